@@ -18,8 +18,10 @@
 #define CPP_API_MEDIA_API_CLIENT_FACTORY_INTERFACE_H_
 
 #include <memory>
+#include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "webrtc/api/scoped_refptr.h"
 
@@ -35,6 +37,20 @@ class MediaApiClientFactoryInterface {
   CreateMediaApiClient(const MediaApiClientConfiguration& api_config,
                        rtc::scoped_refptr<MediaApiClientObserverInterface>
                            api_session_observer) = 0;
+
+  /// Shuts down `clients` in parallel, and destroys them once all of them have
+  /// shut down. Tearing down many clients at once this way takes about as long
+  /// as the slowest client, instead of as long as all of them together.
+  ///
+  /// See `MediaApiClientInterface::Shutdown`.
+  virtual void ShutdownMediaApiClients(
+      std::vector<std::unique_ptr<MediaApiClientInterface>> clients) {
+    absl::BlockingCounter shut_down(static_cast<int>(clients.size()));
+    for (std::unique_ptr<MediaApiClientInterface>& client : clients) {
+      client->Shutdown([&shut_down]() { shut_down.DecrementCount(); });
+    }
+    shut_down.Wait();
+  }
 };
 
 }  // namespace meet
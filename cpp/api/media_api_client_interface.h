@@ -61,12 +61,19 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
 #include <variant>
+#include <vector>
 
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "cpp/api/media_api_client_metrics.h"
 #include "cpp/api/media_entries_resource.h"
 #include "cpp/api/media_stats_resource.h"
 #include "cpp/api/participants_resource.h"
@@ -74,10 +81,297 @@
 #include "cpp/api/video_assignment_resource.h"
 #include "webrtc/api/ref_count.h"
 #include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/stats/rtc_stats_report.h"
 #include "webrtc/api/video/video_frame.h"
+#include "webrtc/api/video_codecs/video_decoder_factory.h"
+#include "webrtc/rtc_base/thread.h"
 
 namespace meet {
 
+/// Configuration for moving observer callbacks off of the client's internal
+/// threads.
+///
+/// By default, observer callbacks are invoked directly on WebRTC's internal
+/// threads, so a slow observer delays decoding and delivery for every stream.
+/// When dispatching is enabled, callbacks are queued and invoked on a pool of
+/// dispatch threads owned by the client instead.
+struct ObserverDispatchConfiguration {
+  /// The number of threads used to invoke observer callbacks. Dispatching is
+  /// disabled if this is zero.
+  ///
+  /// With more than one thread, `OnAudioFrame` and `OnVideoFrame` may be
+  /// invoked concurrently, so observers must be thread-safe. Frames of the
+  /// same stream may then also be delivered out of order; use a single thread
+  /// if the observer relies on their order. `OnJoined`, `OnResourceUpdate`
+  /// and `OnDisconnected` are always invoked one at a time, in the order in
+  /// which they occurred.
+  ///
+  /// Destroying the client joins the dispatch threads, so a client with
+  /// dispatching enabled must not be destroyed from its observer callbacks.
+  uint32_t worker_thread_count = 0;
+  /// The maximum number of audio frames waiting to be dispatched. Once reached,
+  /// newly received audio frames are dropped so that queued audio remains
+  /// contiguous.
+  uint32_t max_queued_audio_frames = 100;
+  /// The maximum number of video frames waiting to be dispatched. Once reached,
+  /// the oldest queued video frame is dropped in favor of the newest frame.
+  uint32_t max_queued_video_frames = 6;
+
+  friend bool operator==(const ObserverDispatchConfiguration&,
+                         const ObserverDispatchConfiguration&) = default;
+};
+
+/// A STUN or TURN server used to gather ICE candidates.
+struct IceServer {
+  /// URLs of the server, e.g. "stun:stun.l.google.com:19302".
+  std::vector<std::string> urls;
+  /// Credentials for TURN servers.
+  std::string username;
+  std::string password;
+
+  friend bool operator==(const IceServer&, const IceServer&) = default;
+};
+
+/// Configuration for gathering ICE candidates.
+///
+/// Candidates are gathered while the local description is set, before the
+/// join request is sent to Meet servers, so gathering is on the critical path
+/// of joining. Hosts with public IP addresses can skip most of it.
+struct IceConfiguration {
+  /// Servers to gather candidates from. Without servers, only host candidates
+  /// are gathered, which avoids waiting for a round trip to a STUN server but
+  /// only works if the host's own addresses are reachable from Meet servers.
+  std::vector<IceServer> servers = {
+      IceServer{.urls = {"stun:stun.l.google.com:19302"},
+                .username = "",
+                .password = ""}};
+  /// The number of candidates to gather as soon as the client is created,
+  /// rather than when connecting. At most 255. Most useful with pre-created
+  /// clients.
+  uint32_t candidate_pool_size = 0;
+  /// If enabled, candidates keep being gathered as network interfaces change
+  /// instead of only once, so the connection can survive network changes.
+  bool continual_gathering = false;
+  /// If enabled, no candidates are gathered on IPv6 interfaces.
+  bool disable_ipv6 = false;
+  /// If enabled, no candidates are gathered on link-local interfaces.
+  bool disable_link_local_networks = false;
+  /// If enabled, no candidates are gathered on cellular interfaces when other
+  /// interfaces are available.
+  bool low_cost_networks_only = false;
+  /// If enabled, no TCP candidates are gathered.
+  bool disable_tcp_candidates = false;
+
+  friend bool operator==(const IceConfiguration&,
+                         const IceConfiguration&) = default;
+};
+
+/// Scheduling settings for one of the client's threads. Settings are applied
+/// when the thread is started, and only on Linux.
+struct ThreadConfiguration {
+  /// The CPUs the thread may run on, e.g. the CPUs of one NUMA node. If empty,
+  /// the thread may run on any CPU.
+  std::vector<int> cpu_affinity;
+  /// The thread's nice value, from -20 (highest priority) to 19. Negative
+  /// values require the `CAP_SYS_NICE` capability.
+  std::optional<int> nice_value;
+  /// If set, the thread is scheduled with the `SCHED_FIFO` real-time policy at
+  /// this priority, from 1 to 99, instead of with a nice value. Requires the
+  /// `CAP_SYS_NICE` capability or a sufficient `RLIMIT_RTPRIO`.
+  std::optional<int> realtime_priority;
+
+  friend bool operator==(const ThreadConfiguration&,
+                         const ThreadConfiguration&) = default;
+};
+
+/// Placement and priority of the client's threads, e.g. to keep a client's
+/// threads on one NUMA node.
+///
+/// Clients created by a factory with a shared context share their signaling,
+/// worker and network threads, which are configured by the factory's shared
+/// context configuration. Such clients must be created with the same settings
+/// for these threads, or creating them fails.
+struct ThreadsConfiguration {
+  /// The client's internal thread, which handles resource updates and
+  /// requests.
+  ThreadConfiguration client;
+  /// WebRTC's signaling thread, which negotiates the connection.
+  ThreadConfiguration signaling;
+  /// WebRTC's worker thread, which decodes media and runs the audio device
+  /// module. Audio is pulled from WebRTC on this thread, so a real-time
+  /// priority keeps audio delivery on schedule when the host is loaded.
+  ThreadConfiguration worker;
+  /// A started thread with a socket server, e.g. from
+  /// `rtc::Thread::CreateWithSocketServer`, used as WebRTC's network thread.
+  /// Not owned; it must outlive every client created with it. If null, WebRTC
+  /// creates a network thread for each peer connection factory, with default
+  /// scheduling.
+  rtc::Thread* network_thread = nullptr;
+
+  friend bool operator==(const ThreadsConfiguration&,
+                         const ThreadsConfiguration&) = default;
+};
+
+/// How received media is buffered before it is decoded.
+enum class LatencyProfile {
+  /// WebRTC's defaults. Jitter buffers adapt to the lowest delay that the
+  /// network jitter allows, which suits live consumers such as captioning.
+  kRealtime,
+  /// Larger jitter buffers with a fixed minimum delay on every receiver. Late
+  /// packets are waited for instead of being concealed, and the buffers are
+  /// time-stretched less often, which suits recording, where added delay does
+  /// not matter but concealment artifacts and their CPU cost do.
+  kArchival,
+};
+
+/// Relative priority of a data channel's outgoing messages when the SCTP
+/// transport is congested. Mirrors WebRTC's data channel priorities.
+enum class DataChannelPriority { kVeryLow, kLow, kMedium, kHigh };
+
+/// Delivery guarantees and priority of a single data channel.
+struct DataChannelConfiguration {
+  /// If disabled, messages may be delivered out of order, so a message that
+  /// is being retransmitted does not hold back the messages sent after it.
+  bool ordered = true;
+  /// If set, a message is retransmitted at most this many times before it is
+  /// dropped. If unset, messages are retransmitted until they are delivered.
+  std::optional<uint16_t> max_retransmits;
+  /// Only applies to messages sent by the client. Meet servers choose the
+  /// priority of the updates they send, so this does not speed up receiving.
+  DataChannelPriority priority = DataChannelPriority::kLow;
+
+  friend bool operator==(const DataChannelConfiguration&,
+                         const DataChannelConfiguration&) = default;
+};
+
+/// Configuration of each of the client's data channels.
+///
+/// Media entries and participants updates are incremental, and session
+/// control and video assignment requests are matched to their responses, so
+/// those channels must stay ordered and reliable; only their priority can be
+/// changed. Media stats uploads are independent of each other unless
+/// `MediaApiClientConfiguration::delta_encoded_stats` is enabled, so the media
+/// stats channel may also be unordered or unreliable.
+///
+/// By default, outgoing session control messages are prioritized over the
+/// other channels so that they are not delayed by bulk stats uploads.
+struct DataChannelsConfiguration {
+  DataChannelConfiguration media_entries;
+  DataChannelConfiguration media_stats;
+  DataChannelConfiguration participants;
+  DataChannelConfiguration session_control = {
+      .ordered = true,
+      .max_retransmits = std::nullopt,
+      .priority = DataChannelPriority::kHigh};
+  DataChannelConfiguration video_assignment;
+
+  friend bool operator==(const DataChannelsConfiguration&,
+                         const DataChannelsConfiguration&) = default;
+};
+
+/// Resource updates that the observer receives.
+///
+/// The data channel of every resource that is not subscribed to is never
+/// opened, so Meet servers do not send its updates and the client spends no
+/// time parsing them. Session control and media stats channels are always
+/// opened, since the client needs them to join and to upload stats.
+struct ResourceSubscriptions {
+  bool media_entries = true;
+  bool participants = true;
+  /// If disabled, video assignment requests cannot be sent.
+  bool video_assignment = true;
+
+  friend bool operator==(const ResourceSubscriptions&,
+                         const ResourceSubscriptions&) = default;
+};
+
+/// Provides hardware accelerated video decoders, e.g. decoders backed by VA-API
+/// or NVDEC.
+///
+/// Clients decode video with software decoders by default. If a provider is
+/// configured, each received stream is decoded by the provider's decoders
+/// instead, for every codec they support. Streams fall back to the software
+/// decoders if a hardware decoder cannot be created, or fails to be
+/// initialized or to decode a frame.
+///
+/// Hardware decoders can output native frame buffers, which are delivered
+/// through `MediaApiClientObserverInterface::OnVideoFrame` as is. Observers
+/// that need the pixels can convert them with
+/// `webrtc::VideoFrameBuffer::ToI420`.
+class HardwareVideoDecoderFactoryProviderInterface {
+ public:
+  virtual ~HardwareVideoDecoderFactoryProviderInterface() = default;
+
+  /// Creates a decoder factory for a new peer connection factory. Returns null
+  /// if hardware decoding is unavailable, in which case software decoders are
+  /// used.
+  ///
+  /// This may be called from any thread, and once for each client or shared
+  /// context using the provider.
+  virtual std::unique_ptr<webrtc::VideoDecoderFactory> Create() = 0;
+};
+
+/// Receives the raw messages received on a client's data channels.
+///
+/// This is intended for capturing sessions so that they can be replayed
+/// offline; see `MediaApiClientConfiguration::data_channel_message_recorder`.
+class DataChannelMessageRecorderInterface {
+ public:
+  virtual ~DataChannelMessageRecorderInterface() = default;
+
+  /// Invoked with each message received on the data channel with the given
+  /// `label` (e.g. "participants"), before the message is parsed into a
+  /// `ResourceUpdate`.
+  ///
+  /// This is invoked synchronously on the client's network thread, and may be
+  /// invoked concurrently by several data channels, so implementations must be
+  /// thread-safe and fast. `message` is only valid for the duration of the
+  /// call.
+  virtual void OnDataChannelMessage(absl::string_view label,
+                                    absl::string_view message) = 0;
+};
+
+/// Provides fresh access tokens when the client renegotiates with Meet servers
+/// after joining; see `MediaApiClientConfiguration::access_token_provider`.
+class AccessTokenProviderInterface {
+ public:
+  virtual ~AccessTokenProviderInterface() = default;
+
+  /// Fetches an access token with the same scopes as the one used to join, and
+  /// invokes `callback` with it or with an error.
+  ///
+  /// This is invoked on the client's signaling thread, so implementations that
+  /// refresh tokens over the network must not block; `callback` may be invoked
+  /// on any thread.
+  virtual void GetAccessToken(
+      absl::AnyInvocable<void(absl::StatusOr<std::string>) &&> callback) = 0;
+};
+
+/// The kinds of received media whose delivery can be paused. See
+/// `MediaApiClientInterface::PauseMedia`.
+enum class MediaKind { kAudio, kVideo };
+
+/// Limits on the decoded video frames delivered through
+/// `MediaApiClientObserverInterface::OnVideoFrame`.
+///
+/// Consumers that only need thumbnails or a few frames per second can set
+/// these so that they do not receive, and have to process, every full
+/// resolution frame. Frames are still decoded at the resolution sent by Meet
+/// servers; to receive lower resolution video, set a lower
+/// `meet::VideoResolution` in the video assignment request instead.
+struct VideoSinkConstraints {
+  /// If set, frames with more pixels are downscaled, preserving their aspect
+  /// ratio, before they are delivered. Downscaled native frame buffers are
+  /// converted to I420. Must be positive.
+  std::optional<int> max_pixel_count;
+  /// If set, frames are dropped so that at most this many frames per second
+  /// are delivered for each video stream. Must be positive.
+  std::optional<int> max_framerate_fps;
+
+  friend bool operator==(const VideoSinkConstraints&,
+                         const VideoSinkConstraints&) = default;
+};
+
 struct MediaApiClientConfiguration {
   /// For values greater than zero, the Meet Media API client will establish
   /// that many video SRTP streams. After the session is initialized, no other
@@ -91,6 +385,118 @@ struct MediaApiClientConfiguration {
   /// be created nor intentionally terminated. All connections will be cleaned
   /// up after the session is complete.
   bool enable_audio_streams = false;
+  /// How often, in milliseconds, the client pulls received audio from WebRTC.
+  /// Every wakeup mixes and delivers 10ms of audio per 10ms of the interval,
+  /// so longer intervals deliver the same audio in bursts, trading latency for
+  /// fewer wakeups per second. Must be a positive multiple of 10, at most 40.
+  uint32_t audio_sampling_interval_ms = 10;
+  /// If enabled, received audio is decoded and delivered through
+  /// `MediaApiClientObserverInterface::OnAudioFrame` without also being mixed
+  /// into a single playout stream. The mixed stream is never exposed by this
+  /// client, so skipping it saves the CPU spent mixing and resampling audio.
+  bool sink_only_audio = false;
+  /// If enabled, received audio is not decoded. Instead, the encoded payload
+  /// of every received audio RTP packet is delivered through
+  /// `MediaApiClientObserverInterface::OnEncodedAudioFrame`, and
+  /// `MediaApiClientObserverInterface::OnAudioFrame` is never invoked.
+  ///
+  /// This is useful for archiving audio, since the encoded payloads are much
+  /// smaller than decoded PCM audio and no CPU is spent decoding them.
+  bool encoded_audio_passthrough = false;
+  /// If enabled, received video is not decoded. Instead, every received
+  /// encoded video frame is delivered through
+  /// `MediaApiClientObserverInterface::OnEncodedVideoFrame`, and
+  /// `MediaApiClientObserverInterface::OnVideoFrame` is never invoked.
+  ///
+  /// This is useful for recording video, since encoded frames are a small
+  /// fraction of the size of decoded frames and no CPU is spent decoding them.
+  bool encoded_video_passthrough = false;
+  /// If enabled, each media stats upload only includes the allowlisted stats
+  /// whose values changed since the previous upload, and omits sections with
+  /// no changed values. Most counters do not change between uploads, so this
+  /// greatly reduces the size of stats uploads. A section that stops being
+  /// reported is uploaded in full if it is reported again.
+  bool delta_encoded_stats = false;
+  /// Controls which threads observer callbacks are invoked on. See
+  /// `ObserverDispatchConfiguration`.
+  ObserverDispatchConfiguration observer_dispatch;
+  /// If enabled, all media and data channels share a single ICE and DTLS
+  /// transport. Meet servers support bundling every media description, so this
+  /// saves a DTLS handshake and a socket per media type. Otherwise, WebRTC's
+  /// balanced bundle policy is used, which may negotiate one transport per
+  /// media type.
+  bool max_bundle = true;
+  /// Controls how ICE candidates are gathered. See `IceConfiguration`.
+  IceConfiguration ice;
+  /// Limits on the decoded video frames delivered to the observer. These can
+  /// be changed later with `MediaApiClientInterface::SetVideoSinkConstraints`.
+  VideoSinkConstraints video_sink_constraints;
+  /// If set, received video is decoded with hardware decoders where possible.
+  /// See `HardwareVideoDecoderFactoryProviderInterface`.
+  std::shared_ptr<HardwareVideoDecoderFactoryProviderInterface>
+      hardware_video_decoder_factory_provider;
+  /// Names of the video codecs the client may receive, from most to least
+  /// preferred (e.g. {"VP8", "VP9"}). Codecs that are not listed are not
+  /// offered to Meet servers, so this can exclude codecs that are expensive to
+  /// decode, such as AV1, at the cost of more bandwidth. Retransmission and
+  /// error correction codecs are always offered. Every listed codec must be
+  /// supported by the video decoders.
+  ///
+  /// If empty, every supported codec is offered in WebRTC's default order.
+  std::vector<std::string> video_codec_preferences;
+  /// If set, every message received on the client's data channels is passed to
+  /// this recorder before it is parsed. See
+  /// `DataChannelMessageRecorderInterface`.
+  std::shared_ptr<DataChannelMessageRecorderInterface>
+      data_channel_message_recorder;
+  /// Delivery guarantees and priorities of the client's data channels. See
+  /// `DataChannelsConfiguration`.
+  DataChannelsConfiguration data_channels;
+  /// Resource updates that the observer receives. See
+  /// `ResourceSubscriptions`.
+  ResourceSubscriptions resource_subscriptions;
+  /// If greater than zero, video assignment requests sent within this many
+  /// milliseconds of the previous one are held back, and only the latest held
+  /// back request is sent once the window has elapsed. This avoids a server
+  /// side re-layout, and the key frames it requests, for every intermediate
+  /// layout of a rapidly changing layout such as an active speaker layout.
+  ///
+  /// The response to a sent request is also delivered for every request that
+  /// it superseded, with the superseded request's ID, so every request still
+  /// receives a response.
+  uint32_t video_assignment_coalescing_window_ms = 0;
+  /// The maximum number of ICE restarts attempted when the peer connection
+  /// fails after joining, e.g. because the network changed. An ICE restart
+  /// renegotiates the transport with Meet servers while keeping the session's
+  /// tracks and data channels, so the client does not have to rejoin. If zero,
+  /// failed connections are not restarted.
+  ///
+  /// This relies on Meet servers accepting a renegotiated offer for an
+  /// existing session. If a restart fails, Meet servers answer with a new
+  /// session instead, or the connection fails again after all restarts have
+  /// been attempted, the client disconnects and must rejoin.
+  uint32_t max_ice_restarts = 0;
+  /// If set, every ICE restart sends its offer with a token fetched from this
+  /// provider, since the token used to join may have expired by then. If null,
+  /// ICE restarts reuse the token passed to
+  /// `MediaApiClientInterface::ConnectActiveConference`.
+  std::shared_ptr<AccessTokenProviderInterface> access_token_provider;
+  /// Placement and priority of the client's threads. See
+  /// `ThreadsConfiguration`.
+  ThreadsConfiguration threads;
+  /// How received audio and video are buffered. See `LatencyProfile`.
+  LatencyProfile latency_profile = LatencyProfile::kRealtime;
+  /// If greater than zero, consecutive decoded audio of each stream is
+  /// delivered through `MediaApiClientObserverInterface::OnAudioFrame` in
+  /// frames of this many milliseconds instead of every 10ms, for consumers
+  /// that process audio in larger chunks, such as speech recognition. A frame
+  /// is delivered early if the stream's contributing source or format changes,
+  /// and carries the capture and receive times of its first 10ms of audio.
+  /// Must be a multiple of 10, at most 1000.
+  uint32_t audio_aggregation_window_ms = 0;
+
+  friend bool operator==(const MediaApiClientConfiguration&,
+                         const MediaApiClientConfiguration&) = default;
 };
 
 /// Requests that can be sent to Meet servers.
@@ -115,8 +521,27 @@ using ResourceUpdate =
                  MediaEntriesChannelToClient, ParticipantsChannelToClient,
                  MediaStatsChannelToClient>;
 
+/// Ref-counted storage for the PCM16 samples of an `AudioFrame`.
+///
+/// Buffers may be recycled by the client once every reference has been
+/// released. Observers can therefore retain a buffer across threads (e.g. by
+/// capturing it in a posted task) instead of copying the samples.
+class AudioBufferInterface : public webrtc::RefCountInterface {
+ public:
+  ~AudioBufferInterface() override = default;
+
+  virtual absl::Span<const int16_t> pcm16() const = 0;
+};
+
 struct AudioFrame {
   absl::Span<const int16_t> pcm16;
+  /// Owning reference to the samples viewed by `pcm16`.
+  ///
+  /// `pcm16` remains valid for as long as a reference to this buffer is held.
+  /// If null, `pcm16` is only valid for the duration of
+  /// `MediaApiClientObserverInterface::OnAudioFrame` and must be copied if it
+  /// is needed afterwards.
+  rtc::scoped_refptr<AudioBufferInterface> buffer;
   int bits_per_sample;
   int sample_rate;
   size_t number_of_channels;
@@ -137,9 +562,64 @@ struct AudioFrame {
   /// @see [WebRTC Synchronization
   /// Source](https://www.w3.org/TR/webrtc/#dom-rtcrtpsynchronizationsource)
   uint32_t synchronization_source;
+  /// Capture time of the audio in the sender's NTP clock, in milliseconds, if
+  /// the sender included the absolute capture time RTP header extension.
+  std::optional<int64_t> absolute_capture_timestamp_ms;
+  /// RTP timestamp of the first sample of the frame, in the 48kHz RTP clock of
+  /// Opus.
+  ///
+  /// WebRTC does not pass RTP timestamps to audio sinks, so it is estimated
+  /// from the RTP timestamp of the stream's most recently received packet when
+  /// its sources are resolved, advanced by the audio received since. It can be
+  /// used to align audio with other media from the same sender, or to detect
+  /// gaps in the stream, but may be off by a few packets.
+  uint32_t rtp_timestamp = 0;
+  /// The time at which the client received the frame from WebRTC, before it
+  /// was queued for the observer. Observers can use it instead of reading the
+  /// clock themselves, which would include the time spent queued.
+  ///
+  /// `absl::InfinitePast()` if unknown.
+  absl::Time receive_time = absl::InfinitePast();
+};
+
+/// The encoded payload of a single received audio RTP packet.
+///
+/// Meet sends Opus encoded audio.
+struct EncodedAudioFrame {
+  std::vector<uint8_t> payload;
+  /// RTP payload type of the packet, as negotiated in the SDP answer.
+  uint8_t payload_type;
+  /// RTP timestamp of the packet, in units of the codec's clock rate (48000Hz
+  /// for Opus).
+  uint32_t rtp_timestamp;
+  /// RTP sequence number of the packet, if known.
+  std::optional<uint16_t> sequence_number;
+  bool is_from_loudest_speaker;
+  /// Contributing source (CSRC) of the packet. This ID is used to identify
+  /// which participant in the conference generated the audio. Integrators can
+  /// cross reference this value with values pushed from Meet servers to the
+  /// client via `MediaEntriesToClient` resource updates.
+  ///
+  /// Unlike `AudioFrame::contributing_source`, this is read from the packet
+  /// itself and is therefore always attributed to the correct participant.
+  ///
+  /// @see [WebRTC Contributing
+  /// Source](https://www.w3.org/TR/webrtc/#dom-rtcrtpcontributingsource)
+  uint32_t contributing_source;
+  /// Synchronization source (SSRC) of the packet. This ID identifies which
+  /// media stream the packet originated from. The SSRC is for debugging
+  /// purposes only.
+  ///
+  /// @see [WebRTC Synchronization
+  /// Source](https://www.w3.org/TR/webrtc/#dom-rtcrtpsynchronizationsource)
+  uint32_t synchronization_source;
 };
 
 struct VideoFrame {
+  /// The decoded frame. Its RTP timestamp (`rtp_timestamp()`, in the 90kHz RTP
+  /// clock) and the sender's capture time estimated from RTCP
+  /// (`ntp_time_ms()`, 0 if not yet known) can be used to align video across
+  /// streams.
   const webrtc::VideoFrame& frame;
   /// Contributing source (CSRC) of the current audio frame. This ID is used to
   /// identify which participant in the conference generated the frame.
@@ -156,13 +636,83 @@ struct VideoFrame {
   /// @see [WebRTC Synchronization
   /// Source](https://www.w3.org/TR/webrtc/#dom-rtcrtpsynchronizationsource)
   uint32_t synchronization_source;
+  /// The time at which the client received the frame from WebRTC, before it
+  /// was queued for the observer.
+  ///
+  /// `absl::InfinitePast()` if unknown.
+  absl::Time receive_time = absl::InfinitePast();
+};
+
+/// A single received encoded video frame.
+///
+/// Meet sends VP8, VP9 or AV1 encoded video.
+struct EncodedVideoFrame {
+  std::vector<uint8_t> data;
+  /// MIME type of the frame's codec (i.e. "video/VP8", "video/VP9" or
+  /// "video/AV1").
+  std::string mime_type;
+  /// Whether the frame can be decoded without any previous frames. Decoding
+  /// must start at a key frame.
+  bool is_key_frame;
+  /// RTP timestamp of the frame, in units of the 90kHz video clock.
+  uint32_t rtp_timestamp;
+  /// Dimensions of the frame. These are only guaranteed to be set for key
+  /// frames, and are 0 if unknown.
+  int width;
+  int height;
+  /// Contributing source (CSRC) of the frame. This ID is used to identify
+  /// which participant in the conference generated the frame. Integrators can
+  /// cross reference this value with values pushed from Meet servers to the
+  /// client via `MediaEntriesToClient` resource updates.
+  ///
+  /// @see [WebRTC Contributing
+  /// Source](https://www.w3.org/TR/webrtc/#dom-rtcrtpcontributingsource)
+  uint32_t contributing_source;
+  /// Synchronization source (SSRC) of the frame. This ID identifies which
+  /// media stream the frame originated from. The SSRC is for debugging
+  /// purposes only.
+  ///
+  /// @see [WebRTC Synchronization
+  /// Source](https://www.w3.org/TR/webrtc/#dom-rtcrtpsynchronizationsource)
+  uint32_t synchronization_source;
+};
+
+/// Time spent joining a conference, for diagnosing slow joins.
+///
+/// Each field is the time in microseconds from the
+/// `MediaApiClientInterface::ConnectActiveConference` call until a step of
+/// joining completed. Steps are listed in the order in which they usually
+/// complete, and steps that had not completed when the client joined are
+/// unset. Steps completed before `ConnectActiveConference` was called, such as
+/// the local description of a pre-created client, are reported as zero.
+struct JoinTimings {
+  /// The local description (SDP offer) was created and applied.
+  std::optional<int64_t> local_description_set_us;
+  /// Meet servers answered the join request.
+  std::optional<int64_t> join_response_received_us;
+  /// The remote description (SDP answer) was applied.
+  std::optional<int64_t> remote_description_set_us;
+  /// The first candidate was gathered from the STUN server.
+  std::optional<int64_t> stun_candidate_gathered_us;
+  /// ICE candidate gathering completed.
+  std::optional<int64_t> ice_gathering_complete_us;
+  /// The ICE and DTLS handshakes completed.
+  std::optional<int64_t> peer_connection_connected_us;
+  /// The session control data channel opened, which requires the SCTP
+  /// association.
+  std::optional<int64_t> data_channel_opened_us;
+  /// The session control update moving the client into the
+  /// `meet::SessionStatus::ConferenceConnectionState::kJoined` state was
+  /// received.
+  int64_t joined_us = 0;
 };
 
 /// Interface for observing client events.
 ///
 /// Methods are invoked on internal threads, and therefore observer
 /// implementations must offload non-trivial work to other threads. Otherwise,
-/// they risk blocking the client.
+/// they risk blocking the client. Alternatively, the client can dispatch
+/// callbacks on its own threads; see `ObserverDispatchConfiguration`.
 class MediaApiClientObserverInterface : public webrtc::RefCountInterface {
  public:
   ~MediaApiClientObserverInterface() override = default;
@@ -175,6 +725,13 @@ class MediaApiClientObserverInterface : public webrtc::RefCountInterface {
   /// invoked.
   virtual void OnJoined() = 0;
 
+  /// Invoked instead of `OnJoined()` with the time spent in each step of
+  /// joining the conference.
+  ///
+  /// The default implementation calls `OnJoined()`, so observers only need to
+  /// override this to receive the timings.
+  virtual void OnJoined(const JoinTimings& timings) { OnJoined(); }
+
   /// Invoked when the client disconnects for whatever reason.
   ///
   /// - This will only be called after
@@ -216,6 +773,18 @@ class MediaApiClientObserverInterface : public webrtc::RefCountInterface {
   /// `meet::SessionStatus::ConferenceConnectionState::kJoined` state.
   virtual void OnAudioFrame(AudioFrame frame) = 0;
 
+  /// Callback for receiving encoded audio packets.
+  ///
+  /// This is only invoked if
+  /// `MediaApiClientConfiguration::encoded_audio_passthrough` is enabled, in
+  /// which case it is invoked instead of `OnAudioFrame`. Packets may be
+  /// delivered out of order; they can be reordered with
+  /// `EncodedAudioFrame::sequence_number`.
+  ///
+  /// This will only be invoked while in the
+  /// `meet::SessionStatus::ConferenceConnectionState::kJoined` state.
+  virtual void OnEncodedAudioFrame(EncodedAudioFrame frame) {}
+
   /// Callbacks for receiving video frames.
   ///
   /// Video frames will not be received for participants with their video
@@ -224,6 +793,17 @@ class MediaApiClientObserverInterface : public webrtc::RefCountInterface {
   /// This will only be invoked while in the
   /// `meet::SessionStatus::ConferenceConnectionState::kJoined` state.
   virtual void OnVideoFrame(VideoFrame frame) = 0;
+
+  /// Callback for receiving encoded video frames.
+  ///
+  /// This is only invoked if
+  /// `MediaApiClientConfiguration::encoded_video_passthrough` is enabled, in
+  /// which case it is invoked instead of `OnVideoFrame`. Frames are delivered
+  /// once all of their packets have been received.
+  ///
+  /// This will only be invoked while in the
+  /// `meet::SessionStatus::ConferenceConnectionState::kJoined` state.
+  virtual void OnEncodedVideoFrame(EncodedVideoFrame frame) {}
 };
 
 /// Interface for the Meet Media API client.
@@ -285,6 +865,109 @@ class MediaApiClientInterface {
   /// `MediaApiClientObserverInterface`.
   virtual absl::Status SendRequest(const ResourceRequest& request) = 0;
 
+  /// Returns a snapshot of the client's internal metrics, such as frame
+  /// delivery counts and join phase durations. See `MediaApiClientMetrics` for
+  /// the metrics that are reported.
+  ///
+  /// This is safe to call from any thread, and is cheap enough to be called
+  /// whenever metrics are scraped. The default implementation reports no
+  /// metrics.
+  virtual MediaApiClientMetrics GetMetrics() const { return {}; }
+
+  using StatsReportCallback = absl::AnyInvocable<
+      void(absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>>)
+          &&>;
+
+  /// Passes the latest WebRTC stats report of the client's peer connection to
+  /// `callback`.
+  ///
+  /// Once joined, the client periodically collects stats to upload them to Meet
+  /// servers. A report collected at most `max_age` ago, either by that upload
+  /// loop or for an earlier call, is passed on without collecting stats again,
+  /// so any number of consumers can share one collection. Otherwise, stats are
+  /// collected, and calls made while a collection is in flight all receive its
+  /// report.
+  ///
+  /// `callback` is invoked on the calling thread if a recent enough report is
+  /// available, and on an internal WebRTC thread otherwise, so it must not
+  /// block. It receives an error if the client is not connected, or shuts down
+  /// before stats are delivered. This is safe to call from any thread,
+  /// including from observer callbacks. The default implementation passes an
+  /// unimplemented error.
+  virtual void GetStatsReport(absl::Duration /* max_age */,
+                              StatsReportCallback callback) {
+    std::move(callback)(
+        absl::UnimplementedError("GetStatsReport is not implemented."));
+  }
+
+  /// Like the callback-based `GetStatsReport`, but blocks until the report is
+  /// delivered.
+  ///
+  /// Returns an error if the client is not connected, or if stats are not
+  /// delivered in time. This must not be called from observer callbacks, since
+  /// collecting stats may need the thread they are invoked on. The default
+  /// implementation returns an unimplemented error.
+  virtual absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>>
+  GetStatsReport(absl::Duration /* max_age */) {
+    return absl::UnimplementedError("GetStatsReport is not implemented.");
+  }
+
+  /// Replaces the limits on the decoded video frames delivered through
+  /// `MediaApiClientObserverInterface::OnVideoFrame`. The constraints apply to
+  /// every received video stream, including streams that have not been
+  /// signaled yet, and take effect from the next delivered frame.
+  ///
+  /// This is safe to call from any thread and in any state. Returns an error
+  /// if a limit is set but not positive. The default implementation returns an
+  /// unimplemented error.
+  virtual absl::Status SetVideoSinkConstraints(
+      VideoSinkConstraints /* constraints */) {
+    return absl::UnimplementedError(
+        "SetVideoSinkConstraints is not implemented.");
+  }
+
+  /// Stops delivering received frames of `kind` through
+  /// `MediaApiClientObserverInterface::OnAudioFrame` or `OnVideoFrame` until
+  /// `ResumeMedia` is called. Paused video tracks are detached from their
+  /// sources, so their frames are no longer scaled, converted or queued for
+  /// the observer. Paused audio is dropped as it is received, before it is
+  /// copied, and audio still being aggregated is discarded.
+  ///
+  /// WebRTC keeps receiving and decoding the streams, since its receivers
+  /// cannot stop decoding without renegotiating the session. Pausing only
+  /// saves the client's own work, which is most of the cost of an idle client.
+  ///
+  /// Pausing applies to tracks that have not been signaled yet, so a client
+  /// can be paused before it connects, e.g. while it waits in a pool, and only
+  /// deliver media once it is resumed. This is safe to call from any thread
+  /// and in any state.
+  ///
+  /// The default implementations do nothing, so media is never paused.
+  virtual void PauseMedia(MediaKind /* kind */) {}
+  virtual void ResumeMedia(MediaKind /* kind */) {}
+
+  /// Like `PauseMedia`, but for the received track with the media line ID
+  /// `mid`, as found in the `mid` label of the client's frame delivery
+  /// metrics. A track delivers frames only while neither it nor its kind of
+  /// media is paused. Tracks that have not been signaled yet are paused once
+  /// they are. The default implementations do nothing.
+  virtual void PauseTrack(absl::string_view /* mid */) {}
+  virtual void ResumeTrack(absl::string_view /* mid */) {}
+
+  /// Stops the client without blocking the calling thread, and invokes
+  /// `on_shut_down` on any thread once the client can no longer invoke its
+  /// observer. Destroying a client that has shut down only releases its
+  /// resources, so it does not block on the client's threads.
+  ///
+  /// Unlike `LeaveConference`, this does not notify Meet servers, and
+  /// `MediaApiClientObserverInterface::OnDisconnected` is not invoked.
+  ///
+  /// The default implementation invokes `on_shut_down` immediately, and leaves
+  /// stopping the client to its destructor.
+  virtual void Shutdown(absl::AnyInvocable<void() &&> on_shut_down) {
+    std::move(on_shut_down)();
+  }
+
   /// Creates a new instance of `MediaApiClientInterface`.
   ///
   /// It is configured with the required codecs to support streaming media from
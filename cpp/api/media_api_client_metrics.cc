@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/api/media_api_client_metrics.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace meet {
+namespace {
+
+// Splits a metric name like `name{label="value"}` into its base name and its
+// labels, without braces.
+std::pair<absl::string_view, absl::string_view> SplitMetricName(
+    absl::string_view name) {
+  size_t brace = name.find('{');
+  if (brace == absl::string_view::npos || name.back() != '}') {
+    return {name, ""};
+  }
+  return {name.substr(0, brace),
+          name.substr(brace + 1, name.size() - brace - 2)};
+}
+
+// Formats a series of the metric `base_name` with `labels` and an optional
+// extra label, e.g. `name_bucket{label="value",le="10"}`.
+std::string SeriesName(absl::string_view base_name, absl::string_view suffix,
+                       absl::string_view labels,
+                       absl::string_view extra_label = "") {
+  std::string series = absl::StrCat(base_name, suffix);
+  if (labels.empty() && extra_label.empty()) {
+    return series;
+  }
+  absl::StrAppend(&series, "{", labels,
+                  !labels.empty() && !extra_label.empty() ? "," : "",
+                  extra_label, "}");
+  return series;
+}
+
+template <typename T>
+std::vector<std::string> SortedKeys(
+    const absl::flat_hash_map<std::string, T>& map) {
+  std::vector<std::string> keys;
+  keys.reserve(map.size());
+  for (const auto& [key, value] : map) {
+    keys.push_back(key);
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+}  // namespace
+
+std::string FormatPrometheusText(const MediaApiClientMetrics& metrics) {
+  std::string text;
+  // Series of the same metric with different labels share a type line.
+  absl::flat_hash_set<absl::string_view> typed_metrics;
+
+  for (const std::string& name : SortedKeys(metrics.counters)) {
+    auto [base_name, labels] = SplitMetricName(name);
+    if (typed_metrics.insert(base_name).second) {
+      absl::StrAppend(&text, "# TYPE ", base_name, " counter\n");
+    }
+    absl::StrAppend(&text, name, " ", metrics.counters.at(name), "\n");
+  }
+
+  for (const std::string& name : SortedKeys(metrics.histograms)) {
+    const HistogramSnapshot& histogram = metrics.histograms.at(name);
+    auto [base_name, labels] = SplitMetricName(name);
+    if (typed_metrics.insert(base_name).second) {
+      absl::StrAppend(&text, "# TYPE ", base_name, " histogram\n");
+    }
+    // Prometheus buckets are cumulative.
+    uint64_t cumulative_count = 0;
+    for (size_t i = 0; i < histogram.bucket_bounds.size(); ++i) {
+      cumulative_count += histogram.bucket_counts[i];
+      absl::StrAppend(
+          &text,
+          SeriesName(base_name, "_bucket", labels,
+                     absl::StrCat("le=\"", histogram.bucket_bounds[i], "\"")),
+          " ", cumulative_count, "\n");
+    }
+    absl::StrAppend(&text,
+                    SeriesName(base_name, "_bucket", labels, "le=\"+Inf\""),
+                    " ", histogram.count, "\n");
+    absl::StrAppend(&text, SeriesName(base_name, "_sum", labels), " ",
+                    histogram.sum, "\n");
+    absl::StrAppend(&text, SeriesName(base_name, "_count", labels), " ",
+                    histogram.count, "\n");
+  }
+  return text;
+}
+
+}  // namespace meet
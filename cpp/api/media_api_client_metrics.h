@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_API_MEDIA_API_CLIENT_METRICS_H_
+#define CPP_API_MEDIA_API_CLIENT_METRICS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace meet {
+
+/// A point-in-time snapshot of a histogram.
+struct HistogramSnapshot {
+  /// The inclusive upper bounds of the histogram's buckets, in ascending order.
+  std::vector<double> bucket_bounds;
+  /// The number of recorded values that fell into each bucket. There is one
+  /// more count than there are bounds; the last count is of the values greater
+  /// than every bound.
+  ///
+  /// Counts are per bucket, not cumulative.
+  std::vector<uint64_t> bucket_counts;
+  /// The total number of recorded values.
+  uint64_t count = 0;
+  /// The sum of all recorded values.
+  double sum = 0;
+};
+
+/// A point-in-time snapshot of a client's internal metrics.
+///
+/// Metrics are keyed by their name, which follows Prometheus conventions and
+/// may carry labels, e.g. `meet_video_frames_delivered_total{mid="1"}`. Units
+/// are part of the name (e.g. `_us` for microseconds, `_bytes` for bytes).
+///
+/// Counters:
+/// - `meet_audio_frames_delivered_total{mid=...}`: Audio frames delivered to
+///   the observer by each audio track.
+/// - `meet_video_frames_delivered_total{mid=...}`: Video frames delivered to
+///   the observer by each video track.
+/// - `meet_audio_frames_dropped_total`, `meet_video_frames_dropped_total`:
+///   Frames dropped by observer dispatch because the observer fell behind.
+/// - `meet_audio_playout_overruns_total`: Audio samplings that fell too far
+///   behind schedule and were skipped.
+///
+/// Histograms:
+/// - `meet_media_delivery_latency_us`: Time WebRTC's threads spend delivering
+///   each frame. This includes the observer callback if observer callbacks
+///   are invoked inline.
+/// - `meet_observer_callback_latency_us`: Time the observer spends in each
+///   callback invoked by observer dispatch threads.
+/// - `meet_data_channel_message_bytes{label=...}`: Size of each message
+///   received on each data channel.
+/// - `meet_data_channel_parse_latency_us{label=...}`: Time spent parsing each
+///   message received on each data channel.
+/// - `meet_join_local_description_latency_us`,
+///   `meet_join_http_latency_us`, `meet_join_remote_description_latency_us`:
+///   Durations of the phases of connecting to a conference: creating the
+///   offer, exchanging it with Meet servers and applying the answer.
+/// - `meet_join_latency_us`: Total time taken to connect to a conference.
+/// - `meet_audio_playout_skew_us`: How late each audio sampling ran relative
+///   to its schedule.
+///
+/// Metrics only appear once they have been recorded. Audio playout metrics
+/// are not reported by clients that share their peer connection context.
+struct MediaApiClientMetrics {
+  absl::flat_hash_map<std::string, uint64_t> counters;
+  absl::flat_hash_map<std::string, HistogramSnapshot> histograms;
+};
+
+/// Formats `metrics` in the Prometheus text exposition format, so that they
+/// can be served to a Prometheus scraper or an OpenTelemetry collector.
+std::string FormatPrometheusText(const MediaApiClientMetrics& metrics);
+
+}  // namespace meet
+
+#endif  // CPP_API_MEDIA_API_CLIENT_METRICS_H_
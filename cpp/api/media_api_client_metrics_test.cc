@@ -0,0 +1,85 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/api/media_api_client_metrics.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace meet {
+namespace {
+
+using ::testing::HasSubstr;
+
+TEST(FormatPrometheusTextTest, FormatsCounters) {
+  MediaApiClientMetrics metrics;
+  metrics.counters["meet_frames_total{mid=\"1\"}"] = 3;
+  metrics.counters["meet_frames_total{mid=\"0\"}"] = 7;
+  metrics.counters["meet_drops_total"] = 2;
+
+  EXPECT_EQ(FormatPrometheusText(metrics),
+            "# TYPE meet_drops_total counter\n"
+            "meet_drops_total 2\n"
+            "# TYPE meet_frames_total counter\n"
+            "meet_frames_total{mid=\"0\"} 7\n"
+            "meet_frames_total{mid=\"1\"} 3\n");
+}
+
+TEST(FormatPrometheusTextTest, FormatsHistogramsWithCumulativeBuckets) {
+  MediaApiClientMetrics metrics;
+  metrics.histograms["meet_latency_us"] = HistogramSnapshot{
+      .bucket_bounds = {10, 100},
+      .bucket_counts = {2, 1, 1},
+      .count = 4,
+      .sum = 565,
+  };
+
+  EXPECT_EQ(FormatPrometheusText(metrics),
+            "# TYPE meet_latency_us histogram\n"
+            "meet_latency_us_bucket{le=\"10\"} 2\n"
+            "meet_latency_us_bucket{le=\"100\"} 3\n"
+            "meet_latency_us_bucket{le=\"+Inf\"} 4\n"
+            "meet_latency_us_sum 565\n"
+            "meet_latency_us_count 4\n");
+}
+
+TEST(FormatPrometheusTextTest, FormatsHistogramLabels) {
+  MediaApiClientMetrics metrics;
+  metrics.histograms["meet_message_bytes{label=\"participants\"}"] =
+      HistogramSnapshot{
+          .bucket_bounds = {256},
+          .bucket_counts = {1, 0},
+          .count = 1,
+          .sum = 20,
+      };
+
+  std::string text = FormatPrometheusText(metrics);
+
+  EXPECT_THAT(text, HasSubstr("# TYPE meet_message_bytes histogram\n"));
+  EXPECT_THAT(text, HasSubstr("meet_message_bytes_bucket{label="
+                              "\"participants\",le=\"256\"} 1\n"));
+  EXPECT_THAT(text, HasSubstr("meet_message_bytes_bucket{label="
+                              "\"participants\",le=\"+Inf\"} 1\n"));
+  EXPECT_THAT(text,
+              HasSubstr("meet_message_bytes_sum{label=\"participants\"} 20\n"));
+  EXPECT_THAT(
+      text, HasSubstr("meet_message_bytes_count{label=\"participants\"} 1\n"));
+}
+
+}  // namespace
+}  // namespace meet
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/api/participant_roster.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "cpp/api/participants_resource.h"
+
+namespace meet {
+
+ParticipantRosterDelta ParticipantRoster::Apply(
+    const ParticipantsChannelToClient& update) {
+  ParticipantRosterDelta delta;
+  // Resource IDs are collected first and resolved once the whole update has
+  // been applied, so that a participant added or changed and then deleted by
+  // the same update is not reported as added or changed.
+  std::vector<int64_t> added_ids;
+  std::vector<int64_t> changed_ids;
+  absl::flat_hash_set<int64_t> added_id_set;
+  absl::flat_hash_set<int64_t> changed_id_set;
+
+  for (const ParticipantResourceSnapshot& snapshot : update.resources) {
+    if (!snapshot.participant.has_value()) {
+      delta.missing_participant_ids.push_back(snapshot.id);
+      continue;
+    }
+
+    auto [it, inserted] = entries_.try_emplace(snapshot.id);
+    ParticipantRosterEntry& entry = it->second;
+    if (inserted) {
+      entry = ParticipantRosterEntry{
+          .handle = ParticipantHandle{.value = next_handle_value_++},
+          .resource_id = snapshot.id,
+          .participant = *snapshot.participant};
+      resource_ids_by_handle_[entry.handle] = snapshot.id;
+      added_ids.push_back(snapshot.id);
+      added_id_set.insert(snapshot.id);
+      continue;
+    }
+
+    if (entry.participant == *snapshot.participant) {
+      continue;
+    }
+    entry.participant = *snapshot.participant;
+    if (!added_id_set.contains(snapshot.id) &&
+        changed_id_set.insert(snapshot.id).second) {
+      changed_ids.push_back(snapshot.id);
+    }
+  }
+
+  for (const ParticipantDeletedResource& deleted : update.deleted_resources) {
+    auto node = entries_.extract(deleted.id);
+    if (node.empty()) {
+      continue;
+    }
+    resource_ids_by_handle_.erase(node.mapped().handle);
+
+    if (added_id_set.erase(deleted.id) > 0) {
+      added_ids.erase(
+          std::find(added_ids.begin(), added_ids.end(), deleted.id));
+      continue;
+    }
+    if (changed_id_set.erase(deleted.id) > 0) {
+      changed_ids.erase(
+          std::find(changed_ids.begin(), changed_ids.end(), deleted.id));
+    }
+    delta.removed.push_back(std::move(node.mapped()));
+  }
+
+  delta.added.reserve(added_ids.size());
+  for (int64_t id : added_ids) {
+    delta.added.push_back(&entries_.at(id));
+  }
+  delta.changed.reserve(changed_ids.size());
+  for (int64_t id : changed_ids) {
+    delta.changed.push_back(&entries_.at(id));
+  }
+  return delta;
+}
+
+const ParticipantRosterEntry* ParticipantRoster::Get(
+    ParticipantHandle handle) const {
+  auto it = resource_ids_by_handle_.find(handle);
+  if (it == resource_ids_by_handle_.end()) {
+    return nullptr;
+  }
+  return FindByResourceId(it->second);
+}
+
+const ParticipantRosterEntry* ParticipantRoster::FindByResourceId(
+    int64_t resource_id) const {
+  auto it = entries_.find(resource_id);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+}  // namespace meet
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_API_PARTICIPANT_ROSTER_H_
+#define CPP_API_PARTICIPANT_ROSTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+#include "cpp/api/participants_resource.h"
+
+namespace meet {
+
+/// A stable handle to a participant in a `ParticipantRoster`.
+///
+/// A handle keeps referring to the same participant across updates until the
+/// participant is removed. Handles are never reused, so a participant that is
+/// removed and later added again under the same resource ID gets a new handle.
+struct ParticipantHandle {
+  uint64_t value = 0;
+
+  friend bool operator==(const ParticipantHandle& lhs,
+                         const ParticipantHandle& rhs) = default;
+
+  template <typename H>
+  friend H AbslHashValue(H h, const ParticipantHandle& handle) {
+    return H::combine(std::move(h), handle.value);
+  }
+};
+
+/// A participant in a `ParticipantRoster`.
+struct ParticipantRosterEntry {
+  ParticipantHandle handle;
+  /// The resource ID from the participant's resource snapshots.
+  int64_t resource_id;
+  Participant participant;
+};
+
+/// The changes that a `ParticipantsChannelToClient` update made to a
+/// `ParticipantRoster`.
+///
+/// `added` and `changed` point into the roster. They remain valid until the
+/// participants they refer to are removed.
+struct ParticipantRosterDelta {
+  /// Participants that were not in the roster before the update, in update
+  /// order.
+  std::vector<const ParticipantRosterEntry*> added;
+  /// Participants already in the roster whose snapshots differed from the
+  /// cached participant, in update order. Snapshots identical to the cached
+  /// participant are not reported.
+  std::vector<const ParticipantRosterEntry*> changed;
+  /// Participants removed from the roster by the update.
+  std::vector<ParticipantRosterEntry> removed;
+  /// The resource IDs of snapshots that did not contain a participant. These
+  /// snapshots are ignored.
+  std::vector<int64_t> missing_participant_ids;
+
+  bool empty() const {
+    return added.empty() && changed.empty() && removed.empty();
+  }
+};
+
+/// A client-side cache of the participants in a conference.
+///
+/// The roster merges resource snapshots and deletions from
+/// `ParticipantsChannelToClient` updates, and reports only what each update
+/// changed. This spares consumers from rebuilding or re-diffing the whole
+/// participant list on every update, which matters in large conferences.
+///
+/// Participants are identified by their resource ID. Snapshots replace the
+/// cached participant with the same resource ID; deletions of unknown resource
+/// IDs are ignored.
+///
+/// This class is not thread-safe.
+class ParticipantRoster {
+ public:
+  /// Merges `update` into the roster and returns the resulting changes.
+  ///
+  /// Snapshots are applied before deletions. A participant that is both added
+  /// and deleted by the same update is not reported.
+  ParticipantRosterDelta Apply(const ParticipantsChannelToClient& update);
+
+  /// Returns the participant referred to by `handle`, or nullptr if the
+  /// participant has been removed.
+  const ParticipantRosterEntry* Get(ParticipantHandle handle) const;
+
+  /// Returns the participant with the given resource ID, or nullptr if there is
+  /// none.
+  const ParticipantRosterEntry* FindByResourceId(int64_t resource_id) const;
+
+  /// Returns the number of participants in the roster.
+  size_t size() const { return entries_.size(); }
+
+ private:
+  // Entries are stored in a node map so that pointers handed out in deltas
+  // stay valid as the roster grows.
+  absl::node_hash_map<int64_t, ParticipantRosterEntry> entries_;
+  absl::flat_hash_map<ParticipantHandle, int64_t> resource_ids_by_handle_;
+  uint64_t next_handle_value_ = 1;
+};
+
+}  // namespace meet
+
+#endif  // CPP_API_PARTICIPANT_ROSTER_H_
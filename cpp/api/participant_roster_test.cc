@@ -0,0 +1,150 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/api/participant_roster.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "cpp/api/participants_resource.h"
+
+namespace meet {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::IsEmpty;
+using ::testing::Pointee;
+
+ParticipantResourceSnapshot CreateSnapshot(int64_t id,
+                                           std::string display_name) {
+  return ParticipantResourceSnapshot{
+      .id = id,
+      .participant = Participant{
+          .participant_key = "participants/key",
+          .type = Participant::Type::kAnonymousUser,
+          .anonymous_user =
+              AnonymousUser{.display_name = std::move(display_name)}}};
+}
+
+TEST(ParticipantRosterTest, ReportsAddedParticipants) {
+  ParticipantRoster roster;
+
+  ParticipantRosterDelta delta = roster.Apply(ParticipantsChannelToClient{
+      .resources = {CreateSnapshot(1, "one"), CreateSnapshot(2, "two")}});
+
+  EXPECT_THAT(
+      delta.added,
+      ElementsAre(Pointee(Field(&ParticipantRosterEntry::resource_id, 1)),
+                  Pointee(Field(&ParticipantRosterEntry::resource_id, 2))));
+  EXPECT_THAT(delta.changed, IsEmpty());
+  EXPECT_THAT(delta.removed, IsEmpty());
+  EXPECT_EQ(roster.size(), 2);
+}
+
+TEST(ParticipantRosterTest, IgnoresUnchangedSnapshots) {
+  ParticipantRoster roster;
+  roster.Apply(ParticipantsChannelToClient{
+      .resources = {CreateSnapshot(1, "one")}});
+
+  ParticipantRosterDelta delta = roster.Apply(ParticipantsChannelToClient{
+      .resources = {CreateSnapshot(1, "one")}});
+
+  EXPECT_TRUE(delta.empty());
+}
+
+TEST(ParticipantRosterTest, ReportsChangedParticipantsWithStableHandles) {
+  ParticipantRoster roster;
+  ParticipantRosterDelta added = roster.Apply(ParticipantsChannelToClient{
+      .resources = {CreateSnapshot(1, "one")}});
+  ASSERT_EQ(added.added.size(), 1);
+  ParticipantHandle handle = added.added[0]->handle;
+
+  ParticipantRosterDelta delta = roster.Apply(ParticipantsChannelToClient{
+      .resources = {CreateSnapshot(1, "renamed")}});
+
+  ASSERT_EQ(delta.changed.size(), 1);
+  EXPECT_EQ(delta.changed[0]->handle, handle);
+  EXPECT_THAT(delta.added, IsEmpty());
+  const ParticipantRosterEntry* entry = roster.Get(handle);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->participant.anonymous_user->display_name, "renamed");
+}
+
+TEST(ParticipantRosterTest, ReportsRemovedParticipants) {
+  ParticipantRoster roster;
+  ParticipantRosterDelta added = roster.Apply(ParticipantsChannelToClient{
+      .resources = {CreateSnapshot(1, "one"), CreateSnapshot(2, "two")}});
+  ParticipantHandle handle = added.added[0]->handle;
+
+  ParticipantRosterDelta delta = roster.Apply(ParticipantsChannelToClient{
+      .deleted_resources = {ParticipantDeletedResource{.id = 1},
+                            ParticipantDeletedResource{.id = 3}}});
+
+  ASSERT_EQ(delta.removed.size(), 1);
+  EXPECT_EQ(delta.removed[0].handle, handle);
+  EXPECT_EQ(delta.removed[0].participant.anonymous_user->display_name, "one");
+  EXPECT_EQ(roster.Get(handle), nullptr);
+  EXPECT_EQ(roster.FindByResourceId(1), nullptr);
+  EXPECT_NE(roster.FindByResourceId(2), nullptr);
+  EXPECT_EQ(roster.size(), 1);
+}
+
+TEST(ParticipantRosterTest, ReaddedParticipantGetsNewHandle) {
+  ParticipantRoster roster;
+  ParticipantHandle handle =
+      roster.Apply(ParticipantsChannelToClient{
+                       .resources = {CreateSnapshot(1, "one")}})
+          .added[0]
+          ->handle;
+  roster.Apply(ParticipantsChannelToClient{
+      .deleted_resources = {ParticipantDeletedResource{.id = 1}}});
+
+  ParticipantRosterDelta delta = roster.Apply(ParticipantsChannelToClient{
+      .resources = {CreateSnapshot(1, "one")}});
+
+  ASSERT_EQ(delta.added.size(), 1);
+  EXPECT_NE(delta.added[0]->handle, handle);
+  EXPECT_EQ(roster.Get(handle), nullptr);
+}
+
+TEST(ParticipantRosterTest, DoesNotReportParticipantAddedAndDeletedTogether) {
+  ParticipantRoster roster;
+
+  ParticipantRosterDelta delta = roster.Apply(ParticipantsChannelToClient{
+      .resources = {CreateSnapshot(1, "one")},
+      .deleted_resources = {ParticipantDeletedResource{.id = 1}}});
+
+  EXPECT_TRUE(delta.empty());
+  EXPECT_EQ(roster.size(), 0);
+}
+
+TEST(ParticipantRosterTest, ReportsSnapshotsWithoutParticipant) {
+  ParticipantRoster roster;
+
+  ParticipantRosterDelta delta = roster.Apply(ParticipantsChannelToClient{
+      .resources = {ParticipantResourceSnapshot{.id = 1}}});
+
+  EXPECT_TRUE(delta.empty());
+  EXPECT_THAT(delta.missing_participant_ids, ElementsAre(1));
+  EXPECT_EQ(roster.size(), 0);
+}
+
+}  // namespace
+}  // namespace meet
@@ -41,12 +41,18 @@ struct SignedInUser {
   /// - For a robot account, it's the administrator-specified device name. For
   /// example, "Altostrat Room".
   std::string display_name;
+
+  friend bool operator==(const SignedInUser& lhs,
+                         const SignedInUser& rhs) = default;
 };
 
 /// Anonymous user.
 struct AnonymousUser {
   /// User provided name when they join a conference anonymously.
   std::string display_name;
+
+  friend bool operator==(const AnonymousUser& lhs,
+                         const AnonymousUser& rhs) = default;
 };
 
 /// Phone user, always has a display name. User dialing in from a phone where
@@ -55,6 +61,8 @@ struct AnonymousUser {
 struct PhoneUser {
   /// Partially redacted user's phone number when calling.
   std::string display_name;
+
+  friend bool operator==(const PhoneUser& lhs, const PhoneUser& rhs) = default;
 };
 
 struct Participant {
@@ -101,6 +109,9 @@ struct Participant {
   std::optional<SignedInUser> signed_in_user;
   std::optional<AnonymousUser> anonymous_user;
   std::optional<PhoneUser> phone_user;
+
+  friend bool operator==(const Participant& lhs,
+                         const Participant& rhs) = default;
 };
 
 /// A resource snapshot managed by the server and replicated to the client.
@@ -63,6 +63,10 @@ struct LayoutModel {
   /// The canvases that videos are assigned to from each virtual SSRC.
   /// Providing more canvases than exists virtual streams will result in
   /// an error status.
+  ///
+  /// A client has one virtual stream per
+  /// `MediaApiClientConfiguration::receiving_video_stream_count`, which is
+  /// fixed when joining, and rejects larger layouts without sending them.
   std::vector<VideoCanvas> canvases;
 };
 
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks for the WebRTC track adapters that convert incoming media into
+// `meet::AudioFrame`s and `meet::VideoFrame`s.
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/conference_media_tracks.h"
+#include "cpp/samples/testing/media_data.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/rtp_packet_info.h"
+#include "webrtc/api/rtp_packet_infos.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/test/mock_rtpreceiver.h"
+#include "webrtc/api/transport/rtp/rtp_source.h"
+#include "webrtc/api/units/timestamp.h"
+#include "webrtc/api/video/video_frame.h"
+
+namespace meet {
+namespace {
+
+using ::media_api_samples::AudioTestData;
+using ::media_api_samples::CreateAudioTestData;
+using ::media_api_samples::CreateVideoTestData;
+using ::media_api_samples::VideoTestData;
+
+// Returns a fixed set of sources without going through gmock, so that the
+// benchmark measures the track rather than the mock.
+class FakeRtpReceiver : public webrtc::MockRtpReceiver {
+ public:
+  explicit FakeRtpReceiver(std::vector<webrtc::RtpSource> sources)
+      : sources_(std::move(sources)) {}
+
+  std::vector<webrtc::RtpSource> GetSources() const override {
+    return sources_;
+  }
+
+ private:
+  std::vector<webrtc::RtpSource> sources_;
+};
+
+webrtc::RtpSource CreateRtpSource(uint32_t source_id,
+                                  webrtc::RtpSourceType source_type) {
+  return webrtc::RtpSource(
+      webrtc::Timestamp::Micros(1234567890), source_id, source_type,
+      /*rtp_timestamp=*/1111111,
+      {.audio_level = 100, .absolute_capture_time = std::nullopt});
+}
+
+// Benchmarks a single 10ms audio frame at 48kHz.
+//
+// Args: number of channels.
+void BM_ConferenceAudioTrackOnData(benchmark::State& state) {
+  const size_t number_of_channels = state.range(0);
+  constexpr size_t kNumberOfFrames = 480;
+  AudioTestData test_data =
+      CreateAudioTestData(number_of_channels * kNumberOfFrames);
+  auto receiver = webrtc::make_ref_counted<FakeRtpReceiver>(
+      std::vector<webrtc::RtpSource>{
+          CreateRtpSource(/*source_id=*/123, webrtc::RtpSourceType::CSRC),
+          CreateRtpSource(kLoudestSpeakerCsrc, webrtc::RtpSourceType::CSRC),
+          CreateRtpSource(/*source_id=*/456, webrtc::RtpSourceType::SSRC)});
+  ConferenceAudioTrack audio_track(
+      "mid", receiver,
+      [](AudioFrame frame) { benchmark::DoNotOptimize(frame); });
+
+  for (auto _ : state) {
+    audio_track.OnData(test_data.pcm16.data(), /*bits_per_sample=*/16,
+                       /*sample_rate=*/48000, number_of_channels,
+                       kNumberOfFrames,
+                       /*absolute_capture_timestamp_ms=*/std::nullopt);
+  }
+  state.SetBytesProcessed(state.iterations() * test_data.pcm16.size() *
+                          sizeof(int16_t));
+}
+BENCHMARK(BM_ConferenceAudioTrackOnData)->Arg(1)->Arg(2);
+
+// Args: frame width and height.
+void BM_ConferenceVideoTrackOnFrame(benchmark::State& state) {
+  VideoTestData test_data = CreateVideoTestData(state.range(0), state.range(1));
+  webrtc::RtpPacketInfo packet_info;
+  packet_info.set_csrcs({123});
+  packet_info.set_ssrc(456);
+  webrtc::VideoFrame::Builder builder;
+  builder.set_packet_infos(webrtc::RtpPacketInfos({packet_info}));
+  builder.set_video_frame_buffer(test_data.webrtc_frame->video_frame_buffer());
+  webrtc::VideoFrame frame = builder.build();
+  ConferenceVideoTrack video_track(
+      "mid", [](VideoFrame frame) { benchmark::DoNotOptimize(frame); });
+
+  for (auto _ : state) {
+    video_track.OnFrame(frame);
+  }
+}
+BENCHMARK(BM_ConferenceVideoTrackOnFrame)
+    ->Args({640, 360})
+    ->Args({1280, 720})
+    ->Args({1920, 1080});
+
+}  // namespace
+}  // namespace meet
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks for writing decoded media to output writers.
+
+#include <cstdint>
+#include <ios>
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "cpp/samples/buffered_output_writer.h"
+#include "cpp/samples/media_writing.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "cpp/samples/testing/media_data.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+
+namespace media_api_samples {
+namespace {
+
+// Discards everything written to it, so that the benchmarks measure the
+// writing helpers rather than the file system.
+//
+// The collectors buffer their output files, so the benchmarks wrap this in a
+// `BufferedOutputWriter` too.
+class NullOutputWriter : public OutputWriterInterface {
+ public:
+  void Write(const char* content, std::streamsize size) override {
+    benchmark::DoNotOptimize(content);
+    benchmark::DoNotOptimize(size);
+  }
+  void Close() override {}
+};
+
+// Args: number of samples.
+void BM_WritePcm16(benchmark::State& state) {
+  AudioTestData test_data = CreateAudioTestData(state.range(0));
+  BufferedOutputWriter writer(std::make_unique<NullOutputWriter>());
+
+  for (auto _ : state) {
+    WritePcm16(test_data.pcm16, writer);
+  }
+  state.SetBytesProcessed(state.iterations() * test_data.pcm16.size() *
+                          sizeof(int16_t));
+}
+// 10ms of mono and stereo audio at 48kHz.
+BENCHMARK(BM_WritePcm16)->Arg(480)->Arg(960);
+
+// Benchmarks a frame whose planes are padded, so each row is written
+// separately.
+//
+// Args: frame width and height.
+void BM_WriteYuv420Padded(benchmark::State& state) {
+  VideoTestData test_data = CreateVideoTestData(state.range(0), state.range(1));
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+      test_data.webrtc_frame->video_frame_buffer()->ToI420();
+  BufferedOutputWriter writer(std::make_unique<NullOutputWriter>());
+
+  for (auto _ : state) {
+    WriteYuv420(*i420, writer);
+  }
+  state.SetBytesProcessed(state.iterations() * test_data.yuv_data.size());
+}
+BENCHMARK(BM_WriteYuv420Padded)
+    ->Args({640, 360})
+    ->Args({1280, 720})
+    ->Args({1920, 1080});
+
+// Benchmarks a frame whose planes are contiguous, so each plane is written as
+// a whole.
+//
+// Args: frame width and height.
+void BM_WriteYuv420Contiguous(benchmark::State& state) {
+  const int width = state.range(0);
+  const int height = state.range(1);
+  rtc::scoped_refptr<webrtc::I420Buffer> i420 =
+      webrtc::I420Buffer::Create(width, height);
+  webrtc::I420Buffer::SetBlack(i420.get());
+  BufferedOutputWriter writer(std::make_unique<NullOutputWriter>());
+
+  for (auto _ : state) {
+    WriteYuv420(*i420, writer);
+  }
+  const int chroma_size = ((width + 1) / 2) * ((height + 1) / 2);
+  state.SetBytesProcessed(state.iterations() *
+                          (width * height + 2 * chroma_size));
+}
+BENCHMARK(BM_WriteYuv420Contiguous)
+    ->Args({640, 360})
+    ->Args({1280, 720})
+    ->Args({1920, 1080});
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,317 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// End-to-end throughput benchmark for `MultiUserMediaCollector`.
+//
+// Drives a collector with synthetic 48kHz audio and 720p I420 video from many
+// contributing sources. Every segment is written through buffered, asynchronous
+// file writers, like the collector's default file output writes video; unlike
+// it, audio segments are not written through memory-mapped files. Files are
+// written to `$COLLECTOR_BENCHMARK_DIR`, which defaults to /dev/shm so that the
+// disk is not the bottleneck. Reports the
+// frames and bytes written per second, and the p99 latency from a frame's
+// callback to its write to its segment's output writer.
+//
+// Segment files are removed once they are closed, but open segments are held
+// in the file system until then: 200 sources write about 2.8GB of video per
+// iteration.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/api/media_entries_resource.h"
+#include "cpp/api/participants_resource.h"
+#include "cpp/samples/async_output_writer.h"
+#include "cpp/samples/buffered_output_writer.h"
+#include "cpp/samples/frame_queue.h"
+#include "cpp/samples/multi_user_media_collector.h"
+#include "cpp/samples/output_file.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "cpp/samples/resource_manager_interface.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+constexpr int kAudioSampleRate = 48000;
+// 10ms of mono audio.
+constexpr int kAudioSamplesPerFrame = kAudioSampleRate / 100;
+constexpr int kVideoWidth = 1280;
+constexpr int kVideoHeight = 720;
+// Each iteration sends one second of media from every source: 100 audio
+// frames and, after every tenth audio frame, a video frame.
+constexpr int kAudioFramesPerSource = 100;
+constexpr int kAudioFramesPerVideoFrame = 10;
+constexpr int kVideoFramesPerSource =
+    kAudioFramesPerSource / kAudioFramesPerVideoFrame;
+// Like the collector's default file output.
+constexpr uint32_t kOutputWriterThreadCount = 2;
+
+// Returns each source's CSRC as its identifier without going through gmock,
+// so that the benchmark measures the collector rather than the mock.
+class FakeResourceManager : public ResourceManagerInterface {
+ public:
+  void OnParticipantResourceUpdate(
+      const meet::ParticipantsChannelToClient& update,
+      absl::Time received_time) override {}
+  void OnMediaEntriesResourceUpdate(
+      const meet::MediaEntriesChannelToClient& update,
+      absl::Time received_time) override {}
+  absl::StatusOr<std::string> GetOutputFileIdentifier(
+      uint32_t contributing_source) override {
+    return absl::StrCat(contributing_source);
+  }
+};
+
+// The callback times of a segment's frames, and the latencies of their writes.
+//
+// Frames are not dropped, so the nth frame written after the file header is
+// the nth frame sent. Callback times are recorded before the frames are sent
+// and read on the segment's shard thread, and the writes are recorded on the
+// shard thread and read once the collector has disconnected, so the frame
+// queues and the disconnect notification order the accesses.
+struct SegmentTimings {
+  explicit SegmentTimings(int frame_count)
+      : callback_times(frame_count), latencies(frame_count) {}
+
+  std::vector<absl::Time> callback_times;
+  std::vector<absl::Duration> latencies;
+  int written_frames = 0;
+  uint64_t written_bytes = 0;
+};
+
+// Records the writes of a segment to `timings`, then forwards them.
+class TimingOutputWriter : public OutputWriterInterface {
+ public:
+  TimingOutputWriter(std::unique_ptr<OutputWriterInterface> writer,
+                     SegmentTimings& timings)
+      : writer_(std::move(writer)), timings_(timings) {}
+
+  void Write(const char* content, std::streamsize size) override {
+    writer_->Write(content, size);
+    RecordWrite(size);
+  }
+  void WriteVectored(absl::Span<const Chunk> chunks) override {
+    writer_->WriteVectored(chunks);
+    std::streamsize size = 0;
+    for (const Chunk& chunk : chunks) {
+      size += chunk.size;
+    }
+    RecordWrite(size);
+  }
+  void Close() override { writer_->Close(); }
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed) override {
+    writer_->CloseAsync(std::move(on_closed));
+  }
+
+ private:
+  // Every write after the file header writes one frame.
+  void RecordWrite(std::streamsize size) {
+    timings_.written_bytes += size;
+    if (!wrote_header_) {
+      wrote_header_ = true;
+      return;
+    }
+    int frame = timings_.written_frames;
+    if (frame < static_cast<int>(timings_.callback_times.size())) {
+      timings_.latencies[frame] = absl::Now() - timings_.callback_times[frame];
+      ++timings_.written_frames;
+    }
+  }
+
+  std::unique_ptr<OutputWriterInterface> writer_;
+  SegmentTimings& timings_;
+  bool wrote_header_ = false;
+};
+
+std::unique_ptr<rtc::Thread> StartThread(absl::string_view name) {
+  std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+  thread->SetName(name, nullptr);
+  thread->Start();
+  return thread;
+}
+
+// Args: number of contributing sources, and number of shard threads. With no
+// shard threads, all segments are handled on the collector thread.
+void BM_MultiUserMediaCollectorThroughput(benchmark::State& state) {
+  const int source_count = state.range(0);
+  const int shard_count = state.range(1);
+  const char* output_dir = std::getenv("COLLECTOR_BENCHMARK_DIR");
+  const std::string output_file_prefix = absl::StrCat(
+      output_dir != nullptr ? output_dir : "/dev/shm", "/collector_benchmark_");
+
+  absl::StatusOr<std::unique_ptr<OutputWriterThreadPool>>
+      output_writer_threads =
+          OutputWriterThreadPool::Create(kOutputWriterThreadCount);
+  if (!output_writer_threads.ok()) {
+    state.SkipWithError("Failed to start output writer threads");
+    return;
+  }
+  std::vector<int16_t> pcm16(kAudioSamplesPerFrame);
+  for (int i = 0; i < kAudioSamplesPerFrame; ++i) {
+    pcm16[i] = static_cast<int16_t>(i);
+  }
+  // Decoded frames are usually contiguous, so each plane is written whole.
+  rtc::scoped_refptr<webrtc::I420Buffer> i420 =
+      webrtc::I420Buffer::Create(kVideoWidth, kVideoHeight);
+  webrtc::I420Buffer::SetBlack(i420.get());
+  webrtc::VideoFrame video_frame =
+      webrtc::VideoFrame::Builder().set_video_frame_buffer(i420).build();
+
+  std::vector<absl::Duration> latencies;
+  uint64_t written_frames = 0;
+  uint64_t written_bytes = 0;
+  for (auto _ : state) {
+    // Keyed by the segments' temporary file names, up to their sequence
+    // numbers.
+    absl::flat_hash_map<std::string, std::unique_ptr<SegmentTimings>> timings;
+    std::vector<SegmentTimings*> audio_timings;
+    std::vector<SegmentTimings*> video_timings;
+    for (int i = 1; i <= source_count; ++i) {
+      auto audio = std::make_unique<SegmentTimings>(kAudioFramesPerSource);
+      auto video = std::make_unique<SegmentTimings>(kVideoFramesPerSource);
+      audio_timings.push_back(audio.get());
+      video_timings.push_back(video.get());
+      timings[absl::StrFormat("%saudio_%d_tmp_", output_file_prefix, i)] =
+          std::move(audio);
+      timings[absl::StrFormat("%svideo_%d_tmp_", output_file_prefix, i)] =
+          std::move(video);
+    }
+
+    std::vector<std::unique_ptr<rtc::Thread>> shard_threads;
+    for (int i = 0; i < shard_count; ++i) {
+      shard_threads.push_back(
+          StartThread(absl::StrCat("collector_shard_thread_", i)));
+    }
+    auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+        output_file_prefix,
+        [&](absl::string_view file_name)
+            -> std::unique_ptr<OutputWriterInterface> {
+          std::ofstream file(std::string(file_name), std::ios::binary |
+                                                         std::ios::out |
+                                                         std::ios::trunc);
+          auto writer = std::make_unique<BufferedOutputWriter>(
+              std::make_unique<AsyncOutputWriter>(
+                  std::make_unique<OutputFile>(std::move(file)),
+                  output_writer_threads->get()));
+          auto timings_it = timings.find(
+              file_name.substr(0, file_name.find("_tmp_") + 5));
+          if (timings_it == timings.end()) {
+            return writer;
+          }
+          return std::make_unique<TimingOutputWriter>(std::move(writer),
+                                                      *timings_it->second);
+        },
+        // Closed segments are removed instead of renamed, so that the file
+        // system only holds open segments.
+        [](absl::string_view tmp_file_name, absl::string_view) {
+          std::remove(std::string(tmp_file_name).c_str());
+        },
+        absl::Seconds(1), std::make_unique<FakeResourceManager>(),
+        StartThread("collector_thread"), std::move(shard_threads));
+    // Video frames are not dropped, so that every frame's latency is measured.
+    // Blocking the callbacks instead of dropping counts towards the latency.
+    collector->SetFrameQueueOptions(
+        kDefaultAudioFrameQueueOptions,
+        {.policy = FrameQueuePolicy::kBlock,
+         .max_frames_per_source =
+             kDefaultVideoFrameQueueOptions.max_frames_per_source});
+
+    absl::Time start = absl::Now();
+    absl::Time receive_time = start;
+    for (int frame = 0; frame < kAudioFramesPerSource; ++frame) {
+      for (int i = 0; i < source_count; ++i) {
+        meet::AudioFrame audio_frame = {
+            .pcm16 = pcm16,
+            .bits_per_sample = 16,
+            .sample_rate = kAudioSampleRate,
+            .number_of_channels = 1,
+            .number_of_frames = kAudioSamplesPerFrame,
+            .contributing_source = static_cast<uint32_t>(i + 1),
+            .receive_time = receive_time};
+        audio_timings[i]->callback_times[frame] = absl::Now();
+        collector->OnAudioFrame(std::move(audio_frame));
+      }
+      if (frame % kAudioFramesPerVideoFrame == 0) {
+        for (int i = 0; i < source_count; ++i) {
+          video_timings[i]->callback_times[frame / kAudioFramesPerVideoFrame] =
+              absl::Now();
+          collector->OnVideoFrame(
+              {.frame = video_frame,
+               .contributing_source = static_cast<uint32_t>(i + 1),
+               .receive_time = receive_time});
+        }
+      }
+      receive_time += absl::Milliseconds(10);
+    }
+    collector->OnDisconnected(absl::OkStatus());
+    if (!collector->WaitForDisconnected(absl::Minutes(1)).ok()) {
+      state.SkipWithError("Collector did not finish writing segments");
+      return;
+    }
+    state.SetIterationTime(absl::ToDoubleSeconds(absl::Now() - start));
+
+    for (const auto& [file_name, segment_timings] : timings) {
+      latencies.insert(
+          latencies.end(), segment_timings->latencies.begin(),
+          segment_timings->latencies.begin() + segment_timings->written_frames);
+      written_frames += segment_timings->written_frames;
+      written_bytes += segment_timings->written_bytes;
+    }
+  }
+
+  state.counters["frames_per_second"] = benchmark::Counter(
+      static_cast<double>(written_frames), benchmark::Counter::kIsRate);
+  state.SetBytesProcessed(static_cast<int64_t>(written_bytes));
+  if (!latencies.empty()) {
+    auto p99 = latencies.begin() + latencies.size() * 99 / 100;
+    std::nth_element(latencies.begin(), p99, latencies.end());
+    state.counters["p99_latency_us"] = absl::ToDoubleMicroseconds(*p99);
+  }
+}
+BENCHMARK(BM_MultiUserMediaCollectorThroughput)
+    ->ArgNames({"sources", "shards"})
+    ->ArgsProduct({{10, 50, 200}, {0, 4}})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace media_api_samples
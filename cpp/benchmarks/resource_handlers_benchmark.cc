@@ -0,0 +1,161 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks for parsing resource updates received over the data channels.
+
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/media_entries_resource_handler.h"
+#include "cpp/internal/media_stats_resource_handler.h"
+#include "cpp/internal/participants_resource_handler.h"
+#include "cpp/internal/resource_handler_interface.h"
+#include "cpp/internal/session_control_resource_handler.h"
+#include "cpp/internal/video_assignment_resource_handler.h"
+
+namespace meet {
+namespace {
+
+// Wraps `resources` in a resource update message.
+std::string CreateUpdate(const std::vector<std::string>& resources) {
+  return absl::StrCat(R"json({"resources": [)json",
+                      absl::StrJoin(resources, ","), "]}");
+}
+
+std::string CreateMediaEntriesUpdate(int resource_count) {
+  std::vector<std::string> resources;
+  for (int i = 0; i < resource_count; ++i) {
+    resources.push_back(absl::StrCat(R"json({
+      "id": )json", i, R"json(,
+      "mediaEntry": {
+        "participant": "participants/)json", i, R"json(",
+        "participantKey": "participants/participant-key-)json", i, R"json(",
+        "session": "participants/)json", i, R"json(/participantSessions/0",
+        "sessionName": "participants/participant-key-)json", i,
+                                     R"json(/participantSessions/session",
+        "audioCsrc": )json", 1000 + i, R"json(,
+        "videoCsrcs": [)json", 2000 + i, R"json(],
+        "presenter": false,
+        "screenshare": false,
+        "audioMuted": false,
+        "videoMuted": false
+      }
+    })json"));
+  }
+  return CreateUpdate(resources);
+}
+
+std::string CreateParticipantsUpdate(int resource_count) {
+  std::vector<std::string> resources;
+  for (int i = 0; i < resource_count; ++i) {
+    resources.push_back(absl::StrCat(R"json({
+      "id": )json", i, R"json(,
+      "participant": {
+        "participantId": )json", i, R"json(,
+        "name": "participants/)json", i, R"json(",
+        "participantKey": "participants/participant-key-)json", i, R"json(",
+        "signedInUser": {
+          "user": "users/)json", i, R"json(",
+          "displayName": "Participant )json", i, R"json("
+        }
+      }
+    })json"));
+  }
+  return CreateUpdate(resources);
+}
+
+std::string CreateVideoAssignmentUpdate(int canvas_count) {
+  std::vector<std::string> canvases;
+  for (int i = 0; i < canvas_count; ++i) {
+    canvases.push_back(absl::StrCat(R"json({
+      "canvasId": )json", i, R"json(,
+      "ssrc": )json", 3000 + i, R"json(,
+      "mediaEntryId": )json", i, "}"));
+  }
+  return CreateUpdate({absl::StrCat(R"json({
+    "videoAssignment": {
+      "label": "assignment",
+      "canvases": [)json", absl::StrJoin(canvases, ","), "]}}")});
+}
+
+void ParseUpdates(benchmark::State& state, ResourceHandlerInterface& handler,
+                  const std::string& update) {
+  for (auto _ : state) {
+    absl::StatusOr<ResourceUpdate> parsed_update = handler.ParseUpdate(update);
+    benchmark::DoNotOptimize(parsed_update);
+  }
+  state.SetBytesProcessed(state.iterations() * update.size());
+}
+
+// Args: number of media entries in the update.
+void BM_MediaEntriesResourceHandlerParseUpdate(benchmark::State& state) {
+  MediaEntriesResourceHandler handler;
+  ParseUpdates(state, handler, CreateMediaEntriesUpdate(state.range(0)));
+}
+BENCHMARK(BM_MediaEntriesResourceHandlerParseUpdate)->Arg(1)->Arg(100);
+
+// Args: number of participants in the update.
+void BM_ParticipantsResourceHandlerParseUpdate(benchmark::State& state) {
+  ParticipantsResourceHandler handler;
+  ParseUpdates(state, handler, CreateParticipantsUpdate(state.range(0)));
+}
+BENCHMARK(BM_ParticipantsResourceHandlerParseUpdate)->Arg(1)->Arg(100);
+
+// Args: number of canvases in the assignment.
+void BM_VideoAssignmentResourceHandlerParseUpdate(benchmark::State& state) {
+  VideoAssignmentResourceHandler handler;
+  ParseUpdates(state, handler, CreateVideoAssignmentUpdate(state.range(0)));
+}
+BENCHMARK(BM_VideoAssignmentResourceHandlerParseUpdate)->Arg(1)->Arg(9);
+
+void BM_MediaStatsResourceHandlerParseUpdate(benchmark::State& state) {
+  MediaStatsResourceHandler handler;
+  ParseUpdates(state, handler, CreateUpdate({R"json({
+    "configuration": {
+      "uploadIntervalSeconds": 10,
+      "allowlist": {
+        "candidate-pair": {
+          "keys": ["lastPacketSentTimestamp", "lastPacketReceivedTimestamp"]
+        },
+        "inbound-rtp": {
+          "keys": ["packetsReceived", "bytesReceived", "jitter"]
+        },
+        "transport": {
+          "keys": ["bytesSent", "bytesReceived"]
+        }
+      }
+    }
+  })json"}));
+}
+BENCHMARK(BM_MediaStatsResourceHandlerParseUpdate);
+
+void BM_SessionControlResourceHandlerParseUpdate(benchmark::State& state) {
+  SessionControlResourceHandler handler;
+  ParseUpdates(state, handler, CreateUpdate({R"json({
+    "sessionStatus": {
+      "connectionState": "STATE_JOINED"
+    }
+  })json"}));
+}
+BENCHMARK(BM_SessionControlResourceHandlerParseUpdate);
+
+}  // namespace
+}  // namespace meet
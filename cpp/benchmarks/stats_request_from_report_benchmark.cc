@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks for converting WebRTC stats reports into media stats requests.
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "benchmark/benchmark.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "cpp/api/media_stats_resource.h"
+#include "cpp/internal/stats_request_from_report.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/stats/rtc_stats_report.h"
+#include "webrtc/api/stats/rtcstats_objects.h"
+#include "webrtc/api/units/timestamp.h"
+
+namespace meet {
+namespace {
+
+// Creates a report with one candidate pair, one transport, and an inbound RTP
+// stream per received stream.
+rtc::scoped_refptr<const webrtc::RTCStatsReport> CreateReport(
+    int inbound_stream_count) {
+  auto report = webrtc::RTCStatsReport::Create(webrtc::Timestamp::Zero());
+  auto candidate_pair_section =
+      std::make_unique<webrtc::RTCIceCandidatePairStats>(
+          "candidate_pair_id", webrtc::Timestamp::Zero());
+  candidate_pair_section->last_packet_sent_timestamp = 100;
+  candidate_pair_section->last_packet_received_timestamp = 200;
+  report->AddStats(std::move(candidate_pair_section));
+  auto rtc_transport_section = std::make_unique<webrtc::RTCTransportStats>(
+      "rtc_transport_id", webrtc::Timestamp::Zero());
+  rtc_transport_section->bytes_sent = 1000;
+  rtc_transport_section->bytes_received = 2000;
+  report->AddStats(std::move(rtc_transport_section));
+  for (int i = 0; i < inbound_stream_count; ++i) {
+    auto inbound_rtp_section =
+        std::make_unique<webrtc::RTCInboundRtpStreamStats>(
+            absl::StrCat("inbound_rtp_id_", i), webrtc::Timestamp::Zero());
+    inbound_rtp_section->packets_received = 300;
+    inbound_rtp_section->bytes_received = 4000;
+    inbound_rtp_section->jitter = 0.5;
+    report->AddStats(std::move(inbound_rtp_section));
+  }
+  return report;
+}
+
+// Args: number of inbound RTP streams in the report.
+void BM_StatsRequestFromReport(benchmark::State& state) {
+  rtc::scoped_refptr<const webrtc::RTCStatsReport> report =
+      CreateReport(state.range(0));
+  const absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>
+      allowlist = {
+          {"candidate-pair",
+           {"lastPacketSentTimestamp", "lastPacketReceivedTimestamp"}},
+          {"inbound-rtp", {"packetsReceived", "bytesReceived", "jitter"}},
+          {"transport", {"bytesSent", "bytesReceived"}},
+      };
+
+  for (auto _ : state) {
+    MediaStatsChannelFromClient request =
+        StatsRequestFromReport(report, /*stats_request_id=*/7, allowlist);
+    benchmark::DoNotOptimize(request);
+  }
+}
+BENCHMARK(BM_StatsRequestFromReport)->Arg(1)->Arg(10)->Arg(50);
+
+}  // namespace
+}  // namespace meet
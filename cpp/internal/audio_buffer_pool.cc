@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/audio_buffer_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/rtc_base/ref_counted_object.h"
+
+namespace meet {
+
+rtc::scoped_refptr<AudioBufferInterface> AudioBufferPool::Acquire(
+    absl::Span<const int16_t> pcm16) {
+  rtc::scoped_refptr<rtc::RefCountedObject<PooledAudioBuffer>> buffer =
+      AcquireUnused();
+  buffer->Assign(pcm16);
+  return buffer;
+}
+
+rtc::scoped_refptr<AudioBufferPool::PooledAudioBuffer>
+AudioBufferPool::AcquireEmpty(size_t capacity) {
+  rtc::scoped_refptr<rtc::RefCountedObject<PooledAudioBuffer>> buffer =
+      AcquireUnused();
+  buffer->samples_.clear();
+  buffer->samples_.reserve(capacity);
+  return buffer;
+}
+
+rtc::scoped_refptr<rtc::RefCountedObject<AudioBufferPool::PooledAudioBuffer>>
+AudioBufferPool::AcquireUnused() {
+  for (const auto& buffer : buffers_) {
+    // If the pool holds the only reference, no observer is using the buffer
+    // and it can be recycled.
+    if (buffer->HasOneRef()) {
+      return buffer;
+    }
+  }
+
+  rtc::scoped_refptr<rtc::RefCountedObject<PooledAudioBuffer>> buffer(
+      new rtc::RefCountedObject<PooledAudioBuffer>());
+  if (buffers_.size() < max_pooled_buffers_) {
+    buffers_.push_back(buffer);
+  }
+  return buffer;
+}
+
+}  // namespace meet
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_AUDIO_BUFFER_POOL_H_
+#define CPP_INTERNAL_AUDIO_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/rtc_base/ref_counted_object.h"
+
+namespace meet {
+
+// The number of buffers retained by a pool by default.
+//
+// Audio frames are produced every 10ms per stream, so this allows observers to
+// hold on to roughly half a second of audio per stream before the pool starts
+// allocating buffers that are not recycled.
+inline constexpr size_t kDefaultMaxPooledAudioBuffers = 50;
+
+// A pool of recyclable `AudioBufferInterface` instances.
+//
+// Buffers are returned to the pool when their last external reference is
+// released, so steady-state audio delivery does not allocate.
+//
+// `Acquire` is not thread-safe and must always be called from the same thread.
+// Buffers returned by `Acquire` may be released on any thread.
+class AudioBufferPool {
+ public:
+  // A pooled buffer, which may be written to by its first holder before it is
+  // shared with observers.
+  class PooledAudioBuffer : public AudioBufferInterface {
+   public:
+    absl::Span<const int16_t> pcm16() const override { return samples_; }
+
+    void Assign(absl::Span<const int16_t> pcm16) {
+      // Reuses the existing allocation when the frame size is unchanged, which
+      // is the common case.
+      samples_.assign(pcm16.begin(), pcm16.end());
+    }
+
+    // Appends `pcm16` to the samples. Invalidates the spans previously
+    // returned by `pcm16()`.
+    void Append(absl::Span<const int16_t> pcm16) {
+      samples_.insert(samples_.end(), pcm16.begin(), pcm16.end());
+    }
+
+   private:
+    friend class AudioBufferPool;
+
+    std::vector<int16_t> samples_;
+  };
+
+  explicit AudioBufferPool(
+      size_t max_pooled_buffers = kDefaultMaxPooledAudioBuffers)
+      : max_pooled_buffers_(max_pooled_buffers) {}
+
+  // AudioBufferPool is neither copyable nor movable.
+  AudioBufferPool(const AudioBufferPool&) = delete;
+  AudioBufferPool& operator=(const AudioBufferPool&) = delete;
+
+  // Returns a buffer containing a copy of `pcm16`.
+  //
+  // If every pooled buffer is still in use and the pool is full, a new buffer
+  // that is not owned by the pool is returned.
+  rtc::scoped_refptr<AudioBufferInterface> Acquire(
+      absl::Span<const int16_t> pcm16);
+
+  // Returns an empty buffer with room for at least `capacity` samples, so that
+  // several frames of audio can be appended to it without reallocating.
+  //
+  // As with `Acquire`, a buffer that is not owned by the pool is returned if
+  // the pool is full.
+  rtc::scoped_refptr<PooledAudioBuffer> AcquireEmpty(size_t capacity);
+
+  // Returns the number of buffers owned by the pool.
+  size_t size() const { return buffers_.size(); }
+
+ private:
+  // Returns a buffer that no observer is using, which has arbitrary contents.
+  rtc::scoped_refptr<rtc::RefCountedObject<PooledAudioBuffer>> AcquireUnused();
+
+  size_t max_pooled_buffers_;
+  std::vector<rtc::scoped_refptr<rtc::RefCountedObject<PooledAudioBuffer>>>
+      buffers_;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_AUDIO_BUFFER_POOL_H_
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/audio_buffer_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/scoped_refptr.h"
+
+namespace meet {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+TEST(AudioBufferPoolTest, AcquireCopiesSamples) {
+  AudioBufferPool pool;
+  std::vector<int16_t> samples = {1, 2, 3, 4};
+
+  rtc::scoped_refptr<AudioBufferInterface> buffer = pool.Acquire(samples);
+  samples[0] = 100;
+
+  EXPECT_THAT(buffer->pcm16(), ElementsAre(1, 2, 3, 4));
+}
+
+TEST(AudioBufferPoolTest, RecyclesReleasedBuffers) {
+  AudioBufferPool pool;
+  std::vector<int16_t> samples1 = {1, 2, 3};
+  std::vector<int16_t> samples2 = {4, 5, 6};
+
+  rtc::scoped_refptr<AudioBufferInterface> buffer1 = pool.Acquire(samples1);
+  const AudioBufferInterface* buffer1_address = buffer1.get();
+  buffer1 = nullptr;
+  rtc::scoped_refptr<AudioBufferInterface> buffer2 = pool.Acquire(samples2);
+
+  EXPECT_EQ(buffer2.get(), buffer1_address);
+  EXPECT_THAT(buffer2->pcm16(), ElementsAreArray(samples2));
+  EXPECT_EQ(pool.size(), 1);
+}
+
+TEST(AudioBufferPoolTest, DoesNotRecycleRetainedBuffers) {
+  AudioBufferPool pool;
+  std::vector<int16_t> samples1 = {1, 2, 3};
+  std::vector<int16_t> samples2 = {4, 5, 6};
+
+  rtc::scoped_refptr<AudioBufferInterface> buffer1 = pool.Acquire(samples1);
+  rtc::scoped_refptr<AudioBufferInterface> buffer2 = pool.Acquire(samples2);
+
+  EXPECT_NE(buffer1.get(), buffer2.get());
+  EXPECT_THAT(buffer1->pcm16(), ElementsAreArray(samples1));
+  EXPECT_THAT(buffer2->pcm16(), ElementsAreArray(samples2));
+  EXPECT_EQ(pool.size(), 2);
+}
+
+TEST(AudioBufferPoolTest, AllocatesUnpooledBuffersWhenFull) {
+  AudioBufferPool pool(/*max_pooled_buffers=*/1);
+  std::vector<int16_t> samples1 = {1, 2, 3};
+  std::vector<int16_t> samples2 = {4, 5, 6};
+
+  rtc::scoped_refptr<AudioBufferInterface> buffer1 = pool.Acquire(samples1);
+  rtc::scoped_refptr<AudioBufferInterface> buffer2 = pool.Acquire(samples2);
+
+  EXPECT_THAT(buffer1->pcm16(), ElementsAreArray(samples1));
+  EXPECT_THAT(buffer2->pcm16(), ElementsAreArray(samples2));
+  EXPECT_EQ(pool.size(), 1);
+}
+
+TEST(AudioBufferPoolTest, AcquireEmptyRecyclesBuffersForAppending) {
+  AudioBufferPool pool;
+  std::vector<int16_t> samples1 = {1, 2, 3};
+  std::vector<int16_t> samples2 = {4, 5};
+
+  rtc::scoped_refptr<AudioBufferInterface> released = pool.Acquire(samples1);
+  const AudioBufferInterface* released_address = released.get();
+  released = nullptr;
+  rtc::scoped_refptr<AudioBufferPool::PooledAudioBuffer> buffer =
+      pool.AcquireEmpty(/*capacity=*/6);
+  EXPECT_TRUE(buffer->pcm16().empty());
+  buffer->Append(samples2);
+  buffer->Append(samples1);
+
+  EXPECT_EQ(buffer.get(), released_address);
+  EXPECT_THAT(buffer->pcm16(), ElementsAre(4, 5, 1, 2, 3));
+  EXPECT_EQ(pool.size(), 1);
+}
+
+}  // namespace
+}  // namespace meet
@@ -16,6 +16,7 @@
 
 #include "cpp/internal/conference_data_channel.h"
 
+#include <cstdint>
 #include <string>
 #include <utility>
 
@@ -24,12 +25,28 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/trace.h"
+#include "cpp/internal/trace_events.h"
 #include "webrtc/api/data_channel_interface.h"
 #include "webrtc/api/rtc_error.h"
+#include "webrtc/rtc_base/time_utils.h"
 
 namespace meet {
 
+void ConferenceDataChannel::OnStateChange() {
+  webrtc::DataChannelInterface::DataState state = data_channel_->state();
+  LOG(INFO) << "ConferenceDataChannel::OnStateChange: " << state;
+  if (state != webrtc::DataChannelInterface::kOpen) {
+    return;
+  }
+  absl::MutexLock lock(&mutex_);
+  if (!opened_time_us_.has_value()) {
+    opened_time_us_ = rtc::TimeMicros();
+  }
+}
+
 void ConferenceDataChannel::OnMessage(const webrtc::DataBuffer& buffer) {
+  MEET_TRACE_EVENT("ConferenceDataChannel::OnMessage");
   // Short-circuit if there is no callback for the message.
   if (!callback_) {
     LOG(WARNING) << label()
@@ -44,8 +61,14 @@ void ConferenceDataChannel::OnMessage(const webrtc::DataBuffer& buffer) {
   }
 
   absl::string_view message(buffer.data.cdata<char>(), buffer.size());
+  message_bytes_.Record(message.size());
+  if (message_recorder_ != nullptr) {
+    message_recorder_->OnDataChannelMessage(label(), message);
+  }
+  int64_t parse_start_us = rtc::TimeMicros();
   absl::StatusOr<ResourceUpdate> update_parse_status =
       resource_handler_->ParseUpdate(message);
+  parse_latency_us_.Record(rtc::TimeMicros() - parse_start_us);
   if (!update_parse_status.ok()) {
     LOG(ERROR) << "Received " << label()
                << " resource update but it failed to parse: "
@@ -53,7 +76,8 @@ void ConferenceDataChannel::OnMessage(const webrtc::DataBuffer& buffer) {
     return;
   }
 
-  VLOG(1) << label() << " data channel received update: " << message;
+  MEET_TRACE(kDataChannel) << label()
+                           << " data channel received update: " << message;
 
   callback_(*std::move(update_parse_status));
 }
@@ -65,7 +89,8 @@ absl::Status ConferenceDataChannel::SendRequest(ResourceRequest request) {
     return stringify_status.status();
   }
 
-  VLOG(1) << "Sending " << label() << " request: " << *stringify_status;
+  MEET_TRACE(kDataChannel) << "Sending " << label()
+                           << " request: " << *stringify_status;
 
   data_channel_->SendAsync(
       // Closing the associated peer connection prevents new tasks from being
@@ -17,14 +17,20 @@
 #ifndef CPP_INTERNAL_CONFERENCE_DATA_CHANNEL_H_
 #define CPP_INTERNAL_CONFERENCE_DATA_CHANNEL_H_
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/internal/conference_data_channel_interface.h"
+#include "cpp/internal/metrics_registry.h"
 #include "cpp/internal/resource_handler_interface.h"
 #include "webrtc/api/data_channel_interface.h"
 #include "webrtc/api/scoped_refptr.h"
@@ -38,11 +44,28 @@ namespace meet {
 class ConferenceDataChannel : public ConferenceDataChannelInterface,
                               public webrtc::DataChannelObserver {
  public:
+  // Received message sizes and parse times are recorded in `metrics`, if
+  // provided. Received messages are passed to `message_recorder`, if provided,
+  // before they are parsed.
   ConferenceDataChannel(
       std::unique_ptr<ResourceHandlerInterface> resource_handler,
-      rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel)
+      rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel,
+      std::shared_ptr<MetricsRegistry> metrics = nullptr,
+      std::shared_ptr<DataChannelMessageRecorderInterface> message_recorder =
+          nullptr)
       : resource_handler_(std::move(resource_handler)),
-        data_channel_(std::move(data_channel)) {
+        data_channel_(std::move(data_channel)),
+        message_recorder_(std::move(message_recorder)),
+        metrics_(metrics != nullptr ? std::move(metrics)
+                                    : std::make_shared<MetricsRegistry>()),
+        message_bytes_(metrics_->GetHistogram(
+            absl::StrCat("meet_data_channel_message_bytes{label=\"", label(),
+                         "\"}"),
+            kSizeBucketsBytes)),
+        parse_latency_us_(metrics_->GetHistogram(
+            absl::StrCat("meet_data_channel_parse_latency_us{label=\"",
+                         label(), "\"}"),
+            kLatencyBucketsUs)) {
     data_channel_->RegisterObserver(this);
   };
 
@@ -55,10 +78,7 @@ class ConferenceDataChannel : public ConferenceDataChannelInterface,
   ConferenceDataChannel(const ConferenceDataChannel&) = delete;
   ConferenceDataChannel& operator=(const ConferenceDataChannel&) = delete;
 
-  void OnStateChange() override {
-    LOG(INFO) << "ConferenceDataChannel::OnStateChange: "
-              << data_channel_->state();
-  };
+  void OnStateChange() override;
 
   void OnMessage(const webrtc::DataBuffer& buffer) override;
 
@@ -83,12 +103,23 @@ class ConferenceDataChannel : public ConferenceDataChannelInterface,
 
   absl::Status SendRequest(ResourceRequest request) override;
 
+  std::optional<int64_t> GetOpenedTimeUs() const override {
+    absl::MutexLock lock(&mutex_);
+    return opened_time_us_;
+  }
+
  private:
   std::string label() const { return data_channel_->label(); }
 
   ResourceUpdateCallback callback_;
   std::unique_ptr<ResourceHandlerInterface> resource_handler_;
   rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel_;
+  std::shared_ptr<DataChannelMessageRecorderInterface> message_recorder_;
+  std::shared_ptr<MetricsRegistry> metrics_;
+  Histogram& message_bytes_;
+  Histogram& parse_latency_us_;
+  mutable absl::Mutex mutex_;
+  std::optional<int64_t> opened_time_us_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace meet
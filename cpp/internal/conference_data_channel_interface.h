@@ -17,6 +17,9 @@
 #ifndef CPP_INTERNAL_CONFERENCE_DATA_CHANNEL_INTERFACE_H_
 #define CPP_INTERNAL_CONFERENCE_DATA_CHANNEL_INTERFACE_H_
 
+#include <cstdint>
+#include <optional>
+
 #include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "cpp/api/media_api_client_interface.h"
@@ -36,6 +39,12 @@ class ConferenceDataChannelInterface {
 
   // Sends a resource request to Meet servers.
   virtual absl::Status SendRequest(ResourceRequest request) = 0;
+
+  // Returns the time at which the data channel opened, as returned by
+  // `rtc::TimeMicros()`, or nullopt if it has not opened yet.
+  //
+  // This may be called from any thread.
+  virtual std::optional<int64_t> GetOpenedTimeUs() const = 0;
 };
 
 }  // namespace meet
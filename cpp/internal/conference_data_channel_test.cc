@@ -168,6 +168,38 @@ TEST(ConferenceDataChannelTest, ReceivingUpdateSucceeds) {
       std::holds_alternative<SessionControlChannelToClient>(received_update));
 }
 
+class MockDataChannelMessageRecorder
+    : public DataChannelMessageRecorderInterface {
+ public:
+  MOCK_METHOD(void, OnDataChannelMessage,
+              (absl::string_view label, absl::string_view message),
+              (override));
+};
+
+TEST(ConferenceDataChannelTest, ReceivedMessagesArePassedToRecorder) {
+  auto resource_handler = std::make_unique<MockResourceHandler>();
+  EXPECT_CALL(*resource_handler, ParseUpdate(_))
+      .WillOnce(Return(SessionControlChannelToClient()));
+  auto data_channel = webrtc::MockDataChannelInterface::Create();
+  EXPECT_CALL(*data_channel, label).WillRepeatedly(Return("session-control"));
+  webrtc::DataChannelObserver *observer;
+  EXPECT_CALL(*data_channel, RegisterObserver(_))
+      .WillOnce([&observer](webrtc::DataChannelObserver *inner_observer) {
+        observer = inner_observer;
+      });
+  auto recorder = std::make_shared<MockDataChannelMessageRecorder>();
+  EXPECT_CALL(*recorder,
+              OnDataChannelMessage(StrEq("session-control"), StrEq("update")));
+  ConferenceDataChannel conference_data_channel(
+      std::move(resource_handler), std::move(data_channel),
+      /*metrics=*/nullptr, recorder);
+  MockFunction<void(ResourceUpdate)> mock_function;
+  EXPECT_CALL(mock_function, Call);
+  conference_data_channel.SetCallback(mock_function.AsStdFunction());
+
+  observer->OnMessage(webrtc::DataBuffer("update"));
+}
+
 TEST(ConferenceDataChannelTest, ReceivingUpdateWithoutCallbackDoesNothing) {
   auto data_channel = webrtc::MockDataChannelInterface::Create();
   webrtc::DataChannelObserver *observer;
@@ -16,40 +16,210 @@
 
 #include "cpp/internal/conference_media_tracks.h"
 
+#include <atomic>
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <utility>
+#include <vector>
 
 #include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/audio_buffer_pool.h"
 #include "webrtc/api/rtp_packet_info.h"
 #include "webrtc/api/rtp_packet_infos.h"
+#include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/transport/rtp/rtp_source.h"
+#include "webrtc/api/units/timestamp.h"
 #include "webrtc/api/video/video_frame.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/api/video/video_source_interface.h"
 
 namespace meet {
+namespace {
 
-void ConferenceAudioTrack::OnData(
+// Frames rendered up to this much earlier than the frame rate limit allows are
+// still delivered, so that jitter in the render times of a stream sent at
+// exactly the limit does not drop every other frame.
+constexpr int64_t kFrameIntervalToleranceUs = 5'000;
+
+// Meet sends Opus audio, whose RTP clock always runs at 48kHz regardless of the
+// decoded sample rate.
+constexpr int64_t kOpusRtpClockRate = 48'000;
+
+// Returns whether the samples of `b` can be appended to those of `a`.
+bool HaveSameSourcesAndFormat(const AudioFrame& a, const AudioFrame& b) {
+  return a.sample_rate == b.sample_rate &&
+         a.number_of_channels == b.number_of_channels &&
+         a.contributing_source == b.contributing_source &&
+         a.synchronization_source == b.synchronization_source &&
+         a.is_from_loudest_speaker == b.is_from_loudest_speaker;
+}
+
+}  // namespace
+
+absl::Status ValidateVideoSinkConstraints(
+    const VideoSinkConstraints& constraints) {
+  if (constraints.max_pixel_count.has_value() &&
+      *constraints.max_pixel_count <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Video sink max pixel count must be positive; got ",
+                     *constraints.max_pixel_count));
+  }
+  if (constraints.max_framerate_fps.has_value() &&
+      *constraints.max_framerate_fps <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Video sink max framerate must be positive; got ",
+                     *constraints.max_framerate_fps));
+  }
+  return absl::OkStatus();
+}
+
+rtc::VideoSinkWants ToVideoSinkWants(const VideoSinkConstraints& constraints) {
+  rtc::VideoSinkWants wants;
+  if (constraints.max_pixel_count.has_value()) {
+    wants.max_pixel_count = *constraints.max_pixel_count;
+  }
+  if (constraints.max_framerate_fps.has_value()) {
+    wants.max_framerate_fps = *constraints.max_framerate_fps;
+  }
+  return wants;
+}
+
+std::optional<AudioFrame> ConferenceAudioTrackBase::ConvertData(
     const void* audio_data, int bits_per_sample, int sample_rate,
     size_t number_of_channels, size_t number_of_frames,
     absl::optional<int64_t> absolute_capture_timestamp_ms) {
+  if (paused_.load(std::memory_order_relaxed)) {
+    // Aggregated audio is dropped, so that it is not joined to the audio
+    // received once the track is resumed.
+    aggregated_frame_.reset();
+    aggregated_buffer_ = nullptr;
+    return std::nullopt;
+  }
   if (bits_per_sample != 16) {
     LOG(ERROR) << "Unsupported bits per sample: " << bits_per_sample
                << ". Expected 16.";
-    return;
+    return std::nullopt;
   }
 
   // Audio data is expected to be in PCM format, where each sample is 16 bits.
   const auto* pcm_data = reinterpret_cast<const int16_t*>(audio_data);
 
-  bool is_from_loudest_speaker = false;
-  std::optional<uint32_t> csrc;
-  std::optional<uint32_t> ssrc;
+  cached_sources_age_ += absl::Seconds(number_of_frames) / sample_rate;
+  if (!cached_sources_.has_value() ||
+      cached_sources_age_ >= source_refresh_interval_) {
+    cached_sources_ = ResolveSources();
+    cached_sources_age_ = absl::ZeroDuration();
+    if (cached_sources_.has_value()) {
+      next_rtp_timestamp_ = cached_sources_->rtp_timestamp;
+    }
+  }
+  if (!cached_sources_.has_value()) {
+    return std::nullopt;
+  }
+  // RTP timestamps wrap around, so the estimate is advanced modulo 2^32.
+  uint32_t rtp_timestamp = next_rtp_timestamp_;
+  next_rtp_timestamp_ += static_cast<uint32_t>(
+      static_cast<int64_t>(number_of_frames) * kOpusRtpClockRate / sample_rate);
+  absl::Time receive_time = absl::Now();
+  std::optional<int64_t> capture_timestamp_ms;
+  if (absolute_capture_timestamp_ms.has_value()) {
+    capture_timestamp_ms = *absolute_capture_timestamp_ms;
+  }
+
+  // Audio data in PCM format is expected to be stored in a contiguous buffer,
+  // where there are `number_of_channels * number_of_frames` audio frames.
+  absl::Span<const int16_t> pcm_data_span =
+      absl::MakeConstSpan(pcm_data, number_of_channels * number_of_frames);
+  AudioFrame frame{
+      .pcm16 = pcm_data_span,
+      .bits_per_sample = bits_per_sample,
+      .sample_rate = sample_rate,
+      .number_of_channels = number_of_channels,
+      .number_of_frames = number_of_frames,
+      .is_from_loudest_speaker = cached_sources_->is_from_loudest_speaker,
+      .contributing_source = cached_sources_->contributing_source,
+      .synchronization_source = cached_sources_->synchronization_source,
+      .absolute_capture_timestamp_ms = capture_timestamp_ms,
+      .rtp_timestamp = rtp_timestamp,
+      .receive_time = receive_time};
+  if (aggregation_window_ > absl::ZeroDuration()) {
+    return Aggregate(std::move(frame));
+  }
+  frame.buffer = buffer_pool_.Acquire(pcm_data_span);
+  frame.pcm16 = frame.buffer->pcm16();
+  return frame;
+}
+
+std::optional<AudioFrame> ConferenceAudioTrackBase::Aggregate(
+    AudioFrame frame) {
+  std::optional<AudioFrame> completed_frame;
+  // A complete frame is normally delivered as soon as it is completed. It is
+  // only still aggregated here if it was completed by the audio that followed
+  // a change of sources, in which case the previous frame was delivered first.
+  if (aggregated_frame_.has_value() &&
+      (IsAggregatedFrameComplete() ||
+       !HaveSameSourcesAndFormat(*aggregated_frame_, frame))) {
+    completed_frame = TakeAggregatedFrame();
+  }
+
+  if (!aggregated_frame_.has_value()) {
+    size_t window_frames = static_cast<size_t>(
+        aggregation_window_ * frame.sample_rate / absl::Seconds(1));
+    aggregated_buffer_ =
+        buffer_pool_.AcquireEmpty(window_frames * frame.number_of_channels);
+    aggregated_frame_ = std::move(frame);
+    aggregated_buffer_->Append(aggregated_frame_->pcm16);
+    aggregated_frame_->pcm16 = {};
+  } else {
+    aggregated_buffer_->Append(frame.pcm16);
+    aggregated_frame_->number_of_frames += frame.number_of_frames;
+  }
+
+  if (!completed_frame.has_value() && IsAggregatedFrameComplete()) {
+    completed_frame = TakeAggregatedFrame();
+  }
+  return completed_frame;
+}
+
+bool ConferenceAudioTrackBase::IsAggregatedFrameComplete() const {
+  return absl::Seconds(aggregated_frame_->number_of_frames) /
+             aggregated_frame_->sample_rate >=
+         aggregation_window_;
+}
+
+AudioFrame ConferenceAudioTrackBase::TakeAggregatedFrame() {
+  AudioFrame frame = *std::move(aggregated_frame_);
+  aggregated_frame_.reset();
+  frame.pcm16 = aggregated_buffer_->pcm16();
+  frame.buffer = std::move(aggregated_buffer_);
+  return frame;
+}
+
+std::optional<ConferenceAudioTrackBase::AudioSources>
+ConferenceAudioTrackBase::ResolveSources() const {
+  const webrtc::RtpSource* csrc_source = nullptr;
+  const webrtc::RtpSource* ssrc_source = nullptr;
+  std::optional<webrtc::Timestamp> loudest_speaker_timestamp;
   // Audio csrcs and ssrcs are not included in the audio data. Therefore,
   // extract them from the RtpReceiver.
-  for (const auto& rtp_source : receiver_->GetSources()) {
+  //
+  // The receiver reports every source seen in the last few seconds, so each
+  // source's receive time is used to select the sources of the most recently
+  // received packets. Otherwise, audio would be attributed to a previous
+  // speaker on this stream for several seconds after a speaker switch.
+  std::vector<webrtc::RtpSource> rtp_sources = receiver_->GetSources();
+  for (const webrtc::RtpSource& rtp_source : rtp_sources) {
     // It is expected that there may be 1 or 2 contributing sources. The
     // contributing source corresponding to the participant's audio stream will
     // always be present. Meet may also send a contributing source with value
@@ -61,15 +231,31 @@ void ConferenceAudioTrack::OnData(
     // other methods may be used as well).
     if (rtp_source.source_type() == webrtc::RtpSourceType::CSRC) {
       if (rtp_source.source_id() == kLoudestSpeakerCsrc) {
-        is_from_loudest_speaker = true;
-      } else {
-        csrc = rtp_source.source_id();
+        if (!loudest_speaker_timestamp.has_value() ||
+            rtp_source.timestamp() > *loudest_speaker_timestamp) {
+          loudest_speaker_timestamp = rtp_source.timestamp();
+        }
+      } else if (csrc_source == nullptr ||
+                 rtp_source.timestamp() > csrc_source->timestamp()) {
+        csrc_source = &rtp_source;
       }
     } else if (rtp_source.source_type() == webrtc::RtpSourceType::SSRC) {
-      ssrc = rtp_source.source_id();
+      if (ssrc_source == nullptr ||
+          rtp_source.timestamp() > ssrc_source->timestamp()) {
+        ssrc_source = &rtp_source;
+      }
     }
   }
 
+  std::optional<uint32_t> csrc;
+  if (csrc_source != nullptr) {
+    csrc = csrc_source->source_id();
+  }
+  std::optional<uint32_t> ssrc;
+  if (ssrc_source != nullptr) {
+    ssrc = ssrc_source->source_id();
+  }
+
   if (!csrc.has_value() || !ssrc.has_value()) {
     // Before real audio starts flowing, silent audio frames will be received.
     // These frames will not have a CSRC or SSRC. Because these frames will be
@@ -84,40 +270,74 @@ void ConferenceAudioTrack::OnData(
     if (!ssrc.has_value()) {
       VLOG(2) << "AudioFrame is missing SSRC for mid: " << mid_;
     }
-    return;
+    return std::nullopt;
   }
 
-  // Audio data in PCM format is expected to be stored in a contiguous buffer,
-  // where there are `number_of_channels * number_of_frames` audio frames.
-  absl::Span<const int16_t> pcm_data_span =
-      absl::MakeConstSpan(pcm_data, number_of_channels * number_of_frames);
-  callback_(AudioFrame{.pcm16 = std::move(pcm_data_span),
-                       .bits_per_sample = bits_per_sample,
-                       .sample_rate = sample_rate,
-                       .number_of_channels = number_of_channels,
-                       .number_of_frames = number_of_frames,
-                       .is_from_loudest_speaker = is_from_loudest_speaker,
-                       .contributing_source = csrc.value(),
-                       .synchronization_source = ssrc.value()});
-};
-
-void ConferenceVideoTrack::OnFrame(const webrtc::VideoFrame& frame) {
+  // The loudest speaker CSRC is only relevant if it was received with the
+  // participant's CSRC, not in an earlier packet.
+  bool is_from_loudest_speaker =
+      loudest_speaker_timestamp.has_value() &&
+      *loudest_speaker_timestamp >= csrc_source->timestamp();
+  return AudioSources{.contributing_source = csrc.value(),
+                      .synchronization_source = ssrc.value(),
+                      .is_from_loudest_speaker = is_from_loudest_speaker,
+                      .rtp_timestamp = ssrc_source->rtp_timestamp()};
+}
+
+std::optional<ConferenceVideoTrackBase::PreparedFrame>
+ConferenceVideoTrackBase::PrepareFrame(const webrtc::VideoFrame& frame) {
   const webrtc::RtpPacketInfos& packet_infos = frame.packet_infos();
   if (packet_infos.empty()) {
     LOG(ERROR) << "VideoFrame is missing packet infos for mid: " << mid_;
-    return;
+    return std::nullopt;
   }
   const webrtc::RtpPacketInfo& packet_info = packet_infos.front();
   if (packet_info.csrcs().empty()) {
     LOG(ERROR) << "VideoFrame is missing CSRC for mid: " << mid_;
-    return;
+    return std::nullopt;
+  }
+
+  // It is expected that there will be only one CSRC per video frame.
+  uint32_t contributing_source = packet_info.csrcs().front();
+  absl::Time receive_time = absl::Now();
+
+  std::optional<int> max_pixel_count;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (constraints_.max_framerate_fps.has_value()) {
+      int64_t min_interval_us = 1'000'000 / *constraints_.max_framerate_fps;
+      if (last_delivered_timestamp_us_.has_value() &&
+          frame.timestamp_us() - *last_delivered_timestamp_us_ <
+              min_interval_us - kFrameIntervalToleranceUs) {
+        return std::nullopt;
+      }
+    }
+    last_delivered_timestamp_us_ = frame.timestamp_us();
+    max_pixel_count = constraints_.max_pixel_count;
+  }
+
+  PreparedFrame prepared{.contributing_source = contributing_source,
+                         .synchronization_source = packet_info.ssrc(),
+                         .receive_time = receive_time};
+  if (max_pixel_count.has_value() && frame.size() > *max_pixel_count) {
+    double scale =
+        std::sqrt(static_cast<double>(*max_pixel_count) / frame.size());
+    // Scaled dimensions are kept even, as required by chroma subsampling.
+    int scaled_width =
+        std::max(2, static_cast<int>(frame.width() * scale) & ~1);
+    int scaled_height =
+        std::max(2, static_cast<int>(frame.height() * scale) & ~1);
+    prepared.scaled_frame = frame;
+    prepared.scaled_frame->set_video_frame_buffer(
+        frame.video_frame_buffer()->Scale(scaled_width, scaled_height));
   }
+  return prepared;
+}
 
-  callback_(VideoFrame{.frame = frame,
-                       // It is expected that there will be only one CSRC per
-                       // video frame.
-                       .contributing_source = packet_info.csrcs().front(),
-                       .synchronization_source = packet_info.ssrc()});
-};
+void ConferenceVideoTrackBase::SetConstraints(
+    VideoSinkConstraints constraints) {
+  absl::MutexLock lock(&mutex_);
+  constraints_ = std::move(constraints);
+}
 
 }  // namespace meet
@@ -17,73 +17,258 @@
 #ifndef CPP_INTERNAL_CONFERENCE_MEDIA_TRACKS_H_
 #define CPP_INTERNAL_CONFERENCE_MEDIA_TRACKS_H_
 
+#include <atomic>
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <variant>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/audio_buffer_pool.h"
+#include "cpp/internal/trace_events.h"
 #include "webrtc/api/media_stream_interface.h"
 #include "webrtc/api/rtp_receiver_interface.h"
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/video/video_frame.h"
 #include "webrtc/api/video/video_sink_interface.h"
+#include "webrtc/api/video/video_source_interface.h"
 
 namespace meet {
 // Meet uses this magic number to indicate the loudest speaker.
 inline constexpr int kLoudestSpeakerCsrc = 42;
 
-// Adapter class for webrtc::AudioTrackSinkInterface that converts
-// webrtc::AudioFrames to meet::AudioFrame and calls the callback.
-class ConferenceAudioTrack : public webrtc::AudioTrackSinkInterface {
+// How much audio `ConferenceAudioTrack` receives before querying its receiver
+// for the current contributing and synchronization sources again.
+inline constexpr absl::Duration kDefaultAudioSourceRefreshInterval =
+    absl::Milliseconds(50);
+
+// Converts the webrtc audio of a received track to meet::AudioFrames. See
+// `BasicConferenceAudioTrack`, which delivers the converted frames.
+//
+// Audio samples are copied once into a pooled `AudioBufferInterface`, which is
+// attached to the frame so that observers can retain the samples without
+// copying them again.
+//
+// Querying the receiver's sources copies them under the receiver's lock, so
+// the resolved sources are reused until `source_refresh_interval` of audio has
+// been received. A zero interval queries the receiver for every frame.
+//
+// If `aggregation_window` is positive, consecutive audio from the same sources
+// and in the same format is appended to one pooled buffer and delivered as a
+// single frame once `aggregation_window` of audio has been received, or earlier
+// if the sources or format change. The frame carries the RTP timestamp and the
+// capture and receive times of its first audio. Audio still being aggregated
+// when the track is destroyed is dropped.
+class ConferenceAudioTrackBase : public webrtc::AudioTrackSinkInterface {
  public:
-  using AudioFrameCallback = absl::AnyInvocable<void(AudioFrame frame)>;
+  // Drops received audio while paused, including audio that was being
+  // aggregated when the track was paused. Safe to call from any thread.
+  void SetPaused(bool paused) {
+    paused_.store(paused, std::memory_order_relaxed);
+  }
 
-  ConferenceAudioTrack(
+ protected:
+  ConferenceAudioTrackBase(
       std::string mid,
       rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
-      AudioFrameCallback callback)
+      absl::Duration source_refresh_interval,
+      absl::Duration aggregation_window)
       : mid_(std::move(mid)),
         receiver_(std::move(receiver)),
-        callback_(std::move(callback)) {}
+        source_refresh_interval_(source_refresh_interval),
+        aggregation_window_(aggregation_window) {}
 
-  void OnData(const void* audio_data, int bits_per_sample, int sample_rate,
-              size_t number_of_channels, size_t number_of_frames,
-              absl::optional<int64_t> absolute_capture_timestamp_ms) override;
+  // Returns the frame to deliver for the arguments of `OnData`, or nullopt if
+  // there is none yet, e.g. because the audio cannot be attributed to a
+  // participant yet, is not PCM16, or is still being aggregated.
+  std::optional<AudioFrame> ConvertData(
+      const void* audio_data, int bits_per_sample, int sample_rate,
+      size_t number_of_channels, size_t number_of_frames,
+      absl::optional<int64_t> absolute_capture_timestamp_ms);
 
  private:
+  struct AudioSources {
+    uint32_t contributing_source;
+    uint32_t synchronization_source;
+    bool is_from_loudest_speaker;
+    // RTP timestamp of the most recently received packet of the SSRC.
+    uint32_t rtp_timestamp;
+  };
+
+  // Returns the sources of the audio currently being received, or nullopt if
+  // the receiver does not report both a CSRC and an SSRC.
+  std::optional<AudioSources> ResolveSources() const;
+  // Appends `frame`, whose samples have not been copied yet, to the aggregated
+  // frame. Returns the aggregated frame if it is complete or `frame` cannot be
+  // appended to it.
+  std::optional<AudioFrame> Aggregate(AudioFrame frame);
+  // Returns whether `aggregation_window_` of audio has been aggregated.
+  bool IsAggregatedFrameComplete() const;
+  // Returns the aggregated frame and starts a new one.
+  AudioFrame TakeAggregatedFrame();
+
   // Media line from the SDP offer/answer that identifies this track.
   std::string mid_;
   rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver_;
-  AudioFrameCallback callback_;
+  std::atomic<bool> paused_ = false;
+  absl::Duration source_refresh_interval_;
+  absl::Duration aggregation_window_;
+  // The frame being aggregated, whose samples are in `aggregated_buffer_`
+  // rather than `pcm16`.
+  std::optional<AudioFrame> aggregated_frame_;
+  rtc::scoped_refptr<AudioBufferPool::PooledAudioBuffer> aggregated_buffer_;
+  // The most recently resolved sources. Unresolved sources are not cached, so
+  // that the first frames of real audio are attributed as soon as possible.
+  std::optional<AudioSources> cached_sources_;
+  // How much audio has been received since `cached_sources_` was resolved.
+  absl::Duration cached_sources_age_ = absl::ZeroDuration();
+  // Estimated RTP timestamp of the next received audio, starting from the RTP
+  // timestamp of `cached_sources_`.
+  uint32_t next_rtp_timestamp_ = 0;
+  // `OnData` is always called on the same thread, satisfying the pool's
+  // threading requirements.
+  AudioBufferPool buffer_pool_;
 };
 
-// Adapter class for rtc::VideoSinkInterface that converts
-// webrtc::VideoFrames to meet::VideoFrames and calls the callback.
-class ConferenceVideoTrack
+// Adapter class for webrtc::AudioTrackSinkInterface that converts
+// webrtc::AudioFrames to meet::AudioFrame and passes them to `FrameSink`.
+//
+// The sink is called directly, so sinks of concrete types are inlined into the
+// audio path instead of being called through a type-erased callback.
+template <typename FrameSink>
+  requires std::invocable<FrameSink&, AudioFrame>
+class BasicConferenceAudioTrack final : public ConferenceAudioTrackBase {
+ public:
+  BasicConferenceAudioTrack(
+      std::string mid,
+      rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+      FrameSink sink,
+      absl::Duration source_refresh_interval =
+          kDefaultAudioSourceRefreshInterval,
+      absl::Duration aggregation_window = absl::ZeroDuration())
+      : ConferenceAudioTrackBase(std::move(mid), std::move(receiver),
+                                 source_refresh_interval, aggregation_window),
+        sink_(std::move(sink)) {}
+
+  void OnData(const void* audio_data, int bits_per_sample, int sample_rate,
+              size_t number_of_channels, size_t number_of_frames,
+              absl::optional<int64_t> absolute_capture_timestamp_ms) override {
+    ScopedTraceEvent trace_event("ConferenceAudioTrack::OnData");
+    std::optional<AudioFrame> frame =
+        ConvertData(audio_data, bits_per_sample, sample_rate,
+                    number_of_channels, number_of_frames,
+                    absolute_capture_timestamp_ms);
+    if (frame.has_value()) {
+      trace_event.SetFrameFlow(TraceFlowPhase::kStart,
+                               frame->contributing_source, frame->receive_time);
+      sink_(*std::move(frame));
+    }
+  }
+
+ private:
+  FrameSink sink_;
+};
+
+// An audio track that delivers frames to a callback.
+using ConferenceAudioTrack =
+    BasicConferenceAudioTrack<absl::AnyInvocable<void(AudioFrame frame)>>;
+
+// Returns an error if a limit in `constraints` is set but not positive.
+absl::Status ValidateVideoSinkConstraints(
+    const VideoSinkConstraints& constraints);
+
+// Returns the sink wants asking the video source for `constraints`.
+rtc::VideoSinkWants ToVideoSinkWants(const VideoSinkConstraints& constraints);
+
+// Attributes the webrtc::VideoFrames of a received track and applies its
+// `VideoSinkConstraints`. See `BasicConferenceVideoTrack`, which delivers the
+// frames.
+//
+// Frames are dropped and downscaled according to the constraints before they
+// are delivered. The sources of received tracks do not adapt frames to the
+// sink wants they are given, so the track applies the constraints itself.
+class ConferenceVideoTrackBase
     : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
  public:
-  using VideoFrameCallback = absl::AnyInvocable<void(VideoFrame frame)>;
+  // Replaces the constraints applied to frames before they are delivered. Safe
+  // to call from any thread.
+  void SetConstraints(VideoSinkConstraints constraints);
 
-  explicit ConferenceVideoTrack(std::string mid, VideoFrameCallback callback)
-      : mid_(std::move(mid)), callback_(std::move(callback)) {}
+ protected:
+  // The part of a `VideoFrame` that is delivered for a received frame.
+  struct PreparedFrame {
+    // Set if the received frame was downscaled.
+    std::optional<webrtc::VideoFrame> scaled_frame;
+    uint32_t contributing_source;
+    uint32_t synchronization_source;
+    absl::Time receive_time;
+  };
 
-  void OnFrame(const webrtc::VideoFrame& frame) override;
+  explicit ConferenceVideoTrackBase(std::string mid) : mid_(std::move(mid)) {}
+
+  // Returns how to deliver `frame`, or nullopt if it is dropped.
+  std::optional<PreparedFrame> PrepareFrame(const webrtc::VideoFrame& frame);
 
  private:
   // Media line from the SDP offer/answer that identifies this track.
   std::string mid_;
-  VideoFrameCallback callback_;
+  absl::Mutex mutex_;
+  VideoSinkConstraints constraints_ ABSL_GUARDED_BY(mutex_);
+  // Render time of the last delivered frame, used to limit the frame rate.
+  std::optional<int64_t> last_delivered_timestamp_us_ ABSL_GUARDED_BY(mutex_);
 };
 
+// Adapter class for rtc::VideoSinkInterface that converts
+// webrtc::VideoFrames to meet::VideoFrames and passes them to `FrameSink`.
+//
+// As with `BasicConferenceAudioTrack`, the sink is called directly.
+template <typename FrameSink>
+  requires std::invocable<FrameSink&, VideoFrame>
+class BasicConferenceVideoTrack final : public ConferenceVideoTrackBase {
+ public:
+  BasicConferenceVideoTrack(std::string mid, FrameSink sink)
+      : ConferenceVideoTrackBase(std::move(mid)), sink_(std::move(sink)) {}
+
+  void OnFrame(const webrtc::VideoFrame& frame) override {
+    ScopedTraceEvent trace_event("ConferenceVideoTrack::OnFrame");
+    std::optional<PreparedFrame> prepared = PrepareFrame(frame);
+    if (!prepared.has_value()) {
+      return;
+    }
+    trace_event.SetFrameFlow(TraceFlowPhase::kStart,
+                             prepared->contributing_source,
+                             prepared->receive_time);
+    sink_(VideoFrame{.frame = prepared->scaled_frame.has_value()
+                                  ? *prepared->scaled_frame
+                                  : frame,
+                     .contributing_source = prepared->contributing_source,
+                     .synchronization_source =
+                         prepared->synchronization_source,
+                     .receive_time = prepared->receive_time});
+  }
+
+ private:
+  FrameSink sink_;
+};
+
+// A video track that delivers frames to a callback.
+using ConferenceVideoTrack =
+    BasicConferenceVideoTrack<absl::AnyInvocable<void(VideoFrame frame)>>;
+
 // Convenience type for holding either an audio or video track.
 using ConferenceMediaTrack =
-    std::variant<std::unique_ptr<ConferenceAudioTrack>,
-                 std::unique_ptr<ConferenceVideoTrack>>;
+    std::variant<std::unique_ptr<ConferenceAudioTrackBase>,
+                 std::unique_ptr<ConferenceVideoTrackBase>>;
 
 }  // namespace meet
 
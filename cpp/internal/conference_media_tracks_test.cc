@@ -27,6 +27,9 @@
 #include "testing/base/public/mock-log.h"
 #include "absl/base/log_severity.h"
 #include "absl/log/globals.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "webrtc/api/rtp_packet_info.h"
 #include "webrtc/api/rtp_packet_infos.h"
@@ -43,6 +46,7 @@ namespace {
 using ::base_logging::ERROR;
 using ::base_logging::INFO;
 using ::testing::_;
+using ::testing::ElementsAre;
 using ::testing::kDoNotCaptureLogsYet;
 using ::testing::MockFunction;
 using ::testing::Return;
@@ -146,6 +150,86 @@ TEST(ConferenceAudioTrackTest,
   EXPECT_EQ(received_frame->synchronization_source, 456);
 }
 
+TEST(ConferenceAudioTrackTest, AudioFrameCarriesCaptureAndReceiveTimes) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  webrtc::RtpSource csrc_rtp_source(
+      webrtc::Timestamp::Micros(1234567890),
+      /*source_id=*/123, webrtc::RtpSourceType::CSRC,
+      /*rtp_timestamp=*/1111111,
+      {.audio_level = 100, .absolute_capture_time = std::nullopt});
+  webrtc::RtpSource ssrc_rtp_source(
+      webrtc::Timestamp::Micros(1234567890),
+      /*source_id=*/456, webrtc::RtpSourceType::SSRC,
+      /*rtp_timestamp=*/2222222,
+      {.audio_level = 100, .absolute_capture_time = std::nullopt});
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillOnce(Return(std::vector<webrtc::RtpSource>{
+          std::move(csrc_rtp_source), std::move(ssrc_rtp_source)}));
+  MockFunction<void(AudioFrame)> mock_function;
+  std::optional<AudioFrame> received_frame;
+  EXPECT_CALL(mock_function, Call)
+      .WillOnce([&received_frame](AudioFrame frame) {
+        received_frame = std::move(frame);
+      });
+  ConferenceAudioTrack audio_track("mid", mock_receiver,
+                                   mock_function.AsStdFunction());
+  int16_t pcm_data[100];
+  absl::Time before_delivery = absl::Now();
+
+  audio_track.OnData(pcm_data,
+                     /*bits_per_sample=*/16,
+                     /*sample_rate=*/48000,
+                     /*number_of_channels=*/1,
+                     /*number_of_frames=*/100,
+                     /*absolute_capture_timestamp_ms=*/987654321);
+
+  ASSERT_TRUE(received_frame.has_value());
+  EXPECT_EQ(received_frame->absolute_capture_timestamp_ms, 987654321);
+  EXPECT_GE(received_frame->receive_time, before_delivery);
+  EXPECT_LE(received_frame->receive_time, absl::Now());
+}
+
+TEST(ConferenceAudioTrackTest, AudioFrameOwnsCopyOfSamples) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  webrtc::RtpSource csrc_rtp_source(
+      webrtc::Timestamp::Micros(1234567890),
+      /*source_id=*/123, webrtc::RtpSourceType::CSRC,
+      /*rtp_timestamp=*/1111111,
+      {.audio_level = 100, .absolute_capture_time = std::nullopt});
+  webrtc::RtpSource ssrc_rtp_source(
+      webrtc::Timestamp::Micros(1234567890),
+      /*source_id=*/456, webrtc::RtpSourceType::SSRC,
+      /*rtp_timestamp=*/2222222,
+      {.audio_level = 100, .absolute_capture_time = std::nullopt});
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillOnce(Return(std::vector<webrtc::RtpSource>{
+          std::move(csrc_rtp_source), std::move(ssrc_rtp_source)}));
+  rtc::scoped_refptr<AudioBufferInterface> received_buffer;
+  absl::Span<const int16_t> received_pcm16;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver,
+      [&received_buffer, &received_pcm16](AudioFrame frame) {
+        received_pcm16 = frame.pcm16;
+        received_buffer = std::move(frame.buffer);
+      });
+  int16_t pcm_data[] = {1, 2, 3, 4};
+
+  audio_track.OnData(pcm_data,
+                     /*bits_per_sample=*/16,
+                     /*sample_rate=*/48000,
+                     /*number_of_channels=*/1,
+                     /*number_of_frames=*/4,
+                     /*absolute_capture_timestamp_ms=*/std::nullopt);
+  // Overwrite the source data to verify that the frame does not reference it.
+  pcm_data[0] = 100;
+
+  ASSERT_NE(received_buffer, nullptr);
+  EXPECT_EQ(received_pcm16.data(), received_buffer->pcm16().data());
+  EXPECT_THAT(received_buffer->pcm16(), ElementsAre(1, 2, 3, 4));
+}
+
 TEST(ConferenceAudioTrackTest, LogsErrorWithUnsupportedBitsPerSample) {
   ConferenceAudioTrack audio_track("mid", nullptr, [](AudioFrame /*frame*/) {});
   ScopedMockLog log(kDoNotCaptureLogsYet);
@@ -301,6 +385,281 @@ TEST(ConferenceAudioTrackTest, LogsErrorWithOnlyLoudestSpeakerCsrc) {
   EXPECT_EQ(message, "AudioFrame is missing CSRC for mid: mid");
 }
 
+TEST(ConferenceAudioTrackTest, AttributesAudioFrameToMostRecentCsrc) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  // The receiver reports sources seen in previous packets too. After a speaker
+  // switch, the previous speaker's CSRC is still reported with an older
+  // receive time.
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillOnce(Return(std::vector<webrtc::RtpSource>{
+          webrtc::RtpSource(
+              webrtc::Timestamp::Micros(2000), /*source_id=*/789,
+              webrtc::RtpSourceType::CSRC, /*rtp_timestamp=*/2222,
+              {.audio_level = 100, .absolute_capture_time = std::nullopt}),
+          webrtc::RtpSource(
+              webrtc::Timestamp::Micros(2000), /*source_id=*/456,
+              webrtc::RtpSourceType::SSRC, /*rtp_timestamp=*/2222,
+              {.audio_level = 100, .absolute_capture_time = std::nullopt}),
+          webrtc::RtpSource(
+              webrtc::Timestamp::Micros(1000), /*source_id=*/123,
+              webrtc::RtpSourceType::CSRC, /*rtp_timestamp=*/1111,
+              {.audio_level = 100, .absolute_capture_time = std::nullopt}),
+          webrtc::RtpSource(
+              webrtc::Timestamp::Micros(1000),
+              /*source_id=*/kLoudestSpeakerCsrc, webrtc::RtpSourceType::CSRC,
+              /*rtp_timestamp=*/1111,
+              {.audio_level = 100, .absolute_capture_time = std::nullopt})}));
+  std::optional<AudioFrame> received_frame;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver, [&received_frame](AudioFrame frame) {
+        received_frame = std::move(frame);
+      });
+  int16_t pcm_data[480];
+
+  audio_track.OnData(pcm_data,
+                     /*bits_per_sample=*/16,
+                     /*sample_rate=*/48000,
+                     /*number_of_channels=*/1,
+                     /*number_of_frames=*/480,
+                     /*absolute_capture_timestamp_ms=*/std::nullopt);
+
+  ASSERT_TRUE(received_frame.has_value());
+  EXPECT_EQ(received_frame->contributing_source, 789);
+  EXPECT_EQ(received_frame->synchronization_source, 456);
+  // The loudest speaker CSRC was received with the previous speaker's CSRC.
+  EXPECT_FALSE(received_frame->is_from_loudest_speaker);
+}
+
+std::vector<webrtc::RtpSource> CreateRtpSources(uint32_t csrc,
+                                                uint32_t ssrc) {
+  return {webrtc::RtpSource(
+              webrtc::Timestamp::Micros(1234567890), csrc,
+              webrtc::RtpSourceType::CSRC, /*rtp_timestamp=*/1111111,
+              {.audio_level = 100, .absolute_capture_time = std::nullopt}),
+          webrtc::RtpSource(
+              webrtc::Timestamp::Micros(1234567890), ssrc,
+              webrtc::RtpSourceType::SSRC, /*rtp_timestamp=*/2222222,
+              {.audio_level = 100, .absolute_capture_time = std::nullopt})};
+}
+
+TEST(ConferenceAudioTrackTest, ReusesSourcesWithinRefreshInterval) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillOnce(Return(CreateRtpSources(/*csrc=*/123, /*ssrc=*/456)));
+  std::vector<uint32_t> received_csrcs;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver,
+      [&received_csrcs](AudioFrame frame) {
+        received_csrcs.push_back(frame.contributing_source);
+      },
+      /*source_refresh_interval=*/absl::Milliseconds(30));
+  int16_t pcm_data[480];
+
+  // Three 10ms frames of audio.
+  for (int i = 0; i < 3; ++i) {
+    audio_track.OnData(pcm_data,
+                       /*bits_per_sample=*/16,
+                       /*sample_rate=*/48000,
+                       /*number_of_channels=*/1,
+                       /*number_of_frames=*/480,
+                       /*absolute_capture_timestamp_ms=*/std::nullopt);
+  }
+
+  EXPECT_THAT(received_csrcs, ElementsAre(123, 123, 123));
+}
+
+TEST(ConferenceAudioTrackTest, EstimatesRtpTimestampsFromSources) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillOnce(Return(CreateRtpSources(/*csrc=*/123, /*ssrc=*/456)));
+  std::vector<uint32_t> received_rtp_timestamps;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver,
+      [&received_rtp_timestamps](AudioFrame frame) {
+        received_rtp_timestamps.push_back(frame.rtp_timestamp);
+      },
+      /*source_refresh_interval=*/absl::Milliseconds(30));
+  int16_t pcm_data[160];
+
+  // Three 10ms frames of 16kHz audio, which advance the 48kHz RTP clock by 480
+  // each.
+  for (int i = 0; i < 3; ++i) {
+    audio_track.OnData(pcm_data,
+                       /*bits_per_sample=*/16,
+                       /*sample_rate=*/16000,
+                       /*number_of_channels=*/1,
+                       /*number_of_frames=*/160,
+                       /*absolute_capture_timestamp_ms=*/std::nullopt);
+  }
+
+  EXPECT_THAT(received_rtp_timestamps,
+              ElementsAre(2222222, 2222222 + 480, 2222222 + 960));
+}
+
+TEST(ConferenceAudioTrackTest, RefreshesSourcesAfterRefreshInterval) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillOnce(Return(CreateRtpSources(/*csrc=*/123, /*ssrc=*/456)))
+      .WillOnce(Return(CreateRtpSources(/*csrc=*/789, /*ssrc=*/456)));
+  std::vector<uint32_t> received_csrcs;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver,
+      [&received_csrcs](AudioFrame frame) {
+        received_csrcs.push_back(frame.contributing_source);
+      },
+      /*source_refresh_interval=*/absl::Milliseconds(20));
+  int16_t pcm_data[480];
+
+  // Three 10ms frames of audio.
+  for (int i = 0; i < 3; ++i) {
+    audio_track.OnData(pcm_data,
+                       /*bits_per_sample=*/16,
+                       /*sample_rate=*/48000,
+                       /*number_of_channels=*/1,
+                       /*number_of_frames=*/480,
+                       /*absolute_capture_timestamp_ms=*/std::nullopt);
+  }
+
+  EXPECT_THAT(received_csrcs, ElementsAre(123, 123, 789));
+}
+
+TEST(ConferenceAudioTrackTest, DoesNotReuseMissingSources) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillOnce(Return(std::vector<webrtc::RtpSource>{}))
+      .WillOnce(Return(CreateRtpSources(/*csrc=*/123, /*ssrc=*/456)));
+  std::vector<uint32_t> received_csrcs;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver,
+      [&received_csrcs](AudioFrame frame) {
+        received_csrcs.push_back(frame.contributing_source);
+      },
+      /*source_refresh_interval=*/absl::Seconds(1));
+  int16_t pcm_data[480];
+
+  // Two 10ms frames of audio. The first is dropped since its sources are
+  // missing.
+  for (int i = 0; i < 2; ++i) {
+    audio_track.OnData(pcm_data,
+                       /*bits_per_sample=*/16,
+                       /*sample_rate=*/48000,
+                       /*number_of_channels=*/1,
+                       /*number_of_frames=*/480,
+                       /*absolute_capture_timestamp_ms=*/std::nullopt);
+  }
+
+  EXPECT_THAT(received_csrcs, ElementsAre(123));
+}
+
+TEST(ConferenceAudioTrackTest, AggregatesAudioWithinAggregationWindow) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillRepeatedly(Return(CreateRtpSources(/*csrc=*/123, /*ssrc=*/456)));
+  std::vector<std::vector<int16_t>> received_samples;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver,
+      [&received_samples](AudioFrame frame) {
+        EXPECT_EQ(frame.number_of_frames, 9);
+        EXPECT_EQ(frame.contributing_source, 123);
+        EXPECT_EQ(frame.absolute_capture_timestamp_ms, 1000);
+        received_samples.emplace_back(frame.buffer->pcm16().begin(),
+                                      frame.buffer->pcm16().end());
+      },
+      kDefaultAudioSourceRefreshInterval,
+      /*aggregation_window=*/absl::Milliseconds(30));
+
+  // Seven 10ms frames of audio at 300Hz, of which the last is still being
+  // aggregated.
+  for (int16_t i = 0; i < 7; ++i) {
+    int16_t pcm_data[3] = {i, i, i};
+    audio_track.OnData(pcm_data,
+                       /*bits_per_sample=*/16,
+                       /*sample_rate=*/300,
+                       /*number_of_channels=*/1,
+                       /*number_of_frames=*/3,
+                       /*absolute_capture_timestamp_ms=*/1000 + i % 3 * 10);
+  }
+
+  EXPECT_THAT(received_samples,
+              ElementsAre(ElementsAre(0, 0, 0, 1, 1, 1, 2, 2, 2),
+                          ElementsAre(3, 3, 3, 4, 4, 4, 5, 5, 5)));
+}
+
+TEST(ConferenceAudioTrackTest, DeliversAggregatedAudioWhenSourcesChange) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillOnce(Return(CreateRtpSources(/*csrc=*/123, /*ssrc=*/456)))
+      .WillRepeatedly(Return(CreateRtpSources(/*csrc=*/789, /*ssrc=*/456)));
+  std::vector<std::pair<uint32_t, size_t>> received_frames;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver,
+      [&received_frames](AudioFrame frame) {
+        received_frames.emplace_back(frame.contributing_source,
+                                     frame.number_of_frames);
+      },
+      /*source_refresh_interval=*/absl::Milliseconds(20),
+      /*aggregation_window=*/absl::Milliseconds(40));
+  int16_t pcm_data[480] = {};
+
+  // Six 10ms frames of audio. The sources change after the second, and the
+  // frames of the second source complete a window.
+  for (int i = 0; i < 6; ++i) {
+    audio_track.OnData(pcm_data,
+                       /*bits_per_sample=*/16,
+                       /*sample_rate=*/48000,
+                       /*number_of_channels=*/1,
+                       /*number_of_frames=*/480,
+                       /*absolute_capture_timestamp_ms=*/std::nullopt);
+  }
+
+  EXPECT_THAT(received_frames, ElementsAre(std::make_pair(123, 960),
+                                           std::make_pair(789, 1920)));
+}
+
+TEST(ConferenceAudioTrackTest, DropsAudioWhilePaused) {
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> mock_receiver(
+      new webrtc::MockRtpReceiver());
+  EXPECT_CALL(*mock_receiver, GetSources)
+      .WillRepeatedly(Return(CreateRtpSources(/*csrc=*/123, /*ssrc=*/456)));
+  std::vector<std::vector<int16_t>> received_samples;
+  ConferenceAudioTrack audio_track(
+      "mid", mock_receiver,
+      [&received_samples](AudioFrame frame) {
+        received_samples.emplace_back(frame.buffer->pcm16().begin(),
+                                      frame.buffer->pcm16().end());
+      },
+      kDefaultAudioSourceRefreshInterval,
+      /*aggregation_window=*/absl::Milliseconds(20));
+  auto on_data = [&audio_track](int16_t sample) {
+    int16_t pcm_data[3] = {sample, sample, sample};
+    audio_track.OnData(pcm_data,
+                       /*bits_per_sample=*/16,
+                       /*sample_rate=*/300,
+                       /*number_of_channels=*/1,
+                       /*number_of_frames=*/3,
+                       /*absolute_capture_timestamp_ms=*/std::nullopt);
+  };
+
+  // The first frame is still being aggregated when the track is paused, so it
+  // is dropped along with the audio received while paused.
+  on_data(0);
+  audio_track.SetPaused(true);
+  on_data(1);
+  on_data(2);
+  audio_track.SetPaused(false);
+  on_data(3);
+  on_data(4);
+
+  EXPECT_THAT(received_samples, ElementsAre(ElementsAre(3, 3, 3, 4, 4, 4)));
+}
+
 TEST(ConferenceVideoTrackTest, CallsObserverWithVideoFrame) {
   MockFunction<void(VideoFrame)> mock_function;
   std::optional<VideoFrame> received_frame;
@@ -329,6 +688,7 @@ TEST(ConferenceVideoTrackTest, CallsObserverWithVideoFrame) {
   EXPECT_EQ(received_frame->frame.size(), 42 * 42);
   EXPECT_EQ(received_frame->contributing_source, 123);
   EXPECT_EQ(received_frame->synchronization_source, 456);
+  EXPECT_NE(received_frame->receive_time, absl::InfinitePast());
 }
 
 TEST(ConferenceVideoTrackTest, LogsErrorWithMissingPackingInfos) {
@@ -369,5 +729,100 @@ TEST(ConferenceVideoTrackTest, LogsErrorWithMissingPacketCsrcs) {
   EXPECT_EQ(message, "VideoFrame is missing CSRC for mid: mid");
 }
 
+webrtc::VideoFrame CreateVideoFrame(int width, int height,
+                                    int64_t timestamp_us) {
+  webrtc::RtpPacketInfo packet_info;
+  packet_info.set_csrcs({123});
+  packet_info.set_ssrc(456);
+  return webrtc::VideoFrame::Builder()
+      .set_packet_infos(webrtc::RtpPacketInfos({packet_info}))
+      .set_video_frame_buffer(webrtc::I420Buffer::Create(width, height))
+      .set_timestamp_us(timestamp_us)
+      .build();
+}
+
+TEST(ConferenceVideoTrackTest, DropsFramesAboveMaxFramerate) {
+  std::vector<int64_t> received_timestamps_us;
+  ConferenceVideoTrack video_track(
+      "mid", [&received_timestamps_us](VideoFrame frame) {
+        received_timestamps_us.push_back(frame.frame.timestamp_us());
+      });
+  video_track.SetConstraints({.max_framerate_fps = 15});
+
+  // Deliver 30fps video with slightly jittered render times.
+  for (int64_t timestamp_us :
+       {0, 33'333, 66'000, 100'000, 133'333, 167'000, 200'000}) {
+    video_track.OnFrame(CreateVideoFrame(42, 42, timestamp_us));
+  }
+
+  EXPECT_THAT(received_timestamps_us, ElementsAre(0, 66'000, 133'333, 200'000));
+}
+
+TEST(ConferenceVideoTrackTest, DownscalesFramesAboveMaxPixelCount) {
+  std::vector<std::pair<int, int>> received_dimensions;
+  ConferenceVideoTrack video_track(
+      "mid", [&received_dimensions](VideoFrame frame) {
+        received_dimensions.emplace_back(frame.frame.width(),
+                                         frame.frame.height());
+        EXPECT_EQ(frame.contributing_source, 123);
+        EXPECT_EQ(frame.synchronization_source, 456);
+      });
+  video_track.SetConstraints({.max_pixel_count = 320 * 180});
+
+  video_track.OnFrame(CreateVideoFrame(1280, 720, 0));
+  video_track.OnFrame(CreateVideoFrame(320, 180, 1'000'000));
+
+  EXPECT_THAT(received_dimensions,
+              ElementsAre(std::make_pair(320, 180), std::make_pair(320, 180)));
+}
+
+TEST(ConferenceVideoTrackTest, DeliversEveryFrameAfterConstraintsAreCleared) {
+  int received_frames = 0;
+  ConferenceVideoTrack video_track(
+      "mid", [&received_frames](VideoFrame /*frame*/) { ++received_frames; });
+  video_track.SetConstraints({.max_framerate_fps = 1});
+  video_track.OnFrame(CreateVideoFrame(42, 42, 0));
+  video_track.OnFrame(CreateVideoFrame(42, 42, 33'333));
+
+  video_track.SetConstraints({});
+  video_track.OnFrame(CreateVideoFrame(42, 42, 66'666));
+
+  EXPECT_EQ(received_frames, 2);
+}
+
+// Sink with a concrete type, as used to deliver frames without type erasure.
+struct CountingVideoSink {
+  void operator()(VideoFrame frame) {
+    received_dimensions->emplace_back(frame.frame.width(),
+                                      frame.frame.height());
+  }
+
+  std::vector<std::pair<int, int>>* received_dimensions;
+};
+
+TEST(ConferenceVideoTrackTest, DeliversFramesToSinkOfConcreteType) {
+  std::vector<std::pair<int, int>> received_dimensions;
+  BasicConferenceVideoTrack<CountingVideoSink> video_track(
+      "mid", CountingVideoSink{.received_dimensions = &received_dimensions});
+  video_track.SetConstraints({.max_pixel_count = 320 * 180});
+
+  video_track.OnFrame(CreateVideoFrame(1280, 720, 0));
+  video_track.OnFrame(CreateVideoFrame(160, 90, 1'000'000));
+
+  EXPECT_THAT(received_dimensions,
+              ElementsAre(std::make_pair(320, 180), std::make_pair(160, 90)));
+}
+
+TEST(ValidateVideoSinkConstraintsTest, RejectsNonPositiveLimits) {
+  EXPECT_TRUE(ValidateVideoSinkConstraints({}).ok());
+  EXPECT_TRUE(ValidateVideoSinkConstraints(
+                  {.max_pixel_count = 1, .max_framerate_fps = 1})
+                  .ok());
+  EXPECT_EQ(ValidateVideoSinkConstraints({.max_pixel_count = 0}).message(),
+            "Video sink max pixel count must be positive; got 0");
+  EXPECT_EQ(ValidateVideoSinkConstraints({.max_framerate_fps = -1}).message(),
+            "Video sink max framerate must be positive; got -1");
+}
+
 }  // namespace
 }  // namespace meet
@@ -16,15 +16,20 @@
 
 #include "cpp/internal/conference_peer_connection.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
+#include "absl/functional/any_invocable.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "nlohmann/json.hpp"
 #include "webrtc/api/jsep.h"
@@ -35,6 +40,9 @@
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/set_local_description_observer_interface.h"
 #include "webrtc/api/set_remote_description_observer_interface.h"
+#include "webrtc/api/task_queue/pending_task_safety_flag.h"
+#include "webrtc/pc/session_description.h"
+#include "webrtc/rtc_base/time_utils.h"
 
 namespace meet {
 namespace {
@@ -45,68 +53,121 @@ using Json = ::nlohmann::json;
 class SetLocalDescriptionObserver
     : public webrtc::SetLocalDescriptionObserverInterface {
  public:
-  explicit SetLocalDescriptionObserver(
-      webrtc::PeerConnectionInterface &peer_connection)
-      : peer_connection_(peer_connection) {}
+  using Callback = absl::AnyInvocable<void(absl::StatusOr<std::string>) &&>;
+
+  SetLocalDescriptionObserver(webrtc::PeerConnectionInterface &peer_connection,
+                              Callback callback)
+      : peer_connection_(peer_connection), callback_(std::move(callback)) {}
+
   void OnSetLocalDescriptionComplete(webrtc::RTCError error) override {
-    if (error.ok()) {
-      const webrtc::SessionDescriptionInterface *desc =
-          peer_connection_.local_description();
-      std::string local_description;
-      // Note that this callback is called on the signaling thread, so
-      // dereferencing the local description here is safe.
-      desc->ToString(&local_description);
-      local_description_ = std::move(local_description);
-    } else {
-      local_description_ = absl::InternalError(
-          absl::StrCat("Error setting local description: ", error.message()));
+    if (!error.ok()) {
+      std::move(callback_)(absl::InternalError(
+          absl::StrCat("Error setting local description: ", error.message())));
+      return;
     }
-    notification_.Notify();
+    const webrtc::SessionDescriptionInterface *desc =
+        peer_connection_.local_description();
+    std::string local_description;
+    // Note that this callback is called on the signaling thread, so
+    // dereferencing the local description here is safe.
+    desc->ToString(&local_description);
+    std::move(callback_)(std::move(local_description));
   };
 
-  absl::StatusOr<std::string> GetLocalDescription() {
-    notification_.WaitForNotification();
-    return local_description_;
-  }
-
  private:
   webrtc::PeerConnectionInterface &peer_connection_;
-  absl::Notification notification_;
-  absl::StatusOr<std::string> local_description_ =
-      absl::InternalError("Local description not set.");
+  Callback callback_;
 };
 
 // Lambda-based implementation of `SetRemoteDescriptionObserverInterface`.
 class SetRemoteDescriptionObserver
     : public webrtc::SetRemoteDescriptionObserverInterface {
  public:
+  using Callback = absl::AnyInvocable<void(absl::Status) &&>;
+
+  explicit SetRemoteDescriptionObserver(Callback callback)
+      : callback_(std::move(callback)) {}
+
   void OnSetRemoteDescriptionComplete(webrtc::RTCError error) override {
-    if (error.ok()) {
-      remote_description_status_ = absl::OkStatus();
-    } else {
-      remote_description_status_ = absl::InternalError(
-          absl::StrCat("Error setting remote description: ", error.message()));
+    if (!error.ok()) {
+      std::move(callback_)(absl::InternalError(
+          absl::StrCat("Error setting remote description: ", error.message())));
+      return;
     }
-    notification_.Notify();
+    std::move(callback_)(absl::OkStatus());
   };
 
-  absl::Status GetRemoteDescription() {
-    notification_.WaitForNotification();
-    return remote_description_status_;
-  }
-
  private:
-  absl::Notification notification_;
-  absl::Status remote_description_status_ =
-      absl::InternalError("Remote description not set.");
+  Callback callback_;
 };
 
+// Returns whether `answer` negotiates the same media lines as `current`, in the
+// same order and with the same media types. This includes the SCTP section
+// carrying the data channels.
+bool RenegotiatesSession(const webrtc::SessionDescriptionInterface &current,
+                         const webrtc::SessionDescriptionInterface &answer) {
+  const cricket::ContentInfos &current_contents =
+      current.description()->contents();
+  const cricket::ContentInfos &answer_contents =
+      answer.description()->contents();
+  if (current_contents.size() != answer_contents.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < current_contents.size(); ++i) {
+    if (current_contents[i].mid() != answer_contents[i].mid() ||
+        current_contents[i].media_description()->type() !=
+            answer_contents[i].media_description()->type()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
+void ConferencePeerConnection::RecordTimestamp(
+    std::optional<int64_t> ConnectTimestamps::*step, int64_t time_us) {
+  absl::MutexLock lock(&timestamps_mutex_);
+  std::optional<int64_t>& timestamp = connect_timestamps_.*step;
+  if (!timestamp.has_value()) {
+    timestamp = time_us;
+  }
+}
+
+void ConferencePeerConnection::OnIceGatheringChange(
+    webrtc::PeerConnectionInterface::IceGatheringState new_state) {
+  VLOG(1) << "OnIceGatheringChange: " << new_state;
+  if (new_state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+    RecordTimestamp(&ConnectTimestamps::ice_gathering_complete_us,
+                    rtc::TimeMicros());
+  }
+}
+
+void ConferencePeerConnection::OnIceCandidate(
+    const webrtc::IceCandidateInterface* candidate) {
+  VLOG(1) << "OnIceCandidate: " << candidate->sdp_mline_index();
+  // Server reflexive candidates are the ones gathered from the STUN server.
+  if (candidate->candidate().is_stun()) {
+    RecordTimestamp(&ConnectTimestamps::stun_candidate_gathered_us,
+                    rtc::TimeMicros());
+  }
+}
+
 void ConferencePeerConnection::OnConnectionChange(
     webrtc::PeerConnectionInterface::PeerConnectionState new_state) {
   VLOG(1) << "OnSignalingChange: "
           << webrtc::PeerConnectionInterface::AsString(new_state);
+  if (new_state ==
+      webrtc::PeerConnectionInterface::PeerConnectionState::kConnected) {
+    RecordTimestamp(&ConnectTimestamps::peer_connection_connected_us,
+                    rtc::TimeMicros());
+    return;
+  }
+  if (new_state ==
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed) {
+    MaybeRestartIce();
+    return;
+  }
   if (new_state !=
       webrtc::PeerConnectionInterface::PeerConnectionState::kClosed) {
     return;
@@ -120,6 +181,102 @@ void ConferencePeerConnection::OnConnectionChange(
   disconnect_callback_(absl::InternalError("Peer connection closed."));
 }
 
+void ConferencePeerConnection::NotifyDisconnected(absl::Status status) {
+  if (disconnect_callback_ == nullptr) {
+    LOG(WARNING) << "PeerConnection disconnected without disconnect callback: "
+                 << status;
+    return;
+  }
+  disconnect_callback_(std::move(status));
+}
+
+void ConferencePeerConnection::MaybeRestartIce() {
+  // Connections that fail while joining are reported by the `Connect`
+  // callback instead, and failures during a restart are handled by the
+  // restart itself.
+  if (max_ice_restarts_ == 0 || !connected_ || ice_restart_in_progress_) {
+    return;
+  }
+  if (ice_restart_count_ >= max_ice_restarts_) {
+    NotifyDisconnected(absl::UnavailableError(absl::StrCat(
+        "Peer connection failed after ", ice_restart_count_,
+        " ICE restarts.")));
+    return;
+  }
+
+  ++ice_restart_count_;
+  ice_restart_in_progress_ = true;
+  ice_restarts_.Increment();
+  LOG(INFO) << "Peer connection failed; restarting ICE (attempt "
+            << ice_restart_count_ << " of " << max_ice_restarts_ << ").";
+
+  int64_t restart_start_us = rtc::TimeMicros();
+  ConnectCallback on_complete = [this, restart_start_us](absl::Status status) {
+    ice_restart_in_progress_ = false;
+    if (status.ok()) {
+      ice_restart_latency_us_.Record(rtc::TimeMicros() - restart_start_us);
+    } else {
+      LOG(WARNING) << "ICE restart failed: " << status;
+      NotifyDisconnected(std::move(status));
+    }
+  };
+
+  // Restarting ICE makes the next offer carry new ICE credentials, so the
+  // cached `local_description_` is bypassed.
+  peer_connection_->RestartIce();
+  peer_connection_->SetLocalDescription(
+      webrtc::make_ref_counted<SetLocalDescriptionObserver>(
+          *peer_connection_,
+          BindToSignalingThread<absl::StatusOr<std::string>>(
+              [this, on_complete = std::move(on_complete)](
+                  absl::StatusOr<std::string> local_description) mutable {
+                if (!local_description.ok()) {
+                  std::move(on_complete)(local_description.status());
+                  return;
+                }
+                RefreshAccessToken(
+                    [this, on_complete = std::move(on_complete),
+                     offer = *std::move(local_description)](
+                        absl::Status status) mutable {
+                      if (!status.ok()) {
+                        std::move(on_complete)(std::move(status));
+                        return;
+                      }
+                      http_connector_->ConnectActiveConferenceAsync(
+                          join_endpoint_, conference_id_, access_token_, offer,
+                          BindToSignalingThread<absl::StatusOr<std::string>>(
+                              [this, on_complete = std::move(on_complete)](
+                                  absl::StatusOr<std::string>
+                                      remote_description) mutable {
+                                SetRemoteDescription(
+                                    std::move(remote_description),
+                                    std::move(on_complete),
+                                    /*restarting_ice=*/true);
+                              }));
+                    });
+              })));
+}
+
+void ConferencePeerConnection::RefreshAccessToken(
+    absl::AnyInvocable<void(absl::Status) &&> callback) {
+  if (access_token_provider_ == nullptr) {
+    std::move(callback)(absl::OkStatus());
+    return;
+  }
+  access_token_provider_(BindToSignalingThread<absl::StatusOr<std::string>>(
+      [this, callback = std::move(callback)](
+          absl::StatusOr<std::string> access_token) mutable {
+        if (!access_token.ok()) {
+          std::move(callback)(absl::UnauthenticatedError(
+              absl::StrCat("Failed to refresh access token: ",
+                           access_token.status().message())));
+          return;
+        }
+        access_token_ = *std::move(access_token);
+        std::move(callback)(absl::OkStatus());
+      }));
+}
+
 void ConferencePeerConnection::OnTrack(
     rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver) {
   if (track_signaled_callback_ == nullptr) {
@@ -130,46 +287,146 @@ void ConferencePeerConnection::OnTrack(
   track_signaled_callback_(std::move(transceiver));
 }
 
-absl::Status ConferencePeerConnection::Connect(absl::string_view join_endpoint,
-                                               absl::string_view conference_id,
-                                               absl::string_view access_token) {
+absl::Status ConferencePeerConnection::PrepareLocalDescription() {
+  absl::Notification done;
+  absl::Status result;
+  SetLocalDescription([&done, &result](absl::Status status) {
+    result = std::move(status);
+    done.Notify();
+  });
+  done.WaitForNotification();
+  return result;
+}
+
+void ConferencePeerConnection::SetLocalDescription(
+    absl::AnyInvocable<void(absl::Status) &&> callback) {
   if (peer_connection_ == nullptr) {
-    return absl::InternalError("Peer connection is null.");
+    std::move(callback)(absl::InternalError("Peer connection is null."));
+    return;
   }
-
-  auto local_description_observer =
-      webrtc::make_ref_counted<SetLocalDescriptionObserver>(*peer_connection_);
-  peer_connection_->SetLocalDescription(local_description_observer);
-  absl::StatusOr<std::string> local_description =
-      local_description_observer->GetLocalDescription();
-  if (!local_description.ok()) {
-    return local_description.status();
+  if (local_description_.has_value()) {
+    std::move(callback)(absl::OkStatus());
+    return;
   }
 
-  absl::StatusOr<std::string> remote_description =
-      http_connector_->ConnectActiveConference(join_endpoint, conference_id,
-                                               access_token,
-                                               local_description.value());
+  peer_connection_->SetLocalDescription(
+      webrtc::make_ref_counted<SetLocalDescriptionObserver>(
+          *peer_connection_,
+          BindToSignalingThread<absl::StatusOr<std::string>>(
+              [this, callback = std::move(callback)](
+                  absl::StatusOr<std::string> local_description) mutable {
+                if (!local_description.ok()) {
+                  std::move(callback)(local_description.status());
+                  return;
+                }
+                local_description_ = *std::move(local_description);
+                RecordTimestamp(&ConnectTimestamps::local_description_set_us,
+                                rtc::TimeMicros());
+                std::move(callback)(absl::OkStatus());
+              })));
+}
+
+void ConferencePeerConnection::SetRemoteDescription(
+    absl::StatusOr<std::string> remote_description, ConnectCallback callback,
+    bool restarting_ice) {
   if (!remote_description.ok()) {
-    return remote_description.status();
+    std::move(callback)(remote_description.status());
+    return;
   }
 
   webrtc::SdpParseError sdp_parse_error;
   std::unique_ptr<webrtc::SessionDescriptionInterface> answer_desc =
       webrtc::CreateSessionDescription(webrtc::SdpType::kAnswer,
-                                       std::move(remote_description).value(),
+                                       *std::move(remote_description),
                                        &sdp_parse_error);
   if (answer_desc == nullptr) {
-    return absl::InternalError(absl::StrCat("Failed to parse answer SDP: ",
-                                            sdp_parse_error.description));
-  }
-  auto remote_description_observer =
-      webrtc::make_ref_counted<SetRemoteDescriptionObserver>();
-  peer_connection_->SetRemoteDescription(std::move(answer_desc),
-                                         remote_description_observer);
-  absl::Status remote_description_result =
-      remote_description_observer->GetRemoteDescription();
-  return remote_description_result;
+    std::move(callback)(absl::InternalError(absl::StrCat(
+        "Failed to parse answer SDP: ", sdp_parse_error.description)));
+    return;
+  }
+  // The restart offer is sent to the join endpoint, which may answer with a
+  // new session rather than renegotiating the existing one. Applying such an
+  // answer would silently replace the tracks and data channels, so the client
+  // disconnects and leaves rejoining to the caller instead.
+  if (restarting_ice) {
+    const webrtc::SessionDescriptionInterface *current_desc =
+        peer_connection_->remote_description();
+    if (current_desc == nullptr ||
+        !RenegotiatesSession(*current_desc, *answer_desc)) {
+      std::move(callback)(absl::FailedPreconditionError(
+          "ICE restart answer does not renegotiate the existing session."));
+      return;
+    }
+  }
+  peer_connection_->SetRemoteDescription(
+      std::move(answer_desc),
+      webrtc::make_ref_counted<SetRemoteDescriptionObserver>(
+          BindToSignalingThread<absl::Status>(std::move(callback))));
+}
+
+void ConferencePeerConnection::Connect(absl::string_view join_endpoint,
+                                       absl::string_view conference_id,
+                                       absl::string_view access_token,
+                                       ConnectCallback callback) {
+  join_endpoint_ = std::string(join_endpoint);
+  conference_id_ = std::string(conference_id);
+  access_token_ = std::string(access_token);
+  ConnectCallback on_complete = [this, callback = std::move(callback)](
+                                    absl::Status status) mutable {
+    connected_ = status.ok();
+    std::move(callback)(std::move(status));
+  };
+
+  // Every step of the chain runs on the signaling thread and is dropped once
+  // this object is destroyed, so destruction never waits for the chain.
+  int64_t connect_start_us = rtc::TimeMicros();
+  signaling_thread_->PostTask(SafeTask(
+      safety_flag_, [this, on_complete = std::move(on_complete),
+                     connect_start_us]() mutable {
+        SetLocalDescription([this, on_complete = std::move(on_complete),
+                             connect_start_us](absl::Status status) mutable {
+          if (!status.ok()) {
+            std::move(on_complete)(std::move(status));
+            return;
+          }
+          int64_t http_start_us = rtc::TimeMicros();
+          local_description_latency_us_.Record(http_start_us -
+                                               connect_start_us);
+          http_connector_->ConnectActiveConferenceAsync(
+              join_endpoint_, conference_id_, access_token_,
+              *local_description_,
+              BindToSignalingThread<absl::StatusOr<std::string>>(
+                  [this, on_complete = std::move(on_complete),
+                   connect_start_us, http_start_us](
+                      absl::StatusOr<std::string> remote_description) mutable {
+                    int64_t remote_description_start_us = rtc::TimeMicros();
+                    if (remote_description.ok()) {
+                      http_latency_us_.Record(remote_description_start_us -
+                                              http_start_us);
+                      RecordTimestamp(
+                          &ConnectTimestamps::join_response_received_us,
+                          remote_description_start_us);
+                    }
+                    SetRemoteDescription(
+                        std::move(remote_description),
+                        [this, on_complete = std::move(on_complete),
+                         connect_start_us, remote_description_start_us](
+                            absl::Status status) mutable {
+                          if (status.ok()) {
+                            int64_t connect_end_us = rtc::TimeMicros();
+                            RecordTimestamp(
+                                &ConnectTimestamps::remote_description_set_us,
+                                connect_end_us);
+                            remote_description_latency_us_.Record(
+                                connect_end_us - remote_description_start_us);
+                            join_latency_us_.Record(connect_end_us -
+                                                    connect_start_us);
+                          }
+                          std::move(on_complete)(std::move(status));
+                        });
+                  }));
+        });
+      }));
 }
 
 }  // namespace meet
@@ -17,18 +17,25 @@
 #ifndef CPP_INTERNAL_CONFERENCE_PEER_CONNECTION_H_
 #define CPP_INTERNAL_CONFERENCE_PEER_CONNECTION_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "cpp/internal/conference_media_tracks.h"
 #include "cpp/internal/conference_peer_connection_interface.h"
 #include "cpp/internal/http_connector_interface.h"
+#include "cpp/internal/metrics_registry.h"
 #include "webrtc/api/data_channel_interface.h"
 #include "webrtc/api/jsep.h"
 #include "webrtc/api/media_stream_interface.h"
@@ -37,6 +44,8 @@
 #include "webrtc/api/rtp_transceiver_interface.h"
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/stats/rtc_stats_collector_callback.h"
+#include "webrtc/api/task_queue/pending_task_safety_flag.h"
+#include "webrtc/rtc_base/thread.h"
 
 namespace meet {
 
@@ -49,16 +58,62 @@ namespace meet {
 class ConferencePeerConnection : public ConferencePeerConnectionInterface,
                                  public webrtc::PeerConnectionObserver {
  public:
+  // Fetches an access token and invokes the given callback with it, possibly
+  // on another thread.
+  using AccessTokenProvider = absl::AnyInvocable<void(
+      absl::AnyInvocable<void(absl::StatusOr<std::string>) &&>)>;
+
+  // The durations of the phases of `Connect` are recorded in `metrics`, if
+  // provided.
+  //
+  // If the connection fails after `Connect` succeeds, up to
+  // `max_ice_restarts` ICE restarts are attempted before the disconnect
+  // callback is invoked.
   ConferencePeerConnection(
       std::unique_ptr<rtc::Thread> signaling_thread,
-      std::unique_ptr<HttpConnectorInterface> http_connector)
-      : signaling_thread_(std::move(signaling_thread)),
-        http_connector_(std::move(http_connector)) {};
+      std::unique_ptr<HttpConnectorInterface> http_connector,
+      std::shared_ptr<MetricsRegistry> metrics = nullptr,
+      uint32_t max_ice_restarts = 0)
+      : ConferencePeerConnection(signaling_thread.get(),
+                                 std::move(http_connector), std::move(metrics),
+                                 max_ice_restarts) {
+    owned_signaling_thread_ = std::move(signaling_thread);
+  }
+
+  // Uses a signaling thread owned elsewhere, such as by a shared peer
+  // connection context. `signaling_thread` must outlive this object.
+  ConferencePeerConnection(
+      rtc::Thread* signaling_thread,
+      std::unique_ptr<HttpConnectorInterface> http_connector,
+      std::shared_ptr<MetricsRegistry> metrics = nullptr,
+      uint32_t max_ice_restarts = 0)
+      : max_ice_restarts_(max_ice_restarts),
+        signaling_thread_(signaling_thread),
+        http_connector_(std::move(http_connector)),
+        metrics_(metrics != nullptr ? std::move(metrics)
+                                    : std::make_shared<MetricsRegistry>()),
+        local_description_latency_us_(metrics_->GetHistogram(
+            "meet_join_local_description_latency_us", kLatencyBucketsUs)),
+        http_latency_us_(metrics_->GetHistogram("meet_join_http_latency_us",
+                                                kLatencyBucketsUs)),
+        remote_description_latency_us_(metrics_->GetHistogram(
+            "meet_join_remote_description_latency_us", kLatencyBucketsUs)),
+        join_latency_us_(
+            metrics_->GetHistogram("meet_join_latency_us", kLatencyBucketsUs)),
+        ice_restarts_(metrics_->GetCounter("meet_ice_restarts")),
+        ice_restart_latency_us_(metrics_->GetHistogram(
+            "meet_ice_restart_latency_us", kLatencyBucketsUs)) {
+    safety_flag_ = webrtc::PendingTaskSafetyFlag::CreateAttachedToTaskQueue(
+        /*alive=*/true, signaling_thread_);
+  };
 
   ~ConferencePeerConnection() override {
     VLOG(1) << "ConferencePeerConnection::~ConferencePeerConnection called.";
 
     Close();
+    // Steps of an in-flight connection attempt or ICE restart run as tasks on
+    // the signaling thread, so they are cancelled rather than waited for.
+    signaling_thread_->BlockingCall([this]() { safety_flag_->SetNotAlive(); });
   }
 
   void OnSignalingChange(
@@ -105,13 +160,9 @@ class ConferencePeerConnection : public ConferencePeerConnectionInterface,
   }
 
   void OnIceGatheringChange(
-      webrtc::PeerConnectionInterface::IceGatheringState new_state) override {
-    VLOG(1) << "OnIceGatheringChange: " << new_state;
-  };
+      webrtc::PeerConnectionInterface::IceGatheringState new_state) override;
 
-  void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override {
-    VLOG(1) << "OnIceCandidate: " << candidate->sdp_mline_index();
-  };
+  void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override;
 
   void OnIceCandidateError(const std::string& /* address */, int /* port */,
                            const std::string& /* url */, int /* error_code */,
@@ -172,7 +223,8 @@ class ConferencePeerConnection : public ConferencePeerConnectionInterface,
   // time, and the track signaled callback must outlive the conference peer
   // connection if one is set.
   //
-  // Tracks will be signaled during the `Connect` call, before it returns.
+  // Tracks will be signaled while connecting, before the `Connect` callback is
+  // invoked.
   //
   // Calling this is not thread-safe, so it should only be called before the
   // conference peer connection is used.
@@ -181,15 +233,39 @@ class ConferencePeerConnection : public ConferencePeerConnectionInterface,
     track_signaled_callback_ = std::move(track_signaled_callback);
   }
 
-  // Connects to the conference with the given arguments and blocks until the
-  // peer connection connects or fails to connect.
+  // Sets the provider of the access tokens sent with ICE restart offers. If
+  // none is set, ICE restarts reuse the access token passed to `Connect`.
   //
-  // Note that `disconnected_callback_` will not be called if this method
-  // returns an error; `disconnected_callback_` will only be called if the
-  // connection is disconnected after this method returns OK.
-  absl::Status Connect(absl::string_view join_endpoint,
-                       absl::string_view conference_id,
-                       absl::string_view access_token) override;
+  // Calling this is not thread-safe, so it should only be called before the
+  // conference peer connection is used.
+  void SetAccessTokenProvider(AccessTokenProvider access_token_provider) {
+    access_token_provider_ = std::move(access_token_provider);
+  }
+
+  // Connects to the conference with the given arguments without blocking.
+  //
+  // Connecting is a chain of asynchronous steps: setting the local description
+  // on the signaling thread, sending the offer with `http_connector_`, and
+  // setting the remote description on the signaling thread. `callback` is
+  // invoked with the result of the chain on the signaling thread, unless this
+  // object is destroyed first.
+  //
+  // Note that `disconnected_callback_` will not be called if `callback`
+  // receives an error; `disconnected_callback_` will only be called if the
+  // connection is disconnected after `callback` receives OK.
+  //
+  // May be called at most once.
+  void Connect(absl::string_view join_endpoint,
+               absl::string_view conference_id, absl::string_view access_token,
+               ConnectCallback callback) override;
+
+  // Sets the local description and blocks until the offer is generated.
+  //
+  // `Connect` sets the local description if this has not already been called,
+  // so calling it ahead of time only moves the cost of generating the offer out
+  // of `Connect`. Not thread-safe; must be called before `Connect`, and never
+  // on the signaling thread.
+  absl::Status PrepareLocalDescription();
 
   void Close() override {
     VLOG(1) << "ConferencePeerConnection::Close called.";
@@ -213,6 +289,11 @@ class ConferencePeerConnection : public ConferencePeerConnectionInterface,
     peer_connection_->GetStats(callback);
   }
 
+  ConnectTimestamps GetConnectTimestamps() const override {
+    absl::MutexLock lock(&timestamps_mutex_);
+    return connect_timestamps_;
+  }
+
   // Sets the underlying peer connection that this class wraps.
   //
   // Calling this is not thread-safe, so it should only be called before the
@@ -223,15 +304,100 @@ class ConferencePeerConnection : public ConferencePeerConnectionInterface,
   }
 
  private:
+  // Sets the local description if it has not been set yet, and invokes
+  // `callback` once `local_description_` is populated or an error occurs.
+  void SetLocalDescription(absl::AnyInvocable<void(absl::Status) &&> callback);
+
+  // Parses and applies the answer received from Meet servers, and invokes
+  // `callback` once the remote description is set or an error occurs.
+  //
+  // When `restarting_ice`, answers that do not renegotiate the media lines of
+  // the current remote description are rejected.
+  void SetRemoteDescription(absl::StatusOr<std::string> remote_description,
+                            ConnectCallback callback,
+                            bool restarting_ice = false);
+
+  // Restarts ICE after the connection fails, renegotiating with Meet servers
+  // using the arguments of `Connect` and a fresh access token from
+  // `access_token_provider_`, if set. Tracks and data channels are kept, so the
+  // session resumes without rejoining. Invokes the disconnect callback if no
+  // restarts remain, the renegotiation fails, or Meet servers answer with a
+  // new session rather than renegotiating the existing one.
+  //
+  // Must be called on the signaling thread.
+  void MaybeRestartIce();
+
+  // Replaces `access_token_` with one from `access_token_provider_`, if set,
+  // and invokes `callback` on the signaling thread once done.
+  void RefreshAccessToken(absl::AnyInvocable<void(absl::Status) &&> callback);
+
+  // Returns a callback that invokes `callback` on the signaling thread, unless
+  // this object is destroyed first. The returned callback does not reference
+  // this object, so it may safely outlive it.
+  template <typename T>
+  absl::AnyInvocable<void(T) &&> BindToSignalingThread(
+      absl::AnyInvocable<void(T) &&> callback) {
+    return [signaling_thread = signaling_thread_, safety_flag = safety_flag_,
+            callback = std::move(callback)](T result) mutable {
+      signaling_thread->PostTask(SafeTask(
+          std::move(safety_flag), [callback = std::move(callback),
+                                   result = std::move(result)]() mutable {
+            std::move(callback)(std::move(result));
+          }));
+    };
+  }
+
+  // Invokes the disconnect callback with `status`, if one is set.
+  void NotifyDisconnected(absl::Status status);
+
+  // Records `time_us` as the completion time of a connection step, unless the
+  // step has already completed.
+  void RecordTimestamp(std::optional<int64_t> ConnectTimestamps::*step,
+                       int64_t time_us);
+
   // Media tracks created while the peer connection's remote description is
-  // being set. This will be null after `Connect` returns.
+  // being set. This will be null after the `Connect` callback is invoked.
   std::vector<ConferenceMediaTrack> media_tracks_;
-
+  // The offer generated by `PrepareLocalDescription`, sent when connecting.
+  std::optional<std::string> local_description_;
+  // Arguments of `Connect`, reused when renegotiating after an ICE restart.
+  // `access_token_` is replaced whenever a fresh token is fetched.
+  std::string join_endpoint_;
+  std::string conference_id_;
+  std::string access_token_;
+  // Whether the `Connect` callback received OK. ICE is only restarted for
+  // connections that were established.
+  std::atomic<bool> connected_ = false;
+
+  // Only one ICE restart is in flight at a time.
+  const uint32_t max_ice_restarts_;
+  uint32_t ice_restart_count_ = 0;
+  std::atomic<bool> ice_restart_in_progress_ = false;
+
+  AccessTokenProvider access_token_provider_;
   DisconnectCallback disconnect_callback_;
   TrackSignaledCallback track_signaled_callback_;
-  std::unique_ptr<rtc::Thread> signaling_thread_;
+  // Null if the signaling thread is owned elsewhere. Declared before
+  // `http_connector_` so that the thread outlives responses delivered while
+  // the connector is destroyed.
+  std::unique_ptr<rtc::Thread> owned_signaling_thread_;
+  rtc::Thread* const signaling_thread_;
+  // Guards every step of `Connect` and ICE restarts.
+  rtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> safety_flag_;
   std::unique_ptr<HttpConnectorInterface> http_connector_;
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_connection_;
+  // Durations of successful `Connect` phases.
+  std::shared_ptr<MetricsRegistry> metrics_;
+  Histogram& local_description_latency_us_;
+  Histogram& http_latency_us_;
+  Histogram& remote_description_latency_us_;
+  Histogram& join_latency_us_;
+  Counter& ice_restarts_;
+  Histogram& ice_restart_latency_us_;
+  // Steps are completed on the signaling and network threads and read from the
+  // client thread.
+  mutable absl::Mutex timestamps_mutex_;
+  ConnectTimestamps connect_timestamps_ ABSL_GUARDED_BY(timestamps_mutex_);
 };
 
 }  // namespace meet
@@ -17,6 +17,9 @@
 #ifndef CPP_INTERNAL_CONFERENCE_PEER_CONNECTION_INTERFACE_H_
 #define CPP_INTERNAL_CONFERENCE_PEER_CONNECTION_INTERFACE_H_
 
+#include <cstdint>
+#include <optional>
+
 #include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
@@ -32,6 +35,18 @@ class ConferencePeerConnectionInterface {
   using DisconnectCallback = absl::AnyInvocable<void(absl::Status)>;
   using TrackSignaledCallback = absl::AnyInvocable<void(
       rtc::scoped_refptr<webrtc::RtpTransceiverInterface>)>;
+  using ConnectCallback = absl::AnyInvocable<void(absl::Status) &&>;
+
+  // Times at which the steps of connecting completed, as returned by
+  // `rtc::TimeMicros()`. Steps that have not completed are unset.
+  struct ConnectTimestamps {
+    std::optional<int64_t> local_description_set_us;
+    std::optional<int64_t> join_response_received_us;
+    std::optional<int64_t> remote_description_set_us;
+    std::optional<int64_t> stun_candidate_gathered_us;
+    std::optional<int64_t> ice_gathering_complete_us;
+    std::optional<int64_t> peer_connection_connected_us;
+  };
 
   virtual ~ConferencePeerConnectionInterface() = default;
 
@@ -41,15 +56,25 @@ class ConferencePeerConnectionInterface {
   virtual void SetTrackSignaledCallback(
       TrackSignaledCallback track_signaled_callback) = 0;
 
-  // Connects to the conference with the given arguments and blocks until the
-  // conference peer connection connects or fails to connect.
-  virtual absl::Status Connect(absl::string_view join_endpoint,
-                               absl::string_view conference_id,
-                               absl::string_view access_token) = 0;
+  // Starts connecting to the conference with the given arguments without
+  // blocking the calling thread.
+  //
+  // `callback` is invoked exactly once, when the conference peer connection
+  // connects or fails to connect. It may be invoked on any thread, including
+  // the calling thread before `Connect` returns.
+  virtual void Connect(absl::string_view join_endpoint,
+                       absl::string_view conference_id,
+                       absl::string_view access_token,
+                       ConnectCallback callback) = 0;
 
   // Closes the conference peer connection, preventing any further callbacks.
   virtual void Close() = 0;
   virtual void GetStats(webrtc::RTCStatsCollectorCallback* callback) = 0;
+  // Returns the times at which the steps of connecting have completed so far.
+  //
+  // Steps may complete before `Connect` is called if the local description was
+  // prepared ahead of time. This may be called from any thread.
+  virtual ConnectTimestamps GetConnectTimestamps() const = 0;
 };
 
 }  // namespace meet
@@ -24,11 +24,13 @@
 #include "gtest/gtest.h"
 #include "testing/base/public/mock-log.h"
 #include "absl/base/log_severity.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/notification.h"
 #include "cpp/internal/http_connector_interface.h"
+#include "cpp/internal/metrics_registry.h"
 #include "cpp/internal/testing/sdp_constants.h"
 #include "webrtc/api/jsep.h"
 #include "webrtc/api/make_ref_counted.h"
@@ -41,6 +43,7 @@
 #include "webrtc/api/test/mock_peerconnectioninterface.h"
 #include "webrtc/api/test/mock_rtp_transceiver.h"
 #include "webrtc/api/test/mock_session_description_interface.h"
+#include "webrtc/pc/session_description.h"
 #include "webrtc/rtc_base/thread.h"
 
 namespace meet {
@@ -48,6 +51,7 @@ namespace {
 
 using ::base_logging::WARNING;
 using ::testing::_;
+using ::testing::Const;
 using ::testing::HasSubstr;
 using ::testing::kDoNotCaptureLogsYet;
 using ::testing::MockFunction;
@@ -84,6 +88,38 @@ class MockHttpConnector : public HttpConnectorInterface {
               (override));
 };
 
+// Holds the callback of an asynchronous request so that tests can complete
+// the request later.
+class DeferredHttpConnector : public HttpConnectorInterface {
+ public:
+  absl::StatusOr<std::string> ConnectActiveConference(
+      absl::string_view /* join_endpoint */,
+      absl::string_view /* conference_id */,
+      absl::string_view /* access_token */,
+      absl::string_view /* sdp_offer */) override {
+    return absl::UnimplementedError("Only asynchronous requests are deferred.");
+  }
+
+  void ConnectActiveConferenceAsync(absl::string_view /* join_endpoint */,
+                                    absl::string_view /* conference_id */,
+                                    absl::string_view /* access_token */,
+                                    absl::string_view /* sdp_offer */,
+                                    ConnectCallback callback) override {
+    callback_ = std::move(callback);
+    request_sent_.Notify();
+  }
+
+  // Waits for a request to be sent and returns its callback.
+  ConnectCallback TakeCallback() {
+    request_sent_.WaitForNotification();
+    return std::move(callback_);
+  }
+
+ private:
+  absl::Notification request_sent_;
+  ConnectCallback callback_;
+};
+
 std::unique_ptr<rtc::Thread> CreateSignalingThread() {
   std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
   thread->SetName("signaling_thread", nullptr);
@@ -91,6 +127,71 @@ std::unique_ptr<rtc::Thread> CreateSignalingThread() {
   return thread;
 }
 
+// Connects with fixed arguments and waits for the `Connect` callback.
+absl::Status ConnectAndWait(
+    ConferencePeerConnection& conference_peer_connection) {
+  absl::Notification connect_done;
+  absl::Status connect_status;
+  conference_peer_connection.Connect(
+      "join-endpoint", "conference-id", "access-token",
+      [&connect_done, &connect_status](absl::Status status) {
+        connect_status = std::move(status);
+        connect_done.Notify();
+      });
+  connect_done.WaitForNotification();
+  return connect_status;
+}
+
+// Makes `peer_connection` report the answer set by `ExpectConnect` as its
+// remote description, which ICE restart answers must renegotiate.
+std::unique_ptr<webrtc::SessionDescriptionInterface>
+ExpectCurrentRemoteDescription(MockPeerConnection& peer_connection) {
+  std::unique_ptr<webrtc::SessionDescriptionInterface> description =
+      webrtc::CreateSessionDescription(webrtc::SdpType::kAnswer,
+                                       kWebRtcAnswer);
+  EXPECT_CALL(peer_connection, remote_description())
+      .WillRepeatedly(Return(description.get()));
+  return description;
+}
+
+// Expects a successful connection attempt that sends `offer`.
+// `remote_description_set` is notified once the remote description is set, if
+// provided.
+void ExpectConnect(MockPeerConnection& peer_connection,
+                   MockHttpConnector& http_connector,
+                   webrtc::MockSessionDescriptionInterface& local_description,
+                   absl::string_view offer,
+                   absl::Notification* remote_description_set = nullptr) {
+  EXPECT_CALL(peer_connection, SetLocalDescription(_))
+      .WillOnce(
+          [](rtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface>
+                 observer) {
+            observer->OnSetLocalDescriptionComplete(webrtc::RTCError::OK());
+          });
+  EXPECT_CALL(local_description, ToString(_))
+      .WillOnce([offer](std::string* str) {
+        *str = std::string(offer);
+        return true;
+      });
+  EXPECT_CALL(peer_connection, local_description())
+      .WillOnce(Return(&local_description));
+  EXPECT_CALL(http_connector,
+              ConnectActiveConference("join-endpoint", "conference-id",
+                                      "access-token", offer))
+      .WillOnce(Return(kWebRtcAnswer));
+  EXPECT_CALL(peer_connection, SetRemoteDescription(_, _))
+      .WillOnce(
+          [remote_description_set](
+              std::unique_ptr<webrtc::SessionDescriptionInterface>,
+              rtc::scoped_refptr<webrtc::SetRemoteDescriptionObserverInterface>
+                  observer) {
+            observer->OnSetRemoteDescriptionComplete(webrtc::RTCError::OK());
+            if (remote_description_set != nullptr) {
+              remote_description_set->Notify();
+            }
+          });
+}
+
 TEST(ConferencePeerConnectionTest, ConnectSucceeds) {
   auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
   EXPECT_CALL(*peer_connection, SetLocalDescription(_))
@@ -127,8 +228,118 @@ TEST(ConferencePeerConnectionTest, ConnectSucceeds) {
       CreateSignalingThread(), std::move(http_connector));
   conference_peer_connection.SetPeerConnection(std::move(peer_connection));
 
-  absl::Status connect_status = conference_peer_connection.Connect(
-      "join-endpoint", "conference-id", "access-token");
+  absl::Status connect_status = ConnectAndWait(conference_peer_connection);
+
+  EXPECT_TRUE(connect_status.ok());
+}
+
+TEST(ConferencePeerConnectionTest, ConnectRecordsTimestamps) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  EXPECT_CALL(*peer_connection, SetLocalDescription(_))
+      .WillOnce(
+          [&](rtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface>
+                  observer) {
+            observer->OnSetLocalDescriptionComplete(webrtc::RTCError::OK());
+          });
+  auto offer_description =
+      std::make_unique<webrtc::MockSessionDescriptionInterface>();
+  EXPECT_CALL(*offer_description, ToString(_)).WillOnce([](std::string* str) {
+    *str = kWebRtcOffer;
+    return true;
+  });
+  EXPECT_CALL(*peer_connection, local_description())
+      .WillOnce(Return(offer_description.get()));
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  EXPECT_CALL(*http_connector, ConnectActiveConference)
+      .WillOnce(Return(kWebRtcAnswer));
+  EXPECT_CALL(*peer_connection, SetRemoteDescription(_, _))
+      .WillOnce(
+          [&](std::unique_ptr<webrtc::SessionDescriptionInterface> description,
+              rtc::scoped_refptr<webrtc::SetRemoteDescriptionObserverInterface>
+                  observer) {
+            observer->OnSetRemoteDescriptionComplete(webrtc::RTCError::OK());
+          });
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::move(http_connector));
+  conference_peer_connection.SetPeerConnection(std::move(peer_connection));
+
+  ASSERT_TRUE(ConnectAndWait(conference_peer_connection).ok());
+  ConferencePeerConnection::ConnectTimestamps timestamps =
+      conference_peer_connection.GetConnectTimestamps();
+
+  ASSERT_TRUE(timestamps.local_description_set_us.has_value());
+  ASSERT_TRUE(timestamps.join_response_received_us.has_value());
+  ASSERT_TRUE(timestamps.remote_description_set_us.has_value());
+  EXPECT_LE(*timestamps.local_description_set_us,
+            *timestamps.join_response_received_us);
+  EXPECT_LE(*timestamps.join_response_received_us,
+            *timestamps.remote_description_set_us);
+  EXPECT_FALSE(timestamps.ice_gathering_complete_us.has_value());
+  EXPECT_FALSE(timestamps.peer_connection_connected_us.has_value());
+}
+
+TEST(ConferencePeerConnectionTest, RecordsFirstTransportTimestamps) {
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::make_unique<MockHttpConnector>());
+
+  conference_peer_connection.OnIceGatheringChange(
+      webrtc::PeerConnectionInterface::kIceGatheringComplete);
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kConnected);
+  ConferencePeerConnection::ConnectTimestamps first_timestamps =
+      conference_peer_connection.GetConnectTimestamps();
+  // Later changes, e.g. after an ICE restart, do not move the timestamps.
+  conference_peer_connection.OnIceGatheringChange(
+      webrtc::PeerConnectionInterface::kIceGatheringComplete);
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kConnected);
+  ConferencePeerConnection::ConnectTimestamps timestamps =
+      conference_peer_connection.GetConnectTimestamps();
+
+  ASSERT_TRUE(first_timestamps.ice_gathering_complete_us.has_value());
+  ASSERT_TRUE(first_timestamps.peer_connection_connected_us.has_value());
+  EXPECT_EQ(timestamps.ice_gathering_complete_us,
+            first_timestamps.ice_gathering_complete_us);
+  EXPECT_EQ(timestamps.peer_connection_connected_us,
+            first_timestamps.peer_connection_connected_us);
+  EXPECT_FALSE(timestamps.local_description_set_us.has_value());
+}
+
+TEST(ConferencePeerConnectionTest, ConnectUsesPreparedLocalDescription) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  // The offer is only generated once, by `PrepareLocalDescription`.
+  EXPECT_CALL(*peer_connection, SetLocalDescription(_))
+      .WillOnce(
+          [&](rtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface>
+                  observer) {
+            observer->OnSetLocalDescriptionComplete(webrtc::RTCError::OK());
+          });
+  auto offer_description =
+      std::make_unique<webrtc::MockSessionDescriptionInterface>();
+  EXPECT_CALL(*offer_description, ToString(_)).WillOnce([](std::string* str) {
+    *str = kWebRtcOffer;
+    return true;
+  });
+  EXPECT_CALL(*peer_connection, local_description())
+      .WillOnce(Return(offer_description.get()));
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  EXPECT_CALL(*http_connector,
+              ConnectActiveConference("join-endpoint", "conference-id",
+                                      "access-token", kWebRtcOffer))
+      .WillOnce(Return(kWebRtcAnswer));
+  EXPECT_CALL(*peer_connection, SetRemoteDescription(_, _))
+      .WillOnce(
+          [&](std::unique_ptr<webrtc::SessionDescriptionInterface> description,
+              rtc::scoped_refptr<webrtc::SetRemoteDescriptionObserverInterface>
+                  observer) {
+            observer->OnSetRemoteDescriptionComplete(webrtc::RTCError::OK());
+          });
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::move(http_connector));
+  conference_peer_connection.SetPeerConnection(std::move(peer_connection));
+
+  EXPECT_TRUE(conference_peer_connection.PrepareLocalDescription().ok());
+  absl::Status connect_status = ConnectAndWait(conference_peer_connection);
 
   EXPECT_TRUE(connect_status.ok());
 }
@@ -137,8 +348,7 @@ TEST(ConferencePeerConnectionTest, ConnectFailsWithNullPeerConnection) {
   ConferencePeerConnection conference_peer_connection(
       CreateSignalingThread(), std::make_unique<MockHttpConnector>());
 
-  absl::Status connect_status = conference_peer_connection.Connect(
-      "join-endpoint", "conference-id", "access-token");
+  absl::Status connect_status = ConnectAndWait(conference_peer_connection);
 
   EXPECT_THAT(connect_status, StatusIs(absl::StatusCode::kInternal,
                                        "Peer connection is null."));
@@ -159,8 +369,7 @@ TEST(ConferencePeerConnectionTest,
       CreateSignalingThread(), std::make_unique<MockHttpConnector>());
   conference_peer_connection.SetPeerConnection(std::move(peer_connection));
 
-  absl::Status connect_status = conference_peer_connection.Connect(
-      "join-endpoint", "conference-id", "access-token");
+  absl::Status connect_status = ConnectAndWait(conference_peer_connection);
 
   EXPECT_THAT(connect_status, StatusIs(absl::StatusCode::kInternal,
                                        HasSubstr("local-description-error")));
@@ -189,8 +398,7 @@ TEST(ConferencePeerConnectionTest, ConnectFailsWhenHttpConnectorFails) {
       CreateSignalingThread(), std::move(http_connector));
   conference_peer_connection.SetPeerConnection(std::move(peer_connection));
 
-  absl::Status connect_status = conference_peer_connection.Connect(
-      "join-endpoint", "conference-id", "access-token");
+  absl::Status connect_status = ConnectAndWait(conference_peer_connection);
 
   EXPECT_THAT(connect_status, StatusIs(absl::StatusCode::kInternal,
                                        HasSubstr("http-connector-error")));
@@ -229,8 +437,7 @@ TEST(ConferencePeerConnectionTest,
       CreateSignalingThread(), std::move(http_connector));
   conference_peer_connection.SetPeerConnection(std::move(peer_connection));
 
-  absl::Status connect_status = conference_peer_connection.Connect(
-      "join-endpoint", "conference-id", "access-token");
+  absl::Status connect_status = ConnectAndWait(conference_peer_connection);
 
   EXPECT_THAT(connect_status, StatusIs(absl::StatusCode::kInternal,
                                        HasSubstr("remote-description-error")));
@@ -276,6 +483,42 @@ TEST(ConferencePeerConnectionTest,
   EXPECT_TRUE(notification.HasBeenNotified());
 }
 
+TEST(ConferencePeerConnectionTest, DestructionCancelsInFlightConnect) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  EXPECT_CALL(*peer_connection, SetLocalDescription(_))
+      .WillOnce(
+          [](rtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface>
+                 observer) {
+            observer->OnSetLocalDescriptionComplete(webrtc::RTCError::OK());
+          });
+  webrtc::MockSessionDescriptionInterface local_description;
+  EXPECT_CALL(local_description, ToString(_)).WillOnce(Return(true));
+  EXPECT_CALL(*peer_connection, local_description())
+      .WillOnce(Return(&local_description));
+  EXPECT_CALL(*peer_connection, SetRemoteDescription(_, _)).Times(0);
+  auto http_connector = std::make_unique<DeferredHttpConnector>();
+  DeferredHttpConnector* http_connector_ptr = http_connector.get();
+  // The signaling thread outlives the conference peer connection, so the
+  // response below is delivered to it after destruction.
+  std::unique_ptr<rtc::Thread> signaling_thread = CreateSignalingThread();
+  auto conference_peer_connection = std::make_unique<ConferencePeerConnection>(
+      signaling_thread.get(), std::move(http_connector));
+  conference_peer_connection->SetPeerConnection(peer_connection);
+  MockFunction<void(absl::Status)> connect_callback;
+  EXPECT_CALL(connect_callback, Call).Times(0);
+  conference_peer_connection->Connect("join-endpoint", "conference-id",
+                                      "access-token",
+                                      connect_callback.AsStdFunction());
+  HttpConnectorInterface::ConnectCallback response_callback =
+      http_connector_ptr->TakeCallback();
+
+  // Destruction does not wait for the response.
+  conference_peer_connection = nullptr;
+  std::move(response_callback)(std::string(kWebRtcAnswer));
+
+  signaling_thread->BlockingCall([]() {});
+}
+
 TEST(ConferencePeerConnectionTest, LogsWarningWhenClosedWithoutPeerConnection) {
   ConferencePeerConnection conference_peer_connection(
       CreateSignalingThread(), std::make_unique<MockHttpConnector>());
@@ -349,6 +592,297 @@ TEST(ConferencePeerConnectionTest,
   EXPECT_EQ(message, "PeerConnection closed without disconnect callback.");
 }
 
+TEST(ConferencePeerConnectionTest, RestartsIceWhenConnectionFails) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  webrtc::MockSessionDescriptionInterface local_description;
+  ExpectConnect(*peer_connection, *http_connector, local_description,
+                kWebRtcOffer);
+  MockHttpConnector* http_connector_ptr = http_connector.get();
+  auto metrics = std::make_shared<MetricsRegistry>();
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::move(http_connector), metrics,
+      /*max_ice_restarts=*/1);
+  conference_peer_connection.SetPeerConnection(peer_connection);
+  ASSERT_TRUE(ConnectAndWait(conference_peer_connection).ok());
+  std::unique_ptr<webrtc::SessionDescriptionInterface> remote_description =
+      ExpectCurrentRemoteDescription(*peer_connection);
+
+  // The restart renegotiates with a new offer, reusing the join arguments.
+  webrtc::MockSessionDescriptionInterface restart_description;
+  absl::Notification restarted;
+  ExpectConnect(*peer_connection, *http_connector_ptr, restart_description,
+                "ice-restart-offer", &restarted);
+  EXPECT_CALL(*peer_connection, RestartIce());
+  MockFunction<void(absl::Status)> disconnect_callback;
+  EXPECT_CALL(disconnect_callback, Call).Times(0);
+  conference_peer_connection.SetDisconnectCallback(
+      disconnect_callback.AsStdFunction());
+
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed);
+
+  restarted.WaitForNotification();
+  EXPECT_EQ(metrics->GetCounter("meet_ice_restarts").value(), 1);
+}
+
+TEST(ConferencePeerConnectionTest,
+     CallsDisconnectedCallbackWhenIceRestartsAreExhausted) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  webrtc::MockSessionDescriptionInterface local_description;
+  ExpectConnect(*peer_connection, *http_connector, local_description,
+                kWebRtcOffer);
+  MockHttpConnector* http_connector_ptr = http_connector.get();
+  std::unique_ptr<rtc::Thread> signaling_thread = CreateSignalingThread();
+  ConferencePeerConnection conference_peer_connection(
+      signaling_thread.get(), std::move(http_connector),
+      /*metrics=*/nullptr, /*max_ice_restarts=*/1);
+  conference_peer_connection.SetPeerConnection(peer_connection);
+  ASSERT_TRUE(ConnectAndWait(conference_peer_connection).ok());
+  std::unique_ptr<webrtc::SessionDescriptionInterface> remote_description =
+      ExpectCurrentRemoteDescription(*peer_connection);
+  webrtc::MockSessionDescriptionInterface restart_description;
+  absl::Notification restarted;
+  ExpectConnect(*peer_connection, *http_connector_ptr, restart_description,
+                "ice-restart-offer", &restarted);
+  EXPECT_CALL(*peer_connection, RestartIce());
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed);
+  restarted.WaitForNotification();
+  // The restart completes in a task posted before the notification.
+  signaling_thread->BlockingCall([]() {});
+  absl::Status status;
+  MockFunction<void(absl::Status)> disconnect_callback;
+  EXPECT_CALL(disconnect_callback, Call).WillOnce([&status](absl::Status s) {
+    status = s;
+  });
+  conference_peer_connection.SetDisconnectCallback(
+      disconnect_callback.AsStdFunction());
+
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed);
+
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kUnavailable,
+                               HasSubstr("after 1 ICE restarts")));
+}
+
+TEST(ConferencePeerConnectionTest,
+     CallsDisconnectedCallbackWhenIceRestartFails) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  webrtc::MockSessionDescriptionInterface local_description;
+  ExpectConnect(*peer_connection, *http_connector, local_description,
+                kWebRtcOffer);
+  MockHttpConnector* http_connector_ptr = http_connector.get();
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::move(http_connector),
+      /*metrics=*/nullptr, /*max_ice_restarts=*/1);
+  conference_peer_connection.SetPeerConnection(peer_connection);
+  ASSERT_TRUE(ConnectAndWait(conference_peer_connection).ok());
+  EXPECT_CALL(*peer_connection, RestartIce());
+  EXPECT_CALL(*peer_connection, SetLocalDescription(_))
+      .WillOnce(
+          [](rtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface>
+                 observer) {
+            observer->OnSetLocalDescriptionComplete(webrtc::RTCError::OK());
+          });
+  webrtc::MockSessionDescriptionInterface restart_description;
+  EXPECT_CALL(restart_description, ToString(_)).WillOnce(Return(true));
+  EXPECT_CALL(*peer_connection, local_description())
+      .WillOnce(Return(&restart_description));
+  EXPECT_CALL(*http_connector_ptr, ConnectActiveConference)
+      .WillOnce(Return(absl::InternalError("http-error")));
+  absl::Status status;
+  absl::Notification disconnected;
+  MockFunction<void(absl::Status)> disconnect_callback;
+  EXPECT_CALL(disconnect_callback, Call)
+      .WillOnce([&status, &disconnected](absl::Status s) {
+        status = s;
+        disconnected.Notify();
+      });
+  conference_peer_connection.SetDisconnectCallback(
+      disconnect_callback.AsStdFunction());
+
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed);
+
+  disconnected.WaitForNotification();
+  EXPECT_THAT(status,
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("http-error")));
+}
+
+TEST(ConferencePeerConnectionTest,
+     CallsDisconnectedCallbackWhenIceRestartAnswersNewSession) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  webrtc::MockSessionDescriptionInterface local_description;
+  ExpectConnect(*peer_connection, *http_connector, local_description,
+                kWebRtcOffer);
+  MockHttpConnector* http_connector_ptr = http_connector.get();
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::move(http_connector),
+      /*metrics=*/nullptr, /*max_ice_restarts=*/1);
+  conference_peer_connection.SetPeerConnection(peer_connection);
+  ASSERT_TRUE(ConnectAndWait(conference_peer_connection).ok());
+  // The current session only has an audio line, so the full answer returned
+  // for the restart offer does not renegotiate it.
+  auto session = std::make_unique<cricket::SessionDescription>();
+  session->AddContent("0", cricket::MediaProtocolType::kRtp,
+                      std::make_unique<cricket::AudioContentDescription>());
+  webrtc::MockSessionDescriptionInterface remote_description;
+  EXPECT_CALL(Const(remote_description), description())
+      .WillRepeatedly(Return(session.get()));
+  EXPECT_CALL(*peer_connection, remote_description())
+      .WillRepeatedly(Return(&remote_description));
+  EXPECT_CALL(*peer_connection, RestartIce());
+  EXPECT_CALL(*peer_connection, SetLocalDescription(_))
+      .WillOnce(
+          [](rtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface>
+                 observer) {
+            observer->OnSetLocalDescriptionComplete(webrtc::RTCError::OK());
+          });
+  webrtc::MockSessionDescriptionInterface restart_description;
+  EXPECT_CALL(restart_description, ToString(_)).WillOnce(Return(true));
+  EXPECT_CALL(*peer_connection, local_description())
+      .WillOnce(Return(&restart_description));
+  EXPECT_CALL(*http_connector_ptr, ConnectActiveConference)
+      .WillOnce(Return(kWebRtcAnswer));
+  EXPECT_CALL(*peer_connection, SetRemoteDescription(_, _)).Times(0);
+  absl::Status status;
+  absl::Notification disconnected;
+  MockFunction<void(absl::Status)> disconnect_callback;
+  EXPECT_CALL(disconnect_callback, Call)
+      .WillOnce([&status, &disconnected](absl::Status s) {
+        status = s;
+        disconnected.Notify();
+      });
+  conference_peer_connection.SetDisconnectCallback(
+      disconnect_callback.AsStdFunction());
+
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed);
+
+  disconnected.WaitForNotification();
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kFailedPrecondition,
+                               HasSubstr("does not renegotiate")));
+}
+
+TEST(ConferencePeerConnectionTest, RestartsIceWithFreshAccessToken) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  webrtc::MockSessionDescriptionInterface local_description;
+  ExpectConnect(*peer_connection, *http_connector, local_description,
+                kWebRtcOffer);
+  MockHttpConnector* http_connector_ptr = http_connector.get();
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::move(http_connector),
+      /*metrics=*/nullptr, /*max_ice_restarts=*/1);
+  conference_peer_connection.SetPeerConnection(peer_connection);
+  conference_peer_connection.SetAccessTokenProvider(
+      [](absl::AnyInvocable<void(absl::StatusOr<std::string>) &&> callback) {
+        std::move(callback)("fresh-access-token");
+      });
+  ASSERT_TRUE(ConnectAndWait(conference_peer_connection).ok());
+  EXPECT_CALL(*peer_connection, RestartIce());
+  EXPECT_CALL(*peer_connection, SetLocalDescription(_))
+      .WillOnce(
+          [](rtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface>
+                 observer) {
+            observer->OnSetLocalDescriptionComplete(webrtc::RTCError::OK());
+          });
+  webrtc::MockSessionDescriptionInterface restart_description;
+  EXPECT_CALL(restart_description, ToString(_))
+      .WillOnce([](std::string* str) {
+        *str = "ice-restart-offer";
+        return true;
+      });
+  EXPECT_CALL(*peer_connection, local_description())
+      .WillOnce(Return(&restart_description));
+  absl::Notification offer_sent;
+  EXPECT_CALL(*http_connector_ptr,
+              ConnectActiveConference("join-endpoint", "conference-id",
+                                      "fresh-access-token",
+                                      "ice-restart-offer"))
+      .WillOnce([&offer_sent]() {
+        offer_sent.Notify();
+        return absl::UnavailableError("renegotiation-error");
+      });
+
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed);
+
+  offer_sent.WaitForNotification();
+}
+
+TEST(ConferencePeerConnectionTest,
+     CallsDisconnectedCallbackWhenAccessTokenCannotBeRefreshed) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  webrtc::MockSessionDescriptionInterface local_description;
+  ExpectConnect(*peer_connection, *http_connector, local_description,
+                kWebRtcOffer);
+  MockHttpConnector* http_connector_ptr = http_connector.get();
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::move(http_connector),
+      /*metrics=*/nullptr, /*max_ice_restarts=*/1);
+  conference_peer_connection.SetPeerConnection(peer_connection);
+  conference_peer_connection.SetAccessTokenProvider(
+      [](absl::AnyInvocable<void(absl::StatusOr<std::string>) &&> callback) {
+        std::move(callback)(absl::InternalError("token-error"));
+      });
+  ASSERT_TRUE(ConnectAndWait(conference_peer_connection).ok());
+  EXPECT_CALL(*peer_connection, RestartIce());
+  EXPECT_CALL(*peer_connection, SetLocalDescription(_))
+      .WillOnce(
+          [](rtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface>
+                 observer) {
+            observer->OnSetLocalDescriptionComplete(webrtc::RTCError::OK());
+          });
+  webrtc::MockSessionDescriptionInterface restart_description;
+  EXPECT_CALL(restart_description, ToString(_)).WillOnce(Return(true));
+  EXPECT_CALL(*peer_connection, local_description())
+      .WillOnce(Return(&restart_description));
+  EXPECT_CALL(*http_connector_ptr, ConnectActiveConference).Times(0);
+  absl::Status status;
+  absl::Notification disconnected;
+  MockFunction<void(absl::Status)> disconnect_callback;
+  EXPECT_CALL(disconnect_callback, Call)
+      .WillOnce([&status, &disconnected](absl::Status s) {
+        status = s;
+        disconnected.Notify();
+      });
+  conference_peer_connection.SetDisconnectCallback(
+      disconnect_callback.AsStdFunction());
+
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed);
+
+  disconnected.WaitForNotification();
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kUnauthenticated,
+                               HasSubstr("token-error")));
+}
+
+TEST(ConferencePeerConnectionTest, DoesNotRestartIceWhenDisabled) {
+  auto peer_connection = rtc::make_ref_counted<MockPeerConnection>();
+  auto http_connector = std::make_unique<MockHttpConnector>();
+  webrtc::MockSessionDescriptionInterface local_description;
+  ExpectConnect(*peer_connection, *http_connector, local_description,
+                kWebRtcOffer);
+  ConferencePeerConnection conference_peer_connection(
+      CreateSignalingThread(), std::move(http_connector));
+  conference_peer_connection.SetPeerConnection(peer_connection);
+  ASSERT_TRUE(ConnectAndWait(conference_peer_connection).ok());
+  EXPECT_CALL(*peer_connection, RestartIce()).Times(0);
+  MockFunction<void(absl::Status)> disconnect_callback;
+  EXPECT_CALL(disconnect_callback, Call).Times(0);
+  conference_peer_connection.SetDisconnectCallback(
+      disconnect_callback.AsStdFunction());
+
+  conference_peer_connection.OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState::kFailed);
+}
+
 TEST(ConferencePeerConnectionTest,
      CallsTrackSignaledCallbackWhenTrackIsSignaled) {
   MockFunction<void(rtc::scoped_refptr<webrtc::RtpTransceiverInterface>)>
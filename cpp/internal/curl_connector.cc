@@ -20,13 +20,14 @@
 #include <string>
 #include <utility>
 
-#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "nlohmann/json.hpp"
 #include "cpp/internal/curl_request.h"
+#include "cpp/internal/trace.h"
+#include "webrtc/rtc_base/thread.h"
 
 namespace meet {
 namespace {
@@ -41,47 +42,43 @@ const json* FindOrNull(const json& json, absl::string_view key) {
 
 }  // namespace
 
-absl::StatusOr<std::string> CurlConnector::ConnectActiveConference(
-    absl::string_view join_endpoint, absl::string_view conference_id,
-    absl::string_view access_token, absl::string_view sdp_offer) {
+void PopulateConnectActiveConferenceRequest(absl::string_view join_endpoint,
+                                            absl::string_view conference_id,
+                                            absl::string_view access_token,
+                                            absl::string_view sdp_offer,
+                                            CurlRequest& curl_request) {
   std::string full_join_endpoint = absl::StrCat(
       join_endpoint, "/spaces/", conference_id, ":connectActiveConference");
 
-  VLOG(1) << "Connecting to " << full_join_endpoint;
+  MEET_TRACE(kHttp) << "Connecting to " << full_join_endpoint;
 
-  CurlRequest curl_request(*curl_api_wrapper_);
   curl_request.SetRequestUrl(std::move(full_join_endpoint));
   curl_request.SetRequestHeader("Content-Type",
                                 "application/json;charset=UTF-8");
   curl_request.SetRequestHeader("Authorization",
                                 absl::StrCat("Bearer ", access_token));
-  if (ca_cert_path_.has_value()) {
-    curl_request.SetCaCertPath(*ca_cert_path_);
-  }
 
   nlohmann::basic_json<> offer_json;
   offer_json["offer"] = sdp_offer;
   std::string offer_json_string = offer_json.dump();
 
-  VLOG(1) << "Join request offer: " << offer_json_string;
+  MEET_TRACE(kHttp) << "Join request offer: " << offer_json_string;
   curl_request.SetRequestBody(std::move(offer_json_string));
+}
 
-  absl::Status response_status = curl_request.Send();
-  if (!response_status.ok()) {
-    return response_status;
-  }
-
+absl::StatusOr<std::string> ParseConnectActiveConferenceResponse(
+    absl::string_view response_data) {
   const json json_request_response =
-      json::parse(curl_request.GetResponseData(), /*cb=*/nullptr,
+      json::parse(response_data, /*cb=*/nullptr,
                   /*allow_exceptions=*/false);
 
-  VLOG(1) << "Parsing response from Meet servers: "
-          << json_request_response.dump();
+  MEET_TRACE(kHttp) << "Parsing response from Meet servers: "
+                    << json_request_response.dump();
 
   if (!json_request_response.is_object()) {
     return absl::UnknownError(
         absl::StrCat("Unparseable or non-json response from Meet servers, ",
-                     curl_request.GetResponseData()));
+                     response_data));
   }
 
   if (const json* answer_field = FindOrNull(json_request_response, "answer");
@@ -115,6 +112,53 @@ absl::StatusOr<std::string> CurlConnector::ConnectActiveConference(
   return absl::UnknownError(
       absl::StrCat("Received response without `answer` or `error` field: ",
                    json_request_response.dump()));
-};
+}
+
+absl::StatusOr<std::string> CurlConnector::ConnectActiveConference(
+    absl::string_view join_endpoint, absl::string_view conference_id,
+    absl::string_view access_token, absl::string_view sdp_offer) {
+  CurlRequest curl_request(*curl_api_wrapper_);
+  PopulateConnectActiveConferenceRequest(join_endpoint, conference_id,
+                                         access_token, sdp_offer,
+                                         curl_request);
+  if (ca_cert_path_.has_value()) {
+    curl_request.SetCaCertPath(*ca_cert_path_);
+  }
+  if (connection_pool_ != nullptr) {
+    curl_request.SetConnectionPool(*connection_pool_);
+  }
+
+  absl::Status response_status = curl_request.Send();
+  if (!response_status.ok()) {
+    return response_status;
+  }
+  return ParseConnectActiveConferenceResponse(curl_request.GetResponseData());
+}
+
+void CurlConnector::ConnectActiveConferenceAsync(
+    absl::string_view join_endpoint, absl::string_view conference_id,
+    absl::string_view access_token, absl::string_view sdp_offer,
+    ConnectCallback callback) {
+  if (request_thread_ == nullptr) {
+    std::unique_ptr<rtc::Thread> request_thread = rtc::Thread::Create();
+    request_thread->SetName("curl_connector_request_thread", nullptr);
+    if (!request_thread->Start()) {
+      std::move(callback)(
+          absl::InternalError("Failed to start curl request thread."));
+      return;
+    }
+    request_thread_ = std::move(request_thread);
+  }
+
+  request_thread_->PostTask(
+      [this, join_endpoint = std::string(join_endpoint),
+       conference_id = std::string(conference_id),
+       access_token = std::string(access_token),
+       sdp_offer = std::string(sdp_offer),
+       callback = std::move(callback)]() mutable {
+        std::move(callback)(ConnectActiveConference(
+            join_endpoint, conference_id, access_token, sdp_offer));
+      });
+}
 
 }  // namespace meet
@@ -26,20 +26,56 @@
 #include "absl/strings/string_view.h"
 #include "cpp/internal/curl_request.h"
 #include "cpp/internal/http_connector_interface.h"
+#include "webrtc/rtc_base/thread.h"
 
 namespace meet {
 
+// Populates `curl_request` with the URL, headers and body of a request to
+// Meet's `ConnectActiveConference` endpoint.
+void PopulateConnectActiveConferenceRequest(absl::string_view join_endpoint,
+                                            absl::string_view conference_id,
+                                            absl::string_view access_token,
+                                            absl::string_view sdp_offer,
+                                            CurlRequest& curl_request);
+
+// Extracts the SDP answer from a `ConnectActiveConference` response, or returns
+// the error reported by Meet servers.
+absl::StatusOr<std::string> ParseConnectActiveConferenceResponse(
+    absl::string_view response_data);
+
 // Implementation of `HttpConnectorInterface` that uses `CurlRequest` to make
 // HTTP requests.
 class CurlConnector : public HttpConnectorInterface {
  public:
-  explicit CurlConnector(std::unique_ptr<CurlApiWrapper> curl_api_wrapper)
-      : curl_api_wrapper_(std::move(curl_api_wrapper)) {};
+  // If `connection_pool` is set, requests reuse the DNS and TLS session caches
+  // it shares, which lets connectors created for different clients skip
+  // repeated lookups and full TLS handshakes with Meet servers.
+  explicit CurlConnector(
+      std::unique_ptr<CurlApiWrapper> curl_api_wrapper,
+      std::shared_ptr<CurlConnectionPool> connection_pool = nullptr)
+      : curl_api_wrapper_(std::move(curl_api_wrapper)),
+        connection_pool_(std::move(connection_pool)) {};
+
+  // Waits for any in-flight asynchronous request to complete.
+  ~CurlConnector() override {
+    if (request_thread_ != nullptr) {
+      request_thread_->Stop();
+    }
+  }
 
   absl::StatusOr<std::string> ConnectActiveConference(
       absl::string_view join_endpoint, absl::string_view conference_id,
       absl::string_view access_token, absl::string_view sdp_offer) override;
 
+  // Curl requests block until they complete, so asynchronous requests are sent
+  // from a thread owned by this connector. The thread is started by the first
+  // asynchronous request, and `callback` is invoked on it.
+  void ConnectActiveConferenceAsync(absl::string_view join_endpoint,
+                                    absl::string_view conference_id,
+                                    absl::string_view access_token,
+                                    absl::string_view sdp_offer,
+                                    ConnectCallback callback) override;
+
   // Sets the path to the CA certificate file to be used by curl.
   //
   // This value will be set as the `CURLOPT_CAINFO` option when making requests
@@ -52,7 +88,9 @@ class CurlConnector : public HttpConnectorInterface {
 
  private:
   std::unique_ptr<CurlApiWrapper> curl_api_wrapper_;
+  std::shared_ptr<CurlConnectionPool> connection_pool_;
   std::optional<std::string> ca_cert_path_;
+  std::unique_ptr<rtc::Thread> request_thread_;
 };
 
 }  // namespace meet
@@ -25,6 +25,7 @@
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
+#include "absl/synchronization/notification.h"
 #include <curl/curl.h>
 #include "nlohmann/json.hpp"
 #include "cpp/internal/testing/mock_curl_api_wrapper.h"
@@ -35,6 +36,7 @@ namespace {
 using Json = ::nlohmann::json;
 using ::testing::_;
 using ::testing::HasSubstr;
+using ::testing::Return;
 using ::testing::StrEq;
 
 TEST(CurlConnectorTest, PopulatesRequest) {
@@ -120,6 +122,54 @@ TEST(CurlConnectorTest, ReturnsResponse) {
   EXPECT_EQ(response.value(), "some sdp answer");
 }
 
+TEST(CurlConnectorTest, AsyncRequestInvokesCallbackWithResponse) {
+  nlohmann::basic_json<> response_body;
+  response_body["answer"] = "some sdp answer";
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  EXPECT_CALL(*mock_curl_api, EasySetOptPtr(_, CURLOPT_WRITEDATA, _))
+      .WillOnce([&response_body](CURL* curl, CURLoption option, void* value) {
+        absl::Cord curl_response(response_body.dump());
+        absl::Cord* str_response = reinterpret_cast<absl::Cord*>(value);
+        *str_response = curl_response;
+        return CURLE_OK;
+      });
+  EXPECT_CALL(*mock_curl_api, EasySetOptPtr(_, CURLOPT_HTTPHEADER, _))
+      .WillOnce(
+          [](CURL* curl, CURLoption option, void* value) { return CURLE_OK; });
+  CurlConnector curl_connector(std::move(mock_curl_api));
+  absl::Notification response_received;
+  absl::StatusOr<std::string> response;
+
+  curl_connector.ConnectActiveConferenceAsync(
+      "https://meet.googleapis.com", "abcdefg", "bearer_token",
+      "some sdp offer",
+      [&](absl::StatusOr<std::string> async_response) {
+        response = std::move(async_response);
+        response_received.Notify();
+      });
+
+  response_received.WaitForNotification();
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ(response.value(), "some sdp answer");
+}
+
+TEST(CurlConnectorTest, RequestsUseConnectionPool) {
+  absl::StatusOr<std::unique_ptr<CurlConnectionPool>> connection_pool =
+      CurlConnectionPool::Create(std::make_unique<MockCurlApiWrapper>());
+  ASSERT_TRUE(connection_pool.ok());
+  CURLSH* share = (*connection_pool)->share();
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  EXPECT_CALL(*mock_curl_api, EasySetOptPtr).WillRepeatedly(Return(CURLE_OK));
+  EXPECT_CALL(*mock_curl_api, EasySetOptPtr(_, CURLOPT_SHARE, share))
+      .WillOnce(Return(CURLE_OK));
+  CurlConnector curl_connector(std::move(mock_curl_api),
+                               *std::move(connection_pool));
+
+  (void)curl_connector.ConnectActiveConference(
+      "https://meet.googleapis.com", "abcdefg", "bearer_token",
+      "some sdp offer");
+}
+
 TEST(CurlConnectorTest, ReturnsErrorFromResponse) {
   nlohmann::basic_json<> response_body;
   response_body["error"]["status"] = "some error status";
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/curl_multi_connector.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include <curl/curl.h>
+#include "cpp/internal/curl_connector.h"
+#include "cpp/internal/curl_request.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace meet {
+namespace {
+
+// Upper bound on how long an event loop iteration waits for socket activity.
+// curl shortens the wait when its own timers expire sooner, and new requests
+// interrupt it with `MultiWakeup`.
+constexpr int kPollTimeoutMs = 1000;
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<CurlMultiConnector>> CurlMultiConnector::Create(
+    std::unique_ptr<CurlApiWrapper> curl_api_wrapper) {
+  CURLM* multi = curl_api_wrapper->MultiInit();
+  if (multi == nullptr) {
+    return absl::InternalError("Failed to initialize curl multi");
+  }
+
+  std::unique_ptr<rtc::Thread> loop_thread = rtc::Thread::Create();
+  loop_thread->SetName("curl_multi_event_loop_thread", nullptr);
+  if (!loop_thread->Start()) {
+    curl_api_wrapper->MultiCleanup(multi);
+    return absl::InternalError("Failed to start curl multi event loop thread");
+  }
+
+  return std::unique_ptr<CurlMultiConnector>(new CurlMultiConnector(
+      std::move(curl_api_wrapper), multi, std::move(loop_thread)));
+}
+
+CurlMultiConnector::~CurlMultiConnector() {
+  // Interrupt a blocking poll so that the event loop thread stops promptly.
+  curl_api_wrapper_->MultiWakeup(multi_);
+  loop_thread_->Stop();
+
+  FailTransfers(absl::CancelledError("Curl multi connector destroyed."));
+  if (CURLMcode code = curl_api_wrapper_->MultiCleanup(multi_);
+      code != CURLM_OK) {
+    LOG(ERROR) << "Failed to clean up curl multi: "
+               << curl_multi_strerror(code);
+  }
+}
+
+absl::StatusOr<std::string> CurlMultiConnector::ConnectActiveConference(
+    absl::string_view join_endpoint, absl::string_view conference_id,
+    absl::string_view access_token, absl::string_view sdp_offer) {
+  if (loop_thread_->IsCurrent()) {
+    return absl::FailedPreconditionError(
+        "ConnectActiveConference called on the curl multi event loop thread.");
+  }
+
+  absl::Notification done;
+  absl::StatusOr<std::string> response;
+  ConnectActiveConferenceAsync(
+      join_endpoint, conference_id, access_token, sdp_offer,
+      [&done, &response](absl::StatusOr<std::string> async_response) {
+        response = std::move(async_response);
+        done.Notify();
+      });
+  done.WaitForNotification();
+  return response;
+}
+
+void CurlMultiConnector::ConnectActiveConferenceAsync(
+    absl::string_view join_endpoint, absl::string_view conference_id,
+    absl::string_view access_token, absl::string_view sdp_offer,
+    ConnectCallback callback) {
+  auto request = std::make_unique<CurlRequest>(*curl_api_wrapper_);
+  PopulateConnectActiveConferenceRequest(join_endpoint, conference_id,
+                                         access_token, sdp_offer, *request);
+  if (ca_cert_path_.has_value()) {
+    request->SetCaCertPath(*ca_cert_path_);
+  }
+
+  loop_thread_->PostTask([this, request = std::move(request),
+                          callback = std::move(callback)]() mutable {
+    StartTransfer(std::move(request), std::move(callback));
+  });
+  // Interrupt a blocking poll so that the transfer starts immediately.
+  curl_api_wrapper_->MultiWakeup(multi_);
+}
+
+void CurlMultiConnector::StartTransfer(std::unique_ptr<CurlRequest> request,
+                                       ConnectCallback callback) {
+  CURL* curl = curl_api_wrapper_->EasyInit();
+  if (curl == nullptr) {
+    std::move(callback)(absl::InternalError("Failed to initialize curl"));
+    return;
+  }
+
+  if (absl::Status prepare_status = request->Prepare(curl);
+      !prepare_status.ok()) {
+    curl_api_wrapper_->EasyCleanup(curl);
+    std::move(callback)(std::move(prepare_status));
+    return;
+  }
+
+  if (CURLMcode code = curl_api_wrapper_->MultiAddHandle(multi_, curl);
+      code != CURLM_OK) {
+    curl_api_wrapper_->EasyCleanup(curl);
+    std::move(callback)(absl::InternalError(absl::StrCat(
+        "Failed to add curl handle to multi: ", curl_multi_strerror(code))));
+    return;
+  }
+
+  transfers_.emplace(curl, Transfer{.request = std::move(request),
+                                    .callback = std::move(callback)});
+  if (!polling_) {
+    polling_ = true;
+    Poll();
+  }
+}
+
+void CurlMultiConnector::Poll() {
+  int running_handles = 0;
+  if (CURLMcode code =
+          curl_api_wrapper_->MultiPerform(multi_, &running_handles);
+      code != CURLM_OK) {
+    FailTransfers(absl::InternalError(absl::StrCat(
+        "Curl failed multi perform: ", curl_multi_strerror(code))));
+  }
+  CompleteFinishedTransfers();
+
+  if (transfers_.empty()) {
+    polling_ = false;
+    return;
+  }
+
+  // Wait for socket activity, a curl timer, or a wakeup from a new request
+  // before the next iteration. Posting the iteration rather than looping here
+  // lets tasks that start new transfers run in between.
+  if (CURLMcode code = curl_api_wrapper_->MultiPoll(multi_, kPollTimeoutMs);
+      code != CURLM_OK) {
+    LOG(WARNING) << "Curl failed multi poll: " << curl_multi_strerror(code);
+  }
+  loop_thread_->PostTask([this]() { Poll(); });
+}
+
+void CurlMultiConnector::CompleteFinishedTransfers() {
+  int messages_in_queue = 0;
+  while (CURLMsg* message =
+             curl_api_wrapper_->MultiInfoRead(multi_, &messages_in_queue)) {
+    if (message->msg != CURLMSG_DONE) {
+      continue;
+    }
+    // `message` is invalidated once its handle is removed, so copy what is
+    // needed first.
+    CURL* curl = message->easy_handle;
+    CURLcode result = message->data.result;
+
+    auto it = transfers_.find(curl);
+    if (it == transfers_.end()) {
+      LOG(DFATAL) << "Curl reported completion of an unknown transfer.";
+      continue;
+    }
+    Transfer transfer = std::move(it->second);
+    transfers_.erase(it);
+    curl_api_wrapper_->MultiRemoveHandle(multi_, curl);
+    curl_api_wrapper_->EasyCleanup(curl);
+
+    if (result != CURLE_OK) {
+      std::move(transfer.callback)(absl::InternalError(
+          absl::StrCat("Curl failed transfer: ", curl_easy_strerror(result))));
+      continue;
+    }
+    std::move(transfer.callback)(ParseConnectActiveConferenceResponse(
+        transfer.request->GetResponseData()));
+  }
+}
+
+void CurlMultiConnector::FailTransfers(const absl::Status& status) {
+  absl::flat_hash_map<CURL*, Transfer> transfers = std::move(transfers_);
+  transfers_.clear();
+  for (auto& [curl, transfer] : transfers) {
+    curl_api_wrapper_->MultiRemoveHandle(multi_, curl);
+    curl_api_wrapper_->EasyCleanup(curl);
+    std::move(transfer.callback)(status);
+  }
+}
+
+}  // namespace meet
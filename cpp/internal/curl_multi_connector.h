@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_CURL_MULTI_CONNECTOR_H_
+#define CPP_INTERNAL_CURL_MULTI_CONNECTOR_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include <curl/curl.h>
+#include "cpp/internal/curl_request.h"
+#include "cpp/internal/http_connector_interface.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace meet {
+
+// Implementation of `HttpConnectorInterface` that drives requests with a curl
+// multi handle on a single event loop thread.
+//
+// `CurlConnector` blocks a thread for every in-flight request. This connector
+// instead runs any number of concurrent requests on its event loop thread, so
+// one instance can be shared by every client that joins from a host. The multi
+// handle also caches connections, so requests to the same host reuse them and
+// may be multiplexed over HTTP/2.
+//
+// This class is thread-safe, except for `SetCaCertPath`.
+class CurlMultiConnector : public HttpConnectorInterface {
+ public:
+  static absl::StatusOr<std::unique_ptr<CurlMultiConnector>> Create(
+      std::unique_ptr<CurlApiWrapper> curl_api_wrapper);
+
+  // Stops the event loop. Requests still in flight complete with a cancelled
+  // error.
+  ~CurlMultiConnector() override;
+
+  // Blocks until the response is received. Must not be called on the event
+  // loop thread, e.g. from a `ConnectActiveConferenceAsync` callback.
+  absl::StatusOr<std::string> ConnectActiveConference(
+      absl::string_view join_endpoint, absl::string_view conference_id,
+      absl::string_view access_token, absl::string_view sdp_offer) override;
+
+  // Starts the request on the event loop thread and returns immediately.
+  // `callback` is invoked on the event loop thread.
+  void ConnectActiveConferenceAsync(absl::string_view join_endpoint,
+                                    absl::string_view conference_id,
+                                    absl::string_view access_token,
+                                    absl::string_view sdp_offer,
+                                    ConnectCallback callback) override;
+
+  // Sets the path to the CA certificate file to be used by curl.
+  //
+  // Not thread-safe; must be called before any requests are made.
+  void SetCaCertPath(absl::string_view ca_cert_path) {
+    ca_cert_path_ = std::string(ca_cert_path);
+  }
+
+ private:
+  struct Transfer {
+    std::unique_ptr<CurlRequest> request;
+    ConnectCallback callback;
+  };
+
+  CurlMultiConnector(std::unique_ptr<CurlApiWrapper> curl_api_wrapper,
+                     CURLM* multi, std::unique_ptr<rtc::Thread> loop_thread)
+      : curl_api_wrapper_(std::move(curl_api_wrapper)),
+        multi_(multi),
+        loop_thread_(std::move(loop_thread)) {}
+
+  // Adds `request` to the multi handle and starts polling if needed.
+  //
+  // Called on the event loop thread.
+  void StartTransfer(std::unique_ptr<CurlRequest> request,
+                     ConnectCallback callback);
+  // Runs one iteration of the event loop, and schedules the next one while
+  // transfers are in flight.
+  //
+  // Called on the event loop thread.
+  void Poll();
+  // Completes the transfers that curl reports as done.
+  //
+  // Called on the event loop thread.
+  void CompleteFinishedTransfers();
+  // Completes every in-flight transfer with `status`.
+  void FailTransfers(const absl::Status& status);
+
+  std::unique_ptr<CurlApiWrapper> curl_api_wrapper_;
+  std::optional<std::string> ca_cert_path_;
+  CURLM* multi_;
+  // In-flight transfers keyed by their easy handle. Only accessed on the
+  // event loop thread, or after it has stopped.
+  absl::flat_hash_map<CURL*, Transfer> transfers_;
+  // Whether an event loop iteration is scheduled. Only accessed on the event
+  // loop thread.
+  bool polling_ = false;
+  std::unique_ptr<rtc::Thread> loop_thread_;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_CURL_MULTI_CONNECTOR_H_
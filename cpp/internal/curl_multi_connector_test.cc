@@ -0,0 +1,211 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/curl_multi_connector.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/synchronization/notification.h"
+#include <curl/curl.h>
+#include "nlohmann/json.hpp"
+#include "cpp/internal/testing/mock_curl_api_wrapper.h"
+
+namespace meet {
+namespace {
+
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Return;
+
+CURL* const kFirstHandle = reinterpret_cast<CURL*>(0x1);
+CURL* const kSecondHandle = reinterpret_cast<CURL*>(0x2);
+
+// Makes `mock_curl_api` write `answer` as the response of every request.
+void RespondWithAnswer(MockCurlApiWrapper& mock_curl_api,
+                       absl::string_view answer) {
+  nlohmann::basic_json<> response_body;
+  response_body["answer"] = answer;
+  EXPECT_CALL(mock_curl_api, EasySetOptPtr)
+      .WillRepeatedly(Return(CURLE_OK));
+  EXPECT_CALL(mock_curl_api, EasySetOptPtr(_, CURLOPT_WRITEDATA, _))
+      .WillRepeatedly([response = response_body.dump()](
+                          CURL* curl, CURLoption option, void* value) {
+        *static_cast<absl::Cord*>(value) = response;
+        return CURLE_OK;
+      });
+}
+
+TEST(CurlMultiConnectorTest, ReturnsResponse) {
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  RespondWithAnswer(*mock_curl_api, "some sdp answer");
+  EXPECT_CALL(*mock_curl_api, EasyInit()).WillOnce(Return(kFirstHandle));
+  CURLMsg done_message = {.msg = CURLMSG_DONE, .easy_handle = kFirstHandle};
+  done_message.data.result = CURLE_OK;
+  EXPECT_CALL(*mock_curl_api, MultiInfoRead)
+      .WillOnce(Return(&done_message))
+      .WillRepeatedly(Return(nullptr));
+  EXPECT_CALL(*mock_curl_api, MultiAddHandle(_, kFirstHandle));
+  EXPECT_CALL(*mock_curl_api, MultiRemoveHandle(_, kFirstHandle));
+  EXPECT_CALL(*mock_curl_api, EasyCleanup(kFirstHandle));
+  absl::StatusOr<std::unique_ptr<CurlMultiConnector>> connector =
+      CurlMultiConnector::Create(std::move(mock_curl_api));
+  ASSERT_TRUE(connector.ok());
+
+  absl::StatusOr<std::string> response =
+      (*connector)->ConnectActiveConference("https://meet.googleapis.com",
+                                            "abcdefg", "bearer_token",
+                                            "some sdp offer");
+
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ(response.value(), "some sdp answer");
+}
+
+TEST(CurlMultiConnectorTest, RunsConcurrentRequestsOnOneMultiHandle) {
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  MockCurlApiWrapper* mock_curl_api_ptr = mock_curl_api.get();
+  RespondWithAnswer(*mock_curl_api, "some sdp answer");
+  EXPECT_CALL(*mock_curl_api, EasyInit())
+      .WillOnce(Return(kFirstHandle))
+      .WillOnce(Return(kSecondHandle));
+  absl::Notification both_added;
+  int added_handles = 0;
+  EXPECT_CALL(*mock_curl_api, MultiAddHandle)
+      .Times(2)
+      .WillRepeatedly([&](CURLM* multi, CURL* curl) {
+        if (++added_handles == 2) {
+          both_added.Notify();
+        }
+        return CURLM_OK;
+      });
+  CURLMsg first_done = {.msg = CURLMSG_DONE, .easy_handle = kFirstHandle};
+  first_done.data.result = CURLE_OK;
+  CURLMsg second_done = {.msg = CURLMSG_DONE, .easy_handle = kSecondHandle};
+  second_done.data.result = CURLE_OK;
+  absl::StatusOr<std::unique_ptr<CurlMultiConnector>> connector =
+      CurlMultiConnector::Create(std::move(mock_curl_api));
+  ASSERT_TRUE(connector.ok());
+  // Keep both transfers in flight until both have been added.
+  int reads = 0;
+  EXPECT_CALL(*mock_curl_api_ptr, MultiInfoRead)
+      .WillRepeatedly([&](CURLM* multi, int* messages_in_queue) -> CURLMsg* {
+        if (!both_added.HasBeenNotified()) {
+          return nullptr;
+        }
+        switch (reads++) {
+          case 0:
+            return &first_done;
+          case 1:
+            return &second_done;
+          default:
+            return nullptr;
+        }
+      });
+  absl::Notification first_received;
+  absl::Notification second_received;
+  absl::StatusOr<std::string> first_response;
+  absl::StatusOr<std::string> second_response;
+
+  (*connector)->ConnectActiveConferenceAsync(
+      "https://meet.googleapis.com", "abcdefg", "bearer_token",
+      "some sdp offer", [&](absl::StatusOr<std::string> response) {
+        first_response = std::move(response);
+        first_received.Notify();
+      });
+  (*connector)->ConnectActiveConferenceAsync(
+      "https://meet.googleapis.com", "hijklmn", "bearer_token",
+      "some sdp offer", [&](absl::StatusOr<std::string> response) {
+        second_response = std::move(response);
+        second_received.Notify();
+      });
+
+  first_received.WaitForNotification();
+  second_received.WaitForNotification();
+  ASSERT_TRUE(first_response.ok());
+  EXPECT_EQ(first_response.value(), "some sdp answer");
+  ASSERT_TRUE(second_response.ok());
+  EXPECT_EQ(second_response.value(), "some sdp answer");
+}
+
+TEST(CurlMultiConnectorTest, ReturnsErrorWhenTransferFails) {
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  RespondWithAnswer(*mock_curl_api, "some sdp answer");
+  CURLMsg done_message = {.msg = CURLMSG_DONE,
+                          .easy_handle = reinterpret_cast<CURL*>(0xdeadbeef)};
+  done_message.data.result = CURLE_COULDNT_CONNECT;
+  EXPECT_CALL(*mock_curl_api, MultiInfoRead)
+      .WillOnce(Return(&done_message))
+      .WillRepeatedly(Return(nullptr));
+  absl::StatusOr<std::unique_ptr<CurlMultiConnector>> connector =
+      CurlMultiConnector::Create(std::move(mock_curl_api));
+  ASSERT_TRUE(connector.ok());
+
+  absl::StatusOr<std::string> response =
+      (*connector)->ConnectActiveConference("https://meet.googleapis.com",
+                                            "abcdefg", "bearer_token",
+                                            "some sdp offer");
+
+  EXPECT_EQ(response.status().code(), absl::StatusCode::kInternal);
+  EXPECT_THAT(response.status().message(),
+              HasSubstr("Curl failed transfer"));
+}
+
+TEST(CurlMultiConnectorTest, CancelsInFlightRequestsWhenDestroyed) {
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  RespondWithAnswer(*mock_curl_api, "some sdp answer");
+  absl::Notification added;
+  EXPECT_CALL(*mock_curl_api, MultiAddHandle)
+      .WillOnce([&added](CURLM* multi, CURL* curl) {
+        added.Notify();
+        return CURLM_OK;
+      });
+  EXPECT_CALL(*mock_curl_api, MultiInfoRead).WillRepeatedly(Return(nullptr));
+  absl::StatusOr<std::unique_ptr<CurlMultiConnector>> connector =
+      CurlMultiConnector::Create(std::move(mock_curl_api));
+  ASSERT_TRUE(connector.ok());
+  absl::StatusOr<std::string> response;
+  (*connector)->ConnectActiveConferenceAsync(
+      "https://meet.googleapis.com", "abcdefg", "bearer_token",
+      "some sdp offer", [&response](absl::StatusOr<std::string> result) {
+        response = std::move(result);
+      });
+  added.WaitForNotification();
+
+  connector->reset();
+
+  EXPECT_EQ(response.status().code(), absl::StatusCode::kCancelled);
+}
+
+TEST(CurlMultiConnectorTest, CreateFailsIfMultiInitFails) {
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  EXPECT_CALL(*mock_curl_api, MultiInit()).WillOnce(Return(nullptr));
+
+  absl::StatusOr<std::unique_ptr<CurlMultiConnector>> connector =
+      CurlMultiConnector::Create(std::move(mock_curl_api));
+
+  EXPECT_EQ(connector.status().code(), absl::StatusCode::kInternal);
+  EXPECT_THAT(connector.status().message(),
+              HasSubstr("Failed to initialize curl multi"));
+}
+
+}  // namespace
+}  // namespace meet
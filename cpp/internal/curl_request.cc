@@ -18,11 +18,14 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "absl/cleanup/cleanup.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -57,8 +60,78 @@ absl::Status CheckOk(CURLcode code, absl::string_view option) {
   return absl::OkStatus();
 }
 
+absl::Status CheckShareOk(CURLSHcode code, absl::string_view option) {
+  if (code != CURLSHE_OK) {
+    return absl::InternalError(absl::StrCat("Failed to set curl share ", option,
+                                            ": ", curl_share_strerror(code)));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
+absl::StatusOr<std::unique_ptr<CurlConnectionPool>> CurlConnectionPool::Create(
+    std::unique_ptr<CurlApiWrapper> curl_api) {
+  CURLSH* share = curl_api->ShareInit();
+  if (share == nullptr) {
+    return absl::InternalError("Failed to initialize curl share");
+  }
+  // The pool owns `share` from here on, so errors below clean it up.
+  std::unique_ptr<CurlConnectionPool> pool(
+      new CurlConnectionPool(std::move(curl_api), share));
+  CurlApiWrapper& api = *pool->curl_api_;
+
+  if (absl::Status opt_status = CheckShareOk(
+          api.ShareSetOptCallback(share, CURLSHOPT_LOCKFUNC, &Lock),
+          "lock function");
+      !opt_status.ok()) {
+    return opt_status;
+  }
+  if (absl::Status opt_status = CheckShareOk(
+          api.ShareSetOptCallback(share, CURLSHOPT_UNLOCKFUNC, &Unlock),
+          "unlock function");
+      !opt_status.ok()) {
+    return opt_status;
+  }
+  if (absl::Status opt_status = CheckShareOk(
+          api.ShareSetOptPtr(share, CURLSHOPT_USERDATA, pool.get()),
+          "user data");
+      !opt_status.ok()) {
+    return opt_status;
+  }
+  for (curl_lock_data data : {CURL_LOCK_DATA_DNS, CURL_LOCK_DATA_SSL_SESSION}) {
+    if (absl::Status opt_status = CheckShareOk(
+            api.ShareSetOptInt(share, CURLSHOPT_SHARE, data), "shared data");
+        !opt_status.ok()) {
+      return opt_status;
+    }
+  }
+  return pool;
+}
+
+CurlConnectionPool::~CurlConnectionPool() {
+  if (CURLSHcode code = curl_api_->ShareCleanup(share_); code != CURLSHE_OK) {
+    LOG(ERROR) << "Failed to clean up curl share: "
+               << curl_share_strerror(code);
+  }
+}
+
+void CurlConnectionPool::Lock(CURL* /* curl */, curl_lock_data data,
+                              curl_lock_access /* access */, void* userptr) {
+  static_cast<CurlConnectionPool*>(userptr)->mutexes_[data].Lock();
+}
+
+void CurlConnectionPool::Unlock(CURL* /* curl */, curl_lock_data data,
+                                void* userptr) {
+  static_cast<CurlConnectionPool*>(userptr)->mutexes_[data].Unlock();
+}
+
+CurlRequest::~CurlRequest() {
+  if (headers_ != nullptr) {
+    curl_api_.SListFreeAll(headers_);
+  }
+}
+
 absl::Status CurlRequest::Send() {
   if (!response_data_.empty()) {
     return absl::InternalError(
@@ -72,6 +145,19 @@ absl::Status CurlRequest::Send() {
 
   absl::Cleanup cleanup_curl = [&] { curl_api_.EasyCleanup(curl); };
 
+  if (absl::Status prepare_status = Prepare(curl); !prepare_status.ok()) {
+    return prepare_status;
+  }
+
+  CURLcode send_result = curl_api_.EasyPerform(curl);
+  if (send_result != CURLE_OK) {
+    return absl::InternalError(absl::StrCat("Curl failed easy perform: ",
+                                            curl_easy_strerror(send_result)));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CurlRequest::Prepare(CURL* curl) {
   if (request_parameters_.headers.empty()) {
     return absl::InvalidArgumentError("Request headers are empty");
   }
@@ -81,11 +167,15 @@ absl::Status CurlRequest::Send() {
     std::string formatted_request_header = header.first + ": " + header.second;
     headers = curl_api_.SListAppend(headers, formatted_request_header.c_str());
   }
-
-  absl::Cleanup cleanup_headers = [&] { curl_api_.SListFreeAll(headers); };
+  // curl reads the headers while the request is in flight, so they are freed
+  // with the request rather than here.
+  if (headers_ != nullptr) {
+    curl_api_.SListFreeAll(headers_);
+  }
+  headers_ = headers;
 
   if (absl::Status opt_status =
-          CheckOk(curl_api_.EasySetOptPtr(curl, CURLOPT_HTTPHEADER, headers),
+          CheckOk(curl_api_.EasySetOptPtr(curl, CURLOPT_HTTPHEADER, headers_),
                   "http header");
       !opt_status.ok()) {
     return opt_status;
@@ -145,11 +235,22 @@ absl::Status CurlRequest::Send() {
     }
   }
 
-  CURLcode send_result = curl_api_.EasyPerform(curl);
-  if (send_result != CURLE_OK) {
-    return absl::InternalError(absl::StrCat("Curl failed easy perform: ",
-                                            curl_easy_strerror(send_result)));
+  if (share_ != nullptr) {
+    if (absl::Status opt_status =
+            CheckOk(curl_api_.EasySetOptPtr(curl, CURLOPT_SHARE, share_),
+                    "share");
+        !opt_status.ok()) {
+      return opt_status;
+    }
+    if (absl::Status opt_status =
+            CheckOk(curl_api_.EasySetOptInt(curl, CURLOPT_HTTP_VERSION,
+                                            CURL_HTTP_VERSION_2TLS),
+                    "http version");
+        !opt_status.ok()) {
+      return opt_status;
+    }
   }
+
   return absl::OkStatus();
 }
 
@@ -194,4 +295,57 @@ void CurlApiWrapper::SListFreeAll(struct curl_slist* list) {
   curl_slist_free_all(list);
 }
 
+CURLM* CurlApiWrapper::MultiInit() { return curl_multi_init(); }
+
+CURLMcode CurlApiWrapper::MultiCleanup(CURLM* multi) {
+  return curl_multi_cleanup(multi);
+}
+
+CURLMcode CurlApiWrapper::MultiAddHandle(CURLM* multi, CURL* curl) {
+  return curl_multi_add_handle(multi, curl);
+}
+
+CURLMcode CurlApiWrapper::MultiRemoveHandle(CURLM* multi, CURL* curl) {
+  return curl_multi_remove_handle(multi, curl);
+}
+
+CURLMcode CurlApiWrapper::MultiPerform(CURLM* multi, int* running_handles) {
+  return curl_multi_perform(multi, running_handles);
+}
+
+CURLMcode CurlApiWrapper::MultiPoll(CURLM* multi, int timeout_ms) {
+  return curl_multi_poll(multi, /*extra_fds=*/nullptr, /*extra_nfds=*/0,
+                         timeout_ms, /*numfds=*/nullptr);
+}
+
+CURLMcode CurlApiWrapper::MultiWakeup(CURLM* multi) {
+  return curl_multi_wakeup(multi);
+}
+
+CURLMsg* CurlApiWrapper::MultiInfoRead(CURLM* multi, int* messages_in_queue) {
+  return curl_multi_info_read(multi, messages_in_queue);
+}
+
+CURLSH* CurlApiWrapper::ShareInit() { return curl_share_init(); }
+
+CURLSHcode CurlApiWrapper::ShareCleanup(CURLSH* share) {
+  return curl_share_cleanup(share);
+}
+
+CURLSHcode CurlApiWrapper::ShareSetOptInt(CURLSH* share, CURLSHoption option,
+                                          int value) {
+  return curl_share_setopt(share, option, value);
+}
+
+CURLSHcode CurlApiWrapper::ShareSetOptPtr(CURLSH* share, CURLSHoption option,
+                                          void* value) {
+  return curl_share_setopt(share, option, value);
+}
+
+CURLSHcode CurlApiWrapper::ShareSetOptCallback(CURLSH* share,
+                                               CURLSHoption option,
+                                               intptr_t address) {
+  return curl_share_setopt(share, option, address);
+}
+
 }  // namespace meet
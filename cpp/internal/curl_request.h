@@ -26,15 +26,20 @@
 //
 // It's just for making requests.
 
+#include <array>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include <curl/curl.h>
 #include <curl/curl.h>
 
@@ -70,6 +75,70 @@ class CurlApiWrapper {
   virtual struct curl_slist* SListAppend(struct curl_slist* list,
                                          const char* value);
   virtual void SListFreeAll(struct curl_slist* list);
+
+  virtual CURLM* MultiInit();
+  virtual CURLMcode MultiCleanup(CURLM* multi);
+  virtual CURLMcode MultiAddHandle(CURLM* multi, CURL* curl);
+  virtual CURLMcode MultiRemoveHandle(CURLM* multi, CURL* curl);
+  virtual CURLMcode MultiPerform(CURLM* multi, int* running_handles);
+  virtual CURLMcode MultiPoll(CURLM* multi, int timeout_ms);
+  virtual CURLMcode MultiWakeup(CURLM* multi);
+  virtual CURLMsg* MultiInfoRead(CURLM* multi, int* messages_in_queue);
+
+  virtual CURLSH* ShareInit();
+  virtual CURLSHcode ShareCleanup(CURLSH* share);
+  virtual CURLSHcode ShareSetOptInt(CURLSH* share, CURLSHoption option,
+                                    int value);
+  virtual CURLSHcode ShareSetOptPtr(CURLSH* share, CURLSHoption option,
+                                    void* value);
+  virtual CURLSHcode ShareSetOptCallback(CURLSH* share, CURLSHoption option,
+                                         intptr_t address);
+
+  // A type-safe wrapper around share function callback options.
+  template <typename R, typename... Args>
+  inline CURLSHcode ShareSetOptCallback(CURLSH* share, CURLSHoption option,
+                                        R (*callback)(Args...)) {
+    return ShareSetOptCallback(share, option,
+                               reinterpret_cast<intptr_t>(callback));
+  }
+};
+
+// Shares curl's DNS and TLS session caches between requests.
+//
+// Requests sent with the same pool skip repeated DNS lookups and resume TLS
+// sessions, which shortens the handshake of each new connection. Connections
+// themselves are not shared, since curl does not support sharing its
+// connection cache between concurrent threads. The pool is thread-safe: curl
+// locks each shared cache through the callbacks installed here, so requests
+// using the same pool may be sent concurrently from different threads. The
+// pool must outlive every request that uses it.
+class CurlConnectionPool {
+ public:
+  static absl::StatusOr<std::unique_ptr<CurlConnectionPool>> Create(
+      std::unique_ptr<CurlApiWrapper> curl_api);
+
+  ~CurlConnectionPool();
+
+  // CurlConnectionPool is neither copyable nor movable.
+  CurlConnectionPool(const CurlConnectionPool&) = delete;
+  CurlConnectionPool& operator=(const CurlConnectionPool&) = delete;
+
+  CURLSH* share() const { return share_; }
+
+ private:
+  CurlConnectionPool(std::unique_ptr<CurlApiWrapper> curl_api, CURLSH* share)
+      : curl_api_(std::move(curl_api)), share_(share) {}
+
+  static void Lock(CURL* curl, curl_lock_data data, curl_lock_access access,
+                   void* userptr) ABSL_NO_THREAD_SAFETY_ANALYSIS;
+  static void Unlock(CURL* curl, curl_lock_data data,
+                     void* userptr) ABSL_NO_THREAD_SAFETY_ANALYSIS;
+
+  std::unique_ptr<CurlApiWrapper> curl_api_;
+  CURLSH* share_;
+  // One mutex per kind of shared data, so that e.g. DNS lookups do not contend
+  // with TLS session cache accesses.
+  std::array<absl::Mutex, CURL_LOCK_DATA_LAST> mutexes_;
 };
 
 // Generic CurlRequest implementation for making requests to servers.
@@ -100,9 +169,21 @@ class CurlRequest {
   };
 
   explicit CurlRequest(CurlApiWrapper& curl_api) : curl_api_(curl_api) {};
+  ~CurlRequest();
 
+  // CurlRequest is neither copyable nor movable, as curl holds pointers to its
+  // response buffer and headers while the request is in flight.
+  CurlRequest(const CurlRequest&) = delete;
+  CurlRequest& operator=(const CurlRequest&) = delete;
+
+  // Sends the request and blocks until the response is received.
   absl::Status Send();
 
+  // Configures `curl` to send this request without sending it, so that the
+  // caller can drive the transfer, e.g. with a curl multi handle. The request
+  // must outlive the transfer.
+  absl::Status Prepare(CURL* curl);
+
   std::string GetResponseData() const { return std::string(response_data_); };
   void SetRequestUrl(std::string url) {
     request_parameters_.url = std::move(url);
@@ -119,6 +200,11 @@ class CurlRequest {
   void SetCaCertPath(absl::string_view ca_cert_path) {
     ca_cert_path_ = std::string(ca_cert_path);
   }
+  // Sends the request using the caches shared by `connection_pool`, and
+  // prefers HTTP/2 so that the reused connection can be multiplexed.
+  void SetConnectionPool(const CurlConnectionPool& connection_pool) {
+    share_ = connection_pool.share();
+  }
 
  private:
   static CURLoption RequestMethodToCurlOption(Method method) {
@@ -145,6 +231,8 @@ class CurlRequest {
   std::string error_message_;
   CurlApiWrapper& curl_api_;
   std::optional<std::string> ca_cert_path_;
+  CURLSH* share_ = nullptr;
+  struct curl_slist* headers_ = nullptr;
 };
 
 }  // namespace meet
@@ -16,11 +16,14 @@
 
 #include "cpp/internal/curl_request.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include <curl/curl.h>
 #include "cpp/internal/testing/mock_curl_api_wrapper.h"
@@ -336,5 +339,88 @@ TEST(CurlRequestTest, ReusedRequestReturnsError) {
                         "another curl request"));
 }
 
+TEST(CurlRequestTest, ConnectionPoolSharesCaches) {
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  EXPECT_CALL(*mock_curl_api, ShareSetOptCallback(_, CURLSHOPT_LOCKFUNC, _))
+      .WillOnce(Return(CURLSHE_OK));
+  EXPECT_CALL(*mock_curl_api, ShareSetOptCallback(_, CURLSHOPT_UNLOCKFUNC, _))
+      .WillOnce(Return(CURLSHE_OK));
+  EXPECT_CALL(*mock_curl_api,
+              ShareSetOptInt(_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS))
+      .WillOnce(Return(CURLSHE_OK));
+  EXPECT_CALL(*mock_curl_api,
+              ShareSetOptInt(_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION))
+      .WillOnce(Return(CURLSHE_OK));
+  // Connections cannot be shared between concurrent threads.
+  EXPECT_CALL(*mock_curl_api,
+              ShareSetOptInt(_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT))
+      .Times(0);
+  EXPECT_CALL(*mock_curl_api, ShareCleanup).WillOnce(Return(CURLSHE_OK));
+
+  absl::StatusOr<std::unique_ptr<CurlConnectionPool>> pool =
+      CurlConnectionPool::Create(std::move(mock_curl_api));
+
+  ASSERT_TRUE(pool.ok());
+  EXPECT_NE((*pool)->share(), nullptr);
+}
+
+TEST(CurlRequestTest, FailureToInitCurlShareReturnsError) {
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  EXPECT_CALL(*mock_curl_api, ShareInit()).WillOnce(Return(nullptr));
+  EXPECT_CALL(*mock_curl_api, ShareCleanup).Times(0);
+
+  absl::StatusOr<std::unique_ptr<CurlConnectionPool>> pool =
+      CurlConnectionPool::Create(std::move(mock_curl_api));
+
+  EXPECT_EQ(pool.status().code(), absl::StatusCode::kInternal);
+  EXPECT_THAT(pool.status().message(),
+              HasSubstr("Failed to initialize curl share"));
+}
+
+TEST(CurlRequestTest, FailureToSetCurlShareOptionReturnsError) {
+  auto mock_curl_api = std::make_unique<MockCurlApiWrapper>();
+  EXPECT_CALL(*mock_curl_api, ShareSetOptInt)
+      .WillRepeatedly(Return(CURLSHE_OK));
+  EXPECT_CALL(*mock_curl_api,
+              ShareSetOptInt(_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION))
+      .WillOnce(Return(CURLSHE_NOT_BUILT_IN));
+  // The share handle is still cleaned up if configuring it fails.
+  EXPECT_CALL(*mock_curl_api, ShareCleanup).WillOnce(Return(CURLSHE_OK));
+
+  absl::StatusOr<std::unique_ptr<CurlConnectionPool>> pool =
+      CurlConnectionPool::Create(std::move(mock_curl_api));
+
+  EXPECT_EQ(pool.status().code(), absl::StatusCode::kInternal);
+  EXPECT_THAT(pool.status().message(),
+              HasSubstr("Failed to set curl share shared data"));
+}
+
+TEST(CurlRequestTest, RequestWithConnectionPoolUsesSharedCachesAndHttp2) {
+  absl::StatusOr<std::unique_ptr<CurlConnectionPool>> pool =
+      CurlConnectionPool::Create(std::make_unique<MockCurlApiWrapper>());
+  ASSERT_TRUE(pool.ok());
+  MockCurlApiWrapper mock_curl_api;
+  EXPECT_CALL(mock_curl_api, EasySetOptPtr(_, CURLOPT_HTTPHEADER, _))
+      .WillOnce(Return(CURLE_OK));
+  EXPECT_CALL(mock_curl_api, EasySetOptPtr(_, CURLOPT_WRITEDATA, _))
+      .WillOnce(Return(CURLE_OK));
+  EXPECT_CALL(mock_curl_api, EasySetOptPtr(_, CURLOPT_SHARE, (*pool)->share()))
+      .WillOnce(Return(CURLE_OK));
+  EXPECT_CALL(mock_curl_api, EasySetOptInt(_, CURLOPT_POST, 1))
+      .WillOnce(Return(CURLE_OK));
+  EXPECT_CALL(mock_curl_api,
+              EasySetOptInt(_, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS))
+      .WillOnce(Return(CURLE_OK));
+  CurlRequest request(mock_curl_api);
+  request.SetRequestUrl("www.this_is_sparta.com");
+  request.SetRequestHeader("Authorization", "Bearer iliketurtles");
+  request.SetRequestBody("{\"offer\": \"some random sdp offer\"}");
+  request.SetConnectionPool(**pool);
+
+  absl::Status request_status = request.Send();
+
+  EXPECT_TRUE(request_status.ok());
+}
+
 }  // namespace
 }  // namespace meet
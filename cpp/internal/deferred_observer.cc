@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/deferred_observer.h"
+
+#include <utility>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/scoped_refptr.h"
+
+namespace meet {
+
+void DeferredObserver::SetObserver(
+    rtc::scoped_refptr<MediaApiClientObserverInterface> observer) {
+  absl::MutexLock lock(&mutex_);
+  DCHECK(observer_ == nullptr);
+  observer_ = std::move(observer);
+}
+
+rtc::scoped_refptr<MediaApiClientObserverInterface>
+DeferredObserver::GetObserver() const {
+  absl::MutexLock lock(&mutex_);
+  return observer_;
+}
+
+void DeferredObserver::OnJoined() {
+  if (auto observer = GetObserver(); observer != nullptr) {
+    observer->OnJoined();
+  }
+}
+
+void DeferredObserver::OnJoined(const JoinTimings& timings) {
+  if (auto observer = GetObserver(); observer != nullptr) {
+    observer->OnJoined(timings);
+  }
+}
+
+void DeferredObserver::OnDisconnected(absl::Status status) {
+  if (auto observer = GetObserver(); observer != nullptr) {
+    observer->OnDisconnected(std::move(status));
+  }
+}
+
+void DeferredObserver::OnResourceUpdate(ResourceUpdate update) {
+  if (auto observer = GetObserver(); observer != nullptr) {
+    observer->OnResourceUpdate(std::move(update));
+  }
+}
+
+void DeferredObserver::OnAudioFrame(AudioFrame frame) {
+  if (auto observer = GetObserver(); observer != nullptr) {
+    observer->OnAudioFrame(std::move(frame));
+  }
+}
+
+void DeferredObserver::OnEncodedAudioFrame(EncodedAudioFrame frame) {
+  if (auto observer = GetObserver(); observer != nullptr) {
+    observer->OnEncodedAudioFrame(std::move(frame));
+  }
+}
+
+void DeferredObserver::OnVideoFrame(VideoFrame frame) {
+  if (auto observer = GetObserver(); observer != nullptr) {
+    observer->OnVideoFrame(std::move(frame));
+  }
+}
+
+void DeferredObserver::OnEncodedVideoFrame(EncodedVideoFrame frame) {
+  if (auto observer = GetObserver(); observer != nullptr) {
+    observer->OnEncodedVideoFrame(std::move(frame));
+  }
+}
+
+}  // namespace meet
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_DEFERRED_OBSERVER_H_
+#define CPP_INTERNAL_DEFERRED_OBSERVER_H_
+
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/scoped_refptr.h"
+
+namespace meet {
+
+// An observer that forwards callbacks to an observer that is provided after
+// the client is created.
+//
+// This allows clients to be created before the application that will use them
+// is known, e.g. for pre-created clients in a pool. Callbacks invoked before
+// the observer is set are dropped.
+class DeferredObserver : public MediaApiClientObserverInterface {
+ public:
+  // Sets the observer that callbacks are forwarded to. This may be called at
+  // most once.
+  void SetObserver(
+      rtc::scoped_refptr<MediaApiClientObserverInterface> observer);
+
+  void OnJoined() override;
+  void OnJoined(const JoinTimings& timings) override;
+  void OnDisconnected(absl::Status status) override;
+  void OnResourceUpdate(ResourceUpdate update) override;
+  void OnAudioFrame(AudioFrame frame) override;
+  void OnEncodedAudioFrame(EncodedAudioFrame frame) override;
+  void OnVideoFrame(VideoFrame frame) override;
+  void OnEncodedVideoFrame(EncodedVideoFrame frame) override;
+
+ private:
+  rtc::scoped_refptr<MediaApiClientObserverInterface> GetObserver() const;
+
+  mutable absl::Mutex mutex_;
+  rtc::scoped_refptr<MediaApiClientObserverInterface> observer_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_DEFERRED_OBSERVER_H_
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/deferred_observer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/testing/mock_media_api_client_observer.h"
+#include "webrtc/api/make_ref_counted.h"
+
+namespace meet {
+namespace {
+
+TEST(DeferredObserverTest, DropsCallbacksBeforeObserverIsSet) {
+  auto deferred_observer = rtc::make_ref_counted<DeferredObserver>();
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnDisconnected).Times(0);
+
+  deferred_observer->OnDisconnected(absl::InternalError("closed"));
+  deferred_observer->SetObserver(observer);
+}
+
+TEST(DeferredObserverTest, ForwardsCallbacksAfterObserverIsSet) {
+  auto deferred_observer = rtc::make_ref_counted<DeferredObserver>();
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnJoined);
+  EXPECT_CALL(*observer, OnEncodedVideoFrame);
+  EXPECT_CALL(*observer, OnDisconnected(absl::OkStatus()));
+
+  deferred_observer->SetObserver(observer);
+  deferred_observer->OnJoined();
+  deferred_observer->OnEncodedVideoFrame(EncodedVideoFrame{});
+  deferred_observer->OnDisconnected(absl::OkStatus());
+}
+
+}  // namespace
+}  // namespace meet
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/encoded_audio_frame_transformer.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/conference_media_tracks.h"
+#include "webrtc/api/array_view.h"
+#include "webrtc/api/frame_transformer_interface.h"
+
+namespace meet {
+
+void EncodedAudioFrameTransformer::Transform(
+    std::unique_ptr<webrtc::TransformableFrameInterface> transformable_frame) {
+  if (transformable_frame->GetDirection() !=
+      webrtc::TransformableFrameInterface::Direction::kReceiver) {
+    LOG(WARNING) << "Ignoring frame that was not received.";
+    return;
+  }
+
+  // This transformer is only installed on audio receivers.
+  auto* audio_frame = static_cast<webrtc::TransformableAudioFrameInterface*>(
+      transformable_frame.get());
+
+  // Meet sends 1 or 2 contributing sources: the participant's and, if the
+  // participant is the loudest speaker, `kLoudestSpeakerCsrc`.
+  std::optional<uint32_t> contributing_source;
+  bool is_from_loudest_speaker = false;
+  for (uint32_t csrc : audio_frame->GetContributingSources()) {
+    if (csrc == kLoudestSpeakerCsrc) {
+      is_from_loudest_speaker = true;
+    } else {
+      contributing_source = csrc;
+    }
+  }
+  if (!contributing_source.has_value()) {
+    VLOG(2) << "Encoded audio frame is missing contributing source. Skipping.";
+    return;
+  }
+
+  rtc::ArrayView<const uint8_t> payload = audio_frame->GetData();
+  frame_callback_(EncodedAudioFrame{
+      .payload = std::vector<uint8_t>(payload.begin(), payload.end()),
+      .payload_type = audio_frame->GetPayloadType(),
+      .rtp_timestamp = audio_frame->GetTimestamp(),
+      .sequence_number = audio_frame->SequenceNumber(),
+      .is_from_loudest_speaker = is_from_loudest_speaker,
+      .contributing_source = *contributing_source,
+      .synchronization_source = audio_frame->GetSsrc()});
+}
+
+}  // namespace meet
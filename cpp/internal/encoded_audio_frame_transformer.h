@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_ENCODED_AUDIO_FRAME_TRANSFORMER_H_
+#define CPP_INTERNAL_ENCODED_AUDIO_FRAME_TRANSFORMER_H_
+
+#include <memory>
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/frame_transformer_interface.h"
+
+namespace meet {
+
+// A frame transformer that delivers the encoded payloads of received audio
+// packets instead of passing them on to be decoded.
+//
+// When installed as the depacketizer to decoder frame transformer of an audio
+// receiver, every received packet is handed to this transformer before
+// decoding. Since frames are never returned to WebRTC, no audio is decoded and
+// the receiver's audio track sinks are never invoked.
+//
+// Frames are transformed on WebRTC's internal threads, so `frame_callback`
+// must be thread-safe.
+class EncodedAudioFrameTransformer : public webrtc::FrameTransformerInterface {
+ public:
+  using EncodedAudioFrameCallback =
+      absl::AnyInvocable<void(EncodedAudioFrame frame)>;
+
+  explicit EncodedAudioFrameTransformer(
+      EncodedAudioFrameCallback frame_callback)
+      : frame_callback_(std::move(frame_callback)) {}
+
+  // EncodedAudioFrameTransformer is neither copyable nor movable.
+  EncodedAudioFrameTransformer(const EncodedAudioFrameTransformer&) = delete;
+  EncodedAudioFrameTransformer& operator=(const EncodedAudioFrameTransformer&) =
+      delete;
+
+  void Transform(std::unique_ptr<webrtc::TransformableFrameInterface>
+                     transformable_frame) override;
+
+ private:
+  EncodedAudioFrameCallback frame_callback_;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_ENCODED_AUDIO_FRAME_TRANSFORMER_H_
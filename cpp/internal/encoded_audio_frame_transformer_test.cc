@@ -0,0 +1,122 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/encoded_audio_frame_transformer.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/conference_media_tracks.h"
+#include "webrtc/api/array_view.h"
+#include "webrtc/api/frame_transformer_interface.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/test/mock_transformable_audio_frame.h"
+
+namespace meet {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+std::unique_ptr<webrtc::MockTransformableAudioFrame> CreateReceivedFrame(
+    const std::vector<uint8_t>& payload, const std::vector<uint32_t>& csrcs) {
+  auto frame =
+      std::make_unique<NiceMock<webrtc::MockTransformableAudioFrame>>();
+  ON_CALL(*frame, GetDirection)
+      .WillByDefault(
+          Return(webrtc::TransformableFrameInterface::Direction::kReceiver));
+  ON_CALL(*frame, GetData)
+      .WillByDefault(Return(rtc::ArrayView<const uint8_t>(payload)));
+  ON_CALL(*frame, GetContributingSources)
+      .WillByDefault(Return(rtc::ArrayView<const uint32_t>(csrcs)));
+  ON_CALL(*frame, GetPayloadType).WillByDefault(Return(111));
+  ON_CALL(*frame, GetTimestamp).WillByDefault(Return(960));
+  ON_CALL(*frame, GetSsrc).WillByDefault(Return(456));
+  ON_CALL(*frame, SequenceNumber).WillByDefault(Return(7));
+  return frame;
+}
+
+TEST(EncodedAudioFrameTransformerTest, DeliversReceivedFrames) {
+  std::optional<EncodedAudioFrame> received_frame;
+  auto transformer = rtc::make_ref_counted<EncodedAudioFrameTransformer>(
+      [&](EncodedAudioFrame frame) { received_frame = std::move(frame); });
+  std::vector<uint8_t> payload = {1, 2, 3};
+  std::vector<uint32_t> csrcs = {123};
+
+  transformer->Transform(CreateReceivedFrame(payload, csrcs));
+
+  ASSERT_TRUE(received_frame.has_value());
+  EXPECT_THAT(received_frame->payload, ElementsAre(1, 2, 3));
+  EXPECT_EQ(received_frame->payload_type, 111);
+  EXPECT_EQ(received_frame->rtp_timestamp, 960);
+  EXPECT_EQ(received_frame->sequence_number, 7);
+  EXPECT_FALSE(received_frame->is_from_loudest_speaker);
+  EXPECT_EQ(received_frame->contributing_source, 123);
+  EXPECT_EQ(received_frame->synchronization_source, 456);
+}
+
+TEST(EncodedAudioFrameTransformerTest, DeliversLoudestSpeakerFrames) {
+  std::optional<EncodedAudioFrame> received_frame;
+  auto transformer = rtc::make_ref_counted<EncodedAudioFrameTransformer>(
+      [&](EncodedAudioFrame frame) { received_frame = std::move(frame); });
+  std::vector<uint8_t> payload = {1, 2, 3};
+  std::vector<uint32_t> csrcs = {kLoudestSpeakerCsrc, 123};
+
+  transformer->Transform(CreateReceivedFrame(payload, csrcs));
+
+  ASSERT_TRUE(received_frame.has_value());
+  EXPECT_TRUE(received_frame->is_from_loudest_speaker);
+  EXPECT_EQ(received_frame->contributing_source, 123);
+}
+
+TEST(EncodedAudioFrameTransformerTest, SkipsFramesWithoutContributingSource) {
+  bool frame_received = false;
+  auto transformer = rtc::make_ref_counted<EncodedAudioFrameTransformer>(
+      [&](EncodedAudioFrame frame) { frame_received = true; });
+  std::vector<uint8_t> payload = {1, 2, 3};
+  std::vector<uint32_t> csrcs = {kLoudestSpeakerCsrc};
+
+  transformer->Transform(CreateReceivedFrame(payload, csrcs));
+
+  EXPECT_FALSE(frame_received);
+}
+
+TEST(EncodedAudioFrameTransformerTest, SkipsFramesThatWereNotReceived) {
+  bool frame_received = false;
+  auto transformer = rtc::make_ref_counted<EncodedAudioFrameTransformer>(
+      [&](EncodedAudioFrame frame) { frame_received = true; });
+  std::vector<uint8_t> payload = {1, 2, 3};
+  std::vector<uint32_t> csrcs = {123};
+  std::unique_ptr<webrtc::MockTransformableAudioFrame> frame =
+      CreateReceivedFrame(payload, csrcs);
+  ON_CALL(*frame, GetDirection)
+      .WillByDefault(
+          Return(webrtc::TransformableFrameInterface::Direction::kSender));
+
+  transformer->Transform(std::move(frame));
+
+  EXPECT_FALSE(frame_received);
+}
+
+}  // namespace
+}  // namespace meet
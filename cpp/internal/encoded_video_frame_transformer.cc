@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/encoded_video_frame_transformer.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/array_view.h"
+#include "webrtc/api/frame_transformer_interface.h"
+#include "webrtc/api/video/video_frame_metadata.h"
+
+namespace meet {
+
+void EncodedVideoFrameTransformer::Transform(
+    std::unique_ptr<webrtc::TransformableFrameInterface> transformable_frame) {
+  if (transformable_frame->GetDirection() !=
+      webrtc::TransformableFrameInterface::Direction::kReceiver) {
+    LOG(WARNING) << "Ignoring frame that was not received.";
+    return;
+  }
+
+  // This transformer is only installed on video receivers.
+  auto* video_frame = static_cast<webrtc::TransformableVideoFrameInterface*>(
+      transformable_frame.get());
+  webrtc::VideoFrameMetadata metadata = video_frame->Metadata();
+
+  // It is expected that there will be exactly one contributing source.
+  if (metadata.GetCsrcs().empty()) {
+    VLOG(2) << "Encoded video frame is missing contributing source. Skipping.";
+    return;
+  }
+
+  rtc::ArrayView<const uint8_t> data = video_frame->GetData();
+  frame_callback_(EncodedVideoFrame{
+      .data = std::vector<uint8_t>(data.begin(), data.end()),
+      .mime_type = video_frame->GetMimeType(),
+      .is_key_frame = video_frame->IsKeyFrame(),
+      .rtp_timestamp = video_frame->GetTimestamp(),
+      .width = metadata.GetWidth(),
+      .height = metadata.GetHeight(),
+      .contributing_source = metadata.GetCsrcs().front(),
+      .synchronization_source = video_frame->GetSsrc()});
+}
+
+}  // namespace meet
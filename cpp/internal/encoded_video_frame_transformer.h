@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_ENCODED_VIDEO_FRAME_TRANSFORMER_H_
+#define CPP_INTERNAL_ENCODED_VIDEO_FRAME_TRANSFORMER_H_
+
+#include <memory>
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/frame_transformer_interface.h"
+
+namespace meet {
+
+// A frame transformer that delivers received encoded video frames instead of
+// passing them on to be decoded.
+//
+// When installed as the depacketizer to decoder frame transformer of a video
+// receiver, every received frame is handed to this transformer once all of its
+// packets have been received. Since frames are never returned to WebRTC, no
+// video is decoded and the receiver's video track sinks are never invoked.
+//
+// Frames are transformed on WebRTC's internal threads, so `frame_callback`
+// must be thread-safe.
+class EncodedVideoFrameTransformer : public webrtc::FrameTransformerInterface {
+ public:
+  using EncodedVideoFrameCallback =
+      absl::AnyInvocable<void(EncodedVideoFrame frame)>;
+
+  explicit EncodedVideoFrameTransformer(
+      EncodedVideoFrameCallback frame_callback)
+      : frame_callback_(std::move(frame_callback)) {}
+
+  // EncodedVideoFrameTransformer is neither copyable nor movable.
+  EncodedVideoFrameTransformer(const EncodedVideoFrameTransformer&) = delete;
+  EncodedVideoFrameTransformer& operator=(const EncodedVideoFrameTransformer&) =
+      delete;
+
+  void Transform(std::unique_ptr<webrtc::TransformableFrameInterface>
+                     transformable_frame) override;
+
+ private:
+  EncodedVideoFrameCallback frame_callback_;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_ENCODED_VIDEO_FRAME_TRANSFORMER_H_
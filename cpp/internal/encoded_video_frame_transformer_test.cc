@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/encoded_video_frame_transformer.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/array_view.h"
+#include "webrtc/api/frame_transformer_interface.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/test/mock_transformable_video_frame.h"
+#include "webrtc/api/video/video_frame_metadata.h"
+
+namespace meet {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+std::unique_ptr<webrtc::MockTransformableVideoFrame> CreateReceivedFrame(
+    const std::vector<uint8_t>& data, std::vector<uint32_t> csrcs) {
+  auto frame =
+      std::make_unique<NiceMock<webrtc::MockTransformableVideoFrame>>();
+  webrtc::VideoFrameMetadata metadata;
+  metadata.SetWidth(1280);
+  metadata.SetHeight(720);
+  metadata.SetCsrcs(std::move(csrcs));
+  ON_CALL(*frame, GetDirection)
+      .WillByDefault(
+          Return(webrtc::TransformableFrameInterface::Direction::kReceiver));
+  ON_CALL(*frame, GetData)
+      .WillByDefault(Return(rtc::ArrayView<const uint8_t>(data)));
+  ON_CALL(*frame, Metadata).WillByDefault(Return(metadata));
+  ON_CALL(*frame, GetMimeType).WillByDefault(Return("video/VP8"));
+  ON_CALL(*frame, IsKeyFrame).WillByDefault(Return(true));
+  ON_CALL(*frame, GetTimestamp).WillByDefault(Return(3000));
+  ON_CALL(*frame, GetSsrc).WillByDefault(Return(456));
+  return frame;
+}
+
+TEST(EncodedVideoFrameTransformerTest, DeliversReceivedFrames) {
+  std::optional<EncodedVideoFrame> received_frame;
+  auto transformer = rtc::make_ref_counted<EncodedVideoFrameTransformer>(
+      [&](EncodedVideoFrame frame) { received_frame = std::move(frame); });
+  std::vector<uint8_t> data = {1, 2, 3};
+
+  transformer->Transform(CreateReceivedFrame(data, /*csrcs=*/{123}));
+
+  ASSERT_TRUE(received_frame.has_value());
+  EXPECT_THAT(received_frame->data, ElementsAre(1, 2, 3));
+  EXPECT_EQ(received_frame->mime_type, "video/VP8");
+  EXPECT_TRUE(received_frame->is_key_frame);
+  EXPECT_EQ(received_frame->rtp_timestamp, 3000);
+  EXPECT_EQ(received_frame->width, 1280);
+  EXPECT_EQ(received_frame->height, 720);
+  EXPECT_EQ(received_frame->contributing_source, 123);
+  EXPECT_EQ(received_frame->synchronization_source, 456);
+}
+
+TEST(EncodedVideoFrameTransformerTest, SkipsFramesWithoutContributingSource) {
+  bool frame_received = false;
+  auto transformer = rtc::make_ref_counted<EncodedVideoFrameTransformer>(
+      [&](EncodedVideoFrame frame) { frame_received = true; });
+  std::vector<uint8_t> data = {1, 2, 3};
+
+  transformer->Transform(CreateReceivedFrame(data, /*csrcs=*/{}));
+
+  EXPECT_FALSE(frame_received);
+}
+
+TEST(EncodedVideoFrameTransformerTest, SkipsFramesThatWereNotReceived) {
+  bool frame_received = false;
+  auto transformer = rtc::make_ref_counted<EncodedVideoFrameTransformer>(
+      [&](EncodedVideoFrame frame) { frame_received = true; });
+  std::vector<uint8_t> data = {1, 2, 3};
+  std::unique_ptr<webrtc::MockTransformableVideoFrame> frame =
+      CreateReceivedFrame(data, /*csrcs=*/{123});
+  ON_CALL(*frame, GetDirection)
+      .WillByDefault(
+          Return(webrtc::TransformableFrameInterface::Direction::kSender));
+
+  transformer->Transform(std::move(frame));
+
+  EXPECT_FALSE(frame_received);
+}
+
+}  // namespace
+}  // namespace meet
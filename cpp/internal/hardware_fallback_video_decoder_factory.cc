@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/hardware_fallback_video_decoder_factory.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/environment/environment.h"
+#include "webrtc/api/video_codecs/sdp_video_format.h"
+#include "webrtc/api/video_codecs/video_decoder.h"
+#include "webrtc/api/video_codecs/video_decoder_factory.h"
+#include "webrtc/api/video_codecs/video_decoder_factory_template.h"
+#include "webrtc/api/video_codecs/video_decoder_software_fallback_wrapper.h"
+
+// The software decoders are chosen at build time; see the
+// `disable_*_decoder` settings in cpp/internal/BUILD. Disabled decoders are
+// not referenced, so their libraries are not linked.
+#ifndef MEET_DISABLE_AV1_DECODER
+#include "webrtc/api/video_codecs/video_decoder_factory_template_dav1d_adapter.h"
+#endif
+#ifndef MEET_DISABLE_VP8_DECODER
+#include "webrtc/api/video_codecs/video_decoder_factory_template_libvpx_vp8_adapter.h"
+#endif
+#ifndef MEET_DISABLE_VP9_DECODER
+#include "webrtc/api/video_codecs/video_decoder_factory_template_libvpx_vp9_adapter.h"
+#endif
+
+namespace meet {
+namespace {
+
+// Ends the list of software decoder adapters, so that the list is never empty
+// and every enabled adapter is followed by a comma. Supports no formats.
+struct NoVideoDecoderTemplateAdapter {
+  static std::vector<webrtc::SdpVideoFormat> SupportedFormats() { return {}; }
+  static std::unique_ptr<webrtc::VideoDecoder> CreateDecoder(
+      const webrtc::Environment& /* env */,
+      const webrtc::SdpVideoFormat& /* format */) {
+    return nullptr;
+  }
+};
+
+}  // namespace
+
+std::vector<webrtc::SdpVideoFormat>
+HardwareFallbackVideoDecoderFactory::GetSupportedFormats() const {
+  std::vector<webrtc::SdpVideoFormat> formats =
+      software_factory_->GetSupportedFormats();
+  for (webrtc::SdpVideoFormat& format :
+       hardware_factory_->GetSupportedFormats()) {
+    if (!format.IsCodecInList(formats)) {
+      formats.push_back(std::move(format));
+    }
+  }
+  return formats;
+}
+
+std::unique_ptr<webrtc::VideoDecoder>
+HardwareFallbackVideoDecoderFactory::Create(
+    const webrtc::Environment& env, const webrtc::SdpVideoFormat& format) {
+  std::unique_ptr<webrtc::VideoDecoder> software_decoder;
+  if (format.IsCodecInList(software_factory_->GetSupportedFormats())) {
+    software_decoder = software_factory_->Create(env, format);
+  }
+  if (!format.IsCodecInList(hardware_factory_->GetSupportedFormats())) {
+    return software_decoder;
+  }
+
+  std::unique_ptr<webrtc::VideoDecoder> hardware_decoder =
+      hardware_factory_->Create(env, format);
+  if (hardware_decoder == nullptr) {
+    LOG(WARNING) << "Failed to create hardware " << format.name
+                 << " decoder; decoding in software.";
+    return software_decoder;
+  }
+  if (software_decoder == nullptr) {
+    return hardware_decoder;
+  }
+  return webrtc::CreateVideoDecoderSoftwareFallbackWrapper(
+      env, std::move(software_decoder), std::move(hardware_decoder));
+}
+
+std::unique_ptr<webrtc::VideoDecoderFactory>
+CreateSoftwareVideoDecoderFactory() {
+  return std::make_unique<webrtc::VideoDecoderFactoryTemplate<
+#ifndef MEET_DISABLE_VP8_DECODER
+      webrtc::LibvpxVp8DecoderTemplateAdapter,
+#endif
+#ifndef MEET_DISABLE_VP9_DECODER
+      webrtc::LibvpxVp9DecoderTemplateAdapter,
+#endif
+#ifndef MEET_DISABLE_AV1_DECODER
+      webrtc::Dav1dDecoderTemplateAdapter,
+#endif
+      NoVideoDecoderTemplateAdapter>>();
+}
+
+std::unique_ptr<webrtc::VideoDecoderFactory> CreateVideoDecoderFactory(
+    HardwareVideoDecoderFactoryProviderInterface* hardware_provider) {
+  if (hardware_provider == nullptr) {
+    return CreateSoftwareVideoDecoderFactory();
+  }
+  std::unique_ptr<webrtc::VideoDecoderFactory> hardware_factory =
+      hardware_provider->Create();
+  if (hardware_factory == nullptr) {
+    LOG(WARNING) << "Hardware video decoding is unavailable; decoding in "
+                    "software.";
+    return CreateSoftwareVideoDecoderFactory();
+  }
+  return std::make_unique<HardwareFallbackVideoDecoderFactory>(
+      std::move(hardware_factory), CreateSoftwareVideoDecoderFactory());
+}
+
+}  // namespace meet
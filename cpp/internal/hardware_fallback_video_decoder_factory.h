@@ -0,0 +1,78 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_HARDWARE_FALLBACK_VIDEO_DECODER_FACTORY_H_
+#define CPP_INTERNAL_HARDWARE_FALLBACK_VIDEO_DECODER_FACTORY_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/environment/environment.h"
+#include "webrtc/api/video_codecs/sdp_video_format.h"
+#include "webrtc/api/video_codecs/video_decoder.h"
+#include "webrtc/api/video_codecs/video_decoder_factory.h"
+
+namespace meet {
+
+// A decoder factory that decodes with hardware decoders where possible.
+//
+// Every format supported by either factory is supported. For formats that both
+// factories support, the hardware decoder is wrapped in WebRTC's software
+// fallback wrapper, which switches to the software decoder if the hardware
+// decoder fails to initialize or to decode a frame. Formats that the hardware
+// factory does not support, or fails to create decoders for, are decoded in
+// software.
+class HardwareFallbackVideoDecoderFactory : public webrtc::VideoDecoderFactory {
+ public:
+  HardwareFallbackVideoDecoderFactory(
+      std::unique_ptr<webrtc::VideoDecoderFactory> hardware_factory,
+      std::unique_ptr<webrtc::VideoDecoderFactory> software_factory)
+      : hardware_factory_(std::move(hardware_factory)),
+        software_factory_(std::move(software_factory)) {}
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  std::unique_ptr<webrtc::VideoDecoder> Create(
+      const webrtc::Environment& env,
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  std::unique_ptr<webrtc::VideoDecoderFactory> hardware_factory_;
+  std::unique_ptr<webrtc::VideoDecoderFactory> software_factory_;
+};
+
+// Returns a factory of software decoders for the codecs sent by Meet (VP8, VP9
+// and AV1).
+//
+// Each decoder can be left out of the build, e.g. with
+// `--define=meet_disable_vp9_decoder=true`, or all of them with
+// `--config=audio_only`, for deployments that do not decode video in software.
+// The factory then does not support the omitted codecs, so clients that
+// receive video must prefer codecs that remain supported, or decode them in
+// hardware.
+std::unique_ptr<webrtc::VideoDecoderFactory>
+CreateSoftwareVideoDecoderFactory();
+
+// Returns the decoder factory for clients configured with `hardware_provider`.
+// Without a provider, or if the provider does not create a factory, the
+// software decoder factory is returned.
+std::unique_ptr<webrtc::VideoDecoderFactory> CreateVideoDecoderFactory(
+    HardwareVideoDecoderFactoryProviderInterface* hardware_provider);
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_HARDWARE_FALLBACK_VIDEO_DECODER_FACTORY_H_
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/hardware_fallback_video_decoder_factory.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "webrtc/api/environment/environment.h"
+#include "webrtc/api/environment/environment_factory.h"
+#include "webrtc/api/test/mock_video_decoder.h"
+#include "webrtc/api/test/mock_video_decoder_factory.h"
+#include "webrtc/api/video_codecs/sdp_video_format.h"
+#include "webrtc/api/video_codecs/video_decoder.h"
+
+namespace meet {
+namespace {
+
+using ::testing::_;
+using ::testing::ByMove;
+using ::testing::Return;
+using ::testing::UnorderedElementsAre;
+
+TEST(HardwareFallbackVideoDecoderFactoryTest, SupportsFormatsOfBothFactories) {
+  auto hardware_factory = std::make_unique<webrtc::MockVideoDecoderFactory>();
+  EXPECT_CALL(*hardware_factory, GetSupportedFormats)
+      .WillOnce(Return(std::vector<webrtc::SdpVideoFormat>{
+          webrtc::SdpVideoFormat("VP9"), webrtc::SdpVideoFormat("H264")}));
+  auto software_factory = std::make_unique<webrtc::MockVideoDecoderFactory>();
+  EXPECT_CALL(*software_factory, GetSupportedFormats)
+      .WillOnce(Return(std::vector<webrtc::SdpVideoFormat>{
+          webrtc::SdpVideoFormat("VP8"), webrtc::SdpVideoFormat("VP9")}));
+  HardwareFallbackVideoDecoderFactory factory(std::move(hardware_factory),
+                                              std::move(software_factory));
+
+  EXPECT_THAT(factory.GetSupportedFormats(),
+              UnorderedElementsAre(webrtc::SdpVideoFormat("VP8"),
+                                   webrtc::SdpVideoFormat("VP9"),
+                                   webrtc::SdpVideoFormat("H264")));
+}
+
+TEST(HardwareFallbackVideoDecoderFactoryTest,
+     CreatesSoftwareDecoderIfHardwareDoesNotSupportFormat) {
+  auto hardware_factory = std::make_unique<webrtc::MockVideoDecoderFactory>();
+  EXPECT_CALL(*hardware_factory, GetSupportedFormats)
+      .WillOnce(Return(std::vector<webrtc::SdpVideoFormat>{
+          webrtc::SdpVideoFormat("VP9")}));
+  EXPECT_CALL(*hardware_factory, Create).Times(0);
+  auto software_factory = std::make_unique<webrtc::MockVideoDecoderFactory>();
+  EXPECT_CALL(*software_factory, GetSupportedFormats)
+      .WillOnce(Return(std::vector<webrtc::SdpVideoFormat>{
+          webrtc::SdpVideoFormat("VP8")}));
+  auto software_decoder = std::make_unique<webrtc::MockVideoDecoder>();
+  webrtc::VideoDecoder* software_decoder_ptr = software_decoder.get();
+  EXPECT_CALL(*software_factory, Create)
+      .WillOnce(Return(ByMove(std::move(software_decoder))));
+  HardwareFallbackVideoDecoderFactory factory(std::move(hardware_factory),
+                                              std::move(software_factory));
+
+  std::unique_ptr<webrtc::VideoDecoder> decoder = factory.Create(
+      webrtc::CreateEnvironment(), webrtc::SdpVideoFormat("VP8"));
+
+  EXPECT_EQ(decoder.get(), software_decoder_ptr);
+}
+
+TEST(HardwareFallbackVideoDecoderFactoryTest,
+     CreatesSoftwareDecoderIfHardwareDecoderCannotBeCreated) {
+  auto hardware_factory = std::make_unique<webrtc::MockVideoDecoderFactory>();
+  EXPECT_CALL(*hardware_factory, GetSupportedFormats)
+      .WillOnce(Return(std::vector<webrtc::SdpVideoFormat>{
+          webrtc::SdpVideoFormat("VP9")}));
+  EXPECT_CALL(*hardware_factory, Create).WillOnce(Return(ByMove(nullptr)));
+  auto software_factory = std::make_unique<webrtc::MockVideoDecoderFactory>();
+  EXPECT_CALL(*software_factory, GetSupportedFormats)
+      .WillOnce(Return(std::vector<webrtc::SdpVideoFormat>{
+          webrtc::SdpVideoFormat("VP9")}));
+  auto software_decoder = std::make_unique<webrtc::MockVideoDecoder>();
+  webrtc::VideoDecoder* software_decoder_ptr = software_decoder.get();
+  EXPECT_CALL(*software_factory, Create)
+      .WillOnce(Return(ByMove(std::move(software_decoder))));
+  HardwareFallbackVideoDecoderFactory factory(std::move(hardware_factory),
+                                              std::move(software_factory));
+
+  std::unique_ptr<webrtc::VideoDecoder> decoder = factory.Create(
+      webrtc::CreateEnvironment(), webrtc::SdpVideoFormat("VP9"));
+
+  EXPECT_EQ(decoder.get(), software_decoder_ptr);
+}
+
+TEST(HardwareFallbackVideoDecoderFactoryTest,
+     WrapsHardwareDecoderWithSoftwareFallback) {
+  auto hardware_factory = std::make_unique<webrtc::MockVideoDecoderFactory>();
+  EXPECT_CALL(*hardware_factory, GetSupportedFormats)
+      .WillOnce(Return(std::vector<webrtc::SdpVideoFormat>{
+          webrtc::SdpVideoFormat("VP9")}));
+  auto hardware_decoder = std::make_unique<webrtc::MockVideoDecoder>();
+  // The fallback wrapper initializes the hardware decoder first.
+  EXPECT_CALL(*hardware_decoder, Configure).WillOnce(Return(true));
+  EXPECT_CALL(*hardware_factory, Create)
+      .WillOnce(Return(ByMove(std::move(hardware_decoder))));
+  auto software_factory = std::make_unique<webrtc::MockVideoDecoderFactory>();
+  EXPECT_CALL(*software_factory, GetSupportedFormats)
+      .WillOnce(Return(std::vector<webrtc::SdpVideoFormat>{
+          webrtc::SdpVideoFormat("VP9")}));
+  auto software_decoder = std::make_unique<webrtc::MockVideoDecoder>();
+  EXPECT_CALL(*software_decoder, Configure).Times(0);
+  EXPECT_CALL(*software_factory, Create)
+      .WillOnce(Return(ByMove(std::move(software_decoder))));
+  HardwareFallbackVideoDecoderFactory factory(std::move(hardware_factory),
+                                              std::move(software_factory));
+
+  std::unique_ptr<webrtc::VideoDecoder> decoder = factory.Create(
+      webrtc::CreateEnvironment(), webrtc::SdpVideoFormat("VP9"));
+
+  ASSERT_NE(decoder, nullptr);
+  EXPECT_TRUE(decoder->Configure(webrtc::VideoDecoder::Settings()));
+}
+
+}  // namespace
+}  // namespace meet
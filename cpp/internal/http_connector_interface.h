@@ -18,7 +18,9 @@
 #define CPP_INTERNAL_HTTP_CONNECTOR_INTERFACE_H_
 
 #include <string>
+#include <utility>
 
+#include "absl/functional/any_invocable.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 
@@ -29,6 +31,9 @@ namespace meet {
 // Mock implementations can be used for testing.
 class HttpConnectorInterface {
  public:
+  using ConnectCallback =
+      absl::AnyInvocable<void(absl::StatusOr<std::string>) &&>;
+
   virtual ~HttpConnectorInterface() = default;
 
   // Sends an HTTP request to Meet's `ConnectActiveConference` endpoint and
@@ -36,6 +41,21 @@ class HttpConnectorInterface {
   virtual absl::StatusOr<std::string> ConnectActiveConference(
       absl::string_view join_endpoint, absl::string_view conference_id,
       absl::string_view access_token, absl::string_view sdp_offer) = 0;
+
+  // Sends the same request as `ConnectActiveConference` without blocking the
+  // calling thread, and invokes `callback` with the response on any thread.
+  //
+  // The default implementation sends the request on the calling thread and
+  // invokes `callback` before returning. Implementations whose requests block
+  // should override this.
+  virtual void ConnectActiveConferenceAsync(absl::string_view join_endpoint,
+                                            absl::string_view conference_id,
+                                            absl::string_view access_token,
+                                            absl::string_view sdp_offer,
+                                            ConnectCallback callback) {
+    std::move(callback)(ConnectActiveConference(join_endpoint, conference_id,
+                                                access_token, sdp_offer));
+  }
 };
 
 }  // namespace meet
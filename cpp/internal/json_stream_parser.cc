@@ -0,0 +1,160 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/json_stream_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "nlohmann/json.hpp"
+
+namespace meet {
+namespace {
+
+using Json = ::nlohmann::json;
+
+// Adapts nlohmann's SAX interface to `JsonStreamHandler`, tracking the path of
+// the current value.
+class SaxAdapter : public nlohmann::json_sax<Json> {
+ public:
+  explicit SaxAdapter(JsonStreamHandler& handler) : handler_(handler) {}
+
+  bool null() override { return Scalar(nullptr); }
+  bool boolean(bool value) override { return Scalar(value); }
+  bool number_integer(number_integer_t value) override {
+    return Scalar(static_cast<int64_t>(value));
+  }
+  bool number_unsigned(number_unsigned_t value) override {
+    return Scalar(static_cast<uint64_t>(value));
+  }
+  bool number_float(number_float_t value,
+                    const string_t& /* raw_value */) override {
+    return Scalar(static_cast<double>(value));
+  }
+  bool string(string_t& value) override { return Scalar(std::move(value)); }
+  bool binary(binary_t& /* value */) override {
+    // JSON text cannot contain binary values.
+    return Fail(absl::InvalidArgumentError("Unexpected binary JSON value"));
+  }
+
+  bool start_object(std::size_t /* elements */) override {
+    if (!CheckRoot(/*is_object=*/true) ||
+        !Check(handler_.OnObjectStart(path_))) {
+      return false;
+    }
+    container_paths_.push_back(path_.size());
+    return true;
+  }
+
+  bool key(string_t& key) override {
+    // Replace the previous key of the current object.
+    path_.resize(container_paths_.back());
+    if (!path_.empty()) {
+      path_ += '.';
+    }
+    path_ += key;
+    return true;
+  }
+
+  bool end_object() override {
+    path_.resize(container_paths_.back());
+    container_paths_.pop_back();
+    return Check(handler_.OnObjectEnd(path_));
+  }
+
+  bool start_array(std::size_t /* elements */) override {
+    if (!CheckRoot(/*is_object=*/false) ||
+        !Check(handler_.OnArrayStart(path_))) {
+      return false;
+    }
+    container_paths_.push_back(path_.size());
+    path_ += "[]";
+    return true;
+  }
+
+  bool end_array() override {
+    path_.resize(container_paths_.back());
+    container_paths_.pop_back();
+    return Check(handler_.OnArrayEnd(path_));
+  }
+
+  bool parse_error(std::size_t /* position */,
+                   const std::string& /* last_token */,
+                   const nlohmann::detail::exception& exception) override {
+    return Fail(absl::InvalidArgumentError(
+        absl::StrCat("Malformed JSON: ", exception.what())));
+  }
+
+  absl::Status status() && { return std::move(status_); }
+
+ private:
+  bool Scalar(JsonScalar value) {
+    return CheckRoot(/*is_object=*/false) &&
+           Check(handler_.OnScalar(path_, std::move(value)));
+  }
+
+  // Fails the parse if the root value is not an object.
+  bool CheckRoot(bool is_object) {
+    if (!container_paths_.empty() || is_object) {
+      return true;
+    }
+    return Fail(absl::InvalidArgumentError("JSON root is not an object"));
+  }
+
+  bool Check(absl::Status status) {
+    if (!status.ok()) {
+      return Fail(std::move(status));
+    }
+    return true;
+  }
+
+  bool Fail(absl::Status status) {
+    if (status_.ok()) {
+      status_ = std::move(status);
+    }
+    return false;
+  }
+
+  JsonStreamHandler& handler_;
+  // The path of the current value.
+  std::string path_;
+  // The length of `path_` for each open object or array, used to restore the
+  // path when moving to the next key or leaving the container.
+  std::vector<std::size_t> container_paths_;
+  absl::Status status_;
+};
+
+}  // namespace
+
+absl::Status ParseJsonObject(absl::string_view json,
+                             JsonStreamHandler& handler) {
+  SaxAdapter adapter(handler);
+  if (!Json::sax_parse(json.begin(), json.end(), &adapter)) {
+    absl::Status status = std::move(adapter).status();
+    // nlohmann reports every failure through the adapter, but guard against
+    // returning OK for a failed parse.
+    return status.ok() ? absl::InvalidArgumentError("Malformed JSON") : status;
+  }
+  return std::move(adapter).status();
+}
+
+}  // namespace meet
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_JSON_STREAM_PARSER_H_
+#define CPP_INTERNAL_JSON_STREAM_PARSER_H_
+
+// This file contains a streaming JSON parser for filling structs directly from
+// a message, without first building a DOM of the whole document.
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace meet {
+
+// A JSON value that is neither an object nor an array.
+using JsonScalar =
+    std::variant<std::nullptr_t, bool, int64_t, uint64_t, double, std::string>;
+
+// Receives the events of a streaming JSON parse.
+//
+// Every event is identified by the path of its value in the document: object
+// keys joined with `.`, with `[]` appended for array elements. For example, in
+// `{"resources": [{"id": 1}]}` the root object has path "", the array has path
+// "resources", its element has path "resources[]" and the id has path
+// "resources[].id".
+//
+// Returning an error from any event stops the parse, and the error is returned
+// by `ParseJsonObject`.
+class JsonStreamHandler {
+ public:
+  virtual ~JsonStreamHandler() = default;
+
+  virtual absl::Status OnObjectStart(absl::string_view path) {
+    return absl::OkStatus();
+  }
+  virtual absl::Status OnObjectEnd(absl::string_view path) {
+    return absl::OkStatus();
+  }
+  virtual absl::Status OnArrayStart(absl::string_view path) {
+    return absl::OkStatus();
+  }
+  virtual absl::Status OnArrayEnd(absl::string_view path) {
+    return absl::OkStatus();
+  }
+  virtual absl::Status OnScalar(absl::string_view path, JsonScalar value) {
+    return absl::OkStatus();
+  }
+};
+
+// Parses `json`, whose root must be an object, and reports its contents to
+// `handler` as they are read.
+//
+// Returns an `InvalidArgument` error if `json` is malformed or its root is not
+// an object, or the first error returned by `handler`. Handlers should
+// therefore return other error codes, so that callers can tell the two apart.
+absl::Status ParseJsonObject(absl::string_view json,
+                             JsonStreamHandler& handler);
+
+// Converts `value` to `T`, returning an `Internal` error naming `path` if
+// `value` has a different type or does not fit in `T`.
+//
+// Integers convert to any integral type they fit in, and any number converts to
+// `double`.
+template <typename T>
+absl::StatusOr<T> JsonScalarAs(absl::string_view path, JsonScalar value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    if (bool* boolean = std::get_if<bool>(&value)) {
+      return *boolean;
+    }
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    if (std::string* string = std::get_if<std::string>(&value)) {
+      return std::move(*string);
+    }
+  } else if constexpr (std::is_same_v<T, double>) {
+    if (double* number = std::get_if<double>(&value)) {
+      return *number;
+    }
+    if (int64_t* number = std::get_if<int64_t>(&value)) {
+      return static_cast<double>(*number);
+    }
+    if (uint64_t* number = std::get_if<uint64_t>(&value)) {
+      return static_cast<double>(*number);
+    }
+  } else {
+    static_assert(std::integral<T>, "Unsupported JSON scalar conversion.");
+    if (int64_t* number = std::get_if<int64_t>(&value);
+        number != nullptr && std::in_range<T>(*number)) {
+      return static_cast<T>(*number);
+    }
+    if (uint64_t* number = std::get_if<uint64_t>(&value);
+        number != nullptr && std::in_range<T>(*number)) {
+      return static_cast<T>(*number);
+    }
+  }
+  return absl::InternalError(
+      absl::StrCat("Unexpected JSON value type for ", path));
+}
+
+// Converts `value` with `JsonScalarAs` and stores it in `field`.
+template <typename T>
+absl::Status AssignJsonScalar(absl::string_view path, JsonScalar value,
+                              T& field) {
+  absl::StatusOr<T> converted = JsonScalarAs<T>(path, std::move(value));
+  if (!converted.ok()) {
+    return converted.status();
+  }
+  field = *std::move(converted);
+  return absl::OkStatus();
+}
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_JSON_STREAM_PARSER_H_
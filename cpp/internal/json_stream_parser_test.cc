@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/json_stream_parser.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace meet {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+// Records every event as "<event> <path>[ = <value>]".
+class RecordingHandler : public JsonStreamHandler {
+ public:
+  absl::Status OnObjectStart(absl::string_view path) override {
+    events_.push_back(absl::StrCat("{ ", path));
+    return absl::OkStatus();
+  }
+  absl::Status OnObjectEnd(absl::string_view path) override {
+    events_.push_back(absl::StrCat("} ", path));
+    return absl::OkStatus();
+  }
+  absl::Status OnArrayStart(absl::string_view path) override {
+    events_.push_back(absl::StrCat("[ ", path));
+    return absl::OkStatus();
+  }
+  absl::Status OnArrayEnd(absl::string_view path) override {
+    events_.push_back(absl::StrCat("] ", path));
+    return absl::OkStatus();
+  }
+  absl::Status OnScalar(absl::string_view path, JsonScalar value) override {
+    if (path == fail_at_) {
+      return absl::InternalError("handler error");
+    }
+    std::string printed;
+    if (std::string* string = std::get_if<std::string>(&value)) {
+      printed = *string;
+    } else if (int64_t* number = std::get_if<int64_t>(&value)) {
+      printed = absl::StrCat(*number);
+    } else if (uint64_t* number = std::get_if<uint64_t>(&value)) {
+      printed = absl::StrCat(*number);
+    } else if (bool* boolean = std::get_if<bool>(&value)) {
+      printed = *boolean ? "true" : "false";
+    } else if (std::holds_alternative<std::nullptr_t>(value)) {
+      printed = "null";
+    }
+    events_.push_back(absl::StrCat("= ", path, " ", printed));
+    return absl::OkStatus();
+  }
+
+  void FailAt(absl::string_view path) { fail_at_ = std::string(path); }
+  const std::vector<std::string>& events() const { return events_; }
+
+ private:
+  std::vector<std::string> events_;
+  std::string fail_at_;
+};
+
+TEST(JsonStreamParserTest, ReportsValuesWithTheirPaths) {
+  RecordingHandler handler;
+
+  absl::Status status = ParseJsonObject(R"json({
+    "resources": [{"id": 1, "entry": {"name": "a", "ids": [2, 3]}}, {}],
+    "flag": true,
+    "nothing": null
+  })json",
+                                        handler);
+
+  ASSERT_TRUE(status.ok()) << status;
+  EXPECT_THAT(handler.events(),
+              ElementsAre("{ ", "[ resources", "{ resources[]",
+                          "= resources[].id 1", "{ resources[].entry",
+                          "= resources[].entry.name a",
+                          "[ resources[].entry.ids",
+                          "= resources[].entry.ids[] 2",
+                          "= resources[].entry.ids[] 3",
+                          "] resources[].entry.ids", "} resources[].entry",
+                          "} resources[]", "{ resources[]", "} resources[]",
+                          "] resources", "= flag true", "= nothing null",
+                          "} "));
+}
+
+TEST(JsonStreamParserTest, MalformedJsonReturnsInvalidArgument) {
+  RecordingHandler handler;
+
+  absl::Status status = ParseJsonObject("{\"resources\": [", handler);
+
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), HasSubstr("Malformed JSON"));
+}
+
+TEST(JsonStreamParserTest, NonObjectRootReturnsInvalidArgument) {
+  RecordingHandler handler;
+
+  EXPECT_EQ(ParseJsonObject("[1, 2]", handler).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(ParseJsonObject("\"some string\"", handler).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_TRUE(handler.events().empty());
+}
+
+TEST(JsonStreamParserTest, HandlerErrorStopsParsing) {
+  RecordingHandler handler;
+  handler.FailAt("first");
+
+  absl::Status status =
+      ParseJsonObject(R"json({"first": 1, "second": 2})json", handler);
+
+  EXPECT_EQ(status, absl::InternalError("handler error"));
+  EXPECT_THAT(handler.events(), ElementsAre("{ "));
+}
+
+TEST(JsonStreamParserTest, JsonScalarAsConvertsCompatibleTypes) {
+  EXPECT_EQ(JsonScalarAs<int32_t>("path", int64_t{-7}).value(), -7);
+  EXPECT_EQ(JsonScalarAs<uint32_t>("path", uint64_t{7}).value(), 7u);
+  EXPECT_EQ(JsonScalarAs<double>("path", int64_t{2}).value(), 2.0);
+  EXPECT_EQ(JsonScalarAs<bool>("path", true).value(), true);
+  EXPECT_EQ(JsonScalarAs<std::string>("path", std::string("text")).value(),
+            "text");
+}
+
+TEST(JsonStreamParserTest, JsonScalarAsRejectsIncompatibleTypes) {
+  EXPECT_THAT(JsonScalarAs<std::string>("some.path", int64_t{1})
+                  .status()
+                  .message(),
+              HasSubstr("some.path"));
+  EXPECT_FALSE(JsonScalarAs<bool>("path", int64_t{1}).ok());
+  EXPECT_FALSE(JsonScalarAs<uint32_t>("path", int64_t{-1}).ok());
+  EXPECT_FALSE(JsonScalarAs<int32_t>("path", int64_t{1} << 40).ok());
+  EXPECT_FALSE(JsonScalarAs<int64_t>("path", 1.5).ok());
+}
+
+}  // namespace
+}  // namespace meet
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/json_writer.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+
+namespace meet {
+
+JsonWriter& JsonWriter::BeginObject() {
+  BeginValue();
+  output_.push_back('{');
+  needs_separator_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::EndObject() {
+  output_.push_back('}');
+  needs_separator_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray() {
+  BeginValue();
+  output_.push_back('[');
+  needs_separator_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::EndArray() {
+  output_.push_back(']');
+  needs_separator_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Key(absl::string_view key) {
+  BeginValue();
+  AppendEscaped(key);
+  output_.push_back(':');
+  // The value that follows the key must not be preceded by a separator.
+  needs_separator_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::String(absl::string_view value) {
+  BeginValue();
+  AppendEscaped(value);
+  needs_separator_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Int(int64_t value) {
+  BeginValue();
+  absl::StrAppend(&output_, value);
+  needs_separator_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::EmptyObject() {
+  BeginValue();
+  output_.append("{}");
+  needs_separator_ = true;
+  return *this;
+}
+
+void JsonWriter::BeginValue() {
+  if (needs_separator_) {
+    output_.push_back(',');
+  }
+}
+
+void JsonWriter::AppendEscaped(absl::string_view value) {
+  output_.push_back('"');
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        output_.append("\\\"");
+        break;
+      case '\\':
+        output_.append("\\\\");
+        break;
+      case '\b':
+        output_.append("\\b");
+        break;
+      case '\f':
+        output_.append("\\f");
+        break;
+      case '\n':
+        output_.append("\\n");
+        break;
+      case '\r':
+        output_.append("\\r");
+        break;
+      case '\t':
+        output_.append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&output_, "\\u%04x",
+                                static_cast<unsigned char>(c));
+        } else {
+          output_.push_back(c);
+        }
+    }
+  }
+  output_.push_back('"');
+}
+
+}  // namespace meet
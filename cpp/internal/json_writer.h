@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_JSON_WRITER_H_
+#define CPP_INTERNAL_JSON_WRITER_H_
+
+// This file contains a JSON writer for serializing structs directly into a
+// string, without first building a DOM of the whole document.
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace meet {
+
+// Appends compact JSON to a string as values are written.
+//
+// Values and keys are written in document order, and the writer inserts the
+// separators between them. The writer does not validate the document; callers
+// are responsible for balancing objects and arrays, and for writing a key
+// before every value of an object.
+//
+// Output is byte for byte identical to `nlohmann::json::dump()` when keys are
+// written in lexicographic order, which is the order that nlohmann writes
+// them in.
+class JsonWriter {
+ public:
+  // Appends to `output`, which must outlive the writer.
+  explicit JsonWriter(std::string& output) : output_(output) {}
+
+  JsonWriter& BeginObject();
+  JsonWriter& EndObject();
+  JsonWriter& BeginArray();
+  JsonWriter& EndArray();
+  JsonWriter& Key(absl::string_view key);
+  JsonWriter& String(absl::string_view value);
+  JsonWriter& Int(int64_t value);
+  // Writes `{}`.
+  JsonWriter& EmptyObject();
+
+ private:
+  void BeginValue();
+  void AppendEscaped(absl::string_view value);
+
+  std::string& output_;
+  // Whether a separator is needed before the next key or array element.
+  bool needs_separator_ = false;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_JSON_WRITER_H_
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/json_writer.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+
+namespace meet {
+namespace {
+
+using Json = nlohmann::json;
+
+TEST(JsonWriterTest, WritesNestedDocument) {
+  std::string output;
+  JsonWriter(output)
+      .BeginObject()
+      .Key("request")
+      .BeginObject()
+      .Key("canvases")
+      .BeginArray()
+      .BeginObject()
+      .Key("direct")
+      .EmptyObject()
+      .Key("id")
+      .Int(1)
+      .EndObject()
+      .Int(-2)
+      .String("three")
+      .EndArray()
+      .Key("requestId")
+      .Int(9007199254740993)
+      .EndObject()
+      .EndObject();
+
+  EXPECT_EQ(output,
+            R"json({"request":{"canvases":[{"direct":{},"id":1},-2,)json"
+            R"json("three"],"requestId":9007199254740993}})json");
+}
+
+TEST(JsonWriterTest, WritesEmptyContainers) {
+  std::string output;
+  JsonWriter(output)
+      .BeginObject()
+      .Key("a")
+      .BeginArray()
+      .EndArray()
+      .Key("b")
+      .BeginObject()
+      .EndObject()
+      .EndObject();
+
+  EXPECT_EQ(output, R"json({"a":[],"b":{}})json");
+}
+
+TEST(JsonWriterTest, AppendsToExistingOutput) {
+  std::string output = "prefix";
+  JsonWriter(output).BeginArray().Int(1).EndArray();
+
+  EXPECT_EQ(output, "prefix[1]");
+}
+
+TEST(JsonWriterTest, EscapesStringsLikeNlohmann) {
+  const std::string value =
+      "quote\" backslash\\ \b\f\n\r\t \x01\x1f \x7f caf\xc3\xa9";
+  std::string output;
+  JsonWriter(output).BeginObject().Key(value).String(value).EndObject();
+
+  EXPECT_EQ(output, Json({{value, value}}).dump());
+}
+
+}  // namespace
+}  // namespace meet
@@ -19,10 +19,10 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <vector>
 
 #include "absl/log/check.h"
 #include "webrtc/api/audio/audio_device_defines.h"
+#include "webrtc/api/audio/audio_frame.h"
 #include "webrtc/api/task_queue/pending_task_safety_flag.h"
 #include "webrtc/api/units/time_delta.h"
 #include "webrtc/rtc_base/thread.h"
@@ -43,6 +43,7 @@ int32_t MediaApiAudioDeviceModule::StartPlayout() {
     return 0;
   }
   is_playing_ = true;
+  next_deadline_us_ = rtc::TimeMicros();
 
   worker_thread_.PostTask(
       SafeTask(safety_flag_, [this]() { ProcessPlayData(); }));
@@ -60,6 +61,12 @@ bool MediaApiAudioDeviceModule::Playing() const {
   return is_playing_;
 }
 
+MediaApiAudioDeviceModule::PlayoutClockStats
+MediaApiAudioDeviceModule::GetPlayoutClockStats() const {
+  DCHECK(worker_thread_.IsCurrent());
+  return playout_clock_stats_;
+}
+
 int32_t MediaApiAudioDeviceModule::Terminate() {
   DCHECK(worker_thread_.IsCurrent());
   safety_flag_->SetNotAlive();
@@ -72,32 +79,46 @@ void MediaApiAudioDeviceModule::ProcessPlayData() {
     return;
   }
 
-  int64_t process_start_time = rtc::TimeMillis();
-  const size_t number_of_samples = kAudioSampleRatePerMillisecond *
-                                   sampling_interval_.ms() *
-                                   kNumberOfAudioChannels;
-  std::vector<int16_t> sample_buffer(number_of_samples);
-  size_t samples_out = 0;
-  int64_t elapsed_time_ms = -1;
-  int64_t ntp_time_ms = -1;
-
-  if (audio_callback_ != nullptr) {
-    audio_callback_->NeedMorePlayData(
-        number_of_samples, kBytesPerSample, kNumberOfAudioChannels,
-        // Sampling rate in samples per second (i.e. Hz).
-        kAudioSampleRatePerMillisecond * 1000, sample_buffer.data(),
-        samples_out, &elapsed_time_ms, &ntp_time_ms);
+  int64_t process_start_time = rtc::TimeMicros();
+  webrtc::TimeDelta skew =
+      webrtc::TimeDelta::Micros(process_start_time - next_deadline_us_);
+  playout_clock_stats_.sampling_count++;
+  playout_clock_stats_.last_skew = skew;
+  playout_clock_stats_.max_skew = std::max(playout_clock_stats_.max_skew, skew);
+  playout_skew_us_.Record(skew.us());
+  if (skew > kMaxPlayoutLag) {
+    // Too far behind to catch up without adding noticeable latency; drop the
+    // missed samplings and restart the schedule from now.
+    playout_clock_stats_.overrun_count++;
+    playout_overruns_total_.Increment();
+    next_deadline_us_ = process_start_time;
   }
-  int64_t process_end_time = rtc::TimeMillis();
-
-  // Delay the next sampling for either:
-  // 1. (sampling interval) - (time to process current sample)
-  // 2. No delay if current processing took longer than the desired 10ms
-  // TODO: Improve testing around this computation.
-  webrtc::TimeDelta delay = std::max(
-      webrtc::TimeDelta::Millis((process_start_time + sampling_interval_.ms()) -
-                                process_end_time),
-      webrtc::TimeDelta::Zero());
+
+  const int64_t number_of_frames =
+      sampling_interval_.ms() / kAudioFrameDuration.ms();
+  for (int64_t i = 0; i < number_of_frames; ++i) {
+    if (sink_only_mixer_ != nullptr) {
+      sink_only_mixer_->Mix(kNumberOfAudioChannels, &mixed_frame_);
+    } else if (audio_callback_ != nullptr) {
+      size_t samples_out = 0;
+      int64_t elapsed_time_ms = -1;
+      int64_t ntp_time_ms = -1;
+      audio_callback_->NeedMorePlayData(
+          playout_buffer_.size(), kBytesPerSample, kNumberOfAudioChannels,
+          // Sampling rate in samples per second (i.e. Hz).
+          kAudioSampleRatePerMillisecond * 1000, playout_buffer_.data(),
+          samples_out, &elapsed_time_ms, &ntp_time_ms);
+    }
+  }
+  int64_t process_end_time = rtc::TimeMicros();
+
+  // Delay the next sampling until its deadline, one sampling interval after
+  // the current one's. If that deadline has already passed, sample
+  // immediately to catch up.
+  next_deadline_us_ += sampling_interval_.us();
+  webrtc::TimeDelta delay =
+      std::max(webrtc::TimeDelta::Micros(next_deadline_us_ - process_end_time),
+               webrtc::TimeDelta::Zero());
   worker_thread_.PostDelayedHighPrecisionTask(
       SafeTask(safety_flag_, [this]() { ProcessPlayData(); }), delay);
 }
@@ -20,10 +20,16 @@
 #include <stdbool.h>
 
 #include <cstdint>
+#include <memory>
 #include <utility>
+#include <vector>
 
+#include "absl/log/check.h"
+#include "cpp/internal/metrics_registry.h"
 #include "webrtc/api/audio/audio_device.h"
 #include "webrtc/api/audio/audio_device_defines.h"
+#include "webrtc/api/audio/audio_frame.h"
+#include "webrtc/api/audio/audio_mixer.h"
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/task_queue/pending_task_safety_flag.h"
 #include "webrtc/api/units/time_delta.h"
@@ -58,19 +64,61 @@ class MediaApiAudioDeviceModule
     : public webrtc::webrtc_impl::AudioDeviceModuleDefault<
           webrtc::AudioDeviceModule> {
  public:
-  // Default constructor for production use.
-  //
-  // In production, audio should be sampled at 48000 Hz every 10ms.
-  explicit MediaApiAudioDeviceModule(rtc::Thread& worker_thread)
-      : MediaApiAudioDeviceModule(worker_thread,
-                                  webrtc::TimeDelta::Millis(10)) {}
+  // WebRTC's audio transport mixes and provides 10ms of audio per request.
+  static constexpr webrtc::TimeDelta kAudioFrameDuration =
+      webrtc::TimeDelta::Millis(10);
+  static constexpr webrtc::TimeDelta kDefaultSamplingInterval =
+      kAudioFrameDuration;
+  // How far playout may fall behind its schedule before missed samplings are
+  // dropped instead of caught up on. This bounds the latency added when the
+  // worker thread is starved.
+  static constexpr webrtc::TimeDelta kMaxPlayoutLag =
+      webrtc::TimeDelta::Millis(100);
+
+  // Measurements of how closely playout follows its schedule.
+  struct PlayoutClockStats {
+    // Number of times audio was sampled.
+    int64_t sampling_count = 0;
+    // How late the most recent sampling ran relative to its deadline.
+    webrtc::TimeDelta last_skew = webrtc::TimeDelta::Zero();
+    // The largest skew observed so far.
+    webrtc::TimeDelta max_skew = webrtc::TimeDelta::Zero();
+    // Number of times playout fell more than `kMaxPlayoutLag` behind and the
+    // schedule was reset.
+    int64_t overrun_count = 0;
+  };
 
-  // Constructor for testing with configurable sampling interval; the default
+  // Constructs an audio device module that wakes up every `sampling_interval`
+  // and pulls as many 10ms audio frames as fit in the interval.
+  //
+  // In production, audio should be sampled at 48000 Hz every 10ms. Longer
+  // intervals trade latency for fewer wakeups per second, and must be a
+  // multiple of 10ms. Tests may also use longer intervals, since the default
   // sampling interval of 10ms is too small to write non-flaky tests with.
-  MediaApiAudioDeviceModule(rtc::Thread& worker_thread,
-                            webrtc::TimeDelta sampling_interval)
+  //
+  // If `sink_only_mixer` is set, audio is pulled directly from it instead of
+  // from the registered audio callback. This skips the audio callback's
+  // mixing and resampling, whose output is unused when audio is only consumed
+  // through audio track sinks. `sink_only_mixer` must be the audio mixer used
+  // by the peer connection factory (see `SinkOnlyAudioMixer`).
+  explicit MediaApiAudioDeviceModule(
+      rtc::Thread& worker_thread,
+      webrtc::TimeDelta sampling_interval = kDefaultSamplingInterval,
+      rtc::scoped_refptr<webrtc::AudioMixer> sink_only_mixer = nullptr,
+      std::shared_ptr<MetricsRegistry> metrics = nullptr)
       : worker_thread_(worker_thread),
-        sampling_interval_(std::move(sampling_interval)) {
+        sampling_interval_(std::move(sampling_interval)),
+        playout_buffer_(kAudioSampleRatePerMillisecond *
+                        kAudioFrameDuration.ms() * kNumberOfAudioChannels),
+        sink_only_mixer_(std::move(sink_only_mixer)),
+        metrics_(metrics != nullptr ? std::move(metrics)
+                                    : std::make_shared<MetricsRegistry>()),
+        playout_skew_us_(metrics_->GetHistogram("meet_audio_playout_skew_us",
+                                                kLatencyBucketsUs)),
+        playout_overruns_total_(
+            metrics_->GetCounter("meet_audio_playout_overruns_total")) {
+    DCHECK_GT(sampling_interval_.ms(), 0);
+    DCHECK_EQ(sampling_interval_.ms() % kAudioFrameDuration.ms(), 0);
     safety_flag_ = webrtc::PendingTaskSafetyFlag::CreateAttachedToTaskQueue(
         /*alive=*/true, &worker_thread_);
   };
@@ -81,12 +129,21 @@ class MediaApiAudioDeviceModule
   int32_t Terminate() override;
   bool Playing() const override;
 
+  // Must be called on the worker thread.
+  PlayoutClockStats GetPlayoutClockStats() const;
+
  private:
   // Periodically calls the registered audio callback, registered by WebRTC
-  // internals, to provide audio data. It is to be invoked every 10ms with a
-  // sampling rate of 48000 Hz. If this is not done, no audio will be provided
+  // internals, to provide audio data. It is to be invoked every sampling
+  // interval and requests one 10ms frame at a sampling rate of 48000 Hz per
+  // 10ms of the interval. If this is not done, no audio will be provided
   // to the audio sinks registered with the RTPReceiver of the RTPTransceiver
   // that remote audio is being received on.
+  //
+  // Samplings are scheduled against absolute deadlines, one sampling interval
+  // apart, rather than relative to when the previous sampling finished. This
+  // keeps scheduling jitter from accumulating: a late sampling is followed
+  // immediately by the next one until playout is back on schedule.
   void ProcessPlayData();
 
   // Note that this MUST be the same worker thread used when creating the peer
@@ -129,6 +186,18 @@ class MediaApiAudioDeviceModule
   // since this class does not own the worker thread.
   rtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> safety_flag_;
   webrtc::TimeDelta sampling_interval_;
+  // Reused for every 10ms frame; the callback's output is discarded since
+  // audio is delivered to the audio sinks instead.
+  std::vector<int16_t> playout_buffer_;
+  rtc::scoped_refptr<webrtc::AudioMixer> sink_only_mixer_;
+  std::shared_ptr<MetricsRegistry> metrics_;
+  Histogram& playout_skew_us_;
+  Counter& playout_overruns_total_;
+  // Reused for every 10ms frame pulled from `sink_only_mixer_`.
+  webrtc::AudioFrame mixed_frame_;
+  // Monotonic time, in microseconds, at which the next sampling is due.
+  int64_t next_deadline_us_ = 0;
+  PlayoutClockStats playout_clock_stats_;
 
   webrtc::AudioTransport* audio_callback_ = nullptr;
   bool is_playing_ = false;
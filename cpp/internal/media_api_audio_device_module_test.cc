@@ -17,20 +17,36 @@
 #include "cpp/internal/media_api_audio_device_module.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "webrtc/api/audio/audio_frame.h"
+#include "webrtc/api/audio/audio_mixer.h"
 #include "webrtc/api/make_ref_counted.h"
 #include "webrtc/api/units/time_delta.h"
 #include "webrtc/modules/audio_device/include/mock_audio_transport.h"
 #include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/time_utils.h"
 
 namespace meet {
 namespace {
 using ::testing::_;
+using ::testing::Each;
+
+class MockAudioMixer : public webrtc::AudioMixer {
+ public:
+  MOCK_METHOD(bool, AddSource, (Source * audio_source), (override));
+  MOCK_METHOD(void, RemoveSource, (Source * audio_source), (override));
+  MOCK_METHOD(void, Mix,
+              (size_t number_of_channels,
+               webrtc::AudioFrame* audio_frame_for_mixing),
+              (override));
+};
 
 std::unique_ptr<rtc::Thread> CreateWorkerThread() {
   std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
@@ -105,13 +121,14 @@ TEST(MediaApiAudioDeviceModuleTest,
   auto adm = rtc::make_ref_counted<MediaApiAudioDeviceModule>(
       *worker_thread, /*sampling_interval=*/webrtc::TimeDelta::Seconds(1));
   webrtc::test::MockAudioTransport audio_transport;
+  // Audio is always requested in 10ms frames.
   const size_t number_of_samples =
-      kAudioSampleRatePerMillisecond * 1000 * kNumberOfAudioChannels;
+      kAudioSampleRatePerMillisecond * 10 * kNumberOfAudioChannels;
   EXPECT_CALL(audio_transport,
               NeedMorePlayData(
                   number_of_samples, kBytesPerSample, kNumberOfAudioChannels,
                   kAudioSampleRatePerMillisecond * 1000, _, _, _, _))
-      .Times(6);
+      .Times(600);
 
   worker_thread->BlockingCall([&]() {
     EXPECT_EQ(adm->RegisterAudioCallback(&audio_transport), 0);
@@ -122,7 +139,7 @@ TEST(MediaApiAudioDeviceModuleTest,
   // should occur at the sampling interval (i.e. 1 sample per second).
   //
   // After 5.5 seconds, there should be 6 rounds of processing, at T=0, T=1,
-  // T=2, T=3, T=4, and T=5.
+  // T=2, T=3, T=4, and T=5, each requesting 100 frames of 10ms.
   absl::SleepFor(absl::Seconds(5.5));
 
   worker_thread->BlockingCall([&]() { adm->Terminate(); });
@@ -132,7 +149,7 @@ TEST(MediaApiAudioDeviceModuleTest,
 // interval, the next sampling should be triggered immediately.
 //
 // This test simulates processing that takes 2 seconds, which is longer than the
-// sampling interval of 1 second.
+// sampling interval of 1 second, by taking 20ms for each of the 100 frames.
 TEST(MediaApiAudioDeviceModuleTest,
      StartPlayoutImmediatelyCallsCallbackWhenCallbackTakesNonTrivialTime) {
   std::unique_ptr<rtc::Thread> worker_thread = CreateWorkerThread();
@@ -140,9 +157,9 @@ TEST(MediaApiAudioDeviceModuleTest,
       *worker_thread, /*sampling_interval=*/webrtc::TimeDelta::Seconds(1));
   webrtc::test::MockAudioTransport audio_transport;
   EXPECT_CALL(audio_transport, NeedMorePlayData(_, _, _, _, _, _, _, _))
-      .Times(3)
+      .Times(300)
       .WillRepeatedly([&]() {
-        absl::SleepFor(absl::Seconds(2));
+        absl::SleepFor(absl::Milliseconds(20));
         return 0;
       });
 
@@ -160,6 +177,112 @@ TEST(MediaApiAudioDeviceModuleTest,
   // seconds, at: T=0, T=2, and T=4.
   absl::SleepFor(absl::Seconds(5.5));
 
+  worker_thread->BlockingCall([&]() {
+    adm->Terminate();
+    // The rounds at T=2 and T=4 were each a second late, which is more than
+    // can be caught up on.
+    MediaApiAudioDeviceModule::PlayoutClockStats stats =
+        adm->GetPlayoutClockStats();
+    EXPECT_EQ(stats.sampling_count, 3);
+    EXPECT_EQ(stats.overrun_count, 2);
+    EXPECT_GE(stats.max_skew, webrtc::TimeDelta::Millis(900));
+  });
+}
+
+// When a round of processing runs late by less than the maximum playout lag,
+// the next round should be triggered immediately, and later rounds should stay
+// on the original schedule rather than drifting by the delay.
+TEST(MediaApiAudioDeviceModuleTest, StartPlayoutCatchesUpWithoutDrifting) {
+  std::unique_ptr<rtc::Thread> worker_thread = CreateWorkerThread();
+  auto adm = rtc::make_ref_counted<MediaApiAudioDeviceModule>(
+      *worker_thread, /*sampling_interval=*/webrtc::TimeDelta::Seconds(1));
+  webrtc::test::MockAudioTransport audio_transport;
+  int call_count = 0;
+  std::vector<int64_t> round_start_times_ms;
+  EXPECT_CALL(audio_transport, NeedMorePlayData(_, _, _, _, _, _, _, _))
+      .WillRepeatedly([&]() {
+        // Each round of processing requests 100 frames of 10ms.
+        if (call_count++ % 100 == 0) {
+          round_start_times_ms.push_back(rtc::TimeMillis());
+        }
+        // Make the first round of processing take longer than the sampling
+        // interval.
+        if (call_count == 100) {
+          absl::SleepFor(absl::Milliseconds(1080));
+        }
+        return 0;
+      });
+
+  worker_thread->BlockingCall([&]() {
+    EXPECT_EQ(adm->RegisterAudioCallback(&audio_transport), 0);
+    EXPECT_EQ(adm->StartPlayout(), 0);
+  });
+
+  // There should be rounds of processing at T=0, T=1.08 (catching up on the
+  // round due at T=1), T=2 and T=3.
+  absl::SleepFor(absl::Seconds(3.5));
+
+  worker_thread->BlockingCall([&]() {
+    adm->Terminate();
+    MediaApiAudioDeviceModule::PlayoutClockStats stats =
+        adm->GetPlayoutClockStats();
+    EXPECT_EQ(stats.sampling_count, 4);
+    EXPECT_EQ(stats.overrun_count, 0);
+    EXPECT_GE(stats.max_skew, webrtc::TimeDelta::Millis(50));
+  });
+  ASSERT_EQ(round_start_times_ms.size(), 4);
+  EXPECT_LT(round_start_times_ms[2] - round_start_times_ms[0], 2040);
+}
+
+TEST(MediaApiAudioDeviceModuleTest,
+     StartPlayoutRequestsOneFramePerTenMillisecondsOfInterval) {
+  std::unique_ptr<rtc::Thread> worker_thread = CreateWorkerThread();
+  auto adm = rtc::make_ref_counted<MediaApiAudioDeviceModule>(
+      *worker_thread, /*sampling_interval=*/webrtc::TimeDelta::Millis(40));
+  webrtc::test::MockAudioTransport audio_transport;
+  std::vector<void*> buffers;
+  EXPECT_CALL(audio_transport, NeedMorePlayData(_, _, _, _, _, _, _, _))
+      .WillRepeatedly([&](size_t, size_t, size_t, uint32_t, void* buffer,
+                          size_t&, int64_t*, int64_t*) {
+        buffers.push_back(buffer);
+        return 0;
+      });
+
+  worker_thread->BlockingCall([&]() {
+    adm->RegisterAudioCallback(&audio_transport);
+    EXPECT_EQ(adm->StartPlayout(), 0);
+  });
+
+  // Terminate in a separate block to allow the first processing task to
+  // complete, before the next one is due.
+  worker_thread->BlockingCall([&]() { adm->Terminate(); });
+
+  // A 40ms interval is sampled as four 10ms frames, all written to the same
+  // preallocated buffer.
+  ASSERT_EQ(buffers.size(), 4);
+  EXPECT_THAT(buffers, Each(buffers.front()));
+}
+
+TEST(MediaApiAudioDeviceModuleTest,
+     StartPlayoutWithSinkOnlyMixerPullsFromMixerInsteadOfCallback) {
+  std::unique_ptr<rtc::Thread> worker_thread = CreateWorkerThread();
+  auto mixer = rtc::make_ref_counted<MockAudioMixer>();
+  auto adm = rtc::make_ref_counted<MediaApiAudioDeviceModule>(
+      *worker_thread, /*sampling_interval=*/webrtc::TimeDelta::Millis(40),
+      /*sink_only_mixer=*/mixer);
+  webrtc::test::MockAudioTransport audio_transport;
+  EXPECT_CALL(audio_transport, NeedMorePlayData(_, _, _, _, _, _, _, _))
+      .Times(0);
+  // Expect one 10ms frame per 10ms of the first sampling interval.
+  EXPECT_CALL(*mixer, Mix(kNumberOfAudioChannels, _)).Times(4);
+
+  worker_thread->BlockingCall([&]() {
+    adm->RegisterAudioCallback(&audio_transport);
+    EXPECT_EQ(adm->StartPlayout(), 0);
+  });
+
+  // Terminate in a separate block to allow the first processing task to
+  // complete, before the next one is due.
   worker_thread->BlockingCall([&]() { adm->Terminate(); });
 }
 
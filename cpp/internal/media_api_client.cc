@@ -16,25 +16,35 @@
 
 #include "cpp/internal/media_api_client.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "absl/functional/any_invocable.h"
+#include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/media_stats_resource.h"
 #include "cpp/api/session_control_resource.h"
 #include "cpp/api/video_assignment_resource.h"
 #include "cpp/internal/conference_media_tracks.h"
+#include "cpp/internal/metrics_registry.h"
 #include "cpp/internal/stats_request_from_report.h"
+#include "cpp/internal/trace_events.h"
 #include "cpp/internal/variant_utils.h"
 #include "webrtc/api/create_peerconnection_factory.h"
 #include "webrtc/api/make_ref_counted.h"
@@ -50,10 +60,14 @@
 #include "webrtc/api/units/time_delta.h"
 #include "webrtc/api/video/video_source_interface.h"
 #include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/time_utils.h"
 
 namespace meet {
 namespace {
 
+// How long `GetStatsReport` waits for the peer connection to deliver stats.
+constexpr absl::Duration kStatsReportTimeout = absl::Seconds(5);
+
 // Lambda-based implementation of RTCStatsCollectorCallback.
 class OnRTCStatsCollected : public webrtc::RTCStatsCollectorCallback {
  public:
@@ -77,57 +91,55 @@ class OnRTCStatsCollected : public webrtc::RTCStatsCollectorCallback {
 absl::Status MediaApiClient::ConnectActiveConference(
     absl::string_view join_endpoint, absl::string_view conference_id,
     absl::string_view access_token) {
-  {
-    absl::MutexLock lock(&mutex_);
-    if (state_ != State::kReady) {
-      return absl::FailedPreconditionError(absl::StrCat(
-          "ConnectActiveConference called in ", StateToString(state_),
-          " state instead of ready state."));
-    }
-    state_ = State::kConnecting;
+  if (State state = State::kReady;
+      !state_.compare_exchange_strong(state, State::kConnecting)) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("ConnectActiveConference called in ", StateToString(state),
+                     " state instead of ready state."));
   }
+  connect_start_time_us_ = rtc::TimeMicros();
   VLOG(1) << "Client switched to connecting state.";
 
-  client_thread_->PostTask(SafeTask(alive_flag_, [&,
-                                                  join_endpoint = std::string(
-                                                      join_endpoint),
-                                                  conference_id = std::string(
-                                                      conference_id),
-                                                  access_token = std::string(
-                                                      access_token)]() {
-    absl::Status connect_status = conference_peer_connection_->Connect(
-        join_endpoint, conference_id, access_token);
-    if (!connect_status.ok()) {
-      MaybeDisconnect(connect_status);
-      return;
-    }
-
-    {
-      absl::MutexLock lock(&mutex_);
-      if (state_ != State::kConnecting) {
-        LOG(WARNING)
-            << "Client in " << StateToString(state_)
-            << " state instead of connecting state after starting connection.";
-        return;
-      }
-      state_ = State::kJoining;
-    }
-    VLOG(1) << "Client switched to joining state.";
-  }));
+  client_thread_->PostTask(SafeTask(
+      alive_flag_, [this, join_endpoint = std::string(join_endpoint),
+                    conference_id = std::string(conference_id),
+                    access_token = std::string(access_token)]() {
+        // The connection attempt completes asynchronously, possibly on another
+        // thread, so hop back to the client thread to handle the result.
+        conference_peer_connection_->Connect(
+            join_endpoint, conference_id, access_token,
+            [this](absl::Status connect_status) {
+              client_thread_->PostTask(SafeTask(
+                  alive_flag_,
+                  [this, connect_status = std::move(connect_status)]() {
+                    HandleConnectResult(connect_status);
+                  }));
+            });
+      }));
 
   return absl::OkStatus();
 };
 
-absl::Status MediaApiClient::LeaveConference(int64_t request_id) {
-  State state;
-  {
-    absl::MutexLock lock(&mutex_);
+void MediaApiClient::HandleConnectResult(absl::Status status) {
+  if (!status.ok()) {
+    MaybeDisconnect(std::move(status));
+    return;
+  }
 
-    if (state_ == State::kDisconnected) {
-      return absl::InternalError(
-          "LeaveConference called in disconnected state.");
-    }
-    state = state_;
+  if (State state = State::kConnecting;
+      !state_.compare_exchange_strong(state, State::kJoining)) {
+    LOG(WARNING)
+        << "Client in " << StateToString(state)
+        << " state instead of connecting state after starting connection.";
+    return;
+  }
+  VLOG(1) << "Client switched to joining state.";
+}
+
+absl::Status MediaApiClient::LeaveConference(int64_t request_id) {
+  State state = state_.load();
+  if (state == State::kDisconnected) {
+    return absl::InternalError("LeaveConference called in disconnected state.");
   }
 
   absl::Status status = data_channels_.session_control->SendRequest(
@@ -145,14 +157,271 @@ absl::Status MediaApiClient::LeaveConference(int64_t request_id) {
   return status;
 }
 
-absl::Status MediaApiClient::SendRequest(const ResourceRequest &request) {
+JoinTimings MediaApiClient::GetJoinTimings(int64_t joined_time_us) {
+  // Steps completed before connecting started, e.g. the prepared local
+  // description of a pooled client, took no time from the caller's view.
+  auto since_connect_start =
+      [this](std::optional<int64_t> time_us) -> std::optional<int64_t> {
+    if (!time_us.has_value()) {
+      return std::nullopt;
+    }
+    return std::max<int64_t>(*time_us - connect_start_time_us_, 0);
+  };
+  ConferencePeerConnectionInterface::ConnectTimestamps connect_timestamps =
+      conference_peer_connection_->GetConnectTimestamps();
+  return JoinTimings{
+      .local_description_set_us =
+          since_connect_start(connect_timestamps.local_description_set_us),
+      .join_response_received_us =
+          since_connect_start(connect_timestamps.join_response_received_us),
+      .remote_description_set_us =
+          since_connect_start(connect_timestamps.remote_description_set_us),
+      .stun_candidate_gathered_us =
+          since_connect_start(connect_timestamps.stun_candidate_gathered_us),
+      .ice_gathering_complete_us =
+          since_connect_start(connect_timestamps.ice_gathering_complete_us),
+      .peer_connection_connected_us =
+          since_connect_start(connect_timestamps.peer_connection_connected_us),
+      .data_channel_opened_us = since_connect_start(
+          data_channels_.session_control->GetOpenedTimeUs()),
+      .joined_us = joined_time_us - connect_start_time_us_,
+  };
+}
+
+MediaApiClientMetrics MediaApiClient::GetMetrics() const {
+  return metrics_->Snapshot();
+}
+
+void MediaApiClient::GetStatsReport(absl::Duration max_age,
+                                    StatsReportCallback callback) {
+  if (State state = state_.load();
+      state == State::kReady || state == State::kDisconnected) {
+    std::move(callback)(absl::FailedPreconditionError(
+        absl::StrCat("GetStatsReport called in ", StateToString(state),
+                     " state before connecting or after disconnecting.")));
+    return;
+  }
+  // Set if the call is answered without waiting for a collection.
+  std::optional<
+      absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>>>
+      result;
   {
-    absl::MutexLock lock(&mutex_);
-    if (state_ != State::kJoined) {
-      LOG(WARNING)
-          << "SendRequest called while client is in " << StateToString(state_)
-          << " state instead of joined state. Requests are not guaranteed to "
-             "be delivered if the client is not joined into the conference.";
+    absl::MutexLock lock(&stats_report_mutex_);
+    if (stats_reports_failed_) {
+      result.emplace(absl::FailedPreconditionError(
+          "GetStatsReport called after the client shut down."));
+    } else if (latest_stats_report_ != nullptr &&
+               absl::Microseconds(rtc::TimeMicros() -
+                                  latest_stats_report_time_us_) <= max_age) {
+      result.emplace(latest_stats_report_);
+    } else {
+      stats_report_callbacks_.push_back(std::move(callback));
+      if (stats_report_collection_pending_) {
+        return;
+      }
+      stats_report_collection_pending_ = true;
+    }
+  }
+  if (result.has_value()) {
+    std::move(callback)(*std::move(result));
+    return;
+  }
+
+  // If the client shuts down before this task runs, the waiting callbacks are
+  // failed instead.
+  client_thread_->PostTask(SafeTask(alive_flag_, [this]() {
+    auto stats_callback = webrtc::make_ref_counted<OnRTCStatsCollected>(
+        [this](
+            const rtc::scoped_refptr<const webrtc::RTCStatsReport> &report) {
+          {
+            absl::MutexLock lock(&stats_report_mutex_);
+            stats_report_collection_pending_ = false;
+          }
+          CacheStatsReport(report);
+        });
+    conference_peer_connection_->GetStats(stats_callback.get());
+  }));
+}
+
+absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>>
+MediaApiClient::GetStatsReport(absl::Duration max_age) {
+  // Collections are started on the client thread, so waiting on it for one
+  // would always time out.
+  DCHECK(!client_thread_->IsCurrent());
+  // The collection may outlive this call if it times out, so the state it
+  // writes to is shared with the callback rather than owned by this frame.
+  struct PendingReport {
+    absl::Notification delivered;
+    absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>> report;
+  };
+  auto pending = std::make_shared<PendingReport>();
+  GetStatsReport(
+      max_age,
+      [pending](absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>>
+                    report) {
+        pending->report = std::move(report);
+        pending->delivered.Notify();
+      });
+  if (!pending->delivered.WaitForNotificationWithTimeout(
+          kStatsReportTimeout)) {
+    return absl::DeadlineExceededError(
+        "Timed out waiting for the peer connection to deliver stats.");
+  }
+  return pending->report;
+}
+
+void MediaApiClient::CacheStatsReport(
+    rtc::scoped_refptr<const webrtc::RTCStatsReport> report) {
+  std::vector<StatsReportCallback> callbacks;
+  {
+    absl::MutexLock lock(&stats_report_mutex_);
+    if (report != nullptr) {
+      latest_stats_report_ = report;
+      latest_stats_report_time_us_ = rtc::TimeMicros();
+    }
+    callbacks = std::move(stats_report_callbacks_);
+    stats_report_callbacks_.clear();
+  }
+  for (StatsReportCallback &callback : callbacks) {
+    if (report == nullptr) {
+      std::move(callback)(absl::InternalError(
+          "Peer connection delivered a null stats report."));
+    } else {
+      std::move(callback)(report);
+    }
+  }
+}
+
+void MediaApiClient::FailStatsReportCallbacks() {
+  std::vector<StatsReportCallback> callbacks;
+  {
+    absl::MutexLock lock(&stats_report_mutex_);
+    stats_reports_failed_ = true;
+    callbacks = std::move(stats_report_callbacks_);
+    stats_report_callbacks_.clear();
+  }
+  for (StatsReportCallback &callback : callbacks) {
+    std::move(callback)(absl::CancelledError(
+        "Client shut down before stats were delivered."));
+  }
+}
+
+absl::Status MediaApiClient::SetVideoSinkConstraints(
+    VideoSinkConstraints constraints) {
+  if (absl::Status status = ValidateVideoSinkConstraints(constraints);
+      !status.ok()) {
+    return status;
+  }
+
+  absl::MutexLock lock(&sink_mutex_);
+  video_sink_constraints_ = std::move(constraints);
+  for (ReceivedVideoTrack &video_track : video_tracks_) {
+    video_track.sink->SetConstraints(video_sink_constraints_);
+    // Paused sinks are given the constraints once they are attached again.
+    if (video_track.attached) {
+      video_track.track->AddOrUpdateSink(
+          video_track.sink, ToVideoSinkWants(video_sink_constraints_));
+    }
+  }
+  return absl::OkStatus();
+}
+
+void MediaApiClient::PauseMedia(MediaKind kind) {
+  absl::MutexLock lock(&sink_mutex_);
+  paused_media_kinds_.insert(kind);
+  UpdatePausedSinks();
+}
+
+void MediaApiClient::ResumeMedia(MediaKind kind) {
+  absl::MutexLock lock(&sink_mutex_);
+  paused_media_kinds_.erase(kind);
+  UpdatePausedSinks();
+}
+
+void MediaApiClient::PauseTrack(absl::string_view mid) {
+  absl::MutexLock lock(&sink_mutex_);
+  paused_track_mids_.insert(std::string(mid));
+  UpdatePausedSinks();
+}
+
+void MediaApiClient::ResumeTrack(absl::string_view mid) {
+  absl::MutexLock lock(&sink_mutex_);
+  paused_track_mids_.erase(mid);
+  UpdatePausedSinks();
+}
+
+bool MediaApiClient::IsTrackPaused(MediaKind kind,
+                                   absl::string_view mid) const {
+  return paused_media_kinds_.contains(kind) || paused_track_mids_.contains(mid);
+}
+
+void MediaApiClient::UpdatePausedSinks() {
+  for (ReceivedAudioTrack &audio_track : audio_tracks_) {
+    audio_track.sink->SetPaused(IsTrackPaused(MediaKind::kAudio,
+                                              audio_track.mid));
+  }
+  for (ReceivedVideoTrack &video_track : video_tracks_) {
+    bool paused = IsTrackPaused(MediaKind::kVideo, video_track.mid);
+    if (paused && video_track.attached) {
+      // Detaching the sink stops the track's source from delivering frames to
+      // it at all, rather than dropping them once they are delivered.
+      video_track.track->RemoveSink(video_track.sink);
+      video_track.attached = false;
+    } else if (!paused && !video_track.attached) {
+      video_track.track->AddOrUpdateSink(
+          video_track.sink, ToVideoSinkWants(video_sink_constraints_));
+      video_track.attached = true;
+    }
+  }
+}
+
+void MediaApiClient::Shutdown(absl::AnyInvocable<void() &&> on_shut_down) {
+  // Not a safe task, since it must run even if the client is shutting down.
+  client_thread_->PostTask(
+      [this, on_shut_down = std::move(on_shut_down)]() mutable {
+        ShutdownOnClientThread();
+        std::move(on_shut_down)();
+      });
+}
+
+void MediaApiClient::ShutdownOnClientThread() {
+  if (shut_down_) {
+    return;
+  }
+  shut_down_ = true;
+  alive_flag_->SetNotAlive();
+  // Close the peer connection to prevent any further callbacks from WebRTC
+  // objects. This prevents null dereferences on client objects after the
+  // client has started to be destroyed.
+  //
+  // Note that destroying the peer connection also closes it, but this client
+  // implementation closes the peer connection explicitly rather than relying
+  // on implicit destructor behavior.
+  conference_peer_connection_->Close();
+  FailStatsReportCallbacks();
+}
+
+absl::Status MediaApiClient::SendRequest(const ResourceRequest &request) {
+  if (State state = state_.load(); state != State::kJoined) {
+    LOG(WARNING)
+        << "SendRequest called while client is in " << StateToString(state)
+        << " state instead of joined state. Requests are not guaranteed to "
+           "be delivered if the client is not joined into the conference.";
+  } else if (const auto *video_assignment =
+                 std::get_if<VideoAssignmentChannelFromClient>(&request);
+             video_assignment != nullptr &&
+             video_assignment->request.set_video_assignment_request
+                 .has_value()) {
+    // Meet servers reject layouts with more canvases than video streams, so
+    // fail without waiting for the round trip. Streams are only signaled
+    // while connecting, so the count is final once joined.
+    size_t canvas_count = video_assignment->request.set_video_assignment_request
+                              ->layout_model.canvases.size();
+    if (size_t video_stream_count = video_stream_count_.load();
+        canvas_count > video_stream_count) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Video assignment has ", canvas_count, " canvases but the client "
+          "only receives ", video_stream_count, " video streams."));
     }
   }
 
@@ -166,12 +435,74 @@ absl::Status MediaApiClient::SendRequest(const ResourceRequest &request) {
           [&](SessionControlChannelFromClient) {
             return data_channels_.session_control->SendRequest(request);
           },
-          [&](VideoAssignmentChannelFromClient) {
+          [&](const VideoAssignmentChannelFromClient& video_assignment) {
+            if (data_channels_.video_assignment == nullptr) {
+              return absl::FailedPreconditionError(
+                  "Video assignment requests cannot be sent without a "
+                  "subscription to video assignment updates.");
+            }
+            if (video_assignment_coalescing_window_ > absl::ZeroDuration()) {
+              return CoalesceVideoAssignmentRequest(video_assignment);
+            }
             return data_channels_.video_assignment->SendRequest(request);
           }},
       request);
 };
 
+absl::Status MediaApiClient::CoalesceVideoAssignmentRequest(
+    const VideoAssignmentChannelFromClient& request) {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (pending_video_assignment_.has_value()) {
+      // A send is already scheduled; it sends this request instead.
+      pending_superseded_request_ids_.push_back(
+          pending_video_assignment_->request.request_id);
+      pending_video_assignment_ = request;
+      return absl::OkStatus();
+    }
+
+    int64_t now_us = rtc::TimeMicros();
+    int64_t window_us =
+        absl::ToInt64Microseconds(video_assignment_coalescing_window_);
+    if (last_video_assignment_time_us_.has_value() &&
+        now_us - *last_video_assignment_time_us_ < window_us) {
+      pending_video_assignment_ = request;
+      client_thread_->PostDelayedTask(
+          SafeTask(alive_flag_,
+                   [this]() { SendPendingVideoAssignmentRequest(); }),
+          webrtc::TimeDelta::Micros(*last_video_assignment_time_us_ +
+                                    window_us - now_us));
+      return absl::OkStatus();
+    }
+    last_video_assignment_time_us_ = now_us;
+  }
+  return data_channels_.video_assignment->SendRequest(request);
+}
+
+void MediaApiClient::SendPendingVideoAssignmentRequest() {
+  std::optional<VideoAssignmentChannelFromClient> request;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!pending_video_assignment_.has_value()) {
+      return;
+    }
+    request = std::move(pending_video_assignment_);
+    pending_video_assignment_.reset();
+    if (!pending_superseded_request_ids_.empty()) {
+      superseded_video_assignment_request_ids_[request->request.request_id] =
+          std::move(pending_superseded_request_ids_);
+      pending_superseded_request_ids_.clear();
+    }
+    last_video_assignment_time_us_ = rtc::TimeMicros();
+  }
+  if (absl::Status status =
+          data_channels_.video_assignment->SendRequest(*std::move(request));
+      !status.ok()) {
+    LOG(ERROR) << "Failed to send coalesced video assignment request: "
+               << status;
+  }
+}
+
 void MediaApiClient::HandleTrackSignaled(
     rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver) {
   // Tracks should only be signaled by the conference peer connection during its
@@ -193,25 +524,54 @@ void MediaApiClient::HandleTrackSignaled(
 
   switch (media_type) {
     case cricket::MEDIA_TYPE_AUDIO: {
-      auto conference_audio_track = std::make_unique<ConferenceAudioTrack>(
-          mid, std::move(receiver),
-          std::bind_front(&MediaApiClientObserverInterface::OnAudioFrame,
-                          observer_));
+      Counter &frames_delivered = metrics_->GetCounter(absl::StrCat(
+          "meet_audio_frames_delivered_total{mid=\"", mid, "\"}"));
+      std::unique_ptr<ConferenceAudioTrackBase> conference_audio_track =
+          track_factory_.create_audio_track(
+              mid, std::move(receiver), audio_aggregation_window_,
+              media_delivery_latency_us_, frames_delivered);
       auto audio_track =
           static_cast<webrtc::AudioTrackInterface *>(receiver_track.get());
+      {
+        // Audio sinks stay attached while paused, and drop the audio instead.
+        // Remote audio is mixed and delivered to the track whether or not it
+        // has sinks, and audio tracks may only be updated on the signaling
+        // thread.
+        absl::MutexLock lock(&sink_mutex_);
+        conference_audio_track->SetPaused(
+            IsTrackPaused(MediaKind::kAudio, mid));
+        audio_tracks_.push_back(ReceivedAudioTrack{
+            .mid = mid, .sink = conference_audio_track.get()});
+      }
       audio_track->AddSink(conference_audio_track.get());
       media_tracks_.push_back(std::move(conference_audio_track));
     }
       return;
     case cricket::MEDIA_TYPE_VIDEO: {
-      auto conference_video_track = std::make_unique<ConferenceVideoTrack>(
-          mid, std::bind_front(&MediaApiClientObserverInterface::OnVideoFrame,
-                               observer_));
-      auto video_track =
-          static_cast<webrtc::VideoTrackInterface *>(receiver_track.get());
-      video_track->AddOrUpdateSink(conference_video_track.get(),
-                                   rtc::VideoSinkWants());
+      Counter &frames_delivered = metrics_->GetCounter(absl::StrCat(
+          "meet_video_frames_delivered_total{mid=\"", mid, "\"}"));
+      std::unique_ptr<ConferenceVideoTrackBase> conference_video_track =
+          track_factory_.create_video_track(mid, media_delivery_latency_us_,
+                                            frames_delivered);
+      rtc::scoped_refptr<webrtc::VideoTrackInterface> video_track(
+          static_cast<webrtc::VideoTrackInterface *>(receiver_track.get()));
+      {
+        absl::MutexLock lock(&sink_mutex_);
+        conference_video_track->SetConstraints(video_sink_constraints_);
+        bool paused = IsTrackPaused(MediaKind::kVideo, mid);
+        if (!paused) {
+          video_track->AddOrUpdateSink(
+              conference_video_track.get(),
+              ToVideoSinkWants(video_sink_constraints_));
+        }
+        video_tracks_.push_back(
+            ReceivedVideoTrack{.mid = mid,
+                               .track = std::move(video_track),
+                               .sink = conference_video_track.get(),
+                               .attached = !paused});
+      }
       media_tracks_.push_back(std::move(conference_video_track));
+      ++video_stream_count_;
     }
       return;
     default:
@@ -222,7 +582,43 @@ void MediaApiClient::HandleTrackSignaled(
 };
 
 void MediaApiClient::HandleResourceUpdate(ResourceUpdate update) {
-  observer_->OnResourceUpdate(update);
+  // Only session control and media stats updates are handled by the client.
+  // All other updates, including potentially large participants and media
+  // entries snapshots, are moved to the observer instead of being copied.
+  if (!std::holds_alternative<SessionControlChannelToClient>(update) &&
+      !std::holds_alternative<MediaStatsChannelToClient>(update)) {
+    // Responses to coalesced video assignment requests are also delivered for
+    // the requests that they superseded.
+    std::optional<VideoAssignmentResponse> superseded_response;
+    std::vector<int64_t> superseded_request_ids;
+    if (const auto* video_assignment =
+            std::get_if<VideoAssignmentChannelToClient>(&update);
+        video_assignment != nullptr && video_assignment->response.has_value()) {
+      absl::MutexLock lock(&mutex_);
+      auto it = superseded_video_assignment_request_ids_.find(
+          video_assignment->response->request_id);
+      if (it != superseded_video_assignment_request_ids_.end()) {
+        superseded_response = video_assignment->response;
+        superseded_request_ids = std::move(it->second);
+        superseded_video_assignment_request_ids_.erase(it);
+      }
+    }
+    ThreadWatchdog::ScopedTask task(
+        "MediaApiClientObserverInterface::OnResourceUpdate");
+    observer_->OnResourceUpdate(std::move(update));
+    for (int64_t request_id : superseded_request_ids) {
+      VideoAssignmentResponse response = *superseded_response;
+      response.request_id = request_id;
+      observer_->OnResourceUpdate(
+          VideoAssignmentChannelToClient{.response = std::move(response)});
+    }
+    return;
+  }
+  {
+    ThreadWatchdog::ScopedTask task(
+        "MediaApiClientObserverInterface::OnResourceUpdate");
+    observer_->OnResourceUpdate(update);
+  }
 
   if (std::holds_alternative<SessionControlChannelToClient>(update)) {
     SessionControlChannelToClient session_control_update =
@@ -238,19 +634,26 @@ void MediaApiClient::HandleResourceUpdate(ResourceUpdate update) {
         std::move(session_control_update.resources[0]);
     if (session_control_resource.session_status.connection_state ==
         SessionStatus::ConferenceConnectionState::kJoined) {
-      {
-        absl::MutexLock lock(&mutex_);
-        if (state_ != State::kJoining) {
-          LOG(WARNING) << "Received joined session status while in "
-                       << StateToString(state_)
-                       << " state instead of joining state.";
-          return;
-        }
-
-        state_ = State::kJoined;
-        observer_->OnJoined();
+      if (State state = State::kJoining;
+          !state_.compare_exchange_strong(state, State::kJoined)) {
+        LOG(WARNING) << "Received joined session status while in "
+                     << StateToString(state)
+                     << " state instead of joining state.";
+        return;
       }
       VLOG(1) << "Client switched to joined state.";
+      // The observer is notified on the client thread, where disconnections
+      // are handled, so that `OnJoined` is never invoked after or concurrently
+      // with `OnDisconnected`. No lock is held while it runs, so a slow
+      // observer does not block requests.
+      client_thread_->PostTask(SafeTask(
+          alive_flag_, [this, timings = GetJoinTimings(rtc::TimeMicros())]() {
+            if (state_.load() == State::kJoined) {
+              ThreadWatchdog::ScopedTask task(
+                  "MediaApiClientObserverInterface::OnJoined");
+              observer_->OnJoined(timings);
+            }
+          }));
     } else if (session_control_resource.session_status.connection_state ==
                SessionStatus::ConferenceConnectionState::kDisconnected) {
       VLOG(1) << "Received disconnected session status.";
@@ -284,7 +687,11 @@ void MediaApiClient::HandleResourceUpdate(ResourceUpdate update) {
         // Request IDs must be non-zero, so the initial value is 1.
         StatsConfig({.stats_request_id = 1,
                      .upload_interval = configuration.upload_interval_seconds,
-                     .allowlist = std::move(configuration.allowlist)});
+                     .allowlist = StatsAllowlist(
+                         std::move(configuration.allowlist))});
+    if (delta_encoded_stats_) {
+      stats_config_.delta_encoder.emplace();
+    }
 
     // Move stats collection off of the network thread to the client thread.
     client_thread_->PostTask(SafeTask(alive_flag_, [&]() {
@@ -313,33 +720,43 @@ void MediaApiClient::MaybeDisconnect(absl::Status status) {
     return;
   }
 
-  {
-    absl::MutexLock lock(&mutex_);
-    if (state_ == State::kDisconnected) {
-      LOG(WARNING) << "Client attempted to disconnect with status: "
-                   << status.message()
-                   << " while already in disconnected state.";
-      return;
-    }
-    state_ = State::kDisconnected;
+  if (state_.exchange(State::kDisconnected) == State::kDisconnected) {
+    LOG(WARNING) << "Client attempted to disconnect with status: "
+                 << status.message() << " while already in disconnected state.";
+    return;
   }
   VLOG(1) << "Client switched to disconnected state: " << status.message();
 
   conference_peer_connection_->Close();
+  ThreadWatchdog::ScopedTask task(
+      "MediaApiClientObserverInterface::OnDisconnected");
   observer_->OnDisconnected(status);
 };
 
 void MediaApiClient::CollectStats() {
+  MEET_TRACE_EVENT("MediaApiClient::CollectStats");
   if (stats_config_.upload_interval == 0) {
     LOG(WARNING) << "Stats initiated with 0 upload interval.";
     return;
   }
+  if (stats_config_.allowlist.empty()) {
+    // Every upload would be empty, so skip collecting stats from the peer
+    // connection entirely.
+    VLOG(1) << "Stats initiated with empty allowlist; not collecting stats.";
+    return;
+  }
 
   auto callback = webrtc::make_ref_counted<OnRTCStatsCollected>(
       [this](const rtc::scoped_refptr<const webrtc::RTCStatsReport> &report) {
+        MEET_TRACE_EVENT("MediaApiClient::CollectStats::OnStatsCollected");
+        CacheStatsReport(report);
         MediaStatsChannelFromClient request = StatsRequestFromReport(
             report, stats_config_.stats_request_id, stats_config_.allowlist);
         stats_config_.stats_request_id++;
+        if (stats_config_.delta_encoder.has_value()) {
+          stats_config_.delta_encoder->RemoveUnchangedValues(
+              *request.request.upload_media_stats);
+        }
         absl::Status send_status =
             data_channels_.media_stats->SendRequest(std::move(request));
         if (!send_status.ok()) {
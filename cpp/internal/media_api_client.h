@@ -17,9 +17,12 @@
 #ifndef CPP_INTERNAL_MEDIA_API_CLIENT_H_
 #define CPP_INTERNAL_MEDIA_API_CLIENT_H_
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,23 +30,124 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
+#include "cpp/api/media_api_client_metrics.h"
+#include "cpp/api/video_assignment_resource.h"
 #include "cpp/internal/conference_data_channel_interface.h"
 #include "cpp/internal/conference_media_tracks.h"
 #include "cpp/internal/conference_peer_connection_interface.h"
+#include "cpp/internal/metrics_registry.h"
+#include "cpp/internal/observer_dispatcher.h"
+#include "cpp/internal/shared_peer_connection_context.h"
+#include "cpp/internal/stats_request_from_report.h"
+#include "cpp/internal/thread_watchdog.h"
+#include "webrtc/api/media_stream_interface.h"
+#include "webrtc/api/rtp_receiver_interface.h"
 #include "webrtc/api/rtp_transceiver_interface.h"
 #include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/stats/rtc_stats_report.h"
 #include "webrtc/api/task_queue/pending_task_safety_flag.h"
 #include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/time_utils.h"
 
 namespace meet {
 
+// Delivers the frames of received tracks to an observer of type `Observer` and
+// records their delivery.
+//
+// The observer is called through `Observer` rather than the observer
+// interface, so frame callbacks that `Observer` declares final are called
+// directly.
+template <typename Observer>
+class ObserverFrameSink {
+ public:
+  ObserverFrameSink(rtc::scoped_refptr<Observer> observer,
+                    Histogram& delivery_latency_us, Counter& frames_delivered)
+      : observer_(std::move(observer)),
+        delivery_latency_us_(delivery_latency_us),
+        frames_delivered_(frames_delivered) {}
+
+  void operator()(AudioFrame frame) {
+    int64_t delivery_start_us = rtc::TimeMicros();
+    ThreadWatchdog::ScopedTask task(
+        "MediaApiClientObserverInterface::OnAudioFrame");
+    observer_->OnAudioFrame(std::move(frame));
+    RecordDelivery(delivery_start_us);
+  }
+
+  void operator()(VideoFrame frame) {
+    int64_t delivery_start_us = rtc::TimeMicros();
+    ThreadWatchdog::ScopedTask task(
+        "MediaApiClientObserverInterface::OnVideoFrame");
+    observer_->OnVideoFrame(std::move(frame));
+    RecordDelivery(delivery_start_us);
+  }
+
+ private:
+  void RecordDelivery(int64_t delivery_start_us) {
+    delivery_latency_us_.Record(rtc::TimeMicros() - delivery_start_us);
+    frames_delivered_.Increment();
+  }
+
+  rtc::scoped_refptr<Observer> observer_;
+  Histogram& delivery_latency_us_;
+  Counter& frames_delivered_;
+};
+
+// Creates the tracks that deliver the frames of received tracks. Called once
+// per signaled track, so the type erasure is kept out of the frame path.
+struct MediaTrackFactory {
+  absl::AnyInvocable<std::unique_ptr<ConferenceAudioTrackBase>(
+      std::string mid,
+      rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+      absl::Duration aggregation_window, Histogram& delivery_latency_us,
+      Counter& frames_delivered)>
+      create_audio_track;
+  absl::AnyInvocable<std::unique_ptr<ConferenceVideoTrackBase>(
+      std::string mid, Histogram& delivery_latency_us,
+      Counter& frames_delivered)>
+      create_video_track;
+};
+
+// Returns a factory of tracks whose sinks call `observer` directly.
+template <typename Observer>
+MediaTrackFactory MakeMediaTrackFactory(
+    rtc::scoped_refptr<Observer> observer) {
+  using Sink = ObserverFrameSink<Observer>;
+  return MediaTrackFactory{
+      .create_audio_track =
+          [observer](std::string mid,
+                     rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+                     absl::Duration aggregation_window,
+                     Histogram& delivery_latency_us, Counter& frames_delivered)
+          -> std::unique_ptr<ConferenceAudioTrackBase> {
+        return std::make_unique<BasicConferenceAudioTrack<Sink>>(
+            std::move(mid), std::move(receiver),
+            Sink(observer, delivery_latency_us, frames_delivered),
+            kDefaultAudioSourceRefreshInterval, aggregation_window);
+      },
+      .create_video_track =
+          [observer](std::string mid, Histogram& delivery_latency_us,
+                     Counter& frames_delivered)
+          -> std::unique_ptr<ConferenceVideoTrackBase> {
+        return std::make_unique<BasicConferenceVideoTrack<Sink>>(
+            std::move(mid),
+            Sink(observer, delivery_latency_us, frames_delivered));
+      }};
+}
+
 class MediaApiClient : public MediaApiClientInterface {
  public:
   // Container for data channels used by the client.
+  //
+  // Media entries, participants and video assignment channels are null if the
+  // client is not subscribed to their resources.
   struct ConferenceDataChannels {
     std::unique_ptr<ConferenceDataChannelInterface> media_entries;
     std::unique_ptr<ConferenceDataChannelInterface> media_stats;
@@ -57,10 +161,26 @@ class MediaApiClient : public MediaApiClientInterface {
                  rtc::scoped_refptr<MediaApiClientObserverInterface> observer,
                  std::unique_ptr<ConferencePeerConnectionInterface>
                      conference_peer_connection,
-                 ConferenceDataChannels data_channels)
-      : client_thread_(std::move(client_thread)),
+                 ConferenceDataChannels data_channels,
+                 rtc::scoped_refptr<SharedPeerConnectionContext>
+                     shared_context = nullptr,
+                 bool delta_encoded_stats = false,
+                 std::shared_ptr<MetricsRegistry> metrics = nullptr,
+                 absl::Duration video_assignment_coalescing_window =
+                     absl::ZeroDuration(),
+                 absl::Duration audio_aggregation_window = absl::ZeroDuration())
+      : video_assignment_coalescing_window_(video_assignment_coalescing_window),
+        audio_aggregation_window_(audio_aggregation_window),
+        delta_encoded_stats_(delta_encoded_stats),
+        metrics_(metrics != nullptr ? std::move(metrics)
+                                    : std::make_shared<MetricsRegistry>()),
+        media_delivery_latency_us_(metrics_->GetHistogram(
+            "meet_media_delivery_latency_us", kLatencyBucketsUs)),
+        client_thread_(std::move(client_thread)),
         worker_thread_(std::move(worker_thread)),
+        shared_context_(std::move(shared_context)),
         observer_(std::move(observer)),
+        track_factory_(MakeMediaTrackFactory(observer_)),
         conference_peer_connection_(std::move(conference_peer_connection)),
         data_channels_(std::move(data_channels)) {
     alive_flag_ = webrtc::PendingTaskSafetyFlag::CreateAttachedToTaskQueue(
@@ -71,28 +191,54 @@ class MediaApiClient : public MediaApiClientInterface {
     conference_peer_connection_->SetTrackSignaledCallback(
         std::bind_front(&MediaApiClient::HandleTrackSignaled, this));
 
-    data_channels_.media_entries->SetCallback(
-        std::bind_front(&MediaApiClient::HandleResourceUpdate, this));
-    data_channels_.media_stats->SetCallback(
-        std::bind_front(&MediaApiClient::HandleResourceUpdate, this));
-    data_channels_.participants->SetCallback(
-        std::bind_front(&MediaApiClient::HandleResourceUpdate, this));
-    data_channels_.session_control->SetCallback(
-        std::bind_front(&MediaApiClient::HandleResourceUpdate, this));
-    data_channels_.video_assignment->SetCallback(
-        std::bind_front(&MediaApiClient::HandleResourceUpdate, this));
+    for (ConferenceDataChannelInterface* data_channel :
+         {data_channels_.media_entries.get(), data_channels_.media_stats.get(),
+          data_channels_.participants.get(),
+          data_channels_.session_control.get(),
+          data_channels_.video_assignment.get()}) {
+      if (data_channel != nullptr) {
+        data_channel->SetCallback(
+            std::bind_front(&MediaApiClient::HandleResourceUpdate, this));
+      }
+    }
   }
 
   ~MediaApiClient() override {
-    client_thread_->BlockingCall([&]() { alive_flag_->SetNotAlive(); });
-    // Close the peer connection to prevent any further callbacks from WebRTC
-    // objects. This prevents null dereferences on client objects after the
-    // client has started to be destroyed.
-    //
-    // Note that destroying the peer connection also closes it, but this client
-    // implementation closes the peer connection explicitly rather than relying
-    // on implicit destructor behavior.
-    conference_peer_connection_->Close();
+    // Shutting down on the client thread orders this after any pending
+    // `Shutdown`, which makes this a no-op.
+    client_thread_->BlockingCall([&]() { ShutdownOnClientThread(); });
+    // Join the dispatch threads here rather than wherever the dispatcher's
+    // last reference happens to be released, which may be a dispatch thread.
+    if (observer_dispatcher_ != nullptr) {
+      observer_dispatcher_->Stop();
+    }
+    if (thread_watchdog_ != nullptr) {
+      thread_watchdog_->Unwatch(client_thread_.get());
+      if (worker_thread_ != nullptr) {
+        thread_watchdog_->Unwatch(worker_thread_.get());
+      }
+    }
+  }
+
+  // Watches the threads owned by the client with `thread_watchdog`. Threads of
+  // the shared context are watched by the factory instead.
+  //
+  // Must be called at most once, before connecting.
+  void SetThreadWatchdog(std::shared_ptr<ThreadWatchdog> thread_watchdog) {
+    thread_watchdog_ = std::move(thread_watchdog);
+    thread_watchdog_->Watch(client_thread_.get(), "client_thread");
+    if (worker_thread_ != nullptr) {
+      thread_watchdog_->Watch(worker_thread_.get(), "worker_thread");
+    }
+  }
+
+  // Stops `observer_dispatcher` when the client is destroyed. The dispatcher
+  // must be the client's observer.
+  //
+  // Must be called at most once, before connecting.
+  void SetObserverDispatcher(
+      rtc::scoped_refptr<ObserverDispatcher> observer_dispatcher) {
+    observer_dispatcher_ = std::move(observer_dispatcher);
   }
 
   absl::Status ConnectActiveConference(absl::string_view join_endpoint,
@@ -100,10 +246,42 @@ class MediaApiClient : public MediaApiClientInterface {
                                        absl::string_view access_token) override;
   absl::Status LeaveConference(int64_t request_id) override;
   absl::Status SendRequest(const ResourceRequest& request) override;
+  MediaApiClientMetrics GetMetrics() const override;
+  void GetStatsReport(absl::Duration max_age,
+                      StatsReportCallback callback) override;
+  absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>>
+  GetStatsReport(absl::Duration max_age) override;
+  absl::Status SetVideoSinkConstraints(
+      VideoSinkConstraints constraints) override;
+  void PauseMedia(MediaKind kind) override;
+  void ResumeMedia(MediaKind kind) override;
+  void PauseTrack(absl::string_view mid) override;
+  void ResumeTrack(absl::string_view mid) override;
+  void Shutdown(absl::AnyInvocable<void() &&> on_shut_down) override;
+
+  // Replaces the factory of the tracks delivering received frames. Must be
+  // called before the client connects. By default, frames are delivered to the
+  // client's observer through the observer interface.
+  void SetMediaTrackFactory(MediaTrackFactory track_factory) {
+    track_factory_ = std::move(track_factory);
+  }
 
  private:
   enum class State { kReady, kConnecting, kJoining, kJoined, kDisconnected };
 
+  // A received track and the sink delivering its frames.
+  struct ReceivedAudioTrack {
+    std::string mid;
+    ConferenceAudioTrackBase* sink;
+  };
+  struct ReceivedVideoTrack {
+    std::string mid;
+    rtc::scoped_refptr<webrtc::VideoTrackInterface> track;
+    ConferenceVideoTrackBase* sink;
+    // Whether the sink is attached to the track, i.e. the track is not paused.
+    bool attached = false;
+  };
+
   // Configuration for collecting stats.
   //
   // https://developers.google.com/meet/media-api/guides/metrics
@@ -122,9 +300,12 @@ class MediaApiClient : public MediaApiClientInterface {
     // Allowlist for values in RTCStatsReport to include in
     // `MediaStatsChannelFromClient` resource requests.
     //
-    // Provided to client by `MediaStatsChannelToClient` resource update.
-    absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>
-        allowlist;
+    // Provided to client by `MediaStatsChannelToClient` resource update, and
+    // indexed once so that each stats upload can be built in a single pass.
+    StatsAllowlist allowlist;
+    // Removes unchanged values from stats uploads if delta encoded stats are
+    // enabled.
+    std::optional<StatsDeltaEncoder> delta_encoder;
   };
 
   std::string StateToString(State state) {
@@ -148,15 +329,105 @@ class MediaApiClient : public MediaApiClientInterface {
   void HandleResourceUpdate(ResourceUpdate update);
   void HandleTrackSignaled(
       rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver);
+  // Returns whether the track with `mid` is paused, either by itself or by its
+  // kind of media.
+  bool IsTrackPaused(MediaKind kind, absl::string_view mid) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(sink_mutex_);
+  // Pauses or resumes every sink according to the paused media and tracks.
+  void UpdatePausedSinks() ABSL_EXCLUSIVE_LOCKS_REQUIRED(sink_mutex_);
+  // Sends `request`, or holds it back until the coalescing window since the
+  // previous video assignment request has elapsed. A held back request
+  // supersedes any request that was already held back.
+  absl::Status CoalesceVideoAssignmentRequest(
+      const VideoAssignmentChannelFromClient& request);
+  // Sends the held back video assignment request, if any.
+  //
+  // Called on the client thread.
+  void SendPendingVideoAssignmentRequest();
   // Collects stats from the peer connection, sends them to Meet servers, and
   // schedules the next stats collection.
   void CollectStats();
+  // Cancels pending client tasks and closes the peer connection, unless the
+  // client has already shut down.
+  //
+  // Called on the client thread.
+  void ShutdownOnClientThread();
+  // Replaces the report returned by `GetStatsReport` with a newly collected
+  // one, and passes it to the callbacks waiting for a report.
+  void CacheStatsReport(
+      rtc::scoped_refptr<const webrtc::RTCStatsReport> report);
+  // Fails the callbacks waiting for a stats report, and every later
+  // `GetStatsReport` call.
+  //
+  // Called on the client thread.
+  void FailStatsReportCallbacks();
+  // Moves the client to the joining state once the conference peer connection
+  // connects, or disconnects it if connecting failed.
+  //
+  // Called on the client thread.
+  void HandleConnectResult(absl::Status status);
   // Disconnects the client if it has not already been disconnected.
   void MaybeDisconnect(absl::Status status);
+  // Returns the time spent in each step of joining, for a client that joined
+  // at `joined_time_us`.
+  JoinTimings GetJoinTimings(int64_t joined_time_us);
 
+  // Transitions are made with compare-and-swap, so that requests and resource
+  // updates never wait on each other or on observer callbacks.
+  std::atomic<State> state_ = State::kReady;
+  // Whether the client has shut down. Only accessed on the client thread.
+  bool shut_down_ = false;
+  // When `ConnectActiveConference` was called, as returned by
+  // `rtc::TimeMicros()`.
+  std::atomic<int64_t> connect_start_time_us_ = 0;
+  // The number of video streams signaled while connecting. Video assignment
+  // canvases map onto these streams.
+  std::atomic<size_t> video_stream_count_ = 0;
+  // Guards the video assignment coalescing state.
   absl::Mutex mutex_;
-  State state_ ABSL_GUARDED_BY(mutex_) = State::kReady;
+  // Video assignment requests are coalesced if positive.
+  const absl::Duration video_assignment_coalescing_window_;
+  // Received audio is delivered in frames of this duration if positive.
+  const absl::Duration audio_aggregation_window_;
+  // When the last video assignment request was sent, as returned by
+  // `rtc::TimeMicros()`.
+  std::optional<int64_t> last_video_assignment_time_us_ ABSL_GUARDED_BY(mutex_);
+  // The latest held back video assignment request, and the IDs of the held
+  // back requests that it superseded.
+  std::optional<VideoAssignmentChannelFromClient> pending_video_assignment_
+      ABSL_GUARDED_BY(mutex_);
+  std::vector<int64_t> pending_superseded_request_ids_ ABSL_GUARDED_BY(mutex_);
+  // The IDs of the requests superseded by each sent video assignment request,
+  // keyed by the sent request's ID. Entries are removed once the sent request
+  // is responded to.
+  absl::flat_hash_map<int64_t, std::vector<int64_t>>
+      superseded_video_assignment_request_ids_ ABSL_GUARDED_BY(mutex_);
   StatsConfig stats_config_;
+  const bool delta_encoded_stats_;
+  // Guards the latest collected stats report, which is shared by the stats
+  // upload loop and `GetStatsReport` callers.
+  absl::Mutex stats_report_mutex_;
+  rtc::scoped_refptr<const webrtc::RTCStatsReport> latest_stats_report_
+      ABSL_GUARDED_BY(stats_report_mutex_);
+  // When `latest_stats_report_` was delivered, as returned by
+  // `rtc::TimeMicros()`.
+  int64_t latest_stats_report_time_us_ ABSL_GUARDED_BY(stats_report_mutex_) =
+      0;
+  // Callbacks of `GetStatsReport` calls waiting for a collection. They are
+  // passed the next collected report, whether it was collected for them or by
+  // the stats upload loop.
+  std::vector<StatsReportCallback> stats_report_callbacks_
+      ABSL_GUARDED_BY(stats_report_mutex_);
+  // Whether a collection started by `GetStatsReport` is in flight, so that
+  // concurrent calls share it.
+  bool stats_report_collection_pending_ ABSL_GUARDED_BY(stats_report_mutex_) =
+      false;
+  // Set once the client has shut down, after which no stats are collected.
+  bool stats_reports_failed_ ABSL_GUARDED_BY(stats_report_mutex_) = false;
+  // Metrics recorded by the client and its components. Declared before the
+  // components so that it outlives them.
+  std::shared_ptr<MetricsRegistry> metrics_;
+  Histogram& media_delivery_latency_us_;
 
   // Internal thread for client initiated asynchronous behavior.
   std::unique_ptr<rtc::Thread> client_thread_;
@@ -165,14 +436,37 @@ class MediaApiClient : public MediaApiClientInterface {
   // Since the thread must outlive all of these objects, the client owns the
   // thread.
   std::unique_ptr<rtc::Thread> worker_thread_;
+  // The context shared with other clients, or null if the client owns its
+  // threads. When set, `worker_thread_` is null and the context keeps the
+  // shared threads alive for the same reason.
+  rtc::scoped_refptr<SharedPeerConnectionContext> shared_context_;
+  // Watches `client_thread_` and `worker_thread_`, or null if unwatched.
+  std::shared_ptr<ThreadWatchdog> thread_watchdog_;
   // Safety flag for ensuring that tasks posted to the client thread are
   // cancelled when the client is destroyed.
   rtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> alive_flag_;
   rtc::scoped_refptr<MediaApiClientObserverInterface> observer_;
+  // The dispatcher wrapping the observer, or null if callbacks are invoked
+  // directly.
+  rtc::scoped_refptr<ObserverDispatcher> observer_dispatcher_;
+  MediaTrackFactory track_factory_;
   std::unique_ptr<ConferencePeerConnectionInterface>
       conference_peer_connection_;
   ConferenceDataChannels data_channels_;
   std::vector<ConferenceMediaTrack> media_tracks_;
+  // Guards the sinks separately from `mutex_`, since updating a video sink
+  // blocks on the worker thread.
+  absl::Mutex sink_mutex_;
+  // Applied to every video track, including tracks signaled later.
+  VideoSinkConstraints video_sink_constraints_ ABSL_GUARDED_BY(sink_mutex_);
+  // Paused media kinds and track MIDs, including MIDs of tracks that have not
+  // been signaled yet.
+  absl::flat_hash_set<MediaKind> paused_media_kinds_
+      ABSL_GUARDED_BY(sink_mutex_);
+  absl::flat_hash_set<std::string> paused_track_mids_
+      ABSL_GUARDED_BY(sink_mutex_);
+  std::vector<ReceivedAudioTrack> audio_tracks_ ABSL_GUARDED_BY(sink_mutex_);
+  std::vector<ReceivedVideoTrack> video_tracks_ ABSL_GUARDED_BY(sink_mutex_);
 };
 
 }  // namespace meet
@@ -16,43 +16,67 @@
 
 #include "cpp/internal/media_api_client_factory.h"
 
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/functional/any_invocable.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/internal/conference_data_channel.h"
+#include "cpp/internal/conference_data_channel_interface.h"
+#include "cpp/internal/conference_media_tracks.h"
 #include "cpp/internal/conference_peer_connection.h"
 #include "cpp/internal/curl_connector.h"
+#include "cpp/internal/curl_multi_connector.h"
 #include "cpp/internal/curl_request.h"
+#include "cpp/internal/deferred_observer.h"
+#include "cpp/internal/encoded_audio_frame_transformer.h"
+#include "cpp/internal/encoded_video_frame_transformer.h"
+#include "cpp/internal/hardware_fallback_video_decoder_factory.h"
 #include "cpp/internal/http_connector_interface.h"
 #include "cpp/internal/media_api_audio_device_module.h"
 #include "cpp/internal/media_api_client.h"
 #include "cpp/internal/media_entries_resource_handler.h"
+#include "cpp/internal/metrics_registry.h"
 #include "cpp/internal/media_stats_resource_handler.h"
+#include "cpp/internal/observer_dispatcher.h"
 #include "cpp/internal/participants_resource_handler.h"
+#include "cpp/internal/receive_only_encoder_factories.h"
+#include "cpp/internal/resource_handler_interface.h"
 #include "cpp/internal/session_control_resource_handler.h"
+#include "cpp/internal/shared_peer_connection_context.h"
+#include "cpp/internal/sink_only_audio_mixer.h"
+#include "cpp/internal/thread_scheduling.h"
 #include "cpp/internal/video_assignment_resource_handler.h"
-#include "webrtc/api/audio_codecs/builtin_audio_encoder_factory.h"
+#include "webrtc/api/audio/audio_mixer.h"
 #include "webrtc/api/audio_codecs/opus_audio_decoder_factory.h"
-#include "webrtc/api/create_peerconnection_factory.h"
 #include "webrtc/api/data_channel_interface.h"
+#include "webrtc/api/enable_media.h"
+#include "webrtc/api/frame_transformer_interface.h"
 #include "webrtc/api/make_ref_counted.h"
 #include "webrtc/api/media_types.h"
 #include "webrtc/api/peer_connection_interface.h"
+#include "webrtc/api/priority.h"
 #include "webrtc/api/rtc_error.h"
+#include "webrtc/api/rtp_parameters.h"
 #include "webrtc/api/rtp_transceiver_direction.h"
 #include "webrtc/api/rtp_transceiver_interface.h"
 #include "webrtc/api/scoped_refptr.h"
-#include "webrtc/api/video_codecs/video_decoder_factory_template.h"
-#include "webrtc/api/video_codecs/video_decoder_factory_template_dav1d_adapter.h"
-#include "webrtc/api/video_codecs/video_decoder_factory_template_libvpx_vp8_adapter.h"
-#include "webrtc/api/video_codecs/video_decoder_factory_template_libvpx_vp9_adapter.h"
-#include "webrtc/api/video_codecs/video_encoder_factory_template.h"
-#include "webrtc/api/video_codecs/video_encoder_factory_template_libvpx_vp9_adapter.h"
+#include "webrtc/api/units/time_delta.h"
 #include "webrtc/rtc_base/thread.h"
 
 namespace meet {
@@ -67,22 +91,170 @@ constexpr int kReceivingAudioStreamCount = 3;
 // There may be 0, 1, 2, or 3 video streams.
 constexpr int kMaxReceivingVideoStreamCount = 3;
 
-webrtc::PeerConnectionInterface::RTCConfiguration GetRtcConfiguration() {
+// The audio device module pulls audio in 10ms frames, so the sampling interval
+// must be a multiple of the frame duration. Longer intervals add latency
+// without meaningfully reducing wakeups.
+constexpr int kAudioFrameDurationMs = 10;
+constexpr int kMaxAudioSamplingIntervalMs = 40;
+// Aggregated audio is held back from observers for up to a second.
+constexpr int kMaxAudioAggregationWindowMs = 1000;
+
+// WebRTC rejects larger ICE candidate pools.
+constexpr int kMaxIceCandidatePoolSize = 255;
+
+// Jitter buffer settings of the archival latency profile. The audio jitter
+// buffer holds up to ten seconds of 20ms packets, rather than WebRTC's default
+// of 200 packets, and every receiver keeps at least half a second of media
+// buffered. Audio and video receivers share the minimum delay so that their
+// playout stays aligned.
+constexpr int kArchivalAudioJitterBufferMaxPackets = 500;
+constexpr double kArchivalJitterBufferMinimumDelaySeconds = 0.5;
+
+// Codecs that repair or protect received video rather than carry it. They are
+// offered regardless of the video codec preferences.
+constexpr std::array<absl::string_view, 4> kVideoResiliencyCodecNames = {
+    "rtx", "red", "ulpfec", "flexfec-03"};
+
+absl::StatusOr<std::unique_ptr<rtc::Thread>> StartThread(
+    absl::string_view name, absl::string_view description,
+    const ThreadConfiguration& thread_config = {}) {
+  std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+  thread->SetName(name, nullptr);
+  if (!thread->Start()) {
+    return absl::InternalError(absl::StrCat("Failed to start ", description));
+  }
+  // Scheduling settings apply to the calling thread, so they are applied from
+  // the new thread itself.
+  if (thread_config != ThreadConfiguration()) {
+    absl::Status status = thread->BlockingCall(
+        [&thread_config] { return ApplyThreadConfiguration(thread_config); });
+    if (!status.ok()) {
+      return absl::Status(status.code(),
+                          absl::StrCat("Failed to configure ", description,
+                                       ": ", status.message()));
+    }
+  }
+  return thread;
+}
+
+// Returns an error naming the thread if `thread_config` is invalid.
+absl::Status ValidateThread(absl::string_view name,
+                            const ThreadConfiguration& thread_config) {
+  absl::Status status = ValidateThreadConfiguration(thread_config);
+  if (!status.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        name, " thread configuration is invalid: ", status.message()));
+  }
+  return absl::OkStatus();
+}
+
+webrtc::PeerConnectionInterface::RTCConfiguration GetRtcConfiguration(
+    const MediaApiClientConfiguration& api_config) {
+  const IceConfiguration& ice_config = api_config.ice;
   webrtc::PeerConnectionInterface::RTCConfiguration config;
   config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
 
-  config.bundle_policy = webrtc::PeerConnectionInterface::kBundlePolicyBalanced;
+  config.bundle_policy =
+      api_config.max_bundle
+          ? webrtc::PeerConnectionInterface::kBundlePolicyMaxBundle
+          : webrtc::PeerConnectionInterface::kBundlePolicyBalanced;
   config.rtcp_mux_policy =
       webrtc::PeerConnectionInterface::kRtcpMuxPolicyRequire;
-  webrtc::PeerConnectionInterface::IceServer stun_server;
-  stun_server.urls.push_back("stun:stun.l.google.com:19302");
-  config.servers.push_back(stun_server);
+  for (const IceServer& server : ice_config.servers) {
+    webrtc::PeerConnectionInterface::IceServer ice_server;
+    ice_server.urls = server.urls;
+    ice_server.username = server.username;
+    ice_server.password = server.password;
+    config.servers.push_back(std::move(ice_server));
+  }
+  config.ice_candidate_pool_size =
+      static_cast<int>(ice_config.candidate_pool_size);
+  if (ice_config.continual_gathering) {
+    config.continual_gathering_policy =
+        webrtc::PeerConnectionInterface::GATHER_CONTINUALLY;
+  }
+  if (ice_config.disable_ipv6) {
+    config.max_ipv6_networks = 0;
+  }
+  config.disable_link_local_networks = ice_config.disable_link_local_networks;
+  if (ice_config.low_cost_networks_only) {
+    config.candidate_network_policy =
+        webrtc::PeerConnectionInterface::kCandidateNetworkPolicyLowCost;
+  }
+  if (ice_config.disable_tcp_candidates) {
+    config.tcp_candidate_policy =
+        webrtc::PeerConnectionInterface::kTcpCandidatePolicyDisabled;
+  }
+  if (api_config.latency_profile == LatencyProfile::kArchival) {
+    config.audio_jitter_buffer_max_packets =
+        kArchivalAudioJitterBufferMaxPackets;
+    config.audio_jitter_buffer_fast_accelerate = false;
+  }
   return config;
 }
 
+// Returns the receive codecs matching `codec_names`, in order, followed by the
+// resiliency codecs. A name may match several codecs, such as the profiles of
+// VP9.
+absl::StatusOr<std::vector<webrtc::RtpCodecCapability>>
+GetVideoCodecPreferences(
+    webrtc::PeerConnectionFactoryInterface& peer_connection_factory,
+    const std::vector<std::string>& codec_names) {
+  std::vector<webrtc::RtpCodecCapability> supported_codecs =
+      peer_connection_factory
+          .GetRtpReceiverCapabilities(cricket::MediaType::MEDIA_TYPE_VIDEO)
+          .codecs;
+  std::vector<webrtc::RtpCodecCapability> preferences;
+  auto add_preference =
+      [&preferences](const webrtc::RtpCodecCapability& codec) {
+        if (std::find(preferences.begin(), preferences.end(), codec) ==
+            preferences.end()) {
+          preferences.push_back(codec);
+        }
+      };
+
+  for (const std::string& codec_name : codec_names) {
+    bool supported = false;
+    for (const webrtc::RtpCodecCapability& codec : supported_codecs) {
+      if (absl::EqualsIgnoreCase(codec.name, codec_name)) {
+        add_preference(codec);
+        supported = true;
+      }
+    }
+    if (!supported) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Video codec preference ", codec_name,
+                       " is not supported by the video decoders"));
+    }
+  }
+  for (const webrtc::RtpCodecCapability& codec : supported_codecs) {
+    if (std::any_of(kVideoResiliencyCodecNames.begin(),
+                    kVideoResiliencyCodecNames.end(),
+                    [&codec](absl::string_view resiliency_codec_name) {
+                      return absl::EqualsIgnoreCase(codec.name,
+                                                    resiliency_codec_name);
+                    })) {
+      add_preference(codec);
+    }
+  }
+  return preferences;
+}
+
+// Adds the client's transceivers. If `video_codec_preferences` is empty, video
+// transceivers keep WebRTC's default codec preferences. If
+// `audio_frame_transformer` or `video_frame_transformer` is set, it is
+// installed on every receiver of that media type to receive media before it is
+// decoded. If `jitter_buffer_minimum_delay_seconds` is set, it is the minimum
+// delay of every receiver.
 absl::Status ConfigureTransceivers(
     webrtc::PeerConnectionInterface& peer_connection, bool enable_audio_streams,
-    int receiving_video_stream_count) {
+    int receiving_video_stream_count,
+    const std::vector<webrtc::RtpCodecCapability>& video_codec_preferences,
+    rtc::scoped_refptr<webrtc::FrameTransformerInterface>
+        audio_frame_transformer,
+    rtc::scoped_refptr<webrtc::FrameTransformerInterface>
+        video_frame_transformer,
+    std::optional<double> jitter_buffer_minimum_delay_seconds) {
   if (enable_audio_streams) {
     for (int i = 0; i < kReceivingAudioStreamCount; i++) {
       webrtc::RtpTransceiverInit audio_init;
@@ -103,6 +275,15 @@ absl::Status ConfigureTransceivers(
             absl::StrCat("Failed to add audio transceiver: ",
                          audio_result.error().message()));
       }
+      if (audio_frame_transformer != nullptr) {
+        audio_result.value()
+            ->receiver()
+            ->SetDepacketizerToDecoderFrameTransformer(audio_frame_transformer);
+      }
+      if (jitter_buffer_minimum_delay_seconds.has_value()) {
+        audio_result.value()->receiver()->SetJitterBufferMinimumDelay(
+            jitter_buffer_minimum_delay_seconds);
+      }
     }
   }
 
@@ -119,145 +300,653 @@ absl::Status ConfigureTransceivers(
       return absl::InternalError(absl::StrCat(
           "Failed to add video transceiver: ", video_result.error().message()));
     }
+    if (!video_codec_preferences.empty()) {
+      if (webrtc::RTCError error = video_result.value()->SetCodecPreferences(
+              video_codec_preferences);
+          !error.ok()) {
+        return absl::InternalError(
+            absl::StrCat("Failed to set video codec preferences: ",
+                         error.message()));
+      }
+    }
+    if (video_frame_transformer != nullptr) {
+      video_result.value()
+          ->receiver()
+          ->SetDepacketizerToDecoderFrameTransformer(video_frame_transformer);
+    }
+    if (jitter_buffer_minimum_delay_seconds.has_value()) {
+      video_result.value()->receiver()->SetJitterBufferMinimumDelay(
+          jitter_buffer_minimum_delay_seconds);
+    }
   }
 
   return absl::OkStatus();
 }
 
-absl::StatusOr<MediaApiClient::ConferenceDataChannels> CreateDataChannels(
-    webrtc::PeerConnectionInterface& peer_connection) {
-  const webrtc::DataChannelInit kDataChannelConfig = {.reliable = true,
-                                                      .ordered = true};
+bool IsOrderedAndReliable(const DataChannelConfiguration& config) {
+  return config.ordered && !config.max_retransmits.has_value();
+}
 
-  webrtc::RTCErrorOr<rtc::scoped_refptr<webrtc::DataChannelInterface>>
-      media_entries_data_channel_status =
-          peer_connection.CreateDataChannelOrError("media-entries",
-                                                   &kDataChannelConfig);
-  if (!media_entries_data_channel_status.ok()) {
-    return absl::InternalError(
-        absl::StrCat("Failed to create media entries data channel: ",
-                     media_entries_data_channel_status.error().message()));
+webrtc::Priority ToWebrtcPriority(DataChannelPriority priority) {
+  switch (priority) {
+    case DataChannelPriority::kVeryLow:
+      return webrtc::Priority::kVeryLow;
+    case DataChannelPriority::kLow:
+      return webrtc::Priority::kLow;
+    case DataChannelPriority::kMedium:
+      return webrtc::Priority::kMedium;
+    case DataChannelPriority::kHigh:
+      return webrtc::Priority::kHigh;
   }
+  return webrtc::Priority::kLow;
+}
 
-  webrtc::RTCErrorOr<rtc::scoped_refptr<webrtc::DataChannelInterface>>
-      media_stats_data_channel_status =
-          peer_connection.CreateDataChannelOrError("media-stats",
-                                                   &kDataChannelConfig);
-  if (!media_stats_data_channel_status.ok()) {
-    return absl::InternalError(
-        absl::StrCat("Failed to create media stats data channel: ",
-                     media_stats_data_channel_status.error().message()));
+webrtc::DataChannelInit ToDataChannelInit(
+    const DataChannelConfiguration& config) {
+  webrtc::DataChannelInit init;
+  init.ordered = config.ordered;
+  if (config.max_retransmits.has_value()) {
+    init.maxRetransmits = *config.max_retransmits;
   }
+  init.priority = webrtc::PriorityValue(ToWebrtcPriority(config.priority));
+  return init;
+}
 
+absl::StatusOr<std::unique_ptr<ConferenceDataChannelInterface>>
+CreateDataChannel(
+    webrtc::PeerConnectionInterface& peer_connection, absl::string_view label,
+    absl::string_view description, const DataChannelConfiguration& config,
+    std::unique_ptr<ResourceHandlerInterface> resource_handler,
+    std::shared_ptr<MetricsRegistry> metrics,
+    std::shared_ptr<DataChannelMessageRecorderInterface> message_recorder) {
+  const webrtc::DataChannelInit init = ToDataChannelInit(config);
   webrtc::RTCErrorOr<rtc::scoped_refptr<webrtc::DataChannelInterface>>
-      participants_data_channel_status =
-          peer_connection.CreateDataChannelOrError("participants",
-                                                   &kDataChannelConfig);
-  if (!participants_data_channel_status.ok()) {
+      data_channel_status =
+          peer_connection.CreateDataChannelOrError(std::string(label), &init);
+  if (!data_channel_status.ok()) {
     return absl::InternalError(
-        absl::StrCat("Failed to create participants data channel: ",
-                     participants_data_channel_status.error().message()));
+        absl::StrCat("Failed to create ", description, " data channel: ",
+                     data_channel_status.error().message()));
+  }
+  return std::make_unique<ConferenceDataChannel>(
+      std::move(resource_handler), std::move(data_channel_status).value(),
+      std::move(metrics), std::move(message_recorder));
+}
+
+// Creates the data channels of the subscribed resources, in addition to the
+// session control and media stats channels needed by the client itself.
+absl::StatusOr<MediaApiClient::ConferenceDataChannels> CreateDataChannels(
+    webrtc::PeerConnectionInterface& peer_connection,
+    std::shared_ptr<MetricsRegistry> metrics,
+    std::shared_ptr<DataChannelMessageRecorderInterface> message_recorder,
+    const DataChannelsConfiguration& config,
+    const ResourceSubscriptions& subscriptions) {
+  MediaApiClient::ConferenceDataChannels data_channels;
+  if (subscriptions.media_entries) {
+    absl::StatusOr<std::unique_ptr<ConferenceDataChannelInterface>>
+        media_entries = CreateDataChannel(
+            peer_connection, "media-entries", "media entries",
+            config.media_entries,
+            std::make_unique<MediaEntriesResourceHandler>(), metrics,
+            message_recorder);
+    if (!media_entries.ok()) {
+      return media_entries.status();
+    }
+    data_channels.media_entries = *std::move(media_entries);
   }
 
-  webrtc::RTCErrorOr<rtc::scoped_refptr<webrtc::DataChannelInterface>>
-      session_control_data_channel_status =
-          peer_connection.CreateDataChannelOrError("session-control",
-                                                   &kDataChannelConfig);
-  if (!session_control_data_channel_status.ok()) {
-    return absl::InternalError(
-        absl::StrCat("Failed to create session control data channel: ",
-                     session_control_data_channel_status.error().message()));
+  absl::StatusOr<std::unique_ptr<ConferenceDataChannelInterface>>
+      media_stats = CreateDataChannel(
+          peer_connection, "media-stats", "media stats", config.media_stats,
+          std::make_unique<MediaStatsResourceHandler>(), metrics,
+          message_recorder);
+  if (!media_stats.ok()) {
+    return media_stats.status();
   }
+  data_channels.media_stats = *std::move(media_stats);
 
-  webrtc::RTCErrorOr<rtc::scoped_refptr<webrtc::DataChannelInterface>>
-      video_assignment_data_channel_status =
-          peer_connection.CreateDataChannelOrError("video-assignment",
-                                                   &kDataChannelConfig);
-  if (!video_assignment_data_channel_status.ok()) {
-    return absl::InternalError(
-        absl::StrCat("Failed to create video assignment data channel: ",
-                     video_assignment_data_channel_status.error().message()));
-  }
-
-  return MediaApiClient::ConferenceDataChannels{
-      .media_entries = std::make_unique<ConferenceDataChannel>(
-          std::make_unique<MediaEntriesResourceHandler>(),
-          std::move(media_entries_data_channel_status).value()),
-      .media_stats = std::make_unique<ConferenceDataChannel>(
-          std::make_unique<MediaStatsResourceHandler>(),
-          std::move(media_stats_data_channel_status).value()),
-      .participants = std::make_unique<ConferenceDataChannel>(
-          std::make_unique<ParticipantsResourceHandler>(),
-          std::move(participants_data_channel_status).value()),
-      .session_control = std::make_unique<ConferenceDataChannel>(
-          std::make_unique<SessionControlResourceHandler>(),
-          std::move(session_control_data_channel_status).value()),
-      .video_assignment = std::make_unique<ConferenceDataChannel>(
-          std::make_unique<VideoAssignmentResourceHandler>(),
-          std::move(video_assignment_data_channel_status).value())};
+  if (subscriptions.participants) {
+    absl::StatusOr<std::unique_ptr<ConferenceDataChannelInterface>>
+        participants = CreateDataChannel(
+            peer_connection, "participants", "participants",
+            config.participants,
+            std::make_unique<ParticipantsResourceHandler>(), metrics,
+            message_recorder);
+    if (!participants.ok()) {
+      return participants.status();
+    }
+    data_channels.participants = *std::move(participants);
+  }
+
+  absl::StatusOr<std::unique_ptr<ConferenceDataChannelInterface>>
+      session_control = CreateDataChannel(
+          peer_connection, "session-control", "session control",
+          config.session_control,
+          std::make_unique<SessionControlResourceHandler>(), metrics,
+          message_recorder);
+  if (!session_control.ok()) {
+    return session_control.status();
+  }
+  data_channels.session_control = *std::move(session_control);
+
+  if (subscriptions.video_assignment) {
+    absl::StatusOr<std::unique_ptr<ConferenceDataChannelInterface>>
+        video_assignment = CreateDataChannel(
+            peer_connection, "video-assignment", "video assignment",
+            config.video_assignment,
+            std::make_unique<VideoAssignmentResourceHandler>(),
+            std::move(metrics), std::move(message_recorder));
+    if (!video_assignment.ok()) {
+      return video_assignment.status();
+    }
+    data_channels.video_assignment = *std::move(video_assignment);
+  }
+  return data_channels;
+}
+
+// Forwards requests to a connector shared by every client of a factory.
+class SharedHttpConnector : public HttpConnectorInterface {
+ public:
+  explicit SharedHttpConnector(std::shared_ptr<HttpConnectorInterface> shared)
+      : shared_(std::move(shared)) {}
+
+  absl::StatusOr<std::string> ConnectActiveConference(
+      absl::string_view join_endpoint, absl::string_view conference_id,
+      absl::string_view access_token, absl::string_view sdp_offer) override {
+    return shared_->ConnectActiveConference(join_endpoint, conference_id,
+                                            access_token, sdp_offer);
+  }
+
+  void ConnectActiveConferenceAsync(absl::string_view join_endpoint,
+                                    absl::string_view conference_id,
+                                    absl::string_view access_token,
+                                    absl::string_view sdp_offer,
+                                    ConnectCallback callback) override {
+    shared_->ConnectActiveConferenceAsync(join_endpoint, conference_id,
+                                          access_token, sdp_offer,
+                                          std::move(callback));
+  }
+
+ private:
+  std::shared_ptr<HttpConnectorInterface> shared_;
+};
+
+// Creates the provider used by the default factory.
+//
+// Every client sends its join request through one `CurlMultiConnector`, so
+// concurrent joins share a single event loop thread and its connection cache.
+// If the event loop cannot be created, each client gets a blocking
+// `CurlConnector` instead, and the connectors share DNS and TLS session
+// caches through a connection pool.
+MediaApiClientFactory::HttpConnectorProvider
+CreateDefaultHttpConnectorProvider() {
+  if (absl::StatusOr<std::unique_ptr<CurlMultiConnector>> multi_connector =
+          CurlMultiConnector::Create(std::make_unique<CurlApiWrapper>());
+      multi_connector.ok()) {
+    std::shared_ptr<HttpConnectorInterface> shared_connector =
+        *std::move(multi_connector);
+    return [shared_connector = std::move(shared_connector)]() {
+      return std::make_unique<SharedHttpConnector>(shared_connector);
+    };
+  } else {
+    LOG(WARNING) << "Failed to create curl multi connector; falling back to "
+                    "blocking connectors: "
+                 << multi_connector.status();
+  }
+
+  std::shared_ptr<CurlConnectionPool> connection_pool;
+  if (absl::StatusOr<std::unique_ptr<CurlConnectionPool>> pool =
+          CurlConnectionPool::Create(std::make_unique<CurlApiWrapper>());
+      pool.ok()) {
+    connection_pool = *std::move(pool);
+  } else {
+    LOG(WARNING) << "Failed to create curl connection pool; clients will not "
+                    "share DNS and TLS session caches: "
+                 << pool.status();
+  }
+  return [connection_pool = std::move(connection_pool)]() {
+    return std::make_unique<CurlConnector>(std::make_unique<CurlApiWrapper>(),
+                                           connection_pool);
+  };
 }
 
 }  // namespace
 
 MediaApiClientFactory::MediaApiClientFactory() {
-  peer_connection_factory_provider_ = [](rtc::Thread* signaling_thread,
-                                         rtc::Thread* worker_thread)
+  peer_connection_factory_provider_ =
+      [](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+         const MediaApiClientConfiguration& api_config,
+         std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
-    return webrtc::CreatePeerConnectionFactory(
-        /*network_thread=*/nullptr, worker_thread, signaling_thread,
-        rtc::make_ref_counted<MediaApiAudioDeviceModule>(*worker_thread),
-        webrtc::CreateBuiltinAudioEncoderFactory(),
-        webrtc::CreateOpusAudioDecoderFactory(),
-        std::make_unique<webrtc::VideoEncoderFactoryTemplate<
-            webrtc::LibvpxVp9EncoderTemplateAdapter>>(),
-        std::make_unique<webrtc::VideoDecoderFactoryTemplate<
-            webrtc::LibvpxVp8DecoderTemplateAdapter,
-            webrtc::LibvpxVp9DecoderTemplateAdapter,
-            webrtc::Dav1dDecoderTemplateAdapter>>(),
-        /*audio_mixer=*/nullptr, /*audio_processing=*/nullptr);
-  };
-  http_connector_provider_ = []() {
-    return std::make_unique<CurlConnector>(std::make_unique<CurlApiWrapper>());
+    // Leaving the audio mixer unset makes WebRTC create its default mixer.
+    rtc::scoped_refptr<webrtc::AudioMixer> audio_mixer;
+    if (api_config.sink_only_audio) {
+      audio_mixer = rtc::make_ref_counted<SinkOnlyAudioMixer>();
+    }
+    // Clients only receive media, so they are given encoder factories without
+    // any encoders, and no audio processing module, which is only applied to
+    // captured audio. RTC event logs are never started, so no event log factory
+    // is provided either.
+    webrtc::PeerConnectionFactoryDependencies dependencies;
+    dependencies.network_thread = api_config.threads.network_thread;
+    dependencies.worker_thread = worker_thread;
+    dependencies.signaling_thread = signaling_thread;
+    dependencies.adm = rtc::make_ref_counted<MediaApiAudioDeviceModule>(
+        *worker_thread,
+        webrtc::TimeDelta::Millis(api_config.audio_sampling_interval_ms),
+        /*sink_only_mixer=*/audio_mixer, std::move(metrics));
+    dependencies.audio_encoder_factory =
+        rtc::make_ref_counted<ReceiveOnlyAudioEncoderFactory>();
+    dependencies.audio_decoder_factory =
+        webrtc::CreateOpusAudioDecoderFactory();
+    dependencies.video_encoder_factory =
+        std::make_unique<ReceiveOnlyVideoEncoderFactory>();
+    dependencies.video_decoder_factory = CreateVideoDecoderFactory(
+        api_config.hardware_video_decoder_factory_provider.get());
+    dependencies.audio_mixer = std::move(audio_mixer);
+    webrtc::EnableMedia(dependencies);
+    return webrtc::CreateModularPeerConnectionFactory(std::move(dependencies));
   };
+  http_connector_provider_ = CreateDefaultHttpConnectorProvider();
 }
 
-absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
-MediaApiClientFactory::CreateMediaApiClient(
-    const MediaApiClientConfiguration& api_config,
-    rtc::scoped_refptr<MediaApiClientObserverInterface> observer) {
+MediaApiClientFactory::MediaApiClientFactory(
+    SharedContextConfiguration shared_context_config)
+    : MediaApiClientFactory() {
+  shared_context_config_ = std::move(shared_context_config);
+}
+
+MediaApiClientFactory::~MediaApiClientFactory() {
+  // Stop the pool thread to ensure that pending pool tasks do not access
+  // member fields after they have been destroyed.
+  if (pool_thread_ != nullptr) {
+    pool_thread_->Stop();
+  }
+  // Clients may keep the shared contexts alive after the factory is destroyed,
+  // but their threads are no longer watched.
+  if (thread_watchdog_ != nullptr) {
+    absl::MutexLock lock(&mutex_);
+    for (const rtc::scoped_refptr<SharedPeerConnectionContext>& context :
+         shared_contexts_) {
+      thread_watchdog_->Unwatch(context->signaling_thread());
+      thread_watchdog_->Unwatch(context->worker_thread());
+    }
+  }
+}
+
+absl::StatusOr<rtc::scoped_refptr<SharedPeerConnectionContext>>
+MediaApiClientFactory::GetSharedContext(
+    const MediaApiClientConfiguration& api_config) {
+  absl::MutexLock lock(&mutex_);
+  int index = next_shared_context_;
+  if (index < static_cast<int>(shared_contexts_.size())) {
+    next_shared_context_ = (index + 1) % shared_context_config_->context_count;
+    return shared_contexts_[index];
+  }
+
+  absl::StatusOr<std::unique_ptr<rtc::Thread>> signaling_thread = StartThread(
+      absl::StrCat("media_api_client_shared_signaling_thread_", index),
+      "shared signaling thread", shared_context_config_->signaling_thread);
+  if (!signaling_thread.ok()) {
+    return signaling_thread.status();
+  }
+  absl::StatusOr<std::unique_ptr<rtc::Thread>> worker_thread = StartThread(
+      absl::StrCat("media_api_client_shared_worker_thread_", index),
+      "shared worker thread", shared_context_config_->worker_thread);
+  if (!worker_thread.ok()) {
+    return worker_thread.status();
+  }
+  // The audio and thread settings used by the factory must match the shared
+  // context configuration, which was checked before this call. The audio device
+  // module is shared by every client of the context, so it does not record into
+  // any one client's metrics.
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
+      peer_connection_factory = peer_connection_factory_provider_(
+          signaling_thread->get(), worker_thread->get(), api_config,
+          /*metrics=*/nullptr);
+  if (peer_connection_factory == nullptr) {
+    return absl::InternalError("Failed to create peer connection factory");
+  }
+  shared_contexts_.push_back(rtc::make_ref_counted<SharedPeerConnectionContext>(
+      *std::move(signaling_thread), *std::move(worker_thread),
+      std::move(peer_connection_factory)));
+  if (thread_watchdog_ != nullptr) {
+    thread_watchdog_->Watch(shared_contexts_.back()->signaling_thread(),
+                            "shared_signaling_thread");
+    thread_watchdog_->Watch(shared_contexts_.back()->worker_thread(),
+                            "shared_worker_thread");
+  }
+  next_shared_context_ = (index + 1) % shared_context_config_->context_count;
+  return shared_contexts_.back();
+}
+
+absl::Status MediaApiClientFactory::ValidateConfiguration(
+    const MediaApiClientConfiguration& api_config) const {
   if (api_config.receiving_video_stream_count > kMaxReceivingVideoStreamCount) {
     return absl::InvalidArgumentError(absl::StrCat(
         "Receiving video stream count must be less than or equal to ",
         kMaxReceivingVideoStreamCount, "; got ",
         api_config.receiving_video_stream_count));
   }
-  std::unique_ptr<rtc::Thread> client_thread = rtc::Thread::Create();
-  client_thread->SetName("media_api_client_internal_thread", nullptr);
-  if (!client_thread->Start()) {
-    return absl::InternalError("Failed to start client thread");
+  if (api_config.audio_sampling_interval_ms == 0 ||
+      api_config.audio_sampling_interval_ms > kMaxAudioSamplingIntervalMs ||
+      api_config.audio_sampling_interval_ms % kAudioFrameDurationMs != 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Audio sampling interval must be a multiple of ", kAudioFrameDurationMs,
+        "ms between ", kAudioFrameDurationMs, "ms and ",
+        kMaxAudioSamplingIntervalMs, "ms; got ",
+        api_config.audio_sampling_interval_ms, "ms"));
+  }
+  if (api_config.audio_aggregation_window_ms > kMaxAudioAggregationWindowMs ||
+      api_config.audio_aggregation_window_ms % kAudioFrameDurationMs != 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Audio aggregation window must be a multiple of ",
+        kAudioFrameDurationMs, "ms of at most ", kMaxAudioAggregationWindowMs,
+        "ms; got ", api_config.audio_aggregation_window_ms, "ms"));
+  }
+  if (api_config.ice.candidate_pool_size > kMaxIceCandidatePoolSize) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "ICE candidate pool size must be less than or equal to ",
+        kMaxIceCandidatePoolSize, "; got ",
+        api_config.ice.candidate_pool_size));
+  }
+  if (absl::Status status =
+          ValidateVideoSinkConstraints(api_config.video_sink_constraints);
+      !status.ok()) {
+    return status;
   }
-  std::unique_ptr<rtc::Thread> signaling_thread = rtc::Thread::Create();
-  signaling_thread->SetName("media_api_client_signaling_thread", nullptr);
-  if (!signaling_thread->Start()) {
-    return absl::InternalError("Failed to start signaling thread");
+  const DataChannelsConfiguration& data_channels = api_config.data_channels;
+  if (!IsOrderedAndReliable(data_channels.media_entries) ||
+      !IsOrderedAndReliable(data_channels.participants) ||
+      !IsOrderedAndReliable(data_channels.session_control) ||
+      !IsOrderedAndReliable(data_channels.video_assignment)) {
+    return absl::InvalidArgumentError(
+        "Only the media stats data channel may be unordered or unreliable");
   }
-  std::unique_ptr<rtc::Thread> worker_thread = rtc::Thread::Create();
-  worker_thread->SetName("media_api_client_worker_thread", nullptr);
-  if (!worker_thread->Start()) {
-    return absl::InternalError("Failed to start worker thread");
+  if (api_config.delta_encoded_stats &&
+      !IsOrderedAndReliable(data_channels.media_stats)) {
+    return absl::InvalidArgumentError(
+        "Delta encoded stats require an ordered and reliable media stats data "
+        "channel");
   }
+  if (absl::Status status = ValidateThread("Client", api_config.threads.client);
+      !status.ok()) {
+    return status;
+  }
+  if (absl::Status status =
+          ValidateThread("Signaling", api_config.threads.signaling);
+      !status.ok()) {
+    return status;
+  }
+  if (absl::Status status = ValidateThread("Worker", api_config.threads.worker);
+      !status.ok()) {
+    return status;
+  }
+  if (shared_context_config_.has_value()) {
+    if (shared_context_config_->context_count <= 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Shared context count must be positive; got ",
+                       shared_context_config_->context_count));
+    }
+    if (api_config.audio_sampling_interval_ms !=
+            shared_context_config_->audio_sampling_interval_ms ||
+        api_config.sink_only_audio != shared_context_config_->sink_only_audio) {
+      return absl::InvalidArgumentError(
+          "Audio settings must match the shared context configuration");
+    }
+    if (api_config.hardware_video_decoder_factory_provider !=
+        shared_context_config_->hardware_video_decoder_factory_provider) {
+      return absl::InvalidArgumentError(
+          "Hardware video decoder factory provider must match the shared "
+          "context configuration");
+    }
+    if (api_config.threads.signaling !=
+            shared_context_config_->signaling_thread ||
+        api_config.threads.worker != shared_context_config_->worker_thread ||
+        api_config.threads.network_thread !=
+            shared_context_config_->network_thread) {
+      return absl::InvalidArgumentError(
+          "Signaling, worker and network thread settings must match the shared "
+          "context configuration");
+    }
+  }
+  return absl::OkStatus();
+}
 
+absl::Status MediaApiClientFactory::EnableClientPool(
+    ClientPoolConfiguration pool_config) {
+  if (pool_config.size <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Client pool size must be positive; got ", pool_config.size));
+  }
+  if (pool_config.max_idle_time <= absl::ZeroDuration()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Client pool max idle time must be positive; got ",
+                     absl::FormatDuration(pool_config.max_idle_time)));
+  }
+  if (absl::Status status = ValidateConfiguration(pool_config.api_config);
+      !status.ok()) {
+    return status;
+  }
+  if (pool_thread_ != nullptr) {
+    return absl::FailedPreconditionError("Client pool is already enabled");
+  }
+  absl::StatusOr<std::unique_ptr<rtc::Thread>> pool_thread =
+      StartThread("media_api_client_pool_thread", "client pool thread");
+  if (!pool_thread.ok()) {
+    return pool_thread.status();
+  }
+  // The pool thread is set first, since it is used once the configuration is
+  // visible to `TakePooledClient`.
+  pool_thread_ = *std::move(pool_thread);
+  {
+    absl::MutexLock lock(&mutex_);
+    client_pool_config_ = std::move(pool_config);
+  }
+  pool_thread_->PostTask([this] { MaintainClientPool(); });
+  return absl::OkStatus();
+}
+
+void MediaApiClientFactory::MaintainClientPool() {
+  DCHECK(pool_thread_->IsCurrent());
+  RefillClientPool();
+  // Refilling also replaces clients that have been idle for too long, so
+  // refill periodically even if no clients are taken from the pool.
+  absl::Duration max_idle_time;
+  {
+    absl::MutexLock lock(&mutex_);
+    max_idle_time = client_pool_config_->max_idle_time;
+  }
+  pool_thread_->PostDelayedTask(
+      [this] { MaintainClientPool(); },
+      webrtc::TimeDelta::Micros(absl::ToInt64Microseconds(max_idle_time)));
+}
+
+void MediaApiClientFactory::RefillClientPool() {
+  DCHECK(pool_thread_->IsCurrent());
+  while (true) {
+    // Clients are destroyed outside of the lock, since destroying a client
+    // blocks on its threads.
+    std::vector<PooledClient> expired_clients;
+    MediaApiClientConfiguration api_config;
+    {
+      absl::MutexLock lock(&mutex_);
+      absl::Time now = absl::Now();
+      // Clients are added in the order they are created, so the oldest clients
+      // are at the front.
+      while (!pooled_clients_.empty() &&
+             now - pooled_clients_.front().created_at >
+                 client_pool_config_->max_idle_time) {
+        expired_clients.push_back(std::move(pooled_clients_.front()));
+        pooled_clients_.pop_front();
+      }
+      if (static_cast<int>(pooled_clients_.size()) >=
+          client_pool_config_->size) {
+        return;
+      }
+      api_config = client_pool_config_->api_config;
+    }
+
+    auto deferred_observer = rtc::make_ref_counted<DeferredObserver>();
+    absl::StatusOr<std::unique_ptr<MediaApiClientInterface>> client =
+        CreateClient(api_config, deferred_observer,
+                     /*prepare_local_description=*/true);
+    if (!client.ok()) {
+      // Retry the next time the pool is refilled rather than spinning on a
+      // persistent failure.
+      LOG(WARNING) << "Failed to create pooled client: " << client.status();
+      return;
+    }
+    absl::MutexLock lock(&mutex_);
+    pooled_clients_.push_back({.client = *std::move(client),
+                               .observer = std::move(deferred_observer),
+                               .created_at = absl::Now()});
+  }
+}
+
+std::unique_ptr<MediaApiClientInterface>
+MediaApiClientFactory::TakePooledClient(
+    const MediaApiClientConfiguration& api_config,
+    rtc::scoped_refptr<MediaApiClientObserverInterface>& observer) {
+  std::vector<PooledClient> expired_clients;
+  std::optional<PooledClient> pooled_client;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!client_pool_config_.has_value() ||
+        client_pool_config_->api_config != api_config) {
+      return nullptr;
+    }
+    absl::Time now = absl::Now();
+    while (!pooled_clients_.empty() && !pooled_client.has_value()) {
+      PooledClient& front = pooled_clients_.front();
+      if (now - front.created_at > client_pool_config_->max_idle_time) {
+        expired_clients.push_back(std::move(front));
+      } else {
+        pooled_client = std::move(front);
+      }
+      pooled_clients_.pop_front();
+    }
+  }
+  pool_thread_->PostTask([this] { RefillClientPool(); });
+
+  if (!pooled_client.has_value()) {
+    return nullptr;
+  }
+  pooled_client->observer->SetObserver(std::move(observer));
+  return std::move(pooled_client->client);
+}
+
+absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+MediaApiClientFactory::CreateMediaApiClient(
+    const MediaApiClientConfiguration& api_config,
+    rtc::scoped_refptr<MediaApiClientObserverInterface> observer) {
+  return CreateMediaApiClient(api_config, std::move(observer),
+                              /*track_factory=*/std::nullopt);
+}
+
+absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+MediaApiClientFactory::CreateMediaApiClient(
+    const MediaApiClientConfiguration& api_config,
+    rtc::scoped_refptr<MediaApiClientObserverInterface> observer,
+    std::optional<MediaTrackFactory> track_factory) {
+  if (absl::Status status = ValidateConfiguration(api_config); !status.ok()) {
+    return status;
+  }
+  if (std::unique_ptr<MediaApiClientInterface> pooled_client =
+          TakePooledClient(api_config, observer);
+      pooled_client != nullptr) {
+    return pooled_client;
+  }
+  return CreateClient(api_config, std::move(observer),
+                      /*prepare_local_description=*/false,
+                      std::move(track_factory));
+}
+
+absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+MediaApiClientFactory::CreateClient(
+    const MediaApiClientConfiguration& api_config,
+    rtc::scoped_refptr<MediaApiClientObserverInterface> observer,
+    bool prepare_local_description,
+    std::optional<MediaTrackFactory> track_factory) {
+  auto metrics = std::make_shared<MetricsRegistry>();
+  rtc::scoped_refptr<ObserverDispatcher> observer_dispatcher;
+  if (api_config.observer_dispatch.worker_thread_count > 0) {
+    // Frames must reach the dispatcher rather than the wrapped observer.
+    track_factory.reset();
+    absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+        ObserverDispatcher::Create(std::move(observer),
+                                   api_config.observer_dispatch, metrics);
+    if (!dispatcher.ok()) {
+      return dispatcher.status();
+    }
+    observer_dispatcher = *std::move(dispatcher);
+    observer = observer_dispatcher;
+  }
+
+  absl::StatusOr<std::unique_ptr<rtc::Thread>> client_thread =
+      StartThread("media_api_client_internal_thread", "client thread",
+                  api_config.threads.client);
+  if (!client_thread.ok()) {
+    return client_thread.status();
+  }
+
+  // Without a shared context, the client owns its signaling and worker threads
+  // and they are left null otherwise.
+  std::unique_ptr<rtc::Thread> signaling_thread;
+  std::unique_ptr<rtc::Thread> worker_thread;
+  rtc::scoped_refptr<SharedPeerConnectionContext> shared_context;
   rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
-      peer_connection_factory = peer_connection_factory_provider_(
-          signaling_thread.get(), worker_thread.get());
+      peer_connection_factory;
+  if (shared_context_config_.has_value()) {
+    absl::StatusOr<rtc::scoped_refptr<SharedPeerConnectionContext>>
+        shared_context_status = GetSharedContext(api_config);
+    if (!shared_context_status.ok()) {
+      return shared_context_status.status();
+    }
+    shared_context = *std::move(shared_context_status);
+    peer_connection_factory = shared_context->peer_connection_factory();
+  } else {
+    absl::StatusOr<std::unique_ptr<rtc::Thread>> signaling_thread_status =
+        StartThread("media_api_client_signaling_thread", "signaling thread",
+                    api_config.threads.signaling);
+    if (!signaling_thread_status.ok()) {
+      return signaling_thread_status.status();
+    }
+    signaling_thread = *std::move(signaling_thread_status);
+    absl::StatusOr<std::unique_ptr<rtc::Thread>> worker_thread_status =
+        StartThread("media_api_client_worker_thread", "worker thread",
+                    api_config.threads.worker);
+    if (!worker_thread_status.ok()) {
+      return worker_thread_status.status();
+    }
+    worker_thread = *std::move(worker_thread_status);
+    peer_connection_factory = peer_connection_factory_provider_(
+        signaling_thread.get(), worker_thread.get(), api_config, metrics);
+  }
 
   std::unique_ptr<HttpConnectorInterface> curl_connector =
       http_connector_provider_();
-  auto conference_peer_connection = std::make_unique<ConferencePeerConnection>(
-      std::move(signaling_thread), std::move(curl_connector));
+  std::unique_ptr<ConferencePeerConnection> conference_peer_connection;
+  if (shared_context != nullptr) {
+    conference_peer_connection = std::make_unique<ConferencePeerConnection>(
+        shared_context->signaling_thread(), std::move(curl_connector), metrics,
+        api_config.max_ice_restarts);
+  } else {
+    conference_peer_connection = std::make_unique<ConferencePeerConnection>(
+        std::move(signaling_thread), std::move(curl_connector), metrics,
+        api_config.max_ice_restarts);
+  }
+  if (api_config.access_token_provider != nullptr) {
+    conference_peer_connection->SetAccessTokenProvider(
+        [access_token_provider = api_config.access_token_provider](
+            absl::AnyInvocable<void(absl::StatusOr<std::string>) &&>
+                callback) {
+          access_token_provider->GetAccessToken(std::move(callback));
+        });
+  }
   auto peer_connection_status =
       peer_connection_factory->CreatePeerConnectionOrError(
-          GetRtcConfiguration(),
+          GetRtcConfiguration(api_config),
           webrtc::PeerConnectionDependencies(conference_peer_connection.get()));
   if (!peer_connection_status.ok()) {
     return absl::InternalError(
@@ -268,25 +957,80 @@ MediaApiClientFactory::CreateMediaApiClient(
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_connection =
       std::move(peer_connection_status).value();
 
-  absl::Status configure_transceivers_status =
-      ConfigureTransceivers(*peer_connection, api_config.enable_audio_streams,
-                            api_config.receiving_video_stream_count);
+  rtc::scoped_refptr<webrtc::FrameTransformerInterface> audio_frame_transformer;
+  if (api_config.encoded_audio_passthrough) {
+    audio_frame_transformer =
+        rtc::make_ref_counted<EncodedAudioFrameTransformer>(std::bind_front(
+            &MediaApiClientObserverInterface::OnEncodedAudioFrame, observer));
+  }
+  rtc::scoped_refptr<webrtc::FrameTransformerInterface> video_frame_transformer;
+  if (api_config.encoded_video_passthrough) {
+    video_frame_transformer =
+        rtc::make_ref_counted<EncodedVideoFrameTransformer>(std::bind_front(
+            &MediaApiClientObserverInterface::OnEncodedVideoFrame, observer));
+  }
+  std::vector<webrtc::RtpCodecCapability> video_codec_preferences;
+  if (!api_config.video_codec_preferences.empty()) {
+    absl::StatusOr<std::vector<webrtc::RtpCodecCapability>> preferences =
+        GetVideoCodecPreferences(*peer_connection_factory,
+                                 api_config.video_codec_preferences);
+    if (!preferences.ok()) {
+      return preferences.status();
+    }
+    video_codec_preferences = *std::move(preferences);
+  }
+  absl::Status configure_transceivers_status = ConfigureTransceivers(
+      *peer_connection, api_config.enable_audio_streams,
+      api_config.receiving_video_stream_count, video_codec_preferences,
+      std::move(audio_frame_transformer), std::move(video_frame_transformer),
+      api_config.latency_profile == LatencyProfile::kArchival
+          ? std::optional<double>(kArchivalJitterBufferMinimumDelaySeconds)
+          : std::nullopt);
   if (!configure_transceivers_status.ok()) {
     return configure_transceivers_status;
   }
 
   absl::StatusOr<MediaApiClient::ConferenceDataChannels>
-      conference_data_channels = CreateDataChannels(*peer_connection);
+      conference_data_channels =
+          CreateDataChannels(*peer_connection, metrics,
+                             api_config.data_channel_message_recorder,
+                             api_config.data_channels,
+                             api_config.resource_subscriptions);
   if (!conference_data_channels.ok()) {
     return conference_data_channels.status();
   }
 
   conference_peer_connection->SetPeerConnection(std::move(peer_connection));
+  if (prepare_local_description) {
+    if (absl::Status status =
+            conference_peer_connection->PrepareLocalDescription();
+        !status.ok()) {
+      return status;
+    }
+  }
 
-  return std::make_unique<MediaApiClient>(
-      std::move(client_thread), std::move(worker_thread), std::move(observer),
+  auto client = std::make_unique<MediaApiClient>(
+      *std::move(client_thread), std::move(worker_thread), std::move(observer),
       std::move(conference_peer_connection),
-      std::move(conference_data_channels).value());
+      std::move(conference_data_channels).value(), std::move(shared_context),
+      api_config.delta_encoded_stats, std::move(metrics),
+      absl::Milliseconds(api_config.video_assignment_coalescing_window_ms),
+      absl::Milliseconds(api_config.audio_aggregation_window_ms));
+  if (track_factory.has_value()) {
+    client->SetMediaTrackFactory(*std::move(track_factory));
+  }
+  if (observer_dispatcher != nullptr) {
+    client->SetObserverDispatcher(std::move(observer_dispatcher));
+  }
+  if (thread_watchdog_ != nullptr) {
+    client->SetThreadWatchdog(thread_watchdog_);
+  }
+  if (absl::Status status =
+          client->SetVideoSinkConstraints(api_config.video_sink_constraints);
+      !status.ok()) {
+    return status;
+  }
+  return client;
 }
 
 }  // namespace meet
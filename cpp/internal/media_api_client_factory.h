@@ -17,14 +17,27 @@
 #ifndef CPP_INTERNAL_MEDIA_API_CLIENT_FACTORY_H_
 #define CPP_INTERNAL_MEDIA_API_CLIENT_FACTORY_H_
 
+#include <concepts>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/functional/any_invocable.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "cpp/api/media_api_client_factory_interface.h"
 #include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/deferred_observer.h"
 #include "cpp/internal/http_connector_interface.h"
+#include "cpp/internal/media_api_client.h"
+#include "cpp/internal/metrics_registry.h"
+#include "cpp/internal/shared_peer_connection_context.h"
+#include "cpp/internal/thread_watchdog.h"
 #include "webrtc/api/peer_connection_interface.h"
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/rtc_base/thread.h"
@@ -33,31 +46,182 @@ namespace meet {
 
 class MediaApiClientFactory : public MediaApiClientFactoryInterface {
  public:
+  // `metrics` is the registry of the client being created, or null when the
+  // factory is shared by several clients.
   using PeerConnectionFactoryProvider = absl::AnyInvocable<
       rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>(
-          rtc::Thread* signaling_thread, rtc::Thread* worker_thread)>;
+          rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+          const MediaApiClientConfiguration& api_config,
+          std::shared_ptr<MetricsRegistry> metrics)>;
   using HttpConnectorProvider =
       absl::AnyInvocable<std::unique_ptr<HttpConnectorInterface>()>;
 
+  // Configuration for factories whose clients share threads and peer
+  // connection factories.
+  //
+  // By default, each client starts its own signaling and worker threads and
+  // peer connection factory. Applications running many conferences at once can
+  // instead spread clients across a fixed number of shared contexts, each
+  // with one signaling thread, one worker thread, and one peer connection
+  // factory. Each client still has its own internal thread, since connecting
+  // blocks it until the conference is joined.
+  struct SharedContextConfiguration {
+    // The number of shared contexts. Clients are assigned to contexts in turn.
+    int context_count = 1;
+    // Audio settings of the shared contexts' audio device modules. See
+    // `MediaApiClientConfiguration`. Since the audio device module is shared,
+    // clients must be created with the same settings.
+    uint32_t audio_sampling_interval_ms = 10;
+    bool sink_only_audio = false;
+    // Provider of the shared contexts' hardware video decoders. See
+    // `MediaApiClientConfiguration`. Clients must be created with the same
+    // provider.
+    std::shared_ptr<HardwareVideoDecoderFactoryProviderInterface>
+        hardware_video_decoder_factory_provider;
+    // Scheduling of the shared contexts' signaling and worker threads, and the
+    // network thread of their peer connection factories. See
+    // `MediaApiClientConfiguration::threads`. Since these threads are shared,
+    // clients must be created with the same settings.
+    ThreadConfiguration signaling_thread;
+    ThreadConfiguration worker_thread;
+    rtc::Thread* network_thread = nullptr;
+  };
+
+  // Configuration for keeping pre-created clients ready to connect.
+  //
+  // Pooled clients have already started their threads, created their peer
+  // connections, transceivers and data channels, and generated their local
+  // offers. Connecting a pooled client therefore only needs to signal the offer
+  // to Meet servers and apply the answer.
+  struct ClientPoolConfiguration {
+    // The number of clients to keep ready.
+    int size = 1;
+    // The configuration of pooled clients. Only `CreateMediaApiClient` calls
+    // with an equal configuration are served from the pool; other calls
+    // create a new client as usual.
+    MediaApiClientConfiguration api_config;
+    // How long a pooled client may wait to be used. Clients that have been
+    // idle for longer are replaced rather than handed out, since the network
+    // state captured in their offers may have gone stale.
+    absl::Duration max_idle_time = absl::Minutes(5);
+  };
+
   // Default constructor that builds clients with real dependencies.
   MediaApiClientFactory();
 
+  // Constructor that builds clients with real dependencies and shares contexts
+  // between them.
+  explicit MediaApiClientFactory(
+      SharedContextConfiguration shared_context_config);
+
   // Constructor with dependency providers, useful for testing.
   explicit MediaApiClientFactory(
       PeerConnectionFactoryProvider peer_connection_factory_provider,
-      HttpConnectorProvider http_connector_provider)
+      HttpConnectorProvider http_connector_provider,
+      std::optional<SharedContextConfiguration> shared_context_config =
+          std::nullopt)
       : peer_connection_factory_provider_(
             std::move(peer_connection_factory_provider)),
-        http_connector_provider_(std::move(http_connector_provider)) {}
+        http_connector_provider_(std::move(http_connector_provider)),
+        shared_context_config_(std::move(shared_context_config)) {}
+
+  ~MediaApiClientFactory() override;
+
+  // Starts keeping `pool_config.size` clients ready, and serves matching
+  // `CreateMediaApiClient` calls from them. Taken clients are replaced in the
+  // background. May only be called once.
+  absl::Status EnableClientPool(ClientPoolConfiguration pool_config);
+
+  // Watches the threads of every client created afterwards, and of the shared
+  // contexts, with `thread_watchdog`. Must be called before any client is
+  // created or the pool is enabled, since it is not synchronized with them.
+  void SetThreadWatchdog(std::shared_ptr<ThreadWatchdog> thread_watchdog) {
+    thread_watchdog_ = std::move(thread_watchdog);
+  }
 
   absl::StatusOr<std::unique_ptr<MediaApiClientInterface>> CreateMediaApiClient(
       const MediaApiClientConfiguration& api_config,
       rtc::scoped_refptr<MediaApiClientObserverInterface> api_session_observer)
       override;
 
+  // Like `CreateMediaApiClient`, but received audio and video frames are
+  // delivered by calling `Observer` directly, without a type-erased callback.
+  // If `Observer` declares its `OnAudioFrame` and `OnVideoFrame` overrides
+  // final, they are not virtual calls either and can be inlined into the frame
+  // path.
+  //
+  // Pooled clients and clients dispatching to observer worker threads deliver
+  // frames through their observer wrappers, so they call the observer through
+  // the observer interface as usual.
+  template <typename Observer>
+    requires std::derived_from<Observer, MediaApiClientObserverInterface>
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+  CreateMediaApiClientWithStaticDispatch(
+      const MediaApiClientConfiguration& api_config,
+      rtc::scoped_refptr<Observer> api_session_observer) {
+    MediaTrackFactory track_factory =
+        MakeMediaTrackFactory(api_session_observer);
+    return CreateMediaApiClient(api_config, std::move(api_session_observer),
+                                std::move(track_factory));
+  }
+
  private:
+  struct PooledClient {
+    std::unique_ptr<MediaApiClientInterface> client;
+    // Forwards the client's callbacks to the observer of the caller that
+    // takes the client.
+    rtc::scoped_refptr<DeferredObserver> observer;
+    absl::Time created_at;
+  };
+
+  absl::Status ValidateConfiguration(
+      const MediaApiClientConfiguration& api_config) const;
+  // Creates a client, whose tracks are created by `track_factory` if set.
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>> CreateMediaApiClient(
+      const MediaApiClientConfiguration& api_config,
+      rtc::scoped_refptr<MediaApiClientObserverInterface> observer,
+      std::optional<MediaTrackFactory> track_factory);
+  // Creates a client. If `prepare_local_description` is true, the client's
+  // offer is generated before it is returned. `track_factory` is ignored if
+  // the observer is wrapped by an observer dispatcher.
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>> CreateClient(
+      const MediaApiClientConfiguration& api_config,
+      rtc::scoped_refptr<MediaApiClientObserverInterface> observer,
+      bool prepare_local_description,
+      std::optional<MediaTrackFactory> track_factory = std::nullopt);
+  // Returns a pooled client for `api_config` that reports to `observer`, or
+  // null if there is none.
+  std::unique_ptr<MediaApiClientInterface> TakePooledClient(
+      const MediaApiClientConfiguration& api_config,
+      rtc::scoped_refptr<MediaApiClientObserverInterface>& observer);
+  // Replaces expired pooled clients and creates clients until the pool is
+  // full. Runs on the pool thread.
+  void RefillClientPool();
+  // Refills the pool and schedules the next refill.
+  void MaintainClientPool();
+
+  // Returns the shared context for the next client, creating it if needed.
+  absl::StatusOr<rtc::scoped_refptr<SharedPeerConnectionContext>>
+  GetSharedContext(const MediaApiClientConfiguration& api_config);
+
   PeerConnectionFactoryProvider peer_connection_factory_provider_;
   HttpConnectorProvider http_connector_provider_;
+  std::optional<SharedContextConfiguration> shared_context_config_;
+  // Null if threads are not watched.
+  std::shared_ptr<ThreadWatchdog> thread_watchdog_;
+
+  absl::Mutex mutex_;
+  // Contexts are created when they are first assigned a client, so that
+  // factories that are never used do not start threads.
+  std::vector<rtc::scoped_refptr<SharedPeerConnectionContext>> shared_contexts_
+      ABSL_GUARDED_BY(mutex_);
+  int next_shared_context_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::optional<ClientPoolConfiguration> client_pool_config_
+      ABSL_GUARDED_BY(mutex_);
+  std::deque<PooledClient> pooled_clients_ ABSL_GUARDED_BY(mutex_);
+  // Creates pooled clients, so that `CreateMediaApiClient` does not wait for
+  // the pool to be refilled. Null until the pool is enabled.
+  std::unique_ptr<rtc::Thread> pool_thread_;
 };
 
 }  // namespace meet
@@ -16,35 +16,49 @@
 
 #include "cpp/internal/media_api_client_factory.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/internal/http_connector_interface.h"
+#include "cpp/internal/metrics_registry.h"
 #include "cpp/internal/testing/mock_media_api_client_observer.h"
 #include "webrtc/api/data_channel_interface.h"
 #include "webrtc/api/make_ref_counted.h"
 #include "webrtc/api/media_types.h"
 #include "webrtc/api/peer_connection_interface.h"
+#include "webrtc/api/priority.h"
 #include "webrtc/api/rtc_error.h"
+#include "webrtc/api/rtp_parameters.h"
 #include "webrtc/api/rtp_transceiver_interface.h"
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/test/mock_data_channel.h"
 #include "webrtc/api/test/mock_peer_connection_factory_interface.h"
 #include "webrtc/api/test/mock_peerconnectioninterface.h"
 #include "webrtc/api/test/mock_rtp_transceiver.h"
+#include "webrtc/api/test/mock_rtpreceiver.h"
+#include "webrtc/api/video_codecs/video_decoder_factory.h"
 #include "webrtc/rtc_base/thread.h"
 
 namespace meet {
 namespace {
 
 using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::NotNull;
+using ::testing::Optional;
 using ::testing::Return;
 using ::testing::status::StatusIs;
 
@@ -105,7 +119,9 @@ TEST(MediaApiClientFactoryTest,
               webrtc::MockDataChannelInterface::Create())));
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -125,6 +141,172 @@ TEST(MediaApiClientFactoryTest,
   EXPECT_TRUE(media_api_client_status.ok());
 }
 
+TEST(MediaApiClientFactoryTest,
+     InstallsFrameTransformerOnAudioReceiversForEncodedAudioPassthrough) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  rtc::scoped_refptr<webrtc::MockPeerConnectionInterface> peer_connection =
+      rtc::make_ref_counted<webrtc::MockPeerConnectionInterface>();
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(Return(
+          static_cast<rtc::scoped_refptr<webrtc::PeerConnectionInterface>>(
+              peer_connection)));
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> audio_receiver =
+      rtc::make_ref_counted<webrtc::MockRtpReceiver>();
+  EXPECT_CALL(*audio_receiver,
+              SetDepacketizerToDecoderFrameTransformer(NotNull()))
+      .Times(3);
+  EXPECT_CALL(*peer_connection,
+              AddTransceiver(cricket::MediaType::MEDIA_TYPE_AUDIO, _))
+      .Times(3)
+      .WillRepeatedly([&](cricket::MediaType media_type,
+                          const webrtc::RtpTransceiverInit& init) {
+        rtc::scoped_refptr<webrtc::MockRtpTransceiver> transceiver =
+            webrtc::MockRtpTransceiver::Create();
+        EXPECT_CALL(*transceiver, receiver)
+            .WillOnce(Return(
+                static_cast<rtc::scoped_refptr<webrtc::RtpReceiverInterface>>(
+                    audio_receiver)));
+        return static_cast<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>(
+            transceiver);
+      });
+  EXPECT_CALL(*peer_connection,
+              AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO, _))
+      .Times(3)
+      .WillRepeatedly([](cricket::MediaType media_type,
+                         const webrtc::RtpTransceiverInit& init) {
+        return static_cast<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>(
+            webrtc::MockRtpTransceiver::Create());
+      });
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("media-entries", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("media-stats", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("participants", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("session-control", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("video-assignment", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .enable_audio_streams = true,
+              .encoded_audio_passthrough = true,
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_TRUE(media_api_client_status.ok());
+}
+
+TEST(MediaApiClientFactoryTest,
+     InstallsFrameTransformerOnVideoReceiversForEncodedVideoPassthrough) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  rtc::scoped_refptr<webrtc::MockPeerConnectionInterface> peer_connection =
+      rtc::make_ref_counted<webrtc::MockPeerConnectionInterface>();
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(Return(
+          static_cast<rtc::scoped_refptr<webrtc::PeerConnectionInterface>>(
+              peer_connection)));
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> video_receiver =
+      rtc::make_ref_counted<webrtc::MockRtpReceiver>();
+  EXPECT_CALL(*video_receiver,
+              SetDepacketizerToDecoderFrameTransformer(NotNull()))
+      .Times(3);
+  EXPECT_CALL(*peer_connection,
+              AddTransceiver(cricket::MediaType::MEDIA_TYPE_AUDIO, _))
+      .Times(3)
+      .WillRepeatedly([](cricket::MediaType media_type,
+                         const webrtc::RtpTransceiverInit& init) {
+        return static_cast<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>(
+            webrtc::MockRtpTransceiver::Create());
+      });
+  EXPECT_CALL(*peer_connection,
+              AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO, _))
+      .Times(3)
+      .WillRepeatedly([&](cricket::MediaType media_type,
+                          const webrtc::RtpTransceiverInit& init) {
+        rtc::scoped_refptr<webrtc::MockRtpTransceiver> transceiver =
+            webrtc::MockRtpTransceiver::Create();
+        EXPECT_CALL(*transceiver, receiver)
+            .WillOnce(Return(
+                static_cast<rtc::scoped_refptr<webrtc::RtpReceiverInterface>>(
+                    video_receiver)));
+        return static_cast<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>(
+            transceiver);
+      });
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("media-entries", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("media-stats", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("participants", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("session-control", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError("video-assignment", _))
+      .WillOnce(
+          Return(static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+              webrtc::MockDataChannelInterface::Create())));
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .enable_audio_streams = true,
+              .encoded_video_passthrough = true,
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_TRUE(media_api_client_status.ok());
+}
+
 TEST(MediaApiClientFactoryTest, FailsIfReceivingVideoStreamCountIsTooHigh) {
   MediaApiClientFactory factory;
 
@@ -142,6 +324,690 @@ TEST(MediaApiClientFactoryTest, FailsIfReceivingVideoStreamCountIsTooHigh) {
                        "equal to 3; got 4"));
 }
 
+TEST(MediaApiClientFactoryTest, FailsIfAudioSamplingIntervalIsInvalid) {
+  MediaApiClientFactory factory;
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .enable_audio_streams = true,
+              .audio_sampling_interval_ms = 15,
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Audio sampling interval must be a multiple of 10ms "
+                       "between 10ms and 40ms; got 15ms"));
+}
+
+TEST(MediaApiClientFactoryTest, FailsIfAudioAggregationWindowIsInvalid) {
+  MediaApiClientFactory factory;
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .enable_audio_streams = true,
+              .audio_aggregation_window_ms = 1010,
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Audio aggregation window must be a multiple of 10ms "
+                       "of at most 1000ms; got 1010ms"));
+}
+
+TEST(MediaApiClientFactoryTest, FailsIfIceCandidatePoolSizeIsTooHigh) {
+  MediaApiClientFactory factory;
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .enable_audio_streams = true,
+              .ice = {.candidate_pool_size = 256},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "ICE candidate pool size must be less than or equal to "
+                       "255; got 256"));
+}
+
+TEST(MediaApiClientFactoryTest, FailsIfVideoSinkMaxPixelCountIsNotPositive) {
+  MediaApiClientFactory factory;
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .video_sink_constraints = {.max_pixel_count = 0},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Video sink max pixel count must be positive; got 0"));
+}
+
+TEST(MediaApiClientFactoryTest, FailsIfResourceDataChannelIsUnreliable) {
+  MediaApiClientFactory factory;
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .data_channels = {.participants = {.max_retransmits = 0}},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Only the media stats data channel may be unordered or "
+                       "unreliable"));
+}
+
+TEST(MediaApiClientFactoryTest,
+     FailsIfMediaStatsDataChannelIsUnorderedWithDeltaEncodedStats) {
+  MediaApiClientFactory factory;
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .delta_encoded_stats = true,
+              .data_channels = {.media_stats = {.ordered = false}},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Delta encoded stats require an ordered and reliable "
+                       "media stats data channel"));
+}
+
+TEST(MediaApiClientFactoryTest, FailsIfThreadConfigurationIsInvalid) {
+  MediaApiClientFactory factory;
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .threads = {.worker = {.nice_value = -1,
+                                     .realtime_priority = 10}},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Worker thread configuration is invalid: Threads "
+                       "cannot have both a nice value and a real-time "
+                       "priority"));
+}
+
+TEST(MediaApiClientFactoryTest, FailsIfThreadAffinityIsOutOfRange) {
+  MediaApiClientFactory factory;
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .threads = {.client = {.cpu_affinity = {-1}}},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Client thread configuration is invalid")));
+}
+
+TEST(MediaApiClientFactoryTest,
+     PassesDataChannelConfigurationToPeerConnection) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  rtc::scoped_refptr<webrtc::MockPeerConnectionInterface> peer_connection =
+      rtc::make_ref_counted<webrtc::MockPeerConnectionInterface>();
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(Return(
+          static_cast<rtc::scoped_refptr<webrtc::PeerConnectionInterface>>(
+              peer_connection)));
+  absl::flat_hash_map<std::string, webrtc::DataChannelInit> inits;
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError(_, NotNull()))
+      .Times(5)
+      .WillRepeatedly([&](const std::string& label,
+                          const webrtc::DataChannelInit* init) {
+        inits[label] = *init;
+        return static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+            webrtc::MockDataChannelInterface::Create());
+      });
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .data_channels =
+                  {.media_stats = {.ordered = false,
+                                   .max_retransmits = 2,
+                                   .priority = DataChannelPriority::kVeryLow}},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  ASSERT_TRUE(media_api_client_status.ok());
+  ASSERT_EQ(inits.size(), 5);
+  EXPECT_FALSE(inits["media-stats"].ordered);
+  EXPECT_EQ(inits["media-stats"].maxRetransmits, 2);
+  EXPECT_EQ(inits["media-stats"].priority,
+            webrtc::PriorityValue(webrtc::Priority::kVeryLow));
+  EXPECT_TRUE(inits["participants"].ordered);
+  EXPECT_FALSE(inits["participants"].maxRetransmits.has_value());
+  EXPECT_EQ(inits["participants"].priority,
+            webrtc::PriorityValue(webrtc::Priority::kLow));
+  EXPECT_TRUE(inits["session-control"].ordered);
+  EXPECT_EQ(inits["session-control"].priority,
+            webrtc::PriorityValue(webrtc::Priority::kHigh));
+}
+
+TEST(MediaApiClientFactoryTest, OnlyCreatesDataChannelsOfSubscribedResources) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  rtc::scoped_refptr<webrtc::MockPeerConnectionInterface> peer_connection =
+      rtc::make_ref_counted<webrtc::MockPeerConnectionInterface>();
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(Return(
+          static_cast<rtc::scoped_refptr<webrtc::PeerConnectionInterface>>(
+              peer_connection)));
+  std::vector<std::string> labels;
+  EXPECT_CALL(*peer_connection, CreateDataChannelOrError)
+      .WillRepeatedly([&](const std::string& label,
+                          const webrtc::DataChannelInit* init) {
+        labels.push_back(label);
+        return static_cast<rtc::scoped_refptr<webrtc::DataChannelInterface>>(
+            webrtc::MockDataChannelInterface::Create());
+      });
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .resource_subscriptions = {.participants = false,
+                                         .video_assignment = false},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  ASSERT_TRUE(media_api_client_status.ok());
+  EXPECT_THAT(labels,
+              ElementsAre("media-entries", "media-stats", "session-control"));
+}
+
+TEST(MediaApiClientFactoryTest, PassesIceConfigurationToPeerConnection) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  webrtc::PeerConnectionInterface::RTCConfiguration rtc_config;
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(
+          [&](const webrtc::PeerConnectionInterface::RTCConfiguration& config,
+              webrtc::PeerConnectionDependencies) {
+            rtc_config = config;
+            return webrtc::RTCError(webrtc::RTCErrorType::INTERNAL_ERROR,
+                                    "Failed to create peer connection");
+          });
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  (void)factory.CreateMediaApiClient(
+      MediaApiClientConfiguration{
+          .receiving_video_stream_count = 3,
+          .enable_audio_streams = true,
+          .ice = {.servers = {},
+                  .candidate_pool_size = 2,
+                  .continual_gathering = true,
+                  .disable_ipv6 = true,
+                  .disable_tcp_candidates = true},
+      },
+      rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_TRUE(rtc_config.servers.empty());
+  EXPECT_EQ(rtc_config.ice_candidate_pool_size, 2);
+  EXPECT_EQ(rtc_config.continual_gathering_policy,
+            webrtc::PeerConnectionInterface::GATHER_CONTINUALLY);
+  EXPECT_EQ(rtc_config.max_ipv6_networks, 0);
+  EXPECT_FALSE(rtc_config.disable_link_local_networks);
+  EXPECT_EQ(rtc_config.tcp_candidate_policy,
+            webrtc::PeerConnectionInterface::kTcpCandidatePolicyDisabled);
+}
+
+TEST(MediaApiClientFactoryTest, UsesMaxBundlePolicyByDefault) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  std::vector<webrtc::PeerConnectionInterface::BundlePolicy> bundle_policies;
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .Times(2)
+      .WillRepeatedly(
+          [&](const webrtc::PeerConnectionInterface::RTCConfiguration& config,
+              webrtc::PeerConnectionDependencies) {
+            bundle_policies.push_back(config.bundle_policy);
+            return webrtc::RTCError(webrtc::RTCErrorType::INTERNAL_ERROR,
+                                    "Failed to create peer connection");
+          });
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  (void)factory.CreateMediaApiClient(
+      MediaApiClientConfiguration{.enable_audio_streams = true},
+      rtc::make_ref_counted<MockMediaApiClientObserver>());
+  (void)factory.CreateMediaApiClient(
+      MediaApiClientConfiguration{.enable_audio_streams = true,
+                                  .max_bundle = false},
+      rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(bundle_policies,
+              ElementsAre(
+                  webrtc::PeerConnectionInterface::kBundlePolicyMaxBundle,
+                  webrtc::PeerConnectionInterface::kBundlePolicyBalanced));
+}
+
+webrtc::RtpCodecCapability CreateVideoCodec(absl::string_view name) {
+  webrtc::RtpCodecCapability codec;
+  codec.name = std::string(name);
+  codec.kind = cricket::MediaType::MEDIA_TYPE_VIDEO;
+  codec.clock_rate = 90000;
+  return codec;
+}
+
+TEST(MediaApiClientFactoryTest, ArchivalLatencyProfileEnlargesJitterBuffers) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  rtc::scoped_refptr<webrtc::MockPeerConnectionInterface> peer_connection =
+      rtc::make_ref_counted<webrtc::MockPeerConnectionInterface>();
+  webrtc::PeerConnectionInterface::RTCConfiguration rtc_config;
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(
+          [&](const webrtc::PeerConnectionInterface::RTCConfiguration& config,
+              webrtc::PeerConnectionDependencies) {
+            rtc_config = config;
+            return static_cast<
+                rtc::scoped_refptr<webrtc::PeerConnectionInterface>>(
+                peer_connection);
+          });
+  rtc::scoped_refptr<webrtc::MockRtpReceiver> receiver =
+      rtc::make_ref_counted<webrtc::MockRtpReceiver>();
+  EXPECT_CALL(*receiver, SetJitterBufferMinimumDelay(Optional(0.5))).Times(4);
+  EXPECT_CALL(*peer_connection, AddTransceiver(_, _))
+      .Times(4)
+      .WillRepeatedly([&](cricket::MediaType media_type,
+                          const webrtc::RtpTransceiverInit& init) {
+        rtc::scoped_refptr<webrtc::MockRtpTransceiver> transceiver =
+            webrtc::MockRtpTransceiver::Create();
+        EXPECT_CALL(*transceiver, receiver)
+            .WillOnce(Return(
+                static_cast<rtc::scoped_refptr<webrtc::RtpReceiverInterface>>(
+                    receiver)));
+        return static_cast<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>(
+            transceiver);
+      });
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  (void)factory.CreateMediaApiClient(
+      MediaApiClientConfiguration{
+          .receiving_video_stream_count = 1,
+          .enable_audio_streams = true,
+          .latency_profile = LatencyProfile::kArchival},
+      rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_EQ(rtc_config.audio_jitter_buffer_max_packets, 500);
+  EXPECT_FALSE(rtc_config.audio_jitter_buffer_fast_accelerate);
+}
+
+TEST(MediaApiClientFactoryTest, SetsVideoCodecPreferencesOnVideoTransceivers) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  webrtc::RtpCapabilities capabilities;
+  capabilities.codecs = {CreateVideoCodec("VP8"), CreateVideoCodec("VP9"),
+                         CreateVideoCodec("AV1"), CreateVideoCodec("rtx")};
+  EXPECT_CALL(*peer_connection_factory,
+              GetRtpReceiverCapabilities(cricket::MediaType::MEDIA_TYPE_VIDEO))
+      .WillOnce(Return(capabilities));
+  rtc::scoped_refptr<webrtc::MockPeerConnectionInterface> peer_connection =
+      rtc::make_ref_counted<webrtc::MockPeerConnectionInterface>();
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(Return(
+          static_cast<rtc::scoped_refptr<webrtc::PeerConnectionInterface>>(
+              peer_connection)));
+  EXPECT_CALL(*peer_connection,
+              AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO, _))
+      .Times(2)
+      .WillRepeatedly([](cricket::MediaType media_type,
+                         const webrtc::RtpTransceiverInit& init) {
+        auto transceiver = webrtc::MockRtpTransceiver::Create();
+        EXPECT_CALL(*transceiver,
+                    SetCodecPreferences(ElementsAre(CreateVideoCodec("AV1"),
+                                                    CreateVideoCodec("VP8"),
+                                                    CreateVideoCodec("rtx"))))
+            .WillOnce(Return(webrtc::RTCError::OK()));
+        return static_cast<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>(
+            transceiver);
+      });
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  (void)factory.CreateMediaApiClient(
+      MediaApiClientConfiguration{.receiving_video_stream_count = 2,
+                                  .video_codec_preferences = {"av1", "VP8"}},
+      rtc::make_ref_counted<MockMediaApiClientObserver>());
+}
+
+TEST(MediaApiClientFactoryTest, FailsIfVideoCodecPreferenceIsUnsupported) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  webrtc::RtpCapabilities capabilities;
+  capabilities.codecs = {CreateVideoCodec("VP8")};
+  EXPECT_CALL(*peer_connection_factory,
+              GetRtpReceiverCapabilities(cricket::MediaType::MEDIA_TYPE_VIDEO))
+      .WillOnce(Return(capabilities));
+  rtc::scoped_refptr<webrtc::MockPeerConnectionInterface> peer_connection =
+      rtc::make_ref_counted<webrtc::MockPeerConnectionInterface>();
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(Return(
+          static_cast<rtc::scoped_refptr<webrtc::PeerConnectionInterface>>(
+              peer_connection)));
+  EXPECT_CALL(*peer_connection, AddTransceiver).Times(0);
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{.receiving_video_stream_count = 1,
+                                      .video_codec_preferences = {"H264"}},
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Video codec preference H264 is not supported by the "
+                       "video decoders"));
+}
+
+TEST(MediaApiClientFactoryTest, PassesConfigurationToProvider) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce(Return(webrtc::RTCError(webrtc::RTCErrorType::INTERNAL_ERROR,
+                                        "Failed to create peer connection")));
+  uint32_t provided_audio_sampling_interval_ms = 0;
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    provided_audio_sampling_interval_ms = api_config.audio_sampling_interval_ms;
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .enable_audio_streams = true,
+              .audio_sampling_interval_ms = 40,
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_EQ(provided_audio_sampling_interval_ms, 40);
+}
+
+TEST(MediaApiClientFactoryTest, SharesPeerConnectionFactoriesAcrossClients) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .Times(3)
+      .WillRepeatedly(
+          Return(webrtc::RTCError(webrtc::RTCErrorType::INTERNAL_ERROR,
+                                  "Failed to create peer connection")));
+  std::vector<rtc::Thread*> signaling_threads;
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    signaling_threads.push_back(signaling_thread);
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(
+      std::move(peer_connection_factory_provider),
+      std::move(http_connector_provider),
+      MediaApiClientFactory::SharedContextConfiguration{.context_count = 2});
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_THAT(factory.CreateMediaApiClient(
+                    MediaApiClientConfiguration{
+                        .receiving_video_stream_count = 3,
+                        .enable_audio_streams = true,
+                    },
+                    rtc::make_ref_counted<MockMediaApiClientObserver>()),
+                StatusIs(absl::StatusCode::kInternal));
+  }
+
+  // The third client reuses the first context.
+  ASSERT_EQ(signaling_threads.size(), 2);
+  EXPECT_NE(signaling_threads[0], signaling_threads[1]);
+}
+
+TEST(MediaApiClientFactoryTest,
+     FailsIfAudioSettingsDoNotMatchSharedContextConfiguration) {
+  MediaApiClientFactory factory(
+      MediaApiClientFactory::SharedContextConfiguration{
+          .audio_sampling_interval_ms = 20});
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .enable_audio_streams = true,
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(
+      media_api_client_status,
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               "Audio settings must match the shared context configuration"));
+}
+
+class FakeHardwareVideoDecoderFactoryProvider
+    : public HardwareVideoDecoderFactoryProviderInterface {
+ public:
+  std::unique_ptr<webrtc::VideoDecoderFactory> Create() override {
+    return nullptr;
+  }
+};
+
+TEST(MediaApiClientFactoryTest,
+     FailsIfHardwareDecoderProviderDoesNotMatchSharedContextConfiguration) {
+  MediaApiClientFactory factory(
+      MediaApiClientFactory::SharedContextConfiguration{});
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .hardware_video_decoder_factory_provider =
+                  std::make_shared<FakeHardwareVideoDecoderFactoryProvider>(),
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Hardware video decoder factory provider must match the "
+                       "shared context configuration"));
+}
+
+TEST(MediaApiClientFactoryTest,
+     FailsIfThreadSettingsDoNotMatchSharedContextConfiguration) {
+  MediaApiClientFactory factory(
+      MediaApiClientFactory::SharedContextConfiguration{
+          .worker_thread = {.nice_value = -5}});
+
+  absl::StatusOr<std::unique_ptr<MediaApiClientInterface>>
+      media_api_client_status = factory.CreateMediaApiClient(
+          MediaApiClientConfiguration{
+              .receiving_video_stream_count = 3,
+              .threads = {.worker = {.nice_value = -10}},
+          },
+          rtc::make_ref_counted<MockMediaApiClientObserver>());
+
+  EXPECT_THAT(media_api_client_status,
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Signaling, worker and network thread settings must "
+                       "match the shared context configuration"));
+}
+
+TEST(MediaApiClientFactoryTest, EnableClientPoolCreatesClientsInBackground) {
+  rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
+      peer_connection_factory =
+          webrtc::MockPeerConnectionFactoryInterface::Create();
+  absl::Notification pooled_client_created;
+  EXPECT_CALL(*peer_connection_factory, CreatePeerConnectionOrError(_, _))
+      .WillOnce([&] {
+        pooled_client_created.Notify();
+        return webrtc::RTCError(webrtc::RTCErrorType::INTERNAL_ERROR,
+                                "Failed to create peer connection");
+      });
+  MediaApiClientFactory::PeerConnectionFactoryProvider
+      peer_connection_factory_provider =
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
+      -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
+    return peer_connection_factory;
+  };
+  MediaApiClientFactory::HttpConnectorProvider http_connector_provider = []() {
+    return std::make_unique<MockHttpConnector>();
+  };
+  MediaApiClientFactory factory(std::move(peer_connection_factory_provider),
+                                std::move(http_connector_provider));
+
+  EXPECT_TRUE(factory.EnableClientPool({.size = 1}).ok());
+
+  // The pooled client is created without waiting for `CreateMediaApiClient`.
+  EXPECT_TRUE(
+      pooled_client_created.WaitForNotificationWithTimeout(absl::Seconds(1)));
+}
+
+TEST(MediaApiClientFactoryTest, EnableClientPoolFailsIfSizeIsNotPositive) {
+  MediaApiClientFactory factory;
+
+  EXPECT_THAT(factory.EnableClientPool({.size = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Client pool size must be positive; got 0"));
+}
+
+TEST(MediaApiClientFactoryTest, EnableClientPoolFailsIfConfigurationIsInvalid) {
+  MediaApiClientFactory factory;
+
+  EXPECT_THAT(
+      factory.EnableClientPool(
+          {.api_config = {.receiving_video_stream_count = 4}}),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               "Receiving video stream count must be less than or equal to 3; "
+               "got 4"));
+}
+
 TEST(MediaApiClientFactoryTest, FailsIfPeerConnectionFactoryFailsToCreate) {
   rtc::scoped_refptr<webrtc::MockPeerConnectionFactoryInterface>
       peer_connection_factory =
@@ -151,7 +1017,9 @@ TEST(MediaApiClientFactoryTest, FailsIfPeerConnectionFactoryFailsToCreate) {
                                         "test error")));
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -193,7 +1061,9 @@ TEST(MediaApiClientFactoryTest, FailsIfAudioTransceiverFailsToBeCreated) {
       });
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -248,7 +1118,9 @@ TEST(MediaApiClientFactoryTest, FailsIfVideoTransceiverFailsToBeCreated) {
       });
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -303,7 +1175,9 @@ TEST(MediaApiClientFactoryTest,
                                         "test error")));
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -362,7 +1236,9 @@ TEST(MediaApiClientFactoryTest, FailsIfMediaStatsDataChannelFailsToBeCreated) {
                                         "test error")));
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -427,7 +1303,9 @@ TEST(MediaApiClientFactoryTest,
                                         "test error")));
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -495,7 +1373,9 @@ TEST(MediaApiClientFactoryTest,
                                         "test error")));
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -567,7 +1447,9 @@ TEST(MediaApiClientFactoryTest,
                                         "test error")));
   MediaApiClientFactory::PeerConnectionFactoryProvider
       peer_connection_factory_provider =
-          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread)
+          [&](rtc::Thread* signaling_thread, rtc::Thread* worker_thread,
+              const MediaApiClientConfiguration& api_config,
+              std::shared_ptr<MetricsRegistry> metrics)
       -> rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> {
     return peer_connection_factory;
   };
@@ -30,11 +30,13 @@
 #include "absl/base/log_severity.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/media_stats_resource.h"
+#include "cpp/api/participants_resource.h"
 #include "cpp/api/session_control_resource.h"
 #include "cpp/api/video_assignment_resource.h"
 #include "cpp/internal/conference_data_channel_interface.h"
@@ -63,13 +65,16 @@
 #include "webrtc/api/video/video_sink_interface.h"
 #include "webrtc/api/video/video_source_interface.h"
 #include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/time_utils.h"
 
 namespace meet {
 namespace {
 
 using ::base_logging::WARNING;
 using ::testing::_;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 using ::testing::kDoNotCaptureLogsYet;
 using ::testing::Return;
 using ::testing::ScopedMockLog;
@@ -91,9 +96,9 @@ class MockConferencePeerConnection : public ConferencePeerConnectionInterface {
     ON_CALL(*this, Close).WillByDefault(Return());
   }
 
-  MOCK_METHOD(absl::Status, Connect,
+  MOCK_METHOD(void, Connect,
               (absl::string_view join_endpoint, absl::string_view conference_id,
-               absl::string_view access_token),
+               absl::string_view access_token, ConnectCallback callback),
               (override));
   MOCK_METHOD(void, Close, (), (override));
   MOCK_METHOD(void, SetTrackSignaledCallback, (TrackSignaledCallback callback),
@@ -102,6 +107,7 @@ class MockConferencePeerConnection : public ConferencePeerConnectionInterface {
               (override));
   MOCK_METHOD(void, GetStats, (webrtc::RTCStatsCollectorCallback * callback),
               (override));
+  MOCK_METHOD(ConnectTimestamps, GetConnectTimestamps, (), (const, override));
 };
 
 class MockConferenceDataChannel : public ConferenceDataChannelInterface {
@@ -112,6 +118,13 @@ class MockConferenceDataChannel : public ConferenceDataChannelInterface {
 
   MOCK_METHOD(void, SetCallback, (ResourceUpdateCallback), (override));
   MOCK_METHOD(absl::Status, SendRequest, (ResourceRequest), (override));
+  MOCK_METHOD(std::optional<int64_t>, GetOpenedTimeUs, (), (const, override));
+};
+
+// Also mocks the `OnJoined` overload that receives join timings.
+class MockJoinTimingsObserver : public MockMediaApiClientObserver {
+ public:
+  MOCK_METHOD(void, OnJoined, (const JoinTimings& timings), (override));
 };
 
 MediaApiClient::ConferenceDataChannels CreateConferenceDataChannels() {
@@ -131,10 +144,13 @@ TEST(MediaApiClientTest, ConnectActiveConferenceSucceeds) {
   auto peer_connection = std::make_unique<MockConferencePeerConnection>();
   absl::Notification connect_called_notification;
   EXPECT_CALL(*peer_connection,
-              Connect("join_endpoint", "conference_id", "access_token"))
-      .WillOnce([&connect_called_notification] {
+              Connect("join_endpoint", "conference_id", "access_token", _))
+      .WillOnce([&connect_called_notification](
+                    absl::string_view, absl::string_view, absl::string_view,
+                    ConferencePeerConnectionInterface::ConnectCallback
+                        callback) {
         connect_called_notification.Notify();
-        return absl::OkStatus();
+        std::move(callback)(absl::OkStatus());
       });
   MediaApiClient client(CreateThread("client_thread"),
                         CreateThread("worker_thread"), std::move(observer),
@@ -162,8 +178,12 @@ TEST(MediaApiClientTest,
       });
   auto peer_connection = std::make_unique<MockConferencePeerConnection>();
   EXPECT_CALL(*peer_connection,
-              Connect("join_endpoint", "conference_id", "access_token"))
-      .WillOnce([] { return absl::InternalError("Failed to connect."); });
+              Connect("join_endpoint", "conference_id", "access_token", _))
+      .WillOnce(
+          [](absl::string_view, absl::string_view, absl::string_view,
+             ConferencePeerConnectionInterface::ConnectCallback callback) {
+            std::move(callback)(absl::InternalError("Failed to connect."));
+          });
   MediaApiClient client(CreateThread("client_thread"),
                         CreateThread("worker_thread"), std::move(observer),
                         std::move(peer_connection),
@@ -189,12 +209,15 @@ TEST(MediaApiClientTest,
       webrtc::make_ref_counted<MockMediaApiClientObserver>(),
       std::move(peer_connection), CreateConferenceDataChannels());
   EXPECT_CALL(*peer_connection_ptr,
-              Connect("join_endpoint", "conference_id", "access_token"))
-      .WillOnce([&client] {
+              Connect("join_endpoint", "conference_id", "access_token", _))
+      .WillOnce([&client](
+                    absl::string_view, absl::string_view, absl::string_view,
+                    ConferencePeerConnectionInterface::ConnectCallback
+                        callback) {
         // Disconnect the client before the connection completes, changing the
         // client's state.
         (void)client.LeaveConference(/*request_id=*/7);
-        return absl::OkStatus();
+        std::move(callback)(absl::OkStatus());
       });
   ScopedMockLog log(kDoNotCaptureLogsYet);
   absl::Notification log_notification;
@@ -289,6 +312,49 @@ TEST(MediaApiClientTest, CallsObserverOnResourceUpdate) {
                   .response->request_id == 7);
 }
 
+TEST(MediaApiClientTest, CallsObserverOnParticipantsResourceUpdate) {
+  auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
+  ResourceUpdate received_resource_update;
+  absl::Notification resource_update_notification;
+  EXPECT_CALL(*observer, OnResourceUpdate)
+      .WillOnce([&received_resource_update, &resource_update_notification](
+                    ResourceUpdate resource_update) {
+        received_resource_update = std::move(resource_update);
+        resource_update_notification.Notify();
+      });
+  auto participants_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  ConferenceDataChannelInterface::ResourceUpdateCallback
+      resource_update_callback;
+  EXPECT_CALL(*participants_data_channel, SetCallback)
+      .WillOnce(
+          [&](ConferenceDataChannelInterface::ResourceUpdateCallback callback) {
+            resource_update_callback = std::move(callback);
+          });
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      std::move(observer), std::make_unique<MockConferencePeerConnection>(),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::move(participants_data_channel),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      });
+
+  resource_update_callback(ParticipantsChannelToClient{
+      .resources = {ParticipantResourceSnapshot{.id = 1},
+                    ParticipantResourceSnapshot{.id = 2}}});
+
+  ASSERT_TRUE(resource_update_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
+  ASSERT_TRUE(std::holds_alternative<ParticipantsChannelToClient>(
+      received_resource_update));
+  EXPECT_THAT(
+      std::get<ParticipantsChannelToClient>(received_resource_update).resources,
+      SizeIs(2));
+}
+
 TEST(MediaApiClientTest,
      JoinsAfterReceivingJoinedSessionStatusWhileInJoiningState) {
   auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
@@ -299,10 +365,14 @@ TEST(MediaApiClientTest,
   auto peer_connection = std::make_unique<MockConferencePeerConnection>();
   absl::Notification connect_called_notification;
   ON_CALL(*peer_connection,
-          Connect("join_endpoint", "conference_id", "access_token"))
-      .WillByDefault([&connect_called_notification] {
+          Connect("join_endpoint", "conference_id", "access_token", _))
+      .WillByDefault([&connect_called_notification](
+                         absl::string_view, absl::string_view,
+                         absl::string_view,
+                         ConferencePeerConnectionInterface::ConnectCallback
+                             callback) {
         connect_called_notification.Notify();
-        return absl::OkStatus();
+        std::move(callback)(absl::OkStatus());
       });
   auto session_control_data_channel =
       std::make_unique<MockConferenceDataChannel>();
@@ -341,6 +411,134 @@ TEST(MediaApiClientTest,
       joined_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
 }
 
+TEST(MediaApiClientTest, SendRequestDoesNotWaitForOnJoined) {
+  auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification on_joined_called;
+  absl::Notification on_joined_released;
+  EXPECT_CALL(*observer, OnJoined).WillOnce([&] {
+    on_joined_called.Notify();
+    on_joined_released.WaitForNotification();
+  });
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  absl::Notification connect_called_notification;
+  ON_CALL(*peer_connection, Connect)
+      .WillByDefault([&connect_called_notification](
+                         absl::string_view, absl::string_view,
+                         absl::string_view,
+                         ConferencePeerConnectionInterface::ConnectCallback
+                             callback) {
+        connect_called_notification.Notify();
+        std::move(callback)(absl::OkStatus());
+      });
+  auto session_control_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  ConferenceDataChannelInterface::ResourceUpdateCallback
+      resource_update_callback;
+  EXPECT_CALL(*session_control_data_channel, SetCallback)
+      .WillOnce(
+          [&](ConferenceDataChannelInterface::ResourceUpdateCallback callback) {
+            resource_update_callback = std::move(callback);
+          });
+  EXPECT_CALL(*session_control_data_channel, SendRequest)
+      .WillOnce(Return(absl::OkStatus()));
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      std::move(observer), std::move(peer_connection),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::move(session_control_data_channel),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      });
+  (void)client.ConnectActiveConference("join_endpoint", "conference_id",
+                                       "access_token");
+  ASSERT_TRUE(connect_called_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
+  resource_update_callback(SessionControlChannelToClient{
+      .resources = std::vector<SessionControlResourceSnapshot>{
+          SessionControlResourceSnapshot{
+              .session_status = SessionStatus{
+                  .connection_state =
+                      SessionStatus::ConferenceConnectionState::kJoined}}}});
+  ASSERT_TRUE(
+      on_joined_called.WaitForNotificationWithTimeout(absl::Seconds(1)));
+
+  // `OnJoined` is still running.
+  EXPECT_OK(client.SendRequest(SessionControlChannelFromClient{
+      .request = SessionControlRequest{.request_id = 1}}));
+
+  on_joined_released.Notify();
+}
+
+TEST(MediaApiClientTest, ReportsJoinTimingsWhenJoined) {
+  auto observer = webrtc::make_ref_counted<MockJoinTimingsObserver>();
+  absl::Notification joined_notification;
+  JoinTimings join_timings;
+  EXPECT_CALL(*observer, OnJoined(_))
+      .WillOnce([&](const JoinTimings& timings) {
+        join_timings = timings;
+        joined_notification.Notify();
+      });
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  ConferencePeerConnectionInterface::ConnectTimestamps connect_timestamps;
+  absl::Notification connect_called_notification;
+  EXPECT_CALL(*peer_connection, Connect)
+      .WillOnce([&](absl::string_view, absl::string_view, absl::string_view,
+                    ConferencePeerConnectionInterface::ConnectCallback
+                        callback) {
+        // The local description was prepared before connecting.
+        connect_timestamps.local_description_set_us = 0;
+        connect_timestamps.remote_description_set_us = rtc::TimeMicros();
+        connect_called_notification.Notify();
+        std::move(callback)(absl::OkStatus());
+      });
+  EXPECT_CALL(*peer_connection, GetConnectTimestamps).WillOnce([&] {
+    return connect_timestamps;
+  });
+  auto session_control_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  ConferenceDataChannelInterface::ResourceUpdateCallback
+      resource_update_callback;
+  EXPECT_CALL(*session_control_data_channel, SetCallback)
+      .WillOnce(
+          [&](ConferenceDataChannelInterface::ResourceUpdateCallback callback) {
+            resource_update_callback = std::move(callback);
+          });
+  EXPECT_CALL(*session_control_data_channel, GetOpenedTimeUs)
+      .WillOnce(Return(std::nullopt));
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      std::move(observer), std::move(peer_connection),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::move(session_control_data_channel),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      });
+  (void)client.ConnectActiveConference("join_endpoint", "conference_id",
+                                       "access_token");
+  ASSERT_TRUE(connect_called_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
+
+  resource_update_callback(SessionControlChannelToClient{
+      .resources = std::vector<SessionControlResourceSnapshot>{
+          SessionControlResourceSnapshot{
+              .session_status = SessionStatus{
+                  .connection_state =
+                      SessionStatus::ConferenceConnectionState::kJoined}}}});
+
+  ASSERT_TRUE(
+      joined_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_EQ(join_timings.local_description_set_us, 0);
+  ASSERT_TRUE(join_timings.remote_description_set_us.has_value());
+  EXPECT_GE(*join_timings.remote_description_set_us, 0);
+  EXPECT_LE(*join_timings.remote_description_set_us, join_timings.joined_us);
+  EXPECT_FALSE(join_timings.join_response_received_us.has_value());
+  EXPECT_FALSE(join_timings.data_channel_opened_us.has_value());
+}
+
 TEST(MediaApiClientTest,
      LogsWarningIfReceivingJoinedSessionStatusWhileNotInJoiningState) {
   auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
@@ -535,6 +733,33 @@ TEST(MediaApiClientTest, DisconnectingClosesConferencePeerConnection) {
       absl::Seconds(1)));
 }
 
+TEST(MediaApiClientTest, ShutdownClosesConferencePeerConnectionOnce) {
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  // Destroying the client after it has shut down does not close the peer
+  // connection again.
+  EXPECT_CALL(*peer_connection, Close).Times(1);
+  auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnDisconnected).Times(0);
+  auto client = std::make_unique<MediaApiClient>(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      std::move(observer), std::move(peer_connection),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      });
+  absl::Notification shut_down_notification;
+
+  client->Shutdown(
+      [&shut_down_notification] { shut_down_notification.Notify(); });
+
+  EXPECT_TRUE(
+      shut_down_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  client.reset();
+}
+
 TEST(MediaApiClientTest, StartsSendingStatsRequestsAfterReceivingStatsUpdate) {
   auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
   absl::Notification disconnected_notification;
@@ -656,19 +881,122 @@ TEST(MediaApiClientTest, StartsSendingStatsRequestsAfterReceivingStatsUpdate) {
             "200");
 }
 
-TEST(MediaApiClientTest, SendMediaStatsRequestReturnsError) {
-  auto media_stats_data_channel = std::make_unique<MockConferenceDataChannel>();
-  absl::Notification send_request_called_notification;
-  ON_CALL(*media_stats_data_channel, SendRequest)
+TEST(MediaApiClientTest, SendsOnlyChangedStatsWhenDeltaEncodingIsEnabled) {
+  auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification disconnected_notification;
+  EXPECT_CALL(*observer, OnDisconnected).WillOnce([&disconnected_notification] {
+    disconnected_notification.Notify();
+  });
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  int stats_collections = 0;
+  ON_CALL(*peer_connection, GetStats)
       .WillByDefault(
-          [&send_request_called_notification](ResourceRequest request) {
-            send_request_called_notification.Notify();
-            return absl::OkStatus();
+          [&stats_collections](webrtc::RTCStatsCollectorCallback* callback) {
+            rtc::scoped_refptr<webrtc::RTCStatsReport> report =
+                webrtc::RTCStatsReport::Create(webrtc::Timestamp::Zero());
+            auto candidate_pair_section =
+                std::make_unique<webrtc::RTCIceCandidatePairStats>(
+                    "candidate_pair_id", webrtc::Timestamp::Zero());
+            // Only the sent timestamp changes between collections.
+            candidate_pair_section->last_packet_sent_timestamp =
+                100 + stats_collections++;
+            candidate_pair_section->last_packet_received_timestamp = 200;
+            report->AddStats(std::move(candidate_pair_section));
+            callback->OnStatsDelivered(std::move(report));
+          });
+  auto media_stats_data_channel = std::make_unique<MockConferenceDataChannel>();
+  std::vector<ResourceRequest> received_requests;
+  EXPECT_CALL(*media_stats_data_channel, SendRequest)
+      // Expect 2 requests: 1 initial request, 1 periodic request.
+      .Times(2)
+      .WillRepeatedly([&received_requests](ResourceRequest request) {
+        received_requests.push_back(std::move(request));
+        return absl::OkStatus();
+      });
+  ConferenceDataChannelInterface::ResourceUpdateCallback
+      resource_update_callback;
+  EXPECT_CALL(*media_stats_data_channel, SetCallback)
+      .WillOnce(
+          [&](ConferenceDataChannelInterface::ResourceUpdateCallback callback) {
+            resource_update_callback = std::move(callback);
+          });
+  ConferenceDataChannelInterface::ResourceUpdateCallback
+      session_control_update_callback;
+  auto session_control_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  EXPECT_CALL(*session_control_data_channel, SetCallback)
+      .WillOnce(
+          [&](ConferenceDataChannelInterface::ResourceUpdateCallback callback) {
+            session_control_update_callback = std::move(callback);
+          });
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      std::move(observer), std::move(peer_connection),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::move(media_stats_data_channel),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::move(session_control_data_channel),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      },
+      /*shared_context=*/nullptr, /*delta_encoded_stats=*/true);
+
+  MediaStatsChannelToClient media_stats_update = MediaStatsChannelToClient{
+      .resources =
+          std::vector<MediaStatsResourceSnapshot>{MediaStatsResourceSnapshot{
+              .configuration = MediaStatsConfiguration{
+                  .upload_interval_seconds = 1,
+                  .allowlist = {{"candidate-pair",
+                                 {"lastPacketSentTimestamp",
+                                  "lastPacketReceivedTimestamp"}}}}}}};
+  resource_update_callback(std::move(media_stats_update));
+  // The upload interval is 1 second, so wait for 1.5 seconds to ensure that 1
+  // periodic request is sent.
+  absl::SleepFor(absl::Seconds(1.5));
+  // Disconnect the client to stop stats collection.
+  SessionControlChannelToClient session_control_update =
+      SessionControlChannelToClient{
+          .resources = std::vector<SessionControlResourceSnapshot>{
+              SessionControlResourceSnapshot{
+                  .session_status = SessionStatus{
+                      .connection_state = SessionStatus::
+                          ConferenceConnectionState::kDisconnected}}}};
+  session_control_update_callback(std::move(session_control_update));
+
+  ASSERT_TRUE(disconnected_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
+  ASSERT_EQ(received_requests.size(), 2);
+  MediaStatsChannelFromClient request1 =
+      std::get<MediaStatsChannelFromClient>(received_requests[0]);
+  MediaStatsChannelFromClient request2 =
+      std::get<MediaStatsChannelFromClient>(received_requests[1]);
+  ASSERT_EQ(request1.request.upload_media_stats->sections.size(), 1);
+  EXPECT_EQ(request1.request.upload_media_stats->sections[0].values.size(), 2);
+  ASSERT_EQ(request2.request.upload_media_stats->sections.size(), 1);
+  EXPECT_EQ(request2.request.upload_media_stats->sections[0].id,
+            "candidate_pair_id");
+  ASSERT_EQ(request2.request.upload_media_stats->sections[0].values.size(), 1);
+  EXPECT_EQ(request2.request.upload_media_stats->sections[0]
+                .values["lastPacketSentTimestamp"],
+            "101");
+}
+
+TEST(MediaApiClientTest, DoesNotCollectStatsWithEmptyAllowlist) {
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  EXPECT_CALL(*peer_connection, GetStats).Times(0);
+  auto media_stats_data_channel = std::make_unique<MockConferenceDataChannel>();
+  EXPECT_CALL(*media_stats_data_channel, SendRequest).Times(0);
+  ConferenceDataChannelInterface::ResourceUpdateCallback
+      resource_update_callback;
+  EXPECT_CALL(*media_stats_data_channel, SetCallback)
+      .WillOnce(
+          [&](ConferenceDataChannelInterface::ResourceUpdateCallback callback) {
+            resource_update_callback = std::move(callback);
           });
   MediaApiClient client(
       CreateThread("client_thread"), CreateThread("worker_thread"),
       webrtc::make_ref_counted<MockMediaApiClientObserver>(),
-      std::make_unique<MockConferencePeerConnection>(),
+      std::move(peer_connection),
       MediaApiClient::ConferenceDataChannels{
           .media_entries = std::make_unique<MockConferenceDataChannel>(),
           .media_stats = std::move(media_stats_data_channel),
@@ -677,40 +1005,202 @@ TEST(MediaApiClientTest, SendMediaStatsRequestReturnsError) {
           .video_assignment = std::make_unique<MockConferenceDataChannel>(),
       });
 
-  absl::Status status = client.SendRequest(MediaStatsChannelFromClient{
-      .request = MediaStatsRequest{.request_id = 123}});
-
-  EXPECT_THAT(
-      status,
-      StatusIs(absl::StatusCode::kInternal,
-               "Media stats requests should not be sent directly. This client "
-               "implementation handles stats collection internally."));
-  EXPECT_FALSE(send_request_called_notification.HasBeenNotified());
+  MediaStatsChannelToClient media_stats_update = MediaStatsChannelToClient{
+      .resources =
+          std::vector<MediaStatsResourceSnapshot>{MediaStatsResourceSnapshot{
+              .configuration = MediaStatsConfiguration{
+                  .upload_interval_seconds = 1, .allowlist = {}}}}};
+  resource_update_callback(std::move(media_stats_update));
+  absl::SleepFor(absl::Seconds(1.5));
 }
 
-TEST(MediaApiClientTest, SendSessionControlRequestSucceeds) {
-  auto session_control_data_channel =
-      std::make_unique<MockConferenceDataChannel>();
-  ResourceRequest received_resource_request;
-  EXPECT_CALL(*session_control_data_channel, SendRequest)
-      .WillOnce([&received_resource_request](ResourceRequest request) {
-        received_resource_request = std::move(request);
-        return absl::OkStatus();
+TEST(MediaApiClientTest, GetStatsReportReusesReportsWithinMaxAge) {
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  absl::Notification connect_called_notification;
+  ON_CALL(*peer_connection, Connect)
+      .WillByDefault([&connect_called_notification](
+                         absl::string_view, absl::string_view,
+                         absl::string_view,
+                         ConferencePeerConnectionInterface::ConnectCallback
+                             callback) {
+        connect_called_notification.Notify();
+        std::move(callback)(absl::OkStatus());
+      });
+  // Expect 2 collections: 1 for the first call, 1 for the last call, whose
+  // maximum age is shorter than the age of the first report.
+  EXPECT_CALL(*peer_connection, GetStats)
+      .Times(2)
+      .WillRepeatedly([](webrtc::RTCStatsCollectorCallback* callback) {
+        callback->OnStatsDelivered(
+            webrtc::RTCStatsReport::Create(webrtc::Timestamp::Zero()));
       });
   MediaApiClient client(
       CreateThread("client_thread"), CreateThread("worker_thread"),
       webrtc::make_ref_counted<MockMediaApiClientObserver>(),
-      std::make_unique<MockConferencePeerConnection>(),
+      std::move(peer_connection),
       MediaApiClient::ConferenceDataChannels{
           .media_entries = std::make_unique<MockConferenceDataChannel>(),
           .media_stats = std::make_unique<MockConferenceDataChannel>(),
           .participants = std::make_unique<MockConferenceDataChannel>(),
-          .session_control = std::move(session_control_data_channel),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
           .video_assignment = std::make_unique<MockConferenceDataChannel>(),
       });
+  ASSERT_TRUE(client
+                  .ConnectActiveConference("join_endpoint", "conference_id",
+                                           "access_token")
+                  .ok());
+  ASSERT_TRUE(connect_called_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
 
-  absl::Status status = client.SendRequest(SessionControlChannelFromClient{
-      .request = SessionControlRequest{.request_id = 123}});
+  absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>> report1 =
+      client.GetStatsReport(absl::Seconds(10));
+  absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>> report2 =
+      client.GetStatsReport(absl::Seconds(10));
+  absl::SleepFor(absl::Milliseconds(10));
+  absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>> report3 =
+      client.GetStatsReport(absl::Milliseconds(1));
+
+  ASSERT_TRUE(report1.ok());
+  ASSERT_TRUE(report2.ok());
+  ASSERT_TRUE(report3.ok());
+  EXPECT_EQ(*report1, *report2);
+  EXPECT_NE(*report1, *report3);
+}
+
+TEST(MediaApiClientTest, GetStatsReportSharesInFlightCollection) {
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  absl::Notification connect_called_notification;
+  ON_CALL(*peer_connection, Connect)
+      .WillByDefault([&connect_called_notification](
+                         absl::string_view, absl::string_view,
+                         absl::string_view,
+                         ConferencePeerConnectionInterface::ConnectCallback
+                             callback) {
+        connect_called_notification.Notify();
+        std::move(callback)(absl::OkStatus());
+      });
+  rtc::scoped_refptr<webrtc::RTCStatsCollectorCallback> stats_callback;
+  absl::Notification get_stats_called;
+  EXPECT_CALL(*peer_connection, GetStats)
+      .WillOnce([&](webrtc::RTCStatsCollectorCallback* callback) {
+        stats_callback = rtc::scoped_refptr<webrtc::RTCStatsCollectorCallback>(
+            callback);
+        get_stats_called.Notify();
+      });
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+      std::move(peer_connection),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      });
+  ASSERT_TRUE(client
+                  .ConnectActiveConference("join_endpoint", "conference_id",
+                                           "access_token")
+                  .ok());
+  ASSERT_TRUE(connect_called_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
+  std::vector<rtc::scoped_refptr<const webrtc::RTCStatsReport>> reports;
+  auto callback =
+      [&reports](
+          absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>>
+              report) {
+        ASSERT_TRUE(report.ok());
+        reports.push_back(*std::move(report));
+      };
+
+  client.GetStatsReport(absl::Seconds(10), callback);
+  client.GetStatsReport(absl::Seconds(10), callback);
+  ASSERT_TRUE(
+      get_stats_called.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_THAT(reports, IsEmpty());
+  rtc::scoped_refptr<const webrtc::RTCStatsReport> report =
+      webrtc::RTCStatsReport::Create(webrtc::Timestamp::Zero());
+  stats_callback->OnStatsDelivered(report);
+
+  EXPECT_THAT(reports, ElementsAre(report, report));
+}
+
+TEST(MediaApiClientTest, GetStatsReportFailsIfNotConnected) {
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  EXPECT_CALL(*peer_connection, GetStats).Times(0);
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+      std::move(peer_connection),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      });
+
+  EXPECT_THAT(client.GetStatsReport(absl::Seconds(10)),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       "GetStatsReport called in ready state before connecting "
+                       "or after disconnecting."));
+}
+
+TEST(MediaApiClientTest, SendMediaStatsRequestReturnsError) {
+  auto media_stats_data_channel = std::make_unique<MockConferenceDataChannel>();
+  absl::Notification send_request_called_notification;
+  ON_CALL(*media_stats_data_channel, SendRequest)
+      .WillByDefault(
+          [&send_request_called_notification](ResourceRequest request) {
+            send_request_called_notification.Notify();
+            return absl::OkStatus();
+          });
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+      std::make_unique<MockConferencePeerConnection>(),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::move(media_stats_data_channel),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      });
+
+  absl::Status status = client.SendRequest(MediaStatsChannelFromClient{
+      .request = MediaStatsRequest{.request_id = 123}});
+
+  EXPECT_THAT(
+      status,
+      StatusIs(absl::StatusCode::kInternal,
+               "Media stats requests should not be sent directly. This client "
+               "implementation handles stats collection internally."));
+  EXPECT_FALSE(send_request_called_notification.HasBeenNotified());
+}
+
+TEST(MediaApiClientTest, SendSessionControlRequestSucceeds) {
+  auto session_control_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  ResourceRequest received_resource_request;
+  EXPECT_CALL(*session_control_data_channel, SendRequest)
+      .WillOnce([&received_resource_request](ResourceRequest request) {
+        received_resource_request = std::move(request);
+        return absl::OkStatus();
+      });
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+      std::make_unique<MockConferencePeerConnection>(),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::move(session_control_data_channel),
+          .video_assignment = std::make_unique<MockConferenceDataChannel>(),
+      });
+
+  absl::Status status = client.SendRequest(SessionControlChannelFromClient{
+      .request = SessionControlRequest{.request_id = 123}});
 
   EXPECT_OK(status);
   ASSERT_TRUE(std::holds_alternative<SessionControlChannelFromClient>(
@@ -753,6 +1243,128 @@ TEST(MediaApiClientTest, SendVideoAssignmentRequestSucceeds) {
       123);
 }
 
+TEST(MediaApiClientTest, CoalescesVideoAssignmentRequestsWithinWindow) {
+  auto video_assignment_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  absl::Mutex mutex;
+  std::vector<int64_t> sent_request_ids;
+  absl::Notification coalesced_request_sent;
+  EXPECT_CALL(*video_assignment_data_channel, SendRequest)
+      .Times(2)
+      .WillRepeatedly([&](ResourceRequest request) {
+        absl::MutexLock lock(&mutex);
+        sent_request_ids.push_back(
+            std::get<VideoAssignmentChannelFromClient>(request)
+                .request.request_id);
+        if (sent_request_ids.size() == 2) {
+          coalesced_request_sent.Notify();
+        }
+        return absl::OkStatus();
+      });
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+      std::make_unique<MockConferencePeerConnection>(),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
+          .video_assignment = std::move(video_assignment_data_channel),
+      },
+      /*shared_context=*/nullptr, /*delta_encoded_stats=*/false,
+      /*metrics=*/nullptr,
+      /*video_assignment_coalescing_window=*/absl::Milliseconds(100));
+
+  for (int64_t request_id : {1, 2, 3}) {
+    EXPECT_OK(client.SendRequest(VideoAssignmentChannelFromClient{
+        .request = VideoAssignmentRequest{.request_id = request_id}}));
+  }
+
+  ASSERT_TRUE(
+      coalesced_request_sent.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  absl::MutexLock lock(&mutex);
+  EXPECT_THAT(sent_request_ids, ElementsAre(1, 3));
+}
+
+TEST(MediaApiClientTest, DeliversCoalescedResponseToSupersededRequests) {
+  auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
+  std::vector<int64_t> response_request_ids;
+  absl::Notification responses_received;
+  EXPECT_CALL(*observer, OnResourceUpdate)
+      .Times(3)
+      .WillRepeatedly([&](ResourceUpdate update) {
+        response_request_ids.push_back(
+            std::get<VideoAssignmentChannelToClient>(update)
+                .response->request_id);
+        if (response_request_ids.size() == 3) {
+          responses_received.Notify();
+        }
+      });
+  auto video_assignment_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  ConferenceDataChannelInterface::ResourceUpdateCallback
+      resource_update_callback;
+  EXPECT_CALL(*video_assignment_data_channel, SetCallback)
+      .WillOnce(
+          [&](ConferenceDataChannelInterface::ResourceUpdateCallback callback) {
+            resource_update_callback = std::move(callback);
+          });
+  absl::Notification coalesced_request_sent;
+  EXPECT_CALL(*video_assignment_data_channel, SendRequest)
+      .WillOnce(Return(absl::OkStatus()))
+      .WillOnce([&](ResourceRequest) {
+        coalesced_request_sent.Notify();
+        return absl::OkStatus();
+      });
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      std::move(observer), std::make_unique<MockConferencePeerConnection>(),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
+          .video_assignment = std::move(video_assignment_data_channel),
+      },
+      /*shared_context=*/nullptr, /*delta_encoded_stats=*/false,
+      /*metrics=*/nullptr,
+      /*video_assignment_coalescing_window=*/absl::Milliseconds(10));
+  for (int64_t request_id : {1, 2, 3, 4}) {
+    EXPECT_OK(client.SendRequest(VideoAssignmentChannelFromClient{
+        .request = VideoAssignmentRequest{.request_id = request_id}}));
+  }
+  ASSERT_TRUE(
+      coalesced_request_sent.WaitForNotificationWithTimeout(absl::Seconds(1)));
+
+  resource_update_callback(VideoAssignmentChannelToClient{
+      .response = VideoAssignmentResponse{.request_id = 4}});
+
+  ASSERT_TRUE(
+      responses_received.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_THAT(response_request_ids, ElementsAre(4, 2, 3));
+}
+
+TEST(MediaApiClientTest,
+     SendVideoAssignmentRequestFailsWithoutVideoAssignmentSubscription) {
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+      std::make_unique<MockConferencePeerConnection>(),
+      MediaApiClient::ConferenceDataChannels{
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::make_unique<MockConferenceDataChannel>(),
+      });
+
+  absl::Status status = client.SendRequest(VideoAssignmentChannelFromClient{
+      .request = VideoAssignmentRequest{.request_id = 123}});
+
+  EXPECT_THAT(status,
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       "Video assignment requests cannot be sent without a "
+                       "subscription to video assignment updates."));
+}
+
 TEST(MediaApiClientTest, SendRequestLogsWarningIfClientNotJoined) {
   auto video_assignment_data_channel =
       std::make_unique<MockConferenceDataChannel>();
@@ -786,6 +1398,94 @@ TEST(MediaApiClientTest, SendRequestLogsWarningIfClientNotJoined) {
               "the client is not joined into the conference.");
 }
 
+TEST(MediaApiClientTest,
+     SendVideoAssignmentRequestFailsWithMoreCanvasesThanVideoStreams) {
+  auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification joined_notification;
+  EXPECT_CALL(*observer, OnJoined).WillOnce([&joined_notification] {
+    joined_notification.Notify();
+  });
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  ConferencePeerConnection::TrackSignaledCallback track_signaled_callback;
+  EXPECT_CALL(*peer_connection, SetTrackSignaledCallback)
+      .WillOnce([&](ConferencePeerConnection::TrackSignaledCallback callback) {
+        track_signaled_callback = std::move(callback);
+      });
+  absl::Notification connect_called_notification;
+  EXPECT_CALL(*peer_connection, Connect)
+      .WillOnce([&](absl::string_view, absl::string_view, absl::string_view,
+                    ConferencePeerConnectionInterface::ConnectCallback
+                        callback) {
+        connect_called_notification.Notify();
+        std::move(callback)(absl::OkStatus());
+      });
+  auto session_control_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  ConferenceDataChannelInterface::ResourceUpdateCallback
+      resource_update_callback;
+  EXPECT_CALL(*session_control_data_channel, SetCallback)
+      .WillOnce(
+          [&](ConferenceDataChannelInterface::ResourceUpdateCallback callback) {
+            resource_update_callback = std::move(callback);
+          });
+  auto video_assignment_data_channel =
+      std::make_unique<MockConferenceDataChannel>();
+  EXPECT_CALL(*video_assignment_data_channel, SendRequest)
+      .WillOnce(Return(absl::OkStatus()));
+  MediaApiClient client(
+      CreateThread("client_thread"), CreateThread("worker_thread"),
+      std::move(observer), std::move(peer_connection),
+      MediaApiClient::ConferenceDataChannels{
+          .media_entries = std::make_unique<MockConferenceDataChannel>(),
+          .media_stats = std::make_unique<MockConferenceDataChannel>(),
+          .participants = std::make_unique<MockConferenceDataChannel>(),
+          .session_control = std::move(session_control_data_channel),
+          .video_assignment = std::move(video_assignment_data_channel),
+      });
+  // Signal a single video stream.
+  rtc::scoped_refptr<webrtc::MockVideoTrack> mock_video_track =
+      webrtc::MockVideoTrack::Create();
+  auto mock_receiver = rtc::scoped_refptr<webrtc::MockRtpReceiver>(
+      new webrtc::MockRtpReceiver());
+  ON_CALL(*mock_receiver, media_type)
+      .WillByDefault(Return(cricket::MediaType::MEDIA_TYPE_VIDEO));
+  ON_CALL(*mock_receiver, track).WillByDefault(Return(mock_video_track));
+  rtc::scoped_refptr<webrtc::MockRtpTransceiver> mock_transceiver =
+      webrtc::MockRtpTransceiver::Create();
+  ON_CALL(*mock_transceiver, mid).WillByDefault(Return("mid"));
+  ON_CALL(*mock_transceiver, receiver).WillByDefault(Return(mock_receiver));
+  track_signaled_callback(std::move(mock_transceiver));
+  (void)client.ConnectActiveConference("join_endpoint", "conference_id",
+                                       "access_token");
+  ASSERT_TRUE(connect_called_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
+  // Wait for the client to switch to the joining state before joining.
+  absl::SleepFor(absl::Milliseconds(100));
+  resource_update_callback(SessionControlChannelToClient{
+      .resources = std::vector<SessionControlResourceSnapshot>{
+          SessionControlResourceSnapshot{
+              .session_status = SessionStatus{
+                  .connection_state =
+                      SessionStatus::ConferenceConnectionState::kJoined}}}});
+  ASSERT_TRUE(
+      joined_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  auto create_request = [](int canvas_count) {
+    return VideoAssignmentChannelFromClient{
+        .request = VideoAssignmentRequest{
+            .request_id = 123,
+            .set_video_assignment_request = SetVideoAssignmentRequest{
+                .layout_model = LayoutModel{
+                    .canvases = std::vector<VideoCanvas>(canvas_count)}}}};
+  };
+
+  EXPECT_THAT(
+      client.SendRequest(create_request(2)),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               "Video assignment has 2 canvases but the client only receives "
+               "1 video streams."));
+  EXPECT_OK(client.SendRequest(create_request(1)));
+}
+
 TEST(MediaApiClientTest, LeaveConferenceSendsLeaveRequest) {
   auto session_control_data_channel =
       std::make_unique<MockConferenceDataChannel>();
@@ -1064,6 +1764,198 @@ TEST(MediaApiClientTest, HandlesSignaledVideoTrack) {
   EXPECT_EQ(received_frame->synchronization_source, 456);
 }
 
+// Observer whose frame callback is final, so that it is called directly.
+class VideoFrameCountingObserver : public MockMediaApiClientObserver {
+ public:
+  void OnVideoFrame(VideoFrame frame) final {
+    received_pixel_counts.push_back(frame.frame.size());
+  }
+
+  std::vector<int> received_pixel_counts;
+};
+
+TEST(MediaApiClientTest, DeliversVideoFramesToTracksOfMediaTrackFactory) {
+  rtc::VideoSinkInterface<webrtc::VideoFrame>* video_track_sink;
+  rtc::scoped_refptr<webrtc::MockVideoTrack> mock_video_track =
+      webrtc::MockVideoTrack::Create();
+  ON_CALL(*mock_video_track, AddOrUpdateSink)
+      .WillByDefault(
+          [&video_track_sink](rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+                              const rtc::VideoSinkWants&) {
+            video_track_sink = sink;
+          });
+  auto mock_receiver = rtc::scoped_refptr<webrtc::MockRtpReceiver>(
+      new webrtc::MockRtpReceiver());
+  ON_CALL(*mock_receiver, media_type)
+      .WillByDefault(Return(cricket::MediaType::MEDIA_TYPE_VIDEO));
+  ON_CALL(*mock_receiver, track).WillByDefault(Return(mock_video_track));
+  rtc::scoped_refptr<webrtc::MockRtpTransceiver> mock_transceiver =
+      webrtc::MockRtpTransceiver::Create();
+  ON_CALL(*mock_transceiver, mid).WillByDefault(Return("mid"));
+  ON_CALL(*mock_transceiver, receiver).WillByDefault(Return(mock_receiver));
+  auto observer = webrtc::make_ref_counted<MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnVideoFrame).Times(0);
+  auto frame_observer = webrtc::make_ref_counted<VideoFrameCountingObserver>();
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  ConferencePeerConnection::TrackSignaledCallback track_signaled_callback;
+  EXPECT_CALL(*peer_connection, SetTrackSignaledCallback)
+      .WillOnce([&](ConferencePeerConnection::TrackSignaledCallback callback) {
+        track_signaled_callback = std::move(callback);
+      });
+  MediaApiClient client(CreateThread("client_thread"),
+                        CreateThread("worker_thread"), std::move(observer),
+                        std::move(peer_connection),
+                        CreateConferenceDataChannels());
+  client.SetMediaTrackFactory(MakeMediaTrackFactory(frame_observer));
+  track_signaled_callback(std::move(mock_transceiver));
+
+  webrtc::VideoFrame::Builder builder;
+  webrtc::RtpPacketInfo packet_info;
+  packet_info.set_csrcs({123});
+  packet_info.set_ssrc(456);
+  builder.set_packet_infos(webrtc::RtpPacketInfos({packet_info}));
+  builder.set_video_frame_buffer(webrtc::I420Buffer::Create(42, 42));
+  webrtc::VideoFrame frame = builder.build();
+  video_track_sink->OnFrame(frame);
+
+  EXPECT_THAT(frame_observer->received_pixel_counts, ElementsAre(42 * 42));
+}
+
+TEST(MediaApiClientTest, SetVideoSinkConstraintsUpdatesVideoTrackSinkWants) {
+  std::vector<rtc::VideoSinkWants> sink_wants;
+  rtc::scoped_refptr<webrtc::MockVideoTrack> mock_video_track =
+      webrtc::MockVideoTrack::Create();
+  ON_CALL(*mock_video_track, AddOrUpdateSink)
+      .WillByDefault(
+          [&sink_wants](rtc::VideoSinkInterface<webrtc::VideoFrame>*,
+                        const rtc::VideoSinkWants& wants) {
+            sink_wants.push_back(wants);
+          });
+  auto mock_receiver = rtc::scoped_refptr<webrtc::MockRtpReceiver>(
+      new webrtc::MockRtpReceiver());
+  ON_CALL(*mock_receiver, media_type)
+      .WillByDefault(Return(cricket::MediaType::MEDIA_TYPE_VIDEO));
+  ON_CALL(*mock_receiver, track).WillByDefault(Return(mock_video_track));
+  rtc::scoped_refptr<webrtc::MockRtpTransceiver> mock_transceiver =
+      webrtc::MockRtpTransceiver::Create();
+  ON_CALL(*mock_transceiver, mid).WillByDefault(Return("mid"));
+  ON_CALL(*mock_transceiver, receiver).WillByDefault(Return(mock_receiver));
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  ConferencePeerConnection::TrackSignaledCallback track_signaled_callback;
+  EXPECT_CALL(*peer_connection, SetTrackSignaledCallback)
+      .WillOnce([&](ConferencePeerConnection::TrackSignaledCallback callback) {
+        track_signaled_callback = std::move(callback);
+      });
+  MediaApiClient client(CreateThread("client_thread"),
+                        CreateThread("worker_thread"),
+                        webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+                        std::move(peer_connection),
+                        CreateConferenceDataChannels());
+  // Constraints set before the track is signaled apply once it is.
+  ASSERT_OK(client.SetVideoSinkConstraints({.max_pixel_count = 320 * 180}));
+  track_signaled_callback(std::move(mock_transceiver));
+
+  ASSERT_OK(client.SetVideoSinkConstraints({.max_framerate_fps = 5}));
+
+  ASSERT_THAT(sink_wants, SizeIs(2));
+  EXPECT_EQ(sink_wants[0].max_pixel_count, 320 * 180);
+  EXPECT_EQ(sink_wants[0].max_framerate_fps,
+            rtc::VideoSinkWants().max_framerate_fps);
+  EXPECT_EQ(sink_wants[1].max_pixel_count,
+            rtc::VideoSinkWants().max_pixel_count);
+  EXPECT_EQ(sink_wants[1].max_framerate_fps, 5);
+}
+
+TEST(MediaApiClientTest, PausingVideoDetachesVideoTrackSink) {
+  rtc::scoped_refptr<webrtc::MockVideoTrack> mock_video_track =
+      webrtc::MockVideoTrack::Create();
+  EXPECT_CALL(*mock_video_track, AddOrUpdateSink).Times(2);
+  EXPECT_CALL(*mock_video_track, RemoveSink);
+  auto mock_receiver = rtc::scoped_refptr<webrtc::MockRtpReceiver>(
+      new webrtc::MockRtpReceiver());
+  ON_CALL(*mock_receiver, media_type)
+      .WillByDefault(Return(cricket::MediaType::MEDIA_TYPE_VIDEO));
+  ON_CALL(*mock_receiver, track).WillByDefault(Return(mock_video_track));
+  rtc::scoped_refptr<webrtc::MockRtpTransceiver> mock_transceiver =
+      webrtc::MockRtpTransceiver::Create();
+  ON_CALL(*mock_transceiver, mid).WillByDefault(Return("mid"));
+  ON_CALL(*mock_transceiver, receiver).WillByDefault(Return(mock_receiver));
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  ConferencePeerConnection::TrackSignaledCallback track_signaled_callback;
+  EXPECT_CALL(*peer_connection, SetTrackSignaledCallback)
+      .WillOnce([&](ConferencePeerConnection::TrackSignaledCallback callback) {
+        track_signaled_callback = std::move(callback);
+      });
+  MediaApiClient client(CreateThread("client_thread"),
+                        CreateThread("worker_thread"),
+                        webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+                        std::move(peer_connection),
+                        CreateConferenceDataChannels());
+  track_signaled_callback(std::move(mock_transceiver));
+
+  client.PauseMedia(MediaKind::kVideo);
+  // Pausing again, or pausing the track itself, does not detach it twice.
+  client.PauseMedia(MediaKind::kVideo);
+  client.PauseTrack("mid");
+  client.ResumeMedia(MediaKind::kVideo);
+  client.ResumeTrack("mid");
+}
+
+TEST(MediaApiClientTest, PausedVideoTrackIsAttachedOnceResumed) {
+  std::vector<rtc::VideoSinkWants> sink_wants;
+  rtc::scoped_refptr<webrtc::MockVideoTrack> mock_video_track =
+      webrtc::MockVideoTrack::Create();
+  ON_CALL(*mock_video_track, AddOrUpdateSink)
+      .WillByDefault(
+          [&sink_wants](rtc::VideoSinkInterface<webrtc::VideoFrame>*,
+                        const rtc::VideoSinkWants& wants) {
+            sink_wants.push_back(wants);
+          });
+  auto mock_receiver = rtc::scoped_refptr<webrtc::MockRtpReceiver>(
+      new webrtc::MockRtpReceiver());
+  ON_CALL(*mock_receiver, media_type)
+      .WillByDefault(Return(cricket::MediaType::MEDIA_TYPE_VIDEO));
+  ON_CALL(*mock_receiver, track).WillByDefault(Return(mock_video_track));
+  rtc::scoped_refptr<webrtc::MockRtpTransceiver> mock_transceiver =
+      webrtc::MockRtpTransceiver::Create();
+  ON_CALL(*mock_transceiver, mid).WillByDefault(Return("mid"));
+  ON_CALL(*mock_transceiver, receiver).WillByDefault(Return(mock_receiver));
+  auto peer_connection = std::make_unique<MockConferencePeerConnection>();
+  ConferencePeerConnection::TrackSignaledCallback track_signaled_callback;
+  EXPECT_CALL(*peer_connection, SetTrackSignaledCallback)
+      .WillOnce([&](ConferencePeerConnection::TrackSignaledCallback callback) {
+        track_signaled_callback = std::move(callback);
+      });
+  MediaApiClient client(CreateThread("client_thread"),
+                        CreateThread("worker_thread"),
+                        webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+                        std::move(peer_connection),
+                        CreateConferenceDataChannels());
+  // Tracks paused before they are signaled are not attached.
+  client.PauseTrack("mid");
+  track_signaled_callback(std::move(mock_transceiver));
+  // Constraints set while paused apply once the track is attached.
+  ASSERT_OK(client.SetVideoSinkConstraints({.max_pixel_count = 320 * 180}));
+  EXPECT_THAT(sink_wants, IsEmpty());
+
+  client.ResumeTrack("mid");
+
+  ASSERT_THAT(sink_wants, SizeIs(1));
+  EXPECT_EQ(sink_wants[0].max_pixel_count, 320 * 180);
+}
+
+TEST(MediaApiClientTest, SetVideoSinkConstraintsFailsWithNonPositiveLimit) {
+  MediaApiClient client(CreateThread("client_thread"),
+                        CreateThread("worker_thread"),
+                        webrtc::make_ref_counted<MockMediaApiClientObserver>(),
+                        std::make_unique<MockConferencePeerConnection>(),
+                        CreateConferenceDataChannels());
+
+  EXPECT_THAT(client.SetVideoSinkConstraints({.max_framerate_fps = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Video sink max framerate must be positive; got 0"));
+}
+
 TEST(MediaApiClientTest, LogsWarningIfSignaledTrackIsUnsupported) {
   auto mock_receiver = rtc::scoped_refptr<webrtc::MockRtpReceiver>(
       new webrtc::MockRtpReceiver());
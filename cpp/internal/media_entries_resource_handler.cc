@@ -22,205 +22,137 @@
 #include <utility>
 #include <vector>
 
-#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
-#include "nlohmann/json.hpp"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/media_entries_resource.h"
+#include "cpp/internal/json_stream_parser.h"
+#include "cpp/internal/trace.h"
+#include "cpp/internal/trace_events.h"
 
 namespace meet {
 namespace {
-using Json = ::nlohmann::json;
 
-const Json* FindOrNull(const Json& json, absl::string_view key) {
-  auto it = json.find(key);
-  return it != json.cend() ? &*it : nullptr;
-}
-
-}  // namespace
-
-absl::StatusOr<ResourceUpdate> MediaEntriesResourceHandler::ParseUpdate(
-    absl::string_view update) {
-  VLOG(1) << "Media entries resource update received: " << update;
-
-  const Json json_resource_update = Json::parse(update, /*cb=*/nullptr,
-                                                /*allow_exceptions=*/false);
-
-  if (!json_resource_update.is_object()) {
-    return absl::InternalError(absl::StrCat(
-        "Invalid media entries resource update json format: ", update));
+// Fills a `MediaEntriesChannelToClient` as the update is parsed.
+class MediaEntriesUpdateBuilder : public JsonStreamHandler {
+ public:
+  absl::Status OnObjectStart(absl::string_view path) override {
+    if (absl::Status status = CheckNotArrayField(path); !status.ok()) {
+      return status;
+    }
+    if (path == "resources[]") {
+      update_.resources.emplace_back();
+    } else if (path == "resources[].mediaEntry") {
+      update_.resources.back().media_entry.emplace();
+    } else if (path == "deletedResources[]") {
+      update_.deleted_resources.emplace_back();
+    }
+    return absl::OkStatus();
   }
 
-  MediaEntriesChannelToClient media_entries_update;
-  // Resources
-  if (const Json* resources_field =
-          FindOrNull(json_resource_update, "resources");
-      resources_field != nullptr) {
-    if (!resources_field->is_array()) {
-      return absl::InternalError(
-          absl::StrCat("Invalid  media entries resource update json format. "
-                       "Expected resources field to be an array: ",
-                       update));
+  absl::Status OnScalar(absl::string_view path, JsonScalar value) override {
+    if (absl::Status status = CheckNotArrayField(path); !status.ok()) {
+      return status;
     }
-
-    std::vector<MediaEntriesResourceSnapshot>& resources =
-        media_entries_update.resources;
-    for (const Json& resource : *resources_field) {
-      // Resources.resourceSnapshot
-      MediaEntriesResourceSnapshot snapshot;
-
-      // Resources.resourceSnapshot.id
-      if (const Json* id_field = FindOrNull(resource, "id");
-          id_field != nullptr) {
-        snapshot.id = id_field->get<int64_t>();
-      } else {
-        snapshot.id = 0;
-      }
-
-      // Resources.resourceSnapshot.mediaEntry
-      if (const Json* media_entry_field = FindOrNull(resource, "mediaEntry");
-          media_entry_field != nullptr) {
-        MediaEntry media_entry;
-
-        // Resources.resourceSnapshot.mediaEntry.participant
-        if (const Json* participant_field =
-                FindOrNull(*media_entry_field, "participant");
-            participant_field != nullptr) {
-          media_entry.participant = participant_field->get<std::string>();
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.participantKey
-        if (const Json* participant_key_field =
-                FindOrNull(*media_entry_field, "participantKey");
-            participant_key_field != nullptr) {
-          media_entry.participant_key =
-              participant_key_field->get<std::string>();
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.session
-        if (const Json* session_field =
-                FindOrNull(*media_entry_field, "session");
-            session_field != nullptr) {
-          media_entry.session = session_field->get<std::string>();
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.sessionName
-        if (const Json* session_name_field =
-                FindOrNull(*media_entry_field, "sessionName");
-            session_name_field != nullptr) {
-          media_entry.session_name = session_name_field->get<std::string>();
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.audioCsrc
-        if (const Json* audio_csrc_field =
-                FindOrNull(*media_entry_field, "audioCsrc");
-            audio_csrc_field != nullptr) {
-          media_entry.audio_csrc = audio_csrc_field->get<uint32_t>();
-        } else {
-          media_entry.audio_csrc = 0;
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.videoCsrcs
-        if (const Json* video_csrcs_field =
-                FindOrNull(*media_entry_field, "videoCsrcs");
-            video_csrcs_field != nullptr) {
-          if (!video_csrcs_field->is_array()) {
-            return absl::InternalError(absl::StrCat(
-                "Invalid media entries resource update json format. Expected "
-                "videoCsrcs field to be an array: ",
-                update));
-          }
-          for (const Json& video_csrc : *video_csrcs_field) {
-            media_entry.video_csrcs.push_back(video_csrc.get<uint32_t>());
-          }
-        } else {
-          media_entry.video_csrcs.clear();
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.presenter
-        if (const Json* presenter_field =
-                FindOrNull(*media_entry_field, "presenter");
-            presenter_field != nullptr) {
-          media_entry.presenter = presenter_field->get<bool>();
-        } else {
-          media_entry.presenter = false;
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.screenshare
-        if (const Json* screenshare_field =
-                FindOrNull(*media_entry_field, "screenshare");
-            screenshare_field != nullptr) {
-          media_entry.screenshare = screenshare_field->get<bool>();
-        } else {
-          media_entry.screenshare = false;
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.audioMuted
-        if (const Json* audio_muted_field =
-                FindOrNull(*media_entry_field, "audioMuted");
-            audio_muted_field != nullptr) {
-          media_entry.audio_muted = audio_muted_field->get<bool>();
-        } else {
-          media_entry.audio_muted = false;
-        }
-
-        // Resources.resourceSnapshot.mediaEntry.videoMuted
-        if (const Json* video_muted_field =
-                FindOrNull(*media_entry_field, "videoMuted");
-            video_muted_field != nullptr) {
-          media_entry.video_muted = video_muted_field->get<bool>();
-        } else {
-          media_entry.video_muted = false;
-        }
-
-        snapshot.media_entry = std::move(media_entry);
-      } else {
-        snapshot.media_entry = std::nullopt;
-      }
-      resources.push_back(std::move(snapshot));
+    if (path == "resources[].id") {
+      return AssignJsonScalar(path, std::move(value),
+                              update_.resources.back().id);
     }
+    if (path == "resources[].mediaEntry.participant") {
+      return AssignOptional(path, std::move(value), media_entry().participant);
+    }
+    if (path == "resources[].mediaEntry.participantKey") {
+      return AssignOptional(path, std::move(value),
+                            media_entry().participant_key);
+    }
+    if (path == "resources[].mediaEntry.session") {
+      return AssignOptional(path, std::move(value), media_entry().session);
+    }
+    if (path == "resources[].mediaEntry.sessionName") {
+      return AssignOptional(path, std::move(value),
+                            media_entry().session_name);
+    }
+    if (path == "resources[].mediaEntry.audioCsrc") {
+      return AssignJsonScalar(path, std::move(value), media_entry().audio_csrc);
+    }
+    if (path == "resources[].mediaEntry.videoCsrcs[]") {
+      return AssignJsonScalar(path, std::move(value),
+                              media_entry().video_csrcs.emplace_back());
+    }
+    if (path == "resources[].mediaEntry.presenter") {
+      return AssignJsonScalar(path, std::move(value), media_entry().presenter);
+    }
+    if (path == "resources[].mediaEntry.screenshare") {
+      return AssignJsonScalar(path, std::move(value),
+                              media_entry().screenshare);
+    }
+    if (path == "resources[].mediaEntry.audioMuted") {
+      return AssignJsonScalar(path, std::move(value),
+                              media_entry().audio_muted);
+    }
+    if (path == "resources[].mediaEntry.videoMuted") {
+      return AssignJsonScalar(path, std::move(value),
+                              media_entry().video_muted);
+    }
+    if (path == "deletedResources[].id") {
+      return AssignJsonScalar(path, std::move(value),
+                              update_.deleted_resources.back().id);
+    }
+    if (path == "deletedResources[].mediaEntry") {
+      return AssignOptional(path, std::move(value),
+                            update_.deleted_resources.back().media_entry);
+    }
+    return absl::OkStatus();
   }
 
-  // deletedResources
-  if (const Json* deleted_resources_field =
-          FindOrNull(json_resource_update, "deletedResources");
-      deleted_resources_field != nullptr) {
-    if (!deleted_resources_field->is_array()) {
+  MediaEntriesChannelToClient& update() { return update_; }
+
+ private:
+  // These fields may only be arrays.
+  static absl::Status CheckNotArrayField(absl::string_view path) {
+    if (path == "resources" || path == "deletedResources" ||
+        path == "resources[].mediaEntry.videoCsrcs") {
       return absl::InternalError(
-          absl::StrCat("Invalid media entries resource update json format. "
-                       "Expected deletedResources field to be an array: ",
-                       update));
+          absl::StrCat("Expected ", path, " field to be an array"));
     }
+    return absl::OkStatus();
+  }
 
-    std::vector<MediaEntriesDeletedResource>& deleted_resources =
-        media_entries_update.deleted_resources;
-    for (const Json& deleted_resource : *deleted_resources_field) {
-      // deletedResources.deletedResource
-      MediaEntriesDeletedResource deleted_entry;
+  template <typename T>
+  static absl::Status AssignOptional(absl::string_view path, JsonScalar value,
+                                     std::optional<T>& field) {
+    return AssignJsonScalar(path, std::move(value), field.emplace());
+  }
 
-      // deletedResources.deletedResource.id
-      if (const Json* id_field = FindOrNull(deleted_resource, "id");
-          id_field != nullptr) {
-        deleted_entry.id = id_field->get<int64_t>();
-      } else {
-        deleted_entry.id = 0;
-      }
+  MediaEntry& media_entry() { return *update_.resources.back().media_entry; }
 
-      // deletedResources.deletedResource.mediaEntry
-      if (const Json* media_entry_field =
-              FindOrNull(deleted_resource, "mediaEntry");
-          media_entry_field != nullptr) {
-        deleted_entry.media_entry = media_entry_field->get<bool>();
-      } else {
-        deleted_entry.media_entry = std::nullopt;
-      }
-      deleted_resources.push_back(std::move(deleted_entry));
-    }
-  }
+  MediaEntriesChannelToClient update_;
+};
 
-  return std::move(media_entries_update);
+}  // namespace
+
+absl::StatusOr<ResourceUpdate> MediaEntriesResourceHandler::ParseUpdate(
+    absl::string_view update) {
+  MEET_TRACE_EVENT("MediaEntriesResourceHandler::ParseUpdate");
+  MEET_TRACE(kResourceUpdate) << "Media entries resource update received: "
+                              << update;
+
+  // The update is parsed as a stream rather than into a DOM, as snapshots in
+  // large meetings can be large.
+  MediaEntriesUpdateBuilder builder;
+  absl::Status status = ParseJsonObject(update, builder);
+  if (absl::IsInvalidArgument(status)) {
+    return absl::InternalError(absl::StrCat(
+        "Invalid media entries resource update json format: ", update));
+  }
+  if (!status.ok()) {
+    return absl::InternalError(
+        absl::StrCat("Invalid media entries resource update json format. ",
+                     status.message(), ": ", update));
+  }
+  return std::move(builder.update());
 }
+
 }  // namespace meet
@@ -16,6 +16,7 @@
 
 #include "cpp/internal/media_stats_resource_handler.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <utility>
@@ -24,7 +25,6 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
-#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -32,6 +32,9 @@
 #include "nlohmann/json.hpp"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/media_stats_resource.h"
+#include "cpp/internal/json_writer.h"
+#include "cpp/internal/trace.h"
+#include "cpp/internal/trace_events.h"
 
 namespace meet {
 namespace {
@@ -49,7 +52,9 @@ const Json* FindOrNull(const Json& json, absl::string_view key) {
 
 absl::StatusOr<ResourceUpdate> MediaStatsResourceHandler::ParseUpdate(
     absl::string_view update) {
-  VLOG(1) << kMediaStatsResourceName << " resource update received: " << update;
+  MEET_TRACE_EVENT("MediaStatsResourceHandler::ParseUpdate");
+  MEET_TRACE(kResourceUpdate) << kMediaStatsResourceName
+                              << " resource update received: " << update;
 
   const Json json_resource_update = Json::parse(update, /*cb=*/nullptr,
                                                 /*allow_exceptions=*/false);
@@ -192,34 +197,58 @@ absl::StatusOr<std::string> MediaStatsResourceHandler::StringifyRequest(
         "MediaStatsResourceHandler only supports MediaStatsChannelFromClient");
   }
 
-  auto media_stats_request = std::get<MediaStatsChannelFromClient>(request);
+  const MediaStatsRequest& media_stats_request =
+      std::get<MediaStatsChannelFromClient>(request).request;
 
-  if (media_stats_request.request.request_id == 0) {
+  if (media_stats_request.request_id == 0) {
     return absl::InvalidArgumentError("Request ID must be set");
   }
 
-  nlohmann::basic_json<> json_request;
-
-  // Request.requestId
-  json_request["request"]["requestId"] = media_stats_request.request.request_id;
+  // Keys are written in lexicographic order. See `JsonWriter`.
+  std::string json_request;
+  JsonWriter writer(json_request);
+  writer.BeginObject()
+      .Key("request")
+      .BeginObject()
+      .Key("requestId")
+      .Int(media_stats_request.request_id);
   // Request.uploadMediaStats
-  if (media_stats_request.request.upload_media_stats.has_value()) {
+  if (media_stats_request.upload_media_stats.has_value() &&
+      !media_stats_request.upload_media_stats->sections.empty()) {
     // Request.uploadMediaStats.sections
+    writer.Key("uploadMediaStats").BeginObject().Key("sections").BeginArray();
+    std::vector<const std::pair<const std::string, std::string>*> values;
     for (const MediaStatsSection& section :
-         media_stats_request.request.upload_media_stats->sections) {
-      nlohmann::basic_json<> section_json;
-      section_json["id"] = section.id;
-      for (const auto& [name, value] : section.values) {
-        // TODO: Refactor media stats data handling to avoid
-        // making copies of `value`. Each media stats report can include
-        // multiple kilobytes of data and therefore we should avoid copying it.
-        section_json[section.type][name] = value;
+         media_stats_request.upload_media_stats->sections) {
+      writer.BeginObject();
+      const bool type_before_id = section.type < "id";
+      if (!type_before_id) {
+        writer.Key("id").String(section.id);
+      }
+      if (!section.values.empty()) {
+        values.clear();
+        for (const auto& value : section.values) {
+          values.push_back(&value);
+        }
+        std::sort(values.begin(), values.end(),
+                  [](const auto* a, const auto* b) {
+                    return a->first < b->first;
+                  });
+        writer.Key(section.type).BeginObject();
+        for (const auto* value : values) {
+          writer.Key(value->first).String(value->second);
+        }
+        writer.EndObject();
+      }
+      if (type_before_id) {
+        writer.Key("id").String(section.id);
       }
-      json_request["request"]["uploadMediaStats"]["sections"].push_back(
-          std::move(section_json));
+      writer.EndObject();
     }
+    writer.EndArray().EndObject();
   }
-  return json_request.dump();
+  writer.EndObject().EndObject();
+  return json_request;
 }
 
 }  // namespace meet
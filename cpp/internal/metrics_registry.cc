@@ -0,0 +1,94 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/metrics_registry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_metrics.h"
+
+namespace meet {
+Histogram::Histogram(absl::Span<const double> bucket_bounds)
+    : bucket_bounds_(bucket_bounds.begin(), bucket_bounds.end()),
+      bucket_counts_(
+          std::make_unique<std::atomic<uint64_t>[]>(bucket_bounds.size() + 1)) {
+}
+
+void Histogram::Record(double value) {
+  size_t bucket =
+      std::lower_bound(bucket_bounds_.begin(), bucket_bounds_.end(), value) -
+      bucket_bounds_.begin();
+  bucket_counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  HistogramSnapshot snapshot{.bucket_bounds = bucket_bounds_};
+  snapshot.bucket_counts.reserve(bucket_bounds_.size() + 1);
+  for (size_t i = 0; i <= bucket_bounds_.size(); ++i) {
+    snapshot.bucket_counts.push_back(
+        bucket_counts_[i].load(std::memory_order_relaxed));
+  }
+  snapshot.count = count_.load(std::memory_order_relaxed);
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+Counter& MetricsRegistry::GetCounter(absl::string_view name) {
+  absl::MutexLock lock(&mutex_);
+  std::unique_ptr<Counter>& counter = counters_[name];
+  if (counter == nullptr) {
+    counter = std::make_unique<Counter>();
+  }
+  return *counter;
+}
+
+Histogram& MetricsRegistry::GetHistogram(
+    absl::string_view name, absl::Span<const double> bucket_bounds) {
+  absl::MutexLock lock(&mutex_);
+  std::unique_ptr<Histogram>& histogram = histograms_[name];
+  if (histogram == nullptr) {
+    histogram = std::make_unique<Histogram>(bucket_bounds);
+  }
+  return *histogram;
+}
+
+MediaApiClientMetrics MetricsRegistry::Snapshot() const {
+  absl::MutexLock lock(&mutex_);
+  MediaApiClientMetrics metrics;
+  metrics.counters.reserve(counters_.size());
+  for (const auto& [name, counter] : counters_) {
+    metrics.counters.try_emplace(name, counter->value());
+  }
+  metrics.histograms.reserve(histograms_.size());
+  for (const auto& [name, histogram] : histograms_) {
+    metrics.histograms.try_emplace(name, histogram->Snapshot());
+  }
+  return metrics;
+}
+
+}  // namespace meet
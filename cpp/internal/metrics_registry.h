@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_METRICS_REGISTRY_H_
+#define CPP_INTERNAL_METRICS_REGISTRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_metrics.h"
+
+namespace meet {
+
+// Bucket bounds for latencies and durations, in microseconds. Covers 50us to
+// 10s.
+inline constexpr double kLatencyBucketsUs[] = {
+    50,      100,     250,       500,       1'000,     2'500,
+    5'000,   10'000,  25'000,    50'000,    100'000,   250'000,
+    500'000, 1'000'000, 2'500'000, 5'000'000, 10'000'000};
+
+// Bucket bounds for message sizes, in bytes. Covers 256B to 4MiB.
+inline constexpr double kSizeBucketsBytes[] = {
+    256, 1'024, 4'096, 16'384, 65'536, 262'144, 1'048'576, 4'194'304};
+
+// A monotonically increasing counter.
+//
+// This class is thread-safe.
+class Counter {
+ public:
+  void Increment(uint64_t value = 1) {
+    value_.fetch_add(value, std::memory_order_relaxed);
+  }
+  uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_ = 0;
+};
+
+// A histogram with fixed bucket bounds.
+//
+// This class is thread-safe. Values are recorded without locking, so a
+// snapshot taken while values are being recorded may be off by the values
+// being recorded.
+class Histogram {
+ public:
+  explicit Histogram(absl::Span<const double> bucket_bounds);
+
+  // Histogram is neither copyable nor movable.
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
+  void Record(double value);
+  HistogramSnapshot Snapshot() const;
+
+ private:
+  const std::vector<double> bucket_bounds_;
+  // One more bucket than there are bounds, for values greater than every
+  // bound.
+  std::unique_ptr<std::atomic<uint64_t>[]> bucket_counts_;
+  std::atomic<uint64_t> count_ = 0;
+  std::atomic<double> sum_ = 0;
+};
+
+// A set of named counters and histograms describing a client's internals.
+//
+// Metrics are created on first lookup and live as long as the registry, so
+// components are expected to look up their metrics once and record into them
+// directly. Recording never locks the registry.
+//
+// This class is thread-safe.
+class MetricsRegistry {
+ public:
+  MetricsRegistry() = default;
+
+  // MetricsRegistry is neither copyable nor movable.
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  // Returns the counter with the given name, creating it if needed.
+  Counter& GetCounter(absl::string_view name);
+
+  // Returns the histogram with the given name, creating it with
+  // `bucket_bounds` if needed. `bucket_bounds` must be in ascending order, and
+  // is ignored if the histogram already exists.
+  Histogram& GetHistogram(absl::string_view name,
+                          absl::Span<const double> bucket_bounds);
+
+  MediaApiClientMetrics Snapshot() const;
+
+ private:
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::unique_ptr<Counter>> counters_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, std::unique_ptr<Histogram>> histograms_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_METRICS_REGISTRY_H_
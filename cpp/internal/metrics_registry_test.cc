@@ -0,0 +1,108 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/metrics_registry.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "cpp/api/media_api_client_metrics.h"
+
+namespace meet {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(MetricsRegistryTest, SnapshotIsEmptyWithoutMetrics) {
+  MetricsRegistry registry;
+
+  MediaApiClientMetrics metrics = registry.Snapshot();
+
+  EXPECT_THAT(metrics.counters, IsEmpty());
+  EXPECT_THAT(metrics.histograms, IsEmpty());
+}
+
+TEST(MetricsRegistryTest, CountsIncrements) {
+  MetricsRegistry registry;
+  Counter& counter = registry.GetCounter("meet_test_total");
+
+  counter.Increment();
+  counter.Increment(4);
+
+  MediaApiClientMetrics metrics = registry.Snapshot();
+  EXPECT_EQ(metrics.counters["meet_test_total"], 5);
+}
+
+TEST(MetricsRegistryTest, ReturnsSameMetricForSameName) {
+  MetricsRegistry registry;
+
+  EXPECT_EQ(&registry.GetCounter("meet_test_total"),
+            &registry.GetCounter("meet_test_total"));
+  EXPECT_EQ(&registry.GetHistogram("meet_test_us", {1, 2}),
+            &registry.GetHistogram("meet_test_us", {3, 4, 5}));
+  EXPECT_NE(&registry.GetCounter("meet_test_total{mid=\"1\"}"),
+            &registry.GetCounter("meet_test_total{mid=\"2\"}"));
+}
+
+TEST(MetricsRegistryTest, RecordsHistogramValuesIntoBuckets) {
+  MetricsRegistry registry;
+  Histogram& histogram = registry.GetHistogram("meet_test_us", {10, 100});
+
+  histogram.Record(5);
+  histogram.Record(10);
+  histogram.Record(50);
+  histogram.Record(500);
+
+  MediaApiClientMetrics metrics = registry.Snapshot();
+  const HistogramSnapshot& snapshot = metrics.histograms["meet_test_us"];
+  EXPECT_THAT(snapshot.bucket_bounds, ElementsAre(10, 100));
+  // Bounds are inclusive.
+  EXPECT_THAT(snapshot.bucket_counts, ElementsAre(2, 1, 1));
+  EXPECT_EQ(snapshot.count, 4);
+  EXPECT_EQ(snapshot.sum, 565);
+}
+
+TEST(MetricsRegistryTest, RecordsFromMultipleThreads) {
+  MetricsRegistry registry;
+  Counter& counter = registry.GetCounter("meet_test_total");
+  Histogram& histogram = registry.GetHistogram("meet_test_us", {10});
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 1000; ++j) {
+        counter.Increment();
+        histogram.Record(1);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  MediaApiClientMetrics metrics = registry.Snapshot();
+  EXPECT_EQ(metrics.counters["meet_test_total"], 4000);
+  EXPECT_EQ(metrics.histograms["meet_test_us"].count, 4000);
+  EXPECT_EQ(metrics.histograms["meet_test_us"].sum, 4000);
+}
+
+}  // namespace
+}  // namespace meet
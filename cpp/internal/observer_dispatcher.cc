@@ -0,0 +1,324 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/observer_dispatcher.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/audio_buffer_pool.h"
+#include "cpp/internal/metrics_registry.h"
+#include "cpp/internal/variant_utils.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/time_utils.h"
+
+namespace meet {
+
+absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>>
+ObserverDispatcher::Create(
+    rtc::scoped_refptr<MediaApiClientObserverInterface> observer,
+    const ObserverDispatchConfiguration& config,
+    std::shared_ptr<MetricsRegistry> metrics) {
+  if (config.worker_thread_count == 0) {
+    return absl::InvalidArgumentError(
+        "Observer dispatch worker thread count must be greater than 0");
+  }
+  if (config.max_queued_audio_frames == 0 ||
+      config.max_queued_video_frames == 0) {
+    return absl::InvalidArgumentError(
+        "Observer dispatch queue sizes must be greater than 0");
+  }
+
+  std::vector<std::unique_ptr<rtc::Thread>> dispatch_threads;
+  dispatch_threads.reserve(config.worker_thread_count);
+  for (uint32_t i = 0; i < config.worker_thread_count; ++i) {
+    std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+    thread->SetName(absl::StrCat("media_api_observer_dispatch_thread_", i),
+                    nullptr);
+    if (!thread->Start()) {
+      return absl::InternalError("Failed to start observer dispatch thread");
+    }
+    dispatch_threads.push_back(std::move(thread));
+  }
+
+  return rtc::make_ref_counted<ObserverDispatcher>(
+      std::move(observer), config, std::move(dispatch_threads),
+      std::move(metrics));
+}
+
+ObserverDispatcher::~ObserverDispatcher() {
+  // Stop the threads to ensure that enqueued tasks do not access member
+  // fields after they have been destroyed.
+  Stop();
+}
+
+void ObserverDispatcher::Stop() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopped_ = true;
+  }
+  for (const std::unique_ptr<rtc::Thread>& thread : dispatch_threads_) {
+    DCHECK(!thread->IsCurrent())
+        << "ObserverDispatcher stopped or destroyed from an observer callback";
+    thread->Stop();
+  }
+}
+
+void ObserverDispatcher::OnJoined() {
+  EnqueueControlEvent([observer = observer_]() { observer->OnJoined(); });
+}
+
+void ObserverDispatcher::OnJoined(const JoinTimings& timings) {
+  EnqueueControlEvent(
+      [observer = observer_, timings]() { observer->OnJoined(timings); });
+}
+
+void ObserverDispatcher::OnResourceUpdate(ResourceUpdate update) {
+  EnqueueControlEvent(
+      [observer = observer_, update = std::move(update)]() mutable {
+        observer->OnResourceUpdate(std::move(update));
+      });
+}
+
+void ObserverDispatcher::OnDisconnected(absl::Status status) {
+  absl::MutexLock lock(&mutex_);
+  if (disconnect_status_.has_value()) {
+    LOG(WARNING) << "OnDisconnected called more than once; ignoring status: "
+                 << status;
+    return;
+  }
+  disconnect_status_ = std::move(status);
+  PostDispatchTask();
+}
+
+void ObserverDispatcher::OnAudioFrame(AudioFrame frame) {
+  // Frames are queued beyond the lifetime of this call, so they must own their
+  // samples.
+  if (frame.buffer == nullptr) {
+    frame.buffer = audio_buffer_pool_.Acquire(frame.pcm16);
+    frame.pcm16 = frame.buffer->pcm16();
+  }
+  EnqueueAudioFrame(std::move(frame));
+}
+
+void ObserverDispatcher::OnEncodedAudioFrame(EncodedAudioFrame frame) {
+  EnqueueAudioFrame(std::move(frame));
+}
+
+void ObserverDispatcher::EnqueueAudioFrame(QueuedAudioFrame frame) {
+  absl::MutexLock lock(&mutex_);
+  if (disconnect_status_.has_value()) {
+    return;
+  }
+  if (audio_frames_.size() >= max_queued_audio_frames_) {
+    // Keep the frames already queued so that the delivered audio stays
+    // contiguous, and drop the newest frame instead.
+    ++dropped_audio_frames_;
+    dropped_audio_frames_total_.Increment();
+    LOG_EVERY_N_SEC(WARNING, 10)
+        << "Observer dispatch audio queue is full; dropped "
+        << dropped_audio_frames_ << " audio frames so far";
+    return;
+  }
+  audio_frames_.push_back(std::move(frame));
+  PostDispatchTask();
+}
+
+void ObserverDispatcher::OnVideoFrame(VideoFrame frame) {
+  absl::MutexLock lock(&mutex_);
+  if (disconnect_status_.has_value()) {
+    return;
+  }
+  bool queue_full = video_frames_.size() >= max_queued_video_frames_;
+  if (queue_full) {
+    // Stale video is less useful than fresh video, so drop the oldest frame.
+    video_frames_.pop_front();
+    ++dropped_video_frames_;
+    dropped_video_frames_total_.Increment();
+    LOG_EVERY_N_SEC(WARNING, 10)
+        << "Observer dispatch video queue is full; dropped "
+        << dropped_video_frames_ << " video frames so far";
+  }
+  video_frames_.push_back(QueuedVideoFrame{
+      .frame = frame.frame,
+      .contributing_source = frame.contributing_source,
+      .synchronization_source = frame.synchronization_source,
+      .receive_time = frame.receive_time});
+  // A dispatch task was already posted for the dropped frame.
+  if (queue_full) {
+    return;
+  }
+  PostDispatchTask();
+}
+
+void ObserverDispatcher::OnEncodedVideoFrame(EncodedVideoFrame frame) {
+  absl::MutexLock lock(&mutex_);
+  if (disconnect_status_.has_value()) {
+    return;
+  }
+  if (ssrcs_awaiting_key_frame_.contains(frame.synchronization_source)) {
+    if (!frame.is_key_frame) {
+      ++dropped_video_frames_;
+      dropped_video_frames_total_.Increment();
+      return;
+    }
+    ssrcs_awaiting_key_frame_.erase(frame.synchronization_source);
+  }
+  if (video_frames_.size() >= max_queued_video_frames_) {
+    // Unlike decoded frames, encoded frames depend on the frames before them,
+    // so the queued frames are kept and the stream resumes at its next key
+    // frame.
+    ssrcs_awaiting_key_frame_.insert(frame.synchronization_source);
+    ++dropped_video_frames_;
+    dropped_video_frames_total_.Increment();
+    LOG_EVERY_N_SEC(WARNING, 10)
+        << "Observer dispatch video queue is full; dropped "
+        << dropped_video_frames_ << " video frames so far";
+    return;
+  }
+  video_frames_.push_back(std::move(frame));
+  PostDispatchTask();
+}
+
+void ObserverDispatcher::EnqueueControlEvent(
+    ControlEvent event) {
+  absl::MutexLock lock(&mutex_);
+  if (disconnect_status_.has_value()) {
+    return;
+  }
+  control_events_.push_back(std::move(event));
+  PostDispatchTask();
+}
+
+void ObserverDispatcher::PostDispatchTask() {
+  rtc::Thread* thread =
+      dispatch_threads_[next_dispatch_thread_++ % dispatch_threads_.size()]
+          .get();
+  // The dispatcher joins its threads before being destroyed, so `this` is
+  // valid for the lifetime of the task.
+  thread->PostTask([this]() { DispatchPending(); });
+}
+
+void ObserverDispatcher::DispatchPending() {
+  // A callback that has been removed from the queues and is ready to be
+  // invoked outside of the lock.
+  using DispatchItem =
+      std::variant<std::monostate, ControlEvent, AudioFrame, EncodedAudioFrame,
+                   QueuedVideoFrame, EncodedVideoFrame, absl::Status>;
+  while (true) {
+    DispatchItem item;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (disconnect_dispatched_ || stopped_) {
+        return;
+      }
+
+      // Control events act as barriers: they wait for in-flight media
+      // callbacks to finish, and media is not dispatched while control events
+      // are pending or in flight.
+      if (!control_event_in_flight_ && !control_events_.empty()) {
+        if (media_in_flight_ > 0) {
+          // The last media callback to finish will dispatch the control event.
+          return;
+        }
+        item = std::move(control_events_.front());
+        control_events_.pop_front();
+        control_event_in_flight_ = true;
+      } else if (control_event_in_flight_ || !control_events_.empty()) {
+        // The in-flight control event will continue dispatching once it
+        // finishes.
+        return;
+      } else if (!audio_frames_.empty()) {
+        // Audio is prioritized over video since gaps in audio are more
+        // noticeable than dropped video frames.
+        std::visit([&item](auto& frame) { item = std::move(frame); },
+                   audio_frames_.front());
+        audio_frames_.pop_front();
+        ++media_in_flight_;
+      } else if (!video_frames_.empty()) {
+        std::visit([&item](auto& frame) { item = std::move(frame); },
+                   video_frames_.front());
+        video_frames_.pop_front();
+        ++media_in_flight_;
+      } else if (disconnect_status_.has_value() && media_in_flight_ == 0) {
+        item = *disconnect_status_;
+        disconnect_dispatched_ = true;
+      } else {
+        return;
+      }
+    }
+
+    int64_t callback_start_us = rtc::TimeMicros();
+    std::visit(
+        overloaded{
+            [](std::monostate) {},
+            [](ControlEvent& event) { std::move(event)(); },
+            [this](AudioFrame& frame) {
+              observer_->OnAudioFrame(std::move(frame));
+            },
+            [this](EncodedAudioFrame& frame) {
+              observer_->OnEncodedAudioFrame(std::move(frame));
+            },
+            [this](QueuedVideoFrame& queued) {
+              observer_->OnVideoFrame(VideoFrame{
+                  .frame = queued.frame,
+                  .contributing_source = queued.contributing_source,
+                  .synchronization_source = queued.synchronization_source,
+                  .receive_time = queued.receive_time});
+            },
+            [this](EncodedVideoFrame& frame) {
+              observer_->OnEncodedVideoFrame(std::move(frame));
+            },
+            [this](absl::Status& status) {
+              observer_->OnDisconnected(std::move(status));
+            }},
+        item);
+    callback_latency_us_.Record(rtc::TimeMicros() - callback_start_us);
+
+    absl::MutexLock lock(&mutex_);
+    if (std::holds_alternative<ControlEvent>(item)) {
+      control_event_in_flight_ = false;
+      // Dispatch tasks for media queued behind the control event may have
+      // already returned, so wake up the other threads to restore concurrency.
+      size_t queued_media = audio_frames_.size() + video_frames_.size();
+      for (size_t i = 1; i < dispatch_threads_.size() && i < queued_media;
+           ++i) {
+        PostDispatchTask();
+      }
+    } else if (std::holds_alternative<AudioFrame>(item) ||
+               std::holds_alternative<EncodedAudioFrame>(item) ||
+               std::holds_alternative<QueuedVideoFrame>(item) ||
+               std::holds_alternative<EncodedVideoFrame>(item)) {
+      --media_in_flight_;
+    }
+  }
+}
+
+}  // namespace meet
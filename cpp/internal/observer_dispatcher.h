@@ -0,0 +1,192 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_OBSERVER_DISPATCHER_H_
+#define CPP_INTERNAL_OBSERVER_DISPATCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/audio_buffer_pool.h"
+#include "cpp/internal/metrics_registry.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace meet {
+
+// An observer that queues callbacks and invokes the wrapped observer on a pool
+// of dispatch threads.
+//
+// This prevents slow observers from blocking WebRTC's internal threads. Media
+// callbacks are queued in bounded queues, one per media type:
+// - When the audio queue is full, newly received audio frames are dropped.
+// - When the video queue is full, the oldest queued video frame is dropped.
+//
+// `OnJoined`, `OnResourceUpdate` and `OnDisconnected` are never dropped. They
+// are invoked one at a time and in order, and no media callbacks are invoked
+// concurrently with them. `OnDisconnected` is invoked after all queued media
+// has been dispatched, and nothing is dispatched after it.
+//
+// Media callbacks are not ordered with respect to each other. With more than
+// one dispatch thread, consecutive frames of the same stream may be dispatched
+// on different threads, so they can reach the observer out of order.
+//
+// The dispatch threads are joined by `Stop`, which must not be called from a
+// dispatch thread. Owners must therefore stop the dispatcher, or release their
+// last reference to it, outside of observer callbacks.
+class ObserverDispatcher : public MediaApiClientObserverInterface {
+ public:
+  // Creates a dispatcher with `config.worker_thread_count` dispatch threads.
+  //
+  // Observer callback latencies and dropped frames are recorded in `metrics`,
+  // if provided.
+  static absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> Create(
+      rtc::scoped_refptr<MediaApiClientObserverInterface> observer,
+      const ObserverDispatchConfiguration& config,
+      std::shared_ptr<MetricsRegistry> metrics = nullptr);
+
+  // Constructor that allows injecting dispatch threads, useful for testing.
+  //
+  // `dispatch_threads` must be non-empty and already started.
+  ObserverDispatcher(
+      rtc::scoped_refptr<MediaApiClientObserverInterface> observer,
+      const ObserverDispatchConfiguration& config,
+      std::vector<std::unique_ptr<rtc::Thread>> dispatch_threads,
+      std::shared_ptr<MetricsRegistry> metrics = nullptr)
+      : observer_(std::move(observer)),
+        metrics_(metrics != nullptr ? std::move(metrics)
+                                    : std::make_shared<MetricsRegistry>()),
+        callback_latency_us_(metrics_->GetHistogram(
+            "meet_observer_callback_latency_us", kLatencyBucketsUs)),
+        dropped_audio_frames_total_(
+            metrics_->GetCounter("meet_audio_frames_dropped_total")),
+        dropped_video_frames_total_(
+            metrics_->GetCounter("meet_video_frames_dropped_total")),
+        max_queued_audio_frames_(config.max_queued_audio_frames),
+        max_queued_video_frames_(config.max_queued_video_frames),
+        dispatch_threads_(std::move(dispatch_threads)) {}
+
+  // Stops the dispatcher if it has not been stopped yet.
+  ~ObserverDispatcher() override;
+
+  // ObserverDispatcher is neither copyable nor movable.
+  ObserverDispatcher(const ObserverDispatcher&) = delete;
+  ObserverDispatcher& operator=(const ObserverDispatcher&) = delete;
+
+  void OnJoined() override;
+  void OnJoined(const JoinTimings& timings) override;
+  void OnDisconnected(absl::Status status) override;
+  void OnResourceUpdate(ResourceUpdate update) override;
+  // Must always be called from the same thread.
+  void OnAudioFrame(AudioFrame frame) override;
+  void OnEncodedAudioFrame(EncodedAudioFrame frame) override;
+  void OnVideoFrame(VideoFrame frame) override;
+  void OnEncodedVideoFrame(EncodedVideoFrame frame) override;
+
+  // Waits for in-flight callbacks to return and stops the dispatch threads.
+  // Callbacks that are still queued are dropped, and no callbacks are invoked
+  // afterwards.
+  //
+  // Must not be called from a dispatch thread, which cannot join itself.
+  void Stop();
+
+  int64_t dropped_audio_frames() {
+    absl::MutexLock lock(&mutex_);
+    return dropped_audio_frames_;
+  }
+  int64_t dropped_video_frames() {
+    absl::MutexLock lock(&mutex_);
+    return dropped_video_frames_;
+  }
+
+ private:
+  // `meet::VideoFrame` only references the WebRTC frame, so queued video frames
+  // hold their own copy. Copying a `webrtc::VideoFrame` only copies a reference
+  // to the underlying buffer.
+  struct QueuedVideoFrame {
+    webrtc::VideoFrame frame;
+    uint32_t contributing_source;
+    uint32_t synchronization_source;
+    absl::Time receive_time;
+  };
+
+  // Decoded and encoded frames share a queue per media type, since a client
+  // only delivers one kind.
+  using QueuedAudioFrame = std::variant<AudioFrame, EncodedAudioFrame>;
+  using QueuedVideo = std::variant<QueuedVideoFrame, EncodedVideoFrame>;
+
+  // A queued `OnJoined` or `OnResourceUpdate` callback.
+  using ControlEvent = absl::AnyInvocable<void() &&>;
+
+  void EnqueueControlEvent(ControlEvent event);
+  void EnqueueAudioFrame(QueuedAudioFrame frame);
+  // Posts a dispatch task to the next dispatch thread.
+  void PostDispatchTask() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Invokes queued callbacks until no callbacks are eligible for dispatch.
+  void DispatchPending();
+
+  rtc::scoped_refptr<MediaApiClientObserverInterface> observer_;
+  std::shared_ptr<MetricsRegistry> metrics_;
+  Histogram& callback_latency_us_;
+  Counter& dropped_audio_frames_total_;
+  Counter& dropped_video_frames_total_;
+  const size_t max_queued_audio_frames_;
+  const size_t max_queued_video_frames_;
+  // Used to retain audio frames that do not own their samples. Only accessed
+  // from `OnAudioFrame`.
+  AudioBufferPool audio_buffer_pool_;
+
+  absl::Mutex mutex_;
+  std::deque<ControlEvent> control_events_ ABSL_GUARDED_BY(mutex_);
+  std::deque<QueuedAudioFrame> audio_frames_ ABSL_GUARDED_BY(mutex_);
+  std::deque<QueuedVideo> video_frames_ ABSL_GUARDED_BY(mutex_);
+  // SSRCs of encoded video streams that had a frame dropped. Later frames of
+  // these streams cannot be decoded, so they are dropped until the next key
+  // frame.
+  absl::flat_hash_set<uint32_t> ssrcs_awaiting_key_frame_
+      ABSL_GUARDED_BY(mutex_);
+  // Set once `OnDisconnected` is received. The status is dispatched once all
+  // other queued callbacks have been dispatched.
+  std::optional<absl::Status> disconnect_status_ ABSL_GUARDED_BY(mutex_);
+  bool disconnect_dispatched_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  bool control_event_in_flight_ ABSL_GUARDED_BY(mutex_) = false;
+  int media_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t dropped_audio_frames_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t dropped_video_frames_ ABSL_GUARDED_BY(mutex_) = 0;
+  size_t next_dispatch_thread_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  std::vector<std::unique_ptr<rtc::Thread>> dispatch_threads_;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_OBSERVER_DISPATCHER_H_
@@ -0,0 +1,333 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/observer_dispatcher.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/api/session_control_resource.h"
+#include "cpp/internal/testing/mock_media_api_client_observer.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace meet {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::InSequence;
+using ::testing::status::StatusIs;
+
+ObserverDispatchConfiguration CreateConfig(uint32_t worker_thread_count) {
+  return {.worker_thread_count = worker_thread_count,
+          .max_queued_audio_frames = 2,
+          .max_queued_video_frames = 2};
+}
+
+webrtc::VideoFrame CreateVideoFrame() {
+  webrtc::VideoFrame::Builder builder;
+  builder.set_video_frame_buffer(webrtc::I420Buffer::Create(42, 42));
+  return builder.build();
+}
+
+TEST(ObserverDispatcherTest, CreateFailsWithoutWorkerThreads) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+
+  EXPECT_THAT(ObserverDispatcher::Create(observer, CreateConfig(0)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ObserverDispatcherTest, InvokesObserverOnDispatchThread) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  rtc::Thread* callback_thread = nullptr;
+  absl::Notification joined;
+  EXPECT_CALL(*observer, OnJoined).WillOnce([&]() {
+    callback_thread = rtc::Thread::Current();
+    joined.Notify();
+  });
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(1));
+  ASSERT_TRUE(dispatcher.ok());
+
+  (*dispatcher)->OnJoined();
+
+  joined.WaitForNotificationWithTimeout(absl::Seconds(1));
+  EXPECT_NE(callback_thread, nullptr);
+  EXPECT_NE(callback_thread, rtc::Thread::Current());
+}
+
+TEST(ObserverDispatcherTest, ForwardsJoinTimings) {
+  // Also mocks the `OnJoined` overload that receives join timings.
+  class MockJoinTimingsObserver : public MockMediaApiClientObserver {
+   public:
+    MOCK_METHOD(void, OnJoined, (const JoinTimings& timings), (override));
+  };
+  auto observer = rtc::make_ref_counted<MockJoinTimingsObserver>();
+  absl::Notification joined;
+  int64_t joined_us = 0;
+  EXPECT_CALL(*observer, OnJoined(_)).WillOnce([&](const JoinTimings& timings) {
+    joined_us = timings.joined_us;
+    joined.Notify();
+  });
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(1));
+  ASSERT_TRUE(dispatcher.ok());
+
+  (*dispatcher)->OnJoined(JoinTimings{.joined_us = 42});
+
+  ASSERT_TRUE(joined.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_EQ(joined_us, 42);
+}
+
+TEST(ObserverDispatcherTest, InvokesControlCallbacksInOrder) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification disconnected;
+  {
+    InSequence sequence;
+    EXPECT_CALL(*observer, OnJoined);
+    EXPECT_CALL(*observer, OnResourceUpdate).Times(10);
+    EXPECT_CALL(*observer,
+                OnDisconnected(StatusIs(absl::StatusCode::kInternal)))
+        .WillOnce([&]() { disconnected.Notify(); });
+  }
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(4));
+  ASSERT_TRUE(dispatcher.ok());
+
+  (*dispatcher)->OnJoined();
+  for (int i = 0; i < 10; ++i) {
+    (*dispatcher)->OnResourceUpdate(SessionControlChannelToClient());
+  }
+  (*dispatcher)->OnDisconnected(absl::InternalError("disconnected"));
+
+  disconnected.WaitForNotificationWithTimeout(absl::Seconds(1));
+}
+
+TEST(ObserverDispatcherTest, DropsNewestAudioFramesWhenQueueIsFull) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification unblock_joined;
+  absl::Notification disconnected;
+  std::vector<int16_t> received_samples;
+  EXPECT_CALL(*observer, OnJoined).WillOnce([&]() {
+    unblock_joined.WaitForNotification();
+  });
+  EXPECT_CALL(*observer, OnAudioFrame)
+      .Times(2)
+      .WillRepeatedly([&](AudioFrame frame) {
+        received_samples.push_back(frame.pcm16[0]);
+      });
+  EXPECT_CALL(*observer, OnDisconnected).WillOnce([&]() {
+    disconnected.Notify();
+  });
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(1));
+  ASSERT_TRUE(dispatcher.ok());
+
+  (*dispatcher)->OnJoined();
+  for (int16_t sample : std::vector<int16_t>{1, 2, 3}) {
+    std::vector<int16_t> samples = {sample};
+    // Samples are not retained by the frame, so the dispatcher must copy them.
+    (*dispatcher)->OnAudioFrame(AudioFrame{.pcm16 = absl::MakeSpan(samples)});
+  }
+  unblock_joined.Notify();
+  (*dispatcher)->OnDisconnected(absl::OkStatus());
+
+  disconnected.WaitForNotificationWithTimeout(absl::Seconds(1));
+  EXPECT_THAT(received_samples, ElementsAre(1, 2));
+  EXPECT_EQ((*dispatcher)->dropped_audio_frames(), 1);
+}
+
+TEST(ObserverDispatcherTest, DispatchesEncodedAudioFramesWithAudioFrames) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification unblock_joined;
+  absl::Notification disconnected;
+  std::vector<uint8_t> received_payloads;
+  EXPECT_CALL(*observer, OnJoined).WillOnce([&]() {
+    unblock_joined.WaitForNotification();
+  });
+  EXPECT_CALL(*observer, OnEncodedAudioFrame)
+      .Times(2)
+      .WillRepeatedly([&](EncodedAudioFrame frame) {
+        received_payloads.push_back(frame.payload[0]);
+      });
+  EXPECT_CALL(*observer, OnDisconnected).WillOnce([&]() {
+    disconnected.Notify();
+  });
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(1));
+  ASSERT_TRUE(dispatcher.ok());
+
+  (*dispatcher)->OnJoined();
+  // Encoded audio frames share the audio queue, so the last frame is dropped.
+  for (uint8_t payload : std::vector<uint8_t>{1, 2, 3}) {
+    (*dispatcher)->OnEncodedAudioFrame(EncodedAudioFrame{.payload = {payload}});
+  }
+  unblock_joined.Notify();
+  (*dispatcher)->OnDisconnected(absl::OkStatus());
+
+  disconnected.WaitForNotificationWithTimeout(absl::Seconds(1));
+  EXPECT_THAT(received_payloads, ElementsAre(1, 2));
+  EXPECT_EQ((*dispatcher)->dropped_audio_frames(), 1);
+}
+
+TEST(ObserverDispatcherTest, DropsOldestVideoFramesWhenQueueIsFull) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification unblock_joined;
+  absl::Notification disconnected;
+  std::vector<uint32_t> received_ssrcs;
+  EXPECT_CALL(*observer, OnJoined).WillOnce([&]() {
+    unblock_joined.WaitForNotification();
+  });
+  EXPECT_CALL(*observer, OnVideoFrame)
+      .Times(2)
+      .WillRepeatedly([&](VideoFrame frame) {
+        received_ssrcs.push_back(frame.synchronization_source);
+      });
+  EXPECT_CALL(*observer, OnDisconnected).WillOnce([&]() {
+    disconnected.Notify();
+  });
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(1));
+  ASSERT_TRUE(dispatcher.ok());
+
+  (*dispatcher)->OnJoined();
+  for (uint32_t ssrc : std::vector<uint32_t>{1, 2, 3}) {
+    // The dispatcher must not reference the frame after the callback returns.
+    webrtc::VideoFrame frame = CreateVideoFrame();
+    (*dispatcher)->OnVideoFrame(VideoFrame{.frame = frame,
+                                           .contributing_source = 123,
+                                           .synchronization_source = ssrc});
+  }
+  unblock_joined.Notify();
+  (*dispatcher)->OnDisconnected(absl::OkStatus());
+
+  disconnected.WaitForNotificationWithTimeout(absl::Seconds(1));
+  EXPECT_THAT(received_ssrcs, ElementsAre(2, 3));
+  EXPECT_EQ((*dispatcher)->dropped_video_frames(), 1);
+}
+
+TEST(ObserverDispatcherTest,
+     DropsEncodedVideoFramesUntilKeyFrameWhenQueueIsFull) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification unblock_joined;
+  absl::Notification queue_drained;
+  absl::Notification disconnected;
+  std::vector<uint8_t> received_payloads;
+  EXPECT_CALL(*observer, OnJoined).WillOnce([&]() {
+    unblock_joined.WaitForNotification();
+  });
+  EXPECT_CALL(*observer, OnEncodedVideoFrame)
+      .Times(3)
+      .WillRepeatedly([&](EncodedVideoFrame frame) {
+        received_payloads.push_back(frame.data[0]);
+        if (received_payloads.size() == 2) {
+          queue_drained.Notify();
+        }
+      });
+  EXPECT_CALL(*observer, OnDisconnected).WillOnce([&]() {
+    disconnected.Notify();
+  });
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(1));
+  ASSERT_TRUE(dispatcher.ok());
+
+  (*dispatcher)->OnJoined();
+  auto send_frame = [&](uint8_t payload, bool is_key_frame) {
+    (*dispatcher)->OnEncodedVideoFrame(
+        EncodedVideoFrame{.data = {payload},
+                          .is_key_frame = is_key_frame,
+                          .synchronization_source = 111});
+  };
+  send_frame(1, /*is_key_frame=*/true);
+  send_frame(2, /*is_key_frame=*/false);
+  // Dropped because the queue is full.
+  send_frame(3, /*is_key_frame=*/false);
+  unblock_joined.Notify();
+  queue_drained.WaitForNotificationWithTimeout(absl::Seconds(1));
+  // Dropped because it depends on the dropped frame.
+  send_frame(4, /*is_key_frame=*/false);
+  send_frame(5, /*is_key_frame=*/true);
+  (*dispatcher)->OnDisconnected(absl::OkStatus());
+
+  disconnected.WaitForNotificationWithTimeout(absl::Seconds(1));
+  EXPECT_THAT(received_payloads, ElementsAre(1, 2, 5));
+  EXPECT_EQ((*dispatcher)->dropped_video_frames(), 2);
+}
+
+TEST(ObserverDispatcherTest, IgnoresCallbacksAfterDisconnect) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::Notification disconnected;
+  EXPECT_CALL(*observer, OnDisconnected).WillOnce([&]() {
+    disconnected.Notify();
+  });
+  EXPECT_CALL(*observer, OnJoined).Times(0);
+  EXPECT_CALL(*observer, OnAudioFrame).Times(0);
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(2));
+  ASSERT_TRUE(dispatcher.ok());
+
+  (*dispatcher)->OnDisconnected(absl::OkStatus());
+  (*dispatcher)->OnJoined();
+  std::vector<int16_t> samples = {1};
+  (*dispatcher)->OnAudioFrame(AudioFrame{.pcm16 = absl::MakeSpan(samples)});
+  (*dispatcher)->OnDisconnected(absl::InternalError("disconnected again"));
+
+  disconnected.WaitForNotificationWithTimeout(absl::Seconds(1));
+}
+
+TEST(ObserverDispatcherTest, StopWaitsForInFlightCallbacksAndDropsQueued) {
+  auto observer = rtc::make_ref_counted<MockMediaApiClientObserver>();
+  absl::StatusOr<rtc::scoped_refptr<ObserverDispatcher>> dispatcher =
+      ObserverDispatcher::Create(observer, CreateConfig(1));
+  ASSERT_TRUE(dispatcher.ok());
+  absl::Notification joined;
+  bool joined_returned = false;
+  EXPECT_CALL(*observer, OnJoined).WillOnce([&]() {
+    joined.Notify();
+    // Returns once `Stop` starts joining the dispatch thread.
+    while (!rtc::Thread::Current()->IsQuitting()) {
+      absl::SleepFor(absl::Milliseconds(1));
+    }
+    joined_returned = true;
+  });
+  EXPECT_CALL(*observer, OnAudioFrame).Times(0);
+
+  (*dispatcher)->OnJoined();
+  std::vector<int16_t> samples = {1};
+  (*dispatcher)->OnAudioFrame(AudioFrame{.pcm16 = absl::MakeSpan(samples)});
+  joined.WaitForNotification();
+  (*dispatcher)->Stop();
+
+  EXPECT_TRUE(joined_returned);
+}
+
+}  // namespace
+}  // namespace meet
@@ -22,191 +22,139 @@
 #include <utility>
 #include <vector>
 
-#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
-#include "nlohmann/json.hpp"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/participants_resource.h"
+#include "cpp/internal/json_stream_parser.h"
+#include "cpp/internal/trace.h"
+#include "cpp/internal/trace_events.h"
 
 namespace meet {
 namespace {
-using Json = ::nlohmann::json;
 
 // Participants resource channel is always opened with this label.
 constexpr absl::string_view kParticipantsResourceName = "participants";
 
-const Json* FindOrNull(const Json& json, absl::string_view key) {
-  auto it = json.find(key);
-  return it != json.cend() ? &*it : nullptr;
-}
-
-}  // namespace
-
-absl::StatusOr<ResourceUpdate> ParticipantsResourceHandler::ParseUpdate(
-    absl::string_view update) {
-  VLOG(1) << kParticipantsResourceName
-          << " resource update received: " << update;
-
-  const Json json_resource_update = Json::parse(update, /*cb=*/nullptr,
-                                                /*allow_exceptions=*/false);
-
-  if (!json_resource_update.is_object()) {
-    return absl::InternalError(absl::StrCat(
-        "Invalid ", kParticipantsResourceName, " json format: ", update));
+// Fills a `ParticipantsChannelToClient` as the update is parsed.
+class ParticipantsUpdateBuilder : public JsonStreamHandler {
+ public:
+  absl::Status OnObjectStart(absl::string_view path) override {
+    if (absl::Status status = CheckNotArrayField(path); !status.ok()) {
+      return status;
+    }
+    if (path == "resources[]") {
+      update_.resources.emplace_back();
+    } else if (path == "resources[].participant") {
+      resource().participant.emplace();
+    } else if (path == "resources[].participant.signedInUser") {
+      participant().type = Participant::Type::kSignedInUser;
+      participant().signed_in_user.emplace();
+    } else if (path == "resources[].participant.anonymousUser") {
+      participant().type = Participant::Type::kAnonymousUser;
+    } else if (path == "resources[].participant.phoneUser") {
+      participant().type = Participant::Type::kPhoneUser;
+    } else if (path == "deletedResources[]") {
+      update_.deleted_resources.emplace_back();
+    }
+    return absl::OkStatus();
   }
 
-  ParticipantsChannelToClient participants_update;
-  // Resources
-  if (const Json* resources_field =
-          FindOrNull(json_resource_update, "resources");
-      resources_field != nullptr) {
-    if (!resources_field->is_array()) {
-      return absl::InternalError(absl::StrCat(
-          "Invalid ", kParticipantsResourceName,
-          " json format. Expected resources field to be an array: ", update));
+  absl::Status OnScalar(absl::string_view path, JsonScalar value) override {
+    if (absl::Status status = CheckNotArrayField(path); !status.ok()) {
+      return status;
     }
-
-    std::vector<ParticipantResourceSnapshot>& resources =
-        participants_update.resources;
-    for (const Json& resource_field : *resources_field) {
-      // Resources.resourceSnapshot
-      ParticipantResourceSnapshot resource;
-
-      // Resources.resourceSnapshot.id
-      if (const Json* id_field = FindOrNull(resource_field, "id");
-          id_field != nullptr) {
-        resource.id = id_field->get<int64_t>();
-      } else {
-        resource.id = 0;
-      }
-
-      // Resources.resourceSnapshot.participant
-      if (const Json* participant_field =
-              FindOrNull(resource_field, "participant");
-          participant_field != nullptr) {
-        Participant participant;
-
-        // Resources.resourceSnapshot.participant.participantId
-        if (const Json* id_field =
-                FindOrNull(*participant_field, "participantId");
-            id_field != nullptr) {
-          participant.participant_id = id_field->get<int32_t>();
-        }
-
-        // Resources.resourceSnapshot.participant.name
-        if (const Json* id_field = FindOrNull(*participant_field, "name");
-            id_field != nullptr) {
-          participant.name = id_field->get<std::string>();
-        }
-
-        if (const Json* id_field =
-                FindOrNull(*participant_field, "participantKey");
-            id_field != nullptr) {
-          participant.participant_key = id_field->get<std::string>();
-        }
-
-        // Resources.resourceSnapshot.participant.signedInUser
-        if (const Json* signed_in_user_field =
-                FindOrNull(*participant_field, "signedInUser");
-            signed_in_user_field != nullptr) {
-          participant.type = Participant::Type::kSignedInUser;
-
-          SignedInUser signed_in_user;
-
-          // Resources.resourceSnapshot.participant.signedInUser.user
-          if (const Json* user_field =
-                  FindOrNull(*signed_in_user_field, "user");
-              user_field != nullptr) {
-            signed_in_user.user = user_field->get<std::string>();
-          }
-
-          // Resources.resourceSnapshot.participant.signedInUser.displayName
-          if (const Json* display_name_field =
-                  FindOrNull(*signed_in_user_field, "displayName");
-              display_name_field != nullptr) {
-            signed_in_user.display_name =
-                display_name_field->get<std::string>();
-          };
-
-          participant.signed_in_user = std::move(signed_in_user);
-        }
-
-        // Resources.resourceSnapshot.participant.anonymousUser
-        if (const Json* anonymous_user_field =
-                FindOrNull(*participant_field, "anonymousUser");
-            anonymous_user_field != nullptr) {
-          participant.type = Participant::Type::kAnonymousUser;
-
-          // Resources.resourceSnapshot.participant.anonymousUser.displayName
-          if (const Json* display_name_field =
-                  FindOrNull(*anonymous_user_field, "displayName");
-              display_name_field != nullptr) {
-            participant.anonymous_user = AnonymousUser{
-                .display_name = display_name_field->get<std::string>()};
-          }
-        }
-
-        // Resources.resourceSnapshot.participant.phoneUser
-        if (const Json* phone_user_field =
-                FindOrNull(*participant_field, "phoneUser");
-            phone_user_field != nullptr) {
-          participant.type = Participant::Type::kPhoneUser;
-
-          // Resources.resourceSnapshot.participant.phoneUser.displayName
-          if (const Json* display_name_field =
-                  FindOrNull(*phone_user_field, "displayName");
-              display_name_field != nullptr) {
-            participant.phone_user = PhoneUser{
-                .display_name = display_name_field->get<std::string>()};
-          }
-        }
-        resource.participant = std::move(participant);
-      } else {
-        resource.participant = std::nullopt;
-      }
-      resources.push_back(std::move(resource));
+    if (path == "resources[].id") {
+      return AssignJsonScalar(path, std::move(value), resource().id);
+    }
+    if (path == "resources[].participant.participantId") {
+      return AssignJsonScalar(path, std::move(value),
+                              participant().participant_id);
+    }
+    if (path == "resources[].participant.name") {
+      return AssignOptional(path, std::move(value), participant().name);
+    }
+    if (path == "resources[].participant.participantKey") {
+      return AssignOptional(path, std::move(value),
+                            participant().participant_key);
+    }
+    if (path == "resources[].participant.signedInUser.user") {
+      return AssignJsonScalar(path, std::move(value),
+                              participant().signed_in_user->user);
+    }
+    if (path == "resources[].participant.signedInUser.displayName") {
+      return AssignJsonScalar(path, std::move(value),
+                              participant().signed_in_user->display_name);
     }
+    if (path == "resources[].participant.anonymousUser.displayName") {
+      return AssignJsonScalar(
+          path, std::move(value),
+          participant().anonymous_user.emplace().display_name);
+    }
+    if (path == "resources[].participant.phoneUser.displayName") {
+      return AssignJsonScalar(path, std::move(value),
+                              participant().phone_user.emplace().display_name);
+    }
+    if (path == "deletedResources[].id") {
+      return AssignJsonScalar(path, std::move(value),
+                              update_.deleted_resources.back().id);
+    }
+    if (path == "deletedResources[].participant") {
+      return AssignOptional(path, std::move(value),
+                            update_.deleted_resources.back().participant);
+    }
+    return absl::OkStatus();
   }
 
-  // Deleted resources
-  if (const Json* deleted_resources_field =
-          FindOrNull(json_resource_update, "deletedResources");
-      deleted_resources_field != nullptr) {
-    if (!deleted_resources_field->is_array()) {
-      return absl::InternalError(absl::StrCat(
-          "Invalid ", kParticipantsResourceName,
-          " json format. Expected deletedResources field to be an array: ",
-          update));
-    }
+  ParticipantsChannelToClient& update() { return update_; }
 
-    std::vector<ParticipantDeletedResource>& deleted_resources =
-        participants_update.deleted_resources;
-    for (const Json& deleted_resource_field : *deleted_resources_field) {
-      // DeletedResources.deletedResource
-      ParticipantDeletedResource deleted_resource;
-
-      // DeletedResources.deletedResource.id
-      if (const Json* id_field = FindOrNull(deleted_resource_field, "id");
-          id_field != nullptr) {
-        deleted_resource.id = id_field->get<int64_t>();
-      } else {
-        deleted_resource.id = 0;
-      }
-
-      // DeletedResources.deletedResource.participant
-      if (const Json* participant_field =
-              FindOrNull(deleted_resource_field, "participant");
-          participant_field != nullptr) {
-        deleted_resource.participant = participant_field->get<bool>();
-      }
-      deleted_resources.push_back(std::move(deleted_resource));
+ private:
+  // The `resources` and `deletedResources` fields may only be arrays.
+  static absl::Status CheckNotArrayField(absl::string_view path) {
+    if (path == "resources" || path == "deletedResources") {
+      return absl::InternalError(
+          absl::StrCat("Expected ", path, " field to be an array"));
     }
+    return absl::OkStatus();
   }
 
-  return std::move(participants_update);
+  template <typename T>
+  static absl::Status AssignOptional(absl::string_view path, JsonScalar value,
+                                     std::optional<T>& field) {
+    return AssignJsonScalar(path, std::move(value), field.emplace());
+  }
+
+  ParticipantResourceSnapshot& resource() { return update_.resources.back(); }
+  Participant& participant() { return *resource().participant; }
+
+  ParticipantsChannelToClient update_;
+};
+
+}  // namespace
+
+absl::StatusOr<ResourceUpdate> ParticipantsResourceHandler::ParseUpdate(
+    absl::string_view update) {
+  MEET_TRACE_EVENT("ParticipantsResourceHandler::ParseUpdate");
+  MEET_TRACE(kResourceUpdate) << kParticipantsResourceName
+                              << " resource update received: " << update;
+
+  // The update is parsed as a stream rather than into a DOM, as snapshots in
+  // large meetings can be large.
+  ParticipantsUpdateBuilder builder;
+  absl::Status status = ParseJsonObject(update, builder);
+  if (absl::IsInvalidArgument(status)) {
+    return absl::InternalError(absl::StrCat(
+        "Invalid ", kParticipantsResourceName, " json format: ", update));
+  }
+  if (!status.ok()) {
+    return absl::InternalError(absl::StrCat("Invalid ",
+                                            kParticipantsResourceName,
+                                            " json format. ", status.message(),
+                                            ": ", update));
+  }
+  return std::move(builder.update());
 }
 
 }  // namespace meet
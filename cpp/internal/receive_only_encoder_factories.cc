@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/receive_only_encoder_factories.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "webrtc/api/audio_codecs/audio_encoder.h"
+#include "webrtc/api/audio_codecs/audio_format.h"
+#include "webrtc/api/environment/environment.h"
+#include "webrtc/api/video_codecs/sdp_video_format.h"
+#include "webrtc/api/video_codecs/video_encoder.h"
+
+namespace meet {
+
+std::vector<webrtc::AudioCodecSpec>
+ReceiveOnlyAudioEncoderFactory::GetSupportedEncoders() {
+  return {};
+}
+
+std::optional<webrtc::AudioCodecInfo>
+ReceiveOnlyAudioEncoderFactory::QueryAudioEncoder(
+    const webrtc::SdpAudioFormat& /* format */) {
+  return std::nullopt;
+}
+
+std::unique_ptr<webrtc::AudioEncoder> ReceiveOnlyAudioEncoderFactory::Create(
+    const webrtc::Environment& /* env */, const webrtc::SdpAudioFormat& format,
+    Options /* options */) {
+  LOG(ERROR) << "Audio encoder requested for " << format.name
+             << ", but the client is receive-only.";
+  return nullptr;
+}
+
+std::vector<webrtc::SdpVideoFormat>
+ReceiveOnlyVideoEncoderFactory::GetSupportedFormats() const {
+  return {};
+}
+
+std::unique_ptr<webrtc::VideoEncoder> ReceiveOnlyVideoEncoderFactory::Create(
+    const webrtc::Environment& /* env */,
+    const webrtc::SdpVideoFormat& format) {
+  LOG(ERROR) << "Video encoder requested for " << format.name
+             << ", but the client is receive-only.";
+  return nullptr;
+}
+
+}  // namespace meet
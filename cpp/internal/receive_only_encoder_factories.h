@@ -0,0 +1,60 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_RECEIVE_ONLY_ENCODER_FACTORIES_H_
+#define CPP_INTERNAL_RECEIVE_ONLY_ENCODER_FACTORIES_H_
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "webrtc/api/audio_codecs/audio_encoder.h"
+#include "webrtc/api/audio_codecs/audio_encoder_factory.h"
+#include "webrtc/api/audio_codecs/audio_format.h"
+#include "webrtc/api/environment/environment.h"
+#include "webrtc/api/video_codecs/sdp_video_format.h"
+#include "webrtc/api/video_codecs/video_encoder.h"
+#include "webrtc/api/video_codecs/video_encoder_factory.h"
+
+namespace meet {
+
+// Encoder factories that support no codecs.
+//
+// Every transceiver of a client is receive-only, so WebRTC never creates an
+// encoder. Peer connection factories still require encoder factories, and
+// these are used in place of the built-in factories so that clients do not
+// link or instantiate encoders they never use.
+class ReceiveOnlyAudioEncoderFactory : public webrtc::AudioEncoderFactory {
+ public:
+  std::vector<webrtc::AudioCodecSpec> GetSupportedEncoders() override;
+  std::optional<webrtc::AudioCodecInfo> QueryAudioEncoder(
+      const webrtc::SdpAudioFormat& format) override;
+  std::unique_ptr<webrtc::AudioEncoder> Create(
+      const webrtc::Environment& env, const webrtc::SdpAudioFormat& format,
+      Options options) override;
+};
+
+class ReceiveOnlyVideoEncoderFactory : public webrtc::VideoEncoderFactory {
+ public:
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  std::unique_ptr<webrtc::VideoEncoder> Create(
+      const webrtc::Environment& env,
+      const webrtc::SdpVideoFormat& format) override;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_RECEIVE_ONLY_ENCODER_FACTORIES_H_
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/receive_only_encoder_factories.h"
+
+#include "gtest/gtest.h"
+#include "webrtc/api/audio_codecs/audio_format.h"
+#include "webrtc/api/environment/environment_factory.h"
+#include "webrtc/api/video_codecs/sdp_video_format.h"
+
+namespace meet {
+namespace {
+
+TEST(ReceiveOnlyAudioEncoderFactoryTest, SupportsNoEncoders) {
+  ReceiveOnlyAudioEncoderFactory factory;
+  webrtc::SdpAudioFormat opus("opus", 48000, 2);
+
+  EXPECT_TRUE(factory.GetSupportedEncoders().empty());
+  EXPECT_FALSE(factory.QueryAudioEncoder(opus).has_value());
+  EXPECT_EQ(factory.Create(webrtc::CreateEnvironment(), opus, {}), nullptr);
+}
+
+TEST(ReceiveOnlyVideoEncoderFactoryTest, SupportsNoEncoders) {
+  ReceiveOnlyVideoEncoderFactory factory;
+
+  EXPECT_TRUE(factory.GetSupportedFormats().empty());
+  EXPECT_EQ(factory.Create(webrtc::CreateEnvironment(),
+                           webrtc::SdpVideoFormat("VP9")),
+            nullptr);
+}
+
+}  // namespace
+}  // namespace meet
@@ -23,7 +23,6 @@
 #include <variant>
 #include <vector>
 
-#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -31,6 +30,9 @@
 #include "nlohmann/json.hpp"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/session_control_resource.h"
+#include "cpp/internal/json_writer.h"
+#include "cpp/internal/trace.h"
+#include "cpp/internal/trace_events.h"
 
 namespace meet {
 namespace {
@@ -76,8 +78,9 @@ StringToMeetingDisconnectReason(absl::string_view reason) {
 
 absl::StatusOr<ResourceUpdate> SessionControlResourceHandler::ParseUpdate(
     absl::string_view update) {
-  VLOG(1) << kSessionControlResourceName
-          << " resource update received: " << update;
+  MEET_TRACE_EVENT("SessionControlResourceHandler::ParseUpdate");
+  MEET_TRACE(kResourceUpdate) << kSessionControlResourceName
+                              << " resource update received: " << update;
 
   const Json json_resource_update = Json::parse(update, /*cb=*/nullptr,
                                                 /*allow_exceptions=*/false);
@@ -186,23 +189,25 @@ absl::StatusOr<std::string> SessionControlResourceHandler::StringifyRequest(
         "SessionControlChannelFromClient");
   }
 
-  auto session_control_request =
+  const SessionControlChannelFromClient& session_control_request =
       std::get<SessionControlChannelFromClient>(request);
 
-  nlohmann::basic_json<> session_control_channel_from_client;
-
   if (session_control_request.request.request_id == 0) {
     return absl::InvalidArgumentError("Request ID must be set");
   }
 
-  session_control_channel_from_client["request"]["requestId"] =
-      session_control_request.request.request_id;
-
+  // Keys are written in lexicographic order. See `JsonWriter`.
+  std::string json_request;
+  JsonWriter writer(json_request);
+  writer.BeginObject().Key("request").BeginObject();
   if (session_control_request.request.leave_request.has_value()) {
-    session_control_channel_from_client["request"]["leave"] =
-        nlohmann::json::value_t::object;
+    writer.Key("leave").EmptyObject();
   }
-  return session_control_channel_from_client.dump();
+  writer.Key("requestId")
+      .Int(session_control_request.request.request_id)
+      .EndObject()
+      .EndObject();
+  return json_request;
 }
 
 }  // namespace meet
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_SHARED_PEER_CONNECTION_CONTEXT_H_
+#define CPP_INTERNAL_SHARED_PEER_CONNECTION_CONTEXT_H_
+
+#include <memory>
+#include <utility>
+
+#include "webrtc/api/peer_connection_interface.h"
+#include "webrtc/api/ref_count.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace meet {
+
+// The signaling thread, worker thread, and peer connection factory shared by
+// clients of a `MediaApiClientFactory` configured with shared contexts.
+//
+// Each client holds a reference to its context, so the threads outlive every
+// peer connection created from the factory, even if the `MediaApiClientFactory`
+// is destroyed first.
+class SharedPeerConnectionContext : public webrtc::RefCountInterface {
+ public:
+  SharedPeerConnectionContext(
+      std::unique_ptr<rtc::Thread> signaling_thread,
+      std::unique_ptr<rtc::Thread> worker_thread,
+      rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
+          peer_connection_factory)
+      : signaling_thread_(std::move(signaling_thread)),
+        worker_thread_(std::move(worker_thread)),
+        peer_connection_factory_(std::move(peer_connection_factory)) {}
+
+  ~SharedPeerConnectionContext() override {
+    // Release the factory while its threads are still running, since it is
+    // destroyed on them.
+    peer_connection_factory_ = nullptr;
+  }
+
+  rtc::Thread* signaling_thread() const { return signaling_thread_.get(); }
+  rtc::Thread* worker_thread() const { return worker_thread_.get(); }
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
+  peer_connection_factory() const {
+    return peer_connection_factory_;
+  }
+
+ private:
+  std::unique_ptr<rtc::Thread> signaling_thread_;
+  std::unique_ptr<rtc::Thread> worker_thread_;
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
+      peer_connection_factory_;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_SHARED_PEER_CONNECTION_CONTEXT_H_
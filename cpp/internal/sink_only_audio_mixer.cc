@@ -0,0 +1,69 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/sink_only_audio_mixer.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "absl/synchronization/mutex.h"
+#include "webrtc/api/audio/audio_frame.h"
+
+namespace meet {
+namespace {
+
+// Audio is output at 48000Hz, 10ms at a time.
+constexpr int kOutputSampleRateHz = 48000;
+constexpr size_t kOutputSamplesPerChannel = kOutputSampleRateHz / 100;
+
+}  // namespace
+
+bool SinkOnlyAudioMixer::AddSource(Source* audio_source) {
+  absl::MutexLock lock(&mutex_);
+  if (std::find(sources_.begin(), sources_.end(), audio_source) !=
+      sources_.end()) {
+    return false;
+  }
+  sources_.push_back(audio_source);
+  return true;
+}
+
+void SinkOnlyAudioMixer::RemoveSource(Source* audio_source) {
+  absl::MutexLock lock(&mutex_);
+  sources_.erase(std::remove(sources_.begin(), sources_.end(), audio_source),
+                 sources_.end());
+}
+
+void SinkOnlyAudioMixer::Mix(size_t number_of_channels,
+                             webrtc::AudioFrame* audio_frame_for_mixing) {
+  {
+    absl::MutexLock lock(&mutex_);
+    for (Source* source : sources_) {
+      // The result is ignored; sources deliver their audio to their sinks
+      // while providing the frame.
+      source->GetAudioFrameWithInfo(source->PreferredSampleRate(),
+                                    &source_frame_);
+    }
+  }
+
+  // A null buffer marks the frame as muted.
+  audio_frame_for_mixing->UpdateFrame(
+      /*timestamp=*/0, /*data=*/nullptr, kOutputSamplesPerChannel,
+      kOutputSampleRateHz, webrtc::AudioFrame::kNormalSpeech,
+      webrtc::AudioFrame::kVadUnknown, number_of_channels);
+}
+
+}  // namespace meet
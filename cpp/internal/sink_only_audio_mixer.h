@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_SINK_ONLY_AUDIO_MIXER_H_
+#define CPP_INTERNAL_SINK_ONLY_AUDIO_MIXER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "webrtc/api/audio/audio_frame.h"
+#include "webrtc/api/audio/audio_mixer.h"
+
+namespace meet {
+
+// An audio mixer that pulls audio from every source without mixing it.
+//
+// WebRTC decodes received audio, and delivers it to the sinks of the remote
+// audio tracks, when the mixer pulls a frame from each audio source. Since
+// this client only consumes audio through those sinks (see
+// `ConferenceAudioTrack`), the mixed output is never used. This mixer
+// therefore only pulls each source's audio at its preferred sample rate,
+// which avoids resampling, and outputs silence instead of summing, limiting
+// and resampling the sources.
+class SinkOnlyAudioMixer : public webrtc::AudioMixer {
+ public:
+  SinkOnlyAudioMixer() = default;
+
+  // SinkOnlyAudioMixer is neither copyable nor movable.
+  SinkOnlyAudioMixer(const SinkOnlyAudioMixer&) = delete;
+  SinkOnlyAudioMixer& operator=(const SinkOnlyAudioMixer&) = delete;
+
+  bool AddSource(Source* audio_source) override;
+  void RemoveSource(Source* audio_source) override;
+
+  // Pulls 10ms of audio from every source and sets `audio_frame_for_mixing`
+  // to 10ms of muted audio.
+  void Mix(size_t number_of_channels,
+           webrtc::AudioFrame* audio_frame_for_mixing) override;
+
+ private:
+  // Held while pulling audio to ensure that sources are not removed while
+  // being pulled from.
+  absl::Mutex mutex_;
+  std::vector<Source*> sources_ ABSL_GUARDED_BY(mutex_);
+  // Reused for every pulled frame, since the pulled audio is discarded.
+  webrtc::AudioFrame source_frame_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_SINK_ONLY_AUDIO_MIXER_H_
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/sink_only_audio_mixer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "webrtc/api/audio/audio_frame.h"
+#include "webrtc/api/audio/audio_mixer.h"
+#include "webrtc/api/make_ref_counted.h"
+
+namespace meet {
+namespace {
+
+using ::testing::_;
+using ::testing::Return;
+
+class MockAudioSource : public webrtc::AudioMixer::Source {
+ public:
+  MOCK_METHOD(AudioFrameInfo, GetAudioFrameWithInfo,
+              (int sample_rate_hz, webrtc::AudioFrame* audio_frame),
+              (override));
+  MOCK_METHOD(int, Ssrc, (), (const, override));
+  MOCK_METHOD(int, PreferredSampleRate, (), (const, override));
+};
+
+TEST(SinkOnlyAudioMixerTest, MixPullsFromEverySourceAtPreferredSampleRate) {
+  auto mixer = rtc::make_ref_counted<SinkOnlyAudioMixer>();
+  MockAudioSource source1;
+  MockAudioSource source2;
+  EXPECT_CALL(source1, PreferredSampleRate).WillOnce(Return(48000));
+  EXPECT_CALL(source1, GetAudioFrameWithInfo(48000, _))
+      .WillOnce(Return(webrtc::AudioMixer::Source::AudioFrameInfo::kNormal));
+  EXPECT_CALL(source2, PreferredSampleRate).WillOnce(Return(16000));
+  EXPECT_CALL(source2, GetAudioFrameWithInfo(16000, _))
+      .WillOnce(Return(webrtc::AudioMixer::Source::AudioFrameInfo::kMuted));
+  ASSERT_TRUE(mixer->AddSource(&source1));
+  ASSERT_TRUE(mixer->AddSource(&source2));
+
+  webrtc::AudioFrame frame;
+  mixer->Mix(/*number_of_channels=*/1, &frame);
+}
+
+TEST(SinkOnlyAudioMixerTest, MixOutputsMutedFrame) {
+  auto mixer = rtc::make_ref_counted<SinkOnlyAudioMixer>();
+  MockAudioSource source;
+  EXPECT_CALL(source, PreferredSampleRate).WillOnce(Return(48000));
+  EXPECT_CALL(source, GetAudioFrameWithInfo)
+      .WillOnce(Return(webrtc::AudioMixer::Source::AudioFrameInfo::kNormal));
+  ASSERT_TRUE(mixer->AddSource(&source));
+
+  webrtc::AudioFrame frame;
+  mixer->Mix(/*number_of_channels=*/2, &frame);
+
+  EXPECT_TRUE(frame.muted());
+  EXPECT_EQ(frame.sample_rate_hz(), 48000);
+  EXPECT_EQ(frame.samples_per_channel(), 480);
+  EXPECT_EQ(frame.num_channels(), 2);
+}
+
+TEST(SinkOnlyAudioMixerTest, AddingSourceTwiceFails) {
+  auto mixer = rtc::make_ref_counted<SinkOnlyAudioMixer>();
+  MockAudioSource source;
+
+  EXPECT_TRUE(mixer->AddSource(&source));
+  EXPECT_FALSE(mixer->AddSource(&source));
+}
+
+TEST(SinkOnlyAudioMixerTest, MixDoesNotPullFromRemovedSources) {
+  auto mixer = rtc::make_ref_counted<SinkOnlyAudioMixer>();
+  MockAudioSource source;
+  EXPECT_CALL(source, GetAudioFrameWithInfo).Times(0);
+  ASSERT_TRUE(mixer->AddSource(&source));
+  mixer->RemoveSource(&source);
+
+  webrtc::AudioFrame frame;
+  mixer->Mix(/*number_of_channels=*/1, &frame);
+}
+
+}  // namespace
+}  // namespace meet
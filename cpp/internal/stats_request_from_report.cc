@@ -16,14 +16,17 @@
 
 #include "cpp/internal/stats_request_from_report.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
-#include "absl/log/log.h"
+#include "absl/strings/string_view.h"
 #include "cpp/api/media_stats_resource.h"
+#include "cpp/internal/trace.h"
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/stats/attribute.h"
 #include "webrtc/api/stats/rtc_stats.h"
@@ -31,41 +34,120 @@
 
 namespace meet {
 
+StatsAllowlist::StatsAllowlist(
+    absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>
+        allowlist) {
+  sections_.reserve(allowlist.size());
+  for (auto& [type, attribute_names] : allowlist) {
+    sections_.try_emplace(
+        type, SectionAllowlist{.attribute_names = std::move(attribute_names)});
+  }
+}
+
+const std::vector<size_t>* StatsAllowlist::AllowedAttributePositions(
+    const webrtc::RTCStats& section,
+    const std::vector<webrtc::Attribute>& attributes) {
+  auto it = sections_.find(absl::string_view(section.type()));
+  if (it == sections_.end()) {
+    return nullptr;
+  }
+
+  SectionAllowlist& section_allowlist = it->second;
+  if (!section_allowlist.attribute_positions.has_value()) {
+    std::vector<size_t>& positions =
+        section_allowlist.attribute_positions.emplace();
+    for (size_t i = 0; i < attributes.size(); ++i) {
+      if (section_allowlist.attribute_names.contains(attributes[i].name())) {
+        positions.push_back(i);
+      }
+    }
+  }
+  return &*section_allowlist.attribute_positions;
+}
+
 MediaStatsChannelFromClient StatsRequestFromReport(
     const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report,
-    int64_t stats_request_id,
-    const absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>&
-        allowlist) {
-  VLOG(1) << "StatsRequestFromReport: " << report->ToJson();
+    int64_t stats_request_id, StatsAllowlist& allowlist) {
+  MEET_TRACE(kMediaStats) << "StatsRequestFromReport: " << report->ToJson();
 
   MediaStatsChannelFromClient request;
   request.request.request_id = stats_request_id;
-  request.request.upload_media_stats = UploadMediaStatsRequest();
+  std::vector<MediaStatsSection>& sections =
+      request.request.upload_media_stats.emplace().sections;
 
   for (const webrtc::RTCStats& report_section : *report) {
-    auto it = allowlist.find(report_section.type());
-    if (it == allowlist.end()) {
+    std::vector<webrtc::Attribute> attributes = report_section.Attributes();
+    const std::vector<size_t>* allowed_positions =
+        allowlist.AllowedAttributePositions(report_section, attributes);
+    if (allowed_positions == nullptr) {
       continue;
     }
-    absl::flat_hash_set<std::string> allowed_attributes = it->second;
 
     MediaStatsSection request_section;
-    request_section.id = report_section.id();
-    request_section.type = report_section.type();
-    for (const webrtc::Attribute& attribute : report_section.Attributes()) {
-      if (attribute.has_value() &&
-          allowed_attributes.contains(attribute.name())) {
-        request_section.values[attribute.name()] = attribute.ToString();
+    for (size_t position : *allowed_positions) {
+      // Positions are resolved against the first section of this type, so
+      // guard against a section that unexpectedly lists fewer attributes.
+      if (position >= attributes.size()) {
+        break;
+      }
+      const webrtc::Attribute& attribute = attributes[position];
+      if (attribute.has_value()) {
+        request_section.values.try_emplace(attribute.name(),
+                                           attribute.ToString());
       }
     }
 
     if (!request_section.values.empty()) {
-      request.request.upload_media_stats->sections.push_back(
-          std::move(request_section));
+      request_section.id = report_section.id();
+      request_section.type = report_section.type();
+      sections.push_back(std::move(request_section));
     }
   }
 
   return request;
 }
 
+MediaStatsChannelFromClient StatsRequestFromReport(
+    const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report,
+    int64_t stats_request_id,
+    const absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>&
+        allowlist) {
+  StatsAllowlist indexed_allowlist(allowlist);
+  return StatsRequestFromReport(report, stats_request_id, indexed_allowlist);
+}
+
+void StatsDeltaEncoder::RemoveUnchangedValues(
+    UploadMediaStatsRequest& request) {
+  absl::flat_hash_map<std::string,
+                      absl::flat_hash_map<std::string, std::string>>
+      uploaded_values;
+  uploaded_values.reserve(request.sections.size());
+  for (MediaStatsSection& section : request.sections) {
+    absl::flat_hash_map<std::string, std::string>& section_values =
+        uploaded_values[section.id];
+    if (auto it = last_uploaded_values_.find(section.id);
+        it != last_uploaded_values_.end()) {
+      section_values = std::move(it->second);
+    }
+
+    absl::erase_if(section.values, [&](const auto& value) {
+      auto [last_value, inserted] =
+          section_values.try_emplace(value.first, value.second);
+      if (inserted) {
+        return false;
+      }
+      if (last_value->second == value.second) {
+        return true;
+      }
+      last_value->second = value.second;
+      return false;
+    });
+  }
+
+  std::erase_if(request.sections, [](const MediaStatsSection& section) {
+    return section.values.empty();
+  });
+  last_uploaded_values_ = std::move(uploaded_values);
+}
+
 }  // namespace meet
@@ -17,21 +17,79 @@
 #ifndef CPP_INTERNAL_STATS_REQUEST_FROM_REPORT_H_
 #define CPP_INTERNAL_STATS_REQUEST_FROM_REPORT_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "cpp/api/media_stats_resource.h"
 #include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/stats/attribute.h"
+#include "webrtc/api/stats/rtc_stats.h"
 #include "webrtc/api/stats/rtc_stats_report.h"
 
 namespace meet {
 
+// An allowlist of stats report sections and attributes, indexed for converting
+// many stats reports.
+//
+// WebRTC always lists the attributes of a given section type in the same
+// order. The allowed attribute names of each section type are therefore
+// resolved to attribute positions the first time a section of that type is
+// converted, and later sections of that type are filtered without comparing
+// attribute names.
+//
+// This class is not thread-safe; it is expected to be used from the thread
+// that collects stats.
+class StatsAllowlist {
+ public:
+  StatsAllowlist() = default;
+  // The allowlist is a map from section type to a set of allowed attributes.
+  explicit StatsAllowlist(
+      absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>
+          allowlist);
+
+  StatsAllowlist(StatsAllowlist&& other) = default;
+  StatsAllowlist& operator=(StatsAllowlist&& other) = default;
+
+  bool empty() const { return sections_.empty(); }
+
+ private:
+  friend MediaStatsChannelFromClient StatsRequestFromReport(
+      const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report,
+      int64_t request_id, StatsAllowlist& allowlist);
+
+  struct SectionAllowlist {
+    absl::flat_hash_set<std::string> attribute_names;
+    // Positions in `RTCStats::Attributes()` of the allowed attributes, in
+    // ascending order. Resolved from `attribute_names` on first use.
+    std::optional<std::vector<size_t>> attribute_positions;
+  };
+
+  // Returns the positions of the allowed attributes of `section`, or nullptr if
+  // the section's type is not allowlisted.
+  const std::vector<size_t>* AllowedAttributePositions(
+      const webrtc::RTCStats& section,
+      const std::vector<webrtc::Attribute>& attributes);
+
+  absl::flat_hash_map<std::string, SectionAllowlist> sections_;
+};
+
 // Convenience function to convert a stats report to a media stats request.
 //
 // The request id will be used when constructing the request.
 //
+// Sections and attributes that are not in the allowlist are not included in the
+// request.
+MediaStatsChannelFromClient StatsRequestFromReport(
+    const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report,
+    int64_t request_id, StatsAllowlist& allowlist);
+
+// As above, but with an allowlist that is only used for a single conversion.
+//
 // The allowlist is a map from section type to a set of allowed attributes.
 // Sections and attributes that are not in the allowlist are not included in the
 // request.
@@ -41,6 +99,28 @@ MediaStatsChannelFromClient StatsRequestFromReport(
     const absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>&
         allowlist);
 
+// Removes stats from successive media stats uploads whose values have not
+// changed since the previous upload.
+//
+// This class is not thread-safe; it is expected to be used from the thread
+// that collects stats.
+class StatsDeltaEncoder {
+ public:
+  // Removes the values in `request` that are equal to the values last passed to
+  // this encoder for the same section id, and then removes sections with no
+  // remaining values.
+  //
+  // Sections missing from `request` are forgotten, so they are uploaded in full
+  // if they are reported again.
+  void RemoveUnchangedValues(UploadMediaStatsRequest& request);
+
+ private:
+  // Map of section id to the last uploaded values of that section.
+  absl::flat_hash_map<std::string,
+                      absl::flat_hash_map<std::string, std::string>>
+      last_uploaded_values_;
+};
+
 }  // namespace meet
 
 #endif  // CPP_INTERNAL_STATS_REQUEST_FROM_REPORT_H_
@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
@@ -233,5 +234,213 @@ TEST(StatsRequestFromReportTest, IgnoresAllowedAttributesThatHaveNoValue) {
             "1000");
 }
 
+TEST(StatsRequestFromReportTest, ReusesIndexedAllowlistAcrossReports) {
+  StatsAllowlist allowlist(
+      absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>{
+          {"transport", {"bytesSent"}},
+      });
+  auto first_report = webrtc::RTCStatsReport::Create(webrtc::Timestamp::Zero());
+  auto first_section = std::make_unique<webrtc::RTCTransportStats>(
+      "first_transport_id", webrtc::Timestamp::Zero());
+  first_section->bytes_sent = 1000;
+  first_section->bytes_received = 2000;
+  first_report->AddStats(std::move(first_section));
+  auto second_report =
+      webrtc::RTCStatsReport::Create(webrtc::Timestamp::Zero());
+  auto second_section = std::make_unique<webrtc::RTCTransportStats>(
+      "second_transport_id", webrtc::Timestamp::Zero());
+  second_section->bytes_sent = 3000;
+  second_section->bytes_received = 4000;
+  second_report->AddStats(std::move(second_section));
+
+  MediaStatsChannelFromClient first_request =
+      StatsRequestFromReport(first_report, /*stats_request_id=*/1, allowlist);
+  MediaStatsChannelFromClient second_request =
+      StatsRequestFromReport(second_report, /*stats_request_id=*/2, allowlist);
+
+  ASSERT_EQ(first_request.request.upload_media_stats->sections.size(), 1);
+  EXPECT_EQ(first_request.request.upload_media_stats->sections[0].id,
+            "first_transport_id");
+  EXPECT_EQ(first_request.request.upload_media_stats->sections[0].values.size(),
+            1);
+  EXPECT_EQ(
+      first_request.request.upload_media_stats->sections[0].values["bytesSent"],
+      "1000");
+  ASSERT_EQ(second_request.request.upload_media_stats->sections.size(), 1);
+  EXPECT_EQ(second_request.request.upload_media_stats->sections[0].id,
+            "second_transport_id");
+  EXPECT_EQ(
+      second_request.request.upload_media_stats->sections[0].values.size(), 1);
+  EXPECT_EQ(second_request.request.upload_media_stats->sections[0]
+                .values["bytesSent"],
+            "3000");
+}
+
+TEST(StatsRequestFromReportTest, IndexedAllowlistFiltersEverySectionOfAType) {
+  StatsAllowlist allowlist(
+      absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>{
+          {"transport", {"bytesReceived"}},
+      });
+  auto report = webrtc::RTCStatsReport::Create(webrtc::Timestamp::Zero());
+  auto first_section = std::make_unique<webrtc::RTCTransportStats>(
+      "first_transport_id", webrtc::Timestamp::Zero());
+  first_section->bytes_sent = 1000;
+  first_section->bytes_received = 2000;
+  // The second section is missing the allowed attribute, and so is omitted.
+  auto second_section = std::make_unique<webrtc::RTCTransportStats>(
+      "second_transport_id", webrtc::Timestamp::Zero());
+  second_section->bytes_sent = 3000;
+  auto third_section = std::make_unique<webrtc::RTCTransportStats>(
+      "third_transport_id", webrtc::Timestamp::Zero());
+  third_section->bytes_received = 6000;
+  report->AddStats(std::move(first_section));
+  report->AddStats(std::move(second_section));
+  report->AddStats(std::move(third_section));
+
+  MediaStatsChannelFromClient request =
+      StatsRequestFromReport(report, /*stats_request_id=*/7, allowlist);
+
+  ASSERT_EQ(request.request.upload_media_stats->sections.size(), 2);
+  EXPECT_EQ(request.request.upload_media_stats->sections[0].id,
+            "first_transport_id");
+  EXPECT_EQ(request.request.upload_media_stats->sections[0].values.size(), 1);
+  EXPECT_EQ(
+      request.request.upload_media_stats->sections[0].values["bytesReceived"],
+      "2000");
+  EXPECT_EQ(request.request.upload_media_stats->sections[1].id,
+            "third_transport_id");
+  EXPECT_EQ(request.request.upload_media_stats->sections[1].values.size(), 1);
+  EXPECT_EQ(
+      request.request.upload_media_stats->sections[1].values["bytesReceived"],
+      "6000");
+}
+
+TEST(StatsRequestFromReportTest, EmptyIndexedAllowlistPopulatesNoSections) {
+  StatsAllowlist allowlist;
+  auto report = webrtc::RTCStatsReport::Create(webrtc::Timestamp::Zero());
+  auto rtc_transport_section = std::make_unique<webrtc::RTCTransportStats>(
+      "rtc_transport_id", webrtc::Timestamp::Zero());
+  rtc_transport_section->bytes_sent = 1000;
+  report->AddStats(std::move(rtc_transport_section));
+
+  MediaStatsChannelFromClient request =
+      StatsRequestFromReport(report, /*stats_request_id=*/7, allowlist);
+
+  EXPECT_TRUE(allowlist.empty());
+  ASSERT_TRUE(request.request.upload_media_stats.has_value());
+  EXPECT_TRUE(request.request.upload_media_stats->sections.empty());
+}
+
+UploadMediaStatsRequest CreateUploadRequest(
+    std::vector<MediaStatsSection> sections) {
+  return UploadMediaStatsRequest{.sections = std::move(sections)};
+}
+
+TEST(StatsDeltaEncoderTest, KeepsAllValuesOfFirstUpload) {
+  StatsDeltaEncoder encoder;
+  UploadMediaStatsRequest request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1000"}, {"bytesReceived", "2000"}}}});
+
+  encoder.RemoveUnchangedValues(request);
+
+  ASSERT_EQ(request.sections.size(), 1);
+  EXPECT_EQ(request.sections[0].id, "transport_id");
+  EXPECT_EQ(request.sections[0].type, "transport");
+  EXPECT_EQ(request.sections[0].values.size(), 2);
+  EXPECT_EQ(request.sections[0].values["bytesSent"], "1000");
+  EXPECT_EQ(request.sections[0].values["bytesReceived"], "2000");
+}
+
+TEST(StatsDeltaEncoderTest, RemovesUnchangedValues) {
+  StatsDeltaEncoder encoder;
+  UploadMediaStatsRequest first_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1000"}, {"bytesReceived", "2000"}}}});
+  encoder.RemoveUnchangedValues(first_request);
+  UploadMediaStatsRequest second_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1500"}, {"bytesReceived", "2000"}}}});
+
+  encoder.RemoveUnchangedValues(second_request);
+
+  ASSERT_EQ(second_request.sections.size(), 1);
+  EXPECT_EQ(second_request.sections[0].id, "transport_id");
+  EXPECT_EQ(second_request.sections[0].values.size(), 1);
+  EXPECT_EQ(second_request.sections[0].values["bytesSent"], "1500");
+}
+
+TEST(StatsDeltaEncoderTest, ComparesAgainstLastUploadedValues) {
+  StatsDeltaEncoder encoder;
+  UploadMediaStatsRequest first_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1000"}}}});
+  encoder.RemoveUnchangedValues(first_request);
+  UploadMediaStatsRequest second_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1500"}}}});
+  encoder.RemoveUnchangedValues(second_request);
+  UploadMediaStatsRequest third_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1000"}}}});
+
+  encoder.RemoveUnchangedValues(third_request);
+
+  ASSERT_EQ(third_request.sections.size(), 1);
+  EXPECT_EQ(third_request.sections[0].values["bytesSent"], "1000");
+}
+
+TEST(StatsDeltaEncoderTest, RemovesSectionsWithNoChangedValues) {
+  StatsDeltaEncoder encoder;
+  UploadMediaStatsRequest first_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1000"}}},
+       {.type = "candidate-pair",
+        .id = "candidate_pair_id",
+        .values = {{"lastPacketSentTimestamp", "100"}}}});
+  encoder.RemoveUnchangedValues(first_request);
+  UploadMediaStatsRequest second_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1000"}}},
+       {.type = "candidate-pair",
+        .id = "candidate_pair_id",
+        .values = {{"lastPacketSentTimestamp", "200"}}}});
+
+  encoder.RemoveUnchangedValues(second_request);
+
+  ASSERT_EQ(second_request.sections.size(), 1);
+  EXPECT_EQ(second_request.sections[0].id, "candidate_pair_id");
+  EXPECT_EQ(second_request.sections[0].values["lastPacketSentTimestamp"],
+            "200");
+}
+
+TEST(StatsDeltaEncoderTest, UploadsReappearingSectionsInFull) {
+  StatsDeltaEncoder encoder;
+  UploadMediaStatsRequest first_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1000"}}}});
+  encoder.RemoveUnchangedValues(first_request);
+  UploadMediaStatsRequest second_request = CreateUploadRequest({});
+  encoder.RemoveUnchangedValues(second_request);
+  UploadMediaStatsRequest third_request = CreateUploadRequest(
+      {{.type = "transport",
+        .id = "transport_id",
+        .values = {{"bytesSent", "1000"}}}});
+
+  encoder.RemoveUnchangedValues(third_request);
+
+  ASSERT_EQ(third_request.sections.size(), 1);
+  EXPECT_EQ(third_request.sections[0].values["bytesSent"], "1000");
+}
+
 }  // namespace
 }  // namespace meet
@@ -51,6 +51,36 @@ class MockCurlApiWrapper : public CurlApiWrapper {
     ON_CALL(*this, EasySetOptInt).WillByDefault(Return(CURLcode::CURLE_OK));
 
     ON_CALL(*this, EasyPerform).WillByDefault(Return(CURLcode::CURLE_OK));
+
+    ON_CALL(*this, MultiInit())
+        .WillByDefault(Return(reinterpret_cast<CURLM*>(0xcafef00d)));
+
+    ON_CALL(*this, MultiCleanup).WillByDefault(Return(CURLMcode::CURLM_OK));
+
+    ON_CALL(*this, MultiAddHandle).WillByDefault(Return(CURLMcode::CURLM_OK));
+
+    ON_CALL(*this, MultiRemoveHandle)
+        .WillByDefault(Return(CURLMcode::CURLM_OK));
+
+    ON_CALL(*this, MultiPerform).WillByDefault(Return(CURLMcode::CURLM_OK));
+
+    ON_CALL(*this, MultiPoll).WillByDefault(Return(CURLMcode::CURLM_OK));
+
+    ON_CALL(*this, MultiWakeup).WillByDefault(Return(CURLMcode::CURLM_OK));
+
+    ON_CALL(*this, ShareInit())
+        .WillByDefault(Return(reinterpret_cast<CURLSH*>(0xfeedface)));
+
+    ON_CALL(*this, ShareCleanup).WillByDefault(Return(CURLSHcode::CURLSHE_OK));
+
+    ON_CALL(*this, ShareSetOptInt)
+        .WillByDefault(Return(CURLSHcode::CURLSHE_OK));
+
+    ON_CALL(*this, ShareSetOptPtr)
+        .WillByDefault(Return(CURLSHcode::CURLSHE_OK));
+
+    ON_CALL(*this, ShareSetOptCallback)
+        .WillByDefault(Return(CURLSHcode::CURLSHE_OK));
   }
 
   MOCK_METHOD(CURL*, EasyInit, (), (override));
@@ -65,6 +95,22 @@ class MockCurlApiWrapper : public CurlApiWrapper {
   MOCK_METHOD(struct curl_slist*, SListAppend,
               (struct curl_slist*, const char*), (override));
   MOCK_METHOD(void, SListFreeAll, (struct curl_slist*), (override));
+  MOCK_METHOD(CURLM*, MultiInit, (), (override));
+  MOCK_METHOD(CURLMcode, MultiCleanup, (CURLM*), (override));
+  MOCK_METHOD(CURLMcode, MultiAddHandle, (CURLM*, CURL*), (override));
+  MOCK_METHOD(CURLMcode, MultiRemoveHandle, (CURLM*, CURL*), (override));
+  MOCK_METHOD(CURLMcode, MultiPerform, (CURLM*, int*), (override));
+  MOCK_METHOD(CURLMcode, MultiPoll, (CURLM*, int), (override));
+  MOCK_METHOD(CURLMcode, MultiWakeup, (CURLM*), (override));
+  MOCK_METHOD(CURLMsg*, MultiInfoRead, (CURLM*, int*), (override));
+  MOCK_METHOD(CURLSH*, ShareInit, (), (override));
+  MOCK_METHOD(CURLSHcode, ShareCleanup, (CURLSH*), (override));
+  MOCK_METHOD(CURLSHcode, ShareSetOptInt, (CURLSH*, CURLSHoption, int),
+              (override));
+  MOCK_METHOD(CURLSHcode, ShareSetOptPtr, (CURLSH*, CURLSHoption, void*),
+              (override));
+  MOCK_METHOD(CURLSHcode, ShareSetOptCallback,
+              (CURLSH*, CURLSHoption, intptr_t), (override));
 };
 
 }  // namespace meet
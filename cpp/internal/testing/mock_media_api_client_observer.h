@@ -29,7 +29,9 @@ class MockMediaApiClientObserver : public MediaApiClientObserverInterface {
   MOCK_METHOD(void, OnDisconnected, (absl::Status), (override));
   MOCK_METHOD(void, OnResourceUpdate, (ResourceUpdate), (override));
   MOCK_METHOD(void, OnAudioFrame, (AudioFrame), (override));
+  MOCK_METHOD(void, OnEncodedAudioFrame, (EncodedAudioFrame), (override));
   MOCK_METHOD(void, OnVideoFrame, (VideoFrame), (override));
+  MOCK_METHOD(void, OnEncodedVideoFrame, (EncodedVideoFrame), (override));
 };
 
 }  // namespace meet
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/thread_scheduling.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "cpp/api/media_api_client_interface.h"
+
+namespace meet {
+
+absl::Status ValidateThreadConfiguration(const ThreadConfiguration& config) {
+  for (int cpu : config.cpu_affinity) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("CPU affinity must only contain CPUs from 0 to ",
+                       CPU_SETSIZE - 1, "; got ", cpu));
+    }
+  }
+  if (config.nice_value.has_value() &&
+      (*config.nice_value < -20 || *config.nice_value > 19)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Nice value must be from -20 to 19; got ", *config.nice_value));
+  }
+  if (config.realtime_priority.has_value() &&
+      (*config.realtime_priority < 1 || *config.realtime_priority > 99)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Real-time priority must be from 1 to 99; got ",
+                     *config.realtime_priority));
+  }
+  if (config.nice_value.has_value() && config.realtime_priority.has_value()) {
+    return absl::InvalidArgumentError(
+        "Threads cannot have both a nice value and a real-time priority");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ApplyThreadConfiguration(const ThreadConfiguration& config) {
+  if (!config.cpu_affinity.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : config.cpu_affinity) {
+      CPU_SET(cpu, &cpu_set);
+    }
+    // pthread functions return the error instead of setting `errno`.
+    if (int error =
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        error != 0) {
+      return absl::ErrnoToStatus(error, "Failed to set thread CPU affinity");
+    }
+  }
+  if (config.realtime_priority.has_value()) {
+    sched_param param = {.sched_priority = *config.realtime_priority};
+    if (int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        error != 0) {
+      return absl::ErrnoToStatus(error,
+                                 "Failed to set thread real-time priority");
+    }
+  }
+  if (config.nice_value.has_value()) {
+    // On Linux, nice values apply to individual threads, identified by their
+    // thread IDs.
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)),
+                    *config.nice_value) != 0) {
+      return absl::ErrnoToStatus(errno, "Failed to set thread nice value");
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace meet
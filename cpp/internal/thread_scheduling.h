@@ -0,0 +1,36 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_THREAD_SCHEDULING_H_
+#define CPP_INTERNAL_THREAD_SCHEDULING_H_
+
+#include "absl/status/status.h"
+#include "cpp/api/media_api_client_interface.h"
+
+namespace meet {
+
+// Returns an error if `config` has CPUs, a nice value or a real-time priority
+// that are out of range, or has both a nice value and a real-time priority.
+absl::Status ValidateThreadConfiguration(const ThreadConfiguration& config);
+
+// Applies `config` to the calling thread. Returns an error if the thread's
+// affinity or priority cannot be changed, e.g. because the process lacks the
+// required capabilities.
+absl::Status ApplyThreadConfiguration(const ThreadConfiguration& config);
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_THREAD_SCHEDULING_H_
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/thread_scheduling.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "cpp/api/media_api_client_interface.h"
+
+namespace meet {
+namespace {
+
+using ::testing::status::StatusIs;
+
+TEST(ThreadSchedulingTest, ValidatesDefaultConfiguration) {
+  EXPECT_TRUE(ValidateThreadConfiguration({}).ok());
+}
+
+TEST(ThreadSchedulingTest, RejectsOutOfRangeCpus) {
+  EXPECT_THAT(ValidateThreadConfiguration({.cpu_affinity = {0, -1}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ValidateThreadConfiguration({.cpu_affinity = {CPU_SETSIZE}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ThreadSchedulingTest, RejectsOutOfRangeNiceValue) {
+  EXPECT_THAT(ValidateThreadConfiguration({.nice_value = 20}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ThreadSchedulingTest, RejectsOutOfRangeRealtimePriority) {
+  EXPECT_THAT(ValidateThreadConfiguration({.realtime_priority = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ThreadSchedulingTest, RejectsNiceValueWithRealtimePriority) {
+  EXPECT_THAT(
+      ValidateThreadConfiguration({.nice_value = 0, .realtime_priority = 1}),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               "Threads cannot have both a nice value and a real-time "
+               "priority"));
+}
+
+TEST(ThreadSchedulingTest, AppliesCpuAffinityAndNiceValue) {
+  // Lowering a thread's priority never requires privileges.
+  absl::Status status;
+  cpu_set_t cpu_set;
+  std::thread thread([&] {
+    status = ApplyThreadConfiguration({.cpu_affinity = {0}, .nice_value = 5});
+    pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  });
+  thread.join();
+
+  ASSERT_TRUE(status.ok()) << status;
+  EXPECT_EQ(CPU_COUNT(&cpu_set), 1);
+  EXPECT_TRUE(CPU_ISSET(0, &cpu_set));
+}
+
+}  // namespace
+}  // namespace meet
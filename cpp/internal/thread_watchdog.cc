@@ -0,0 +1,184 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/thread_watchdog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "cpp/internal/metrics_registry.h"
+#include "webrtc/api/units/time_delta.h"
+#include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/time_utils.h"
+
+namespace meet {
+namespace {
+
+// The name of the `ScopedTask` running on the current thread.
+thread_local std::atomic<const char*> current_task_name = nullptr;
+
+}  // namespace
+
+ThreadWatchdog::ScopedTask::ScopedTask(const char* name)
+    : previous_name_(
+          current_task_name.exchange(name, std::memory_order_relaxed)) {}
+
+ThreadWatchdog::ScopedTask::~ScopedTask() {
+  current_task_name.store(previous_name_, std::memory_order_relaxed);
+}
+
+absl::StatusOr<std::unique_ptr<ThreadWatchdog>> ThreadWatchdog::Create(
+    ThreadWatchdogOptions options, std::shared_ptr<MetricsRegistry> metrics) {
+  if (options.heartbeat_interval <= absl::ZeroDuration() ||
+      options.stall_threshold <= absl::ZeroDuration()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Thread watchdog heartbeat interval and stall threshold "
+                     "must be positive; got ",
+                     absl::FormatDuration(options.heartbeat_interval), " and ",
+                     absl::FormatDuration(options.stall_threshold)));
+  }
+
+  std::unique_ptr<rtc::Thread> watchdog_thread = rtc::Thread::Create();
+  watchdog_thread->SetName("thread_watchdog_thread", nullptr);
+  if (!watchdog_thread->Start()) {
+    return absl::InternalError("Failed to start thread watchdog thread");
+  }
+
+  Counter* stalls =
+      metrics != nullptr ? &metrics->GetCounter("meet_thread_stalls") : nullptr;
+  StallCallback log_stall = [stalls](const Stall& stall) {
+    LOG(WARNING) << "Thread " << stall.thread_name << " has not run a task for "
+                 << absl::FormatDuration(stall.duration) << ", with "
+                 << stall.queue_depth << " tasks queued, while running "
+                 << (stall.blocking_task.empty() ? "an unannotated task"
+                                                 : stall.blocking_task);
+    if (stalls != nullptr) {
+      stalls->Increment();
+    }
+  };
+  return std::make_unique<ThreadWatchdog>(options, std::move(metrics),
+                                          std::move(log_stall),
+                                          std::move(watchdog_thread));
+}
+
+ThreadWatchdog::ThreadWatchdog(ThreadWatchdogOptions options,
+                               std::shared_ptr<MetricsRegistry> metrics,
+                               StallCallback stall_callback,
+                               std::unique_ptr<rtc::Thread> watchdog_thread)
+    : options_(options),
+      metrics_(std::move(metrics)),
+      stall_callback_(std::move(stall_callback)),
+      watchdog_thread_(std::move(watchdog_thread)) {
+  watchdog_thread_->PostTask([this]() { CheckThreads(); });
+}
+
+ThreadWatchdog::~ThreadWatchdog() { watchdog_thread_->Stop(); }
+
+void ThreadWatchdog::Watch(rtc::Thread* thread, absl::string_view name) {
+  auto watched_thread = std::make_shared<WatchedThread>();
+  watched_thread->thread = thread;
+  watched_thread->name = std::string(name);
+  if (metrics_ != nullptr) {
+    watched_thread->metrics = metrics_;
+    watched_thread->latency_us = &metrics_->GetHistogram(
+        absl::StrCat("meet_", name, "_task_queue_latency_us"),
+        kLatencyBucketsUs);
+  }
+
+  absl::MutexLock lock(&mutex_);
+  watched_threads_.push_back(std::move(watched_thread));
+}
+
+void ThreadWatchdog::Unwatch(rtc::Thread* thread) {
+  // Heartbeats are only posted while holding the lock, so none are posted
+  // once this returns.
+  absl::MutexLock lock(&mutex_);
+  std::erase_if(watched_threads_,
+                [thread](const std::shared_ptr<WatchedThread>& watched_thread) {
+                  return watched_thread->thread == thread;
+                });
+}
+
+void ThreadWatchdog::CheckThreads() {
+  int64_t now_us = rtc::TimeMicros();
+  std::vector<Stall> stalls;
+  {
+    absl::MutexLock lock(&mutex_);
+    for (std::shared_ptr<WatchedThread>& watched_thread : watched_threads_) {
+      if (!watched_thread->heartbeat_pending.load()) {
+        watched_thread->heartbeat_pending = true;
+        watched_thread->heartbeat_posted_at_us = now_us;
+        watched_thread->stall_reported = false;
+        watched_thread->thread->PostTask(
+            [watched_thread, posted_at_us = now_us]() {
+              // Point the watchdog at this thread's annotations, now that the
+              // heartbeat runs on it.
+              watched_thread->current_task = &current_task_name;
+              if (watched_thread->latency_us != nullptr) {
+                watched_thread->latency_us->Record(
+                    static_cast<double>(rtc::TimeMicros() - posted_at_us));
+              }
+              watched_thread->heartbeat_pending = false;
+            });
+        continue;
+      }
+
+      absl::Duration waited =
+          absl::Microseconds(now_us - watched_thread->heartbeat_posted_at_us);
+      if (watched_thread->stall_reported ||
+          waited < options_.stall_threshold) {
+        continue;
+      }
+      watched_thread->stall_reported = true;
+      Stall stall = {.thread_name = watched_thread->name,
+                     .duration = waited,
+                     .queue_depth = watched_thread->thread->size()};
+      // The annotations are only known once a heartbeat has run on the
+      // thread.
+      if (const std::atomic<const char*>* current_task =
+              watched_thread->current_task.load();
+          current_task != nullptr) {
+        if (const char* name = current_task->load(std::memory_order_relaxed);
+            name != nullptr) {
+          stall.blocking_task = name;
+        }
+      }
+      stalls.push_back(std::move(stall));
+    }
+  }
+  for (const Stall& stall : stalls) {
+    stall_callback_(stall);
+  }
+
+  watchdog_thread_->PostDelayedTask(
+      [this]() { CheckThreads(); },
+      webrtc::TimeDelta::Micros(
+          absl::ToInt64Microseconds(options_.heartbeat_interval)));
+}
+
+}  // namespace meet
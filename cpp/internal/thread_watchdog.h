@@ -0,0 +1,151 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_THREAD_WATCHDOG_H_
+#define CPP_INTERNAL_THREAD_WATCHDOG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "cpp/internal/metrics_registry.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace meet {
+
+struct ThreadWatchdogOptions {
+  // How often a heartbeat task is posted to every watched thread.
+  absl::Duration heartbeat_interval = absl::Milliseconds(100);
+  // Threads whose heartbeat has waited this long to run are reported as
+  // stalled.
+  absl::Duration stall_threshold = absl::Milliseconds(250);
+};
+
+// Detects threads that are blocked, e.g. by an observer callback or a disk
+// write, which otherwise only shows up as missing media.
+//
+// The watchdog posts a heartbeat task to every watched thread and measures how
+// long it waits in the thread's task queue. The wait is recorded in a
+// `meet_<name>_task_queue_latency_us` histogram, which is shared by threads
+// watched with the same name. A heartbeat that waits longer than the stall
+// threshold is reported once, with the number of tasks queued on the thread
+// and the `ScopedTask` running on it, if any.
+//
+// This class is thread-safe.
+class ThreadWatchdog {
+ public:
+  struct Stall {
+    std::string thread_name;
+    // How long the heartbeat has waited so far.
+    absl::Duration duration;
+    // The number of tasks queued on the thread, including the heartbeat.
+    size_t queue_depth = 0;
+    // The name of the `ScopedTask` running on the thread, or empty if the
+    // running task is not annotated.
+    std::string blocking_task;
+  };
+  using StallCallback = absl::AnyInvocable<void(const Stall& stall)>;
+
+  // Names the task running on the calling thread while in scope, so that
+  // stalls of watched threads report it. Scopes may be nested. `name` must
+  // outlive the scope, e.g. be a string literal.
+  //
+  // This costs two relaxed atomic operations, so it can annotate hot paths.
+  class ScopedTask {
+   public:
+    explicit ScopedTask(const char* name);
+    ~ScopedTask();
+
+    // ScopedTask is neither copyable nor movable.
+    ScopedTask(const ScopedTask&) = delete;
+    ScopedTask& operator=(const ScopedTask&) = delete;
+
+   private:
+    const char* previous_name_;
+  };
+
+  // Starts a watchdog on its own thread. Stalls are logged, and recorded in
+  // the `meet_thread_stalls` counter of `metrics` if it is not null.
+  static absl::StatusOr<std::unique_ptr<ThreadWatchdog>> Create(
+      ThreadWatchdogOptions options,
+      std::shared_ptr<MetricsRegistry> metrics = nullptr);
+
+  // Constructor that allows injecting the watchdog thread and stall callback,
+  // useful for testing. `watchdog_thread` must already be started.
+  ThreadWatchdog(ThreadWatchdogOptions options,
+                 std::shared_ptr<MetricsRegistry> metrics,
+                 StallCallback stall_callback,
+                 std::unique_ptr<rtc::Thread> watchdog_thread);
+
+  ~ThreadWatchdog();
+
+  // ThreadWatchdog is neither copyable nor movable.
+  ThreadWatchdog(const ThreadWatchdog&) = delete;
+  ThreadWatchdog& operator=(const ThreadWatchdog&) = delete;
+
+  // Starts watching `thread`. `thread` must be unwatched before it is
+  // stopped, since heartbeats are posted to it until then.
+  void Watch(rtc::Thread* thread, absl::string_view name);
+  void Unwatch(rtc::Thread* thread);
+
+ private:
+  // State of a watched thread, shared with its in-flight heartbeat.
+  struct WatchedThread {
+    rtc::Thread* thread;
+    std::string name;
+    // Null if the watchdog has no metrics registry. The registry is retained,
+    // since heartbeats may run after the watchdog is destroyed.
+    std::shared_ptr<MetricsRegistry> metrics;
+    Histogram* latency_us = nullptr;
+    // When the in-flight heartbeat was posted, as returned by
+    // `rtc::TimeMicros()`. Only accessed on the watchdog thread.
+    int64_t heartbeat_posted_at_us = 0;
+    bool stall_reported = false;
+    std::atomic<bool> heartbeat_pending = false;
+    // The annotated task of the thread, which the heartbeat points at the
+    // thread's own `ScopedTask` state once it runs.
+    std::atomic<const std::atomic<const char*>*> current_task = nullptr;
+  };
+
+  // Posts heartbeats, reports stalled threads, and schedules the next check.
+  //
+  // Called on the watchdog thread.
+  void CheckThreads();
+
+  const ThreadWatchdogOptions options_;
+  std::shared_ptr<MetricsRegistry> metrics_;
+  StallCallback stall_callback_;
+
+  absl::Mutex mutex_;
+  std::vector<std::shared_ptr<WatchedThread>> watched_threads_
+      ABSL_GUARDED_BY(mutex_);
+
+  std::unique_ptr<rtc::Thread> watchdog_thread_;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_THREAD_WATCHDOG_H_
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/thread_watchdog.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_metrics.h"
+#include "cpp/internal/metrics_registry.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace meet {
+namespace {
+
+using ::testing::Contains;
+using ::testing::Ge;
+using ::testing::IsEmpty;
+using ::testing::Key;
+using ::testing::status::StatusIs;
+
+constexpr ThreadWatchdogOptions kTestOptions = {
+    .heartbeat_interval = absl::Milliseconds(5),
+    .stall_threshold = absl::Milliseconds(50),
+};
+
+std::unique_ptr<rtc::Thread> CreateThread(absl::string_view name) {
+  auto thread = rtc::Thread::Create();
+  thread->SetName(name, nullptr);
+  thread->Start();
+  return thread;
+}
+
+// Waits until a heartbeat has run on `thread_name`'s thread.
+void WaitForHeartbeat(const MetricsRegistry& metrics,
+                      absl::string_view thread_name) {
+  std::string histogram_name =
+      absl::StrCat("meet_", thread_name, "_task_queue_latency_us");
+  absl::Time deadline = absl::Now() + absl::Seconds(5);
+  while (absl::Now() < deadline) {
+    MediaApiClientMetrics snapshot = metrics.Snapshot();
+    if (auto it = snapshot.histograms.find(histogram_name);
+        it != snapshot.histograms.end() && it->second.count > 0) {
+      return;
+    }
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  ADD_FAILURE() << "No heartbeat ran on " << thread_name;
+}
+
+TEST(ThreadWatchdogTest, CreateFailsWithNonPositiveHeartbeatInterval) {
+  EXPECT_THAT(
+      ThreadWatchdog::Create({.heartbeat_interval = absl::ZeroDuration()}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ThreadWatchdogTest, RecordsTaskQueueLatencyWithoutReportingStalls) {
+  auto metrics = std::make_shared<MetricsRegistry>();
+  absl::Mutex mutex;
+  std::vector<ThreadWatchdog::Stall> stalls;
+  ThreadWatchdog watchdog(
+      kTestOptions, metrics,
+      [&](const ThreadWatchdog::Stall& stall) {
+        absl::MutexLock lock(&mutex);
+        stalls.push_back(stall);
+      },
+      CreateThread("watchdog_thread"));
+  std::unique_ptr<rtc::Thread> thread = CreateThread("worker_thread");
+
+  watchdog.Watch(thread.get(), "worker_thread");
+  WaitForHeartbeat(*metrics, "worker_thread");
+  watchdog.Unwatch(thread.get());
+
+  EXPECT_THAT(metrics->Snapshot().histograms,
+              Contains(Key("meet_worker_thread_task_queue_latency_us")));
+  absl::MutexLock lock(&mutex);
+  EXPECT_THAT(stalls, IsEmpty());
+}
+
+TEST(ThreadWatchdogTest, ReportsStalledThreadWithBlockingTask) {
+  auto metrics = std::make_shared<MetricsRegistry>();
+  absl::Notification stall_reported;
+  ThreadWatchdog::Stall reported_stall;
+  ThreadWatchdog watchdog(
+      kTestOptions, metrics,
+      [&](const ThreadWatchdog::Stall& stall) {
+        if (!stall_reported.HasBeenNotified()) {
+          reported_stall = stall;
+          stall_reported.Notify();
+        }
+      },
+      CreateThread("watchdog_thread"));
+  std::unique_ptr<rtc::Thread> thread = CreateThread("collector_thread");
+  watchdog.Watch(thread.get(), "collector_thread");
+  WaitForHeartbeat(*metrics, "collector_thread");
+
+  absl::Notification unblock;
+  thread->PostTask([&unblock]() {
+    ThreadWatchdog::ScopedTask task("WriteSegment");
+    unblock.WaitForNotification();
+  });
+  thread->PostTask([]() {});
+  bool reported =
+      stall_reported.WaitForNotificationWithTimeout(absl::Seconds(5));
+  unblock.Notify();
+  watchdog.Unwatch(thread.get());
+
+  ASSERT_TRUE(reported);
+  EXPECT_EQ(reported_stall.thread_name, "collector_thread");
+  EXPECT_EQ(reported_stall.blocking_task, "WriteSegment");
+  EXPECT_GE(reported_stall.duration, kTestOptions.stall_threshold);
+  // The queued task and the heartbeat are waiting behind the blocking task.
+  EXPECT_THAT(reported_stall.queue_depth, Ge(2));
+}
+
+TEST(ThreadWatchdogTest, ScopedTasksRestoreEnclosingTask) {
+  auto metrics = std::make_shared<MetricsRegistry>();
+  absl::Notification stall_reported;
+  ThreadWatchdog::Stall reported_stall;
+  ThreadWatchdog watchdog(
+      kTestOptions, metrics,
+      [&](const ThreadWatchdog::Stall& stall) {
+        if (!stall_reported.HasBeenNotified()) {
+          reported_stall = stall;
+          stall_reported.Notify();
+        }
+      },
+      CreateThread("watchdog_thread"));
+  std::unique_ptr<rtc::Thread> thread = CreateThread("client_thread");
+  watchdog.Watch(thread.get(), "client_thread");
+  WaitForHeartbeat(*metrics, "client_thread");
+
+  absl::Notification unblock;
+  thread->PostTask([&unblock]() {
+    ThreadWatchdog::ScopedTask outer_task("OnResourceUpdate");
+    { ThreadWatchdog::ScopedTask inner_task("ParseUpdate"); }
+    unblock.WaitForNotification();
+  });
+  bool reported =
+      stall_reported.WaitForNotificationWithTimeout(absl::Seconds(5));
+  unblock.Notify();
+  watchdog.Unwatch(thread.get());
+
+  ASSERT_TRUE(reported);
+  EXPECT_EQ(reported_stall.blocking_task, "OnResourceUpdate");
+}
+
+}  // namespace
+}  // namespace meet
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/trace.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+
+namespace meet {
+namespace {
+
+// The categories that can be enabled by name. Pipeline events are recorded in
+// memory until they are taken, so that category is only enabled by callers
+// that take them, e.g. to write a trace file.
+constexpr TraceCategory kLoggedTraceCategories[] = {
+    TraceCategory::kDataChannel,
+    TraceCategory::kResourceUpdate,
+    TraceCategory::kMediaStats,
+    TraceCategory::kHttp,
+};
+
+}  // namespace
+
+absl::string_view TraceCategoryName(TraceCategory category) {
+  switch (category) {
+    case TraceCategory::kDataChannel:
+      return "data_channel";
+    case TraceCategory::kResourceUpdate:
+      return "resource_update";
+    case TraceCategory::kMediaStats:
+      return "media_stats";
+    case TraceCategory::kHttp:
+      return "http";
+    case TraceCategory::kPipeline:
+      return "pipeline";
+  }
+  return "unknown";
+}
+
+void SetTraceCategoryEnabled(TraceCategory category, bool enabled) {
+  if (enabled) {
+    trace_internal::enabled_categories.fetch_or(
+        static_cast<uint32_t>(category), std::memory_order_relaxed);
+  } else {
+    trace_internal::enabled_categories.fetch_and(
+        ~static_cast<uint32_t>(category), std::memory_order_relaxed);
+  }
+}
+
+absl::Status SetEnabledTraceCategories(absl::string_view categories) {
+  uint32_t enabled = 0;
+  for (absl::string_view name :
+       absl::StrSplit(categories, ',', absl::SkipWhitespace())) {
+    name = absl::StripAsciiWhitespace(name);
+    if (name == "all") {
+      for (TraceCategory category : kLoggedTraceCategories) {
+        enabled |= static_cast<uint32_t>(category);
+      }
+      continue;
+    }
+
+    bool found = false;
+    for (TraceCategory category : kLoggedTraceCategories) {
+      if (name == TraceCategoryName(category)) {
+        enabled |= static_cast<uint32_t>(category);
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unknown trace category: ", name));
+    }
+  }
+
+  // Leave the pipeline category as it was, since it cannot be named.
+  uint32_t pipeline = static_cast<uint32_t>(TraceCategory::kPipeline);
+  uint32_t current =
+      trace_internal::enabled_categories.load(std::memory_order_relaxed);
+  trace_internal::enabled_categories.store(
+      (current & pipeline) | enabled, std::memory_order_relaxed);
+  return absl::OkStatus();
+}
+
+}  // namespace meet
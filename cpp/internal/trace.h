@@ -0,0 +1,97 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_TRACE_H_
+#define CPP_INTERNAL_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/optimization.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace meet {
+
+// Categories of diagnostic traces emitted on the client's data paths.
+//
+// Traces include full message payloads, so they are disabled by default and
+// should only be enabled while debugging.
+enum class TraceCategory : uint32_t {
+  // Requests sent and updates received on conference data channels.
+  kDataChannel = 1u << 0,
+  // Raw resource updates received by resource handlers.
+  kResourceUpdate = 1u << 1,
+  // Stats reports collected for media stats uploads.
+  kMediaStats = 1u << 2,
+  // Requests to and responses from Meet REST API endpoints.
+  kHttp = 1u << 3,
+  // Timeline events of frames and messages moving through the client and
+  // samples, recorded by `ScopedTraceEvent` rather than logged.
+  kPipeline = 1u << 4,
+};
+
+// Returns the name of the category, as accepted by `SetEnabledTraceCategories`.
+absl::string_view TraceCategoryName(TraceCategory category);
+
+void SetTraceCategoryEnabled(TraceCategory category, bool enabled);
+
+// Enables exactly the logged categories in `categories`, a comma-separated
+// list of category names (e.g. "data_channel,media_stats"). "all" enables
+// every logged category and an empty list disables every logged category.
+//
+// `kPipeline` is not a logged category: its events are recorded until they
+// are taken by `TakeRecordedTraceEvents`, so it can only be enabled through
+// `SetTraceCategoryEnabled`, by callers that take them, and is left unchanged.
+//
+// Returns an error and leaves the enabled categories unchanged if any name is
+// unknown.
+absl::Status SetEnabledTraceCategories(absl::string_view categories);
+
+namespace trace_internal {
+inline std::atomic<uint32_t> enabled_categories{0};
+}  // namespace trace_internal
+
+inline bool IsTraceCategoryEnabled(TraceCategory category) {
+  return ABSL_PREDICT_FALSE(
+      (trace_internal::enabled_categories.load(std::memory_order_relaxed) &
+       static_cast<uint32_t>(category)) != 0);
+}
+
+}  // namespace meet
+
+// Defining `MEET_DISABLE_TRACE` compiles every trace statement down to a
+// constant false check, so that the compiler can remove it entirely.
+#ifdef MEET_DISABLE_TRACE
+#define MEET_TRACE_IS_ON(category) false
+#else
+#define MEET_TRACE_IS_ON(category) \
+  ::meet::IsTraceCategoryEnabled(::meet::TraceCategory::category)
+#endif
+
+// Logs a trace message in the given category, e.g.
+//
+//   MEET_TRACE(kDataChannel) << "Received update: " << message;
+//
+// The streamed operands are only evaluated when the category is enabled, so
+// expensive payloads (like serialized stats reports) cost nothing otherwise.
+#define MEET_TRACE(category)                                             \
+  LOG_IF(INFO, MEET_TRACE_IS_ON(category))                               \
+      << "[" << ::meet::TraceCategoryName(::meet::TraceCategory::category) \
+      << "] "
+
+#endif  // CPP_INTERNAL_TRACE_H_
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/trace_events.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "cpp/internal/json_writer.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace meet {
+namespace {
+
+// Bounds the memory used by a forgotten recording to roughly 64MB.
+constexpr size_t kDefaultMaxRecordedTraceEvents = 1'000'000;
+
+struct RecordedEvent {
+  const char* name;
+  int64_t start_us;
+  int64_t duration_us;
+  int thread_id;
+  std::optional<TraceFlowPhase> flow_phase;
+  uint64_t flow_id;
+  int64_t flow_time_us;
+  uint32_t contributing_source;
+};
+
+struct Recording {
+  absl::Mutex mutex;
+  std::vector<RecordedEvent> events ABSL_GUARDED_BY(mutex);
+  // Names of the threads that recorded events, indexed by thread ID.
+  std::vector<std::string> thread_names ABSL_GUARDED_BY(mutex);
+  size_t max_events ABSL_GUARDED_BY(mutex) = kDefaultMaxRecordedTraceEvents;
+  int64_t dropped_events ABSL_GUARDED_BY(mutex) = 0;
+};
+
+Recording& GetRecording() {
+  // Never destroyed, so that threads still recording during shutdown do not
+  // access a destroyed recording.
+  static Recording* recording = new Recording();
+  return *recording;
+}
+
+// Returns a small ID for the calling thread, registering its name the first
+// time it records an event.
+int CurrentThreadId(Recording& recording)
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(recording.mutex) {
+  thread_local int thread_id = -1;
+  if (thread_id == -1) {
+    thread_id = static_cast<int>(recording.thread_names.size());
+    rtc::Thread* thread = rtc::Thread::Current();
+    recording.thread_names.push_back(
+        thread != nullptr && !thread->name().empty()
+            ? thread->name()
+            : absl::StrCat("thread_", thread_id));
+  }
+  return thread_id;
+}
+
+absl::string_view FlowPhaseCode(TraceFlowPhase phase) {
+  switch (phase) {
+    case TraceFlowPhase::kStart:
+      return "s";
+    case TraceFlowPhase::kStep:
+      return "t";
+    case TraceFlowPhase::kEnd:
+      return "f";
+  }
+  return "t";
+}
+
+void WriteEventHeader(JsonWriter& writer, absl::string_view name,
+                      absl::string_view phase, int64_t time_us,
+                      int thread_id) {
+  writer.Key("name")
+      .String(name)
+      .Key("cat")
+      .String(TraceCategoryName(TraceCategory::kPipeline))
+      .Key("ph")
+      .String(phase)
+      .Key("ts")
+      .Int(time_us)
+      .Key("pid")
+      .Int(1)
+      .Key("tid")
+      .Int(thread_id);
+}
+
+}  // namespace
+
+uint64_t TraceFrameFlowId(uint32_t contributing_source,
+                          absl::Time receive_time) {
+  // Mixes the receive time so that frames of different sources received at
+  // the same time do not share a flow.
+  uint64_t id = static_cast<uint64_t>(absl::ToUnixMicros(receive_time)) *
+                0x9e3779b97f4a7c15u;
+  id ^= static_cast<uint64_t>(contributing_source) << 32 | contributing_source;
+  // Zero marks slices without a flow.
+  return id != 0 ? id : 1;
+}
+
+void ScopedTraceEvent::Record() {
+  int64_t end_us = rtc::TimeMicros();
+  Recording& recording = GetRecording();
+  absl::MutexLock lock(&recording.mutex);
+  if (recording.events.size() >= recording.max_events) {
+    ++recording.dropped_events;
+    return;
+  }
+  recording.events.push_back(RecordedEvent{
+      .name = name_,
+      .start_us = start_us_,
+      .duration_us = end_us - start_us_,
+      .thread_id = CurrentThreadId(recording),
+      .flow_phase = flow_id_ != 0 ? std::optional<TraceFlowPhase>(flow_phase_)
+                                  : std::nullopt,
+      .flow_id = flow_id_,
+      .flow_time_us = flow_time_us_,
+      .contributing_source = contributing_source_,
+  });
+}
+
+void SetMaxRecordedTraceEvents(size_t max_events) {
+  Recording& recording = GetRecording();
+  absl::MutexLock lock(&recording.mutex);
+  recording.max_events = max_events;
+}
+
+std::string TakeRecordedTraceEvents() {
+  std::vector<RecordedEvent> events;
+  std::vector<std::string> thread_names;
+  int64_t dropped_events;
+  {
+    Recording& recording = GetRecording();
+    absl::MutexLock lock(&recording.mutex);
+    events = std::exchange(recording.events, {});
+    // Thread IDs stay assigned, so the names are kept for later recordings.
+    thread_names = recording.thread_names;
+    dropped_events = std::exchange(recording.dropped_events, 0);
+  }
+
+  std::string output;
+  JsonWriter writer(output);
+  writer.BeginObject().Key("traceEvents").BeginArray();
+  for (int thread_id = 0; thread_id < static_cast<int>(thread_names.size());
+       ++thread_id) {
+    writer.BeginObject()
+        .Key("name")
+        .String("thread_name")
+        .Key("ph")
+        .String("M")
+        .Key("pid")
+        .Int(1)
+        .Key("tid")
+        .Int(thread_id)
+        .Key("args")
+        .BeginObject()
+        .Key("name")
+        .String(thread_names[thread_id])
+        .EndObject()
+        .EndObject();
+  }
+  for (const RecordedEvent& event : events) {
+    writer.BeginObject();
+    WriteEventHeader(writer, event.name, "X", event.start_us,
+                     event.thread_id);
+    writer.Key("dur").Int(event.duration_us);
+    if (event.flow_phase.has_value()) {
+      writer.Key("args")
+          .BeginObject()
+          .Key("csrc")
+          .Int(event.contributing_source)
+          .EndObject();
+    }
+    writer.EndObject();
+
+    if (event.flow_phase.has_value()) {
+      writer.BeginObject();
+      WriteEventHeader(writer, "frame", FlowPhaseCode(*event.flow_phase),
+                       event.flow_time_us, event.thread_id);
+      // IDs are written as strings, since trace viewers parse JSON numbers as
+      // doubles.
+      writer.Key("id").String(absl::StrCat(absl::Hex(event.flow_id)));
+      if (*event.flow_phase == TraceFlowPhase::kEnd) {
+        // Binds the end of the flow to the enclosing slice rather than the
+        // next one.
+        writer.Key("bp").String("e");
+      }
+      writer.EndObject();
+    }
+  }
+  writer.EndArray()
+      .Key("otherData")
+      .BeginObject()
+      .Key("dropped_events")
+      .Int(dropped_events)
+      .EndObject()
+      .EndObject();
+  return output;
+}
+
+}  // namespace meet
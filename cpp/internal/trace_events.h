@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_TRACE_EVENTS_H_
+#define CPP_INTERNAL_TRACE_EVENTS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/time/time.h"
+#include "cpp/internal/trace.h"
+#include "webrtc/rtc_base/time_utils.h"
+
+namespace meet {
+
+// How a trace event takes part in the flow of a received frame through the
+// pipeline, from the track that received it to the writer that stored it.
+enum class TraceFlowPhase {
+  // The event received the frame.
+  kStart,
+  // The event handled the frame and passed it on.
+  kStep,
+  // The event was the last to handle the frame.
+  kEnd,
+};
+
+// Returns the ID of the flow of a received frame. Frames are identified by
+// their contributing source and the time the client received them, which are
+// passed along with the frame at every step of the pipeline.
+uint64_t TraceFrameFlowId(uint32_t contributing_source,
+                          absl::Time receive_time);
+
+// Records the duration of a scope as a slice of the pipeline timeline, while
+// the `pipeline` trace category is enabled.
+//
+// Recorded events are kept in memory until they are taken with
+// `TakeRecordedTraceEvents`, which serializes them in the Chrome JSON trace
+// event format read by Perfetto and chrome://tracing. Nested scopes on the
+// same thread are shown as nested slices.
+//
+// Events are recorded behind a lock, which is only taken while the category
+// is enabled.
+class ScopedTraceEvent {
+ public:
+  // `name` must outlive the recording, e.g. be a string literal.
+  explicit ScopedTraceEvent(const char* name)
+      : name_(name), start_us_(MEET_TRACE_IS_ON(kPipeline) ? rtc::TimeMicros()
+                                                           : kNotRecording) {}
+  ~ScopedTraceEvent() {
+    if (start_us_ != kNotRecording) {
+      Record();
+    }
+  }
+
+  // ScopedTraceEvent is neither copyable nor movable.
+  ScopedTraceEvent(const ScopedTraceEvent&) = delete;
+  ScopedTraceEvent& operator=(const ScopedTraceEvent&) = delete;
+
+  // Binds the slice to the flow of the frame received from
+  // `contributing_source` at `receive_time`, so that the timeline connects
+  // the slices that handled the frame. Should be called before any nested
+  // trace events start, since the flow is bound to the innermost slice.
+  void SetFrameFlow(TraceFlowPhase phase, uint32_t contributing_source,
+                    absl::Time receive_time) {
+    if (start_us_ == kNotRecording) {
+      return;
+    }
+    flow_phase_ = phase;
+    flow_id_ = TraceFrameFlowId(contributing_source, receive_time);
+    flow_time_us_ = rtc::TimeMicros();
+    contributing_source_ = contributing_source;
+  }
+
+ private:
+  static constexpr int64_t kNotRecording = -1;
+
+  void Record();
+
+  const char* name_;
+  int64_t start_us_;
+  TraceFlowPhase flow_phase_ = TraceFlowPhase::kStart;
+  // Zero if the slice is not part of a flow.
+  uint64_t flow_id_ = 0;
+  int64_t flow_time_us_ = 0;
+  uint32_t contributing_source_ = 0;
+};
+
+// Sets the maximum number of events kept in memory. Events recorded while the
+// maximum is reached are dropped and counted in the serialized trace.
+void SetMaxRecordedTraceEvents(size_t max_events);
+
+// Returns the events recorded since the last call as a Chrome JSON trace, and
+// clears them.
+std::string TakeRecordedTraceEvents();
+
+}  // namespace meet
+
+#define MEET_TRACE_EVENT_CONCAT_INNER(a, b) a##b
+#define MEET_TRACE_EVENT_CONCAT(a, b) MEET_TRACE_EVENT_CONCAT_INNER(a, b)
+
+// Records the enclosing scope as a pipeline trace event named `name`, e.g.
+//
+//   MEET_TRACE_EVENT("ConferenceDataChannel::OnMessage");
+//
+// Use `ScopedTraceEvent` directly to bind the event to a frame flow.
+#define MEET_TRACE_EVENT(name)        \
+  ::meet::ScopedTraceEvent            \
+  MEET_TRACE_EVENT_CONCAT(meet_trace_event_, __LINE__)(name)
+
+#endif  // CPP_INTERNAL_TRACE_EVENTS_H_
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/trace_events.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+#include "cpp/internal/trace.h"
+
+namespace meet {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+class TraceEventsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { TakeRecordedTraceEvents(); }
+  void TearDown() override {
+    SetTraceCategoryEnabled(TraceCategory::kPipeline, false);
+    SetMaxRecordedTraceEvents(1'000'000);
+    TakeRecordedTraceEvents();
+  }
+};
+
+TEST_F(TraceEventsTest, DoesNotRecordWhenCategoryIsDisabled) {
+  { MEET_TRACE_EVENT("Disabled"); }
+
+  EXPECT_THAT(TakeRecordedTraceEvents(), Not(HasSubstr("Disabled")));
+}
+
+TEST_F(TraceEventsTest, RecordsCompleteEvents) {
+  SetTraceCategoryEnabled(TraceCategory::kPipeline, true);
+
+  { MEET_TRACE_EVENT("Enabled"); }
+
+  EXPECT_THAT(TakeRecordedTraceEvents(),
+              AllOf(HasSubstr(R"("name":"Enabled")"),
+                    HasSubstr(R"("cat":"pipeline")"), HasSubstr(R"("ph":"X")"),
+                    HasSubstr(R"("name":"thread_name")")));
+}
+
+TEST_F(TraceEventsTest, TakeClearsRecordedEvents) {
+  SetTraceCategoryEnabled(TraceCategory::kPipeline, true);
+  { MEET_TRACE_EVENT("Enabled"); }
+  TakeRecordedTraceEvents();
+
+  EXPECT_THAT(TakeRecordedTraceEvents(), Not(HasSubstr(R"("name":"Enabled")")));
+}
+
+TEST_F(TraceEventsTest, RecordsFrameFlows) {
+  SetTraceCategoryEnabled(TraceCategory::kPipeline, true);
+  absl::Time receive_time = absl::FromUnixMicros(123456);
+  {
+    ScopedTraceEvent event("Receive");
+    event.SetFrameFlow(TraceFlowPhase::kStart, 42, receive_time);
+  }
+  {
+    ScopedTraceEvent event("Write");
+    event.SetFrameFlow(TraceFlowPhase::kEnd, 42, receive_time);
+  }
+
+  std::string trace = TakeRecordedTraceEvents();
+
+  EXPECT_THAT(trace, AllOf(HasSubstr(R"("ph":"s")"), HasSubstr(R"("ph":"f")"),
+                           HasSubstr(R"("bp":"e")"),
+                           HasSubstr(R"("args":{"csrc":42})")));
+}
+
+TEST_F(TraceEventsTest, FlowIdsIdentifyFrames) {
+  absl::Time receive_time = absl::FromUnixMicros(123456);
+
+  EXPECT_EQ(TraceFrameFlowId(1, receive_time),
+            TraceFrameFlowId(1, receive_time));
+  EXPECT_NE(TraceFrameFlowId(1, receive_time),
+            TraceFrameFlowId(2, receive_time));
+  EXPECT_NE(TraceFrameFlowId(1, receive_time),
+            TraceFrameFlowId(1, receive_time + absl::Milliseconds(10)));
+}
+
+TEST_F(TraceEventsTest, DropsEventsBeyondMaximum) {
+  SetTraceCategoryEnabled(TraceCategory::kPipeline, true);
+  SetMaxRecordedTraceEvents(1);
+
+  { MEET_TRACE_EVENT("Kept"); }
+  { MEET_TRACE_EVENT("Dropped"); }
+
+  EXPECT_THAT(TakeRecordedTraceEvents(),
+              AllOf(HasSubstr(R"("name":"Kept")"), Not(HasSubstr("Dropped")),
+                    HasSubstr(R"("dropped_events":1)")));
+}
+
+}  // namespace
+}  // namespace meet
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/trace.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace meet {
+namespace {
+
+using ::testing::HasSubstr;
+
+class TraceTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    ASSERT_TRUE(SetEnabledTraceCategories("").ok());
+    SetTraceCategoryEnabled(TraceCategory::kPipeline, false);
+  }
+};
+
+int CountEvaluation(int& evaluations) {
+  ++evaluations;
+  return evaluations;
+}
+
+TEST_F(TraceTest, CategoriesAreDisabledByDefault) {
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kDataChannel));
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kResourceUpdate));
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kMediaStats));
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kHttp));
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kPipeline));
+}
+
+TEST_F(TraceTest, DisabledTraceDoesNotEvaluateOperands) {
+  int evaluations = 0;
+
+  MEET_TRACE(kMediaStats) << CountEvaluation(evaluations);
+
+  EXPECT_EQ(evaluations, 0);
+}
+
+TEST_F(TraceTest, EnabledTraceEvaluatesOperands) {
+  int evaluations = 0;
+  SetTraceCategoryEnabled(TraceCategory::kMediaStats, true);
+
+  MEET_TRACE(kMediaStats) << CountEvaluation(evaluations);
+  MEET_TRACE(kDataChannel) << CountEvaluation(evaluations);
+
+  EXPECT_EQ(evaluations, 1);
+}
+
+TEST_F(TraceTest, SetTraceCategoryEnabledTogglesOneCategory) {
+  SetTraceCategoryEnabled(TraceCategory::kHttp, true);
+  SetTraceCategoryEnabled(TraceCategory::kDataChannel, true);
+  SetTraceCategoryEnabled(TraceCategory::kHttp, false);
+
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kHttp));
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kDataChannel));
+}
+
+TEST_F(TraceTest, SetEnabledTraceCategoriesEnablesNamedCategories) {
+  ASSERT_TRUE(SetEnabledTraceCategories("data_channel, http").ok());
+
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kDataChannel));
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kResourceUpdate));
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kMediaStats));
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kHttp));
+}
+
+TEST_F(TraceTest, SetEnabledTraceCategoriesEnablesAllLoggedCategories) {
+  ASSERT_TRUE(SetEnabledTraceCategories("all").ok());
+
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kDataChannel));
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kResourceUpdate));
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kMediaStats));
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kHttp));
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kPipeline));
+}
+
+TEST_F(TraceTest, SetEnabledTraceCategoriesLeavesPipelineCategoryUnchanged) {
+  SetTraceCategoryEnabled(TraceCategory::kPipeline, true);
+
+  ASSERT_TRUE(SetEnabledTraceCategories("").ok());
+
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kPipeline));
+  EXPECT_EQ(SetEnabledTraceCategories("pipeline").code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(TraceTest, SetEnabledTraceCategoriesRejectsUnknownCategory) {
+  SetTraceCategoryEnabled(TraceCategory::kHttp, true);
+
+  absl::Status status = SetEnabledTraceCategories("data_channel,bogus");
+
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), HasSubstr("bogus"));
+  // The previously enabled categories are left unchanged.
+  EXPECT_TRUE(IsTraceCategoryEnabled(TraceCategory::kHttp));
+  EXPECT_FALSE(IsTraceCategoryEnabled(TraceCategory::kDataChannel));
+}
+
+}  // namespace
+}  // namespace meet
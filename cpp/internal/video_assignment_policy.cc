@@ -0,0 +1,77 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/video_assignment_policy.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "cpp/api/media_entries_resource.h"
+#include "cpp/api/video_assignment_resource.h"
+
+namespace meet {
+
+std::optional<SetVideoAssignmentRequest>
+VideoAssignmentPolicy::HandleMediaEntriesUpdate(
+    const MediaEntriesChannelToClient& update) {
+  for (const MediaEntriesDeletedResource& deleted : update.deleted_resources) {
+    media_entries_.erase(deleted.id);
+  }
+  for (const MediaEntriesResourceSnapshot& snapshot : update.resources) {
+    if (snapshot.media_entry.has_value()) {
+      media_entries_[snapshot.id] = *snapshot.media_entry;
+    }
+  }
+
+  int video_entry_count = 0;
+  bool screenshare = false;
+  for (const auto& [id, entry] : media_entries_) {
+    if (entry.video_muted || entry.video_csrcs.empty()) {
+      continue;
+    }
+    ++video_entry_count;
+    screenshare = screenshare || entry.screenshare;
+  }
+  int canvas_count =
+      std::clamp(video_entry_count, 0, std::max(config_.max_canvases, 0));
+
+  if (assigned_canvas_count_ == canvas_count &&
+      assigned_screenshare_ == screenshare) {
+    return std::nullopt;
+  }
+  assigned_canvas_count_ = canvas_count;
+  assigned_screenshare_ = screenshare;
+
+  const VideoResolution& resolution = screenshare
+                                          ? config_.screenshare_resolution
+                                          : config_.camera_resolution;
+  SetVideoAssignmentRequest request;
+  request.layout_model.label = "video-assignment-policy";
+  request.video_resolution = resolution;
+  for (int i = 0; i < canvas_count; ++i) {
+    // Canvas IDs are reused across layouts so that servers keep assigning
+    // the same feeds to the same canvases.
+    request.layout_model.canvases.push_back(VideoCanvas{
+        .id = i + 1,
+        .dimensions = {.height = resolution.height, .width = resolution.width},
+        .assignment_protocol = VideoCanvas::AssignmentProtocol::kRelevant});
+  }
+  return request;
+}
+
+}  // namespace meet
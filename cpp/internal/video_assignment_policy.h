@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_INTERNAL_VIDEO_ASSIGNMENT_POLICY_H_
+#define CPP_INTERNAL_VIDEO_ASSIGNMENT_POLICY_H_
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "cpp/api/media_entries_resource.h"
+#include "cpp/api/video_assignment_resource.h"
+
+namespace meet {
+
+// Configuration for `VideoAssignmentPolicy`.
+struct VideoAssignmentPolicyConfiguration {
+  // The maximum number of canvases to request. This should not exceed
+  // `MediaApiClientConfiguration::receiving_video_stream_count`.
+  int max_canvases = 3;
+  // The resolution requested while nobody is screensharing. Camera video is
+  // usually only needed to tell participants apart, so thumbnails suffice.
+  VideoResolution camera_resolution = {
+      .height = 180, .width = 320, .frame_rate = 15};
+  // The resolution requested while somebody is screensharing, so that shared
+  // text stays legible. Screenshares rarely need a high frame rate.
+  VideoResolution screenshare_resolution = {
+      .height = 720, .width = 1280, .frame_rate = 5};
+};
+
+// Chooses video assignments that only request the video the application uses.
+//
+// Meet servers assign the most relevant video feeds, e.g. those of the active
+// speakers, to the canvases of a layout. This policy tracks media entries and
+// requests one canvas per entry that is sending video, up to a maximum, so
+// that no stream is decoded for a canvas that would stay empty. It requests
+// the camera resolution unless an entry is screensharing.
+//
+// Each time media entries change such that the layout should change, a new
+// `SetVideoAssignmentRequest` is returned for the application to send.
+//
+// This class is not thread-safe.
+class VideoAssignmentPolicy {
+ public:
+  explicit VideoAssignmentPolicy(VideoAssignmentPolicyConfiguration config)
+      : config_(std::move(config)) {}
+
+  // Applies a media entries update and returns the video assignment request to
+  // send, or nullopt if the current assignment is still suitable.
+  //
+  // The first call always returns a request.
+  std::optional<SetVideoAssignmentRequest> HandleMediaEntriesUpdate(
+      const MediaEntriesChannelToClient& update);
+
+ private:
+  const VideoAssignmentPolicyConfiguration config_;
+  // The media entries of the conference, by resource ID.
+  absl::flat_hash_map<int64_t, MediaEntry> media_entries_;
+  // The canvas count and screenshare state of the last returned request.
+  std::optional<int> assigned_canvas_count_;
+  bool assigned_screenshare_ = false;
+};
+
+}  // namespace meet
+
+#endif  // CPP_INTERNAL_VIDEO_ASSIGNMENT_POLICY_H_
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/internal/video_assignment_policy.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "cpp/api/media_entries_resource.h"
+#include "cpp/api/video_assignment_resource.h"
+
+namespace meet {
+namespace {
+
+using ::testing::SizeIs;
+
+MediaEntriesResourceSnapshot CreateVideoEntry(int64_t id, uint32_t video_csrc,
+                                              bool screenshare = false) {
+  return MediaEntriesResourceSnapshot{
+      .id = id,
+      .media_entry = MediaEntry{.video_csrcs = {video_csrc},
+                                .screenshare = screenshare}};
+}
+
+TEST(VideoAssignmentPolicyTest, RequestsOneCanvasPerVideoEntry) {
+  VideoAssignmentPolicy policy({.max_canvases = 3});
+
+  std::optional<SetVideoAssignmentRequest> request =
+      policy.HandleMediaEntriesUpdate(MediaEntriesChannelToClient{
+          .resources = {CreateVideoEntry(1, 111), CreateVideoEntry(2, 222)}});
+
+  ASSERT_TRUE(request.has_value());
+  ASSERT_THAT(request->layout_model.canvases, SizeIs(2));
+  EXPECT_EQ(request->layout_model.canvases[0].id, 1);
+  EXPECT_EQ(request->layout_model.canvases[1].id, 2);
+  EXPECT_EQ(request->layout_model.canvases[0].dimensions.height, 180);
+  EXPECT_EQ(request->layout_model.canvases[0].dimensions.width, 320);
+  EXPECT_EQ(request->video_resolution.frame_rate, 15);
+}
+
+TEST(VideoAssignmentPolicyTest, IgnoresEntriesWithoutVideo) {
+  VideoAssignmentPolicy policy({.max_canvases = 3});
+
+  std::optional<SetVideoAssignmentRequest> request =
+      policy.HandleMediaEntriesUpdate(MediaEntriesChannelToClient{
+          .resources = {
+              MediaEntriesResourceSnapshot{.id = 1,
+                                           .media_entry = MediaEntry{}},
+              MediaEntriesResourceSnapshot{
+                  .id = 2,
+                  .media_entry = MediaEntry{.video_csrcs = {222},
+                                            .video_muted = true}}}});
+
+  ASSERT_TRUE(request.has_value());
+  EXPECT_THAT(request->layout_model.canvases, SizeIs(0));
+}
+
+TEST(VideoAssignmentPolicyTest, LimitsCanvasesToMaximum) {
+  VideoAssignmentPolicy policy({.max_canvases = 1});
+
+  std::optional<SetVideoAssignmentRequest> request =
+      policy.HandleMediaEntriesUpdate(MediaEntriesChannelToClient{
+          .resources = {CreateVideoEntry(1, 111), CreateVideoEntry(2, 222)}});
+
+  ASSERT_TRUE(request.has_value());
+  EXPECT_THAT(request->layout_model.canvases, SizeIs(1));
+}
+
+TEST(VideoAssignmentPolicyTest, ReturnsNothingWhenLayoutIsUnchanged) {
+  VideoAssignmentPolicy policy({.max_canvases = 3});
+  ASSERT_TRUE(policy
+                  .HandleMediaEntriesUpdate(MediaEntriesChannelToClient{
+                      .resources = {CreateVideoEntry(1, 111)}})
+                  .has_value());
+
+  // A different participant sending video keeps the canvas count.
+  EXPECT_FALSE(policy
+                   .HandleMediaEntriesUpdate(MediaEntriesChannelToClient{
+                       .resources = {CreateVideoEntry(2, 222)},
+                       .deleted_resources = {{.id = 1}}})
+                   .has_value());
+}
+
+TEST(VideoAssignmentPolicyTest, UpdatesLayoutWhenEntriesAreDeleted) {
+  VideoAssignmentPolicy policy({.max_canvases = 3});
+  ASSERT_TRUE(policy
+                  .HandleMediaEntriesUpdate(MediaEntriesChannelToClient{
+                      .resources = {CreateVideoEntry(1, 111),
+                                    CreateVideoEntry(2, 222)}})
+                  .has_value());
+
+  std::optional<SetVideoAssignmentRequest> request =
+      policy.HandleMediaEntriesUpdate(
+          MediaEntriesChannelToClient{.deleted_resources = {{.id = 2}}});
+
+  ASSERT_TRUE(request.has_value());
+  EXPECT_THAT(request->layout_model.canvases, SizeIs(1));
+}
+
+TEST(VideoAssignmentPolicyTest, RequestsScreenshareResolutionWhileSharing) {
+  VideoAssignmentPolicy policy({.max_canvases = 3});
+  ASSERT_TRUE(policy
+                  .HandleMediaEntriesUpdate(MediaEntriesChannelToClient{
+                      .resources = {CreateVideoEntry(1, 111)}})
+                  .has_value());
+
+  std::optional<SetVideoAssignmentRequest> sharing_request =
+      policy.HandleMediaEntriesUpdate(MediaEntriesChannelToClient{
+          .resources = {CreateVideoEntry(2, 222, /*screenshare=*/true)}});
+  std::optional<SetVideoAssignmentRequest> stopped_request =
+      policy.HandleMediaEntriesUpdate(
+          MediaEntriesChannelToClient{.deleted_resources = {{.id = 2}}});
+
+  ASSERT_TRUE(sharing_request.has_value());
+  EXPECT_EQ(sharing_request->video_resolution.height, 720);
+  EXPECT_EQ(sharing_request->video_resolution.width, 1280);
+  EXPECT_EQ(sharing_request->video_resolution.frame_rate, 5);
+  ASSERT_TRUE(stopped_request.has_value());
+  EXPECT_EQ(stopped_request->video_resolution.height, 180);
+}
+
+}  // namespace
+}  // namespace meet
@@ -22,7 +22,6 @@
 #include <variant>
 #include <vector>
 
-#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -30,6 +29,9 @@
 #include "nlohmann/json.hpp"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/video_assignment_resource.h"
+#include "cpp/internal/json_writer.h"
+#include "cpp/internal/trace.h"
+#include "cpp/internal/trace_events.h"
 
 namespace meet {
 namespace {
@@ -48,8 +50,9 @@ const Json* FindOrNull(const Json& json, absl::string_view key) {
 
 absl::StatusOr<ResourceUpdate> VideoAssignmentResourceHandler::ParseUpdate(
     absl::string_view update) {
-  VLOG(1) << kVideoAssignmentResourceName
-          << " resource update received: " << update;
+  MEET_TRACE_EVENT("VideoAssignmentResourceHandler::ParseUpdate");
+  MEET_TRACE(kResourceUpdate) << kVideoAssignmentResourceName
+                              << " resource update received: " << update;
 
   const Json json_resource_update = Json::parse(update, /*cb=*/nullptr,
                                                 /*allow_exceptions=*/false);
@@ -183,70 +186,73 @@ absl::StatusOr<std::string> VideoAssignmentResourceHandler::StringifyRequest(
         "VideoAssignmentChannelFromClient");
   }
 
-  auto video_assignment_request =
-      std::get<VideoAssignmentChannelFromClient>(request);
+  const VideoAssignmentRequest& video_assignment_request =
+      std::get<VideoAssignmentChannelFromClient>(request).request;
 
-  nlohmann::basic_json<> video_assignment_channel_from_client;
-
-  if (video_assignment_request.request.request_id == 0) {
+  if (video_assignment_request.request_id == 0) {
     return absl::InvalidArgumentError("Request ID must be set");
   }
-
-  // Request.requestId
-  video_assignment_channel_from_client["request"]["requestId"] =
-      video_assignment_request.request.request_id;
-  // Request.setAssignment
-  if (video_assignment_request.request.set_video_assignment_request
-          .has_value()) {
-    // Request.setAssignment.layoutModel.label
-    video_assignment_channel_from_client["request"]["setAssignment"]
-                                        ["layoutModel"]["label"] =
-                                            video_assignment_request.request
-                                                .set_video_assignment_request
-                                                ->layout_model.label;
-
-    // Request.setAssignment.layoutModel.canvases
-    std::vector<VideoCanvas> canvases =
-        video_assignment_request.request.set_video_assignment_request
-            ->layout_model.canvases;
-    for (const auto& canvas : canvases) {
+  if (video_assignment_request.set_video_assignment_request.has_value()) {
+    for (const VideoCanvas& canvas :
+         video_assignment_request.set_video_assignment_request->layout_model
+             .canvases) {
       if (canvas.id == 0) {
         return absl::InvalidArgumentError("Canvas ID must be set");
       }
+    }
+  }
 
-      nlohmann::basic_json<> video_canvas;
-      video_canvas["id"] = canvas.id;
-      video_canvas["dimensions"]["height"] = canvas.dimensions.height;
-      video_canvas["dimensions"]["width"] = canvas.dimensions.width;
-      if (canvas.assignment_protocol == kDirect) {
-        video_canvas["direct"] = nlohmann::json::value_t::object;
-      } else {
-        video_canvas["relevant"] = nlohmann::json::value_t::object;
+  // Keys are written in lexicographic order. See `JsonWriter`.
+  std::string json_request;
+  JsonWriter writer(json_request);
+  writer.BeginObject()
+      .Key("request")
+      .BeginObject()
+      .Key("requestId")
+      .Int(video_assignment_request.request_id);
+  // Request.setAssignment
+  if (video_assignment_request.set_video_assignment_request.has_value()) {
+    const SetVideoAssignmentRequest& set_assignment =
+        *video_assignment_request.set_video_assignment_request;
+    writer.Key("setAssignment").BeginObject().Key("layoutModel").BeginObject();
+    // Request.setAssignment.layoutModel.canvases
+    if (!set_assignment.layout_model.canvases.empty()) {
+      writer.Key("canvases").BeginArray();
+      for (const VideoCanvas& canvas : set_assignment.layout_model.canvases) {
+        writer.BeginObject()
+            .Key("dimensions")
+            .BeginObject()
+            .Key("height")
+            .Int(canvas.dimensions.height)
+            .Key("width")
+            .Int(canvas.dimensions.width)
+            .EndObject();
+        if (canvas.assignment_protocol == kDirect) {
+          writer.Key("direct").EmptyObject().Key("id").Int(canvas.id);
+        } else {
+          writer.Key("id").Int(canvas.id).Key("relevant").EmptyObject();
+        }
+        writer.EndObject();
       }
-      video_assignment_channel_from_client["request"]["setAssignment"]
-                                          ["layoutModel"]["canvases"]
-                                              .push_back(
-                                                  std::move(video_canvas));
+      writer.EndArray();
     }
+    // Request.setAssignment.layoutModel.label
+    writer.Key("label").String(set_assignment.layout_model.label).EndObject();
 
     // Request.setAssignment.videoResolution
-    video_assignment_channel_from_client["request"]["setAssignment"]
-                                        ["maxVideoResolution"]["height"] =
-                                            video_assignment_request.request
-                                                .set_video_assignment_request
-                                                ->video_resolution.height;
-    video_assignment_channel_from_client["request"]["setAssignment"]
-                                        ["maxVideoResolution"]["width"] =
-                                            video_assignment_request.request
-                                                .set_video_assignment_request
-                                                ->video_resolution.width;
-    video_assignment_channel_from_client["request"]["setAssignment"]
-                                        ["maxVideoResolution"]["frameRate"] =
-                                            video_assignment_request.request
-                                                .set_video_assignment_request
-                                                ->video_resolution.frame_rate;
+    writer.Key("maxVideoResolution")
+        .BeginObject()
+        .Key("frameRate")
+        .Int(set_assignment.video_resolution.frame_rate)
+        .Key("height")
+        .Int(set_assignment.video_resolution.height)
+        .Key("width")
+        .Int(set_assignment.video_resolution.width)
+        .EndObject()
+        .EndObject();
   }
-  return video_assignment_channel_from_client.dump();
+  writer.EndObject().EndObject();
+  return json_request;
 }
 
 }  // namespace meet
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/async_output_writer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/types/span.h"
+#include "cpp/internal/trace_events.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+
+absl::StatusOr<std::unique_ptr<OutputWriterThreadPool>>
+OutputWriterThreadPool::Create(uint32_t thread_count,
+                               size_t max_in_flight_bytes) {
+  if (thread_count == 0) {
+    return absl::InvalidArgumentError(
+        "Output writer thread count must be greater than 0");
+  }
+
+  std::vector<std::unique_ptr<rtc::Thread>> threads;
+  threads.reserve(thread_count);
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+    thread->SetName(absl::StrCat("output_writer_thread_", i), nullptr);
+    if (!thread->Start()) {
+      return absl::InternalError("Failed to start output writer thread");
+    }
+    threads.push_back(std::move(thread));
+  }
+  return std::make_unique<OutputWriterThreadPool>(std::move(threads),
+                                                  max_in_flight_bytes);
+}
+
+rtc::Thread* OutputWriterThreadPool::NextThread() {
+  absl::MutexLock lock(&mutex_);
+  return threads_[next_thread_++ % threads_.size()].get();
+}
+
+bool OutputWriterThreadPool::AcquireInFlightBytes(size_t size) {
+  auto can_proceed = [this, size]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return stopped_ || in_flight_bytes_ == 0 ||
+           in_flight_bytes_ + size <= max_in_flight_bytes_;
+  };
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(&can_proceed));
+  if (stopped_) {
+    return false;
+  }
+  in_flight_bytes_ += size;
+  return true;
+}
+
+void OutputWriterThreadPool::ReleaseInFlightBytes(size_t size) {
+  absl::MutexLock lock(&mutex_);
+  in_flight_bytes_ -= size;
+}
+
+void OutputWriterThreadPool::Stop() {
+  {
+    absl::MutexLock lock(&mutex_);
+    // Writes that have not started will never release their bytes, so unblock
+    // any waiting writers.
+    stopped_ = true;
+  }
+  for (std::unique_ptr<rtc::Thread>& thread : threads_) {
+    thread->Stop();
+  }
+}
+
+void AsyncOutputWriter::Write(const char* content, std::streamsize size) {
+  PostWrite(std::vector<char>(content, content + size));
+}
+
+void AsyncOutputWriter::WriteVectored(absl::Span<const Chunk> chunks) {
+  // Gather the chunks so that they are handed to the writer thread in a single
+  // task.
+  size_t total_size = 0;
+  for (const Chunk& chunk : chunks) {
+    total_size += chunk.size;
+  }
+  std::vector<char> data;
+  data.reserve(total_size);
+  for (const Chunk& chunk : chunks) {
+    data.insert(data.end(), chunk.content, chunk.content + chunk.size);
+  }
+  PostWrite(std::move(data));
+}
+
+void AsyncOutputWriter::PostWrite(std::vector<char> data) {
+  if (data.empty()) {
+    return;
+  }
+  if (!pool_->AcquireInFlightBytes(data.size())) {
+    return;
+  }
+  thread_->PostTask(
+      [state = state_, pool = pool_, data = std::move(data)]() {
+        MEET_TRACE_EVENT("AsyncOutputWriter::Write");
+        state->writer->Write(data.data(), data.size());
+        pool->ReleaseInFlightBytes(data.size());
+      });
+}
+
+void AsyncOutputWriter::Close() {
+  absl::Notification closed;
+  CloseAsync([&closed]() { closed.Notify(); });
+  closed.WaitForNotification();
+}
+
+void AsyncOutputWriter::CloseAsync(absl::AnyInvocable<void() &&> on_closed) {
+  closed_ = true;
+  thread_->PostTask(
+      [state = state_, on_closed = std::move(on_closed)]() mutable {
+        MEET_TRACE_EVENT("AsyncOutputWriter::Close");
+        state->writer->Close();
+        std::move(on_closed)();
+      });
+}
+
+}  // namespace media_api_samples
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_ASYNC_OUTPUT_WRITER_H_
+#define CPP_SAMPLES_ASYNC_OUTPUT_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+
+inline constexpr size_t kDefaultMaxInFlightOutputBytes = 32 * 1024 * 1024;
+
+// A pool of threads that perform blocking writes on behalf of
+// `AsyncOutputWriter`s.
+//
+// The pool bounds the number of bytes that have been handed to its threads but
+// not yet written. Once the bound is reached, writers block until enough data
+// has been written, so that a slow disk applies backpressure instead of
+// growing memory without limit.
+class OutputWriterThreadPool {
+ public:
+  static absl::StatusOr<std::unique_ptr<OutputWriterThreadPool>> Create(
+      uint32_t thread_count,
+      size_t max_in_flight_bytes = kDefaultMaxInFlightOutputBytes);
+
+  // Constructor that allows injecting writer threads, useful for testing.
+  //
+  // `threads` must be non-empty and already started.
+  OutputWriterThreadPool(std::vector<std::unique_ptr<rtc::Thread>> threads,
+                         size_t max_in_flight_bytes)
+      : threads_(std::move(threads)),
+        max_in_flight_bytes_(max_in_flight_bytes) {}
+
+  ~OutputWriterThreadPool() { Stop(); }
+
+  // OutputWriterThreadPool is neither copyable nor movable.
+  OutputWriterThreadPool(const OutputWriterThreadPool&) = delete;
+  OutputWriterThreadPool& operator=(const OutputWriterThreadPool&) = delete;
+
+  // Returns the thread that the next writer should use. Threads are assigned
+  // round-robin.
+  rtc::Thread* NextThread();
+
+  // Blocks until `size` bytes can be put in flight, and accounts for them.
+  // Returns false, without blocking, if the pool has been stopped.
+  //
+  // Writes larger than the bound are admitted once nothing else is in flight.
+  bool AcquireInFlightBytes(size_t size);
+  void ReleaseInFlightBytes(size_t size);
+
+  // Stops the writer threads. Writes that have not started are discarded.
+  void Stop();
+
+ private:
+  std::vector<std::unique_ptr<rtc::Thread>> threads_;
+  const size_t max_in_flight_bytes_;
+
+  absl::Mutex mutex_;
+  size_t in_flight_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  size_t next_thread_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+// An output writer that moves writes off of the calling thread.
+//
+// Data is copied and handed to a thread from an `OutputWriterThreadPool`,
+// which writes it to the wrapped writer. All writes for a given writer run on
+// the same thread, in order.
+class AsyncOutputWriter : public OutputWriterInterface {
+ public:
+  // `pool` must outlive this writer.
+  AsyncOutputWriter(std::unique_ptr<OutputWriterInterface> writer,
+                    OutputWriterThreadPool* pool)
+      : state_(std::make_shared<State>(std::move(writer))),
+        pool_(pool),
+        thread_(pool->NextThread()) {}
+
+  ~AsyncOutputWriter() override {
+    if (!closed_) {
+      CloseAsync([] {});
+    }
+  }
+
+  // AsyncOutputWriter is neither copyable nor movable.
+  AsyncOutputWriter(const AsyncOutputWriter&) = delete;
+  AsyncOutputWriter& operator=(const AsyncOutputWriter&) = delete;
+
+  void Write(const char* content, std::streamsize size) override;
+  void WriteVectored(absl::Span<const Chunk> chunks) override;
+  // Blocks until all queued writes have completed and the wrapped writer has
+  // been closed.
+  void Close() override;
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed) override;
+
+ private:
+  // Shared with queued tasks, so that the wrapped writer stays alive until
+  // every queued write has run.
+  struct State {
+    explicit State(std::unique_ptr<OutputWriterInterface> writer)
+        : writer(std::move(writer)) {}
+
+    std::unique_ptr<OutputWriterInterface> writer;
+  };
+
+  void PostWrite(std::vector<char> data);
+
+  std::shared_ptr<State> state_;
+  OutputWriterThreadPool* pool_;
+  rtc::Thread* thread_;
+  bool closed_ = false;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_ASYNC_OUTPUT_WRITER_H_
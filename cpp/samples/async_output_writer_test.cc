@@ -0,0 +1,120 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/async_output_writer.h"
+
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "cpp/samples/testing/mock_output_writer.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::InSequence;
+
+std::unique_ptr<OutputWriterThreadPool> CreatePool(size_t max_in_flight_bytes) {
+  absl::StatusOr<std::unique_ptr<OutputWriterThreadPool>> pool =
+      OutputWriterThreadPool::Create(/*thread_count=*/2, max_in_flight_bytes);
+  EXPECT_TRUE(pool.ok());
+  return std::move(pool).value();
+}
+
+TEST(AsyncOutputWriterTest, CreatePoolFailsWithoutThreads) {
+  EXPECT_FALSE(OutputWriterThreadPool::Create(/*thread_count=*/0).ok());
+}
+
+TEST(AsyncOutputWriterTest, WritesInOrderOnWriterThread) {
+  std::unique_ptr<OutputWriterThreadPool> pool = CreatePool(1024);
+  auto mock_writer = std::make_unique<MockOutputWriter>();
+  std::string written;
+  bool wrote_on_writer_thread = true;
+  rtc::Thread* test_thread = rtc::Thread::Current();
+  EXPECT_CALL(*mock_writer, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        wrote_on_writer_thread &= rtc::Thread::Current() != test_thread;
+        written.append(content, size);
+      });
+  EXPECT_CALL(*mock_writer, Close);
+  AsyncOutputWriter writer(std::move(mock_writer), pool.get());
+
+  writer.Write("ab", 2);
+  std::vector<OutputWriterInterface::Chunk> chunks = {{"cd", 2}, {"ef", 2}};
+  writer.WriteVectored(chunks);
+  writer.Close();
+
+  EXPECT_EQ(written, "abcdef");
+  EXPECT_TRUE(wrote_on_writer_thread);
+}
+
+TEST(AsyncOutputWriterTest, CloseAsyncInvokesCallbackAfterPendingWrites) {
+  std::unique_ptr<OutputWriterThreadPool> pool = CreatePool(1024);
+  auto mock_writer = std::make_unique<MockOutputWriter>();
+  {
+    InSequence sequence;
+    EXPECT_CALL(*mock_writer, Write(_, 2));
+    EXPECT_CALL(*mock_writer, Close);
+  }
+  AsyncOutputWriter writer(std::move(mock_writer), pool.get());
+  absl::Notification closed;
+
+  writer.Write("ab", 2);
+  writer.CloseAsync([&closed]() { closed.Notify(); });
+
+  EXPECT_TRUE(closed.WaitForNotificationWithTimeout(absl::Seconds(1)));
+}
+
+TEST(AsyncOutputWriterTest, BlocksWhenInFlightBytesAreExhausted) {
+  std::unique_ptr<OutputWriterThreadPool> pool = CreatePool(4);
+  auto mock_writer = std::make_unique<MockOutputWriter>();
+  absl::Notification unblock_write;
+  absl::Notification second_write_queued;
+  EXPECT_CALL(*mock_writer, Write(_, _))
+      .WillOnce([&]() { unblock_write.WaitForNotification(); })
+      .WillOnce([]() {});
+  EXPECT_CALL(*mock_writer, Close);
+  AsyncOutputWriter writer(std::move(mock_writer), pool.get());
+  writer.Write("abcd", 4);
+
+  auto second_writer = rtc::Thread::Create();
+  second_writer->Start();
+  second_writer->PostTask([&]() {
+    writer.Write("ef", 2);
+    second_write_queued.Notify();
+  });
+
+  // The first write still holds all of the in-flight bytes.
+  EXPECT_FALSE(second_write_queued.WaitForNotificationWithTimeout(
+      absl::Milliseconds(50)));
+  unblock_write.Notify();
+  EXPECT_TRUE(
+      second_write_queued.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  writer.Close();
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/audio_levels.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+
+namespace media_api_samples {
+namespace {
+
+constexpr double kFullScale = 32768.0;
+
+}  // namespace
+
+AudioLevel ComputeAudioLevel(absl::Span<const int16_t> pcm16) {
+  if (pcm16.empty()) {
+    return AudioLevel();
+  }
+
+  // Samples are widened before squaring, since the square of an int16 sample
+  // only fits in 31 bits and sums would overflow 32-bit accumulators.
+  int peak = 0;
+  int64_t sum_of_squares = 0;
+  for (int16_t sample : pcm16) {
+    int32_t value = sample;
+    int32_t magnitude = value < 0 ? -value : value;
+    peak = magnitude > peak ? magnitude : peak;
+    sum_of_squares += static_cast<int64_t>(value * value);
+  }
+  return AudioLevel{
+      .peak = peak,
+      .rms = std::sqrt(static_cast<double>(sum_of_squares) / pcm16.size()),
+  };
+}
+
+double AmplitudeToDbfs(double amplitude) {
+  if (amplitude <= 0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return 20 * std::log10(amplitude / kFullScale);
+}
+
+bool IsSilence(const AudioLevel& level, double threshold_dbfs) {
+  return AmplitudeToDbfs(level.rms) < threshold_dbfs;
+}
+
+void ConvertPcm16ToFloat(absl::Span<const int16_t> pcm16,
+                         absl::Span<float> output) {
+  DCHECK_GE(output.size(), pcm16.size());
+
+  constexpr float kScale = 1.0f / 32768.0f;
+  for (size_t i = 0; i < pcm16.size(); ++i) {
+    output[i] = static_cast<float>(pcm16[i]) * kScale;
+  }
+}
+
+}  // namespace media_api_samples
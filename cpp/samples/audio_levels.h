@@ -0,0 +1,60 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_AUDIO_LEVELS_H_
+#define CPP_SAMPLES_AUDIO_LEVELS_H_
+
+#include <cstdint>
+
+#include "absl/types/span.h"
+
+namespace media_api_samples {
+
+// Audio below this RMS level is considered silence by default. Quiet speech is
+// around -40 dBFS, while the noise floor of a muted-but-open microphone is
+// typically below -60 dBFS.
+inline constexpr double kDefaultSilenceThresholdDbfs = -50.0;
+
+// The level of a buffer of PCM16 samples.
+struct AudioLevel {
+  // The largest absolute sample value, in [0, 32768].
+  int peak = 0;
+  // The root mean square of the samples, in [0, 32768].
+  double rms = 0;
+};
+
+// Computes the peak and RMS level of `pcm16`.
+//
+// The loops are kept simple and branch-free so that compilers vectorize them
+// for the target's SIMD instructions.
+AudioLevel ComputeAudioLevel(absl::Span<const int16_t> pcm16);
+
+// Converts an amplitude in [0, 32768] to decibels relative to full scale.
+// Returns -infinity for 0.
+double AmplitudeToDbfs(double amplitude);
+
+// Returns whether the RMS level of `level` is below `threshold_dbfs`.
+bool IsSilence(const AudioLevel& level,
+               double threshold_dbfs = kDefaultSilenceThresholdDbfs);
+
+// Converts PCM16 samples to floats in [-1, 1). `output` must be at least as
+// large as `pcm16`.
+void ConvertPcm16ToFloat(absl::Span<const int16_t> pcm16,
+                         absl::Span<float> output);
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_AUDIO_LEVELS_H_
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/audio_levels.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/types/span.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::DoubleNear;
+using ::testing::ElementsAre;
+using ::testing::FloatEq;
+
+TEST(AudioLevelsTest, ComputeAudioLevelOfEmptyBufferIsZero) {
+  AudioLevel level = ComputeAudioLevel({});
+
+  EXPECT_EQ(level.peak, 0);
+  EXPECT_EQ(level.rms, 0);
+}
+
+TEST(AudioLevelsTest, ComputeAudioLevelComputesPeakAndRms) {
+  std::vector<int16_t> pcm16 = {3, -4, 3, -4};
+
+  AudioLevel level = ComputeAudioLevel(pcm16);
+
+  EXPECT_EQ(level.peak, 4);
+  EXPECT_THAT(level.rms, DoubleNear(3.5355, 1e-4));
+}
+
+TEST(AudioLevelsTest, ComputeAudioLevelHandlesFullScaleSamples) {
+  std::vector<int16_t> pcm16(4800, -32768);
+
+  AudioLevel level = ComputeAudioLevel(pcm16);
+
+  EXPECT_EQ(level.peak, 32768);
+  EXPECT_EQ(level.rms, 32768);
+}
+
+TEST(AudioLevelsTest, AmplitudeToDbfsIsRelativeToFullScale) {
+  EXPECT_EQ(AmplitudeToDbfs(32768), 0);
+  EXPECT_THAT(AmplitudeToDbfs(16384), DoubleNear(-6.0206, 1e-4));
+  EXPECT_EQ(AmplitudeToDbfs(0), -INFINITY);
+}
+
+TEST(AudioLevelsTest, IsSilenceComparesRmsWithThreshold) {
+  // About -50.3 dBFS.
+  AudioLevel quiet = {.peak = 100, .rms = 100};
+  // About -30.3 dBFS.
+  AudioLevel speech = {.peak = 3000, .rms = 1000};
+
+  EXPECT_TRUE(IsSilence(quiet));
+  EXPECT_FALSE(IsSilence(speech));
+  EXPECT_FALSE(IsSilence(quiet, /*threshold_dbfs=*/-60));
+  EXPECT_TRUE(IsSilence(AudioLevel()));
+}
+
+TEST(AudioLevelsTest, ConvertPcm16ToFloatScalesToUnitRange) {
+  std::vector<int16_t> pcm16 = {-32768, 0, 16384, 32767};
+  std::vector<float> output(pcm16.size());
+
+  ConvertPcm16ToFloat(pcm16, absl::MakeSpan(output));
+
+  EXPECT_THAT(output, ElementsAre(FloatEq(-1), FloatEq(0), FloatEq(0.5),
+                                  FloatEq(32767.0f / 32768.0f)));
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/audio_resampler.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "webrtc/api/audio/audio_view.h"
+#include "webrtc/common_audio/resampler/include/push_resampler.h"
+
+namespace media_api_samples {
+namespace {
+
+// Audio is resampled in 10 ms frames.
+constexpr int kFramesPerSecond = 100;
+
+}  // namespace
+
+absl::Status ValidateAudioConversion(const AudioConversion& conversion) {
+  if (conversion.sample_rate < 0 ||
+      conversion.sample_rate % kFramesPerSecond != 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Audio sample rate must be a multiple of 100 Hz; got ",
+                     conversion.sample_rate));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<absl::Span<const int16_t>> AudioResampler::Convert(
+    absl::Span<const int16_t> pcm16, int sample_rate, int channel_count) {
+  if (sample_rate <= 0 || channel_count <= 0 ||
+      pcm16.size() % channel_count != 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Invalid audio frame of ", pcm16.size(), " samples with ",
+        channel_count, " channels at ", sample_rate, " Hz"));
+  }
+  size_t samples_per_channel = pcm16.size() / channel_count;
+
+  absl::Span<const int16_t> input = pcm16;
+  int input_channel_count = channel_count;
+  if (conversion_.downmix_to_mono && channel_count > 1) {
+    downmixed_.resize(samples_per_channel);
+    for (size_t i = 0; i < samples_per_channel; ++i) {
+      int32_t sum = 0;
+      for (int channel = 0; channel < channel_count; ++channel) {
+        sum += pcm16[i * channel_count + channel];
+      }
+      downmixed_[i] = static_cast<int16_t>(sum / channel_count);
+    }
+    input = downmixed_;
+    input_channel_count = 1;
+  }
+
+  int output_sample_rate = OutputSampleRate(sample_rate);
+  if (output_sample_rate == sample_rate) {
+    return input;
+  }
+  size_t input_block_size = sample_rate / kFramesPerSecond;
+  if (sample_rate % kFramesPerSecond != 0 || samples_per_channel == 0 ||
+      samples_per_channel % input_block_size != 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Audio frames must be a multiple of 10 ms long to be resampled; got ",
+        samples_per_channel, " samples per channel at ", sample_rate, " Hz"));
+  }
+
+  // Only reinitializes, and so resets the filter state, if the input format
+  // changes.
+  resampler_.InitializeIfNeeded(sample_rate, output_sample_rate,
+                                input_channel_count);
+  size_t output_block_size = output_sample_rate / kFramesPerSecond;
+  size_t block_count = samples_per_channel / input_block_size;
+  resampled_.resize(block_count * output_block_size * input_channel_count);
+  for (size_t block = 0; block < block_count; ++block) {
+    resampler_.Resample(
+        webrtc::InterleavedView<const int16_t>(
+            input.data() + block * input_block_size * input_channel_count,
+            input_block_size, input_channel_count),
+        webrtc::InterleavedView<int16_t>(
+            resampled_.data() + block * output_block_size * input_channel_count,
+            output_block_size, input_channel_count));
+  }
+  return absl::MakeConstSpan(resampled_);
+}
+
+}  // namespace media_api_samples
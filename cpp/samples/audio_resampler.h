@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_AUDIO_RESAMPLER_H_
+#define CPP_SAMPLES_AUDIO_RESAMPLER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "webrtc/common_audio/resampler/include/push_resampler.h"
+
+namespace media_api_samples {
+
+// The format that audio is converted to before it is written, e.g. 16 kHz mono
+// for speech recognition.
+struct AudioConversion {
+  // The output sample rate in Hz, or 0 to keep the input sample rate. Must be a
+  // multiple of 100, since audio is resampled in 10 ms frames.
+  int sample_rate = 16000;
+  // Whether to average the channels of multichannel audio into one.
+  bool downmix_to_mono = true;
+};
+
+// Returns an error if `conversion` cannot be applied.
+absl::Status ValidateAudioConversion(const AudioConversion& conversion);
+
+// Converts a stream of interleaved PCM16 frames to the format of an
+// `AudioConversion`.
+//
+// The resampler's filter state is kept between frames, so a resampler must
+// only be used for a single stream. Resampling uses WebRTC's push resampler,
+// which is vectorized for the target's SIMD instructions.
+class AudioResampler {
+ public:
+  explicit AudioResampler(AudioConversion conversion)
+      : conversion_(conversion) {}
+
+  // AudioResampler is neither copyable nor movable.
+  AudioResampler(const AudioResampler&) = delete;
+  AudioResampler& operator=(const AudioResampler&) = delete;
+
+  // The format of audio that `Convert` returns for input in the given format.
+  int OutputSampleRate(int input_sample_rate) const {
+    return conversion_.sample_rate > 0 ? conversion_.sample_rate
+                                       : input_sample_rate;
+  }
+  int OutputChannelCount(int input_channel_count) const {
+    return conversion_.downmix_to_mono ? 1 : input_channel_count;
+  }
+
+  // Converts a frame of `channel_count` interleaved channels.
+  //
+  // Frames must be a multiple of 10 ms long if they are resampled: WebRTC
+  // delivers 10 ms frames, and aggregated frames (see
+  // `MediaApiClientConfiguration::audio_aggregation_window_ms`) hold several of
+  // them. Longer frames are resampled 10 ms at a time. The returned samples
+  // are valid until the next call.
+  absl::StatusOr<absl::Span<const int16_t>> Convert(
+      absl::Span<const int16_t> pcm16, int sample_rate, int channel_count);
+
+ private:
+  const AudioConversion conversion_;
+  webrtc::PushResampler<int16_t> resampler_;
+  // Reused between frames to avoid allocating for each frame.
+  std::vector<int16_t> downmixed_;
+  std::vector<int16_t> resampled_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_AUDIO_RESAMPLER_H_
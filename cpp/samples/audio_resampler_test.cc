@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/audio_resampler.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::SizeIs;
+using ::testing::status::StatusIs;
+
+TEST(AudioResamplerTest, ValidateAudioConversionAcceptsMultiplesOf100Hz) {
+  EXPECT_OK(ValidateAudioConversion({.sample_rate = 16000}));
+  EXPECT_OK(ValidateAudioConversion({.sample_rate = 0}));
+  EXPECT_THAT(ValidateAudioConversion({.sample_rate = 22050}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ValidateAudioConversion({.sample_rate = -16000}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(AudioResamplerTest, DownmixesChannelsToMono) {
+  AudioResampler resampler({.sample_rate = 0, .downmix_to_mono = true});
+  std::vector<int16_t> stereo = {100, 200, -100, -300, 7, 8};
+
+  absl::StatusOr<absl::Span<const int16_t>> mono =
+      resampler.Convert(stereo, /*sample_rate=*/48000, /*channel_count=*/2);
+
+  ASSERT_OK(mono);
+  EXPECT_THAT(*mono, ElementsAre(150, -200, 7));
+  EXPECT_EQ(resampler.OutputChannelCount(2), 1);
+  EXPECT_EQ(resampler.OutputSampleRate(48000), 48000);
+}
+
+TEST(AudioResamplerTest, PassesThroughMatchingFormat) {
+  AudioResampler resampler({.sample_rate = 48000, .downmix_to_mono = false});
+  std::vector<int16_t> stereo = {1, 2, 3, 4};
+
+  absl::StatusOr<absl::Span<const int16_t>> output =
+      resampler.Convert(stereo, /*sample_rate=*/48000, /*channel_count=*/2);
+
+  ASSERT_OK(output);
+  EXPECT_EQ(output->data(), stereo.data());
+  EXPECT_EQ(resampler.OutputChannelCount(2), 2);
+}
+
+TEST(AudioResamplerTest, ResamplesTenMillisecondFrames) {
+  AudioResampler resampler({.sample_rate = 16000, .downmix_to_mono = true});
+  std::vector<int16_t> stereo(480 * 2, 1000);
+
+  absl::StatusOr<absl::Span<const int16_t>> output =
+      resampler.Convert(stereo, /*sample_rate=*/48000, /*channel_count=*/2);
+
+  ASSERT_OK(output);
+  EXPECT_THAT(*output, SizeIs(160));
+  EXPECT_EQ(resampler.OutputSampleRate(48000), 16000);
+}
+
+TEST(AudioResamplerTest, ResamplesFramesOfSeveralTenMilliseconds) {
+  AudioResampler resampler({.sample_rate = 16000, .downmix_to_mono = true});
+  // A 40 ms frame, as delivered with a 40 ms audio aggregation window.
+  std::vector<int16_t> mono(4 * 480, 1000);
+
+  absl::StatusOr<absl::Span<const int16_t>> output =
+      resampler.Convert(mono, /*sample_rate=*/48000, /*channel_count=*/1);
+
+  ASSERT_OK(output);
+  EXPECT_THAT(*output, SizeIs(4 * 160));
+}
+
+TEST(AudioResamplerTest, RejectsFramesThatCannotBeResampled) {
+  AudioResampler resampler({.sample_rate = 16000, .downmix_to_mono = true});
+  std::vector<int16_t> short_frame(100);
+  std::vector<int16_t> partial_frame(480 + 100);
+  std::vector<int16_t> uneven_frame(3);
+
+  EXPECT_THAT(resampler.Convert(short_frame, /*sample_rate=*/48000,
+                                /*channel_count=*/1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(resampler.Convert(partial_frame, /*sample_rate=*/48000,
+                                /*channel_count=*/1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(resampler.Convert(uneven_frame, /*sample_rate=*/48000,
+                                /*channel_count=*/2),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/buffered_output_writer.h"
+
+#include <cstddef>
+#include <ios>
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/types/span.h"
+#include "cpp/internal/trace_events.h"
+
+namespace media_api_samples {
+
+void BufferedOutputWriter::Write(const char* content, std::streamsize size) {
+  MEET_TRACE_EVENT("BufferedOutputWriter::Write");
+  if (buffer_.size() + size > flush_size_) {
+    Flush();
+  }
+  // Copying large writes into the buffer would only delay them.
+  if (static_cast<size_t>(size) >= flush_size_) {
+    writer_->Write(content, size);
+    return;
+  }
+  buffer_.insert(buffer_.end(), content, content + size);
+}
+
+void BufferedOutputWriter::WriteVectored(absl::Span<const Chunk> chunks) {
+  size_t total_size = 0;
+  for (const Chunk& chunk : chunks) {
+    total_size += chunk.size;
+  }
+  if (buffer_.size() + total_size > flush_size_) {
+    Flush();
+  }
+  if (total_size >= flush_size_) {
+    writer_->WriteVectored(chunks);
+    return;
+  }
+  for (const Chunk& chunk : chunks) {
+    buffer_.insert(buffer_.end(), chunk.content, chunk.content + chunk.size);
+  }
+}
+
+void BufferedOutputWriter::Close() {
+  MEET_TRACE_EVENT("BufferedOutputWriter::Close");
+  Flush();
+  writer_->Close();
+}
+
+void BufferedOutputWriter::CloseAsync(
+    absl::AnyInvocable<void() &&> on_closed) {
+  Flush();
+  writer_->CloseAsync(std::move(on_closed));
+}
+
+void BufferedOutputWriter::Flush() {
+  if (buffer_.empty()) {
+    return;
+  }
+  writer_->Write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+}
+
+}  // namespace media_api_samples
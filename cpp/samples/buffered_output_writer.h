@@ -0,0 +1,72 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_BUFFERED_OUTPUT_WRITER_H_
+#define CPP_SAMPLES_BUFFERED_OUTPUT_WRITER_H_
+
+#include <cstddef>
+#include <ios>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/types/span.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+
+// 64 KiB holds roughly 0.7 seconds of 48 kHz mono PCM16 audio.
+inline constexpr size_t kDefaultOutputWriterFlushSize = 64 * 1024;
+
+// An output writer that accumulates small writes and forwards them to the
+// wrapped writer in chunks of up to `flush_size` bytes.
+//
+// Writes (or vectored writes) of at least `flush_size` bytes in total are
+// forwarded directly, after any buffered data. Buffered data is flushed when
+// the writer is closed or destroyed.
+class BufferedOutputWriter : public OutputWriterInterface {
+ public:
+  explicit BufferedOutputWriter(
+      std::unique_ptr<OutputWriterInterface> writer,
+      size_t flush_size = kDefaultOutputWriterFlushSize)
+      : writer_(std::move(writer)), flush_size_(flush_size) {
+    buffer_.reserve(flush_size_);
+  }
+
+  ~BufferedOutputWriter() override { Flush(); }
+
+  // BufferedOutputWriter is neither copyable nor movable.
+  BufferedOutputWriter(const BufferedOutputWriter&) = delete;
+  BufferedOutputWriter& operator=(const BufferedOutputWriter&) = delete;
+
+  void Write(const char* content, std::streamsize size) override;
+  void WriteVectored(absl::Span<const Chunk> chunks) override;
+  void Close() override;
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed) override;
+
+  // Forwards any buffered data to the wrapped writer.
+  void Flush();
+
+ private:
+  std::unique_ptr<OutputWriterInterface> writer_;
+  const size_t flush_size_;
+  std::vector<char> buffer_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_BUFFERED_OUTPUT_WRITER_H_
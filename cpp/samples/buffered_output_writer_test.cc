@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/buffered_output_writer.h"
+
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "cpp/samples/testing/mock_output_writer.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::InSequence;
+
+TEST(BufferedOutputWriterTest, BuffersWritesUntilFlushSizeIsReached) {
+  auto mock_writer = std::make_unique<MockOutputWriter>();
+  std::string written;
+  EXPECT_CALL(*mock_writer, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written.append(content, size);
+      });
+  BufferedOutputWriter writer(std::move(mock_writer), /*flush_size=*/4);
+
+  writer.Write("ab", 2);
+  writer.Write("cd", 2);
+  EXPECT_EQ(written, "");
+  // Exceeds the flush size, so "abcd" is flushed and "ef" is buffered.
+  writer.Write("ef", 2);
+  EXPECT_EQ(written, "abcd");
+}
+
+TEST(BufferedOutputWriterTest, ForwardsLargeWritesDirectly) {
+  auto mock_writer = std::make_unique<MockOutputWriter>();
+  std::string written;
+  EXPECT_CALL(*mock_writer, Write(_, _))
+      .Times(2)
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written.append(content, size);
+        written.append("|");
+      });
+  BufferedOutputWriter writer(std::move(mock_writer), /*flush_size=*/4);
+
+  writer.Write("a", 1);
+  writer.Write("bcdef", 5);
+
+  EXPECT_EQ(written, "a|bcdef|");
+}
+
+TEST(BufferedOutputWriterTest, BuffersSmallVectoredWrites) {
+  auto mock_writer = std::make_unique<MockOutputWriter>();
+  std::string written;
+  EXPECT_CALL(*mock_writer, Write(_, _))
+      .WillOnce([&](const char* content, std::streamsize size) {
+        written.append(content, size);
+      });
+  BufferedOutputWriter writer(std::move(mock_writer), /*flush_size=*/8);
+  std::vector<OutputWriterInterface::Chunk> chunks = {{"ab", 2}, {"cd", 2}};
+
+  writer.WriteVectored(chunks);
+  EXPECT_EQ(written, "");
+  writer.Flush();
+
+  EXPECT_EQ(written, "abcd");
+}
+
+TEST(BufferedOutputWriterTest, CloseFlushesBeforeClosing) {
+  auto mock_writer = std::make_unique<MockOutputWriter>();
+  {
+    InSequence sequence;
+    EXPECT_CALL(*mock_writer, Write(_, 2));
+    EXPECT_CALL(*mock_writer, Close);
+  }
+  BufferedOutputWriter writer(std::move(mock_writer), /*flush_size=*/4);
+
+  writer.Write("ab", 2);
+  writer.Close();
+}
+
+TEST(BufferedOutputWriterTest, DestructorFlushesBufferedData) {
+  auto mock_writer = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*mock_writer, Write(_, 2));
+  auto writer = std::make_unique<BufferedOutputWriter>(std::move(mock_writer),
+                                                       /*flush_size=*/4);
+
+  writer->Write("ab", 2);
+  writer.reset();
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,369 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/conference_host.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_factory_interface.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/api/video_assignment_resource.h"
+#include "cpp/samples/async_output_writer.h"
+#include "cpp/samples/memory_account.h"
+#include "cpp/samples/multi_user_media_collector.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/units/time_delta.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+constexpr uint32_t kOutputWriterThreadCount = 4;
+constexpr int64_t kVideoAssignmentRequestId = 1;
+constexpr int64_t kLeaveRequestId = 2;
+
+absl::StatusOr<std::unique_ptr<rtc::Thread>> StartThread(
+    absl::string_view name) {
+  std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+  thread->SetName(name, nullptr);
+  if (!thread->Start()) {
+    return absl::InternalError(absl::StrCat("Failed to start ", name));
+  }
+  return thread;
+}
+
+// Requests a canvas of 100px x 100px for each received video stream, and lets
+// the backend choose which streams are relevant to send.
+meet::VideoAssignmentChannelFromClient CreateVideoAssignmentRequest(
+    int canvas_count) {
+  std::vector<meet::VideoCanvas> canvases;
+  for (int i = 1; i <= canvas_count; ++i) {
+    canvases.push_back(meet::VideoCanvas{
+        .id = i,
+        .dimensions = {.height = 100, .width = 100},
+        .assignment_protocol = meet::VideoCanvas::AssignmentProtocol::kRelevant,
+    });
+  }
+  return meet::VideoAssignmentChannelFromClient{
+      .request = {
+          .request_id = kVideoAssignmentRequestId,
+          .set_video_assignment_request = meet::SetVideoAssignmentRequest{
+              .layout_model =
+                  meet::LayoutModel{.label = "conference_host_layout",
+                                    .canvases = std::move(canvases)},
+              .video_resolution = meet::VideoResolution{
+                  .height = 400,
+                  .width = 400,
+                  .frame_rate = 30,
+              }}}};
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ConferenceHost>> ConferenceHost::Create(
+    ConferenceHostOptions options,
+    std::unique_ptr<meet::MediaApiClientFactoryInterface> client_factory) {
+  if (options.output_file_prefix.empty()) {
+    return absl::InvalidArgumentError("Output file prefix is empty");
+  }
+  if (options.meet_api_url.empty()) {
+    return absl::InvalidArgumentError("Meet API URL is empty");
+  }
+  if (options.collector_shard_count < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Collector shard count must not be negative; got ",
+                     options.collector_shard_count));
+  }
+  if (client_factory == nullptr) {
+    return absl::InvalidArgumentError("Client factory is null");
+  }
+
+  absl::StatusOr<std::unique_ptr<rtc::Thread>> control_thread =
+      StartThread("conference_host_control_thread");
+  if (!control_thread.ok()) {
+    return control_thread.status();
+  }
+  absl::StatusOr<std::unique_ptr<rtc::Thread>> collector_thread =
+      StartThread("collector_thread");
+  if (!collector_thread.ok()) {
+    return collector_thread.status();
+  }
+  std::vector<std::unique_ptr<rtc::Thread>> shard_threads;
+  for (int i = 0; i < options.collector_shard_count; ++i) {
+    absl::StatusOr<std::unique_ptr<rtc::Thread>> shard_thread =
+        StartThread(absl::StrCat("collector_shard_thread_", i));
+    if (!shard_thread.ok()) {
+      return shard_thread.status();
+    }
+    shard_threads.push_back(*std::move(shard_thread));
+  }
+  absl::StatusOr<std::unique_ptr<OutputWriterThreadPool>>
+      output_writer_threads =
+          OutputWriterThreadPool::Create(kOutputWriterThreadCount);
+  if (!output_writer_threads.ok()) {
+    return output_writer_threads.status();
+  }
+
+  auto host = absl::WrapUnique(new ConferenceHost(
+      std::move(options), std::move(client_factory),
+      *std::move(control_thread), *std::move(collector_thread),
+      std::move(shard_threads), *std::move(output_writer_threads)));
+  host->control_thread_->PostTask([host = host.get()] { host->Poll(); });
+  return host;
+}
+
+ConferenceHost::ConferenceHost(
+    ConferenceHostOptions options,
+    std::unique_ptr<meet::MediaApiClientFactoryInterface> client_factory,
+    std::unique_ptr<rtc::Thread> control_thread,
+    std::unique_ptr<rtc::Thread> collector_thread,
+    std::vector<std::unique_ptr<rtc::Thread>> shard_threads,
+    std::unique_ptr<OutputWriterThreadPool> output_writer_threads)
+    : options_(std::move(options)),
+      client_factory_(std::move(client_factory)),
+      collector_thread_(std::move(collector_thread)),
+      shard_threads_(std::move(shard_threads)),
+      output_writer_threads_(std::move(output_writer_threads)),
+      control_thread_(std::move(control_thread)) {}
+
+ConferenceHost::~ConferenceHost() {
+  control_thread_->BlockingCall([this] {
+    shutting_down_ = true;
+    for (auto& [meeting_space_id, conference] : conferences_) {
+      LeaveConference(meeting_space_id, conference);
+    }
+  });
+  // Polling keeps releasing conferences as they disconnect.
+  while (!control_thread_->BlockingCall([this] {
+    return conferences_.empty();
+  })) {
+    absl::SleepFor(options_.poll_interval);
+  }
+  control_thread_->Stop();
+
+  // Collectors have been released, so nothing else is posted to the shared
+  // threads. Output writer and shard threads post tasks to the collector
+  // thread, so they are stopped first.
+  output_writer_threads_->Stop();
+  for (std::unique_ptr<rtc::Thread>& shard_thread : shard_threads_) {
+    shard_thread->Stop();
+  }
+  collector_thread_->Stop();
+}
+
+absl::Status ConferenceHost::Join(absl::string_view meeting_space_id,
+                                  absl::string_view oauth_token,
+                                  absl::Duration collection_duration) {
+  if (meeting_space_id.empty()) {
+    return absl::InvalidArgumentError("Meeting space ID is empty");
+  }
+  if (oauth_token.empty()) {
+    return absl::InvalidArgumentError("OAuth token is empty");
+  }
+
+  return control_thread_->BlockingCall([&]() -> absl::Status {
+    if (shutting_down_) {
+      return absl::FailedPreconditionError("Conference host is shutting down");
+    }
+    if (conferences_.contains(meeting_space_id)) {
+      return absl::AlreadyExistsError(
+          absl::StrCat("Already hosting conference ", meeting_space_id));
+    }
+
+    std::vector<rtc::Thread*> shard_threads;
+    for (std::unique_ptr<rtc::Thread>& shard_thread : shard_threads_) {
+      shard_threads.push_back(shard_thread.get());
+    }
+    Conference conference = {
+        .collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+            absl::StrCat(options_.output_file_prefix, meeting_space_id, "_"),
+            options_.segment_gap_threshold, collector_thread_.get(),
+            std::move(shard_threads), output_writer_threads_.get(),
+            options_.event_log_format),
+        .collection_duration = collection_duration,
+    };
+    conference.collector->SetMemoryBudget(
+        options_.conference_memory_budget_bytes);
+    absl::StatusOr<std::unique_ptr<meet::MediaApiClientInterface>> client =
+        client_factory_->CreateMediaApiClient(options_.client_config,
+                                              conference.collector);
+    if (!client.ok()) {
+      return client.status();
+    }
+    conference.client = *std::move(client);
+
+    if (absl::Status status = conference.client->ConnectActiveConference(
+            options_.meet_api_url, meeting_space_id, oauth_token);
+        !status.ok()) {
+      return status;
+    }
+    conference.connected_at = absl::Now();
+    LOG(INFO) << "Connecting to conference " << meeting_space_id;
+    conferences_.emplace(meeting_space_id, std::move(conference));
+    return absl::OkStatus();
+  });
+}
+
+absl::Status ConferenceHost::Leave(absl::string_view meeting_space_id) {
+  return control_thread_->BlockingCall([&]() -> absl::Status {
+    auto it = conferences_.find(meeting_space_id);
+    if (it == conferences_.end()) {
+      return absl::NotFoundError(
+          absl::StrCat("Not hosting conference ", meeting_space_id));
+    }
+    LeaveConference(it->first, it->second);
+    return absl::OkStatus();
+  });
+}
+
+std::vector<std::string> ConferenceHost::GetActiveConferences() {
+  return control_thread_->BlockingCall([this] {
+    std::vector<std::string> meeting_space_ids;
+    for (const auto& [meeting_space_id, conference] : conferences_) {
+      meeting_space_ids.push_back(meeting_space_id);
+    }
+    return meeting_space_ids;
+  });
+}
+
+void ConferenceHost::Poll() {
+  absl::Time now = absl::Now();
+  std::vector<rtc::scoped_refptr<MultiUserMediaCollector>>
+      disconnected_collectors;
+  std::vector<std::unique_ptr<meet::MediaApiClientInterface>>
+      disconnected_clients;
+  for (auto it = conferences_.begin(); it != conferences_.end();) {
+    const std::string& meeting_space_id = it->first;
+    Conference& conference = it->second;
+
+    if (conference.collector->WaitForDisconnected(absl::ZeroDuration()).ok()) {
+      LOG(INFO) << "Disconnected from conference " << meeting_space_id;
+      disconnected_collectors.push_back(std::move(conference.collector));
+      disconnected_clients.push_back(std::move(conference.client));
+      conferences_.erase(it++);
+      continue;
+    }
+
+    if (!conference.joined_at.has_value() &&
+        conference.collector->WaitForJoined(absl::ZeroDuration()).ok()) {
+      LOG(INFO) << "Joined conference " << meeting_space_id;
+      conference.joined_at = now;
+      if (options_.client_config.receiving_video_stream_count > 0 &&
+          !conference.left) {
+        if (absl::Status status =
+                conference.client->SendRequest(CreateVideoAssignmentRequest(
+                    options_.client_config.receiving_video_stream_count));
+            !status.ok()) {
+          LOG(ERROR) << "Failed to send video assignment request to "
+                     << meeting_space_id << ": " << status;
+        }
+      }
+    }
+
+    EnforceMemoryBudget(meeting_space_id, conference);
+
+    if (conference.joined_at.has_value()) {
+      if (now - *conference.joined_at >= conference.collection_duration) {
+        LeaveConference(meeting_space_id, conference);
+      }
+    } else if (now - conference.connected_at >= options_.join_timeout) {
+      LOG(ERROR) << "Timed out joining conference " << meeting_space_id;
+      LeaveConference(meeting_space_id, conference);
+    }
+    ++it;
+  }
+  // Conferences often end in waves, so their clients are shut down together
+  // rather than one after another. The clients are destroyed first, since the
+  // collectors may only be released once no more callbacks can reach them.
+  if (!disconnected_clients.empty()) {
+    client_factory_->ShutdownMediaApiClients(std::move(disconnected_clients));
+  }
+  disconnected_collectors.clear();
+
+  control_thread_->PostDelayedTask(
+      [this] { Poll(); }, webrtc::TimeDelta::Micros(absl::ToInt64Microseconds(
+                              options_.poll_interval)));
+}
+
+void ConferenceHost::EnforceMemoryBudget(absl::string_view meeting_space_id,
+                                         Conference& conference) {
+  size_t budget = options_.conference_memory_budget_bytes;
+  if (budget == 0 || conference.left) {
+    return;
+  }
+
+  MemoryUsage usage = conference.collector->GetMemoryUsage();
+  if (usage.total_bytes() > budget) {
+    // Closing idle segments releases their writers without changing what is
+    // written, so it is done on every poll while over budget.
+    conference.collector->CloseIdleSegments();
+    if (conference.memory_degraded) {
+      return;
+    }
+    LOG(WARNING) << "Conference " << meeting_space_id << " is over its memory "
+                 << "budget of " << budget << " bytes, degrading video: "
+                 << usage.queued_audio_bytes << " bytes of queued audio, "
+                 << usage.queued_video_bytes << " bytes of queued video, "
+                 << usage.open_segment_bytes << " bytes of open segments";
+    if (absl::Status status = conference.client->SetVideoSinkConstraints(
+            options_.degraded_video_sink_constraints);
+        !status.ok()) {
+      LOG(ERROR) << "Failed to degrade video of " << meeting_space_id << ": "
+                 << status;
+    }
+    conference.memory_degraded = true;
+  } else if (conference.memory_degraded && usage.total_bytes() < budget / 2) {
+    LOG(INFO) << "Conference " << meeting_space_id
+              << " is back under its memory budget, restoring video";
+    if (absl::Status status = conference.client->SetVideoSinkConstraints(
+            options_.client_config.video_sink_constraints);
+        !status.ok()) {
+      LOG(ERROR) << "Failed to restore video of " << meeting_space_id << ": "
+                 << status;
+    }
+    conference.memory_degraded = false;
+  }
+}
+
+void ConferenceHost::LeaveConference(absl::string_view meeting_space_id,
+                                     Conference& conference) {
+  if (conference.left) {
+    return;
+  }
+  conference.left = true;
+  if (absl::Status status = conference.client->LeaveConference(kLeaveRequestId);
+      !status.ok()) {
+    LOG(ERROR) << "Failed to leave conference " << meeting_space_id << ": "
+               << status;
+    return;
+  }
+  LOG(INFO) << "Sent leave request to " << meeting_space_id;
+}
+
+}  // namespace media_api_samples
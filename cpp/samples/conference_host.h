@@ -0,0 +1,167 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_CONFERENCE_HOST_H_
+#define CPP_SAMPLES_CONFERENCE_HOST_H_
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_factory_interface.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/samples/async_output_writer.h"
+#include "cpp/samples/multi_user_media_collector.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+
+struct ConferenceHostOptions {
+  // Directory and file prefix of the output files. Each conference's files
+  // are written with the prefix `<output_file_prefix><meeting_space_id>_`.
+  std::string output_file_prefix;
+  std::string meet_api_url;
+  // See `MultiUserMediaCollector`.
+  absl::Duration segment_gap_threshold = absl::Seconds(1);
+  EventLogFormat event_log_format = EventLogFormat::kCsv;
+  // The number of collector threads that media segments of all conferences
+  // are partitioned across. If 0, all segments are written on the collector
+  // thread.
+  int collector_shard_count = 0;
+  // How long a conference may take to be joined before it is left.
+  absl::Duration join_timeout = absl::Minutes(2);
+  // How often the host checks whether conferences have joined, should be
+  // left, or have disconnected.
+  absl::Duration poll_interval = absl::Milliseconds(100);
+  meet::MediaApiClientConfiguration client_config = {
+      .receiving_video_stream_count = 3,
+      .enable_audio_streams = true,
+  };
+  // If non-zero, the memory that each conference's collector may hold for
+  // queued frames and open segments; see
+  // `MultiUserMediaCollector::SetMemoryBudget`. Once a conference is over
+  // budget, its collector drops video, its client is asked for video with
+  // `degraded_video_sink_constraints`, and its idle segments are closed. The
+  // client's constraints are restored once usage falls below half the budget.
+  size_t conference_memory_budget_bytes = 0;
+  meet::VideoSinkConstraints degraded_video_sink_constraints = {
+      .max_pixel_count = 320 * 180,
+      .max_framerate_fps = 10,
+  };
+};
+
+// Collects media from many conferences in a single process.
+//
+// Running one sample process per conference duplicates the WebRTC threads and
+// globals of every client. Instead, the host creates all clients from one
+// factory, which should share peer connection contexts between them (see
+// `meet::MediaApiClientFactory::SharedContextConfiguration`), and writes all
+// conferences' media on one set of collector and output writer threads.
+//
+// Each conference still has its own client and `MultiUserMediaCollector`, so
+// conferences only observe their own callbacks and write their own files.
+//
+// Conferences are joined and left on the host's control thread. Once joined,
+// a conference's video assignment is sent, and the conference is left once
+// its collection duration has passed. Disconnected conferences are released.
+class ConferenceHost {
+ public:
+  // `client_factory` should share contexts between its clients.
+  static absl::StatusOr<std::unique_ptr<ConferenceHost>> Create(
+      ConferenceHostOptions options,
+      std::unique_ptr<meet::MediaApiClientFactoryInterface> client_factory);
+
+  // Leaves all conferences and waits for them to disconnect.
+  ~ConferenceHost();
+
+  // ConferenceHost is neither copyable nor movable.
+  ConferenceHost(const ConferenceHost&) = delete;
+  ConferenceHost& operator=(const ConferenceHost&) = delete;
+
+  // Creates a client for the conference and starts connecting to it. Media is
+  // collected for `collection_duration` once the conference is joined.
+  //
+  // Returns an error if the host already has a conference with the same ID,
+  // or if the client cannot be created or started.
+  absl::Status Join(absl::string_view meeting_space_id,
+                    absl::string_view oauth_token,
+                    absl::Duration collection_duration);
+  // Leaves the conference before its collection duration has passed.
+  absl::Status Leave(absl::string_view meeting_space_id);
+
+  // Returns the IDs of conferences that have not disconnected yet.
+  std::vector<std::string> GetActiveConferences();
+
+ private:
+  struct Conference {
+    rtc::scoped_refptr<MultiUserMediaCollector> collector;
+    std::unique_ptr<meet::MediaApiClientInterface> client;
+    absl::Duration collection_duration;
+    absl::Time connected_at;
+    std::optional<absl::Time> joined_at;
+    bool left = false;
+    // Whether the client's video is degraded for being over the memory budget.
+    bool memory_degraded = false;
+  };
+
+  ConferenceHost(ConferenceHostOptions options,
+                 std::unique_ptr<meet::MediaApiClientFactoryInterface>
+                     client_factory,
+                 std::unique_ptr<rtc::Thread> control_thread,
+                 std::unique_ptr<rtc::Thread> collector_thread,
+                 std::vector<std::unique_ptr<rtc::Thread>> shard_threads,
+                 std::unique_ptr<OutputWriterThreadPool> output_writer_threads);
+
+  // Advances every conference, then schedules the next poll. Runs on the
+  // control thread.
+  void Poll();
+  // Degrades or restores the conference's video according to its collector's
+  // memory usage.
+  void EnforceMemoryBudget(absl::string_view meeting_space_id,
+                           Conference& conference);
+  // Leaves the conference if it has not been left yet.
+  void LeaveConference(absl::string_view meeting_space_id,
+                       Conference& conference);
+
+  const ConferenceHostOptions options_;
+  std::unique_ptr<meet::MediaApiClientFactoryInterface> client_factory_;
+
+  // Threads shared by the collectors of all conferences. Declared before the
+  // conferences so that they outlive the collectors.
+  std::unique_ptr<rtc::Thread> collector_thread_;
+  std::vector<std::unique_ptr<rtc::Thread>> shard_threads_;
+  std::unique_ptr<OutputWriterThreadPool> output_writer_threads_;
+
+  // Conferences by meeting space ID. Only accessed on the control thread.
+  absl::flat_hash_map<std::string, Conference> conferences_;
+  // Whether the host is being destroyed. Only accessed on the control thread.
+  bool shutting_down_ = false;
+
+  // Serializes joining, leaving and polling conferences.
+  std::unique_ptr<rtc::Thread> control_thread_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_CONFERENCE_HOST_H_
@@ -0,0 +1,328 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/conference_host.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_factory_interface.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/api/video_assignment_resource.h"
+#include "webrtc/api/scoped_refptr.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::UnorderedElementsAre;
+using ::testing::status::StatusIs;
+
+class MockMediaApiClient : public meet::MediaApiClientInterface {
+ public:
+  MOCK_METHOD(absl::Status, ConnectActiveConference,
+              (absl::string_view, absl::string_view, absl::string_view),
+              (override));
+  MOCK_METHOD(absl::Status, LeaveConference, (int64_t), (override));
+  MOCK_METHOD(absl::Status, SendRequest, (const meet::ResourceRequest&),
+              (override));
+  MOCK_METHOD(meet::MediaApiClientMetrics, GetMetrics, (),
+              (const, override));
+  MOCK_METHOD(
+      absl::StatusOr<rtc::scoped_refptr<const webrtc::RTCStatsReport>>,
+      GetStatsReport, (absl::Duration), (override));
+  MOCK_METHOD(void, GetStatsReport,
+              (absl::Duration, StatsReportCallback), (override));
+  MOCK_METHOD(absl::Status, SetVideoSinkConstraints,
+              (meet::VideoSinkConstraints), (override));
+  MOCK_METHOD(void, PauseMedia, (meet::MediaKind), (override));
+  MOCK_METHOD(void, ResumeMedia, (meet::MediaKind), (override));
+  MOCK_METHOD(void, PauseTrack, (absl::string_view), (override));
+  MOCK_METHOD(void, ResumeTrack, (absl::string_view), (override));
+  MOCK_METHOD(void, Shutdown, (absl::AnyInvocable<void() &&>), (override));
+};
+
+class MockMediaApiClientFactory : public meet::MediaApiClientFactoryInterface {
+ public:
+  MOCK_METHOD(absl::StatusOr<std::unique_ptr<meet::MediaApiClientInterface>>,
+              CreateMediaApiClient,
+              (const meet::MediaApiClientConfiguration&,
+               rtc::scoped_refptr<meet::MediaApiClientObserverInterface>),
+              (override));
+};
+
+ConferenceHostOptions CreateOptions() {
+  return {
+      .output_file_prefix = ::testing::TempDir() + "/conference_host_test_",
+      .meet_api_url = "https://meet.googleapis.com",
+      .poll_interval = absl::Milliseconds(1),
+  };
+}
+
+// Returns a client that reports to `observer` as the test drives it:
+// connecting succeeds, and leaving disconnects.
+std::unique_ptr<MockMediaApiClient> CreateClient(
+    rtc::scoped_refptr<meet::MediaApiClientObserverInterface> observer) {
+  auto client = std::make_unique<NiceMock<MockMediaApiClient>>();
+  ON_CALL(*client, ConnectActiveConference)
+      .WillByDefault(Return(absl::OkStatus()));
+  ON_CALL(*client, SendRequest).WillByDefault(Return(absl::OkStatus()));
+  ON_CALL(*client, LeaveConference).WillByDefault([observer](int64_t) {
+    observer->OnDisconnected(absl::OkStatus());
+    return absl::OkStatus();
+  });
+  ON_CALL(*client, Shutdown)
+      .WillByDefault([](absl::AnyInvocable<void() &&> on_shut_down) {
+        std::move(on_shut_down)();
+      });
+  return client;
+}
+
+void WaitForNoActiveConferences(ConferenceHost& host) {
+  absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (!host.GetActiveConferences().empty() && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+}
+
+TEST(ConferenceHostTest, CreateFailsWithEmptyOutputFilePrefix) {
+  ConferenceHostOptions options = CreateOptions();
+  options.output_file_prefix = "";
+
+  EXPECT_THAT(ConferenceHost::Create(
+                  std::move(options),
+                  std::make_unique<MockMediaApiClientFactory>()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Output file prefix is empty"));
+}
+
+TEST(ConferenceHostTest, CreateFailsWithNegativeShardCount) {
+  ConferenceHostOptions options = CreateOptions();
+  options.collector_shard_count = -1;
+
+  EXPECT_THAT(ConferenceHost::Create(
+                  std::move(options),
+                  std::make_unique<MockMediaApiClientFactory>()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Collector shard count must not be negative; got -1"));
+}
+
+TEST(ConferenceHostTest, JoinConnectsClientToConference) {
+  auto factory = std::make_unique<MockMediaApiClientFactory>();
+  EXPECT_CALL(*factory, CreateMediaApiClient)
+      .WillOnce([](const meet::MediaApiClientConfiguration&,
+                   rtc::scoped_refptr<meet::MediaApiClientObserverInterface>
+                       observer) {
+        std::unique_ptr<MockMediaApiClient> client = CreateClient(observer);
+        EXPECT_CALL(*client,
+                    ConnectActiveConference("https://meet.googleapis.com",
+                                            "space1", "token1"));
+        return client;
+      });
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host =
+      ConferenceHost::Create(CreateOptions(), std::move(factory));
+  ASSERT_OK(host);
+
+  EXPECT_OK((*host)->Join("space1", "token1", absl::Minutes(1)));
+  EXPECT_THAT((*host)->GetActiveConferences(), ElementsAre("space1"));
+}
+
+TEST(ConferenceHostTest, JoinFailsForDuplicateConference) {
+  auto factory = std::make_unique<MockMediaApiClientFactory>();
+  EXPECT_CALL(*factory, CreateMediaApiClient)
+      .WillOnce([](const meet::MediaApiClientConfiguration&,
+                   rtc::scoped_refptr<meet::MediaApiClientObserverInterface>
+                       observer) { return CreateClient(observer); });
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host =
+      ConferenceHost::Create(CreateOptions(), std::move(factory));
+  ASSERT_OK(host);
+  ASSERT_OK((*host)->Join("space1", "token1", absl::Minutes(1)));
+
+  EXPECT_THAT((*host)->Join("space1", "token2", absl::Minutes(1)),
+              StatusIs(absl::StatusCode::kAlreadyExists,
+                       "Already hosting conference space1"));
+}
+
+TEST(ConferenceHostTest, JoinFailsIfClientCannotBeCreated) {
+  auto factory = std::make_unique<MockMediaApiClientFactory>();
+  EXPECT_CALL(*factory, CreateMediaApiClient)
+      .WillOnce(Return(absl::InternalError("Failed to create client")));
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host =
+      ConferenceHost::Create(CreateOptions(), std::move(factory));
+  ASSERT_OK(host);
+
+  EXPECT_THAT((*host)->Join("space1", "token1", absl::Minutes(1)),
+              StatusIs(absl::StatusCode::kInternal, "Failed to create client"));
+  EXPECT_THAT((*host)->GetActiveConferences(), IsEmpty());
+}
+
+TEST(ConferenceHostTest, ConferencesHaveSeparateObservers) {
+  meet::MediaApiClientObserverInterface* observer1 = nullptr;
+  meet::MediaApiClientObserverInterface* observer2 = nullptr;
+  auto factory = std::make_unique<MockMediaApiClientFactory>();
+  EXPECT_CALL(*factory, CreateMediaApiClient)
+      .WillOnce([&](const meet::MediaApiClientConfiguration&,
+                    rtc::scoped_refptr<meet::MediaApiClientObserverInterface>
+                        observer) {
+        observer1 = observer.get();
+        return CreateClient(observer);
+      })
+      .WillOnce([&](const meet::MediaApiClientConfiguration&,
+                    rtc::scoped_refptr<meet::MediaApiClientObserverInterface>
+                        observer) {
+        observer2 = observer.get();
+        return CreateClient(observer);
+      });
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host =
+      ConferenceHost::Create(CreateOptions(), std::move(factory));
+  ASSERT_OK(host);
+  ASSERT_OK((*host)->Join("space1", "token1", absl::Minutes(1)));
+  ASSERT_OK((*host)->Join("space2", "token2", absl::Minutes(1)));
+
+  EXPECT_NE(observer1, observer2);
+  EXPECT_THAT((*host)->GetActiveConferences(),
+              UnorderedElementsAre("space1", "space2"));
+}
+
+TEST(ConferenceHostTest, SendsVideoAssignmentOnceJoined) {
+  absl::Notification sent_video_assignment;
+  // Not retained, since collectors must be released before the host.
+  meet::MediaApiClientObserverInterface* observer = nullptr;
+  auto factory = std::make_unique<MockMediaApiClientFactory>();
+  EXPECT_CALL(*factory, CreateMediaApiClient)
+      .WillOnce([&](const meet::MediaApiClientConfiguration&,
+                    rtc::scoped_refptr<meet::MediaApiClientObserverInterface>
+                        client_observer) {
+        observer = client_observer.get();
+        std::unique_ptr<MockMediaApiClient> client =
+            CreateClient(client_observer);
+        EXPECT_CALL(*client, SendRequest)
+            .WillOnce([&](const meet::ResourceRequest& request) {
+              const auto& video_assignment =
+                  std::get<meet::VideoAssignmentChannelFromClient>(request);
+              EXPECT_EQ(video_assignment.request.set_video_assignment_request
+                            ->layout_model.canvases.size(),
+                        3);
+              sent_video_assignment.Notify();
+              return absl::OkStatus();
+            });
+        return client;
+      });
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host =
+      ConferenceHost::Create(CreateOptions(), std::move(factory));
+  ASSERT_OK(host);
+  ASSERT_OK((*host)->Join("space1", "token1", absl::Minutes(1)));
+
+  observer->OnJoined();
+
+  EXPECT_TRUE(
+      sent_video_assignment.WaitForNotificationWithTimeout(absl::Seconds(10)));
+}
+
+TEST(ConferenceHostTest, LeavesAndReleasesConferenceAfterCollectionDuration) {
+  // Not retained, since collectors must be released before the host.
+  meet::MediaApiClientObserverInterface* observer = nullptr;
+  auto factory = std::make_unique<MockMediaApiClientFactory>();
+  EXPECT_CALL(*factory, CreateMediaApiClient)
+      .WillOnce([&](const meet::MediaApiClientConfiguration&,
+                    rtc::scoped_refptr<meet::MediaApiClientObserverInterface>
+                        client_observer) {
+        observer = client_observer.get();
+        std::unique_ptr<MockMediaApiClient> client =
+            CreateClient(client_observer);
+        EXPECT_CALL(*client, LeaveConference(_));
+        EXPECT_CALL(*client, Shutdown);
+        return client;
+      });
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host =
+      ConferenceHost::Create(CreateOptions(), std::move(factory));
+  ASSERT_OK(host);
+  ASSERT_OK((*host)->Join("space1", "token1", absl::ZeroDuration()));
+
+  observer->OnJoined();
+  WaitForNoActiveConferences(**host);
+
+  EXPECT_THAT((*host)->GetActiveConferences(), IsEmpty());
+}
+
+TEST(ConferenceHostTest, LeavesConferenceThatTimesOutJoining) {
+  auto factory = std::make_unique<MockMediaApiClientFactory>();
+  EXPECT_CALL(*factory, CreateMediaApiClient)
+      .WillOnce([](const meet::MediaApiClientConfiguration&,
+                   rtc::scoped_refptr<meet::MediaApiClientObserverInterface>
+                       observer) {
+        std::unique_ptr<MockMediaApiClient> client = CreateClient(observer);
+        EXPECT_CALL(*client, LeaveConference(_));
+        return client;
+      });
+  ConferenceHostOptions options = CreateOptions();
+  options.join_timeout = absl::ZeroDuration();
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host =
+      ConferenceHost::Create(std::move(options), std::move(factory));
+  ASSERT_OK(host);
+  ASSERT_OK((*host)->Join("space1", "token1", absl::Minutes(1)));
+
+  WaitForNoActiveConferences(**host);
+
+  EXPECT_THAT((*host)->GetActiveConferences(), IsEmpty());
+}
+
+TEST(ConferenceHostTest, LeaveFailsForUnknownConference) {
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host = ConferenceHost::Create(
+      CreateOptions(), std::make_unique<MockMediaApiClientFactory>());
+  ASSERT_OK(host);
+
+  EXPECT_THAT((*host)->Leave("space1"),
+              StatusIs(absl::StatusCode::kNotFound,
+                       "Not hosting conference space1"));
+}
+
+TEST(ConferenceHostTest, DestructorLeavesActiveConferences) {
+  auto factory = std::make_unique<MockMediaApiClientFactory>();
+  EXPECT_CALL(*factory, CreateMediaApiClient)
+      .WillOnce([](const meet::MediaApiClientConfiguration&,
+                   rtc::scoped_refptr<meet::MediaApiClientObserverInterface>
+                       observer) {
+        std::unique_ptr<MockMediaApiClient> client = CreateClient(observer);
+        EXPECT_CALL(*client, LeaveConference(_));
+        return client;
+      });
+  absl::StatusOr<std::unique_ptr<ConferenceHost>> host =
+      ConferenceHost::Create(CreateOptions(), std::move(factory));
+  ASSERT_OK(host);
+  ASSERT_OK((*host)->Join("space1", "token1", absl::Minutes(1)));
+
+  host->reset();
+}
+
+}  // namespace
+}  // namespace media_api_samples
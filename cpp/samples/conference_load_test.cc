@@ -0,0 +1,338 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Simulates a conference of many participants sending audio and video at real
+// rates into a `MultiUserMediaCollector`, and reports the collector's
+// throughput, callback latencies, allocations and CPU use. Run it before and
+// after a change to catch collector and output writer regressions.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/api/media_entries_resource.h"
+#include "cpp/api/participants_resource.h"
+#include "cpp/samples/frame_queue.h"
+#include "cpp/samples/multi_user_media_collector.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/rtc_base/thread.h"
+
+ABSL_FLAG(int, participants, 100, "The number of simulated participants.");
+
+ABSL_FLAG(int, video_participants, 3,
+          "The number of participants that also send video. Meet servers send "
+          "as many video streams as the client requests.");
+
+ABSL_FLAG(absl::Duration, duration, absl::Seconds(10),
+          "How long to send media for.");
+
+ABSL_FLAG(int, video_width, 320, "The width of simulated video frames.");
+
+ABSL_FLAG(int, video_height, 180, "The height of simulated video frames.");
+
+ABSL_FLAG(int, video_frame_rate, 30,
+          "The frame rate of each simulated video stream.");
+
+ABSL_FLAG(std::string, output_file_prefix, "/tmp/load_test_output_",
+          "The prefix of the files written by the collector.");
+
+ABSL_FLAG(int, collector_shard_count, 0,
+          "The number of threads to write media on. If zero, media is "
+          "written on the collector thread.");
+
+namespace {
+
+// Counts every allocation made through the global `operator new`, so that the
+// allocations made per frame can be reported.
+std::atomic<uint64_t> allocation_count{0};
+
+constexpr int kAudioSampleRate = 48000;
+constexpr absl::Duration kAudioFrameDuration = absl::Milliseconds(10);
+constexpr int kAudioSamplesPerFrame = kAudioSampleRate / 100;
+// Video CSRCs are offset from audio CSRCs so that the two never collide.
+constexpr uint32_t kVideoCsrcOffset = 1'000'000;
+
+// Per-callback delivery latencies, in nanoseconds.
+struct LatencyRecorder {
+  std::vector<int64_t> latencies_ns;
+
+  void Record(absl::Duration latency) {
+    latencies_ns.push_back(absl::ToInt64Nanoseconds(latency));
+  }
+
+  absl::Duration Percentile(double percentile) {
+    if (latencies_ns.empty()) {
+      return absl::ZeroDuration();
+    }
+    size_t index = std::min(
+        latencies_ns.size() - 1,
+        static_cast<size_t>(percentile / 100 * latencies_ns.size()));
+    std::nth_element(latencies_ns.begin(), latencies_ns.begin() + index,
+                     latencies_ns.end());
+    return absl::Nanoseconds(latencies_ns[index]);
+  }
+};
+
+absl::Duration CpuTime() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return absl::DurationFromTimeval(usage.ru_utime) +
+         absl::DurationFromTimeval(usage.ru_stime);
+}
+
+void SendResources(media_api_samples::MultiUserMediaCollector& collector,
+                   int participant_count, int video_participant_count) {
+  meet::ParticipantsChannelToClient participants;
+  meet::MediaEntriesChannelToClient media_entries;
+  for (int i = 0; i < participant_count; ++i) {
+    std::string participant_key = absl::StrCat("participants/p", i);
+    participants.resources.push_back(meet::ParticipantResourceSnapshot{
+        .id = i,
+        .participant = meet::Participant{
+            .participant_key = participant_key,
+            .type = meet::Participant::Type::kAnonymousUser,
+            .anonymous_user = meet::AnonymousUser{
+                .display_name = absl::StrCat("participant_", i)}}});
+
+    meet::MediaEntry media_entry{
+        .participant_key = participant_key,
+        .session_name = absl::StrCat(participant_key, "/mediaEntries/m", i),
+        .audio_csrc = static_cast<uint32_t>(i + 1)};
+    if (i < video_participant_count) {
+      media_entry.video_csrcs.push_back(kVideoCsrcOffset + i + 1);
+    }
+    media_entries.resources.push_back(meet::MediaEntriesResourceSnapshot{
+        .id = i, .media_entry = std::move(media_entry)});
+  }
+  collector.OnResourceUpdate(std::move(participants));
+  collector.OnResourceUpdate(std::move(media_entries));
+}
+
+// Returns an I420 buffer filled with `value`. Alternating between buffers with
+// different contents keeps repeated-frame skipping from dropping frames.
+rtc::scoped_refptr<webrtc::I420Buffer> CreateVideoBuffer(int width, int height,
+                                                         uint8_t value) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(width, height);
+  std::memset(buffer->MutableDataY(), value, buffer->StrideY() * height);
+  std::memset(buffer->MutableDataU(), value,
+              buffer->StrideU() * ((height + 1) / 2));
+  std::memset(buffer->MutableDataV(), value,
+              buffer->StrideV() * ((height + 1) / 2));
+  return buffer;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size); ptr != nullptr) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size); ptr != nullptr) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+int main(int argc, char** argv) {
+  absl::SetProgramUsageMessage(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  const int participant_count = absl::GetFlag(FLAGS_participants);
+  const int video_participant_count =
+      std::min(absl::GetFlag(FLAGS_video_participants), participant_count);
+  const int video_frame_rate = absl::GetFlag(FLAGS_video_frame_rate);
+  if (participant_count <= 0 || video_participant_count < 0 ||
+      video_frame_rate <= 0) {
+    LOG(ERROR) << "Participant counts and the video frame rate must be "
+                  "positive";
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<rtc::Thread> collector_thread = rtc::Thread::Create();
+  collector_thread->SetName("collector_thread", nullptr);
+  if (!collector_thread->Start()) {
+    LOG(ERROR) << "Failed to start collector thread";
+    return EXIT_FAILURE;
+  }
+  std::vector<std::unique_ptr<rtc::Thread>> shard_threads;
+  for (int i = 0; i < absl::GetFlag(FLAGS_collector_shard_count); ++i) {
+    std::unique_ptr<rtc::Thread> shard_thread = rtc::Thread::Create();
+    shard_thread->SetName(absl::StrCat("collector_shard_thread_", i), nullptr);
+    if (!shard_thread->Start()) {
+      LOG(ERROR) << "Failed to start collector shard thread";
+      return EXIT_FAILURE;
+    }
+    shard_threads.push_back(std::move(shard_thread));
+  }
+  auto collector =
+      webrtc::make_ref_counted<media_api_samples::MultiUserMediaCollector>(
+          absl::GetFlag(FLAGS_output_file_prefix), absl::Seconds(1),
+          std::move(collector_thread), std::move(shard_threads));
+  collector->OnJoined();
+  SendResources(*collector, participant_count, video_participant_count);
+
+  // A tone, so that silence skipping does not drop the audio.
+  std::vector<int16_t> tone(kAudioSamplesPerFrame);
+  for (int i = 0; i < kAudioSamplesPerFrame; ++i) {
+    tone[i] = static_cast<int16_t>(
+        8000 * std::sin(2 * M_PI * 440 * i / kAudioSampleRate));
+  }
+  const int video_width = absl::GetFlag(FLAGS_video_width);
+  const int video_height = absl::GetFlag(FLAGS_video_height);
+  rtc::scoped_refptr<webrtc::I420Buffer> video_buffers[] = {
+      CreateVideoBuffer(video_width, video_height, 16),
+      CreateVideoBuffer(video_width, video_height, 235)};
+
+  LatencyRecorder audio_latencies;
+  LatencyRecorder video_latencies;
+  const absl::Duration video_frame_interval =
+      absl::Seconds(1) / video_frame_rate;
+  const absl::Duration duration = absl::GetFlag(FLAGS_duration);
+  uint64_t audio_frame_count = 0;
+  uint64_t video_frame_count = 0;
+  uint64_t media_bytes = 0;
+  absl::Duration max_tick_lag;
+
+  const absl::Duration cpu_start = CpuTime();
+  const uint64_t allocations_start = allocation_count.load();
+  const absl::Time start = absl::Now();
+  absl::Time next_video_time = start;
+  for (absl::Time tick = start; tick - start < duration;
+       tick += kAudioFrameDuration) {
+    if (absl::Duration wait = tick - absl::Now(); wait > absl::ZeroDuration()) {
+      absl::SleepFor(wait);
+    }
+    max_tick_lag = std::max(max_tick_lag, absl::Now() - tick);
+
+    for (int i = 0; i < participant_count; ++i) {
+      absl::Time delivery_start = absl::Now();
+      collector->OnAudioFrame(meet::AudioFrame{
+          .pcm16 = tone,
+          .bits_per_sample = 16,
+          .sample_rate = kAudioSampleRate,
+          .number_of_channels = 1,
+          .number_of_frames = tone.size(),
+          .is_from_loudest_speaker = false,
+          .contributing_source = static_cast<uint32_t>(i + 1),
+          .synchronization_source = static_cast<uint32_t>(i + 1),
+          .receive_time = delivery_start});
+      audio_latencies.Record(absl::Now() - delivery_start);
+    }
+    audio_frame_count += participant_count;
+    media_bytes += participant_count * tone.size() * sizeof(int16_t);
+
+    if (tick < next_video_time) {
+      continue;
+    }
+    next_video_time += video_frame_interval;
+    webrtc::VideoFrame frame =
+        webrtc::VideoFrame::Builder()
+            .set_video_frame_buffer(video_buffers[video_frame_count % 2])
+            .build();
+    for (int i = 0; i < video_participant_count; ++i) {
+      absl::Time delivery_start = absl::Now();
+      collector->OnVideoFrame(meet::VideoFrame{
+          .frame = frame,
+          .contributing_source = kVideoCsrcOffset + i + 1,
+          .synchronization_source = kVideoCsrcOffset + i + 1,
+          .receive_time = delivery_start});
+      video_latencies.Record(absl::Now() - delivery_start);
+    }
+    video_frame_count += video_participant_count;
+    media_bytes += video_participant_count * video_width * video_height * 3 / 2;
+  }
+  const absl::Duration elapsed = absl::Now() - start;
+
+  collector->OnDisconnected(absl::OkStatus());
+  if (absl::Status status = collector->WaitForDisconnected(absl::Minutes(1));
+      !status.ok()) {
+    LOG(ERROR) << "Failed to finish writing media: " << status;
+    return EXIT_FAILURE;
+  }
+  // Writing continues after the frames are delivered, so CPU and allocations
+  // are measured once every segment has been closed.
+  const absl::Duration cpu = CpuTime() - cpu_start;
+  const uint64_t allocations = allocation_count.load() - allocations_start;
+  const uint64_t frame_count = audio_frame_count + video_frame_count;
+  const double elapsed_seconds = absl::ToDoubleSeconds(elapsed);
+
+  absl::PrintF("participants: %d (%d with video)\n", participant_count,
+               video_participant_count);
+  absl::PrintF("frames: %d audio, %d video in %s\n", audio_frame_count,
+               video_frame_count, absl::FormatDuration(elapsed));
+  absl::PrintF("throughput: %.0f frames/s, %.2f MiB/s\n",
+               frame_count / elapsed_seconds,
+               media_bytes / elapsed_seconds / (1024 * 1024));
+  absl::PrintF("audio callback latency: p50 %s, p99 %s, max %s\n",
+               absl::FormatDuration(audio_latencies.Percentile(50)),
+               absl::FormatDuration(audio_latencies.Percentile(99)),
+               absl::FormatDuration(audio_latencies.Percentile(100)));
+  absl::PrintF("video callback latency: p50 %s, p99 %s, max %s\n",
+               absl::FormatDuration(video_latencies.Percentile(50)),
+               absl::FormatDuration(video_latencies.Percentile(99)),
+               absl::FormatDuration(video_latencies.Percentile(100)));
+  absl::PrintF("max sender lag: %s\n", absl::FormatDuration(max_tick_lag));
+  absl::PrintF("allocations: %d (%.2f per frame)\n", allocations,
+               frame_count > 0 ? static_cast<double>(allocations) / frame_count
+                               : 0);
+  absl::PrintF("cpu: %s (%.2f%% of a core per participant)\n",
+               absl::FormatDuration(cpu),
+               100 * absl::ToDoubleSeconds(cpu) / elapsed_seconds /
+                   participant_count);
+  media_api_samples::FrameQueueStats audio_queue_stats =
+      collector->GetAudioQueueStats();
+  media_api_samples::FrameQueueStats video_queue_stats =
+      collector->GetVideoQueueStats();
+  absl::PrintF("queued frames: max %d audio, %d video\n",
+               audio_queue_stats.max_queued_frames,
+               video_queue_stats.max_queued_frames);
+  absl::PrintF("dropped frames: %d audio, %d video\n",
+               audio_queue_stats.dropped_frames,
+               video_queue_stats.dropped_frames);
+  return EXIT_SUCCESS;
+}
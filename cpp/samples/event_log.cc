@@ -0,0 +1,477 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/event_log.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "cpp/samples/little_endian.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+namespace {
+
+constexpr absl::string_view kParticipantResourceUpdateFormat =
+    "time=%s,"
+    "event=updated participant resource,"
+    "display_name=%s,"
+    "participant_key=%s,"
+    "participant_id=%d\n";
+constexpr absl::string_view kParticipantResourceDeleteFormat =
+    "time=%s,"
+    "event=deleted participant resource,"
+    "participant_id=%d\n";
+constexpr absl::string_view kMediaEntryResourceUpdateFormat =
+    "time=%s,"
+    "event=updated media entry resource,"
+    "participant_session_name=%s,"
+    "participant_key=%s,"
+    "media_entry_id=%d,"
+    "audio_csrc=%d,"
+    // Because there may be multiple video contributing sources, they will be
+    // concatenated using `|` as a delimiter.
+    "video_csrcs=%s,"
+    "audio_muted=%d,"
+    "video_muted=%d\n";
+constexpr absl::string_view kMediaEntryResourceDeleteFormat =
+    "time=%s,"
+    "event=deleted media entry resource,"
+    "media_entry_id=%d\n";
+
+// The `event` values of each event type.
+constexpr absl::string_view kParticipantUpdatedEvent =
+    "updated participant resource";
+constexpr absl::string_view kParticipantDeletedEvent =
+    "deleted participant resource";
+constexpr absl::string_view kMediaEntryUpdatedEvent =
+    "updated media entry resource";
+constexpr absl::string_view kMediaEntryDeletedEvent =
+    "deleted media entry resource";
+
+// The keys of every event type.
+constexpr std::array<absl::string_view, 11> kCsvKeys = {
+    "time",
+    "event",
+    "display_name",
+    "participant_key",
+    "participant_id",
+    "participant_session_name",
+    "media_entry_id",
+    "audio_csrc",
+    "video_csrcs",
+    "audio_muted",
+    "video_muted"};
+
+// Whether columns are already in the little-endian byte order of the format,
+// so that they can be copied as is.
+template <typename T>
+constexpr bool kIsStoredAsIs =
+    sizeof(T) == 1 || std::endian::native == std::endian::little;
+
+// Appends `count` little-endian values from the front of `data` to `column`.
+// Returns false if `data` is too short.
+template <typename T>
+bool TakeArray(absl::string_view& data, size_t count, std::vector<T>& column) {
+  if (data.size() / sizeof(T) < count) {
+    return false;
+  }
+  size_t offset = column.size();
+  column.resize(offset + count);
+  if constexpr (kIsStoredAsIs<T>) {
+    std::memcpy(column.data() + offset, data.data(), count * sizeof(T));
+    data.remove_prefix(count * sizeof(T));
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      TakeLittleEndian(data, column[offset + i]);
+    }
+  }
+  return true;
+}
+
+// Reads the `ends` of a row group's list column, rebased onto the values
+// already in the column, and returns the number of values they index. Returns
+// nullopt if the ends are not ordered.
+std::optional<uint32_t> TakeEnds(absl::string_view& data, uint32_t row_count,
+                                 size_t base, std::vector<uint32_t>& ends) {
+  std::vector<uint32_t> group_ends;
+  if (!TakeArray(data, row_count, group_ends)) {
+    return std::nullopt;
+  }
+  uint32_t previous_end = 0;
+  for (uint32_t end : group_ends) {
+    if (end < previous_end) {
+      return std::nullopt;
+    }
+    previous_end = end;
+    ends.push_back(static_cast<uint32_t>(base + end));
+  }
+  return previous_end;
+}
+
+bool TakeStringColumn(absl::string_view& data, uint32_t row_count,
+                      EventLogColumns::StringColumn& column) {
+  std::optional<uint32_t> size =
+      TakeEnds(data, row_count, column.bytes.size(), column.ends);
+  if (!size.has_value() || data.size() < *size) {
+    return false;
+  }
+  column.bytes.append(data.data(), *size);
+  data.remove_prefix(*size);
+  return true;
+}
+
+bool TakeCsrcListColumn(absl::string_view& data, uint32_t row_count,
+                        EventLogColumns::CsrcListColumn& column) {
+  std::optional<uint32_t> size =
+      TakeEnds(data, row_count, column.values.size(), column.ends);
+  return size.has_value() && TakeArray(data, *size, column.values);
+}
+
+// Returns a chunk of the little-endian values of `column`. Columns are written
+// in place on little-endian hosts, and byte-swapped into a copy kept in
+// `copies` otherwise.
+template <typename T>
+OutputWriterInterface::Chunk ColumnChunk(const std::vector<T>& column,
+                                         std::deque<std::string>& copies) {
+  auto size = static_cast<std::streamsize>(column.size() * sizeof(T));
+  if constexpr (kIsStoredAsIs<T>) {
+    return {.content = reinterpret_cast<const char*>(column.data()),
+            .size = size};
+  } else {
+    std::string& copy = copies.emplace_back(size, '\0');
+    for (size_t i = 0; i < column.size(); ++i) {
+      PutLittleEndian(copy.data(), i * sizeof(T), column[i]);
+    }
+    return {.content = copy.data(), .size = size};
+  }
+}
+
+absl::StatusOr<ResourceEvent> ParseCsvLine(absl::string_view line) {
+  std::vector<std::pair<absl::string_view, std::string>> fields;
+  for (absl::string_view token : absl::StrSplit(line, ',')) {
+    std::pair<absl::string_view, absl::string_view> key_value =
+        absl::StrSplit(token, absl::MaxSplits('=', 1));
+    if (token.find('=') != absl::string_view::npos &&
+        absl::c_linear_search(kCsvKeys, key_value.first)) {
+      fields.emplace_back(key_value.first, std::string(key_value.second));
+    } else if (!fields.empty()) {
+      // The previous value contained a comma.
+      absl::StrAppend(&fields.back().second, ",", token);
+    } else {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Malformed event log line: ", line));
+    }
+  }
+
+  ResourceEvent event;
+  bool has_type = false;
+  for (const auto& [key, value] : fields) {
+    bool parsed = true;
+    if (key == "time") {
+      std::string error;
+      parsed = absl::ParseTime(absl::RFC3339_full, value, &event.time, &error);
+    } else if (key == "event") {
+      has_type = true;
+      if (value == kParticipantUpdatedEvent) {
+        event.type = ResourceEventType::kParticipantUpdated;
+      } else if (value == kParticipantDeletedEvent) {
+        event.type = ResourceEventType::kParticipantDeleted;
+      } else if (value == kMediaEntryUpdatedEvent) {
+        event.type = ResourceEventType::kMediaEntryUpdated;
+      } else if (value == kMediaEntryDeletedEvent) {
+        event.type = ResourceEventType::kMediaEntryDeleted;
+      } else {
+        parsed = false;
+      }
+    } else if (key == "display_name") {
+      event.display_name = value;
+    } else if (key == "participant_key") {
+      event.participant_key = value;
+    } else if (key == "participant_session_name") {
+      event.participant_session_name = value;
+    } else if (key == "participant_id" || key == "media_entry_id") {
+      parsed = absl::SimpleAtoi(value, &event.resource_id);
+    } else if (key == "audio_csrc") {
+      parsed = absl::SimpleAtoi(value, &event.audio_csrc);
+    } else if (key == "video_csrcs") {
+      for (absl::string_view csrc :
+           absl::StrSplit(value, '|', absl::SkipEmpty())) {
+        uint32_t video_csrc;
+        parsed = parsed && absl::SimpleAtoi(csrc, &video_csrc);
+        event.video_csrcs.push_back(video_csrc);
+      }
+    } else if (key == "audio_muted") {
+      parsed = absl::SimpleAtob(value, &event.audio_muted);
+    } else if (key == "video_muted") {
+      parsed = absl::SimpleAtob(value, &event.video_muted);
+    }
+    if (!parsed) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Malformed ", key, " in event log line: ", line));
+    }
+  }
+  if (!has_type) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Missing event in event log line: ", line));
+  }
+  return event;
+}
+
+}  // namespace
+
+void CsvEventLogWriter::Append(const ResourceEvent& event) {
+  if (event.time != formatted_time_) {
+    formatted_time_ = event.time;
+    formatted_time_string_ = absl::FormatTime(event.time);
+  }
+  switch (event.type) {
+    case ResourceEventType::kParticipantUpdated:
+      absl::StrAppendFormat(&batch_, kParticipantResourceUpdateFormat,
+                            formatted_time_string_, event.display_name,
+                            event.participant_key, event.resource_id);
+      break;
+    case ResourceEventType::kParticipantDeleted:
+      absl::StrAppendFormat(&batch_, kParticipantResourceDeleteFormat,
+                            formatted_time_string_, event.resource_id);
+      break;
+    case ResourceEventType::kMediaEntryUpdated:
+      absl::StrAppendFormat(
+          &batch_, kMediaEntryResourceUpdateFormat, formatted_time_string_,
+          event.participant_session_name, event.participant_key,
+          event.resource_id, event.audio_csrc,
+          absl::StrJoin(event.video_csrcs, "|"), event.audio_muted,
+          event.video_muted);
+      break;
+    case ResourceEventType::kMediaEntryDeleted:
+      absl::StrAppendFormat(&batch_, kMediaEntryResourceDeleteFormat,
+                            formatted_time_string_, event.resource_id);
+      break;
+  }
+}
+
+void CsvEventLogWriter::Flush() {
+  if (batch_.empty()) {
+    return;
+  }
+  writer_->Write(batch_.data(), batch_.size());
+  // Clearing keeps the batch's capacity, so later updates of a similar size do
+  // not allocate.
+  batch_.clear();
+}
+
+void EventLogColumns::StringColumn::Append(absl::string_view value) {
+  bytes.append(value.data(), value.size());
+  ends.push_back(static_cast<uint32_t>(bytes.size()));
+}
+
+absl::string_view EventLogColumns::StringColumn::Get(size_t row) const {
+  size_t start = row == 0 ? 0 : ends[row - 1];
+  return absl::string_view(bytes).substr(start, ends[row] - start);
+}
+
+void EventLogColumns::CsrcListColumn::Append(
+    absl::Span<const uint32_t> list) {
+  values.insert(values.end(), list.begin(), list.end());
+  ends.push_back(static_cast<uint32_t>(values.size()));
+}
+
+absl::Span<const uint32_t> EventLogColumns::CsrcListColumn::Get(
+    size_t row) const {
+  size_t start = row == 0 ? 0 : ends[row - 1];
+  return absl::MakeConstSpan(values).subspan(start, ends[row] - start);
+}
+
+void EventLogColumns::Append(const ResourceEvent& event) {
+  types.push_back(event.type);
+  times.push_back(absl::ToUnixNanos(event.time));
+  resource_ids.push_back(event.resource_id);
+  audio_csrcs.push_back(event.audio_csrc);
+  muted.push_back(static_cast<uint8_t>((event.audio_muted ? kAudioMuted : 0) |
+                                       (event.video_muted ? kVideoMuted : 0)));
+  display_names.Append(event.display_name);
+  participant_keys.Append(event.participant_key);
+  participant_session_names.Append(event.participant_session_name);
+  video_csrcs.Append(event.video_csrcs);
+}
+
+ResourceEvent EventLogColumns::Row(size_t row) const {
+  absl::Span<const uint32_t> row_video_csrcs = video_csrcs.Get(row);
+  return ResourceEvent{
+      .type = types[row],
+      .time = absl::FromUnixNanos(times[row]),
+      .resource_id = resource_ids[row],
+      .display_name = std::string(display_names.Get(row)),
+      .participant_key = std::string(participant_keys.Get(row)),
+      .participant_session_name =
+          std::string(participant_session_names.Get(row)),
+      .audio_csrc = audio_csrcs[row],
+      .video_csrcs = std::vector<uint32_t>(row_video_csrcs.begin(),
+                                           row_video_csrcs.end()),
+      .audio_muted = (muted[row] & kAudioMuted) != 0,
+      .video_muted = (muted[row] & kVideoMuted) != 0,
+  };
+}
+
+void EventLogColumns::Clear() {
+  types.clear();
+  times.clear();
+  resource_ids.clear();
+  audio_csrcs.clear();
+  muted.clear();
+  for (StringColumn* column :
+       {&display_names, &participant_keys, &participant_session_names}) {
+    column->ends.clear();
+    column->bytes.clear();
+  }
+  video_csrcs.ends.clear();
+  video_csrcs.values.clear();
+}
+
+void ColumnarEventLogWriter::Append(const ResourceEvent& event) {
+  pending_.Append(event);
+}
+
+void ColumnarEventLogWriter::Flush() {
+  if (pending_.size() == 0) {
+    return;
+  }
+  std::deque<std::string> copies;
+  std::vector<OutputWriterInterface::Chunk> chunks = {
+      {},  // The header, once the size of the columns is known.
+      ColumnChunk(pending_.types, copies),
+      ColumnChunk(pending_.times, copies),
+      ColumnChunk(pending_.resource_ids, copies),
+      ColumnChunk(pending_.audio_csrcs, copies),
+      ColumnChunk(pending_.muted, copies),
+  };
+  for (const EventLogColumns::StringColumn* column :
+       {&pending_.display_names, &pending_.participant_keys,
+        &pending_.participant_session_names}) {
+    chunks.push_back(ColumnChunk(column->ends, copies));
+    chunks.push_back(
+        {.content = column->bytes.data(),
+         .size = static_cast<std::streamsize>(column->bytes.size())});
+  }
+  chunks.push_back(ColumnChunk(pending_.video_csrcs.ends, copies));
+  chunks.push_back(ColumnChunk(pending_.video_csrcs.values, copies));
+
+  char header[2 * sizeof(uint32_t)];
+  size_t size = sizeof(uint32_t);
+  for (const OutputWriterInterface::Chunk& chunk : chunks) {
+    size += chunk.size;
+  }
+  size_t offset = PutLittleEndian(header, 0, static_cast<uint32_t>(size));
+  PutLittleEndian(header, offset, static_cast<uint32_t>(pending_.size()));
+  chunks[0] = {.content = header, .size = sizeof(header)};
+  writer_->WriteVectored(chunks);
+  pending_.Clear();
+}
+
+std::optional<EventLogFormat> ParseEventLogFormat(absl::string_view name) {
+  if (name == "csv") {
+    return EventLogFormat::kCsv;
+  }
+  if (name == "columnar") {
+    return EventLogFormat::kColumnar;
+  }
+  return std::nullopt;
+}
+
+std::unique_ptr<EventLogWriterInterface> CreateEventLogWriter(
+    EventLogFormat format, std::unique_ptr<OutputWriterInterface> writer) {
+  switch (format) {
+    case EventLogFormat::kCsv:
+      return std::make_unique<CsvEventLogWriter>(std::move(writer));
+    case EventLogFormat::kColumnar:
+      return std::make_unique<ColumnarEventLogWriter>(std::move(writer));
+  }
+  return nullptr;
+}
+
+absl::StatusOr<EventLogColumns> ReadColumnarEventLog(
+    absl::string_view contents) {
+  EventLogColumns columns;
+  while (!contents.empty()) {
+    uint32_t size;
+    if (!TakeLittleEndian(contents, size) || contents.size() < size) {
+      // The collector stopped while writing the last row group.
+      break;
+    }
+    absl::string_view group = contents.substr(0, size);
+    contents.remove_prefix(size);
+
+    size_t first_row = columns.size();
+    uint32_t row_count;
+    if (!TakeLittleEndian(group, row_count) ||
+        !TakeArray(group, row_count, columns.types) ||
+        !TakeArray(group, row_count, columns.times) ||
+        !TakeArray(group, row_count, columns.resource_ids) ||
+        !TakeArray(group, row_count, columns.audio_csrcs) ||
+        !TakeArray(group, row_count, columns.muted) ||
+        !TakeStringColumn(group, row_count, columns.display_names) ||
+        !TakeStringColumn(group, row_count, columns.participant_keys) ||
+        !TakeStringColumn(group, row_count,
+                          columns.participant_session_names) ||
+        !TakeCsrcListColumn(group, row_count, columns.video_csrcs) ||
+        !group.empty()) {
+      return absl::DataLossError("Malformed event log row group.");
+    }
+    for (size_t row = first_row; row < columns.size(); ++row) {
+      if (columns.types[row] < ResourceEventType::kParticipantUpdated ||
+          columns.types[row] > ResourceEventType::kMediaEntryDeleted) {
+        return absl::DataLossError("Malformed event log event type.");
+      }
+    }
+  }
+  return columns;
+}
+
+absl::StatusOr<std::vector<ResourceEvent>> ParseCsvEventLog(
+    absl::string_view contents) {
+  std::vector<ResourceEvent> events;
+  for (absl::string_view line :
+       absl::StrSplit(contents, '\n', absl::SkipEmpty())) {
+    absl::StatusOr<ResourceEvent> event = ParseCsvLine(line);
+    if (!event.ok()) {
+      return event.status();
+    }
+    events.push_back(*std::move(event));
+  }
+  return events;
+}
+
+}  // namespace media_api_samples
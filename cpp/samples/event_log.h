@@ -0,0 +1,195 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_EVENT_LOG_H_
+#define CPP_SAMPLES_EVENT_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+
+enum class ResourceEventType : uint8_t {
+  kParticipantUpdated = 1,
+  kParticipantDeleted = 2,
+  kMediaEntryUpdated = 3,
+  kMediaEntryDeleted = 4,
+};
+
+// A participant or media entry event of the event log. Fields that do not
+// apply to the event's type are left empty.
+struct ResourceEvent {
+  ResourceEventType type = ResourceEventType::kParticipantUpdated;
+  absl::Time time;
+  // The participant ID of participant events, or the media entry ID of media
+  // entry events.
+  int64_t resource_id = 0;
+  std::string display_name;
+  std::string participant_key;
+  std::string participant_session_name;
+  uint32_t audio_csrc = 0;
+  std::vector<uint32_t> video_csrcs;
+  bool audio_muted = false;
+  bool video_muted = false;
+
+  friend bool operator==(const ResourceEvent&, const ResourceEvent&) = default;
+};
+
+enum class EventLogFormat {
+  // `key=value` lines; see `CsvEventLogWriter`.
+  kCsv,
+  // Typed columns; see `ColumnarEventLogWriter`.
+  kColumnar,
+};
+
+// Parses an event log format from its lowercase name, "csv" or "columnar".
+// Returns nullopt if `name` is not a supported format.
+std::optional<EventLogFormat> ParseEventLogFormat(absl::string_view name);
+
+// Interface for writing the event log.
+class EventLogWriterInterface {
+ public:
+  virtual ~EventLogWriterInterface() = default;
+  // Buffers `event` until the next `Flush`.
+  virtual void Append(const ResourceEvent& event) = 0;
+  // Writes the events appended since the last flush.
+  virtual void Flush() = 0;
+};
+
+// Writes events as lines of comma-separated `key=value` pairs, e.g.:
+//   time=<time>,event=deleted media entry resource,media_entry_id=<id>
+//
+// Values are not escaped, so display names that contain commas are ambiguous;
+// see `ParseCsvEventLog`. Each flush is written in a single write.
+class CsvEventLogWriter : public EventLogWriterInterface {
+ public:
+  explicit CsvEventLogWriter(std::unique_ptr<OutputWriterInterface> writer)
+      : writer_(std::move(writer)) {}
+
+  void Append(const ResourceEvent& event) override;
+  void Flush() override;
+
+ private:
+  std::unique_ptr<OutputWriterInterface> writer_;
+  // Events are formatted into this batch until they are flushed.
+  std::string batch_;
+  // The events of an update share its received time, so the last formatted
+  // time is reused.
+  absl::Time formatted_time_ = absl::InfinitePast();
+  std::string formatted_time_string_;
+};
+
+// The events of an event log, stored as one typed column per field. Rows are
+// in the order in which they were appended.
+//
+// Analysis jobs can scan the columns they need without parsing text, e.g. the
+// types and times of every event.
+struct EventLogColumns {
+  // Strings stored back to back; `ends[i]` is the end of row `i` in `bytes`.
+  struct StringColumn {
+    std::vector<uint32_t> ends;
+    std::string bytes;
+
+    void Append(absl::string_view value);
+    absl::string_view Get(size_t row) const;
+  };
+  // Lists of CSRCs stored back to back; `ends[i]` is the end of row `i` in
+  // `values`.
+  struct CsrcListColumn {
+    std::vector<uint32_t> ends;
+    std::vector<uint32_t> values;
+
+    void Append(absl::Span<const uint32_t> list);
+    absl::Span<const uint32_t> Get(size_t row) const;
+  };
+
+  // Muted flags, as bits of `muted`.
+  static constexpr uint8_t kAudioMuted = 1 << 0;
+  static constexpr uint8_t kVideoMuted = 1 << 1;
+
+  size_t size() const { return types.size(); }
+  void Append(const ResourceEvent& event);
+  ResourceEvent Row(size_t row) const;
+  void Clear();
+
+  std::vector<ResourceEventType> types;
+  // Nanoseconds since the Unix epoch, the precision of the CSV format's times.
+  std::vector<int64_t> times;
+  std::vector<int64_t> resource_ids;
+  std::vector<uint32_t> audio_csrcs;
+  std::vector<uint8_t> muted;
+  StringColumn display_names;
+  StringColumn participant_keys;
+  StringColumn participant_session_names;
+  CsrcListColumn video_csrcs;
+};
+
+// Writes events in a columnar format.
+//
+// Each flush writes the appended events as a row group:
+//   uint32 size | uint32 row count | columns
+// where `size` counts the bytes that follow it. The columns are written in
+// the order of the fields of `EventLogColumns`, fixed-size columns as arrays
+// of one value per row, and string and CSRC list columns as an array of
+// `ends` followed by their values. Integers are little-endian, like session
+// traces.
+class ColumnarEventLogWriter : public EventLogWriterInterface {
+ public:
+  explicit ColumnarEventLogWriter(std::unique_ptr<OutputWriterInterface> writer)
+      : writer_(std::move(writer)) {}
+
+  void Append(const ResourceEvent& event) override;
+  void Flush() override;
+
+ private:
+  std::unique_ptr<OutputWriterInterface> writer_;
+  // Cleared after each flush, keeping the columns' capacity.
+  EventLogColumns pending_;
+};
+
+// Returns a writer of `format` that writes to `writer`.
+std::unique_ptr<EventLogWriterInterface> CreateEventLogWriter(
+    EventLogFormat format, std::unique_ptr<OutputWriterInterface> writer);
+
+// Reads the row groups of a columnar event log into one set of columns. A
+// truncated final row group, as left by a collector that stopped while
+// writing it, is ignored. Returns an error if a complete row group is
+// malformed.
+absl::StatusOr<EventLogColumns> ReadColumnarEventLog(
+    absl::string_view contents);
+
+// Parses an event log written by `CsvEventLogWriter`, e.g. to convert it to
+// the columnar format.
+//
+// A value that contains a comma is recovered as long as the text after the
+// comma does not look like a known key and `=`.
+absl::StatusOr<std::vector<ResourceEvent>> ParseCsvEventLog(
+    absl::string_view contents);
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_EVENT_LOG_H_
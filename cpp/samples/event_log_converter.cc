@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Converts event logs written in the CSV format to the columnar format, so
+// that logs recorded before the columnar format existed can be analyzed with
+// the same tools. See `EventLogFormat`.
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "cpp/samples/event_log.h"
+#include "cpp/samples/output_file.h"
+
+ABSL_FLAG(std::string, csv_event_log, "",
+          "The CSV event log to convert, e.g. <output_file_prefix>"
+          "event_log.csv.");
+
+ABSL_FLAG(std::string, columnar_event_log, "",
+          "Where to write the columnar event log. Defaults to the CSV event "
+          "log's name with a .columnar extension.");
+
+namespace {
+
+// Events are written in row groups of this many rows, so that readers can
+// load the columns of a large log in a few copies.
+constexpr size_t kRowGroupSize = 4096;
+
+constexpr absl::string_view kCsvExtension = ".csv";
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::SetProgramUsageMessage(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  std::string csv_file_name = absl::GetFlag(FLAGS_csv_event_log);
+  if (csv_file_name.empty()) {
+    LOG(ERROR) << "CSV event log is empty";
+    return EXIT_FAILURE;
+  }
+  std::string columnar_file_name = absl::GetFlag(FLAGS_columnar_event_log);
+  if (columnar_file_name.empty()) {
+    absl::string_view stem = csv_file_name;
+    absl::ConsumeSuffix(&stem, kCsvExtension);
+    columnar_file_name = absl::StrCat(stem, ".columnar");
+  }
+
+  std::ifstream csv_file(csv_file_name, std::ios::binary);
+  if (!csv_file.is_open()) {
+    LOG(ERROR) << "Failed to open CSV event log: " << csv_file_name;
+    return EXIT_FAILURE;
+  }
+  std::string csv((std::istreambuf_iterator<char>(csv_file)),
+                  std::istreambuf_iterator<char>());
+  if (csv_file.bad()) {
+    LOG(ERROR) << "Failed to read CSV event log: " << csv_file_name;
+    return EXIT_FAILURE;
+  }
+  absl::StatusOr<std::vector<media_api_samples::ResourceEvent>> events =
+      media_api_samples::ParseCsvEventLog(csv);
+  if (!events.ok()) {
+    LOG(ERROR) << "Failed to parse CSV event log: " << events.status();
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream columnar_file(columnar_file_name,
+                              std::ios::binary | std::ios::trunc);
+  if (!columnar_file.is_open()) {
+    LOG(ERROR) << "Failed to open columnar event log: " << columnar_file_name;
+    return EXIT_FAILURE;
+  }
+  auto output =
+      std::make_unique<media_api_samples::OutputFile>(std::move(columnar_file));
+  media_api_samples::OutputFile* output_file = output.get();
+  media_api_samples::ColumnarEventLogWriter event_log(std::move(output));
+  for (size_t i = 0; i < events->size(); ++i) {
+    event_log.Append((*events)[i]);
+    if ((i + 1) % kRowGroupSize == 0) {
+      event_log.Flush();
+    }
+  }
+  event_log.Flush();
+  output_file->Close();
+  if (!output_file->ok()) {
+    LOG(ERROR) << "Failed to write columnar event log: " << columnar_file_name;
+    return EXIT_FAILURE;
+  }
+  LOG(INFO) << "Converted " << events->size() << " events to "
+            << columnar_file_name;
+  return EXIT_SUCCESS;
+}
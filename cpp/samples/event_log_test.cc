@@ -0,0 +1,213 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/event_log.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "cpp/samples/testing/mock_output_writer.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::status::StatusIs;
+
+// Returns an output writer that appends everything written to it to `log`.
+std::unique_ptr<MockOutputWriter> CreateLogOutput(std::string& log) {
+  auto writer = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .WillRepeatedly([&log](const char* content, std::streamsize size) {
+        log.append(content, size);
+      });
+  return writer;
+}
+
+ResourceEvent ParticipantUpdated() {
+  return {.type = ResourceEventType::kParticipantUpdated,
+          .time = absl::FromUnixMicros(1'700'000'000'123'456),
+          .resource_id = 123,
+          .display_name = "Mrs. Dalloway",
+          .participant_key = "participant_key"};
+}
+
+ResourceEvent MediaEntryUpdated() {
+  return {.type = ResourceEventType::kMediaEntryUpdated,
+          .time = absl::FromUnixMicros(1'700'000'001'000'000),
+          .resource_id = 456,
+          .participant_key = "participant_key",
+          .participant_session_name = "session_name",
+          .audio_csrc = 111,
+          .video_csrcs = {222, 333},
+          .audio_muted = true};
+}
+
+ResourceEvent MediaEntryDeleted() {
+  return {.type = ResourceEventType::kMediaEntryDeleted,
+          .time = absl::FromUnixMicros(1'700'000'002'000'000),
+          .resource_id = 456};
+}
+
+TEST(EventLogTest, ParsesEventLogFormatNames) {
+  EXPECT_EQ(ParseEventLogFormat("csv"), EventLogFormat::kCsv);
+  EXPECT_EQ(ParseEventLogFormat("columnar"), EventLogFormat::kColumnar);
+  EXPECT_EQ(ParseEventLogFormat("parquet"), std::nullopt);
+}
+
+TEST(EventLogTest, CsvWriterWritesEachFlushOnce) {
+  auto writer = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*writer, Write(_, _)).Times(1);
+  CsvEventLogWriter event_log(std::move(writer));
+
+  event_log.Append(ParticipantUpdated());
+  event_log.Append(MediaEntryDeleted());
+  event_log.Flush();
+  // Nothing was appended since the last flush.
+  event_log.Flush();
+}
+
+TEST(EventLogTest, ParsesCsvEventLog) {
+  std::string log;
+  CsvEventLogWriter event_log(CreateLogOutput(log));
+  ResourceEvent participant_deleted = {
+      .type = ResourceEventType::kParticipantDeleted,
+      .time = absl::FromUnixMicros(1'700'000'003'000'000),
+      .resource_id = 123};
+
+  event_log.Append(ParticipantUpdated());
+  event_log.Append(MediaEntryUpdated());
+  event_log.Flush();
+  event_log.Append(MediaEntryDeleted());
+  event_log.Append(participant_deleted);
+  event_log.Flush();
+
+  absl::StatusOr<std::vector<ResourceEvent>> events = ParseCsvEventLog(log);
+  ASSERT_OK(events);
+  EXPECT_THAT(*events,
+              ElementsAre(ParticipantUpdated(), MediaEntryUpdated(),
+                          MediaEntryDeleted(), participant_deleted));
+}
+
+TEST(EventLogTest, ParsesCsvDisplayNamesWithCommas) {
+  std::string log;
+  CsvEventLogWriter event_log(CreateLogOutput(log));
+  ResourceEvent event = ParticipantUpdated();
+  event.display_name = "Dalloway, Clarissa";
+
+  event_log.Append(event);
+  event_log.Flush();
+
+  absl::StatusOr<std::vector<ResourceEvent>> events = ParseCsvEventLog(log);
+  ASSERT_OK(events);
+  EXPECT_THAT(*events, ElementsAre(event));
+}
+
+TEST(EventLogTest, ParseCsvFailsWithUnknownEvent) {
+  EXPECT_THAT(ParseCsvEventLog("time=2024-01-01T00:00:00Z,event=unknown\n"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(EventLogTest, ReadsColumnarEventLogAcrossRowGroups) {
+  std::string log;
+  ColumnarEventLogWriter event_log(CreateLogOutput(log));
+
+  event_log.Append(ParticipantUpdated());
+  event_log.Append(MediaEntryUpdated());
+  event_log.Flush();
+  event_log.Append(MediaEntryUpdated());
+  event_log.Append(MediaEntryDeleted());
+  event_log.Flush();
+
+  absl::StatusOr<EventLogColumns> columns = ReadColumnarEventLog(log);
+  ASSERT_OK(columns);
+  ASSERT_EQ(columns->size(), 4);
+  EXPECT_EQ(columns->Row(0), ParticipantUpdated());
+  EXPECT_EQ(columns->Row(1), MediaEntryUpdated());
+  EXPECT_EQ(columns->Row(2), MediaEntryUpdated());
+  EXPECT_EQ(columns->Row(3), MediaEntryDeleted());
+  EXPECT_THAT(columns->video_csrcs.values, ElementsAre(222, 333, 222, 333));
+}
+
+TEST(EventLogTest, ColumnarEventLogKeepsNanosecondTimes) {
+  std::string log;
+  ColumnarEventLogWriter event_log(CreateLogOutput(log));
+  ResourceEvent event = ParticipantUpdated();
+  event.time = absl::FromUnixNanos(1'700'000'000'123'456'789);
+
+  event_log.Append(event);
+  event_log.Flush();
+
+  absl::StatusOr<EventLogColumns> columns = ReadColumnarEventLog(log);
+  ASSERT_OK(columns);
+  ASSERT_EQ(columns->size(), 1);
+  EXPECT_EQ(columns->Row(0), event);
+}
+
+TEST(EventLogTest, ColumnarWriterWritesLittleEndianRowGroupHeader) {
+  std::string log;
+  ColumnarEventLogWriter event_log(CreateLogOutput(log));
+  event_log.Append(ParticipantUpdated());
+  event_log.Append(MediaEntryUpdated());
+  event_log.Flush();
+
+  ASSERT_GE(log.size(), 8);
+  uint32_t size = log.size() - 4;
+  EXPECT_EQ(log.substr(0, 8),
+            std::string({static_cast<char>(size & 0xff),
+                         static_cast<char>((size >> 8) & 0xff),
+                         static_cast<char>((size >> 16) & 0xff),
+                         static_cast<char>(size >> 24), 2, 0, 0, 0}));
+}
+
+TEST(EventLogTest, ColumnarReadIgnoresTruncatedFinalRowGroup) {
+  std::string log;
+  ColumnarEventLogWriter event_log(CreateLogOutput(log));
+  event_log.Append(ParticipantUpdated());
+  event_log.Flush();
+  event_log.Append(MediaEntryUpdated());
+  event_log.Flush();
+  log.resize(log.size() - 3);
+
+  absl::StatusOr<EventLogColumns> columns = ReadColumnarEventLog(log);
+
+  ASSERT_OK(columns);
+  ASSERT_EQ(columns->size(), 1);
+  EXPECT_EQ(columns->Row(0), ParticipantUpdated());
+}
+
+TEST(EventLogTest, ColumnarReadFailsWithMalformedRowGroup) {
+  std::string log;
+  ColumnarEventLogWriter event_log(CreateLogOutput(log));
+  event_log.Append(ParticipantUpdated());
+  event_log.Flush();
+  // Corrupt the event type of the first row.
+  log[2 * sizeof(uint32_t)] = 9;
+
+  EXPECT_THAT(ReadColumnarEventLog(log), StatusIs(absl::StatusCode::kDataLoss));
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/frame_queue.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+
+namespace media_api_samples {
+namespace {
+
+// The most frames of one source handled by a single drain, before the thread's
+// other tasks get a turn.
+constexpr int kMaxFramesPerDrain = 8;
+
+}  // namespace
+
+FrameQueue::~FrameQueue() {
+  // Waits for a running drain to finish.
+  absl::MutexLock lock(&liveness_->mutex);
+  liveness_->alive = false;
+}
+
+void FrameQueue::Enqueue(uint32_t source, Task task) {
+  enqueued_frames_.fetch_add(1, std::memory_order_relaxed);
+  // A dropped frame is released after the lock, since releasing its buffer
+  // may be expensive.
+  Task dropped_task;
+  absl::MutexLock lock(&mutex_);
+  auto [it, inserted] = queues_.try_emplace(source);
+  if (options_.policy != FrameQueuePolicy::kUnbounded) {
+    size_t max_frames = std::max<size_t>(options_.max_frames_per_source, 1);
+    if (options_.policy == FrameQueuePolicy::kBlock) {
+      while (it->second.tasks.size() >= max_frames) {
+        dequeued_.Wait(&mutex_);
+        // The source's entry may have been erased or moved while waiting.
+        std::tie(it, inserted) = queues_.try_emplace(source);
+      }
+    } else if (it->second.tasks.size() >= max_frames) {
+      dropped_task = std::move(it->second.tasks.front().task);
+      it->second.tasks.pop_front();
+      --queued_frames_;
+      dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  it->second.tasks.push_back(
+      QueuedTask{.sequence = next_sequence_++, .task = std::move(task)});
+  max_queued_frames_ = std::max(max_queued_frames_, ++queued_frames_);
+
+  if (inserted) {
+    PostDrain(source);
+  }
+}
+
+void FrameQueue::PostAfterQueuedFrames(Task task) {
+  {
+    absl::MutexLock lock(&mutex_);
+    Barrier barrier{.sequence = next_sequence_, .task = std::move(task)};
+    // Barriers run in order, so a barrier waits for earlier ones.
+    if (!barriers_.empty() || !IsCompleted(barrier)) {
+      barriers_.push_back(std::move(barrier));
+      return;
+    }
+    task = std::move(barrier.task);
+  }
+  // The frame being handled, if any, is handled before this task runs.
+  thread_->PostTask(std::move(task));
+}
+
+void FrameQueue::PostDrain(uint32_t source) {
+  thread_->PostTask([this, liveness = liveness_, source] {
+    absl::MutexLock lock(&liveness->mutex);
+    if (liveness->alive) {
+      Drain(source);
+    }
+  });
+}
+
+void FrameQueue::Drain(uint32_t source) {
+  for (int i = 0; i < kMaxFramesPerDrain; ++i) {
+    Task task;
+    {
+      absl::MutexLock lock(&mutex_);
+      auto it = queues_.find(source);
+      if (it->second.tasks.empty()) {
+        queues_.erase(it);
+        return;
+      }
+      task = std::move(it->second.tasks.front().task);
+      it->second.tasks.pop_front();
+      --queued_frames_;
+    }
+    dequeued_.SignalAll();
+    std::move(task)();
+    RunCompletedBarriers();
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = queues_.find(source);
+    if (it->second.tasks.empty()) {
+      queues_.erase(it);
+      return;
+    }
+  }
+  // The rest of the source's frames are handled after the tasks posted in the
+  // meantime, including other sources' drains.
+  PostDrain(source);
+}
+
+void FrameQueue::RunCompletedBarriers() {
+  std::vector<Task> tasks;
+  {
+    absl::MutexLock lock(&mutex_);
+    while (!barriers_.empty() && IsCompleted(barriers_.front())) {
+      tasks.push_back(std::move(barriers_.front().task));
+      barriers_.pop_front();
+    }
+  }
+  for (Task& task : tasks) {
+    std::move(task)();
+  }
+}
+
+bool FrameQueue::IsCompleted(const Barrier& barrier) const {
+  for (const auto& [source, queue] : queues_) {
+    if (!queue.tasks.empty() &&
+        queue.tasks.front().sequence < barrier.sequence) {
+      return false;
+    }
+  }
+  return true;
+}
+
+FrameQueueStats FrameQueue::GetStats() const {
+  FrameQueueStats stats;
+  stats.enqueued_frames = enqueued_frames_.load(std::memory_order_relaxed);
+  stats.dropped_frames = dropped_frames_.load(std::memory_order_relaxed);
+  absl::MutexLock lock(&mutex_);
+  stats.queued_frames = queued_frames_;
+  stats.max_queued_frames = max_queued_frames_;
+  return stats;
+}
+
+}  // namespace media_api_samples
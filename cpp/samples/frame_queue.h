@@ -0,0 +1,165 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_FRAME_QUEUE_H_
+#define CPP_SAMPLES_FRAME_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/mutex.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+
+// What a `FrameQueue` does when a source's queue is full.
+enum class FrameQueuePolicy {
+  // Frames are never dropped, and queues grow without bound.
+  kUnbounded,
+  // The source's oldest queued frame is dropped to make room for the new one.
+  kDropOldest,
+  // The caller blocks until the source's queue has room.
+  kBlock,
+};
+
+struct FrameQueueOptions {
+  FrameQueuePolicy policy = FrameQueuePolicy::kUnbounded;
+  // The maximum number of frames queued for each source. Ignored for
+  // `kUnbounded`.
+  size_t max_frames_per_source = 0;
+};
+
+struct FrameQueueStats {
+  uint64_t enqueued_frames = 0;
+  uint64_t dropped_frames = 0;
+  // The number of frames currently queued, across all sources.
+  size_t queued_frames = 0;
+  // The most frames that have been queued at once, across all sources.
+  size_t max_queued_frames = 0;
+
+  // Combines the stats of several queues. The combined `max_queued_frames` is
+  // an upper bound, since the queues may not have peaked at the same time.
+  FrameQueueStats& operator+=(const FrameQueueStats& other) {
+    enqueued_frames += other.enqueued_frames;
+    dropped_frames += other.dropped_frames;
+    queued_frames += other.queued_frames;
+    max_queued_frames += other.max_queued_frames;
+    return *this;
+  }
+};
+
+// The queue options used by the media collectors by default. Dropped audio
+// would leave gaps in recordings, so audio is never dropped; video keeps about
+// a second of frames per participant.
+inline constexpr FrameQueueOptions kDefaultAudioFrameQueueOptions = {
+    .policy = FrameQueuePolicy::kUnbounded};
+inline constexpr FrameQueueOptions kDefaultVideoFrameQueueOptions = {
+    .policy = FrameQueuePolicy::kDropOldest, .max_frames_per_source = 30};
+
+// Queues the frames of each contributing source to be handled on a thread,
+// bounding the number of frames that are waiting, e.g. while writes to a slow
+// disk block the thread.
+//
+// A source's frames are handled in order. Each source's frames are handled in
+// bounded batches, so that a source with a long backlog does not starve the
+// other sources and the thread's other tasks. Tasks that must run after the
+// frames queued before them are posted with `PostAfterQueuedFrames`.
+//
+// This class is thread-safe.
+class FrameQueue {
+ public:
+  using Task = absl::AnyInvocable<void() &&>;
+
+  // `thread` must outlive the queue. Frames that are still queued when the
+  // queue is destroyed are dropped.
+  FrameQueue(rtc::Thread* thread, FrameQueueOptions options)
+      : thread_(thread), options_(options) {}
+
+  ~FrameQueue();
+
+  // FrameQueue is neither copyable nor movable.
+  FrameQueue(const FrameQueue&) = delete;
+  FrameQueue& operator=(const FrameQueue&) = delete;
+
+  // Queues `task`, which handles a frame from `source`, applying the queue's
+  // policy if the source's queue is full.
+  //
+  // With `kBlock`, this must not be called on the queue's thread.
+  void Enqueue(uint32_t source, Task task);
+
+  // Runs `task` on the queue's thread once every frame queued before this
+  // call, from any source, has been handled or dropped.
+  void PostAfterQueuedFrames(Task task);
+
+  FrameQueueStats GetStats() const;
+
+ private:
+  struct QueuedTask {
+    // The order in which the task was queued, across all sources.
+    uint64_t sequence;
+    Task task;
+  };
+  struct SourceQueue {
+    std::deque<QueuedTask> tasks;
+  };
+  struct Barrier {
+    // Runs once no task queued before `sequence` remains.
+    uint64_t sequence;
+    Task task;
+  };
+  // Shared with posted drains, so that drains that run after the queue has
+  // been destroyed do nothing.
+  struct Liveness {
+    absl::Mutex mutex;
+    bool alive ABSL_GUARDED_BY(mutex) = true;
+  };
+
+  void PostDrain(uint32_t source);
+  // Runs a batch of queued tasks for `source`, and posts another drain if
+  // tasks remain. Must be called on `thread_`.
+  void Drain(uint32_t source);
+  // Runs the barriers whose preceding tasks have all been handled or dropped.
+  // Must be called on `thread_`.
+  void RunCompletedBarriers();
+  bool IsCompleted(const Barrier& barrier) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  rtc::Thread* thread_;
+  const FrameQueueOptions options_;
+  const std::shared_ptr<Liveness> liveness_ = std::make_shared<Liveness>();
+
+  mutable absl::Mutex mutex_;
+  absl::CondVar dequeued_;
+  // Sources are erased once their queues are empty, so a source has a drain
+  // posted exactly when it has an entry.
+  absl::flat_hash_map<uint32_t, SourceQueue> queues_ ABSL_GUARDED_BY(mutex_);
+  uint64_t next_sequence_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::deque<Barrier> barriers_ ABSL_GUARDED_BY(mutex_);
+  size_t queued_frames_ ABSL_GUARDED_BY(mutex_) = 0;
+  size_t max_queued_frames_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::atomic<uint64_t> enqueued_frames_ = 0;
+  std::atomic<uint64_t> dropped_frames_ = 0;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_FRAME_QUEUE_H_
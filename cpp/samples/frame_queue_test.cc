@@ -0,0 +1,247 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/frame_queue.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::ElementsAre;
+
+std::unique_ptr<rtc::Thread> CreateThread() {
+  std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+  thread->SetName("frame_queue_thread", nullptr);
+  EXPECT_TRUE(thread->Start());
+  return thread;
+}
+
+// Blocks `thread` until `release` is notified, so that frames stay queued.
+void BlockThread(rtc::Thread& thread, absl::Notification& release) {
+  thread.PostTask([&release] { release.WaitForNotification(); });
+}
+
+// Waits until every frame queued so far has been handled.
+void WaitForQueuedFrames(FrameQueue& queue) {
+  absl::Notification handled;
+  queue.PostAfterQueuedFrames([&handled] { handled.Notify(); });
+  handled.WaitForNotification();
+}
+
+TEST(FrameQueueTest, HandlesFramesInOrderOnThread) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  FrameQueue queue(thread.get(), {.policy = FrameQueuePolicy::kDropOldest,
+                                  .max_frames_per_source = 8});
+  std::vector<int> handled;
+  bool handled_on_thread = true;
+
+  for (int i = 0; i < 4; ++i) {
+    queue.Enqueue(/*source=*/1, [&, i] {
+      handled_on_thread &= thread->IsCurrent();
+      handled.push_back(i);
+    });
+  }
+  thread->BlockingCall([] {});
+
+  EXPECT_THAT(handled, ElementsAre(0, 1, 2, 3));
+  EXPECT_TRUE(handled_on_thread);
+  EXPECT_EQ(queue.GetStats().enqueued_frames, 4);
+  EXPECT_EQ(queue.GetStats().queued_frames, 0);
+}
+
+TEST(FrameQueueTest, DropsOldestFramesOfFullSource) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  FrameQueue queue(thread.get(), {.policy = FrameQueuePolicy::kDropOldest,
+                                  .max_frames_per_source = 2});
+  std::vector<int> handled;
+  absl::Notification release;
+  BlockThread(*thread, release);
+
+  for (int i = 0; i < 4; ++i) {
+    queue.Enqueue(/*source=*/1, [&handled, i] { handled.push_back(i); });
+  }
+  queue.Enqueue(/*source=*/2, [&handled] { handled.push_back(10); });
+  FrameQueueStats stats = queue.GetStats();
+  release.Notify();
+  thread->BlockingCall([] {});
+
+  EXPECT_THAT(handled, ElementsAre(2, 3, 10));
+  EXPECT_EQ(stats.enqueued_frames, 5);
+  EXPECT_EQ(stats.dropped_frames, 2);
+  EXPECT_EQ(stats.queued_frames, 3);
+  EXPECT_EQ(stats.max_queued_frames, 3);
+}
+
+TEST(FrameQueueTest, UnboundedQueueNeverDrops) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  FrameQueue queue(thread.get(), {.policy = FrameQueuePolicy::kUnbounded,
+                                  .max_frames_per_source = 1});
+  int handled_count = 0;
+  absl::Notification release;
+  BlockThread(*thread, release);
+
+  for (int i = 0; i < 10; ++i) {
+    queue.Enqueue(/*source=*/1, [&handled_count] { ++handled_count; });
+  }
+  release.Notify();
+  WaitForQueuedFrames(queue);
+
+  EXPECT_EQ(handled_count, 10);
+  EXPECT_EQ(queue.GetStats().dropped_frames, 0);
+  EXPECT_EQ(queue.GetStats().max_queued_frames, 10);
+}
+
+TEST(FrameQueueTest, BlockingQueueWaitsForRoom) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  FrameQueue queue(thread.get(), {.policy = FrameQueuePolicy::kBlock,
+                                  .max_frames_per_source = 1});
+  std::vector<int> handled;
+  absl::Notification release;
+  BlockThread(*thread, release);
+  queue.Enqueue(/*source=*/1, [&handled] { handled.push_back(0); });
+
+  absl::Notification enqueued;
+  std::thread producer([&] {
+    queue.Enqueue(/*source=*/1, [&handled] { handled.push_back(1); });
+    enqueued.Notify();
+  });
+  EXPECT_FALSE(enqueued.WaitForNotificationWithTimeout(absl::Milliseconds(50)));
+  release.Notify();
+  enqueued.WaitForNotification();
+  producer.join();
+  thread->BlockingCall([] {});
+
+  EXPECT_THAT(handled, ElementsAre(0, 1));
+  EXPECT_EQ(queue.GetStats().dropped_frames, 0);
+}
+
+TEST(FrameQueueTest, HandlesQueuedFramesBeforeLaterTasks) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  FrameQueue queue(thread.get(), {});
+  std::vector<int> handled;
+  absl::Notification release;
+  BlockThread(*thread, release);
+
+  queue.Enqueue(/*source=*/1, [&handled] { handled.push_back(0); });
+  thread->PostTask([&handled] { handled.push_back(1); });
+  // Queued behind the first frame's drain, which was posted before the task.
+  queue.Enqueue(/*source=*/1, [&handled] { handled.push_back(2); });
+  release.Notify();
+  thread->BlockingCall([] {});
+
+  EXPECT_THAT(handled, ElementsAre(0, 2, 1));
+}
+
+TEST(FrameQueueTest, DrainsLongBacklogsInBatches) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  FrameQueue queue(thread.get(), {});
+  std::vector<int> handled;
+  absl::Notification release;
+  BlockThread(*thread, release);
+
+  for (int i = 0; i < 20; ++i) {
+    queue.Enqueue(/*source=*/1, [&handled, i] { handled.push_back(i); });
+  }
+  thread->PostTask([&handled] { handled.push_back(100); });
+  release.Notify();
+  WaitForQueuedFrames(queue);
+
+  ASSERT_EQ(handled.size(), 21);
+  // The posted task runs after the first batch, rather than after the whole
+  // backlog.
+  EXPECT_EQ(handled[8], 100);
+  EXPECT_EQ(queue.GetStats().queued_frames, 0);
+}
+
+TEST(FrameQueueTest, RunsTasksAfterFramesQueuedBeforeThem) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  FrameQueue queue(thread.get(), {});
+  std::vector<int> handled;
+  absl::Notification release;
+  BlockThread(*thread, release);
+
+  for (int i = 0; i < 20; ++i) {
+    queue.Enqueue(/*source=*/1, [&handled, i] { handled.push_back(i); });
+  }
+  queue.Enqueue(/*source=*/2, [&handled] { handled.push_back(20); });
+  absl::Notification done;
+  queue.PostAfterQueuedFrames([&handled, &done] {
+    handled.push_back(100);
+    done.Notify();
+  });
+  // Queued after the task, so it may be handled before or after it.
+  queue.Enqueue(/*source=*/2, [&] { handled.push_back(21); });
+  release.Notify();
+  ASSERT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  thread->BlockingCall([] {});
+
+  ASSERT_EQ(handled.size(), 23);
+  auto task = std::find(handled.begin(), handled.end(), 100);
+  for (int i = 0; i <= 20; ++i) {
+    EXPECT_LT(std::find(handled.begin(), handled.end(), i), task) << i;
+  }
+}
+
+TEST(FrameQueueTest, RunsTasksPostedWithNoQueuedFrames) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  FrameQueue queue(thread.get(), {});
+  absl::Notification done;
+
+  queue.PostAfterQueuedFrames([&done] { done.Notify(); });
+
+  EXPECT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(1)));
+}
+
+TEST(FrameQueueTest, DropsFramesQueuedWhenDestroyed) {
+  std::unique_ptr<rtc::Thread> thread = CreateThread();
+  auto queue = std::make_unique<FrameQueue>(thread.get(), FrameQueueOptions{});
+  int handled = 0;
+  absl::Notification release;
+  BlockThread(*thread, release);
+
+  for (int i = 0; i < 20; ++i) {
+    queue->Enqueue(/*source=*/1, [&handled] { ++handled; });
+  }
+  // Runs after the first batch, and holds the thread until the queue has been
+  // destroyed.
+  absl::Notification first_batch_handled;
+  absl::Notification destroyed;
+  thread->PostTask([&] {
+    first_batch_handled.Notify();
+    destroyed.WaitForNotification();
+  });
+  release.Notify();
+  first_batch_handled.WaitForNotification();
+  queue.reset();
+  destroyed.Notify();
+  thread->BlockingCall([] {});
+
+  EXPECT_EQ(handled, 8);
+}
+
+}  // namespace
+}  // namespace media_api_samples
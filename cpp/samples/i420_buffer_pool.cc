@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/i420_buffer_pool.h"
+
+#include <memory>
+#include <utility>
+
+#include "libyuv/convert.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/nv12_buffer.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/common_video/include/video_frame_buffer_pool.h"
+
+namespace media_api_samples {
+
+rtc::scoped_refptr<webrtc::I420BufferInterface> I420BufferPool::ToI420(
+    webrtc::VideoFrameBuffer& buffer) {
+  const webrtc::NV12BufferInterface* nv12 = buffer.GetNV12();
+  if (nv12 == nullptr) {
+    // I420 buffers return themselves.
+    return buffer.ToI420();
+  }
+
+  rtc::scoped_refptr<webrtc::I420Buffer> i420 =
+      CreateBuffer(buffer.width(), buffer.height());
+  if (i420 == nullptr) {
+    return buffer.ToI420();
+  }
+  libyuv::NV12ToI420(nv12->DataY(), nv12->StrideY(), nv12->DataUV(),
+                     nv12->StrideUV(), i420->MutableDataY(), i420->StrideY(),
+                     i420->MutableDataU(), i420->StrideU(),
+                     i420->MutableDataV(), i420->StrideV(), nv12->width(),
+                     nv12->height());
+  return i420;
+}
+
+rtc::scoped_refptr<webrtc::I420BufferInterface> I420BufferPool::Scale(
+    rtc::scoped_refptr<webrtc::I420BufferInterface> buffer, int width,
+    int height) {
+  if (buffer->width() == width && buffer->height() == height) {
+    return buffer;
+  }
+  rtc::scoped_refptr<webrtc::I420Buffer> scaled = CreateBuffer(width, height);
+  if (scaled == nullptr) {
+    scaled = webrtc::I420Buffer::Create(width, height);
+  }
+  scaled->ScaleFrom(*buffer);
+  return scaled;
+}
+
+rtc::scoped_refptr<webrtc::I420Buffer> I420BufferPool::CreateBuffer(
+    int width, int height) {
+  std::unique_ptr<webrtc::VideoFrameBufferPool>& pool =
+      pools_[{width, height}];
+  if (pool == nullptr) {
+    if (pools_.size() > kMaxPooledResolutions) {
+      pools_.clear();
+      return CreateBuffer(width, height);
+    }
+    pool = std::make_unique<webrtc::VideoFrameBufferPool>(
+        /*zero_initialize=*/false, max_buffers_per_resolution_);
+  }
+  return pool->CreateI420Buffer(width, height);
+}
+
+}  // namespace media_api_samples
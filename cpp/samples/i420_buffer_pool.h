@@ -0,0 +1,82 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_I420_BUFFER_POOL_H_
+#define CPP_SAMPLES_I420_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/common_video/include/video_frame_buffer_pool.h"
+
+namespace media_api_samples {
+
+// Converts video frame buffers to I420 into recycled buffers, so that
+// converting a stream does not allocate and fault in a new buffer per frame.
+//
+// Buffers are pooled per resolution, so streams of different resolutions that
+// share a pool do not evict each other's buffers.
+//
+// Not thread-safe: `ToI420` and `Scale` must always be called on the same
+// thread. The returned buffers may be released on any thread.
+class I420BufferPool {
+ public:
+  // `max_buffers_per_resolution` bounds the converted buffers of each
+  // resolution that can be in use at once. Once it is reached, conversions
+  // fall back to allocating a new buffer.
+  explicit I420BufferPool(size_t max_buffers_per_resolution = 8)
+      : max_buffers_per_resolution_(max_buffers_per_resolution) {}
+
+  // I420BufferPool is neither copyable nor movable.
+  I420BufferPool(const I420BufferPool&) = delete;
+  I420BufferPool& operator=(const I420BufferPool&) = delete;
+
+  // Returns `buffer` itself if it is already I420. NV12 buffers, as produced
+  // by hardware decoders, are converted into a pooled buffer, and other buffer
+  // types are converted by `webrtc::VideoFrameBuffer::ToI420`. Returns null if
+  // the buffer could not be converted.
+  rtc::scoped_refptr<webrtc::I420BufferInterface> ToI420(
+      webrtc::VideoFrameBuffer& buffer);
+
+  // Returns `buffer` scaled to `width` by `height`, in a pooled buffer if one
+  // is available. Returns `buffer` itself if it already has that resolution.
+  rtc::scoped_refptr<webrtc::I420BufferInterface> Scale(
+      rtc::scoped_refptr<webrtc::I420BufferInterface> buffer, int width,
+      int height);
+
+ private:
+  // Returns an unused pooled buffer of `width` by `height`, or null if every
+  // pooled buffer of that resolution is still in use.
+  rtc::scoped_refptr<webrtc::I420Buffer> CreateBuffer(int width, int height);
+
+  // Once this many resolutions have been pooled, the pools are reset, so that
+  // resolutions which are no longer received do not hold on to buffers.
+  static constexpr size_t kMaxPooledResolutions = 16;
+
+  const size_t max_buffers_per_resolution_;
+  absl::flat_hash_map<std::pair<int, int>,
+                      std::unique_ptr<webrtc::VideoFrameBufferPool>>
+      pools_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_I420_BUFFER_POOL_H_
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/i420_buffer_pool.h"
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/nv12_buffer.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+
+namespace media_api_samples {
+namespace {
+
+// Creates an NV12 buffer whose luma and chroma bytes identify their positions.
+rtc::scoped_refptr<webrtc::NV12Buffer> CreateNv12Buffer(int width,
+                                                        int height) {
+  rtc::scoped_refptr<webrtc::NV12Buffer> nv12 =
+      webrtc::NV12Buffer::Create(width, height);
+  for (int row = 0; row < height; ++row) {
+    for (int x = 0; x < width; ++x) {
+      nv12->MutableDataY()[row * nv12->StrideY() + x] = row * width + x;
+    }
+  }
+  for (int row = 0; row < nv12->ChromaHeight(); ++row) {
+    for (int x = 0; x < nv12->ChromaWidth(); ++x) {
+      uint8_t* uv = nv12->MutableDataUV() + row * nv12->StrideUV() + 2 * x;
+      uv[0] = 100 + row;
+      uv[1] = 200 + x;
+    }
+  }
+  return nv12;
+}
+
+TEST(I420BufferPoolTest, ReturnsI420BuffersThemselves) {
+  I420BufferPool pool;
+  rtc::scoped_refptr<webrtc::I420Buffer> i420 =
+      webrtc::I420Buffer::Create(4, 2);
+
+  EXPECT_EQ(pool.ToI420(*i420).get(), i420.get());
+}
+
+TEST(I420BufferPoolTest, ConvertsNv12Buffers) {
+  I420BufferPool pool;
+  rtc::scoped_refptr<webrtc::NV12Buffer> nv12 = CreateNv12Buffer(4, 3);
+
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420 = pool.ToI420(*nv12);
+
+  ASSERT_NE(i420, nullptr);
+  rtc::scoped_refptr<webrtc::I420BufferInterface> expected = nv12->ToI420();
+  ASSERT_EQ(i420->width(), 4);
+  ASSERT_EQ(i420->height(), 3);
+  for (int row = 0; row < 3; ++row) {
+    for (int x = 0; x < 4; ++x) {
+      EXPECT_EQ(i420->DataY()[row * i420->StrideY() + x],
+                expected->DataY()[row * expected->StrideY() + x]);
+    }
+  }
+  for (int row = 0; row < 2; ++row) {
+    for (int x = 0; x < 2; ++x) {
+      EXPECT_EQ(i420->DataU()[row * i420->StrideU() + x], 100 + row);
+      EXPECT_EQ(i420->DataV()[row * i420->StrideV() + x], 200 + x);
+    }
+  }
+}
+
+TEST(I420BufferPoolTest, ReusesReleasedBuffers) {
+  I420BufferPool pool;
+  rtc::scoped_refptr<webrtc::NV12Buffer> nv12 = CreateNv12Buffer(4, 2);
+
+  const uint8_t* first_data = pool.ToI420(*nv12)->DataY();
+  const uint8_t* second_data = pool.ToI420(*nv12)->DataY();
+
+  EXPECT_EQ(first_data, second_data);
+}
+
+TEST(I420BufferPoolTest, KeepsBuffersOfEachResolution) {
+  I420BufferPool pool;
+  rtc::scoped_refptr<webrtc::NV12Buffer> small = CreateNv12Buffer(4, 2);
+  rtc::scoped_refptr<webrtc::NV12Buffer> large = CreateNv12Buffer(8, 4);
+
+  const uint8_t* small_data = pool.ToI420(*small)->DataY();
+  const uint8_t* large_data = pool.ToI420(*large)->DataY();
+
+  EXPECT_EQ(pool.ToI420(*small)->DataY(), small_data);
+  EXPECT_EQ(pool.ToI420(*large)->DataY(), large_data);
+}
+
+TEST(I420BufferPoolTest, AllocatesBuffersOncePoolIsExhausted) {
+  I420BufferPool pool(/*max_buffers_per_resolution=*/1);
+  rtc::scoped_refptr<webrtc::NV12Buffer> nv12 = CreateNv12Buffer(4, 2);
+
+  rtc::scoped_refptr<webrtc::I420BufferInterface> first = pool.ToI420(*nv12);
+  rtc::scoped_refptr<webrtc::I420BufferInterface> second = pool.ToI420(*nv12);
+
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  EXPECT_NE(first->DataY(), second->DataY());
+}
+
+TEST(I420BufferPoolTest, ReturnsBuffersOfRequestedResolutionThemselves) {
+  I420BufferPool pool;
+  rtc::scoped_refptr<webrtc::I420Buffer> i420 =
+      webrtc::I420Buffer::Create(4, 2);
+
+  EXPECT_EQ(pool.Scale(i420, 4, 2).get(), i420.get());
+}
+
+TEST(I420BufferPoolTest, ScalesIntoReleasedBuffers) {
+  I420BufferPool pool;
+  rtc::scoped_refptr<webrtc::I420Buffer> i420 =
+      webrtc::I420Buffer::Create(8, 4);
+
+  rtc::scoped_refptr<webrtc::I420BufferInterface> scaled =
+      pool.Scale(i420, 4, 2);
+  ASSERT_NE(scaled, nullptr);
+  EXPECT_EQ(scaled->width(), 4);
+  EXPECT_EQ(scaled->height(), 2);
+  const uint8_t* first_data = scaled->DataY();
+  scaled = nullptr;
+
+  EXPECT_EQ(pool.Scale(i420, 4, 2)->DataY(), first_data);
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_LITTLE_ENDIAN_H_
+#define CPP_SAMPLES_LITTLE_ENDIAN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "absl/strings/string_view.h"
+
+namespace media_api_samples {
+
+// Helpers for the binary formats written by the samples, e.g. session traces
+// and segment catalogs, which store integers in little-endian byte order so
+// that files can be read on any host.
+
+// Writes `value` at `offset` in `buffer`, and returns the offset after it.
+template <typename T>
+size_t PutLittleEndian(char* buffer, size_t offset, T value) {
+  static_assert(std::is_integral_v<T>);
+  auto bits = static_cast<std::make_unsigned_t<T>>(value);
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    buffer[offset + i] = static_cast<char>(bits >> (8 * i));
+  }
+  return offset + sizeof(T);
+}
+
+// Reads a `T` from the front of `data`, and removes it. Returns false if
+// `data` is too short.
+template <typename T>
+bool TakeLittleEndian(absl::string_view& data, T& value) {
+  static_assert(std::is_integral_v<T>);
+  if (data.size() < sizeof(T)) {
+    return false;
+  }
+  std::make_unsigned_t<T> bits = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bits |= static_cast<std::make_unsigned_t<T>>(
+                static_cast<uint8_t>(data[i]))
+            << (8 * i);
+  }
+  value = static_cast<T>(bits);
+  data.remove_prefix(sizeof(T));
+  return true;
+}
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_LITTLE_ENDIAN_H_
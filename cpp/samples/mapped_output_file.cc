@@ -0,0 +1,169 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/mapped_output_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "cpp/internal/trace_events.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+// Allocates disk space for the bytes [offset, offset + length) of the file.
+// Extending the file with `ftruncate` instead would leave it sparse, so
+// running out of space would raise SIGBUS on a write to the mapping rather
+// than fail here. Returns an error number, or 0 on success.
+int AllocateFile(int fd, size_t offset, size_t length) {
+  return posix_fallocate(fd, offset, length);
+}
+
+char* MapFile(int fd, size_t size) {
+  void* mapping =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, /*offset=*/0);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  return static_cast<char*>(mapping);
+}
+
+// Unmaps and closes the file, dropping the unused tail of its last extent.
+void CloseMappedFile(int fd, char* mapping, size_t capacity, size_t size) {
+  if (mapping != nullptr) {
+    munmap(mapping, capacity);
+  }
+  if (ftruncate(fd, size) != 0) {
+    LOG(ERROR) << "Failed to truncate mapped output file: "
+               << std::strerror(errno);
+  }
+  close(fd);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<MappedOutputFile>> MappedOutputFile::Create(
+    absl::string_view file_name, size_t extent_size,
+    rtc::Thread* close_thread) {
+  if (extent_size == 0) {
+    return absl::InvalidArgumentError("Extent size must be greater than 0");
+  }
+
+  int fd = open(std::string(file_name).c_str(), O_RDWR | O_CREAT | O_TRUNC,
+                /*mode=*/0644);
+  if (fd < 0) {
+    return absl::ErrnoToStatus(errno,
+                               absl::StrCat("Failed to open ", file_name));
+  }
+  if (int error = AllocateFile(fd, /*offset=*/0, extent_size); error != 0) {
+    absl::Status status = absl::ErrnoToStatus(
+        error, absl::StrCat("Failed to preallocate ", file_name));
+    close(fd);
+    return status;
+  }
+  char* mapping = MapFile(fd, extent_size);
+  if (mapping == nullptr) {
+    absl::Status status =
+        absl::ErrnoToStatus(errno, absl::StrCat("Failed to map ", file_name));
+    close(fd);
+    return status;
+  }
+  return absl::WrapUnique(
+      new MappedOutputFile(fd, extent_size, mapping, close_thread));
+}
+
+void MappedOutputFile::Write(const char* content, std::streamsize size) {
+  MEET_TRACE_EVENT("MappedOutputFile::Write");
+  if (mapping_ == nullptr || size <= 0) {
+    return;
+  }
+  if (!Reserve(size_ + size)) {
+    LOG(ERROR) << "Failed to grow mapped output file; dropping further writes";
+    return;
+  }
+  std::memcpy(mapping_ + size_, content, size);
+  size_ += size;
+}
+
+bool MappedOutputFile::Reserve(size_t size) {
+  if (size <= capacity_) {
+    return true;
+  }
+  size_t capacity = (size + extent_size_ - 1) / extent_size_ * extent_size_;
+  // The mapping is only grown once the space for it has been allocated.
+  if (int error = AllocateFile(fd_, capacity_, capacity - capacity_);
+      error != 0) {
+    LOG(ERROR) << "Failed to preallocate mapped output file: "
+               << std::strerror(error);
+    munmap(mapping_, capacity_);
+    mapping_ = nullptr;
+    return false;
+  }
+  munmap(mapping_, capacity_);
+  mapping_ = MapFile(fd_, capacity);
+  if (mapping_ == nullptr) {
+    return false;
+  }
+  capacity_ = capacity;
+  return true;
+}
+
+void MappedOutputFile::Close() {
+  MEET_TRACE_EVENT("MappedOutputFile::Close");
+  if (fd_ < 0) {
+    return;
+  }
+  CloseMappedFile(std::exchange(fd_, -1), std::exchange(mapping_, nullptr),
+                  capacity_, size_);
+}
+
+void MappedOutputFile::CloseAsync(absl::AnyInvocable<void() &&> on_closed) {
+  if (close_thread_ == nullptr || fd_ < 0) {
+    Close();
+    std::move(on_closed)();
+    return;
+  }
+  // The mapping and descriptor are handed over to the task, so the writer can
+  // be destroyed while the file is still closing.
+  close_thread_->PostTask([fd = std::exchange(fd_, -1),
+                           mapping = std::exchange(mapping_, nullptr),
+                           capacity = capacity_, size = size_,
+                           on_closed = std::move(on_closed)]() mutable {
+    MEET_TRACE_EVENT("MappedOutputFile::Close");
+    CloseMappedFile(fd, mapping, capacity, size);
+    std::move(on_closed)();
+  });
+}
+
+}  // namespace media_api_samples
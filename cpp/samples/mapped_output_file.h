@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_MAPPED_OUTPUT_FILE_H_
+#define CPP_SAMPLES_MAPPED_OUTPUT_FILE_H_
+
+#include <cstddef>
+#include <ios>
+#include <memory>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+
+// 1 MiB holds roughly 11 seconds of 48 kHz mono PCM16 audio.
+inline constexpr size_t kDefaultMappedExtentSize = 1024 * 1024;
+
+// An output writer that writes to a local file through a shared memory
+// mapping.
+//
+// The file is preallocated in extents of `extent_size` bytes, so writes are
+// copies into the mapping and only grow the file once an extent is full. Disk
+// space is allocated for each extent before it is mapped, so running out of
+// space fails the write that needed the extent; that write and every later
+// one are dropped. The kernel writes dirty pages back to the file in the
+// background. Closing the writer truncates the file to the number of bytes
+// written.
+//
+// Until it has closed, the file is larger than the bytes written, so callers
+// that give the file its final name should rename it from the `CloseAsync`
+// callback, which runs once the file has been truncated. The file may still be
+// renamed while it is open.
+//
+// If `close_thread` is set, `CloseAsync` unmaps and truncates the file on that
+// thread, so that closing many files at once, e.g. every segment of a
+// conference that has ended, is not serialized on the writing thread. The
+// writer may be destroyed before it has finished closing.
+class MappedOutputFile : public OutputWriterInterface {
+ public:
+  // Creates or truncates `file_name` and maps its first extent.
+  //
+  // `close_thread` must outlive the writer and its pending close.
+  static absl::StatusOr<std::unique_ptr<MappedOutputFile>> Create(
+      absl::string_view file_name,
+      size_t extent_size = kDefaultMappedExtentSize,
+      rtc::Thread* close_thread = nullptr);
+
+  ~MappedOutputFile() override { Close(); }
+
+  // MappedOutputFile is neither copyable nor movable.
+  MappedOutputFile(const MappedOutputFile&) = delete;
+  MappedOutputFile& operator=(const MappedOutputFile&) = delete;
+
+  void Write(const char* content, std::streamsize size) override;
+  void Close() override;
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed) override;
+
+ private:
+  MappedOutputFile(int fd, size_t extent_size, char* mapping,
+                   rtc::Thread* close_thread)
+      : fd_(fd),
+        extent_size_(extent_size),
+        mapping_(mapping),
+        capacity_(extent_size),
+        close_thread_(close_thread) {}
+
+  // Grows the file and its mapping to hold at least `size` bytes. Returns
+  // false if the file could not be grown.
+  bool Reserve(size_t size);
+
+  int fd_;
+  const size_t extent_size_;
+  // Null once closed, or if growing the file failed.
+  char* mapping_;
+  size_t capacity_;
+  size_t size_ = 0;
+  // Null if the file is closed on the calling thread.
+  rtc::Thread* close_thread_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_MAPPED_OUTPUT_FILE_H_
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/mapped_output_file.h"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::status::StatusIs;
+
+std::string ReadFile(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+TEST(MappedOutputFileTest, WritesAndTruncatesToWrittenSize) {
+  std::string file_name = ::testing::TempDir() + "/mapped_output_file_1";
+  absl::StatusOr<std::unique_ptr<MappedOutputFile>> file =
+      MappedOutputFile::Create(file_name, /*extent_size=*/16);
+  ASSERT_OK(file);
+
+  (*file)->Write("abc", 3);
+  (*file)->Write("def", 3);
+  (*file)->Close();
+
+  EXPECT_EQ(ReadFile(file_name), "abcdef");
+}
+
+TEST(MappedOutputFileTest, GrowsPastExtentSize) {
+  std::string file_name = ::testing::TempDir() + "/mapped_output_file_2";
+  absl::StatusOr<std::unique_ptr<MappedOutputFile>> file =
+      MappedOutputFile::Create(file_name, /*extent_size=*/4);
+  ASSERT_OK(file);
+
+  (*file)->Write("abc", 3);
+  // Crosses into the second and third extents.
+  (*file)->Write("defghij", 7);
+  (*file)->Close();
+
+  EXPECT_EQ(ReadFile(file_name), "abcdefghij");
+}
+
+TEST(MappedOutputFileTest, PreallocatesExtentWhileOpen) {
+  std::string file_name = ::testing::TempDir() + "/mapped_output_file_3";
+  absl::StatusOr<std::unique_ptr<MappedOutputFile>> file =
+      MappedOutputFile::Create(file_name, /*extent_size=*/8);
+  ASSERT_OK(file);
+
+  (*file)->Write("ab", 2);
+
+  EXPECT_EQ(ReadFile(file_name).size(), 8);
+}
+
+TEST(MappedOutputFileTest, AllocatesDiskSpaceForExtents) {
+  std::string file_name = ::testing::TempDir() + "/mapped_output_file_7";
+  absl::StatusOr<std::unique_ptr<MappedOutputFile>> file =
+      MappedOutputFile::Create(file_name, /*extent_size=*/64 * 1024);
+  ASSERT_OK(file);
+
+  // Grows the file into a second extent.
+  std::string content(96 * 1024, 'a');
+  (*file)->Write(content.data(), content.size());
+
+  struct stat file_stat;
+  ASSERT_EQ(stat(file_name.c_str(), &file_stat), 0);
+  // The file is not sparse: both extents are backed by disk blocks.
+  EXPECT_GE(file_stat.st_blocks * 512, 128 * 1024);
+  (*file)->Close();
+  EXPECT_EQ(ReadFile(file_name), content);
+}
+
+TEST(MappedOutputFileTest, KeepsWritingAfterRename) {
+  std::string file_name = ::testing::TempDir() + "/mapped_output_file_4";
+  std::string renamed_file_name =
+      ::testing::TempDir() + "/mapped_output_file_4_renamed";
+  absl::StatusOr<std::unique_ptr<MappedOutputFile>> file =
+      MappedOutputFile::Create(file_name, /*extent_size=*/4);
+  ASSERT_OK(file);
+
+  (*file)->Write("abc", 3);
+  ASSERT_EQ(std::rename(file_name.c_str(), renamed_file_name.c_str()), 0);
+  (*file)->Write("def", 3);
+  (*file)->Close();
+
+  EXPECT_EQ(ReadFile(renamed_file_name), "abcdef");
+}
+
+TEST(MappedOutputFileTest, DestructorClosesFile) {
+  std::string file_name = ::testing::TempDir() + "/mapped_output_file_5";
+  {
+    absl::StatusOr<std::unique_ptr<MappedOutputFile>> file =
+        MappedOutputFile::Create(file_name, /*extent_size=*/16);
+    ASSERT_OK(file);
+    (*file)->Write("abc", 3);
+  }
+
+  EXPECT_EQ(ReadFile(file_name), "abc");
+}
+
+TEST(MappedOutputFileTest, ClosesOnCloseThreadAfterWriterIsDestroyed) {
+  std::string file_name = ::testing::TempDir() + "/mapped_output_file_6";
+  std::unique_ptr<rtc::Thread> close_thread = rtc::Thread::Create();
+  close_thread->Start();
+  absl::Notification closed;
+  {
+    absl::StatusOr<std::unique_ptr<MappedOutputFile>> file =
+        MappedOutputFile::Create(file_name, /*extent_size=*/16,
+                                 close_thread.get());
+    ASSERT_OK(file);
+    (*file)->Write("abc", 3);
+    (*file)->CloseAsync([&] {
+      EXPECT_TRUE(close_thread->IsCurrent());
+      closed.Notify();
+    });
+  }
+
+  ASSERT_TRUE(closed.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_EQ(ReadFile(file_name), "abc");
+}
+
+TEST(MappedOutputFileTest, TruncatesFileBeforeInvokingCloseCallback) {
+  std::string file_name = ::testing::TempDir() + "/mapped_output_file_8";
+  std::string renamed_file_name =
+      ::testing::TempDir() + "/mapped_output_file_8_renamed";
+  std::unique_ptr<rtc::Thread> close_thread = rtc::Thread::Create();
+  close_thread->Start();
+  absl::Notification closed;
+  absl::StatusOr<std::unique_ptr<MappedOutputFile>> file =
+      MappedOutputFile::Create(file_name, /*extent_size=*/16,
+                               close_thread.get());
+  ASSERT_OK(file);
+
+  (*file)->Write("abcde", 5);
+  (*file)->CloseAsync([&] {
+    struct stat file_stat;
+    ASSERT_EQ(stat(file_name.c_str(), &file_stat), 0);
+    EXPECT_EQ(file_stat.st_size, 5);
+    EXPECT_EQ(std::rename(file_name.c_str(), renamed_file_name.c_str()), 0);
+    closed.Notify();
+  });
+
+  ASSERT_TRUE(closed.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_EQ(ReadFile(renamed_file_name), "abcde");
+}
+
+TEST(MappedOutputFileTest, CreateFailsWithZeroExtentSize) {
+  EXPECT_THAT(MappedOutputFile::Create(
+                  ::testing::TempDir() + "/mapped_output_file_6",
+                  /*extent_size=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Extent size must be greater than 0"));
+}
+
+TEST(MappedOutputFileTest, CreateFailsIfFileCannotBeOpened) {
+  EXPECT_THAT(
+      MappedOutputFile::Create(::testing::TempDir() + "/missing/mapped_file"),
+      StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -16,10 +16,26 @@
 
 #include "cpp/samples/media_writing.h"
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <optional>
+#include <string>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "cpp/samples/output_writer_interface.h"
+#include "libyuv/convert_argb.h"
+#include "libyuv/convert_from.h"
+#include "libyuv/planar_functions.h"
+#include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/video/video_frame_buffer.h"
 
 namespace media_api_samples {
@@ -30,15 +46,35 @@ namespace media_api_samples {
 //
 // See webrtc/rtc_base/byte_order.h.
 
-void WritePcm16(const std::vector<int16_t>& pcm16,
-                OutputWriterInterface& writer) {
-  for (int16_t sample : pcm16) {
-    writer.Write(reinterpret_cast<const char*>(&sample), sizeof(sample));
+namespace {
+
+// Appends the visible part of a plane to `chunks`.
+//
+// When reading planes from their buffers, the stride for each plane is
+// expected to be greater than or equal to the width of the plane. This is
+// because `stride` is the width of the memory block, while `width` is the width
+// of the image. Rows are therefore only contiguous when `stride` equals
+// `width`; otherwise, each row is appended as a separate chunk.
+void AppendPlane(const uint8_t* plane, int stride, int width, int height,
+                 std::vector<OutputWriterInterface::Chunk>& chunks) {
+  if (stride == width) {
+    chunks.push_back({.content = reinterpret_cast<const char*>(plane),
+                      .size = static_cast<std::streamsize>(width) * height});
+    return;
+  }
+  for (int i = 0; i < height; ++i) {
+    chunks.push_back(
+        {.content = reinterpret_cast<const char*>(plane + i * stride),
+         .size = width});
   }
 }
 
-void WriteYuv420(const webrtc::I420BufferInterface& i420,
-                 OutputWriterInterface& writer) {
+constexpr absl::string_view kY4mFrameMarker = "FRAME\n";
+
+// Appends the visible parts of the Y (luma), U and V (chroma) planes to
+// `chunks`.
+void AppendYuv420Planes(const webrtc::I420BufferInterface& i420,
+                        std::vector<OutputWriterInterface::Chunk>& chunks) {
   int width = i420.width();
   int height = i420.height();
   // Chroma planes (U and V) are half the width and height of the luma plane
@@ -46,36 +82,328 @@ void WriteYuv420(const webrtc::I420BufferInterface& i420,
   int chroma_width = (width + 1) / 2;    // Increment by 1 for rounding
   int chroma_height = (height + 1) / 2;  // Increment by 1 for rounding
 
-  // When reading the Y, U, and V planes from their buffers, the stride for each
-  // plane is expected to be greater than or equal to the width of the plane.
-  // This is because `stride` is the width of the memory block, while `width` is
-  // the width of the image.
-  //
-  // As a result, reading the planes works by advancing the pointer by `stride`
-  // each time but only reading `width` bytes from that pointer.
-
-  // Write Y plane (luma plane).
-  const uint8_t* y_plane = i420.DataY();
-  int y_stride = i420.StrideY();
-  for (int i = 0; i < height; ++i) {
-    writer.Write(reinterpret_cast<const char*>(y_plane + i * y_stride), width);
+  chunks.reserve(chunks.size() + height + 2 * chroma_height);
+  AppendPlane(i420.DataY(), i420.StrideY(), width, height, chunks);
+  AppendPlane(i420.DataU(), i420.StrideU(), chroma_width, chroma_height,
+              chunks);
+  AppendPlane(i420.DataV(), i420.StrideV(), chroma_width, chroma_height,
+              chunks);
+}
+
+bool HasSamePlanePixels(const uint8_t* a, int a_stride, const uint8_t* b,
+                        int b_stride, int width, int height) {
+  for (int row = 0; row < height; ++row) {
+    if (std::memcmp(a + row * a_stride, b + row * b_stride, width) != 0) {
+      return false;
+    }
   }
+  return true;
+}
 
-  // Write U plane (first chroma plane).
-  const uint8_t* u_plane = i420.DataU();
-  int u_stride = i420.StrideU();
-  for (int i = 0; i < chroma_height; ++i) {
-    writer.Write(reinterpret_cast<const char*>(u_plane + i * u_stride),
-                 chroma_width);
+// WAV, IVF and Y4M headers are little-endian regardless of the host's byte
+// order.
+template <typename T>
+void StoreLittleEndian(T value, uint8_t* destination) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    destination[i] = static_cast<uint8_t>(value >> (8 * i));
   }
+}
+
+}  // namespace
+
+void WritePcm16(absl::Span<const int16_t> pcm16,
+                OutputWriterInterface& writer) {
+  if (pcm16.empty()) {
+    return;
+  }
+  // Samples are contiguous, so the whole buffer is written in a single call.
+  writer.Write(reinterpret_cast<const char*>(pcm16.data()),
+               pcm16.size() * sizeof(int16_t));
+}
+
+void WriteYuv420(const webrtc::I420BufferInterface& i420,
+                 OutputWriterInterface& writer) {
+  // Gather the planes so that the frame is handed to the writer in a single
+  // call.
+  std::vector<OutputWriterInterface::Chunk> chunks;
+  AppendYuv420Planes(i420, chunks);
+  writer.WriteVectored(chunks);
+}
+
+bool HasSameYuv420Pixels(const webrtc::I420BufferInterface& a,
+                         const webrtc::I420BufferInterface& b) {
+  int width = a.width();
+  int height = a.height();
+  if (width != b.width() || height != b.height()) {
+    return false;
+  }
+  int chroma_width = (width + 1) / 2;
+  int chroma_height = (height + 1) / 2;
+  // Luma is compared first since it is the most likely to change.
+  return HasSamePlanePixels(a.DataY(), a.StrideY(), b.DataY(), b.StrideY(),
+                            width, height) &&
+         HasSamePlanePixels(a.DataU(), a.StrideU(), b.DataU(), b.StrideU(),
+                            chroma_width, chroma_height) &&
+         HasSamePlanePixels(a.DataV(), a.StrideV(), b.DataV(), b.StrideV(),
+                            chroma_width, chroma_height);
+}
+
+std::optional<VideoPixelFormat> ParseVideoPixelFormat(absl::string_view name) {
+  if (name == "i420") {
+    return VideoPixelFormat::kI420;
+  }
+  if (name == "nv12") {
+    return VideoPixelFormat::kNv12;
+  }
+  if (name == "rgb24") {
+    return VideoPixelFormat::kRgb24;
+  }
+  if (name == "bgra") {
+    return VideoPixelFormat::kBgra;
+  }
+  return std::nullopt;
+}
+
+size_t VideoFrameSize(VideoPixelFormat format, int width, int height) {
+  size_t pixel_count = static_cast<size_t>(width) * height;
+  switch (format) {
+    case VideoPixelFormat::kI420:
+    case VideoPixelFormat::kNv12:
+      return pixel_count +
+             2 * static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+    case VideoPixelFormat::kRgb24:
+      return 3 * pixel_count;
+    case VideoPixelFormat::kBgra:
+      return 4 * pixel_count;
+  }
+  return 0;
+}
+
+absl::string_view RawVideoFileExtension(VideoPixelFormat format) {
+  switch (format) {
+    case VideoPixelFormat::kI420:
+      return ".yuv";
+    case VideoPixelFormat::kNv12:
+      return ".nv12";
+    case VideoPixelFormat::kRgb24:
+      return ".rgb";
+    case VideoPixelFormat::kBgra:
+      return ".bgra";
+  }
+  return "";
+}
 
-  // Write V plane (second chroma plane).
-  const uint8_t* v_plane = i420.DataV();
-  int v_stride = i420.StrideV();
-  for (int i = 0; i < chroma_height; ++i) {
-    writer.Write(reinterpret_cast<const char*>(v_plane + i * v_stride),
-                 chroma_width);
+bool ConvertYuv420(const webrtc::I420BufferInterface& i420,
+                   VideoPixelFormat format, absl::Span<uint8_t> output) {
+  if (output.size() < VideoFrameSize(format, i420.width(), i420.height())) {
+    return false;
   }
+  int width = i420.width();
+  int height = i420.height();
+  int chroma_width = (width + 1) / 2;
+  uint8_t* destination = output.data();
+  switch (format) {
+    case VideoPixelFormat::kI420: {
+      uint8_t* destination_u = destination + width * height;
+      uint8_t* destination_v =
+          destination_u + chroma_width * ((height + 1) / 2);
+      libyuv::I420Copy(i420.DataY(), i420.StrideY(), i420.DataU(),
+                       i420.StrideU(), i420.DataV(), i420.StrideV(),
+                       destination, width, destination_u, chroma_width,
+                       destination_v, chroma_width, width, height);
+      break;
+    }
+    case VideoPixelFormat::kNv12:
+      libyuv::I420ToNV12(i420.DataY(), i420.StrideY(), i420.DataU(),
+                         i420.StrideU(), i420.DataV(), i420.StrideV(),
+                         destination, width, destination + width * height,
+                         2 * chroma_width, width, height);
+      break;
+    case VideoPixelFormat::kRgb24:
+      // libyuv names formats by their little-endian word order, so its RAW
+      // format is the R, G, B byte order written here, and RGB24 is B, G, R.
+      libyuv::I420ToRAW(i420.DataY(), i420.StrideY(), i420.DataU(),
+                        i420.StrideU(), i420.DataV(), i420.StrideV(),
+                        destination, 3 * width, width, height);
+      break;
+    case VideoPixelFormat::kBgra:
+      // Likewise, libyuv's ARGB is the B, G, R, A byte order.
+      libyuv::I420ToARGB(i420.DataY(), i420.StrideY(), i420.DataU(),
+                         i420.StrideU(), i420.DataV(), i420.StrideV(),
+                         destination, 4 * width, width, height);
+      break;
+  }
+  return true;
+}
+
+void WriteRawVideoFrame(const webrtc::I420BufferInterface& i420,
+                        VideoPixelFormat format,
+                        std::vector<uint8_t>& conversion_buffer,
+                        OutputWriterInterface& writer) {
+  if (format == VideoPixelFormat::kI420) {
+    // Planes are written from the buffer without copying them.
+    std::vector<OutputWriterInterface::Chunk> chunks;
+    AppendYuv420Planes(i420, chunks);
+    writer.WriteVectored(chunks);
+    return;
+  }
+  conversion_buffer.resize(
+      VideoFrameSize(format, i420.width(), i420.height()));
+  ConvertYuv420(i420, format, absl::MakeSpan(conversion_buffer));
+  writer.Write(reinterpret_cast<const char*>(conversion_buffer.data()),
+               static_cast<std::streamsize>(conversion_buffer.size()));
+}
+
+bool WriteVideoFrameBuffer(webrtc::VideoFrameBuffer& buffer,
+                           OutputWriterInterface& writer) {
+  if (const webrtc::I420BufferInterface* i420 = buffer.GetI420();
+      i420 != nullptr) {
+    WriteYuv420(*i420, writer);
+    return true;
+  }
+
+  rtc::scoped_refptr<webrtc::I420BufferInterface> converted = buffer.ToI420();
+  if (converted == nullptr) {
+    return false;
+  }
+  WriteYuv420(*converted, writer);
+  return true;
+}
+
+void WriteWavFileHeader(int sample_rate, int channel_count,
+                        OutputWriterInterface& writer) {
+  constexpr uint16_t kBitsPerSample = 16;
+  constexpr uint32_t kUnknownChunkSize = 0xFFFFFFFF;
+  uint16_t block_align = channel_count * kBitsPerSample / 8;
+
+  std::array<uint8_t, kWavFileHeaderSize> header = {'R', 'I', 'F', 'F'};
+  StoreLittleEndian<uint32_t>(kUnknownChunkSize, &header[4]);
+  header[8] = 'W';
+  header[9] = 'A';
+  header[10] = 'V';
+  header[11] = 'E';
+  header[12] = 'f';
+  header[13] = 'm';
+  header[14] = 't';
+  header[15] = ' ';
+  StoreLittleEndian<uint32_t>(/*fmt chunk size=*/16, &header[16]);
+  StoreLittleEndian<uint16_t>(/*format=PCM*/ 1, &header[20]);
+  StoreLittleEndian<uint16_t>(channel_count, &header[22]);
+  StoreLittleEndian<uint32_t>(sample_rate, &header[24]);
+  StoreLittleEndian<uint32_t>(sample_rate * block_align, &header[28]);
+  StoreLittleEndian<uint16_t>(block_align, &header[32]);
+  StoreLittleEndian<uint16_t>(kBitsPerSample, &header[34]);
+  header[36] = 'd';
+  header[37] = 'a';
+  header[38] = 't';
+  header[39] = 'a';
+  StoreLittleEndian<uint32_t>(kUnknownChunkSize, &header[40]);
+  writer.Write(reinterpret_cast<const char*>(header.data()), header.size());
+}
+
+absl::Status FinalizeWavFileHeader(absl::string_view file_name) {
+  std::fstream file(std::string(file_name),
+                    std::ios::binary | std::ios::in | std::ios::out);
+  if (!file.is_open()) {
+    return absl::NotFoundError(
+        absl::StrCat("Failed to open WAV file: ", file_name));
+  }
+  file.seekg(0, std::ios::end);
+  std::streamoff file_size = file.tellg();
+  if (file_size < static_cast<std::streamoff>(kWavFileHeaderSize)) {
+    return absl::DataLossError(
+        absl::StrCat("WAV file is shorter than its header: ", file_name));
+  }
+  if (file_size - 8 > std::numeric_limits<uint32_t>::max()) {
+    return absl::OkStatus();
+  }
+
+  uint8_t riff_size[4];
+  StoreLittleEndian(static_cast<uint32_t>(file_size - 8), riff_size);
+  uint8_t data_size[4];
+  StoreLittleEndian(static_cast<uint32_t>(file_size - kWavFileHeaderSize),
+                    data_size);
+  file.seekp(4);
+  file.write(reinterpret_cast<const char*>(riff_size), sizeof(riff_size));
+  file.seekp(40);
+  file.write(reinterpret_cast<const char*>(data_size), sizeof(data_size));
+  file.close();
+  if (file.fail()) {
+    return absl::DataLossError(
+        absl::StrCat("Failed to write WAV chunk sizes: ", file_name));
+  }
+  return absl::OkStatus();
+}
+
+void WriteY4mFileHeader(int width, int height, int frame_rate,
+                        OutputWriterInterface& writer) {
+  // Frames are progressive with square pixels, and chroma is sampled as in
+  // WebRTC's I420 buffers.
+  std::string header = absl::StrCat("YUV4MPEG2 W", width, " H", height, " F",
+                                    frame_rate, ":1 Ip A1:1 C420jpeg\n");
+  writer.Write(header.data(), header.size());
+}
+
+bool WriteY4mFrame(webrtc::VideoFrameBuffer& buffer,
+                   OutputWriterInterface& writer) {
+  // I420 buffers return themselves, so only other buffer types are converted.
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420 = buffer.ToI420();
+  if (i420 == nullptr) {
+    return false;
+  }
+  // Write the frame marker and planes in a single call.
+  std::vector<OutputWriterInterface::Chunk> chunks = {
+      {.content = kY4mFrameMarker.data(),
+       .size = static_cast<std::streamsize>(kY4mFrameMarker.size())}};
+  AppendYuv420Planes(*i420, chunks);
+  writer.WriteVectored(chunks);
+  return true;
+}
+
+std::optional<absl::string_view> IvfFourccForMimeType(
+    absl::string_view mime_type) {
+  if (mime_type == "video/VP8") {
+    return "VP80";
+  }
+  if (mime_type == "video/VP9") {
+    return "VP90";
+  }
+  if (mime_type == "video/AV1") {
+    return "AV01";
+  }
+  return std::nullopt;
+}
+
+void WriteIvfFileHeader(absl::string_view fourcc, int width, int height,
+                        OutputWriterInterface& writer) {
+  std::array<uint8_t, 32> header = {'D', 'K', 'I', 'F'};
+  StoreLittleEndian<uint16_t>(/*version=*/0, &header[4]);
+  StoreLittleEndian<uint16_t>(header.size(), &header[6]);
+  for (size_t i = 0; i < 4 && i < fourcc.size(); ++i) {
+    header[8 + i] = static_cast<uint8_t>(fourcc[i]);
+  }
+  StoreLittleEndian<uint16_t>(width, &header[12]);
+  StoreLittleEndian<uint16_t>(height, &header[14]);
+  // The time base is 1/90000, matching the RTP clock rate of video.
+  StoreLittleEndian<uint32_t>(/*rate=*/90000, &header[16]);
+  StoreLittleEndian<uint32_t>(/*scale=*/1, &header[20]);
+  // The frame count (bytes 24-27) and reserved bytes (28-31) are left as zero.
+  writer.Write(reinterpret_cast<const char*>(header.data()), header.size());
+}
+
+void WriteIvfFrame(absl::Span<const uint8_t> data, uint64_t timestamp,
+                   OutputWriterInterface& writer) {
+  std::array<uint8_t, 12> header = {};
+  StoreLittleEndian<uint32_t>(data.size(), &header[0]);
+  StoreLittleEndian<uint64_t>(timestamp, &header[4]);
+  std::array<OutputWriterInterface::Chunk, 2> chunks = {
+      OutputWriterInterface::Chunk{
+          .content = reinterpret_cast<const char*>(header.data()),
+          .size = static_cast<std::streamsize>(header.size())},
+      OutputWriterInterface::Chunk{
+          .content = reinterpret_cast<const char*>(data.data()),
+          .size = static_cast<std::streamsize>(data.size())}};
+  writer.WriteVectored(chunks);
 }
 
 }  // namespace media_api_samples
@@ -17,22 +17,137 @@
 #ifndef CPP_SAMPLES_MEDIA_WRITING_H_
 #define CPP_SAMPLES_MEDIA_WRITING_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "cpp/samples/output_writer_interface.h"
 #include "webrtc/api/video/video_frame_buffer.h"
 
 namespace media_api_samples {
 
 // Writes a PCM16 buffer to the output writer.
-void WritePcm16(const std::vector<int16_t>& pcm16,
+void WritePcm16(absl::Span<const int16_t> pcm16,
                 OutputWriterInterface& writer);
 
 // Writes a YUV420p buffer to the output writer.
 void WriteYuv420(const webrtc::I420BufferInterface& i420,
                  OutputWriterInterface& writer);
 
+// Writes a video frame buffer to the output writer as YUV420p.
+//
+// I420 buffers are written directly. Other buffer types (e.g. NV12 or native
+// buffers) are converted first, so callers should pass buffers through
+// unconverted and call this off of WebRTC's threads. Returns false if the
+// buffer could not be converted.
+bool WriteVideoFrameBuffer(webrtc::VideoFrameBuffer& buffer,
+                           OutputWriterInterface& writer);
+
+// Pixel formats that raw video frames can be written in, e.g. for vision
+// models that consume RGB tensors. Frames are tightly packed, with no padding
+// between rows.
+enum class VideoPixelFormat {
+  // Y, U and V planes, as in Y4M files.
+  kI420,
+  // A Y plane followed by a plane of interleaved U and V samples.
+  kNv12,
+  // Packed pixels of 8-bit R, G and B bytes, in that order.
+  kRgb24,
+  // Packed pixels of 8-bit B, G, R and A bytes, in that order. Alpha is always
+  // opaque.
+  kBgra,
+};
+
+// Parses a pixel format from its lowercase name, e.g. "rgb24". Returns nullopt
+// if `name` is not a supported format.
+std::optional<VideoPixelFormat> ParseVideoPixelFormat(absl::string_view name);
+
+// Returns the size of a `width` by `height` frame in `format`.
+size_t VideoFrameSize(VideoPixelFormat format, int width, int height);
+
+// Returns the file extension used for raw frames in `format`, e.g. ".rgb".
+absl::string_view RawVideoFileExtension(VideoPixelFormat format);
+
+// Converts a YUV420p buffer to `format`, writing the frame to `output`.
+// Returns false if `output` is smaller than `VideoFrameSize`.
+//
+// Conversions use libyuv, and RGB conversions use the BT.601 limited range
+// coefficients that WebRTC's decoders produce.
+bool ConvertYuv420(const webrtc::I420BufferInterface& i420,
+                   VideoPixelFormat format, absl::Span<uint8_t> output);
+
+// Writes a YUV420p buffer as a raw frame in `format`, without a frame marker.
+// Frames that need conversion are converted into `conversion_buffer`, which is
+// resized as needed and can be reused across frames to avoid allocations.
+void WriteRawVideoFrame(const webrtc::I420BufferInterface& i420,
+                        VideoPixelFormat format,
+                        std::vector<uint8_t>& conversion_buffer,
+                        OutputWriterInterface& writer);
+
+// Returns whether two YUV420p buffers have the same resolution and pixels.
+//
+// Rows are compared with `memcmp`, which the C library vectorizes, and the
+// comparison stops at the first row that differs.
+bool HasSameYuv420Pixels(const webrtc::I420BufferInterface& a,
+                         const webrtc::I420BufferInterface& b);
+
+// The size of the header written by `WriteWavFileHeader`.
+inline constexpr size_t kWavFileHeaderSize = 44;
+
+// Writes the header that starts a WAV file of interleaved PCM16 samples.
+//
+// The RIFF and data chunk sizes are not known until the file is closed, so
+// they are set to 0xFFFFFFFF, which most readers treat as extending to the end
+// of the file, until `FinalizeWavFileHeader` sets them. Since the header has a
+// fixed size, sample `i` of channel `c` starts at byte
+// `kWavFileHeaderSize + (i * channel_count + c) * 2`.
+void WriteWavFileHeader(int sample_rate, int channel_count,
+                        OutputWriterInterface& writer);
+
+// Sets the RIFF and data chunk sizes in the header of a closed local WAV file,
+// written by `WriteWavFileHeader`, from the size of the file. Files too large
+// for 32-bit chunk sizes keep the unknown sizes.
+absl::Status FinalizeWavFileHeader(absl::string_view file_name);
+
+// Writes the stream header that starts a Y4M file of YUV420p frames.
+//
+// Frames are not timestamped, so `frame_rate` is only the nominal rate at
+// which readers play them back, not the rate at which frames were received:
+// the collectors write 30 frames per second, although Meet sends video at a
+// variable rate. The multi-user collector records each segment's first and
+// last frame times in its file name and catalog entry instead.
+void WriteY4mFileHeader(int width, int height, int frame_rate,
+                        OutputWriterInterface& writer);
+
+// Writes a video frame buffer to a Y4M file, converting it as in
+// `WriteVideoFrameBuffer`. Returns false if the buffer could not be converted.
+//
+// Every frame of a file has the same size, so frames can be seeked to without
+// scanning the file.
+bool WriteY4mFrame(webrtc::VideoFrameBuffer& buffer,
+                   OutputWriterInterface& writer);
+
+// Returns the IVF FourCC for an encoded video MIME type (e.g. "VP80" for
+// "video/VP8"), or nullopt if the codec cannot be written to an IVF file.
+std::optional<absl::string_view> IvfFourccForMimeType(
+    absl::string_view mime_type);
+
+// Writes the 32 byte header that starts an IVF file.
+//
+// The frame count is left as zero, since it is not known until the file is
+// closed and players do not rely on it.
+void WriteIvfFileHeader(absl::string_view fourcc, int width, int height,
+                        OutputWriterInterface& writer);
+
+// Writes an encoded frame to an IVF file, using the frame's 90kHz RTP
+// timestamp as its presentation timestamp.
+void WriteIvfFrame(absl::Span<const uint8_t> data, uint64_t timestamp,
+                   OutputWriterInterface& writer);
+
 }  // namespace media_api_samples
 
 #endif  // CPP_SAMPLES_MEDIA_WRITING_H_
@@ -0,0 +1,431 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/media_writing.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "cpp/samples/output_file.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "cpp/samples/testing/media_data.h"
+#include "cpp/samples/testing/mock_output_writer.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/nv12_buffer.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::AllOf;
+using ::testing::ElementsAre;
+using ::testing::Ge;
+using ::testing::Le;
+using ::testing::Matcher;
+using ::testing::status::StatusIs;
+
+// libyuv's fixed-point color conversions may round the exact BT.601 values
+// either way.
+Matcher<uint8_t> IsNearChannel(int value) {
+  return AllOf(Ge(value - 1), Le(value + 1));
+}
+
+// Records the chunks of each vectored write.
+class RecordingOutputWriter : public OutputWriterInterface {
+ public:
+  void Write(const char* content, std::streamsize size) override {
+    FAIL() << "Expected only vectored writes";
+  }
+  void WriteVectored(absl::Span<const Chunk> chunks) override {
+    ++vectored_write_count;
+    for (const Chunk& chunk : chunks) {
+      chunk_sizes.push_back(chunk.size);
+      content.insert(content.end(), chunk.content, chunk.content + chunk.size);
+    }
+  }
+  void Close() override {}
+
+  int vectored_write_count = 0;
+  std::vector<std::streamsize> chunk_sizes;
+  std::vector<char> content;
+};
+
+TEST(MediaWritingTest, WritePcm16WritesFrameInOneCall) {
+  AudioTestData test_data = CreateAudioTestData(/*num_samples=*/10);
+  MockOutputWriter writer;
+  std::vector<int16_t> written_pcm16;
+  EXPECT_CALL(writer, Write(_, 10 * sizeof(int16_t)))
+      .WillOnce([&](const char* content, std::streamsize size) {
+        const int16_t* samples = reinterpret_cast<const int16_t*>(content);
+        written_pcm16.assign(samples, samples + size / sizeof(int16_t));
+      });
+
+  WritePcm16(test_data.frame.pcm16, writer);
+
+  EXPECT_EQ(written_pcm16, test_data.pcm16);
+}
+
+TEST(MediaWritingTest, WriteYuv420WritesContiguousPlanesInOneChunkEach) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(/*width=*/4, /*height=*/2);
+  RecordingOutputWriter writer;
+
+  WriteYuv420(*buffer, writer);
+
+  EXPECT_EQ(writer.vectored_write_count, 1);
+  EXPECT_THAT(writer.chunk_sizes, ElementsAre(8, 2, 2));
+}
+
+TEST(MediaWritingTest, WriteYuv420WritesPaddedPlanesRowByRow) {
+  VideoTestData test_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  RecordingOutputWriter writer;
+
+  WriteYuv420(*test_data.webrtc_frame->video_frame_buffer()->GetI420(),
+              writer);
+
+  EXPECT_EQ(writer.vectored_write_count, 1);
+  // 5 rows of Y, then 3 rows each of U and V.
+  EXPECT_THAT(writer.chunk_sizes,
+              ElementsAre(10, 10, 10, 10, 10, 5, 5, 5, 5, 5, 5));
+  EXPECT_EQ(writer.content, test_data.yuv_data);
+}
+
+// Returns a `width`x`height` buffer with every pixel set to `value`, with
+// `padding` bytes at the end of each row.
+rtc::scoped_refptr<webrtc::I420Buffer> CreateFilledBuffer(int width,
+                                                          int height,
+                                                          int padding,
+                                                          uint8_t value) {
+  int chroma_width = (width + 1) / 2;
+  int chroma_height = (height + 1) / 2;
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(width, height, width + padding,
+                                 chroma_width + padding,
+                                 chroma_width + padding);
+  std::memset(buffer->MutableDataY(), value, buffer->StrideY() * height);
+  std::memset(buffer->MutableDataU(), value, buffer->StrideU() * chroma_height);
+  std::memset(buffer->MutableDataV(), value, buffer->StrideV() * chroma_height);
+  return buffer;
+}
+
+TEST(MediaWritingTest, HasSameYuv420PixelsIgnoresPadding) {
+  rtc::scoped_refptr<webrtc::I420Buffer> a =
+      CreateFilledBuffer(/*width=*/10, /*height=*/5, /*padding=*/0, 7);
+  rtc::scoped_refptr<webrtc::I420Buffer> b =
+      CreateFilledBuffer(/*width=*/10, /*height=*/5, /*padding=*/6, 7);
+  b->MutableDataY()[10] = 1;
+
+  EXPECT_TRUE(HasSameYuv420Pixels(*a, *b));
+}
+
+TEST(MediaWritingTest, HasSameYuv420PixelsDetectsChangedPixel) {
+  rtc::scoped_refptr<webrtc::I420Buffer> a =
+      CreateFilledBuffer(/*width=*/10, /*height=*/5, /*padding=*/0, 7);
+  rtc::scoped_refptr<webrtc::I420Buffer> b =
+      CreateFilledBuffer(/*width=*/10, /*height=*/5, /*padding=*/0, 7);
+  // The last pixel of the last plane.
+  b->MutableDataV()[b->StrideV() * 2 + 4] = 8;
+
+  EXPECT_FALSE(HasSameYuv420Pixels(*a, *b));
+}
+
+TEST(MediaWritingTest, HasSameYuv420PixelsDetectsResolutionChange) {
+  rtc::scoped_refptr<webrtc::I420Buffer> a =
+      CreateFilledBuffer(/*width=*/10, /*height=*/5, /*padding=*/0, 7);
+  rtc::scoped_refptr<webrtc::I420Buffer> b =
+      CreateFilledBuffer(/*width=*/10, /*height=*/6, /*padding=*/0, 7);
+
+  EXPECT_FALSE(HasSameYuv420Pixels(*a, *b));
+}
+
+TEST(MediaWritingTest, WriteVideoFrameBufferWritesI420BufferDirectly) {
+  VideoTestData test_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  RecordingOutputWriter writer;
+
+  EXPECT_TRUE(WriteVideoFrameBuffer(
+      *test_data.webrtc_frame->video_frame_buffer(), writer));
+
+  EXPECT_EQ(writer.content, test_data.yuv_data);
+}
+
+TEST(MediaWritingTest, WriteVideoFrameBufferConvertsNv12Buffer) {
+  rtc::scoped_refptr<webrtc::NV12Buffer> buffer =
+      webrtc::NV12Buffer::Create(/*width=*/4, /*height=*/2);
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      buffer->MutableDataY()[i * buffer->StrideY() + j] = 1;
+    }
+  }
+  // NV12 interleaves the U and V planes.
+  buffer->MutableDataUV()[0] = 2;
+  buffer->MutableDataUV()[1] = 3;
+  buffer->MutableDataUV()[2] = 2;
+  buffer->MutableDataUV()[3] = 3;
+  RecordingOutputWriter writer;
+
+  EXPECT_TRUE(WriteVideoFrameBuffer(*buffer, writer));
+
+  EXPECT_THAT(writer.content, ElementsAre(1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 3));
+}
+
+TEST(MediaWritingTest, WriteWavFileHeaderWritesLittleEndianHeader) {
+  MockOutputWriter writer;
+  std::vector<uint8_t> written;
+  EXPECT_CALL(writer, Write(_, kWavFileHeaderSize))
+      .WillOnce([&](const char* content, std::streamsize size) {
+        written.assign(content, content + size);
+      });
+
+  WriteWavFileHeader(/*sample_rate=*/48000, /*channel_count=*/2, writer);
+
+  EXPECT_THAT(written, ElementsAre('R', 'I', 'F', 'F',          //
+                                   0xff, 0xff, 0xff, 0xff,      //
+                                   'W', 'A', 'V', 'E',          //
+                                   'f', 'm', 't', ' ',          //
+                                   16, 0, 0, 0,                 //
+                                   1, 0, 2, 0,                  //
+                                   0x80, 0xbb, 0x00, 0x00,      //
+                                   0x00, 0xee, 0x02, 0x00,      //
+                                   4, 0, 16, 0,                 //
+                                   'd', 'a', 't', 'a',          //
+                                   0xff, 0xff, 0xff, 0xff));
+}
+
+TEST(MediaWritingTest, FinalizeWavFileHeaderSetsChunkSizes) {
+  std::string file_name = ::testing::TempDir() + "/finalized.wav";
+  {
+    OutputFile file(std::ofstream(file_name, std::ios::binary));
+    WriteWavFileHeader(/*sample_rate=*/48000, /*channel_count=*/1, file);
+    file.Write("abcdef", 6);
+    file.Close();
+  }
+
+  ASSERT_OK(FinalizeWavFileHeader(file_name));
+
+  std::ifstream file(file_name, std::ios::binary);
+  std::vector<uint8_t> contents((std::istreambuf_iterator<char>(file)),
+                                std::istreambuf_iterator<char>());
+  ASSERT_EQ(contents.size(), kWavFileHeaderSize + 6);
+  EXPECT_THAT(absl::MakeSpan(contents).subspan(4, 4),
+              ElementsAre(kWavFileHeaderSize - 8 + 6, 0, 0, 0));
+  EXPECT_THAT(absl::MakeSpan(contents).subspan(40, 4),
+              ElementsAre(6, 0, 0, 0));
+}
+
+TEST(MediaWritingTest, FinalizeWavFileHeaderFailsWithMissingFile) {
+  EXPECT_THAT(FinalizeWavFileHeader(::testing::TempDir() + "/missing.wav"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(MediaWritingTest, WriteY4mFileHeaderWritesStreamHeader) {
+  MockOutputWriter writer;
+  std::string written;
+  EXPECT_CALL(writer, Write)
+      .WillOnce([&](const char* content, std::streamsize size) {
+        written.assign(content, size);
+      });
+
+  WriteY4mFileHeader(/*width=*/640, /*height=*/360, /*frame_rate=*/30, writer);
+
+  EXPECT_EQ(written, "YUV4MPEG2 W640 H360 F30:1 Ip A1:1 C420jpeg\n");
+}
+
+TEST(MediaWritingTest, WriteY4mFrameWritesFrameMarkerAndPlanesInOneCall) {
+  VideoTestData test_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  RecordingOutputWriter writer;
+
+  EXPECT_TRUE(
+      WriteY4mFrame(*test_data.webrtc_frame->video_frame_buffer(), writer));
+
+  EXPECT_EQ(writer.vectored_write_count, 1);
+  std::vector<char> expected = {'F', 'R', 'A', 'M', 'E', '\n'};
+  expected.insert(expected.end(), test_data.yuv_data.begin(),
+                  test_data.yuv_data.end());
+  EXPECT_EQ(writer.content, expected);
+}
+
+TEST(MediaWritingTest, WriteY4mFrameConvertsNv12Buffer) {
+  rtc::scoped_refptr<webrtc::NV12Buffer> buffer =
+      webrtc::NV12Buffer::Create(/*width=*/2, /*height=*/2);
+  RecordingOutputWriter writer;
+
+  EXPECT_TRUE(WriteY4mFrame(*buffer, writer));
+
+  // The frame marker, then 4 bytes of Y and 1 byte each of U and V.
+  EXPECT_EQ(writer.content.size(), 6 + 4 + 1 + 1);
+}
+
+TEST(MediaWritingTest, IvfFourccForMimeTypeMapsSupportedCodecs) {
+  EXPECT_EQ(IvfFourccForMimeType("video/VP8"), "VP80");
+  EXPECT_EQ(IvfFourccForMimeType("video/VP9"), "VP90");
+  EXPECT_EQ(IvfFourccForMimeType("video/AV1"), "AV01");
+  EXPECT_EQ(IvfFourccForMimeType("video/H264"), std::nullopt);
+}
+
+TEST(MediaWritingTest, WriteIvfFileHeaderWritesLittleEndianHeader) {
+  MockOutputWriter writer;
+  std::vector<uint8_t> written;
+  EXPECT_CALL(writer, Write(_, 32))
+      .WillOnce([&](const char* content, std::streamsize size) {
+        written.assign(content, content + size);
+      });
+
+  WriteIvfFileHeader("VP80", /*width=*/640, /*height=*/360, writer);
+
+  EXPECT_THAT(written, ElementsAre('D', 'K', 'I', 'F',          //
+                                   0, 0, 32, 0,                 //
+                                   'V', 'P', '8', '0',          //
+                                   0x80, 0x02, 0x68, 0x01,      //
+                                   0x90, 0x5f, 0x01, 0x00,      //
+                                   1, 0, 0, 0,                  //
+                                   0, 0, 0, 0,                  //
+                                   0, 0, 0, 0));
+}
+
+TEST(MediaWritingTest, WriteIvfFrameWritesFrameHeaderAndData) {
+  std::vector<uint8_t> data = {7, 8, 9};
+  RecordingOutputWriter writer;
+
+  WriteIvfFrame(data, /*timestamp=*/0x0102030405, writer);
+
+  EXPECT_EQ(writer.vectored_write_count, 1);
+  EXPECT_THAT(writer.chunk_sizes, ElementsAre(12, 3));
+  EXPECT_THAT(writer.content, ElementsAre(3, 0, 0, 0,                    //
+                                          5, 4, 3, 2, 1, 0, 0, 0,        //
+                                          7, 8, 9));
+}
+
+// Returns a `width`x`height` buffer with every pixel set to the given color.
+rtc::scoped_refptr<webrtc::I420Buffer> CreateColorBuffer(int width, int height,
+                                                         uint8_t y, uint8_t u,
+                                                         uint8_t v) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      CreateFilledBuffer(width, height, /*padding=*/2, y);
+  int chroma_height = (height + 1) / 2;
+  std::memset(buffer->MutableDataU(), u, buffer->StrideU() * chroma_height);
+  std::memset(buffer->MutableDataV(), v, buffer->StrideV() * chroma_height);
+  return buffer;
+}
+
+TEST(MediaWritingTest, ParseVideoPixelFormatParsesSupportedFormats) {
+  EXPECT_EQ(ParseVideoPixelFormat("i420"), VideoPixelFormat::kI420);
+  EXPECT_EQ(ParseVideoPixelFormat("nv12"), VideoPixelFormat::kNv12);
+  EXPECT_EQ(ParseVideoPixelFormat("rgb24"), VideoPixelFormat::kRgb24);
+  EXPECT_EQ(ParseVideoPixelFormat("bgra"), VideoPixelFormat::kBgra);
+  EXPECT_EQ(ParseVideoPixelFormat("rgba"), std::nullopt);
+}
+
+TEST(MediaWritingTest, VideoFrameSizeMatchesPixelFormat) {
+  EXPECT_EQ(VideoFrameSize(VideoPixelFormat::kI420, 5, 3), 15 + 2 * 3 * 2);
+  EXPECT_EQ(VideoFrameSize(VideoPixelFormat::kNv12, 5, 3), 15 + 2 * 3 * 2);
+  EXPECT_EQ(VideoFrameSize(VideoPixelFormat::kRgb24, 5, 3), 45);
+  EXPECT_EQ(VideoFrameSize(VideoPixelFormat::kBgra, 5, 3), 60);
+}
+
+TEST(MediaWritingTest, ConvertYuv420PacksI420PlanesWithoutPadding) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      CreateColorBuffer(/*width=*/3, /*height=*/2, /*y=*/1, /*u=*/2, /*v=*/3);
+  std::vector<uint8_t> output(VideoFrameSize(VideoPixelFormat::kI420, 3, 2));
+
+  EXPECT_TRUE(ConvertYuv420(*buffer, VideoPixelFormat::kI420,
+                            absl::MakeSpan(output)));
+
+  EXPECT_THAT(output, ElementsAre(1, 1, 1, 1, 1, 1, 2, 2, 3, 3));
+}
+
+TEST(MediaWritingTest, ConvertYuv420InterleavesNv12ChromaPlane) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      CreateColorBuffer(/*width=*/4, /*height=*/2, /*y=*/1, /*u=*/2, /*v=*/3);
+  std::vector<uint8_t> output(VideoFrameSize(VideoPixelFormat::kNv12, 4, 2));
+
+  EXPECT_TRUE(ConvertYuv420(*buffer, VideoPixelFormat::kNv12,
+                            absl::MakeSpan(output)));
+
+  EXPECT_THAT(output, ElementsAre(1, 1, 1, 1, 1, 1, 1, 1, 2, 3, 2, 3));
+}
+
+TEST(MediaWritingTest, ConvertYuv420ConvertsLimitedRangeColorsToRgb24) {
+  std::vector<uint8_t> output(VideoFrameSize(VideoPixelFormat::kRgb24, 2, 1));
+
+  ASSERT_TRUE(ConvertYuv420(*CreateColorBuffer(2, 1, 235, 128, 128),
+                            VideoPixelFormat::kRgb24, absl::MakeSpan(output)));
+  EXPECT_THAT(output,
+              ElementsAre(IsNearChannel(255), IsNearChannel(255),
+                          IsNearChannel(255), IsNearChannel(255),
+                          IsNearChannel(255), IsNearChannel(255)));
+  ASSERT_TRUE(ConvertYuv420(*CreateColorBuffer(2, 1, 16, 128, 128),
+                            VideoPixelFormat::kRgb24, absl::MakeSpan(output)));
+  EXPECT_THAT(output, ElementsAre(IsNearChannel(0), IsNearChannel(0),
+                                  IsNearChannel(0), IsNearChannel(0),
+                                  IsNearChannel(0), IsNearChannel(0)));
+  ASSERT_TRUE(ConvertYuv420(*CreateColorBuffer(2, 1, 81, 90, 240),
+                            VideoPixelFormat::kRgb24, absl::MakeSpan(output)));
+  EXPECT_THAT(output, ElementsAre(IsNearChannel(255), IsNearChannel(0),
+                                  IsNearChannel(0), IsNearChannel(255),
+                                  IsNearChannel(0), IsNearChannel(0)));
+}
+
+TEST(MediaWritingTest, ConvertYuv420WritesBgraWithOpaqueAlpha) {
+  std::vector<uint8_t> output(VideoFrameSize(VideoPixelFormat::kBgra, 1, 1));
+
+  ASSERT_TRUE(ConvertYuv420(*CreateColorBuffer(1, 1, 81, 90, 240),
+                            VideoPixelFormat::kBgra, absl::MakeSpan(output)));
+
+  // Alpha is not converted, so it is exact.
+  EXPECT_THAT(output, ElementsAre(IsNearChannel(0), IsNearChannel(0),
+                                  IsNearChannel(255), 255));
+}
+
+TEST(MediaWritingTest, ConvertYuv420FailsIfOutputIsTooSmall) {
+  std::vector<uint8_t> output(
+      VideoFrameSize(VideoPixelFormat::kRgb24, 2, 2) - 1);
+
+  EXPECT_FALSE(ConvertYuv420(*CreateColorBuffer(2, 2, 16, 128, 128),
+                             VideoPixelFormat::kRgb24,
+                             absl::MakeSpan(output)));
+}
+
+TEST(MediaWritingTest, WriteRawVideoFrameWritesConvertedFrameInOneCall) {
+  MockOutputWriter writer;
+  std::vector<uint8_t> written;
+  EXPECT_CALL(writer, Write(_, 6))
+      .WillOnce([&](const char* content, std::streamsize size) {
+        written.assign(content, content + size);
+      });
+  std::vector<uint8_t> conversion_buffer;
+
+  WriteRawVideoFrame(*CreateColorBuffer(2, 1, 235, 128, 128),
+                     VideoPixelFormat::kRgb24, conversion_buffer, writer);
+
+  EXPECT_THAT(written,
+              ElementsAre(IsNearChannel(255), IsNearChannel(255),
+                          IsNearChannel(255), IsNearChannel(255),
+                          IsNearChannel(255), IsNearChannel(255)));
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/memory_account.h"
+
+#include <atomic>
+#include <cstddef>
+
+namespace media_api_samples {
+
+void MemoryAccount::Charge::Release() {
+  if (account_ == nullptr) {
+    return;
+  }
+  account_->BytesFor(category_).fetch_sub(bytes_, std::memory_order_relaxed);
+  account_ = nullptr;
+}
+
+MemoryAccount::Charge MemoryAccount::Acquire(MemoryCategory category,
+                                             size_t bytes) {
+  BytesFor(category).fetch_add(bytes, std::memory_order_relaxed);
+  return Charge(this, category, bytes);
+}
+
+MemoryUsage MemoryAccount::GetUsage() const {
+  auto load = [this](MemoryCategory category) {
+    return bytes_[static_cast<size_t>(category)].load(
+        std::memory_order_relaxed);
+  };
+  return MemoryUsage{
+      .queued_audio_bytes = load(MemoryCategory::kQueuedAudio),
+      .queued_video_bytes = load(MemoryCategory::kQueuedVideo),
+      .open_segment_bytes = load(MemoryCategory::kOpenSegments),
+  };
+}
+
+bool MemoryAccount::IsOverBudget() const {
+  size_t budget = budget_bytes();
+  return budget != 0 && GetUsage().total_bytes() > budget;
+}
+
+bool MemoryAccount::ShouldDropFrames() {
+  size_t budget = budget_bytes();
+  if (budget == 0) {
+    return false;
+  }
+  MemoryUsage usage = GetUsage();
+  size_t queued_bytes = usage.queued_audio_bytes + usage.queued_video_bytes;
+  if (queued_bytes > budget) {
+    dropping_frames_.store(true, std::memory_order_relaxed);
+    return true;
+  }
+  if (queued_bytes <= budget / 2) {
+    dropping_frames_.store(false, std::memory_order_relaxed);
+    return false;
+  }
+  return dropping_frames_.load(std::memory_order_relaxed);
+}
+
+}  // namespace media_api_samples
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_MEMORY_ACCOUNT_H_
+#define CPP_SAMPLES_MEMORY_ACCOUNT_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace media_api_samples {
+
+// The kinds of memory that are attributed to a conference.
+enum class MemoryCategory {
+  // Audio frames waiting to be written.
+  kQueuedAudio,
+  // Video frames waiting to be written.
+  kQueuedVideo,
+  // The write buffers of open segments.
+  kOpenSegments,
+};
+
+inline constexpr size_t kMemoryCategoryCount = 3;
+
+struct MemoryUsage {
+  size_t queued_audio_bytes = 0;
+  size_t queued_video_bytes = 0;
+  size_t open_segment_bytes = 0;
+
+  size_t total_bytes() const {
+    return queued_audio_bytes + queued_video_bytes + open_segment_bytes;
+  }
+};
+
+// Counts the bytes held on behalf of a single conference, by category, and
+// compares them against an optional budget.
+//
+// This class is thread-safe. Usage is sampled rather than reserved, so it may
+// briefly exceed the budget while several threads are charging it at once.
+class MemoryAccount {
+ public:
+  // Holds bytes charged to an account, and releases them when destroyed, e.g.
+  // once a queued frame has been written or dropped.
+  class Charge {
+   public:
+    Charge() = default;
+    ~Charge() { Release(); }
+
+    Charge(Charge&& other)
+        : account_(other.account_),
+          category_(other.category_),
+          bytes_(other.bytes_) {
+      other.account_ = nullptr;
+    }
+    Charge& operator=(Charge&& other) {
+      if (this != &other) {
+        Release();
+        account_ = other.account_;
+        category_ = other.category_;
+        bytes_ = other.bytes_;
+        other.account_ = nullptr;
+      }
+      return *this;
+    }
+
+    Charge(const Charge&) = delete;
+    Charge& operator=(const Charge&) = delete;
+
+    size_t bytes() const { return account_ != nullptr ? bytes_ : 0; }
+
+   private:
+    friend class MemoryAccount;
+
+    Charge(MemoryAccount* account, MemoryCategory category, size_t bytes)
+        : account_(account), category_(category), bytes_(bytes) {}
+
+    void Release();
+
+    MemoryAccount* account_ = nullptr;
+    MemoryCategory category_ = MemoryCategory::kQueuedAudio;
+    size_t bytes_ = 0;
+  };
+
+  MemoryAccount() = default;
+
+  MemoryAccount(const MemoryAccount&) = delete;
+  MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+  // Charges `bytes` to `category` until the returned charge is destroyed. The
+  // account must outlive the charge.
+  Charge Acquire(MemoryCategory category, size_t bytes);
+
+  // Sets the number of bytes the account may use before it is over budget.
+  // Zero means that the account is unlimited, which is the default.
+  void SetBudget(size_t budget_bytes) {
+    budget_bytes_.store(budget_bytes, std::memory_order_relaxed);
+  }
+  size_t budget_bytes() const {
+    return budget_bytes_.load(std::memory_order_relaxed);
+  }
+
+  MemoryUsage GetUsage() const;
+
+  // Returns whether the account has a budget and uses more than it.
+  bool IsOverBudget() const;
+
+  // Returns whether received frames should be dropped to bring the frames
+  // queued for writing back under the budget. Only queued frames count, since
+  // open segments are not released by dropping frames. Once queued frames
+  // exceed the budget, this keeps returning true until they have fallen to
+  // half of it, so that drops come in bursts rather than every other frame.
+  bool ShouldDropFrames();
+
+ private:
+  std::atomic<size_t>& BytesFor(MemoryCategory category) {
+    return bytes_[static_cast<size_t>(category)];
+  }
+
+  std::atomic<size_t> budget_bytes_ = 0;
+  std::array<std::atomic<size_t>, kMemoryCategoryCount> bytes_ = {};
+  std::atomic<bool> dropping_frames_ = false;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_MEMORY_ACCOUNT_H_
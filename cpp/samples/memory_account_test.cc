@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/memory_account.h"
+
+#include <utility>
+
+#include "gtest/gtest.h"
+
+namespace media_api_samples {
+namespace {
+
+TEST(MemoryAccountTest, ChargesAreCountedByCategory) {
+  MemoryAccount account;
+  MemoryAccount::Charge audio =
+      account.Acquire(MemoryCategory::kQueuedAudio, 10);
+  MemoryAccount::Charge video =
+      account.Acquire(MemoryCategory::kQueuedVideo, 20);
+  MemoryAccount::Charge segment =
+      account.Acquire(MemoryCategory::kOpenSegments, 30);
+
+  MemoryUsage usage = account.GetUsage();
+  EXPECT_EQ(usage.queued_audio_bytes, 10);
+  EXPECT_EQ(usage.queued_video_bytes, 20);
+  EXPECT_EQ(usage.open_segment_bytes, 30);
+  EXPECT_EQ(usage.total_bytes(), 60);
+}
+
+TEST(MemoryAccountTest, DestroyingChargeReleasesBytes) {
+  MemoryAccount account;
+  {
+    MemoryAccount::Charge charge =
+        account.Acquire(MemoryCategory::kQueuedVideo, 20);
+    EXPECT_EQ(account.GetUsage().queued_video_bytes, 20);
+  }
+  EXPECT_EQ(account.GetUsage().queued_video_bytes, 0);
+}
+
+TEST(MemoryAccountTest, MovedChargeIsReleasedOnce) {
+  MemoryAccount account;
+  MemoryAccount::Charge moved;
+  {
+    MemoryAccount::Charge charge =
+        account.Acquire(MemoryCategory::kQueuedAudio, 10);
+    moved = std::move(charge);
+  }
+  EXPECT_EQ(moved.bytes(), 10);
+  EXPECT_EQ(account.GetUsage().queued_audio_bytes, 10);
+
+  moved = MemoryAccount::Charge();
+  EXPECT_EQ(account.GetUsage().queued_audio_bytes, 0);
+}
+
+TEST(MemoryAccountTest, UnlimitedAccountIsNeverOverBudget) {
+  MemoryAccount account;
+  MemoryAccount::Charge charge =
+      account.Acquire(MemoryCategory::kQueuedVideo, 1 << 30);
+
+  EXPECT_FALSE(account.IsOverBudget());
+}
+
+TEST(MemoryAccountTest, IsOverBudgetOnceUsageExceedsBudget) {
+  MemoryAccount account;
+  account.SetBudget(100);
+  MemoryAccount::Charge audio =
+      account.Acquire(MemoryCategory::kQueuedAudio, 50);
+  MemoryAccount::Charge video =
+      account.Acquire(MemoryCategory::kQueuedVideo, 50);
+  EXPECT_FALSE(account.IsOverBudget());
+
+  MemoryAccount::Charge segment =
+      account.Acquire(MemoryCategory::kOpenSegments, 1);
+  EXPECT_TRUE(account.IsOverBudget());
+
+  segment = MemoryAccount::Charge();
+  EXPECT_FALSE(account.IsOverBudget());
+}
+
+TEST(MemoryAccountTest, OpenSegmentsDoNotCauseFrameDrops) {
+  MemoryAccount account;
+  account.SetBudget(100);
+  MemoryAccount::Charge segment =
+      account.Acquire(MemoryCategory::kOpenSegments, 1000);
+
+  EXPECT_TRUE(account.IsOverBudget());
+  EXPECT_FALSE(account.ShouldDropFrames());
+}
+
+TEST(MemoryAccountTest, DropsFramesUntilQueuedFramesFallToHalfOfBudget) {
+  MemoryAccount account;
+  account.SetBudget(100);
+  MemoryAccount::Charge audio =
+      account.Acquire(MemoryCategory::kQueuedAudio, 60);
+  EXPECT_FALSE(account.ShouldDropFrames());
+
+  MemoryAccount::Charge video =
+      account.Acquire(MemoryCategory::kQueuedVideo, 50);
+  EXPECT_TRUE(account.ShouldDropFrames());
+
+  video = MemoryAccount::Charge();
+  EXPECT_TRUE(account.ShouldDropFrames());
+
+  audio = account.Acquire(MemoryCategory::kQueuedAudio, 50);
+  EXPECT_FALSE(account.ShouldDropFrames());
+}
+
+}  // namespace
+}  // namespace media_api_samples
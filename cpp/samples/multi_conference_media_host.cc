@@ -0,0 +1,186 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Collects media from many conferences in one long-running process.
+//
+// Conferences are joined and left through commands read from standard input,
+// one per line:
+//
+//   join <meeting_space_id> <oauth_token>
+//   leave <meeting_space_id>
+//   list
+//
+// All clients share the host's peer connection contexts, collector threads
+// and output writer threads. The process leaves all conferences and exits
+// once standard input is closed.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "cpp/internal/media_api_client_factory.h"
+#include "cpp/internal/trace.h"
+#include "cpp/samples/conference_host.h"
+#include "cpp/samples/event_log.h"
+
+ABSL_FLAG(std::string, output_file_prefix, "/tmp/test_output_",
+          "Directory and file prefix where files will be written. Files of "
+          "each conference will be written to "
+          "<output_file_prefix><meeting_space_id>_<filename>.");
+
+ABSL_FLAG(std::string, meet_api_url, "https://meet.googleapis.com/v2beta",
+          "The base URL to use for the Meet API.");
+
+ABSL_FLAG(absl::Duration, collection_duration, absl::Seconds(30),
+          "The duration of media collection once a conference is joined. The "
+          "host will leave the conference after this duration.");
+
+ABSL_FLAG(absl::Duration, join_timeout, absl::Minutes(2),
+          "The maximum amount of time to wait for the host to join a "
+          "conference before leaving it.");
+
+ABSL_FLAG(absl::Duration, segment_gap_threshold, absl::Seconds(1),
+          "The amount of time that must pass between media frames before a new "
+          "media segment is created.");
+
+ABSL_FLAG(int, collector_shard_count, 0,
+          "The number of threads that media segments of all conferences are "
+          "partitioned across by contributing source. If 0, all segments are "
+          "written on a single collector thread.");
+
+ABSL_FLAG(int, context_count, 1,
+          "The number of shared peer connection contexts that conferences are "
+          "spread across. Each context has its own signaling and worker "
+          "threads.");
+
+ABSL_FLAG(int64_t, conference_memory_budget_mb, 0,
+          "The memory, in MiB, that each conference may hold for queued frames "
+          "and open segments before its video is degraded. If 0, conferences "
+          "are not limited.");
+
+ABSL_FLAG(std::string, event_log_format, "csv",
+          "The format of the event log: csv (event_log.csv) or columnar "
+          "(event_log.columnar, typed columns that analysis jobs can read "
+          "without parsing text).");
+
+ABSL_FLAG(std::string, trace_categories, "",
+          "Comma-separated trace categories to log, or \"all\". Valid "
+          "categories are data_channel, resource_update, media_stats and "
+          "http. The pipeline category, which records every frame event, is "
+          "only available in multi_user_media_sample, with --trace_event_file.");
+
+namespace {
+
+// Runs one command line. Returns an error if the command is malformed or
+// fails.
+absl::Status RunCommand(media_api_samples::ConferenceHost& host,
+                        absl::string_view line) {
+  std::vector<absl::string_view> args =
+      absl::StrSplit(line, ' ', absl::SkipWhitespace());
+  if (args.empty()) {
+    return absl::OkStatus();
+  }
+  if (args[0] == "join" && args.size() == 3) {
+    return host.Join(args[1], args[2],
+                     absl::GetFlag(FLAGS_collection_duration));
+  }
+  if (args[0] == "leave" && args.size() == 2) {
+    return host.Leave(args[1]);
+  }
+  if (args[0] == "list" && args.size() == 1) {
+    std::cout << absl::StrJoin(host.GetActiveConferences(), " ") << std::endl;
+    return absl::OkStatus();
+  }
+  return absl::InvalidArgumentError(
+      "Expected \"join <meeting_space_id> <oauth_token>\", "
+      "\"leave <meeting_space_id>\" or \"list\"");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::SetProgramUsageMessage(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status trace_status =
+      meet::SetEnabledTraceCategories(absl::GetFlag(FLAGS_trace_categories));
+  if (!trace_status.ok()) {
+    LOG(ERROR) << "Invalid trace categories: " << trace_status;
+    return EXIT_FAILURE;
+  }
+  if (absl::GetFlag(FLAGS_conference_memory_budget_mb) < 0) {
+    LOG(ERROR) << "Conference memory budget must not be negative";
+    return EXIT_FAILURE;
+  }
+  std::optional<media_api_samples::EventLogFormat> event_log_format =
+      media_api_samples::ParseEventLogFormat(
+          absl::GetFlag(FLAGS_event_log_format));
+  if (!event_log_format.has_value()) {
+    LOG(ERROR) << "Unsupported event log format: "
+               << absl::GetFlag(FLAGS_event_log_format);
+    return EXIT_FAILURE;
+  }
+
+  media_api_samples::ConferenceHostOptions options = {
+      .output_file_prefix = absl::GetFlag(FLAGS_output_file_prefix),
+      .meet_api_url = absl::GetFlag(FLAGS_meet_api_url),
+      .segment_gap_threshold = absl::GetFlag(FLAGS_segment_gap_threshold),
+      .event_log_format = *event_log_format,
+      .collector_shard_count = absl::GetFlag(FLAGS_collector_shard_count),
+      .join_timeout = absl::GetFlag(FLAGS_join_timeout),
+      .conference_memory_budget_bytes = static_cast<size_t>(
+          absl::GetFlag(FLAGS_conference_memory_budget_mb) * 1024 * 1024),
+  };
+  absl::StatusOr<std::unique_ptr<media_api_samples::ConferenceHost>> host =
+      media_api_samples::ConferenceHost::Create(
+          std::move(options),
+          std::make_unique<meet::MediaApiClientFactory>(
+              meet::MediaApiClientFactory::SharedContextConfiguration{
+                  .context_count = absl::GetFlag(FLAGS_context_count),
+              }));
+  if (!host.ok()) {
+    LOG(ERROR) << "Failed to create conference host: " << host.status();
+    return EXIT_FAILURE;
+  }
+  LOG(INFO) << "Conference host ready for commands";
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (absl::Status status = RunCommand(**host, line); !status.ok()) {
+      // The line is not logged since it may contain an OAuth token.
+      LOG(ERROR) << "Command failed: " << status;
+    }
+  }
+
+  LOG(INFO) << "Leaving all conferences";
+  host->reset();
+  return EXIT_SUCCESS;
+}
@@ -16,85 +16,212 @@
 
 #include "cpp/samples/multi_user_media_collector.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <ios>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "absl/functional/any_invocable.h"
+#include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/media_entries_resource.h"
 #include "cpp/api/participants_resource.h"
+#include "cpp/api/video_assignment_resource.h"
+#include "cpp/internal/trace_events.h"
+#include "cpp/samples/async_output_writer.h"
+#include "cpp/samples/audio_levels.h"
+#include "cpp/samples/audio_resampler.h"
+#include "cpp/samples/buffered_output_writer.h"
+#include "cpp/samples/frame_queue.h"
+#include "cpp/samples/i420_buffer_pool.h"
+#include "cpp/samples/mapped_output_file.h"
 #include "cpp/samples/media_writing.h"
+#include "cpp/samples/memory_account.h"
+#include "cpp/samples/output_file.h"
+#include "cpp/samples/resource_manager.h"
+#include "cpp/samples/video_segment_encoder.h"
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/rtc_base/thread.h"
 
 namespace media_api_samples {
 namespace {
 
-constexpr absl::string_view kTmpAudioFormat = "%saudio_%s_tmp.pcm";
-constexpr absl::string_view kTmpVideoFormat = "%svideo_%s_tmp_%dx%d.yuv";
-constexpr absl::string_view kFinishedAudioFormat = "%saudio_%s_%s_%s.pcm";
-constexpr absl::string_view kFinishedVideoFormat = "%svideo_%s_%s_%s_%dx%d.yuv";
+constexpr absl::string_view kAudioFileExtension = ".wav";
+// Temporary names include a sequence number that is unique within the
+// collector, so that a segment's file keeps its name until it has been closed
+// and renamed, even if a new segment for the same source has started.
+constexpr absl::string_view kTmpAudioFormat = "%saudio_%s_tmp_%d.wav";
+constexpr absl::string_view kTmpVideoFormat = "%svideo_%s_tmp_%d_%dx%d%s";
+constexpr absl::string_view kFinishedAudioFormat = "%saudio_%s_%s_%s.wav";
+constexpr absl::string_view kFinishedVideoFormat = "%svideo_%s_%s_%s_%dx%d%s";
+constexpr absl::string_view kRawVideoFileExtension = ".y4m";
+constexpr absl::string_view kEncodedVideoFileExtension = ".ivf";
+// The nominal frame rate of video segments. Frames are written as they are
+// received, at up to the frame rate requested by the samples' video
+// assignments.
+constexpr int kVideoFrameRate = 30;
+// The estimated memory held by an open segment's buffered writer.
+constexpr size_t kSegmentWriterMemoryEstimate = kDefaultOutputWriterFlushSize;
+
+// Returns the size of an I420 frame of the given resolution.
+size_t I420FrameBytes(int width, int height) {
+  size_t chroma_width = static_cast<size_t>((width + 1) / 2);
+  size_t chroma_height = static_cast<size_t>((height + 1) / 2);
+  return static_cast<size_t>(width) * static_cast<size_t>(height) +
+         2 * chroma_width * chroma_height;
+}
+
+// Returns the time the client received a frame, falling back to the current
+// time for frames that were not stamped by the client. The client stamps
+// frames before they are queued for delivery, so segment timing is not skewed
+// by any time that frames spend waiting in the observer queue.
+absl::Time ReceivedTimeOf(absl::Time receive_time) {
+  return receive_time == absl::InfinitePast() ? absl::Now() : receive_time;
+}
+
+// Opens a local file for writing, logging whether it opened.
+std::ofstream OpenFile(absl::string_view file_name, std::ios::openmode mode) {
+  std::ofstream file(std::string(file_name),
+                     std::ios::binary | std::ios::out | mode);
+  if (file.is_open()) {
+    LOG(INFO) << "Opened file: " << file_name;
+  } else {
+    // Files should normally open successfully.
+    //
+    // Potential causes for failure include:
+    // - The parent directory does not exist.
+    // - The system is out of disk space.
+    //
+    // If a file cannot be opened, the sample will still run, but written
+    // data will be lost.
+    LOG(ERROR) << "Failed to open file: " << file_name;
+  }
+  return file;
+}
 
 }  // namespace
 
 void MultiUserMediaCollector::OnAudioFrame(meet::AudioFrame frame) {
-  absl::Time received_time = absl::Now();
-  std::vector<int16_t> samples(frame.pcm16.begin(), frame.pcm16.end());
-
-  collector_thread_->PostTask([this, samples = std::move(samples),
-                               contributing_source = frame.contributing_source,
-                               received_time = received_time] {
-    HandleAudioData(std::move(samples), contributing_source, received_time);
-  });
+  meet::ScopedTraceEvent trace_event("MultiUserMediaCollector::OnAudioFrame");
+  trace_event.SetFrameFlow(meet::TraceFlowPhase::kStep,
+                           frame.contributing_source, frame.receive_time);
+  absl::Time received_time = ReceivedTimeOf(frame.receive_time);
+  // Retain the frame's buffer rather than copying the samples. Frames without a
+  // buffer only guarantee the samples for the duration of this call, so they
+  // are copied into a pooled buffer.
+  rtc::scoped_refptr<meet::AudioBufferInterface> buffer =
+      frame.buffer != nullptr ? std::move(frame.buffer)
+                              : audio_buffer_pool_.Acquire(frame.pcm16);
+  // Audio is charged but never dropped for being over budget, since dropped
+  // audio would leave gaps in recordings.
+  MemoryAccount::Charge memory_charge =
+      memory_account_.Acquire(MemoryCategory::kQueuedAudio,
+                              buffer->pcm16().size() * sizeof(int16_t));
+
+  Shard& shard = ShardFor(frame.contributing_source);
+  shard.audio_queue->Enqueue(
+      frame.contributing_source,
+      [this, &shard, buffer = std::move(buffer),
+       memory_charge = std::move(memory_charge),
+       sample_rate = frame.sample_rate,
+       channel_count = static_cast<int>(frame.number_of_channels),
+       contributing_source = frame.contributing_source,
+       received_time = received_time]() mutable {
+        HandleAudioData(shard, std::move(buffer), sample_rate, channel_count,
+                        contributing_source, received_time);
+      });
 }
 
 void MultiUserMediaCollector::OnVideoFrame(meet::VideoFrame frame) {
-  absl::Time received_time = absl::Now();
-  rtc::scoped_refptr<webrtc::I420BufferInterface> buffer =
-      frame.frame.video_frame_buffer()->ToI420();
-
-  collector_thread_->PostTask([this, buffer = std::move(buffer),
-                               contributing_source = frame.contributing_source,
-                               received_time = received_time] {
-    HandleVideoData(std::move(buffer), contributing_source, received_time);
-  });
+  meet::ScopedTraceEvent trace_event("MultiUserMediaCollector::OnVideoFrame");
+  trace_event.SetFrameFlow(meet::TraceFlowPhase::kStep,
+                           frame.contributing_source, frame.receive_time);
+  if (memory_account_.ShouldDropFrames()) {
+    memory_budget_dropped_video_frames_.fetch_add(1,
+                                                  std::memory_order_relaxed);
+    return;
+  }
+  absl::Time received_time = ReceivedTimeOf(frame.receive_time);
+  // Converting the buffer to I420 can be expensive for non-I420 buffers, so
+  // pass the buffer through as-is and only convert it when it is written.
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer =
+      frame.frame.video_frame_buffer();
+  MemoryAccount::Charge memory_charge = memory_account_.Acquire(
+      MemoryCategory::kQueuedVideo,
+      I420FrameBytes(buffer->width(), buffer->height()));
+
+  Shard& shard = ShardFor(frame.contributing_source);
+  shard.video_queue->Enqueue(
+      frame.contributing_source,
+      [this, &shard, buffer = std::move(buffer),
+       memory_charge = std::move(memory_charge),
+       contributing_source = frame.contributing_source,
+       received_time = received_time]() mutable {
+        HandleVideoData(shard, std::move(buffer), contributing_source,
+                        received_time);
+      });
 }
 
-void MultiUserMediaCollector::HandleAudioData(std::vector<int16_t> samples,
-                                              uint32_t contributing_source,
-                                              absl::Time received_time) {
-  DCHECK(collector_thread_->IsCurrent());
-
+void MultiUserMediaCollector::HandleAudioData(
+    Shard& shard, rtc::scoped_refptr<meet::AudioBufferInterface> buffer,
+    int sample_rate, int channel_count, uint32_t contributing_source,
+    absl::Time received_time) {
+  DCHECK(shard.thread->IsCurrent());
+  meet::ScopedTraceEvent trace_event(
+      "MultiUserMediaCollector::HandleAudioData");
+  trace_event.SetFrameFlow(meet::TraceFlowPhase::kEnd, contributing_source,
+                           received_time);
+
+  bool silent =
+      skip_silent_audio_ &&
+      IsSilence(ComputeAudioLevel(buffer->pcm16()), silence_threshold_dbfs_);
   AudioSegment* audio_segment = nullptr;
 
-  if (auto it = audio_segments_.find(contributing_source);
-      it != audio_segments_.end()) {
+  if (auto it = shard.audio_segments.find(contributing_source);
+      it != shard.audio_segments.end()) {
     AudioSegment* current_audio_segment = it->second.get();
     if (received_time - current_audio_segment->last_frame_time <
         segment_gap_threshold_) {
       // Reuse the existing segment if the received frame is within the gap of
       // the previous frame.
       audio_segment = current_audio_segment;
-      // TODO: Make this heuristic calculation more testable.
-      audio_segment->last_frame_time = received_time;
+      // Silence is written within the gap, but does not extend the segment.
+      if (!silent) {
+        // TODO: Make this heuristic calculation more testable.
+        audio_segment->last_frame_time = received_time;
+      }
     } else {
       // If there is an existing segment, but the received frame is beyond the
       // gap of the previous frame, close the existing segment.
       CloseAudioSegment(*current_audio_segment);
-      audio_segments_.erase(it);
+      shard.audio_segments.erase(it);
     }
   }
 
   if (audio_segment == nullptr) {
+    if (silent) {
+      // Segments only start once a participant speaks.
+      return;
+    }
     // If there is no existing segment (because one did not exist or the
     // previous segment was closed), create a new segment.
     absl::StatusOr<std::string> file_identifier_status =
@@ -113,41 +240,65 @@ void MultiUserMediaCollector::HandleAudioData(std::vector<int16_t> samples,
     }
 
     std::string file_identifier = std::move(file_identifier_status).value();
+    std::string audio_segment_name = absl::StrFormat(
+        kTmpAudioFormat, output_file_prefix_, file_identifier,
+        next_segment_number_.fetch_add(1, std::memory_order_relaxed));
     auto new_audio_segment = std::make_unique<AudioSegment>(
-        output_writer_provider_(absl::StrFormat(
-            kTmpAudioFormat, output_file_prefix_, file_identifier)),
-        std::move(file_identifier), received_time, received_time);
+        OpenSegmentWriter(shard, audio_segment_name),
+        std::move(audio_segment_name), std::move(file_identifier),
+        received_time, received_time);
+    new_audio_segment->memory_charge = memory_account_.Acquire(
+        MemoryCategory::kOpenSegments, audio_segment_memory_estimate_);
+    if (audio_conversion_.has_value()) {
+      new_audio_segment->resampler =
+          std::make_unique<AudioResampler>(*audio_conversion_);
+      WriteWavFileHeader(
+          new_audio_segment->resampler->OutputSampleRate(sample_rate),
+          new_audio_segment->resampler->OutputChannelCount(channel_count),
+          *new_audio_segment->writer);
+    } else {
+      WriteWavFileHeader(sample_rate, channel_count,
+                         *new_audio_segment->writer);
+    }
     audio_segment = new_audio_segment.get();
-    audio_segments_[contributing_source] = std::move(new_audio_segment);
+    shard.audio_segments[contributing_source] = std::move(new_audio_segment);
   }
 
   DCHECK(audio_segment != nullptr);
   // At this point, either an existing segment is being appended to or a new
   // segment has been created.
-  WritePcm16(samples, *audio_segment->writer);
+  absl::Span<const int16_t> pcm16 = buffer->pcm16();
+  if (audio_segment->resampler != nullptr) {
+    absl::StatusOr<absl::Span<const int16_t>> converted_pcm16 =
+        audio_segment->resampler->Convert(pcm16, sample_rate, channel_count);
+    if (!converted_pcm16.ok()) {
+      LOG_EVERY_N_SEC(ERROR, 10)
+          << "Failed to convert audio: " << converted_pcm16.status();
+      return;
+    }
+    pcm16 = *converted_pcm16;
+  }
+  WritePcm16(pcm16, *audio_segment->writer);
 }
 
 void MultiUserMediaCollector::HandleVideoData(
-    rtc::scoped_refptr<webrtc::I420BufferInterface> buffer,
+    Shard& shard, rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
     uint32_t contributing_source, absl::Time received_time) {
-  DCHECK(collector_thread_->IsCurrent());
-
-  // Meet video frames are always in YUV420p format.
-  const webrtc::I420BufferInterface* i420 = buffer->GetI420();
-  if (i420 == nullptr) {
-    LOG(ERROR) << "Failed to get I420 buffer from video frame buffer.";
-    return;
-  }
+  DCHECK(shard.thread->IsCurrent());
+  meet::ScopedTraceEvent trace_event(
+      "MultiUserMediaCollector::HandleVideoData");
+  trace_event.SetFrameFlow(meet::TraceFlowPhase::kEnd, contributing_source,
+                           received_time);
 
   VideoSegment* video_segment = nullptr;
 
-  if (auto it = video_segments_.find(contributing_source);
-      it != video_segments_.end()) {
+  if (auto it = shard.video_segments.find(contributing_source);
+      it != shard.video_segments.end()) {
     VideoSegment* current_video_segment = it->second.get();
     if (received_time - current_video_segment->last_frame_time <
             segment_gap_threshold_ &&
-        current_video_segment->width == i420->width() &&
-        current_video_segment->height == i420->height()) {
+        current_video_segment->width == buffer->width() &&
+        current_video_segment->height == buffer->height()) {
       // Reuse the existing segment if the received frame is within the gap of
       // the previous frame and the resolution is the same.
       video_segment = current_video_segment;
@@ -158,7 +309,7 @@ void MultiUserMediaCollector::HandleVideoData(
       // gap of the previous frame or the resolution is different, close the
       // existing segment.
       CloseVideoSegment(*current_video_segment);
-      video_segments_.erase(it);
+      shard.video_segments.erase(it);
     }
   }
 
@@ -181,21 +332,94 @@ void MultiUserMediaCollector::HandleVideoData(
     }
 
     std::string file_identifier = std::move(file_identifier_status).value();
-    std::string video_segment_name =
-        absl::StrFormat(kTmpVideoFormat, output_file_prefix_, file_identifier,
-                        buffer->width(), buffer->height());
+    int file_width = buffer->width();
+    int file_height = buffer->height();
+    absl::string_view file_extension = kEncodedVideoFileExtension;
+    if (video_encoder_pool_ == nullptr) {
+      if (raw_video_width_ != 0) {
+        file_width = raw_video_width_;
+        file_height = raw_video_height_;
+      }
+      file_extension = raw_video_format_ == VideoPixelFormat::kI420
+                           ? kRawVideoFileExtension
+                           : RawVideoFileExtension(raw_video_format_);
+    }
+    std::string video_segment_name = absl::StrFormat(
+        kTmpVideoFormat, output_file_prefix_, file_identifier,
+        next_segment_number_.fetch_add(1, std::memory_order_relaxed),
+        file_width, file_height, file_extension);
+    // Encoders write on their own threads, so their files are not cached.
+    std::unique_ptr<OutputWriterInterface> writer =
+        video_encoder_pool_ != nullptr
+            ? output_writer_provider_(video_segment_name)
+            : OpenSegmentWriter(shard, video_segment_name);
     auto new_video_segment = std::make_unique<VideoSegment>(
-        output_writer_provider_(std::move(video_segment_name)),
+        std::move(writer), std::move(video_segment_name),
         std::move(file_identifier), buffer->width(), buffer->height(),
-        received_time, received_time);
+        received_time, received_time, file_width, file_height,
+        file_extension);
+    // Besides the write buffer, each segment holds about a frame, whether as
+    // its encoder's reference frame, its conversion buffer or its last frame.
+    new_video_segment->memory_charge = memory_account_.Acquire(
+        MemoryCategory::kOpenSegments,
+        kSegmentWriterMemoryEstimate +
+            I420FrameBytes(buffer->width(), buffer->height()));
+    if (video_encoder_pool_ != nullptr) {
+      // Segments end when the resolution changes, so each segment's encoder
+      // is initialized for a single resolution.
+      new_video_segment->encoder = video_encoder_pool_->CreateSegmentEncoder(
+          buffer->width(), buffer->height(),
+          std::move(new_video_segment->writer));
+    } else if (raw_video_format_ == VideoPixelFormat::kI420) {
+      WriteY4mFileHeader(file_width, file_height, kVideoFrameRate,
+                         *new_video_segment->writer);
+    }
     video_segment = new_video_segment.get();
-    video_segments_[contributing_source] = std::move(new_video_segment);
+    shard.video_segments[contributing_source] = std::move(new_video_segment);
   }
 
   DCHECK(video_segment != nullptr);
   // At this point, either an existing segment is being appended to or a new
   // segment has been created.
-  WriteYuv420(*i420, *video_segment->writer);
+  if (skip_repeated_video_frames_) {
+    // Convert the buffer up front to compare it with the previous frame. The
+    // converted buffer is written, so it is not converted again.
+    rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+        shard.i420_pool.ToI420(*buffer);
+    if (i420 == nullptr) {
+      LOG(ERROR) << "Failed to convert video frame buffer to I420.";
+      return;
+    }
+    if (video_segment->last_frame != nullptr &&
+        HasSameYuv420Pixels(*i420, *video_segment->last_frame)) {
+      ++video_segment->skipped_frame_count;
+      return;
+    }
+    video_segment->last_frame = i420;
+    buffer = std::move(i420);
+  }
+  if (video_segment->encoder != nullptr) {
+    video_segment->encoder->Encode(std::move(buffer), received_time);
+    return;
+  }
+  if (buffer->type() != webrtc::VideoFrameBuffer::Type::kI420) {
+    buffer = shard.i420_pool.ToI420(*buffer);
+  }
+  if (buffer == nullptr) {
+    LOG(ERROR) << "Failed to convert video frame buffer to I420.";
+    return;
+  }
+  // `ToI420` returns I420 buffers themselves.
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+      shard.i420_pool.Scale(buffer->ToI420(), video_segment->file_width,
+                            video_segment->file_height);
+  if (raw_video_format_ == VideoPixelFormat::kI420) {
+    WriteY4mFrame(*i420, *video_segment->writer);
+    return;
+  }
+  WriteRawVideoFrame(*i420, raw_video_format_,
+                     video_segment->conversion_buffer,
+                     *video_segment->writer);
 }
 
 void MultiUserMediaCollector::OnResourceUpdate(meet::ResourceUpdate update) {
@@ -203,6 +427,10 @@ void MultiUserMediaCollector::OnResourceUpdate(meet::ResourceUpdate update) {
   collector_thread_->PostTask(
       [this, update = std::move(update), received_time = received_time] {
         if (std::holds_alternative<meet::MediaEntriesChannelToClient>(update)) {
+          if (video_assignment_policy_.has_value()) {
+            MaybeRequestVideoAssignment(
+                std::get<meet::MediaEntriesChannelToClient>(update));
+          }
           resource_manager_->OnMediaEntriesResourceUpdate(
               std::move(std::get<meet::MediaEntriesChannelToClient>(update)),
               received_time);
@@ -215,51 +443,367 @@ void MultiUserMediaCollector::OnResourceUpdate(meet::ResourceUpdate update) {
       });
 }
 
+void MultiUserMediaCollector::MaybeRequestVideoAssignment(
+    const meet::MediaEntriesChannelToClient& update) {
+  DCHECK(collector_thread_->IsCurrent());
+
+  std::optional<meet::SetVideoAssignmentRequest> request =
+      video_assignment_policy_->HandleMediaEntriesUpdate(update);
+  if (!request.has_value()) {
+    return;
+  }
+  send_video_assignment_request_(meet::VideoAssignmentChannelFromClient{
+      .request = {.request_id = next_video_assignment_request_id_++,
+                  .set_video_assignment_request = *std::move(request)}});
+}
+
 void MultiUserMediaCollector::OnDisconnected(absl::Status status) {
   // The `MediaApiClient` will only call this method once.
   DCHECK(!disconnect_notification_.HasBeenNotified());
 
   LOG(INFO) << "MultiUserMediaCollector::OnDisconnected " << status;
   collector_thread_->PostTask([this] {
-    for (auto& [contributing_source, audio_segment] : audio_segments_) {
-      CloseAudioSegment(*audio_segment);
-    }
-    audio_segments_.clear();
-    for (auto& [contributing_source, video_segment] : video_segments_) {
-      CloseVideoSegment(*video_segment);
+    for (Shard& shard : shards_) {
+      ++remaining_shards_to_close_;
+      PostAfterQueuedFrames(shard, [this, &shard] {
+        CloseShardSegments(shard);
+        collector_thread_->PostTask([this] {
+          --remaining_shards_to_close_;
+          MaybeNotifyDisconnected();
+        });
+      });
     }
-    video_segments_.clear();
-
-    disconnect_notification_.Notify();
+    disconnected_ = true;
+    MaybeNotifyDisconnected();
   });
 }
 
-void MultiUserMediaCollector::CloseAudioSegment(AudioSegment& audio_segment) {
-  DCHECK(collector_thread_->IsCurrent());
+void MultiUserMediaCollector::CloseShardSegments(Shard& shard) {
+  DCHECK(shard.thread->IsCurrent());
+
+  for (auto& [contributing_source, audio_segment] : shard.audio_segments) {
+    CloseAudioSegment(*audio_segment);
+  }
+  shard.audio_segments.clear();
+  for (auto& [contributing_source, video_segment] : shard.video_segments) {
+    CloseVideoSegment(*video_segment);
+  }
+  shard.video_segments.clear();
+}
+
+void MultiUserMediaCollector::CloseIdleSegments() {
+  absl::Time idle_since = absl::Now() - segment_gap_threshold_;
+  for (Shard& shard : shards_) {
+    PostAfterQueuedFrames(shard, [this, &shard, idle_since] {
+      CloseIdleShardSegments(shard, idle_since);
+    });
+  }
+}
+
+void MultiUserMediaCollector::PostAfterQueuedFrames(
+    Shard& shard, absl::AnyInvocable<void() &&> task) {
+  shard.audio_queue->PostAfterQueuedFrames(
+      [&shard, task = std::move(task)]() mutable {
+        shard.video_queue->PostAfterQueuedFrames(std::move(task));
+      });
+}
+
+void MultiUserMediaCollector::CloseIdleShardSegments(Shard& shard,
+                                                     absl::Time idle_since) {
+  DCHECK(shard.thread->IsCurrent());
 
-  audio_segment.writer->Close();
-  segment_renamer_(
-      absl::StrFormat(kTmpAudioFormat, output_file_prefix_,
-                      audio_segment.file_identifier),
-      absl::StrFormat(kFinishedAudioFormat, output_file_prefix_,
-                      audio_segment.file_identifier,
-                      absl::FormatTime(audio_segment.first_frame_time),
-                      absl::FormatTime(audio_segment.last_frame_time)));
+  for (auto it = shard.audio_segments.begin();
+       it != shard.audio_segments.end();) {
+    if (it->second->last_frame_time < idle_since) {
+      CloseAudioSegment(*it->second);
+      shard.audio_segments.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = shard.video_segments.begin();
+       it != shard.video_segments.end();) {
+    if (it->second->last_frame_time < idle_since) {
+      CloseVideoSegment(*it->second);
+      shard.video_segments.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void MultiUserMediaCollector::CloseAudioSegment(AudioSegment& audio_segment) {
+  std::string finished_name = absl::StrFormat(
+      kFinishedAudioFormat, output_file_prefix_, audio_segment.file_identifier,
+      absl::FormatTime(audio_segment.first_frame_time),
+      absl::FormatTime(audio_segment.last_frame_time));
+  audio_segment.writer->CloseAsync(
+      RenameSegmentOnClose(std::move(audio_segment.tmp_name),
+                           {.kind = meet::MediaKind::kAudio,
+                            .file_identifier = audio_segment.file_identifier,
+                            .file_name = std::move(finished_name),
+                            .first_frame_time = audio_segment.first_frame_time,
+                            .last_frame_time = audio_segment.last_frame_time}));
 }
 
 void MultiUserMediaCollector::CloseVideoSegment(VideoSegment& video_segment) {
+  std::string finished_name = absl::StrFormat(
+      kFinishedVideoFormat, output_file_prefix_, video_segment.file_identifier,
+      absl::FormatTime(video_segment.first_frame_time),
+      absl::FormatTime(video_segment.last_frame_time),
+      video_segment.file_width, video_segment.file_height,
+      video_segment.file_extension);
+  if (video_segment.skipped_frame_count > 0) {
+    VLOG(1) << "Skipped " << video_segment.skipped_frame_count
+            << " repeated frames of " << finished_name;
+  }
+  absl::AnyInvocable<void() &&> on_closed =
+      RenameSegmentOnClose(std::move(video_segment.tmp_name),
+                           {.kind = meet::MediaKind::kVideo,
+                            .file_identifier = video_segment.file_identifier,
+                            .file_name = std::move(finished_name),
+                            .first_frame_time = video_segment.first_frame_time,
+                            .last_frame_time = video_segment.last_frame_time,
+                            .width = video_segment.file_width,
+                            .height = video_segment.file_height});
+  if (video_segment.encoder != nullptr) {
+    // The encoder writes any queued frames before closing the writer.
+    video_segment.encoder->CloseAsync(std::move(on_closed));
+    return;
+  }
+  video_segment.writer->CloseAsync(std::move(on_closed));
+}
+
+absl::AnyInvocable<void() &&> MultiUserMediaCollector::RenameSegmentOnClose(
+    std::string tmp_name, SegmentCatalogEntry entry) {
+  // Files only get their finished names, and are only cataloged, once all of
+  // their data has been written and they have been finalized, e.g. mapped
+  // files truncated.
+  return [this, tmp_name = std::move(tmp_name), entry = std::move(entry),
+          on_closed = TrackSegmentClose()]() mutable {
+    segment_renamer_(tmp_name, entry.file_name);
+    if (segment_catalog_ != nullptr) {
+      segment_catalog_->Append(entry);
+    }
+    std::move(on_closed)();
+  };
+}
+
+absl::AnyInvocable<void() &&> MultiUserMediaCollector::TrackSegmentClose() {
+  pending_segment_closes_.fetch_add(1);
+  return [this]() {
+    if (pending_segment_closes_.fetch_sub(1) != 1) {
+      return;
+    }
+    if (collector_thread_->IsCurrent()) {
+      MaybeNotifyDisconnected();
+      return;
+    }
+    collector_thread_->PostTask([this] { MaybeNotifyDisconnected(); });
+  };
+}
+
+void MultiUserMediaCollector::MaybeNotifyDisconnected() {
   DCHECK(collector_thread_->IsCurrent());
 
-  video_segment.writer->Close();
-  segment_renamer_(
-      absl::StrFormat(kTmpVideoFormat, output_file_prefix_,
-                      video_segment.file_identifier, video_segment.width,
-                      video_segment.height),
-      absl::StrFormat(kFinishedVideoFormat, output_file_prefix_,
-                      video_segment.file_identifier,
-                      absl::FormatTime(video_segment.first_frame_time),
-                      absl::FormatTime(video_segment.last_frame_time),
-                      video_segment.width, video_segment.height));
+  // Every segment has been appended to the catalog once all shards have closed
+  // their segments and those segments have finished closing, so the catalog
+  // is closed then, before notifying.
+  if (disconnected_ && remaining_shards_to_close_ == 0 &&
+      pending_segment_closes_.load() == 0 && segment_catalog_ != nullptr &&
+      !segment_catalog_closing_) {
+    segment_catalog_closing_ = true;
+    segment_catalog_->CloseAsync(TrackSegmentClose());
+  }
+  if (disconnected_ && remaining_shards_to_close_ == 0 &&
+      pending_segment_closes_.load() == 0 &&
+      !disconnect_notification_.HasBeenNotified()) {
+    disconnect_notification_.Notify();
+  }
+}
+
+MultiUserMediaCollector::~MultiUserMediaCollector() {
+  // Encoder threads are owned by this collector even when its other threads
+  // are shared, and they post segment closes to the collector thread.
+  if (video_encoder_pool_ != nullptr) {
+    video_encoder_pool_->Stop();
+  }
+  if (owned_collector_thread_ == nullptr) {
+    // Shared threads keep running, so wait for any tasks already posted for
+    // this collector to finish instead. Shard threads are flushed first since
+    // they post tasks to the collector thread.
+    for (Shard& shard : shards_) {
+      if (shard.thread != collector_thread_) {
+        shard.thread->BlockingCall([] {});
+      }
+    }
+    collector_thread_->BlockingCall([] {});
+    return;
+  }
+
+  // Stop the threads to ensure that enqueued tasks do not access member
+  // fields after they have been destroyed. Output writer and shard threads
+  // are stopped first since they post tasks to the collector thread.
+  if (owned_output_writer_threads_ != nullptr) {
+    owned_output_writer_threads_->Stop();
+  }
+  for (std::unique_ptr<rtc::Thread>& shard_thread : owned_shard_threads_) {
+    shard_thread->Stop();
+  }
+  owned_collector_thread_->Stop();
+}
+
+std::unique_ptr<OutputWriterInterface>
+MultiUserMediaCollector::OpenSegmentWriter(Shard& shard,
+                                           absl::string_view file_name) {
+  std::unique_ptr<OutputWriterInterface> writer =
+      output_writer_provider_(file_name);
+  if (shard.writer_cache == nullptr) {
+    return writer;
+  }
+  return shard.writer_cache->Wrap(file_name, std::move(writer));
+}
+
+std::unique_ptr<OutputWriterInterface> MultiUserMediaCollector::OpenFileWriter(
+    absl::string_view file_name, std::ios::openmode mode) {
+  // Media is written in many small chunks, so buffer writes to reduce the
+  // number of file writes. Buffered chunks are written on the output writer
+  // threads, so that a slow disk does not stall the collector thread.
+  return std::make_unique<BufferedOutputWriter>(
+      std::make_unique<AsyncOutputWriter>(
+          std::make_unique<OutputFile>(OpenFile(file_name, mode)),
+          output_writer_threads_));
+}
+
+void MultiUserMediaCollector::InitializeFileOutput(
+    EventLogFormat event_log_format) {
+  audio_segment_memory_estimate_ = kDefaultMappedExtentSize;
+  output_writer_provider_ = [this](absl::string_view file_name)
+      -> std::unique_ptr<OutputWriterInterface> {
+    // Audio segments are written through a preallocated memory mapping, so
+    // that writes are copies instead of write calls on the shard threads.
+    // They are closed on the output writer threads, so that the segments
+    // closed at once on disconnecting are finalized in parallel.
+    if (absl::EndsWith(file_name, kAudioFileExtension)) {
+      absl::StatusOr<std::unique_ptr<MappedOutputFile>> mapped_file =
+          MappedOutputFile::Create(file_name, kDefaultMappedExtentSize,
+                                   output_writer_threads_->NextThread());
+      if (mapped_file.ok()) {
+        LOG(INFO) << "Opened mapped file: " << file_name;
+        return *std::move(mapped_file);
+      }
+      LOG(WARNING) << "Failed to map file, writing it instead: "
+                   << mapped_file.status();
+    }
+    return OpenFileWriter(file_name, std::ios::trunc);
+  };
+  // Reopened files are appended to through buffered writes, since a mapping
+  // would have to be extended from the end of the file.
+  segment_reopen_provider_ = [this](absl::string_view file_name) {
+    return OpenFileWriter(file_name, std::ios::app);
+  };
+  segment_renamer_ = [](absl::string_view tmp_file_name,
+                        absl::string_view finished_file_name) {
+    // Audio segments' sizes are only known once they have closed.
+    if (absl::EndsWith(tmp_file_name, kAudioFileExtension)) {
+      absl::Status status = FinalizeWavFileHeader(tmp_file_name);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to finalize WAV header: " << status;
+      }
+    }
+    std::rename(tmp_file_name.data(), finished_file_name.data());
+  };
+  resource_manager_ = std::make_unique<ResourceManager>(CreateEventLogWriter(
+      event_log_format,
+      output_writer_provider_(absl::StrCat(
+          output_file_prefix_, event_log_format == EventLogFormat::kColumnar
+                                   ? "event_log.columnar"
+                                   : "event_log.csv"))));
+  // Catalog records are written unbuffered and flushed one at a time, so
+  // that readers of a running collector's catalog see each segment once it
+  // has finished, and only the record being written can be lost if the
+  // collector stops.
+  segment_catalog_ = std::make_unique<SegmentCatalogWriter>(
+      std::make_unique<AsyncOutputWriter>(
+          std::make_unique<OutputFile>(
+              OpenFile(absl::StrCat(output_file_prefix_, "segments.catalog"),
+                       std::ios::trunc),
+              /*flush_writes=*/true),
+          output_writer_threads_));
+}
+
+void MultiUserMediaCollector::InitializeShards(
+    std::vector<rtc::Thread*> shard_threads) {
+  if (shard_threads.empty()) {
+    shards_ = std::vector<Shard>(1);
+    shards_[0].thread = collector_thread_;
+  } else {
+    shards_ = std::vector<Shard>(shard_threads.size());
+    for (size_t i = 0; i < shard_threads.size(); ++i) {
+      shards_[i].thread = shard_threads[i];
+    }
+  }
+  SetFrameQueueOptions(kDefaultAudioFrameQueueOptions,
+                       kDefaultVideoFrameQueueOptions);
+}
+
+absl::Status MultiUserMediaCollector::SetRawVideoOutput(
+    VideoPixelFormat format, int width, int height) {
+  if (width < 0 || height < 0 || (width == 0) != (height == 0)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Raw video output resolution must be positive or zero, got ", width,
+        "x", height, "."));
+  }
+  raw_video_format_ = format;
+  raw_video_width_ = width;
+  raw_video_height_ = height;
+  return absl::OkStatus();
+}
+
+void MultiUserMediaCollector::SetMaxOpenSegmentFiles(size_t max_open_files) {
+  // Round up, so that every shard can keep at least one file open.
+  size_t max_open_files_per_shard =
+      (max_open_files + shards_.size() - 1) / shards_.size();
+  for (Shard& shard : shards_) {
+    shard.writer_cache = std::make_unique<OutputWriterCache>(
+        max_open_files_per_shard, [this](absl::string_view file_name) {
+          return segment_reopen_provider_ != nullptr
+                     ? segment_reopen_provider_(file_name)
+                     : output_writer_provider_(file_name);
+        });
+  }
+}
+
+void MultiUserMediaCollector::SetFrameQueueOptions(
+    FrameQueueOptions audio_options, FrameQueueOptions video_options) {
+  for (Shard& shard : shards_) {
+    shard.audio_queue =
+        std::make_unique<FrameQueue>(shard.thread, audio_options);
+    shard.video_queue =
+        std::make_unique<FrameQueue>(shard.thread, video_options);
+  }
+}
+
+FrameQueueStats MultiUserMediaCollector::GetAudioQueueStats() const {
+  FrameQueueStats stats;
+  for (const Shard& shard : shards_) {
+    stats += shard.audio_queue->GetStats();
+  }
+  return stats;
+}
+
+FrameQueueStats MultiUserMediaCollector::GetVideoQueueStats() const {
+  FrameQueueStats stats;
+  for (const Shard& shard : shards_) {
+    stats += shard.video_queue->GetStats();
+  }
+  return stats;
+}
+
+MultiUserMediaCollector::Shard& MultiUserMediaCollector::ShardFor(
+    ContributingSource contributing_source) {
+  return shards_[absl::Hash<ContributingSource>()(contributing_source) %
+                 shards_.size()];
 }
 
 }  // namespace media_api_samples
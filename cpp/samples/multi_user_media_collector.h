@@ -17,11 +17,12 @@
 #ifndef CPP_SAMPLES_MULTI_USER_MEDIA_COLLECTOR_H_
 #define CPP_SAMPLES_MULTI_USER_MEDIA_COLLECTOR_H_
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <cstdio>
-#include <fstream>
 #include <ios>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -31,15 +32,29 @@
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
-#include "absl/strings/str_cat.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
-#include "cpp/samples/output_file.h"
+#include "cpp/api/media_entries_resource.h"
+#include "cpp/api/video_assignment_resource.h"
+#include "cpp/internal/audio_buffer_pool.h"
+#include "cpp/internal/video_assignment_policy.h"
+#include "cpp/samples/async_output_writer.h"
+#include "cpp/samples/audio_levels.h"
+#include "cpp/samples/audio_resampler.h"
+#include "cpp/samples/buffered_output_writer.h"
+#include "cpp/samples/event_log.h"
+#include "cpp/samples/frame_queue.h"
+#include "cpp/samples/i420_buffer_pool.h"
+#include "cpp/samples/media_writing.h"
+#include "cpp/samples/memory_account.h"
+#include "cpp/samples/output_writer_cache.h"
 #include "cpp/samples/output_writer_interface.h"
-#include "cpp/samples/resource_manager.h"
 #include "cpp/samples/resource_manager_interface.h"
+#include "cpp/samples/segment_catalog.h"
+#include "cpp/samples/video_segment_encoder.h"
 #include "webrtc/api/scoped_refptr.h"
 #include "webrtc/api/video/video_frame_buffer.h"
 #include "webrtc/rtc_base/thread.h"
@@ -63,86 +78,292 @@ namespace media_api_samples {
 // format:
 //
 // Audio:
-//   <output_file_prefix>audio_<participant_identifiers>_tmp.pcm
+//   <output_file_prefix>audio_<participant_identifiers>_tmp_<number>.wav
 // Video:
-//   <output_file_prefix>video_<participant_identifiers>_tmp_<width>x<height>.yuv
+//   <output_file_prefix>video_<participant_identifiers>_tmp_<number>_<width>x<height>.y4m
 //
-// Once a segment is finished, the `tmp` token will be replaced with the start
-// and end times of the segment:
+// where `number` is unique among the collector's segments. Once a segment is
+// finished and its file has been closed, the `tmp` token and number will be
+// replaced with the start and end times of the segment:
 //
 // Audio:
-//   <output_file_prefix>audio_<participant_identifiers>_<start_time>_<end_time>.pcm
+//   <output_file_prefix>audio_<participant_identifiers>_<start_time>_<end_time>.wav
 // Video:
-//   <output_file_prefix>video_<participant_identifiers>_<start_time>_<end_time>_<width>x<height>.yuv
+//   <output_file_prefix>video_<participant_identifiers>_<start_time>_<end_time>_<width>x<height>.y4m
 //
 // For video segments, the resolution of the segment will also be included in
 // the file name. The resolution is appended to the end of the file name so that
 // files are lexicographically ordered by display name and start time.
 //
+// Audio segments are WAV files of PCM16 samples, and video segments are Y4M
+// files of YUV420p frames, so their formats can be read from the files
+// themselves. See `WriteWavFileHeader` and `WriteY4mFileHeader`.
+//
+// If video encoding is enabled, video segments are instead encoded and written
+// as IVF files, with the `.ivf` extension. See `EnableVideoEncoding`.
+// Otherwise, raw video segments can be converted to a pixel format that is
+// ready for vision models, without a Y4M header. See `SetRawVideoOutput`.
+//
 // `participant_identifiers` is a string that uniquely identifies the media
 // stream. This is handled by the participant manager implementation.
+//
+// Once each segment has been renamed, it is also appended to the segment
+// catalog, `<output_file_prefix>segments.catalog`, which records the same
+// metadata as the file name in a form that can be indexed by participant and
+// time without listing the output directory. See `SegmentCatalog`. File names
+// keep their metadata, so existing consumers of the files still work.
+//
+// By default, audio segments are written to memory-mapped files (see
+// `MappedOutputFile`), and video segments and the event log are written on
+// output writer threads. Segments are closed on the output writer threads
+// too, so the many segments that are closed on disconnecting are finalized in
+// parallel, bounded by the number of writer threads, and the disconnect
+// notification is only sent once all of them have closed.
 class MultiUserMediaCollector : public meet::MediaApiClientObserverInterface {
  public:
-  // Lambda for renaming media segments when they are closed.
+  // Lambda for renaming media segments once their writers have finished
+  // closing. It is invoked on the thread that finished closing the writer.
   using SegmentRenamer =
       absl::AnyInvocable<void(/*tmp_name=*/absl::string_view,
                               /*timestamped_name=*/absl::string_view)>;
 
   // Default constructor that writes media to real files and uses a real
   // participant manager.
-  MultiUserMediaCollector(absl::string_view output_file_prefix,
-                          absl::Duration segment_gap_threshold,
-                          std::unique_ptr<rtc::Thread> collector_thread)
+  //
+  // If `shard_threads` is non-empty, segments are partitioned across those
+  // threads by contributing source, so that media from different participants
+  // is written in parallel. Otherwise, all segments are handled on
+  // `collector_thread`.
+  //
+  // The event log is written to `<output_file_prefix>event_log.csv`, or to
+  // `<output_file_prefix>event_log.columnar` in the columnar format.
+  MultiUserMediaCollector(
+      absl::string_view output_file_prefix,
+      absl::Duration segment_gap_threshold,
+      std::unique_ptr<rtc::Thread> collector_thread,
+      std::vector<std::unique_ptr<rtc::Thread>> shard_threads = {},
+      EventLogFormat event_log_format = EventLogFormat::kCsv)
       : output_file_prefix_(output_file_prefix),
         segment_gap_threshold_(segment_gap_threshold),
-        collector_thread_(std::move(collector_thread)) {
-    output_writer_provider_ = [](absl::string_view file_name) {
-      std::ofstream file(std::string(file_name),
-                         std::ios::binary | std::ios::out | std::ios::trunc);
-      if (file.is_open()) {
-        LOG(INFO) << "Opened file: " << file_name;
-      } else {
-        // Files should normally open successfully.
-        //
-        // Potential causes for failure include:
-        // - The parent directory does not exist.
-        // - The system is out of disk space.
-        //
-        // If a file cannot be opened, the sample will still run, but written
-        // data will be lost.
-        LOG(ERROR) << "Failed to open file: " << file_name;
-      }
-      return std::make_unique<OutputFile>(std::move(file));
-    };
-    segment_renamer_ = [](absl::string_view tmp_file_name,
-                          absl::string_view finished_file_name) {
-      std::rename(tmp_file_name.data(), finished_file_name.data());
-    };
-    resource_manager_ =
-        std::make_unique<ResourceManager>(output_writer_provider_(
-            absl::StrCat(output_file_prefix_, "event_log.csv")));
+        owned_collector_thread_(std::move(collector_thread)),
+        collector_thread_(owned_collector_thread_.get()),
+        owned_shard_threads_(std::move(shard_threads)) {
+    std::vector<rtc::Thread*> shard_thread_ptrs;
+    for (std::unique_ptr<rtc::Thread>& shard_thread : owned_shard_threads_) {
+      shard_thread_ptrs.push_back(shard_thread.get());
+    }
+    InitializeShards(std::move(shard_thread_ptrs));
+    absl::StatusOr<std::unique_ptr<OutputWriterThreadPool>>
+        output_writer_threads =
+            OutputWriterThreadPool::Create(kOutputWriterThreadCount);
+    CHECK_OK(output_writer_threads.status());
+    owned_output_writer_threads_ = std::move(output_writer_threads).value();
+    output_writer_threads_ = owned_output_writer_threads_.get();
+    InitializeFileOutput(event_log_format);
+  }
+
+  // Constructor for collectors that share their threads with the other
+  // collectors of a process, such as the collectors of a `ConferenceHost`.
+  //
+  // The threads and `output_writer_threads` are not owned and must outlive the
+  // collector. Since they are not stopped when the collector is destroyed, the
+  // collector must only be destroyed once it has disconnected and its client
+  // has been destroyed, so that no more tasks are posted for it.
+  MultiUserMediaCollector(
+      absl::string_view output_file_prefix,
+      absl::Duration segment_gap_threshold, rtc::Thread* collector_thread,
+      std::vector<rtc::Thread*> shard_threads,
+      OutputWriterThreadPool* output_writer_threads,
+      EventLogFormat event_log_format = EventLogFormat::kCsv)
+      : output_file_prefix_(output_file_prefix),
+        output_writer_threads_(output_writer_threads),
+        segment_gap_threshold_(segment_gap_threshold),
+        collector_thread_(collector_thread) {
+    InitializeShards(std::move(shard_threads));
+    InitializeFileOutput(event_log_format);
   }
 
   // Constructor that allows injecting dependencies for testing.
+  //
+  // When sharded, or when the number of open segment files is limited,
+  // `output_writer_provider` is invoked concurrently from several threads, so
+  // it must be thread-safe. `segment_renamer` is invoked
+  // from whichever threads finish closing segments, so it must be thread-safe
+  // even if the collector is not sharded.
   MultiUserMediaCollector(
       absl::string_view output_file_prefix,
       OutputWriterProvider output_writer_provider,
       SegmentRenamer segment_renamer, absl::Duration segment_gap_threshold,
       std::unique_ptr<ResourceManagerInterface> resource_manager,
-      std::unique_ptr<rtc::Thread> collector_thread)
+      std::unique_ptr<rtc::Thread> collector_thread,
+      std::vector<std::unique_ptr<rtc::Thread>> shard_threads = {})
       : output_file_prefix_(output_file_prefix),
         output_writer_provider_(std::move(output_writer_provider)),
         segment_renamer_(std::move(segment_renamer)),
         segment_gap_threshold_(segment_gap_threshold),
         resource_manager_(std::move(resource_manager)),
-        collector_thread_(std::move(collector_thread)) {}
+        owned_collector_thread_(std::move(collector_thread)),
+        collector_thread_(owned_collector_thread_.get()),
+        owned_shard_threads_(std::move(shard_threads)) {
+    std::vector<rtc::Thread*> shard_thread_ptrs;
+    for (std::unique_ptr<rtc::Thread>& shard_thread : owned_shard_threads_) {
+      shard_thread_ptrs.push_back(shard_thread.get());
+    }
+    InitializeShards(std::move(shard_thread_ptrs));
+  }
+
+  ~MultiUserMediaCollector() override;
+
+  // Encodes video segments with `encoder_pool` instead of writing raw frames,
+  // which makes them much smaller at the cost of encoding them as they are
+  // received. If the encoders fall behind, frames are dropped instead of
+  // delaying other segments.
+  //
+  // Must be called before the collector receives any frames.
+  void EnableVideoEncoding(
+      std::unique_ptr<VideoSegmentEncoderPool> encoder_pool) {
+    video_encoder_pool_ = std::move(encoder_pool);
+  }
+
+  // Skips video frames whose pixels are the same as the previous frame of their
+  // segment, as is common for screen shares and static camera feeds.
+  //
+  // Encoded segments keep the timestamps of the frames that are written. Y4M
+  // files are played back at a constant rate though, so static periods of raw
+  // segments are shortened. Their file names still record when they started
+  // and ended.
+  //
+  // Must be called before the collector receives any frames.
+  void EnableRepeatedVideoFrameSkipping() {
+    skip_repeated_video_frames_ = true;
+  }
+
+  // Segments audio by speech rather than by frame arrival. Frames whose RMS
+  // level is below `silence_threshold_dbfs` neither start nor extend audio
+  // segments, so a segment ends once its participant has been silent for
+  // `segment_gap_threshold`, even though an open microphone keeps sending
+  // frames. Shorter pauses are still written, so segments play back in real
+  // time.
+  //
+  // Must be called before the collector receives any frames.
+  void EnableSilenceSkipping(
+      double silence_threshold_dbfs = kDefaultSilenceThresholdDbfs) {
+    skip_silent_audio_ = true;
+    silence_threshold_dbfs_ = silence_threshold_dbfs;
+  }
 
-  ~MultiUserMediaCollector() override {
-    // Stop the thread to ensure that enqueued tasks do not access member fields
-    // after they have been destroyed.
-    collector_thread_->Stop();
+  // Converts audio before it is written, e.g. to 16 kHz mono for speech
+  // recognition. Each segment resamples its participant's stream continuously.
+  //
+  // Must be called before the collector receives any frames.
+  absl::Status EnableAudioConversion(AudioConversion conversion) {
+    if (absl::Status status = ValidateAudioConversion(conversion);
+        !status.ok()) {
+      return status;
+    }
+    audio_conversion_ = conversion;
+    return absl::OkStatus();
   }
 
+  // Writes raw video segments as headerless frames in `format`, optionally
+  // scaled to `width` by `height`, so that consumers such as vision models can
+  // read them without converting each frame themselves. The file extension is
+  // given by `RawVideoFileExtension` and the file names record the written
+  // resolution. I420 frames are still written as Y4M files.
+  //
+  // If `width` and `height` are zero, frames are written at the resolution
+  // they are received at. Has no effect if video encoding is enabled.
+  //
+  // Must be called before the collector receives any frames.
+  absl::Status SetRawVideoOutput(VideoPixelFormat format, int width = 0,
+                                 int height = 0);
+
+  // Limits the number of raw segment files that are open at once, so that file
+  // descriptors and write buffers stay bounded however many participants are
+  // recorded. Once the limit is reached, the least recently written segment
+  // is flushed and its file closed, and the file is reopened for appending
+  // when the segment is next written to. The limit is divided between the
+  // shards. Encoded segments are not limited.
+  //
+  // Segments that are written to continuously are reopened frequently if the
+  // limit is lower than the number of active segments, so it should be set
+  // well above the number of participants expected to speak or share video at
+  // once. If a custom writer provider is injected, it is also used to reopen
+  // files, and should append to existing files.
+  //
+  // Must be called before the collector receives any frames.
+  void SetMaxOpenSegmentFiles(size_t max_open_files);
+
+  // Appends finished segments to `segment_catalog` instead of the default
+  // catalog file, as their writers finish closing. Collectors with injected
+  // dependencies do not write a catalog unless one is set. The catalog is
+  // closed once every segment has finished closing, before the disconnect
+  // notification is sent.
+  //
+  // Must be called before the collector receives any frames.
+  void SetSegmentCatalog(
+      std::unique_ptr<SegmentCatalogWriter> segment_catalog) {
+    segment_catalog_ = std::move(segment_catalog);
+  }
+
+  // Chooses video assignments with a `meet::VideoAssignmentPolicy` as media
+  // entries change, instead of leaving a fixed layout in place, so that only
+  // the video that media entries are sending is requested and decoded. Each
+  // request is passed to `send_request` on the collector thread, to be sent
+  // through the client.
+  //
+  // Must be called before the collector receives any resource updates.
+  void SetVideoAssignmentPolicy(
+      meet::VideoAssignmentPolicyConfiguration config,
+      absl::AnyInvocable<void(meet::VideoAssignmentChannelFromClient)>
+          send_request) {
+    video_assignment_policy_.emplace(std::move(config));
+    send_video_assignment_request_ = std::move(send_request);
+  }
+
+  // Bounds the frames that each participant can have waiting to be written,
+  // so that memory use stays predictable while writes are stalled, e.g. by a
+  // slow disk. Defaults to `kDefaultAudioFrameQueueOptions` and
+  // `kDefaultVideoFrameQueueOptions`.
+  //
+  // `kBlock` blocks the client's media threads while writes are stalled, which
+  // may cause WebRTC to drop media instead.
+  //
+  // Must be called before the collector receives any frames.
+  void SetFrameQueueOptions(FrameQueueOptions audio_options,
+                            FrameQueueOptions video_options);
+
+  // Returns the combined stats of every shard's audio or video queue.
+  FrameQueueStats GetAudioQueueStats() const;
+  FrameQueueStats GetVideoQueueStats() const;
+
+  // Limits the memory held for queued frames and open segments to
+  // `budget_bytes`, so that a single conference cannot exhaust the memory of a
+  // host recording many conferences. While queued frames exceed the budget,
+  // received video frames are dropped until queued frames fall to half of it,
+  // so that audio keeps being recorded; see `GetMemoryBudgetDroppedVideoFrames`
+  // and `MemoryAccount::ShouldDropFrames`. Open segments count towards
+  // `IsOverMemoryBudget` but do not cause drops, since dropping frames does not
+  // release them; `CloseIdleSegments` does. Zero means unlimited, which is the
+  // default.
+  //
+  // Usage is estimated from the sizes of queued frames and of open segments'
+  // write buffers or mapped extents, rather than measured from the allocator.
+  void SetMemoryBudget(size_t budget_bytes) {
+    memory_account_.SetBudget(budget_bytes);
+  }
+  MemoryUsage GetMemoryUsage() const { return memory_account_.GetUsage(); }
+  bool IsOverMemoryBudget() const { return memory_account_.IsOverBudget(); }
+  uint64_t GetMemoryBudgetDroppedVideoFrames() const {
+    return memory_budget_dropped_video_frames_.load(std::memory_order_relaxed);
+  }
+
+  // Closes the segments that have not received a frame for longer than the
+  // segment gap threshold, releasing their writers. Such segments would be
+  // closed by their next frame anyway, so this does not change what is
+  // written. Frames queued before this is called are handled first.
+  void CloseIdleSegments();
+
   void OnAudioFrame(meet::AudioFrame frame) override;
   void OnVideoFrame(meet::VideoFrame frame) override;
   void OnResourceUpdate(meet::ResourceUpdate update) override;
@@ -174,6 +395,9 @@ class MultiUserMediaCollector : public meet::MediaApiClientObserverInterface {
  private:
   using ContributingSource = uint32_t;
 
+  // The number of threads used to write media files by default.
+  static constexpr uint32_t kOutputWriterThreadCount = 2;
+
   // Audio and video streams are logically broken up into media "segments".
   //
   // The first time a frame is received for a particular contributing source,
@@ -193,57 +417,206 @@ class MultiUserMediaCollector : public meet::MediaApiClientObserverInterface {
   //    a different resolution than the current segment.
   struct AudioSegment {
     std::unique_ptr<OutputWriterInterface> writer;
+    std::string tmp_name;
     std::string file_identifier;
     absl::Time first_frame_time;
+    // The time of the last frame that was not silence, if skipping silence.
     absl::Time last_frame_time;
+    // Null unless audio conversion is enabled.
+    std::unique_ptr<AudioResampler> resampler;
+    // The estimated memory held by the segment's writer.
+    MemoryAccount::Charge memory_charge;
   };
   struct VideoSegment {
     std::unique_ptr<OutputWriterInterface> writer;
+    std::string tmp_name;
     std::string file_identifier;
     int width = 0;
     int height = 0;
     absl::Time first_frame_time;
     absl::Time last_frame_time;
+    // The resolution and extension in the segment's file names, which differ
+    // from the received frames' if raw frames are converted.
+    int file_width = 0;
+    int file_height = 0;
+    absl::string_view file_extension;
+    // Set instead of `writer` if video encoding is enabled. Owns the segment's
+    // writer.
+    std::unique_ptr<VideoSegmentEncoder> encoder;
+    // Reused for converting raw frames to `raw_video_format_`.
+    std::vector<uint8_t> conversion_buffer;
+    // The last frame written to the segment, if skipping repeated frames.
+    rtc::scoped_refptr<webrtc::I420BufferInterface> last_frame;
+    int skipped_frame_count = 0;
+    // The estimated memory held by the segment's writer or encoder.
+    MemoryAccount::Charge memory_charge;
+  };
+
+  // Segments are partitioned across shards by contributing source. A shard's
+  // segments are only accessed on its thread.
+  struct Shard {
+    rtc::Thread* thread = nullptr;
+    // Null unless the number of open segment files is limited. Declared
+    // before the segments so that it outlives their writers.
+    std::unique_ptr<OutputWriterCache> writer_cache;
+    // Maps from contributing source to the current audio or video segment for
+    // that source.
+    //
+    // Values in these maps are never null.
+    // TODO: Remove comment once nullability annotations are added.
+    absl::flat_hash_map<ContributingSource, std::unique_ptr<AudioSegment>>
+        audio_segments;
+    absl::flat_hash_map<ContributingSource, std::unique_ptr<VideoSegment>>
+        video_segments;
+    // Frames waiting to be handled on the shard's thread. Never null.
+    std::unique_ptr<FrameQueue> audio_queue;
+    std::unique_ptr<FrameQueue> video_queue;
+    // Recycles the buffers of raw segments' converted frames, across all of
+    // the shard's segments.
+    I420BufferPool i420_pool;
   };
 
-  void HandleAudioData(std::vector<int16_t> samples,
+  // Writes media and the event log to files under `output_file_prefix_`,
+  // using `output_writer_threads_`.
+  void InitializeFileOutput(EventLogFormat event_log_format);
+  void InitializeShards(std::vector<rtc::Thread*> shard_threads);
+  Shard& ShardFor(ContributingSource contributing_source);
+  // Opens the file of a new raw segment, through the shard's writer cache if
+  // the number of open files is limited.
+  std::unique_ptr<OutputWriterInterface> OpenSegmentWriter(
+      Shard& shard, absl::string_view file_name);
+  // Opens a buffered writer to a local file, written on the output writer
+  // threads.
+  std::unique_ptr<OutputWriterInterface> OpenFileWriter(
+      absl::string_view file_name, std::ios::openmode mode);
+
+  // Starts a new segment with a WAV header for `sample_rate` and
+  // `channel_count` if needed, then appends the samples.
+  void HandleAudioData(Shard& shard,
+                       rtc::scoped_refptr<meet::AudioBufferInterface> buffer,
+                       int sample_rate, int channel_count,
                        ContributingSource contributing_source,
                        absl::Time received_time);
-  void HandleVideoData(rtc::scoped_refptr<webrtc::I420BufferInterface> buffer,
+  void HandleVideoData(Shard& shard,
+                       rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
                        ContributingSource contributing_source,
                        absl::Time received_time);
 
-  // Closes the audio or video segment. This will rename the file to include
-  // the start and end times of the segment.
+  // Sends the video assignment chosen by the policy for a media entries
+  // update, if it differs from the current one. Must be called on the
+  // collector thread.
+  void MaybeRequestVideoAssignment(
+      const meet::MediaEntriesChannelToClient& update);
+
+  // Closes all of a shard's segments. Must be called on the shard's thread.
+  void CloseShardSegments(Shard& shard);
+  // Closes a shard's segments whose last frame was before `idle_since`. Must
+  // be called on the shard's thread.
+  void CloseIdleShardSegments(Shard& shard, absl::Time idle_since);
+  // Runs `task` on the shard's thread once the audio and video frames queued
+  // for the shard before this call have been handled.
+  void PostAfterQueuedFrames(Shard& shard, absl::AnyInvocable<void() &&> task);
+
+  // Closes the audio or video segment. Once the segment's writer has finished
+  // closing, the file will be renamed to include the start and end times of
+  // the segment.
   void CloseAudioSegment(AudioSegment& audio_segment);
   void CloseVideoSegment(VideoSegment& video_segment);
+  // Counts a segment that has started closing, and returns the callback that
+  // renames its file to `entry.file_name` and appends `entry` to the catalog
+  // once its writer has finished closing.
+  absl::AnyInvocable<void() &&> RenameSegmentOnClose(std::string tmp_name,
+                                                     SegmentCatalogEntry entry);
+  // Counts a segment that has started closing, and returns the callback to
+  // invoke once it has finished closing.
+  absl::AnyInvocable<void() &&> TrackSegmentClose();
+  // Notifies `disconnect_notification_` once disconnected and all segments have
+  // finished closing. Must be called on the collector thread.
+  void MaybeNotifyDisconnected();
 
   std::string output_file_prefix_;
+  // Threads used by the default output writers, owned unless they are shared
+  // with other collectors. Null if a custom writer provider is injected.
+  //
+  // Declared before the segments so that it outlives their writers.
+  std::unique_ptr<OutputWriterThreadPool> owned_output_writer_threads_;
+  OutputWriterThreadPool* output_writer_threads_ = nullptr;
   OutputWriterProvider output_writer_provider_;
+  // Reopens parked segment files for appending. Null if a custom writer
+  // provider is injected, in which case that provider reopens files instead.
+  OutputWriterProvider segment_reopen_provider_;
   SegmentRenamer segment_renamer_;
+  // Null unless video encoding is enabled.
+  std::unique_ptr<VideoSegmentEncoderPool> video_encoder_pool_;
+  bool skip_repeated_video_frames_ = false;
+  VideoPixelFormat raw_video_format_ = VideoPixelFormat::kI420;
+  // Zero unless raw frames are scaled.
+  int raw_video_width_ = 0;
+  int raw_video_height_ = 0;
+  bool skip_silent_audio_ = false;
+  double silence_threshold_dbfs_ = kDefaultSilenceThresholdDbfs;
+  std::optional<AudioConversion> audio_conversion_;
   // If a media frame is received more than `segment_gap_threshold_` after
   // the previous frame for a given segment, a new media segment will be
   // created and the previous segment will be closed.
   absl::Duration segment_gap_threshold_;
 
-  // Maps from contributing source to the current audio or video segment for
-  // that source.
-  //
-  // Values in these maps are never null.
-  // TODO: Remove comment once nullability annotations are added.
-  absl::flat_hash_map<ContributingSource, std::unique_ptr<AudioSegment>>
-      audio_segments_;
-  absl::flat_hash_map<ContributingSource, std::unique_ptr<VideoSegment>>
-      video_segments_;
+  // Charged by queued frames and open segments, so it is declared before the
+  // shards.
+  MemoryAccount memory_account_;
+  std::atomic<uint64_t> memory_budget_dropped_video_frames_ = 0;
+  // The memory charged for each open audio segment: a mapped extent when
+  // audio segments are mapped, or a write buffer otherwise.
+  size_t audio_segment_memory_estimate_ = kDefaultOutputWriterFlushSize;
 
+  // Resource updates are applied on the collector thread, while identifiers
+  // are looked up from the shard threads without synchronization; see
+  // `ResourceManagerInterface::GetOutputFileIdentifier`.
   std::unique_ptr<ResourceManagerInterface> resource_manager_;
+  // Set if video assignments follow media entries. Only accessed on the
+  // collector thread.
+  std::optional<meet::VideoAssignmentPolicy> video_assignment_policy_;
+  absl::AnyInvocable<void(meet::VideoAssignmentChannelFromClient)>
+      send_video_assignment_request_;
+  int64_t next_video_assignment_request_id_ = 1;
+  // Appended to as segments finish closing, from whichever thread closed
+  // them. Null if no catalog is written.
+  std::unique_ptr<SegmentCatalogWriter> segment_catalog_;
+
+  // Used to copy audio frames that do not own their samples. Only accessed
+  // from `OnAudioFrame`, which the client always calls from the same thread.
+  meet::AudioBufferPool audio_buffer_pool_;
+
+  // The number of segments whose writers have not finished closing.
+  std::atomic<int> pending_segment_closes_ = 0;
+  // Numbers segments' temporary file names. Incremented from the shard
+  // threads.
+  std::atomic<uint64_t> next_segment_number_ = 0;
+  // The number of shards that have not closed their segments after
+  // disconnecting. Only accessed on the collector thread.
+  int remaining_shards_to_close_ = 0;
+  // Whether `OnDisconnected` has started closing all segments. Only accessed
+  // on the collector thread.
+  bool disconnected_ = false;
+  // Whether the segment catalog has started closing. Only accessed on the
+  // collector thread.
+  bool segment_catalog_closing_ = false;
 
   absl::Notification join_notification_;
   absl::Notification disconnect_notification_;
 
   // The media collector's internal thread. Used for moving work off of the
   // MediaApiClient's threads and synchronizing access to member variables.
-  std::unique_ptr<rtc::Thread> collector_thread_;
+  //
+  // Null if the thread is shared with other collectors.
+  std::unique_ptr<rtc::Thread> owned_collector_thread_;
+  rtc::Thread* collector_thread_;
+  // Additional threads that own segments when sharded, if they are owned by
+  // this collector.
+  std::vector<std::unique_ptr<rtc::Thread>> owned_shard_threads_;
+  // Never empty. Not resized after construction, so references to shards stay
+  // valid.
+  std::vector<Shard> shards_;
 };
 
 }  // namespace media_api_samples
@@ -31,14 +31,25 @@
 #include "absl/base/log_severity.h"
 #include "absl/log/globals.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "cpp/api/media_entries_resource.h"
+#include "cpp/api/video_assignment_resource.h"
+#include "cpp/internal/video_assignment_policy.h"
+#include "cpp/samples/frame_queue.h"
+#include "cpp/samples/media_writing.h"
 #include "cpp/samples/output_writer_interface.h"
+#include "cpp/samples/segment_catalog.h"
 #include "cpp/samples/testing/media_data.h"
 #include "cpp/samples/testing/mock_output_writer.h"
 #include "cpp/samples/testing/mock_resource_manager.h"
+#include "cpp/samples/video_segment_encoder.h"
 #include "webrtc/api/make_ref_counted.h"
 #include "webrtc/rtc_base/thread.h"
 
@@ -47,11 +58,30 @@ namespace {
 
 using ::base_logging::INFO;
 using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 using ::testing::kDoNotCaptureLogsYet;
 using ::testing::MatchesRegex;
 using ::testing::MockFunction;
+using ::testing::NiceMock;
 using ::testing::Return;
 using ::testing::ScopedMockLog;
+using ::testing::SizeIs;
+
+// Matches the temporary file names of segments, whose numbers depend on the
+// order in which segments are started.
+auto TmpAudioFileName(absl::string_view identifier) {
+  return MatchesRegex(
+      absl::StrCat("test_audio_", identifier, "_tmp_[0-9]+\\.wav"));
+}
+auto TmpVideoFileName(absl::string_view identifier,
+                      absl::string_view resolution_and_extension) {
+  return MatchesRegex(
+      absl::StrCat("test_video_", identifier, "_tmp_[0-9]+_",
+                   absl::StrReplaceAll(resolution_and_extension,
+                                       {{".", "\\."}})));
+}
 
 TEST(MultiUserMediaCollectorTest, WaitForJoinedTimesOutBeforeJoining) {
   auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
@@ -105,10 +135,10 @@ TEST(MultiUserMediaCollectorTest, ClosesAudioAndVideoSegmentsOnDisconnect) {
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_audio_identifier_1_tmp.pcm"))
+              Call(TmpAudioFileName("identifier_1")))
       .WillOnce(Return(std::move(mock_audio_output_file)));
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_2_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_2", "10x5.y4m")))
       .WillOnce(Return(std::move(mock_video_output_file)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -130,6 +160,63 @@ TEST(MultiUserMediaCollectorTest, ClosesAudioAndVideoSegmentsOnDisconnect) {
   EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
 }
 
+TEST(MultiUserMediaCollectorTest,
+     ShardedCollectorClosesAudioAndVideoSegmentsOnDisconnect) {
+  // Output file 1.
+  AudioTestData test_data1 = CreateAudioTestData(/*num_samples=*/10);
+  test_data1.frame.contributing_source = 1;
+  auto mock_audio_output_file = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*mock_audio_output_file, Write(_, _));
+  EXPECT_CALL(*mock_audio_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
+  EXPECT_CALL(*mock_audio_output_file, Close);
+
+  // Output file 2.
+  VideoTestData test_data2 = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  test_data2.meet_frame.contributing_source = 2;
+  auto mock_video_output_file = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*mock_video_output_file, Write(_, _)).Times(AnyNumber());
+  EXPECT_CALL(*mock_video_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
+  EXPECT_CALL(*mock_video_output_file, Close);
+
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpAudioFileName("identifier_1")))
+      .WillOnce(Return(std::move(mock_audio_output_file)));
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpVideoFileName("identifier_2", "10x5.y4m")))
+      .WillOnce(Return(std::move(mock_video_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(2))
+      .WillOnce(Return("identifier_2"));
+  MockFunction<void(absl::string_view, absl::string_view)> mock_renamer;
+  EXPECT_CALL(mock_renamer, Call).Times(2);
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  std::vector<std::unique_ptr<rtc::Thread>> shard_threads;
+  for (int i = 0; i < 2; ++i) {
+    shard_threads.push_back(rtc::Thread::Create());
+    shard_threads.back()->Start();
+  }
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      mock_renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread),
+      std::move(shard_threads));
+
+  collector->OnAudioFrame(std::move(test_data1.frame));
+  collector->OnVideoFrame(std::move(test_data2.meet_frame));
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+}
+
 TEST(MultiUserMediaCollectorTest, ClosingSegmentsRenamesFiles) {
   // Output file 1.
   AudioTestData test_data1 = CreateAudioTestData(/*num_samples=*/10);
@@ -148,10 +235,10 @@ TEST(MultiUserMediaCollectorTest, ClosingSegmentsRenamesFiles) {
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_audio_identifier_1_tmp.pcm"))
+              Call(TmpAudioFileName("identifier_1")))
       .WillOnce(Return(std::move(mock_audio_output_file)));
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_2_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_2", "10x5.y4m")))
       .WillOnce(Return(std::move(mock_video_output_file)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -162,11 +249,11 @@ TEST(MultiUserMediaCollectorTest, ClosingSegmentsRenamesFiles) {
   // Final segment names are generated using the current time, so just check
   // that the final segment name matches the expected format.
   EXPECT_CALL(mock_renamer,
-              Call("test_audio_identifier_1_tmp.pcm",
-                   MatchesRegex("test_audio_identifier_1_.*_.*\\.pcm")));
+              Call(TmpAudioFileName("identifier_1"),
+                   MatchesRegex("test_audio_identifier_1_.*_.*\\.wav")));
   EXPECT_CALL(mock_renamer,
-              Call("test_video_identifier_2_tmp_10x5.yuv",
-                   MatchesRegex("test_video_identifier_2_.*_.*_10x5\\.yuv")));
+              Call(TmpVideoFileName("identifier_2", "10x5.y4m"),
+                   MatchesRegex("test_video_identifier_2_.*_.*_10x5\\.y4m")));
   auto thread = rtc::Thread::Create();
   thread->Start();
   auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
@@ -177,6 +264,278 @@ TEST(MultiUserMediaCollectorTest, ClosingSegmentsRenamesFiles) {
   collector->OnAudioFrame(std::move(test_data1.frame));
   collector->OnVideoFrame(std::move(test_data2.meet_frame));
   collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+}
+
+TEST(MultiUserMediaCollectorTest, EncodedVideoSegmentsAreWrittenAsIvfFiles) {
+  VideoTestData test_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  test_data.meet_frame.contributing_source = 1;
+  auto mock_output_file = std::make_unique<MockOutputWriter>();
+  std::string written;
+  EXPECT_CALL(*mock_output_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written.append(content, size);
+      });
+  EXPECT_CALL(*mock_output_file, Close);
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpVideoFileName("identifier_1", "10x5.ivf")))
+      .WillOnce(Return(std::move(mock_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  MockFunction<void(absl::string_view, absl::string_view)> mock_renamer;
+  EXPECT_CALL(mock_renamer,
+              Call(TmpVideoFileName("identifier_1", "10x5.ivf"),
+                   MatchesRegex("test_video_identifier_1_.*_.*_10x5\\.ivf")));
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      mock_renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  std::vector<std::unique_ptr<rtc::Thread>> encoder_threads;
+  encoder_threads.push_back(rtc::Thread::Create());
+  encoder_threads.back()->Start();
+  // Without an encoder, segments are only framed; encoding itself is covered
+  // by the encoder's tests.
+  collector->EnableVideoEncoding(std::make_unique<VideoSegmentEncoderPool>(
+      VideoEncodingConfiguration(), "VP80", []() { return nullptr; },
+      std::move(encoder_threads)));
+
+  collector->OnVideoFrame(std::move(test_data.meet_frame));
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  EXPECT_EQ(written.substr(0, 4), "DKIF");
+}
+
+TEST(MultiUserMediaCollectorTest, SetRawVideoOutputRejectsPartialResolution) {
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", MockFunction<std::unique_ptr<OutputWriterInterface>(
+                   absl::string_view)>()
+                   .AsStdFunction(),
+      MockFunction<void(absl::string_view, absl::string_view)>()
+          .AsStdFunction(),
+      absl::Seconds(1), std::make_unique<MockResourceManager>(),
+      rtc::Thread::Create());
+
+  EXPECT_EQ(collector
+                ->SetRawVideoOutput(VideoPixelFormat::kRgb24, /*width=*/4,
+                                    /*height=*/0)
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(MultiUserMediaCollectorTest, ConvertedVideoSegmentsAreWrittenWithoutY4m) {
+  VideoTestData test_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  test_data.meet_frame.contributing_source = 1;
+  auto mock_output_file = std::make_unique<MockOutputWriter>();
+  std::string written;
+  EXPECT_CALL(*mock_output_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written.append(content, size);
+      });
+  EXPECT_CALL(*mock_output_file, Close);
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpVideoFileName("identifier_1", "4x2.rgb")))
+      .WillOnce(Return(std::move(mock_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  MockFunction<void(absl::string_view, absl::string_view)> mock_renamer;
+  EXPECT_CALL(mock_renamer,
+              Call(TmpVideoFileName("identifier_1", "4x2.rgb"),
+                   MatchesRegex("test_video_identifier_1_.*_.*_4x2\\.rgb")));
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      mock_renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  ASSERT_EQ(collector->SetRawVideoOutput(VideoPixelFormat::kRgb24,
+                                         /*width=*/4, /*height=*/2),
+            absl::OkStatus());
+
+  collector->OnVideoFrame(std::move(test_data.meet_frame));
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  // A single frame of 4x2 RGB pixels, without a header or frame marker.
+  EXPECT_EQ(written.size(), 4 * 2 * 3);
+}
+
+TEST(MultiUserMediaCollectorTest, SilenceDoesNotStartAudioSegments) {
+  // Samples 0 to 9 are far below the default silence threshold.
+  AudioTestData test_data = CreateAudioTestData(/*num_samples=*/10);
+  test_data.frame.contributing_source = 1;
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider, Call).Times(0);
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier).Times(0);
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  collector->EnableSilenceSkipping();
+
+  collector->OnAudioFrame(std::move(test_data.frame));
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+}
+
+TEST(MultiUserMediaCollectorTest, SilenceAfterSpeechIsWrittenWithinGap) {
+  std::vector<int16_t> speech(10, 10000);
+  AudioTestData silence = CreateAudioTestData(/*num_samples=*/10);
+  silence.frame.contributing_source = 1;
+
+  auto mock_output_file = std::make_unique<MockOutputWriter>();
+  std::vector<int16_t> written_pcm16;
+  EXPECT_CALL(*mock_output_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        const int16_t* samples = reinterpret_cast<const int16_t*>(content);
+        written_pcm16.insert(written_pcm16.end(), samples,
+                             samples + size / sizeof(int16_t));
+      });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
+  EXPECT_CALL(*mock_output_file, Close);
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpAudioFileName("identifier_1")))
+      .WillOnce(Return(std::move(mock_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  collector->EnableSilenceSkipping();
+
+  collector->OnAudioFrame(
+      meet::AudioFrame{.pcm16 = speech, .contributing_source = 1});
+  collector->OnAudioFrame(std::move(silence.frame));
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  std::vector<int16_t> expected_pcm16 = speech;
+  expected_pcm16.insert(expected_pcm16.end(), silence.pcm16.begin(),
+                        silence.pcm16.end());
+  EXPECT_EQ(written_pcm16, expected_pcm16);
+}
+
+TEST(MultiUserMediaCollectorTest, EnableAudioConversionRejectsInvalidRate) {
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", MockFunction<std::unique_ptr<OutputWriterInterface>(
+                   absl::string_view)>()
+                   .AsStdFunction(),
+      MockFunction<void(absl::string_view, absl::string_view)>()
+          .AsStdFunction(),
+      absl::Seconds(1), std::make_unique<MockResourceManager>(),
+      rtc::Thread::Create());
+
+  EXPECT_EQ(collector->EnableAudioConversion({.sample_rate = 22050}).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(MultiUserMediaCollectorTest, ConvertsAudioBeforeWriting) {
+  std::vector<int16_t> stereo = {100, 200, -100, -300};
+
+  auto mock_output_file = std::make_unique<MockOutputWriter>();
+  std::string written;
+  EXPECT_CALL(*mock_output_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written.append(content, size);
+      });
+  EXPECT_CALL(*mock_output_file, Close);
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpAudioFileName("identifier_1")))
+      .WillOnce(Return(std::move(mock_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  ASSERT_EQ(collector->EnableAudioConversion(
+                {.sample_rate = 0, .downmix_to_mono = true}),
+            absl::OkStatus());
+
+  collector->OnAudioFrame(meet::AudioFrame{.pcm16 = stereo,
+                                           .sample_rate = 48000,
+                                           .number_of_channels = 2,
+                                           .contributing_source = 1});
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  ASSERT_EQ(written.size(), kWavFileHeaderSize + 2 * sizeof(int16_t));
+  // The header describes the downmixed audio.
+  EXPECT_EQ(written[22], 1);
+  const int16_t* samples =
+      reinterpret_cast<const int16_t*>(written.data() + kWavFileHeaderSize);
+  EXPECT_EQ(samples[0], 150);
+  EXPECT_EQ(samples[1], -200);
+}
+
+TEST(MultiUserMediaCollectorTest, ResamplesAggregatedAudioFrames) {
+  // A 40 ms frame, as delivered with a 40 ms audio aggregation window.
+  std::vector<int16_t> mono(4 * 480, 1000);
+
+  auto mock_output_file = std::make_unique<MockOutputWriter>();
+  std::string written;
+  EXPECT_CALL(*mock_output_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written.append(content, size);
+      });
+  EXPECT_CALL(*mock_output_file, Close);
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpAudioFileName("identifier_1")))
+      .WillOnce(Return(std::move(mock_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  ASSERT_EQ(collector->EnableAudioConversion(
+                {.sample_rate = 16000, .downmix_to_mono = true}),
+            absl::OkStatus());
+
+  collector->OnAudioFrame(meet::AudioFrame{.pcm16 = mono,
+                                           .sample_rate = 48000,
+                                           .number_of_channels = 1,
+                                           .contributing_source = 1});
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  EXPECT_EQ(written.size(), kWavFileHeaderSize + 4 * 160 * sizeof(int16_t));
 }
 
 TEST(MultiUserMediaCollectorTest, ReceivesAudioFrameAndWritesToFile) {
@@ -189,16 +548,22 @@ TEST(MultiUserMediaCollectorTest, ReceivesAudioFrameAndWritesToFile) {
   absl::Notification write_notification;
   EXPECT_CALL(*mock_output_file, Write(_, _))
       .WillRepeatedly([&](const char* content, std::streamsize size) {
-        EXPECT_EQ(size, sizeof(int16_t));
-        written_pcm16.push_back(reinterpret_cast<const int16_t*>(content)[0]);
+        // Each frame is written in a single call.
+        EXPECT_EQ(size, pcm16.size() * sizeof(int16_t));
+        const int16_t* samples = reinterpret_cast<const int16_t*>(content);
+        written_pcm16.insert(written_pcm16.end(), samples,
+                             samples + size / sizeof(int16_t));
         if (written_pcm16.size() == pcm16.size()) {
           write_notification.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_audio_identifier_1_tmp.pcm"))
+              Call(TmpAudioFileName("identifier_1")))
       .WillOnce(Return(std::move(mock_output_file)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -230,17 +595,19 @@ TEST(MultiUserMediaCollectorTest,
   absl::Notification write_notification;
   EXPECT_CALL(*mock_output_file, Write(_, _))
       .WillRepeatedly([&](const char* content, std::streamsize size) {
-        EXPECT_EQ(size, sizeof(int16_t));
-        written_pcm16_count++;
+        written_pcm16_count += size / sizeof(int16_t);
         if (written_pcm16_count ==
             test_data1.pcm16.size() + test_data2.pcm16.size()) {
           write_notification.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_audio_identifier_1_tmp.pcm"))
+              Call(TmpAudioFileName("identifier_1")))
       .WillOnce(Return(std::move(mock_output_file)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -270,12 +637,14 @@ TEST(MultiUserMediaCollectorTest,
   absl::Notification write_notification1;
   EXPECT_CALL(*mock_output_file1, Write(_, _))
       .WillRepeatedly([&](const char* content, std::streamsize size) {
-        EXPECT_EQ(size, sizeof(int16_t));
-        written_pcm16_count1++;
+        written_pcm16_count1 += size / sizeof(int16_t);
         if (written_pcm16_count1 == test_data1.pcm16.size()) {
           write_notification1.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file1, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   // Output file 2.
   AudioTestData test_data2 = CreateAudioTestData(/*num_samples=*/20);
@@ -285,20 +654,22 @@ TEST(MultiUserMediaCollectorTest,
   absl::Notification write_notification2;
   EXPECT_CALL(*mock_output_file2, Write(_, _))
       .WillRepeatedly([&](const char* content, std::streamsize size) {
-        EXPECT_EQ(size, sizeof(int16_t));
-        written_pcm16_count2++;
+        written_pcm16_count2 += size / sizeof(int16_t);
         if (written_pcm16_count2 == test_data2.pcm16.size()) {
           write_notification2.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file2, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_audio_identifier_1_tmp.pcm"))
+              Call(TmpAudioFileName("identifier_1")))
       .WillOnce(Return(std::move(mock_output_file1)));
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_audio_identifier_2_tmp.pcm"))
+              Call(TmpAudioFileName("identifier_2")))
       .WillOnce(Return(std::move(mock_output_file2)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -332,12 +703,14 @@ TEST(MultiUserMediaCollectorTest,
   absl::Notification write_notification1;
   EXPECT_CALL(*mock_output_file1, Write(_, _))
       .WillRepeatedly([&](const char* content, std::streamsize size) {
-        EXPECT_EQ(size, sizeof(int16_t));
-        written_pcm16_count1++;
+        written_pcm16_count1 += size / sizeof(int16_t);
         if (written_pcm16_count1 == test_data1.pcm16.size()) {
           write_notification1.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file1, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
   // Expect that the first output file is closed when the second frame is
   // received.
   EXPECT_CALL(*mock_output_file1, Close);
@@ -351,18 +724,20 @@ TEST(MultiUserMediaCollectorTest,
   absl::Notification write_notification2;
   EXPECT_CALL(*mock_output_file2, Write(_, _))
       .WillRepeatedly([&](const char* content, std::streamsize size) {
-        EXPECT_EQ(size, sizeof(int16_t));
-        written_pcm16_count2++;
+        written_pcm16_count2 += size / sizeof(int16_t);
         if (written_pcm16_count2 == test_data2.pcm16.size()) {
           write_notification2.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file2, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   int file_count = 0;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_audio_identifier_1_tmp.pcm"))
+              Call(TmpAudioFileName("identifier_1")))
       .Times(2)
       .WillRepeatedly([&] {
         file_count++;
@@ -394,6 +769,59 @@ TEST(MultiUserMediaCollectorTest,
       write_notification2.WaitForNotificationWithTimeout(absl::Seconds(1)));
 }
 
+TEST(MultiUserMediaCollectorTest, UsesFrameReceiveTimesForSegmentGaps) {
+  AudioTestData test_data1 = CreateAudioTestData(/*num_samples=*/10);
+  test_data1.frame.contributing_source = 1;
+  AudioTestData test_data2 = CreateAudioTestData(/*num_samples=*/20);
+  test_data2.frame.contributing_source = 1;
+  // The frames are delivered back to back, but were received further apart
+  // than the segment gap.
+  absl::Time now = absl::Now();
+  test_data1.frame.receive_time = now - absl::Seconds(5);
+  test_data2.frame.receive_time = now;
+  auto mock_output_file1 = std::make_unique<NiceMock<MockOutputWriter>>();
+  EXPECT_CALL(*mock_output_file1, Close);
+  auto mock_output_file2 = std::make_unique<NiceMock<MockOutputWriter>>();
+  absl::Notification second_segment_notification;
+  EXPECT_CALL(*mock_output_file2, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        if (!second_segment_notification.HasBeenNotified()) {
+          second_segment_notification.Notify();
+        }
+      });
+
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  int file_count = 0;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpAudioFileName("identifier_1")))
+      .Times(2)
+      .WillRepeatedly([&]() -> std::unique_ptr<OutputWriterInterface> {
+        file_count++;
+        if (file_count == 1) {
+          return std::move(mock_output_file1);
+        } else {
+          return std::move(mock_output_file2);
+        }
+      });
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillRepeatedly(Return("identifier_1"));
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+
+  collector->OnAudioFrame(std::move(test_data1.frame));
+  collector->OnAudioFrame(std::move(test_data2.frame));
+
+  EXPECT_TRUE(second_segment_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
+}
+
 TEST(MultiUserMediaCollectorTest, StartingNewAudioSegmentReleasesOldSegment) {
   AudioTestData test_data1 = CreateAudioTestData(/*num_samples=*/10);
   test_data1.frame.contributing_source = 1;
@@ -416,7 +844,7 @@ TEST(MultiUserMediaCollectorTest, StartingNewAudioSegmentReleasesOldSegment) {
       mock_output_file_provider;
   int file_count = 0;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_audio_identifier_1_tmp.pcm"))
+              Call(TmpAudioFileName("identifier_1")))
       .Times(2)
       .WillRepeatedly([&] {
         file_count++;
@@ -500,10 +928,13 @@ TEST(MultiUserMediaCollectorTest, ReceivesVideoFrameAndWritesToFile) {
           write_notification.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_1_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_1", "10x5.y4m")))
       .WillOnce(Return(std::move(mock_output_file)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -523,6 +954,50 @@ TEST(MultiUserMediaCollectorTest, ReceivesVideoFrameAndWritesToFile) {
   EXPECT_EQ(written_yuv_data, yuv_data);
 }
 
+TEST(MultiUserMediaCollectorTest, SkipsRepeatedVideoFramesWhenEnabled) {
+  VideoTestData test_data1 = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  test_data1.meet_frame.contributing_source = 1;
+  VideoTestData test_data2 = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  test_data2.meet_frame.contributing_source = 1;
+  std::vector<char> yuv_data = std::move(test_data1.yuv_data);
+
+  auto mock_output_file = std::make_unique<MockOutputWriter>();
+  std::vector<char> written_yuv_data;
+  EXPECT_CALL(*mock_output_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written_yuv_data.insert(written_yuv_data.end(), content,
+                                content + size);
+      });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(2);
+  EXPECT_CALL(*mock_output_file, Close);
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpVideoFileName("identifier_1", "10x5.y4m")))
+      .WillOnce(Return(std::move(mock_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  collector->EnableRepeatedVideoFrameSkipping();
+
+  collector->OnVideoFrame(std::move(test_data1.meet_frame));
+  collector->OnVideoFrame(std::move(test_data2.meet_frame));
+  collector->OnDisconnected(absl::OkStatus());
+
+  // Only the file header and the first frame's marker and planes are written.
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  EXPECT_EQ(written_yuv_data, yuv_data);
+}
+
 TEST(MultiUserMediaCollectorTest,
      ReceivingVideoFramesWithSameSourceAndSizeCreatesOneFile) {
   VideoTestData test_data1 = CreateVideoTestData(/*width=*/10, /*height=*/5);
@@ -541,10 +1016,13 @@ TEST(MultiUserMediaCollectorTest,
           write_notification.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_1_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_1", "10x5.y4m")))
       .WillOnce(Return(std::move(mock_output_file)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -579,6 +1057,9 @@ TEST(MultiUserMediaCollectorTest,
           write_notification1.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file1, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   // Output file 2.
   VideoTestData test_data2 = CreateVideoTestData(/*width=*/10, /*height=*/5);
@@ -593,14 +1074,17 @@ TEST(MultiUserMediaCollectorTest,
           write_notification2.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file2, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_1_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_1", "10x5.y4m")))
       .WillOnce(Return(std::move(mock_output_file1)));
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_2_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_2", "10x5.y4m")))
       .WillOnce(Return(std::move(mock_output_file2)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -639,6 +1123,9 @@ TEST(MultiUserMediaCollectorTest,
           write_notification1.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file1, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   // Output file 2, only change the width.
   VideoTestData test_data2 = CreateVideoTestData(/*width=*/20, /*height=*/5);
@@ -653,6 +1140,9 @@ TEST(MultiUserMediaCollectorTest,
           write_notification2.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file2, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   // Output file 3, only change the height.
   VideoTestData test_data3 = CreateVideoTestData(/*width=*/20, /*height=*/20);
@@ -667,17 +1157,20 @@ TEST(MultiUserMediaCollectorTest,
           write_notification3.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file3, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_1_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_1", "10x5.y4m")))
       .WillOnce(Return(std::move(mock_output_file1)));
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_1_tmp_20x5.yuv"))
+              Call(TmpVideoFileName("identifier_1", "20x5.y4m")))
       .WillOnce(Return(std::move(mock_output_file2)));
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_1_tmp_20x20.yuv"))
+              Call(TmpVideoFileName("identifier_1", "20x20.y4m")))
       .WillOnce(Return(std::move(mock_output_file3)));
   auto mock_resource_manager = std::make_unique<MockResourceManager>();
   EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
@@ -718,6 +1211,9 @@ TEST(MultiUserMediaCollectorTest,
           write_notification1.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file1, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
   // Expect that the first output file is closed when the second frame is
   // received.
   EXPECT_CALL(*mock_output_file1, Close);
@@ -736,12 +1232,15 @@ TEST(MultiUserMediaCollectorTest,
           write_notification2.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file2, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   int file_count = 0;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_1_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_1", "10x5.y4m")))
       .Times(2)
       .WillRepeatedly([&] {
         file_count++;
@@ -794,7 +1293,7 @@ TEST(MultiUserMediaCollectorTest, StartingNewVideoSegmentReleasesOldSegment) {
       mock_output_file_provider;
   int file_count = 0;
   EXPECT_CALL(mock_output_file_provider,
-              Call("test_video_identifier_1_tmp_10x5.yuv"))
+              Call(TmpVideoFileName("identifier_1", "10x5.y4m")))
       .Times(2)
       .WillRepeatedly([&] {
         file_count++;
@@ -861,5 +1360,426 @@ TEST(MultiUserMediaCollectorTest,
       log_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
 }
 
+TEST(MultiUserMediaCollectorTest, ReopensParkedSegmentFilesOnceLimitIsReached) {
+  std::vector<std::string> opened_files;
+  absl::Notification second_file_opened;
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(2))
+      .WillOnce(Return("identifier_2"));
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_",
+      [&](absl::string_view file_name)
+          -> std::unique_ptr<OutputWriterInterface> {
+        opened_files.push_back(std::string(file_name));
+        if (opened_files.size() == 2) {
+          second_file_opened.Notify();
+        }
+        return std::make_unique<NiceMock<MockOutputWriter>>();
+      },
+      [](absl::string_view, absl::string_view) {}, absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  collector->SetMaxOpenSegmentFiles(1);
+  auto send_audio_frame = [&](uint32_t contributing_source) {
+    AudioTestData test_data = CreateAudioTestData(/*num_samples=*/10);
+    test_data.frame.contributing_source = contributing_source;
+    collector->OnAudioFrame(std::move(test_data.frame));
+  };
+
+  send_audio_frame(1);
+  send_audio_frame(2);
+  // Frames of the same source that are queued together are written together,
+  // so wait for the second segment before writing to the first again.
+  ASSERT_TRUE(
+      second_file_opened.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  send_audio_frame(1);
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  // The first segment is parked when the second starts, and reopened for its
+  // next frame.
+  EXPECT_THAT(opened_files, ElementsAre(TmpAudioFileName("identifier_1"),
+                                        TmpAudioFileName("identifier_2"),
+                                        TmpAudioFileName("identifier_1")));
+  EXPECT_EQ(opened_files[2], opened_files[0]);
+}
+
+TEST(MultiUserMediaCollectorTest, DropsOldestVideoFramesWhenQueueIsFull) {
+  auto mock_output_file = std::make_unique<NiceMock<MockOutputWriter>>();
+  EXPECT_CALL(*mock_output_file, Close);
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpVideoFileName("identifier_1", "10x5.y4m")))
+      .WillOnce(Return(std::move(mock_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  rtc::Thread* collector_thread = thread.get();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  collector->SetFrameQueueOptions(
+      kDefaultAudioFrameQueueOptions,
+      {.policy = FrameQueuePolicy::kDropOldest, .max_frames_per_source = 1});
+  // Stall the collector thread so that frames stay queued.
+  absl::Notification release;
+  collector_thread->PostTask([&release] { release.WaitForNotification(); });
+
+  for (int i = 0; i < 3; ++i) {
+    VideoTestData test_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+    test_data.meet_frame.contributing_source = 1;
+    collector->OnVideoFrame(std::move(test_data.meet_frame));
+  }
+  FrameQueueStats stats = collector->GetVideoQueueStats();
+  release.Notify();
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  EXPECT_EQ(stats.enqueued_frames, 3);
+  EXPECT_EQ(stats.dropped_frames, 2);
+  EXPECT_EQ(stats.queued_frames, 1);
+  EXPECT_EQ(collector->GetVideoQueueStats().queued_frames, 0);
+}
+
+TEST(MultiUserMediaCollectorTest, DropsVideoFramesWhileOverMemoryBudget) {
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpAudioFileName("identifier_1")))
+      .WillOnce(Return(std::make_unique<NiceMock<MockOutputWriter>>()));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  rtc::Thread* collector_thread = thread.get();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  collector->SetMemoryBudget(1);
+  // Stall the collector thread so that frames stay queued.
+  absl::Notification release;
+  collector_thread->PostTask([&release] { release.WaitForNotification(); });
+
+  AudioTestData audio_data = CreateAudioTestData(/*num_samples=*/10);
+  audio_data.frame.contributing_source = 1;
+  collector->OnAudioFrame(std::move(audio_data.frame));
+  VideoTestData video_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  video_data.meet_frame.contributing_source = 2;
+  collector->OnVideoFrame(std::move(video_data.meet_frame));
+  MemoryUsage queued_usage = collector->GetMemoryUsage();
+  bool over_budget = collector->IsOverMemoryBudget();
+  release.Notify();
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  EXPECT_TRUE(over_budget);
+  EXPECT_EQ(queued_usage.queued_audio_bytes, 10 * sizeof(int16_t));
+  EXPECT_EQ(queued_usage.queued_video_bytes, 0);
+  EXPECT_EQ(collector->GetMemoryBudgetDroppedVideoFrames(), 1);
+  EXPECT_EQ(collector->GetMemoryUsage().total_bytes(), 0);
+}
+
+TEST(MultiUserMediaCollectorTest, KeepsVideoFramesWhileSegmentsAreOverBudget) {
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider, Call)
+      .WillRepeatedly([](absl::string_view) {
+        return std::make_unique<NiceMock<MockOutputWriter>>();
+      });
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(2))
+      .WillOnce(Return("identifier_2"));
+  auto renamer = NiceMock<MockFunction<void(absl::string_view,
+                                            absl::string_view)>>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  rtc::Thread* collector_thread = thread.get();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  collector->SetMemoryBudget(1);
+  AudioTestData audio_data = CreateAudioTestData(/*num_samples=*/10);
+  audio_data.frame.contributing_source = 1;
+  collector->OnAudioFrame(std::move(audio_data.frame));
+  collector_thread->BlockingCall([] {});
+  ASSERT_GT(collector->GetMemoryUsage().open_segment_bytes, 1);
+  ASSERT_TRUE(collector->IsOverMemoryBudget());
+
+  VideoTestData video_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  video_data.meet_frame.contributing_source = 2;
+  collector->OnVideoFrame(std::move(video_data.meet_frame));
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  EXPECT_EQ(collector->GetMemoryBudgetDroppedVideoFrames(), 0);
+}
+
+TEST(MultiUserMediaCollectorTest, RequestsVideoAssignmentsForMediaEntries) {
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  rtc::Thread* collector_thread = thread.get();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", [](absl::string_view) { return nullptr; },
+      [](absl::string_view, absl::string_view) {}, absl::Seconds(1),
+      std::make_unique<NiceMock<MockResourceManager>>(), std::move(thread));
+  std::vector<meet::VideoAssignmentChannelFromClient> requests;
+  collector->SetVideoAssignmentPolicy(
+      meet::VideoAssignmentPolicyConfiguration(),
+      [&](meet::VideoAssignmentChannelFromClient request) {
+        EXPECT_TRUE(collector_thread->IsCurrent());
+        requests.push_back(std::move(request));
+      });
+  meet::MediaEntriesChannelToClient update;
+  update.resources.push_back(
+      {.id = 1, .media_entry = meet::MediaEntry{.video_csrcs = {111}}});
+
+  collector->OnResourceUpdate(update);
+  // The same entries keep the current assignment.
+  collector->OnResourceUpdate(update);
+  update.resources.push_back(
+      {.id = 2, .media_entry = meet::MediaEntry{.video_csrcs = {222}}});
+  collector->OnResourceUpdate(update);
+  collector_thread->BlockingCall([] {});
+
+  ASSERT_THAT(requests, SizeIs(2));
+  EXPECT_EQ(requests[0].request.request_id, 1);
+  ASSERT_TRUE(requests[0].request.set_video_assignment_request.has_value());
+  EXPECT_THAT(
+      requests[0].request.set_video_assignment_request->layout_model.canvases,
+      SizeIs(1));
+  EXPECT_EQ(requests[1].request.request_id, 2);
+  ASSERT_TRUE(requests[1].request.set_video_assignment_request.has_value());
+  EXPECT_THAT(
+      requests[1].request.set_video_assignment_request->layout_model.canvases,
+      SizeIs(2));
+}
+
+TEST(MultiUserMediaCollectorTest, CloseIdleSegmentsClosesSegmentsPastGap) {
+  auto mock_output_file = std::make_unique<NiceMock<MockOutputWriter>>();
+  absl::Notification close_notification;
+  EXPECT_CALL(*mock_output_file, Close).WillOnce([&] {
+    close_notification.Notify();
+  });
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider,
+              Call(TmpAudioFileName("identifier_1")))
+      .WillOnce(Return(std::move(mock_output_file)));
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  auto renamer = MockFunction<void(absl::string_view, absl::string_view)>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  AudioTestData test_data = CreateAudioTestData(/*num_samples=*/10);
+  test_data.frame.contributing_source = 1;
+  test_data.frame.receive_time = absl::Now() - absl::Seconds(5);
+  collector->OnAudioFrame(std::move(test_data.frame));
+
+  collector->CloseIdleSegments();
+
+  EXPECT_TRUE(
+      close_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  // The segment was already closed, so disconnecting does not close it again.
+  collector->OnDisconnected(absl::OkStatus());
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  EXPECT_EQ(collector->GetMemoryUsage().open_segment_bytes, 0);
+}
+
+TEST(MultiUserMediaCollectorTest, CatalogsSegmentsBeforeNotifyingDisconnect) {
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider, Call)
+      .WillRepeatedly([](absl::string_view) {
+        return std::make_unique<NiceMock<MockOutputWriter>>();
+      });
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(2))
+      .WillOnce(Return("identifier_2"));
+  auto renamer = NiceMock<MockFunction<void(absl::string_view,
+                                            absl::string_view)>>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_", std::move(mock_output_file_provider).AsStdFunction(),
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  std::string catalog_contents;
+  auto catalog_output = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*catalog_output, Write)
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        catalog_contents.append(content, size);
+      });
+  EXPECT_CALL(*catalog_output, Close);
+  collector->SetSegmentCatalog(
+      std::make_unique<SegmentCatalogWriter>(std::move(catalog_output)));
+  absl::Time receive_time = absl::FromUnixSeconds(1'700'000'000);
+  AudioTestData audio_data = CreateAudioTestData(/*num_samples=*/10);
+  audio_data.frame.contributing_source = 1;
+  audio_data.frame.receive_time = receive_time;
+  VideoTestData video_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
+  video_data.meet_frame.contributing_source = 2;
+  video_data.meet_frame.receive_time = receive_time;
+
+  collector->OnAudioFrame(std::move(audio_data.frame));
+  collector->OnVideoFrame(std::move(video_data.meet_frame));
+  collector->OnDisconnected(absl::OkStatus());
+  ASSERT_EQ(collector->WaitForDisconnected(absl::Seconds(1)),
+            absl::OkStatus());
+
+  absl::StatusOr<SegmentCatalog> catalog =
+      SegmentCatalog::Parse(catalog_contents);
+  ASSERT_OK(catalog);
+  std::vector<const SegmentCatalogEntry*> audio_segments = catalog->Find(
+      "identifier_1", meet::MediaKind::kAudio, receive_time, receive_time);
+  ASSERT_EQ(audio_segments.size(), 1);
+  EXPECT_EQ(audio_segments[0]->first_frame_time, receive_time);
+  EXPECT_EQ(audio_segments[0]->file_name,
+            absl::StrFormat("test_audio_identifier_1_%s_%s.wav",
+                            absl::FormatTime(receive_time),
+                            absl::FormatTime(receive_time)));
+  std::vector<const SegmentCatalogEntry*> video_segments = catalog->Find(
+      "identifier_2", meet::MediaKind::kVideo, receive_time, receive_time);
+  ASSERT_EQ(video_segments.size(), 1);
+  EXPECT_EQ(video_segments[0]->width, 10);
+  EXPECT_EQ(video_segments[0]->height, 5);
+}
+
+// A writer whose `CloseAsync` completes once the test invokes the callback it
+// hands over.
+class DeferredCloseOutputWriter : public OutputWriterInterface {
+ public:
+  DeferredCloseOutputWriter(absl::AnyInvocable<void() &&>& on_closed,
+                            absl::Notification& closing)
+      : on_closed_(on_closed), closing_(closing) {}
+
+  void Write(const char* content, std::streamsize size) override {}
+  void Close() override {}
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed) override {
+    on_closed_ = std::move(on_closed);
+    closing_.Notify();
+  }
+
+ private:
+  absl::AnyInvocable<void() &&>& on_closed_;
+  absl::Notification& closing_;
+};
+
+TEST(MultiUserMediaCollectorTest, RenamesSegmentsOnceTheirWritersHaveClosed) {
+  absl::AnyInvocable<void() &&> on_closed;
+  absl::Notification closing;
+  std::vector<std::string> opened_files;
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillRepeatedly(Return("identifier_1"));
+  MockFunction<void(absl::string_view, absl::string_view)> mock_renamer;
+  EXPECT_CALL(mock_renamer, Call).Times(0);
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_",
+      [&](absl::string_view file_name)
+          -> std::unique_ptr<OutputWriterInterface> {
+        opened_files.push_back(std::string(file_name));
+        if (opened_files.size() == 1) {
+          return std::make_unique<DeferredCloseOutputWriter>(on_closed,
+                                                             closing);
+        }
+        return std::make_unique<NiceMock<MockOutputWriter>>();
+      },
+      mock_renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  absl::Time receive_time = absl::FromUnixSeconds(1'700'000'000);
+  auto send_audio_frame = [&](absl::Time receive_time) {
+    AudioTestData test_data = CreateAudioTestData(/*num_samples=*/10);
+    test_data.frame.contributing_source = 1;
+    test_data.frame.receive_time = receive_time;
+    collector->OnAudioFrame(std::move(test_data.frame));
+  };
+
+  // The second frame is past the gap, so it starts a new segment for the same
+  // source while the first is still closing.
+  send_audio_frame(receive_time);
+  send_audio_frame(receive_time + absl::Seconds(2));
+  ASSERT_TRUE(closing.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_CALL(mock_renamer, Call(TmpAudioFileName("identifier_1"), _))
+      .Times(2);
+  std::move(on_closed)();
+  collector->OnDisconnected(absl::OkStatus());
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  EXPECT_THAT(opened_files, ElementsAre(TmpAudioFileName("identifier_1"),
+                                        TmpAudioFileName("identifier_1")));
+  EXPECT_NE(opened_files[0], opened_files[1]);
+}
+
+TEST(MultiUserMediaCollectorTest, CatalogsSegmentsOnceTheirWritersHaveClosed) {
+  absl::AnyInvocable<void() &&> on_closed;
+  absl::Notification closing;
+  auto mock_resource_manager = std::make_unique<MockResourceManager>();
+  EXPECT_CALL(*mock_resource_manager, GetOutputFileIdentifier(1))
+      .WillOnce(Return("identifier_1"));
+  auto renamer = NiceMock<MockFunction<void(absl::string_view,
+                                            absl::string_view)>>();
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<MultiUserMediaCollector>(
+      "test_",
+      [&](absl::string_view) -> std::unique_ptr<OutputWriterInterface> {
+        return std::make_unique<DeferredCloseOutputWriter>(on_closed, closing);
+      },
+      renamer.AsStdFunction(), absl::Seconds(1),
+      std::move(mock_resource_manager), std::move(thread));
+  std::string catalog_contents;
+  auto catalog_output = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*catalog_output, Write)
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        catalog_contents.append(content, size);
+      });
+  EXPECT_CALL(*catalog_output, Close);
+  collector->SetSegmentCatalog(
+      std::make_unique<SegmentCatalogWriter>(std::move(catalog_output)));
+  AudioTestData audio_data = CreateAudioTestData(/*num_samples=*/10);
+  audio_data.frame.contributing_source = 1;
+
+  collector->OnAudioFrame(std::move(audio_data.frame));
+  collector->OnDisconnected(absl::OkStatus());
+  ASSERT_TRUE(closing.WaitForNotificationWithTimeout(absl::Seconds(1)));
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Milliseconds(100)).code(),
+            absl::StatusCode::kDeadlineExceeded);
+  absl::StatusOr<SegmentCatalog> catalog =
+      SegmentCatalog::Parse(catalog_contents);
+  ASSERT_OK(catalog);
+  EXPECT_THAT(catalog->entries(), IsEmpty());
+
+  std::move(on_closed)();
+
+  EXPECT_EQ(collector->WaitForDisconnected(absl::Seconds(1)), absl::OkStatus());
+  catalog = SegmentCatalog::Parse(catalog_contents);
+  ASSERT_OK(catalog);
+  EXPECT_THAT(catalog->entries(), SizeIs(1));
+}
+
 }  // namespace
 }  // namespace media_api_samples
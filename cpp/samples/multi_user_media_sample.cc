@@ -15,10 +15,16 @@
  */
 
 
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
+#include <fstream>
+#include <ios>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
@@ -26,12 +32,23 @@
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/video_assignment_resource.h"
 #include "cpp/internal/media_api_client_factory.h"
+#include "cpp/internal/thread_watchdog.h"
+#include "cpp/internal/trace.h"
+#include "cpp/internal/trace_events.h"
+#include "cpp/internal/video_assignment_policy.h"
+#include "cpp/samples/buffered_output_writer.h"
+#include "cpp/samples/event_log.h"
+#include "cpp/samples/media_writing.h"
 #include "cpp/samples/multi_user_media_collector.h"
+#include "cpp/samples/output_file.h"
+#include "cpp/samples/session_trace.h"
+#include "cpp/samples/video_segment_encoder.h"
 #include "webrtc/api/make_ref_counted.h"
 #include "webrtc/rtc_base/thread.h"
 
@@ -66,6 +83,96 @@ ABSL_FLAG(absl::Duration, segment_gap_threshold, absl::Seconds(1),
           "larger gap will result in fewer, sparser segments. A smaller gap "
           "will result in more, denser segments.");
 
+ABSL_FLAG(int, collector_shard_count, 0,
+          "The number of threads that media segments are partitioned across by "
+          "contributing source. If 0, all segments are written on a single "
+          "collector thread.");
+
+ABSL_FLAG(std::string, video_codec, "",
+          "If set, video segments are encoded with this codec (VP8, VP9 or "
+          "AV1) and written as IVF files instead of raw Y4M files.");
+
+ABSL_FLAG(int, video_bitrate_kbps, 1000,
+          "The target bitrate of encoded video segments, if --video_codec is "
+          "set.");
+
+ABSL_FLAG(int, max_open_segment_files, 0,
+          "If set, at most this many raw segment files are kept open at once. "
+          "Idle segments are flushed and closed, and reopened when they are "
+          "next written to.");
+
+ABSL_FLAG(std::string, raw_video_format, "i420",
+          "The pixel format of raw video segments: i420 (Y4M files), nv12, "
+          "rgb24 or bgra. Formats other than i420 are written as headerless "
+          "frames, e.g. for vision models. Ignored if --video_codec is set.");
+
+ABSL_FLAG(int, raw_video_width, 0,
+          "If set with --raw_video_height, raw video frames are scaled to this "
+          "width before they are written.");
+
+ABSL_FLAG(int, raw_video_height, 0,
+          "If set with --raw_video_width, raw video frames are scaled to this "
+          "height before they are written.");
+
+ABSL_FLAG(bool, skip_repeated_video_frames, false,
+          "Whether to skip video frames that are the same as the previous "
+          "frame of their segment, such as the frames of static screen "
+          "shares. Raw video segments are played back at a constant rate, so "
+          "skipping frames shortens their static periods.");
+
+ABSL_FLAG(bool, skip_silent_audio, false,
+          "Whether to end audio segments once a participant has been silent "
+          "for --segment_gap_threshold, and to not start segments with "
+          "silence, even if their microphone keeps sending audio.");
+
+ABSL_FLAG(int, audio_sample_rate, 0,
+          "If set, audio is resampled to this rate in Hz (e.g. 16000 for "
+          "speech recognition) before it is written.");
+
+ABSL_FLAG(bool, downmix_audio, false,
+          "Whether to downmix multichannel audio to mono before it is "
+          "written.");
+
+ABSL_FLAG(std::string, event_log_format, "csv",
+          "The format of the event log: csv (event_log.csv) or columnar "
+          "(event_log.columnar, typed columns that analysis jobs can read "
+          "without parsing text).");
+
+ABSL_FLAG(bool, adaptive_video_assignment, false,
+          "Whether to request one video canvas per media entry that is "
+          "sending video, at a low resolution unless somebody is "
+          "screensharing, updated as media entries change, instead of a "
+          "fixed layout of three canvases.");
+
+ABSL_FLAG(bool, archival_latency, false,
+          "Whether to buffer received media for recording rather than low "
+          "latency, so that fewer late packets are concealed.");
+
+ABSL_FLAG(int, audio_aggregation_window_ms, 0,
+          "If set, received audio is delivered to the collector in frames of "
+          "this many milliseconds rather than every 10ms.");
+
+ABSL_FLAG(std::string, session_trace_file, "",
+          "If set, the session is recorded to this file, so that it can be "
+          "replayed offline with session_replay_sample. Traces include every "
+          "decoded frame and grow quickly.");
+
+ABSL_FLAG(std::string, trace_categories, "",
+          "Comma-separated trace categories to log, or \"all\". Traces "
+          "include full message payloads and may be verbose. Valid categories "
+          "are data_channel, resource_update, media_stats and http. The "
+          "pipeline category, which records every frame event, is not "
+          "included in \"all\" and is enabled by --trace_event_file instead.");
+
+ABSL_FLAG(std::string, trace_event_file, "",
+          "If set, enables the pipeline trace category and writes its events "
+          "to this file as a Chrome JSON trace when the sample exits, which "
+          "can be opened in Perfetto or chrome://tracing.");
+
+ABSL_FLAG(int, thread_stall_threshold_ms, 0,
+          "If set, the client and collector threads are watched, and tasks "
+          "that block one of them for this many milliseconds are logged.");
+
 namespace {
 
 meet::VideoAssignmentChannelFromClient CreateVideoAssignmentRequest() {
@@ -110,6 +217,16 @@ meet::VideoAssignmentChannelFromClient CreateVideoAssignmentRequest() {
 int main(int argc, char** argv) {
   absl::SetProgramUsageMessage(argv[0]);
   absl::ParseCommandLine(argc, argv);
+  absl::Status trace_status =
+      meet::SetEnabledTraceCategories(absl::GetFlag(FLAGS_trace_categories));
+  if (!trace_status.ok()) {
+    LOG(ERROR) << "Invalid trace categories: " << trace_status;
+    return EXIT_FAILURE;
+  }
+  std::string trace_event_file_name = absl::GetFlag(FLAGS_trace_event_file);
+  if (!trace_event_file_name.empty()) {
+    meet::SetTraceCategoryEnabled(meet::TraceCategory::kPipeline, true);
+  }
   std::string output_file_prefix = absl::GetFlag(FLAGS_output_file_prefix);
   if (output_file_prefix.empty()) {
     LOG(ERROR) << "Output directory is empty";
@@ -130,6 +247,14 @@ int main(int argc, char** argv) {
     LOG(ERROR) << "OAuth token is empty";
     return EXIT_FAILURE;
   }
+  std::optional<media_api_samples::EventLogFormat> event_log_format =
+      media_api_samples::ParseEventLogFormat(
+          absl::GetFlag(FLAGS_event_log_format));
+  if (!event_log_format.has_value()) {
+    LOG(ERROR) << "Unsupported event log format: "
+               << absl::GetFlag(FLAGS_event_log_format);
+    return EXIT_FAILURE;
+  }
 
   std::unique_ptr<rtc::Thread> collector_thread = rtc::Thread::Create();
   collector_thread->SetName("collector_thread", nullptr);
@@ -137,24 +262,161 @@ int main(int argc, char** argv) {
     LOG(ERROR) << "Failed to start collector thread";
     return EXIT_FAILURE;
   }
+  // Kept for the watchdog, since the collector takes ownership of the threads.
+  std::vector<rtc::Thread*> collector_threads = {collector_thread.get()};
 
+  std::vector<std::unique_ptr<rtc::Thread>> shard_threads;
+  for (int i = 0; i < absl::GetFlag(FLAGS_collector_shard_count); ++i) {
+    std::unique_ptr<rtc::Thread> shard_thread = rtc::Thread::Create();
+    shard_thread->SetName(absl::StrCat("collector_shard_thread_", i), nullptr);
+    if (!shard_thread->Start()) {
+      LOG(ERROR) << "Failed to start collector shard thread";
+      return EXIT_FAILURE;
+    }
+    collector_threads.push_back(shard_thread.get());
+    shard_threads.push_back(std::move(shard_thread));
+  }
+
+  // Set once the client has been created. Media entries, and so the policy's
+  // video assignments, only arrive after joining. Declared before the
+  // collector, whose thread may use it until the collector is destroyed.
+  std::atomic<meet::MediaApiClientInterface*> video_assignment_client =
+      nullptr;
   auto media_collector =
       webrtc::make_ref_counted<media_api_samples::MultiUserMediaCollector>(
           output_file_prefix, absl::GetFlag(FLAGS_segment_gap_threshold),
-          std::move(collector_thread));
+          std::move(collector_thread), std::move(shard_threads),
+          *event_log_format);
+  // Created after the collector, so that it stops watching the collector
+  // threads before they are stopped.
+  std::shared_ptr<meet::ThreadWatchdog> thread_watchdog;
+  if (int threshold_ms = absl::GetFlag(FLAGS_thread_stall_threshold_ms);
+      threshold_ms > 0) {
+    absl::StatusOr<std::unique_ptr<meet::ThreadWatchdog>> watchdog =
+        meet::ThreadWatchdog::Create(
+            {.heartbeat_interval = absl::Milliseconds(threshold_ms) / 2,
+             .stall_threshold = absl::Milliseconds(threshold_ms)});
+    if (!watchdog.ok()) {
+      LOG(ERROR) << "Failed to start thread watchdog: " << watchdog.status();
+      return EXIT_FAILURE;
+    }
+    thread_watchdog = *std::move(watchdog);
+    for (int i = 0; i < static_cast<int>(collector_threads.size()); ++i) {
+      thread_watchdog->Watch(collector_threads[i],
+                             i == 0 ? "collector_thread"
+                                    : "collector_shard_thread");
+    }
+  }
+  if (std::string video_codec = absl::GetFlag(FLAGS_video_codec);
+      !video_codec.empty()) {
+    absl::StatusOr<std::unique_ptr<media_api_samples::VideoSegmentEncoderPool>>
+        encoder_pool = media_api_samples::VideoSegmentEncoderPool::Create(
+            {.codec_name = std::move(video_codec),
+             .target_bitrate_kbps = absl::GetFlag(FLAGS_video_bitrate_kbps)});
+    if (!encoder_pool.ok()) {
+      LOG(ERROR) << "Failed to create video encoders: "
+                 << encoder_pool.status();
+      return EXIT_FAILURE;
+    }
+    media_collector->EnableVideoEncoding(*std::move(encoder_pool));
+  }
+  if (absl::GetFlag(FLAGS_max_open_segment_files) > 0) {
+    media_collector->SetMaxOpenSegmentFiles(
+        absl::GetFlag(FLAGS_max_open_segment_files));
+  }
+  std::optional<media_api_samples::VideoPixelFormat> raw_video_format =
+      media_api_samples::ParseVideoPixelFormat(
+          absl::GetFlag(FLAGS_raw_video_format));
+  if (!raw_video_format.has_value()) {
+    LOG(ERROR) << "Unsupported raw video format: "
+               << absl::GetFlag(FLAGS_raw_video_format);
+    return EXIT_FAILURE;
+  }
+  if (absl::Status status = media_collector->SetRawVideoOutput(
+          *raw_video_format, absl::GetFlag(FLAGS_raw_video_width),
+          absl::GetFlag(FLAGS_raw_video_height));
+      !status.ok()) {
+    LOG(ERROR) << "Invalid raw video output: " << status;
+    return EXIT_FAILURE;
+  }
+  if (absl::GetFlag(FLAGS_skip_repeated_video_frames)) {
+    media_collector->EnableRepeatedVideoFrameSkipping();
+  }
+  if (absl::GetFlag(FLAGS_skip_silent_audio)) {
+    media_collector->EnableSilenceSkipping();
+  }
+  if (absl::GetFlag(FLAGS_audio_sample_rate) > 0 ||
+      absl::GetFlag(FLAGS_downmix_audio)) {
+    if (absl::Status status = media_collector->EnableAudioConversion(
+            {.sample_rate = absl::GetFlag(FLAGS_audio_sample_rate),
+             .downmix_to_mono = absl::GetFlag(FLAGS_downmix_audio)});
+        !status.ok()) {
+      LOG(ERROR) << "Invalid audio conversion: " << status;
+      return EXIT_FAILURE;
+    }
+  }
   meet::MediaApiClientConfiguration config = {
       .receiving_video_stream_count = 3,
       .enable_audio_streams = true,
+      .latency_profile = absl::GetFlag(FLAGS_archival_latency)
+                             ? meet::LatencyProfile::kArchival
+                             : meet::LatencyProfile::kRealtime,
+      .audio_aggregation_window_ms = static_cast<uint32_t>(
+          absl::GetFlag(FLAGS_audio_aggregation_window_ms)),
   };
+  if (absl::GetFlag(FLAGS_adaptive_video_assignment)) {
+    meet::VideoAssignmentPolicyConfiguration policy_config;
+    policy_config.max_canvases = config.receiving_video_stream_count;
+    media_collector->SetVideoAssignmentPolicy(
+        std::move(policy_config),
+        [&video_assignment_client](
+            meet::VideoAssignmentChannelFromClient request) {
+          meet::MediaApiClientInterface* client =
+              video_assignment_client.load();
+          if (client == nullptr) {
+            return;
+          }
+          if (absl::Status status = client->SendRequest(request);
+              !status.ok()) {
+            LOG(ERROR) << "Failed to send video assignment request: "
+                       << status;
+          }
+        });
+  }
+  rtc::scoped_refptr<meet::MediaApiClientObserverInterface> observer =
+      media_collector;
+  std::shared_ptr<media_api_samples::SessionTraceWriter> trace_writer;
+  if (std::string trace_file_name = absl::GetFlag(FLAGS_session_trace_file);
+      !trace_file_name.empty()) {
+    std::ofstream trace_file(
+        trace_file_name, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!trace_file.is_open()) {
+      LOG(ERROR) << "Failed to open session trace file: " << trace_file_name;
+      return EXIT_FAILURE;
+    }
+    trace_writer = std::make_shared<media_api_samples::SessionTraceWriter>(
+        std::make_unique<media_api_samples::BufferedOutputWriter>(
+            std::make_unique<media_api_samples::OutputFile>(
+                std::move(trace_file))));
+    config.data_channel_message_recorder = trace_writer;
+    observer = webrtc::make_ref_counted<
+        media_api_samples::SessionRecordingObserver>(trace_writer,
+                                                     media_collector);
+  }
+  meet::MediaApiClientFactory client_factory;
+  if (thread_watchdog != nullptr) {
+    client_factory.SetThreadWatchdog(thread_watchdog);
+  }
   absl::StatusOr<std::unique_ptr<meet::MediaApiClientInterface>> client_status =
-      meet::MediaApiClientFactory().CreateMediaApiClient(std::move(config),
-                                                         media_collector);
+      client_factory.CreateMediaApiClient(std::move(config),
+                                          std::move(observer));
   if (!client_status.ok()) {
     LOG(ERROR) << "Failed to create MediaApiClient: " << client_status.status();
     return EXIT_FAILURE;
   }
   std::unique_ptr<meet::MediaApiClientInterface> client =
       *std::move(client_status);
+  video_assignment_client.store(client.get());
   LOG(INFO) << "Created MediaApiClient";
 
   if (absl::Status connect_status = client->ConnectActiveConference(
@@ -173,13 +435,15 @@ int main(int argc, char** argv) {
   }
   LOG(INFO) << "Joined conference";
 
-  if (absl::Status send_status =
-          client->SendRequest(CreateVideoAssignmentRequest());
-      !send_status.ok()) {
-    LOG(ERROR) << "Failed to send video assignment request: " << send_status;
-    return EXIT_FAILURE;
+  if (!absl::GetFlag(FLAGS_adaptive_video_assignment)) {
+    if (absl::Status send_status =
+            client->SendRequest(CreateVideoAssignmentRequest());
+        !send_status.ok()) {
+      LOG(ERROR) << "Failed to send video assignment request: " << send_status;
+      return EXIT_FAILURE;
+    }
+    LOG(INFO) << "Sent video assignment request";
   }
-  LOG(INFO) << "Sent video assignment request";
 
   // Collect media for the specified duration.
   absl::SleepFor(absl::GetFlag(FLAGS_collection_duration));
@@ -200,5 +464,20 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
   LOG(INFO) << "Disconnected from conference";
+  video_assignment_client.store(nullptr);
+  if (trace_writer != nullptr) {
+    trace_writer->Close();
+  }
+  if (!trace_event_file_name.empty()) {
+    std::ofstream trace_event_file(
+        trace_event_file_name,
+        std::ios::binary | std::ios::out | std::ios::trunc);
+    trace_event_file << meet::TakeRecordedTraceEvents();
+    if (!trace_event_file.good()) {
+      LOG(ERROR) << "Failed to write trace events to: "
+                 << trace_event_file_name;
+      return EXIT_FAILURE;
+    }
+  }
   return EXIT_SUCCESS;
 }
@@ -18,12 +18,21 @@
 
 #include <ios>
 
+#include "cpp/internal/trace_events.h"
+
 namespace media_api_samples {
 
 void OutputFile::Write(const char* content, std::streamsize size) {
+  MEET_TRACE_EVENT("OutputFile::Write");
   file_.write(content, size);
+  if (flush_writes_) {
+    file_.flush();
+  }
 }
 
-void OutputFile::Close() { file_.close(); }
+void OutputFile::Close() {
+  MEET_TRACE_EVENT("OutputFile::Close");
+  file_.close();
+}
 
 }  // namespace media_api_samples
@@ -28,12 +28,20 @@ namespace media_api_samples {
 // An output writer that writes to a local file.
 class OutputFile : public OutputWriterInterface {
  public:
-  explicit OutputFile(std::ofstream file) : file_(std::move(file)) {}
+  // If `flush_writes` is true, each write is flushed to the file before
+  // returning, so that a reader never sees a partial write unless the process
+  // stops while writing it.
+  explicit OutputFile(std::ofstream file, bool flush_writes = false)
+      : file_(std::move(file)), flush_writes_(flush_writes) {}
   void Write(const char* content, std::streamsize size) override;
   void Close() override;
 
+  // Returns false once a write, flush or close of the file has failed.
+  bool ok() const { return !file_.fail(); }
+
  private:
   std::ofstream file_;
+  bool flush_writes_;
 };
 
 }  // namespace media_api_samples
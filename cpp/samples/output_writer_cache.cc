@@ -0,0 +1,249 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/output_writer_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <ios>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/log/log.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+namespace {
+
+// Tracks the close of a parked writer, which may finish on any thread.
+struct ParkedClose {
+  absl::Mutex mutex;
+  bool closed ABSL_GUARDED_BY(mutex) = false;
+  // Set if the cached writer is closed before its parked writer has finished
+  // closing.
+  absl::AnyInvocable<void() &&> on_closed ABSL_GUARDED_BY(mutex);
+
+  bool IsClosed() {
+    absl::MutexLock lock(&mutex);
+    return closed;
+  }
+};
+
+// Reopens `file_name` to append `pending_writes`, then closes it.
+void AppendAndCloseAsync(OutputWriterProvider& reopen_provider,
+                         absl::string_view file_name,
+                         const std::string& pending_writes,
+                         absl::AnyInvocable<void() &&> on_closed) {
+  std::unique_ptr<OutputWriterInterface> writer = reopen_provider(file_name);
+  writer->Write(pending_writes.data(), pending_writes.size());
+  writer->CloseAsync(std::move(on_closed));
+}
+
+}  // namespace
+
+class OutputWriterCache::CachedWriter : public OutputWriterInterface {
+ public:
+  CachedWriter(OutputWriterCache& cache, absl::string_view file_name,
+               std::unique_ptr<OutputWriterInterface> writer)
+      : cache_(cache), file_name_(file_name), writer_(std::move(writer)) {
+    cache_.MarkOpen(*this);
+  }
+
+  ~CachedWriter() override {
+    if (!pending_writes_.empty()) {
+      Close();
+    }
+    cache_.MarkClosed(*this);
+  }
+
+  void Write(const char* content, std::streamsize size) override {
+    if (!EnsureOpen()) {
+      pending_writes_.append(content, size);
+      return;
+    }
+    writer_->Write(content, size);
+  }
+
+  void WriteVectored(absl::Span<const Chunk> chunks) override {
+    if (!EnsureOpen()) {
+      for (const Chunk& chunk : chunks) {
+        pending_writes_.append(chunk.content, chunk.size);
+      }
+      return;
+    }
+    writer_->WriteVectored(chunks);
+  }
+
+  void Close() override {
+    cache_.MarkClosed(*this);
+    if (writer_ != nullptr) {
+      writer_->Close();
+      writer_.reset();
+      return;
+    }
+    if (parked_close_ == nullptr) {
+      return;
+    }
+    {
+      absl::MutexLock lock(&parked_close_->mutex);
+      parked_close_->mutex.Await(absl::Condition(&parked_close_->closed));
+    }
+    if (!pending_writes_.empty()) {
+      std::unique_ptr<OutputWriterInterface> writer =
+          (*cache_.reopen_provider_)(file_name_);
+      ++cache_.reopen_count_;
+      writer->Write(pending_writes_.data(), pending_writes_.size());
+      writer->Close();
+      pending_writes_.clear();
+    }
+  }
+
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed) override {
+    cache_.MarkClosed(*this);
+    if (writer_ != nullptr) {
+      writer_->CloseAsync(std::move(on_closed));
+      writer_.reset();
+      return;
+    }
+    if (parked_close_ == nullptr) {
+      std::move(on_closed)();
+      return;
+    }
+    if (!pending_writes_.empty()) {
+      // The writes buffered while the parked writer was closing are appended
+      // once it has closed, by whichever thread finishes closing it, so the
+      // provider is copied in case the cache is destroyed first.
+      ++cache_.reopen_count_;
+      on_closed = [reopen_provider = cache_.reopen_provider_,
+                   file_name = file_name_,
+                   pending_writes = std::move(pending_writes_),
+                   on_closed = std::move(on_closed)]() mutable {
+        AppendAndCloseAsync(*reopen_provider, file_name, pending_writes,
+                            std::move(on_closed));
+      };
+      pending_writes_.clear();
+    }
+    {
+      absl::MutexLock lock(&parked_close_->mutex);
+      if (!parked_close_->closed) {
+        parked_close_->on_closed = std::move(on_closed);
+        return;
+      }
+    }
+    std::move(on_closed)();
+  }
+
+ private:
+  friend class OutputWriterCache;
+
+  // Closes the underlying writer without blocking, until the next write.
+  void Park() {
+    if (writer_ == nullptr) {
+      // Still waiting for the previous parked writer to close, with writes
+      // buffered until then.
+      return;
+    }
+    parked_close_ = std::make_shared<ParkedClose>();
+    writer_->CloseAsync([parked_close = parked_close_]() {
+      absl::AnyInvocable<void() &&> on_closed;
+      {
+        absl::MutexLock lock(&parked_close->mutex);
+        parked_close->closed = true;
+        on_closed = std::move(parked_close->on_closed);
+      }
+      if (on_closed != nullptr) {
+        std::move(on_closed)();
+      }
+    });
+    writer_.reset();
+  }
+
+  // Reopens the writer if it is parked and its parked writer has finished
+  // closing. Returns false if writes must be buffered until then, since data
+  // written before the writer was parked must reach the file before it is
+  // appended to, and waiting would block the writing thread.
+  bool EnsureOpen() {
+    cache_.MarkOpen(*this);
+    if (writer_ != nullptr) {
+      return true;
+    }
+    if (!parked_close_->IsClosed()) {
+      return false;
+    }
+    parked_close_.reset();
+    writer_ = (*cache_.reopen_provider_)(file_name_);
+    ++cache_.reopen_count_;
+    VLOG(1) << "Reopened parked output file: " << file_name_;
+    if (!pending_writes_.empty()) {
+      writer_->Write(pending_writes_.data(), pending_writes_.size());
+      pending_writes_.clear();
+    }
+    return true;
+  }
+
+  OutputWriterCache& cache_;
+  const std::string file_name_;
+  // Null while parked or once closed.
+  std::unique_ptr<OutputWriterInterface> writer_;
+  // Null unless the writer has been parked.
+  std::shared_ptr<ParkedClose> parked_close_;
+  // Written while parked, before the parked writer finished closing.
+  std::string pending_writes_;
+  // The writer's position in `cache_.open_writers_`, if it is open.
+  std::list<CachedWriter*>::iterator position_;
+  bool is_open_ = false;
+};
+
+std::unique_ptr<OutputWriterInterface> OutputWriterCache::Wrap(
+    absl::string_view file_name,
+    std::unique_ptr<OutputWriterInterface> writer) {
+  return std::make_unique<CachedWriter>(*this, file_name, std::move(writer));
+}
+
+void OutputWriterCache::MarkOpen(CachedWriter& writer) {
+  if (writer.is_open_) {
+    open_writers_.splice(open_writers_.begin(), open_writers_,
+                         writer.position_);
+    return;
+  }
+  // `writer` is not in the list yet, so it is never parked itself.
+  size_t max_open_writers = std::max<size_t>(max_open_writers_, 1);
+  while (open_writers_.size() >= max_open_writers) {
+    CachedWriter* least_recent = open_writers_.back();
+    MarkClosed(*least_recent);
+    least_recent->Park();
+  }
+  open_writers_.push_front(&writer);
+  writer.position_ = open_writers_.begin();
+  writer.is_open_ = true;
+}
+
+void OutputWriterCache::MarkClosed(CachedWriter& writer) {
+  if (!writer.is_open_) {
+    return;
+  }
+  open_writers_.erase(writer.position_);
+  writer.is_open_ = false;
+}
+
+}  // namespace media_api_samples
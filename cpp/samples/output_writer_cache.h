@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_OUTPUT_WRITER_CACHE_H_
+#define CPP_SAMPLES_OUTPUT_WRITER_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+
+// Bounds the number of output writers that are open at once, so that
+// recording a large conference does not exhaust file descriptors or hold a
+// write buffer for every participant.
+//
+// Writers returned by `Wrap` count against `max_open_writers` while they are
+// open. Once the limit is reached, opening or reopening a writer parks the
+// least recently written one: its underlying writer is closed, flushing any
+// buffered data, and the next write reopens the file through
+// `reopen_provider`, which must append to the existing file. Writes made
+// before the parked writer has finished closing are buffered in memory until
+// a later write or close finds it closed, so that writing never waits for a
+// close. Parking is
+// transparent to the wrapped writers' owners, so formats whose headers do not
+// depend on the file size, such as WAV and Y4M files written by
+// `media_writing`, stay valid.
+//
+// Not thread-safe: wrapped writers must be written to and closed on a single
+// thread. The cache must outlive the writers it wraps, although their
+// underlying writers may finish closing afterwards.
+class OutputWriterCache {
+ public:
+  // `reopen_provider` is also invoked from whichever thread finishes closing a
+  // parked writer that was closed with buffered writes, so it must be
+  // thread-safe.
+  OutputWriterCache(size_t max_open_writers,
+                    OutputWriterProvider reopen_provider)
+      : max_open_writers_(max_open_writers),
+        reopen_provider_(std::make_shared<OutputWriterProvider>(
+            std::move(reopen_provider))) {}
+
+  // OutputWriterCache is neither copyable nor movable.
+  OutputWriterCache(const OutputWriterCache&) = delete;
+  OutputWriterCache& operator=(const OutputWriterCache&) = delete;
+
+  // Returns a writer that writes to `writer`, which has just opened
+  // `file_name`, and that reopens `file_name` if it is parked.
+  std::unique_ptr<OutputWriterInterface> Wrap(
+      absl::string_view file_name,
+      std::unique_ptr<OutputWriterInterface> writer);
+
+  // Returns the number of wrapped writers that are currently open.
+  size_t open_writer_count() const { return open_writers_.size(); }
+  // Returns the number of times that parked writers have been reopened.
+  int64_t reopen_count() const { return reopen_count_; }
+
+ private:
+  class CachedWriter;
+
+  // Marks `writer` as the most recently written writer, parking the least
+  // recently written writers if it was not already open.
+  void MarkOpen(CachedWriter& writer);
+  // Stops tracking `writer`, which has been parked or closed.
+  void MarkClosed(CachedWriter& writer);
+
+  const size_t max_open_writers_;
+  // Shared with closes that append buffered writes after the cache is
+  // destroyed.
+  std::shared_ptr<OutputWriterProvider> reopen_provider_;
+  // Open writers, from the most to the least recently written.
+  std::list<CachedWriter*> open_writers_;
+  int64_t reopen_count_ = 0;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_OUTPUT_WRITER_CACHE_H_
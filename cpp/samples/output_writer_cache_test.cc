@@ -0,0 +1,213 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/output_writer_cache.h"
+
+#include <ios>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/strings/string_view.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Appends writes to a shared string per file, and records closes.
+class FakeFileSystem {
+ public:
+  class FakeWriter : public OutputWriterInterface {
+   public:
+    FakeWriter(FakeFileSystem& file_system, std::string file_name)
+        : file_system_(file_system), file_name_(std::move(file_name)) {}
+
+    void Write(const char* content, std::streamsize size) override {
+      file_system_.files[file_name_].append(content, size);
+    }
+    void Close() override { file_system_.closed_files.push_back(file_name_); }
+    void CloseAsync(absl::AnyInvocable<void() &&> on_closed) override {
+      Close();
+      if (file_system_.defer_closes) {
+        file_system_.pending_closes.push_back(std::move(on_closed));
+        return;
+      }
+      std::move(on_closed)();
+    }
+
+   private:
+    FakeFileSystem& file_system_;
+    std::string file_name_;
+  };
+
+  std::unique_ptr<OutputWriterInterface> Open(absl::string_view file_name) {
+    opened_files.push_back(std::string(file_name));
+    return std::make_unique<FakeWriter>(*this, std::string(file_name));
+  }
+
+  OutputWriterProvider Provider() {
+    return [this](absl::string_view file_name) { return Open(file_name); };
+  }
+
+  std::map<std::string, std::string> files;
+  std::vector<std::string> opened_files;
+  std::vector<std::string> closed_files;
+  bool defer_closes = false;
+  std::vector<absl::AnyInvocable<void() &&>> pending_closes;
+};
+
+TEST(OutputWriterCacheTest, WritesThroughOpenWriters) {
+  FakeFileSystem file_system;
+  OutputWriterCache cache(/*max_open_writers=*/2, file_system.Provider());
+  std::unique_ptr<OutputWriterInterface> a =
+      cache.Wrap("a", file_system.Open("a"));
+  std::unique_ptr<OutputWriterInterface> b =
+      cache.Wrap("b", file_system.Open("b"));
+
+  a->Write("1", 1);
+  b->Write("2", 1);
+
+  EXPECT_EQ(cache.open_writer_count(), 2);
+  EXPECT_EQ(file_system.files["a"], "1");
+  EXPECT_EQ(file_system.files["b"], "2");
+  EXPECT_THAT(file_system.closed_files, IsEmpty());
+}
+
+TEST(OutputWriterCacheTest, ParksLeastRecentlyWrittenWriter) {
+  FakeFileSystem file_system;
+  OutputWriterCache cache(/*max_open_writers=*/2, file_system.Provider());
+  std::unique_ptr<OutputWriterInterface> a =
+      cache.Wrap("a", file_system.Open("a"));
+  std::unique_ptr<OutputWriterInterface> b =
+      cache.Wrap("b", file_system.Open("b"));
+  a->Write("1", 1);
+
+  std::unique_ptr<OutputWriterInterface> c =
+      cache.Wrap("c", file_system.Open("c"));
+
+  EXPECT_EQ(cache.open_writer_count(), 2);
+  EXPECT_THAT(file_system.closed_files, ElementsAre("b"));
+}
+
+TEST(OutputWriterCacheTest, ReopensParkedWriterOnWrite) {
+  FakeFileSystem file_system;
+  OutputWriterCache cache(/*max_open_writers=*/1, file_system.Provider());
+  std::unique_ptr<OutputWriterInterface> a =
+      cache.Wrap("a", file_system.Open("a"));
+  a->Write("1", 1);
+  std::unique_ptr<OutputWriterInterface> b =
+      cache.Wrap("b", file_system.Open("b"));
+
+  a->Write("2", 1);
+
+  EXPECT_EQ(file_system.files["a"], "12");
+  EXPECT_THAT(file_system.opened_files, ElementsAre("a", "b", "a"));
+  EXPECT_THAT(file_system.closed_files, ElementsAre("a", "b"));
+  EXPECT_EQ(cache.reopen_count(), 1);
+}
+
+TEST(OutputWriterCacheTest, ClosingWriterFreesItsSlot) {
+  FakeFileSystem file_system;
+  OutputWriterCache cache(/*max_open_writers=*/1, file_system.Provider());
+  std::unique_ptr<OutputWriterInterface> a =
+      cache.Wrap("a", file_system.Open("a"));
+
+  a->Close();
+  std::unique_ptr<OutputWriterInterface> b =
+      cache.Wrap("b", file_system.Open("b"));
+
+  EXPECT_EQ(cache.open_writer_count(), 1);
+  EXPECT_THAT(file_system.closed_files, ElementsAre("a"));
+}
+
+TEST(OutputWriterCacheTest, ClosingParkedWriterWaitsForParkedClose) {
+  FakeFileSystem file_system;
+  file_system.defer_closes = true;
+  OutputWriterCache cache(/*max_open_writers=*/1, file_system.Provider());
+  std::unique_ptr<OutputWriterInterface> a =
+      cache.Wrap("a", file_system.Open("a"));
+  std::unique_ptr<OutputWriterInterface> b =
+      cache.Wrap("b", file_system.Open("b"));
+  bool closed = false;
+
+  a->CloseAsync([&closed]() { closed = true; });
+
+  EXPECT_FALSE(closed);
+  ASSERT_EQ(file_system.pending_closes.size(), 1);
+  std::move(file_system.pending_closes[0])();
+  EXPECT_TRUE(closed);
+  EXPECT_EQ(cache.open_writer_count(), 1);
+}
+
+TEST(OutputWriterCacheTest, BuffersWritesUntilParkedCloseFinishes) {
+  FakeFileSystem file_system;
+  file_system.defer_closes = true;
+  OutputWriterCache cache(/*max_open_writers=*/1, file_system.Provider());
+  std::unique_ptr<OutputWriterInterface> a =
+      cache.Wrap("a", file_system.Open("a"));
+  a->Write("1", 1);
+  std::unique_ptr<OutputWriterInterface> b =
+      cache.Wrap("b", file_system.Open("b"));
+
+  a->Write("2", 1);
+
+  EXPECT_EQ(file_system.files["a"], "1");
+  EXPECT_THAT(file_system.opened_files, ElementsAre("a", "b"));
+  ASSERT_EQ(file_system.pending_closes.size(), 2);
+  std::move(file_system.pending_closes[0])();
+
+  a->Write("3", 1);
+
+  EXPECT_EQ(file_system.files["a"], "123");
+  EXPECT_THAT(file_system.opened_files, ElementsAre("a", "b", "a"));
+  EXPECT_EQ(cache.reopen_count(), 1);
+}
+
+TEST(OutputWriterCacheTest, ClosingWriterAppendsWritesBufferedWhileParked) {
+  FakeFileSystem file_system;
+  file_system.defer_closes = true;
+  OutputWriterCache cache(/*max_open_writers=*/1, file_system.Provider());
+  std::unique_ptr<OutputWriterInterface> a =
+      cache.Wrap("a", file_system.Open("a"));
+  a->Write("1", 1);
+  std::unique_ptr<OutputWriterInterface> b =
+      cache.Wrap("b", file_system.Open("b"));
+  a->Write("2", 1);
+  bool closed = false;
+
+  a->CloseAsync([&closed]() { closed = true; });
+
+  EXPECT_EQ(file_system.files["a"], "1");
+  ASSERT_EQ(file_system.pending_closes.size(), 2);
+  std::move(file_system.pending_closes[0])();
+  EXPECT_EQ(file_system.files["a"], "12");
+  EXPECT_FALSE(closed);
+  ASSERT_EQ(file_system.pending_closes.size(), 3);
+  std::move(file_system.pending_closes[2])();
+  EXPECT_TRUE(closed);
+  EXPECT_THAT(file_system.opened_files, ElementsAre("a", "b", "a"));
+}
+
+}  // namespace
+}  // namespace media_api_samples
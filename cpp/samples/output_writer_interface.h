@@ -19,18 +19,43 @@
 
 #include <ios>
 #include <memory>
+#include <utility>
 
 #include "absl/functional/any_invocable.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace media_api_samples {
 
 // Interface for writing data.
 class OutputWriterInterface {
  public:
+  // A contiguous range of data passed to `WriteVectored`.
+  struct Chunk {
+    const char* content;
+    std::streamsize size;
+  };
+
   virtual ~OutputWriterInterface() = default;
   virtual void Write(const char* content, std::streamsize size) = 0;
+  // Writes `chunks` in order, as if `Write` were called for each chunk.
+  //
+  // Writers that can write several chunks at once should override this.
+  virtual void WriteVectored(absl::Span<const Chunk> chunks) {
+    for (const Chunk& chunk : chunks) {
+      Write(chunk.content, chunk.size);
+    }
+  }
   virtual void Close() = 0;
+  // Closes the writer and invokes `on_closed` once all previously written data
+  // has been written. `on_closed` may be invoked on any thread.
+  //
+  // Writers that write asynchronously should override this so that callers do
+  // not need to block on `Close`.
+  virtual void CloseAsync(absl::AnyInvocable<void() &&> on_closed) {
+    Close();
+    std::move(on_closed)();
+  }
 };
 
 // Interface for providing output writers.
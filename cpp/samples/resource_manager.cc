@@ -28,43 +28,16 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
-#include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "cpp/api/media_entries_resource.h"
+#include "cpp/api/participant_roster.h"
 #include "cpp/api/participants_resource.h"
 
 namespace media_api_samples {
 namespace {
 
-constexpr absl::string_view kParticipantResourceUpdateFormat =
-    "time=%s,"
-    "event=updated participant resource,"
-    "display_name=%s,"
-    "participant_key=%s,"
-    "participant_id=%d\n";
-constexpr absl::string_view kParticipantResourceDeleteFormat =
-    "time=%s,"
-    "event=deleted participant resource,"
-    "participant_id=%d\n";
-constexpr absl::string_view kMediaEntryResourceUpdateFormat =
-    "time=%s,"
-    "event=updated media entry resource,"
-    "participant_session_name=%s,"
-    "participant_key=%s,"
-    "media_entry_id=%d,"
-    "audio_csrc=%d,"
-    // Because there may be multiple video contributing sources, they will be
-    // concatenated using `|` as a delimiter.
-    "video_csrcs=%s,"
-    "audio_muted=%d,"
-    "video_muted=%d\n";
-constexpr absl::string_view kMediaEntryResourceDeleteFormat =
-    "time=%s,"
-    "event=deleted media entry resource,"
-    "media_entry_id=%d\n";
-
 // The output file identifier is formatted as:
 //   <display_name>_<participant_key>_<participant_session_name>
 constexpr absl::string_view kOutputFileIdentifierFormat = "%s_%s_%s";
@@ -73,23 +46,32 @@ constexpr absl::string_view kOutputFileIdentifierFormat = "%s_%s_%s";
 
 void ResourceManager::OnParticipantResourceUpdate(
     const meet::ParticipantsChannelToClient& update, absl::Time received_time) {
-  for (const meet::ParticipantResourceSnapshot& resource : update.resources) {
-    if (!resource.participant.has_value()) {
-      LOG(ERROR) << "Participant resource snapshot with id " << resource.id
-                 << " does not have a participant. Skipping...";
-      continue;
-    }
+  meet::ParticipantRosterDelta delta = participant_roster_.Apply(update);
+  for (int64_t id : delta.missing_participant_ids) {
+    LOG(ERROR) << "Participant resource snapshot with id " << id
+               << " does not have a participant. Skipping...";
+  }
 
-    const meet::Participant& resource_participant = *resource.participant;
+  // Snapshots identical to the cached participant are filtered out by the
+  // roster, so only added and changed participants are rebuilt and logged.
+  std::vector<const meet::ParticipantRosterEntry*> updated_entries =
+      std::move(delta.added);
+  updated_entries.insert(updated_entries.end(), delta.changed.begin(),
+                         delta.changed.end());
 
-    absl::StatusOr<std::string> participant_key_parsed =
+  OutputFileIdentifiers identifiers = *output_file_identifiers_.load();
+  for (const meet::ParticipantRosterEntry* entry : updated_entries) {
+    const int64_t resource_id = entry->resource_id;
+    const meet::Participant& resource_participant = entry->participant;
+
+    absl::StatusOr<ParticipantKey> participant_key_parsed =
         ParseParticipantKey(resource_participant.participant_key);
     if (!participant_key_parsed.ok()) {
       LOG(ERROR) << "Failed to parse participant key: "
                  << participant_key_parsed.status().message();
       continue;
     }
-    std::string participant_key = std::move(participant_key_parsed).value();
+    ParticipantKey participant_key = *std::move(participant_key_parsed);
 
     std::string display_name;
     if (resource_participant.anonymous_user.has_value()) {
@@ -99,33 +81,54 @@ void ResourceManager::OnParticipantResourceUpdate(
     } else if (resource_participant.signed_in_user.has_value()) {
       display_name = resource_participant.signed_in_user->display_name;
     } else {
-      LOG(ERROR) << "Participant resource snapshot with id " << resource.id
+      LOG(ERROR) << "Participant resource snapshot with id " << resource_id
                  << " does not have a user. Skipping...";
       continue;
     }
 
-    auto participant = std::make_unique<Participant>(std::move(participant_key),
-                                                     resource.id, display_name);
+    Participant participant{.participant_key = std::move(participant_key),
+                            .participant_id = resource_id,
+                            .display_name = std::move(display_name)};
 
-    std::string event_log_message = absl::StrFormat(
-        kParticipantResourceUpdateFormat, absl::FormatTime(received_time),
-        participant->display_name, participant->participant_key,
-        participant->participant_id);
-    event_log_file_->Write(event_log_message.data(), event_log_message.size());
+    event_log_->Append(
+        {.type = ResourceEventType::kParticipantUpdated,
+         .time = received_time,
+         .resource_id = participant.participant_id,
+         .display_name = participant.display_name,
+         .participant_key = std::string(participant.participant_key.value())});
 
     // Since these are resource "snapshots", they are intended to be complete
     // representations of the data. Therefore, existing data can be entirely
-    // replaced with the new data.
-    participants_by_id_[participant->participant_id] = participant.get();
-    participants_by_key_[participant->participant_key] = std::move(participant);
+    // replaced with the new data, reusing the existing slot.
+    ParticipantKey key = participant.participant_key;
+    ParticipantHandle handle;
+    auto existing_it = participants_by_key_.find(key.value());
+    if (existing_it != participants_by_key_.end()) {
+      handle = existing_it->second;
+      Participant* existing_participant = participants_.Get(handle);
+      DCHECK(existing_participant != nullptr);
+      if (existing_participant->participant_id != resource_id) {
+        participants_by_id_.erase(existing_participant->participant_id);
+      }
+      *existing_participant = std::move(participant);
+    } else {
+      handle = participants_.Insert(std::move(participant));
+      participants_by_key_[key.value()] = handle;
+    }
+    participants_by_id_[resource_id] = handle;
+
+    media_entries_.ForEach([&](const MediaEntry& media_entry) {
+      if (media_entry.participant_key == key) {
+        SetOutputFileIdentifiers(media_entry, identifiers);
+      }
+    });
   }
 
   for (const meet::ParticipantDeletedResource& resource :
        update.deleted_resources) {
-    std::string event_log_message =
-        absl::StrFormat(kParticipantResourceDeleteFormat,
-                        absl::FormatTime(received_time), resource.id);
-    event_log_file_->Write(event_log_message.data(), event_log_message.size());
+    event_log_->Append({.type = ResourceEventType::kParticipantDeleted,
+                        .time = received_time,
+                        .resource_id = resource.id});
 
     auto node = participants_by_id_.extract(resource.id);
     if (node.empty()) {
@@ -134,16 +137,28 @@ void ResourceManager::OnParticipantResourceUpdate(
       continue;
     }
 
-    Participant* removed_participant = std::move(node.mapped());
+    ParticipantHandle removed_handle = node.mapped();
+    Participant* removed_participant = participants_.Get(removed_handle);
     DCHECK(removed_participant != nullptr);
-    // This map holds the unique pointer to the participant, so it must be
-    // erased after the participant is removed from the other map.
-    participants_by_key_.erase(removed_participant->participant_key);
+    ParticipantKey removed_participant_key =
+        std::move(removed_participant->participant_key);
+    participants_by_key_.erase(removed_participant_key.value());
+    participants_.Erase(removed_handle);
+
+    media_entries_.ForEach([&](const MediaEntry& media_entry) {
+      if (media_entry.participant_key == removed_participant_key) {
+        SetOutputFileIdentifiers(media_entry, identifiers);
+      }
+    });
   }
+
+  PublishOutputFileIdentifiers(std::move(identifiers));
+  event_log_->Flush();
 }
 
 void ResourceManager::OnMediaEntriesResourceUpdate(
     const meet::MediaEntriesChannelToClient& update, absl::Time received_time) {
+  OutputFileIdentifiers identifiers = *output_file_identifiers_.load();
   for (const meet::MediaEntriesResourceSnapshot& resource : update.resources) {
     if (!resource.media_entry.has_value()) {
       LOG(ERROR) << "Media entry resource snapshot with id " << resource.id
@@ -153,55 +168,76 @@ void ResourceManager::OnMediaEntriesResourceUpdate(
 
     const meet::MediaEntry& resource_media_entry = *resource.media_entry;
 
-    absl::StatusOr<std::string> participant_session_name_parsed =
+    absl::StatusOr<ParticipantSessionName> participant_session_name_parsed =
         ParseParticipantSessionName(resource_media_entry.session_name);
     if (!participant_session_name_parsed.ok()) {
       LOG(ERROR) << "Failed to parse participant session name: "
                  << participant_session_name_parsed.status().message();
       continue;
     }
-    std::string participant_session_name =
-        std::move(participant_session_name_parsed).value();
+    ParticipantSessionName participant_session_name =
+        *std::move(participant_session_name_parsed);
 
-    absl::StatusOr<std::string> participant_key_parsed =
+    absl::StatusOr<ParticipantKey> participant_key_parsed =
         ParseParticipantKey(resource_media_entry.participant_key);
     if (!participant_key_parsed.ok()) {
       LOG(ERROR) << "Failed to parse participant key: "
                  << participant_key_parsed.status().message();
       continue;
     }
-    std::string participant_key = std::move(participant_key_parsed).value();
-
-    auto media_entry = std::make_unique<MediaEntry>(
-        std::move(participant_session_name), std::move(participant_key),
-        resource.id, resource_media_entry.audio_csrc,
-        std::move(resource_media_entry.video_csrcs));
-
-    std::string event_log_message = absl::StrFormat(
-        kMediaEntryResourceUpdateFormat, absl::FormatTime(received_time),
-        media_entry->participant_session_name, media_entry->participant_key,
-        media_entry->media_entry_id, media_entry->audio_csrc,
-        absl::StrJoin(media_entry->video_csrcs, "|"),
-        resource_media_entry.audio_muted, resource_media_entry.video_muted);
-    event_log_file_->Write(event_log_message.data(), event_log_message.size());
+    ParticipantKey participant_key = *std::move(participant_key_parsed);
+
+    MediaEntry media_entry{
+        .participant_session_name = std::move(participant_session_name),
+        .participant_key = std::move(participant_key),
+        .media_entry_id = resource.id,
+        .audio_csrc = resource_media_entry.audio_csrc,
+        .video_csrcs = resource_media_entry.video_csrcs};
+
+    event_log_->Append(
+        {.type = ResourceEventType::kMediaEntryUpdated,
+         .time = received_time,
+         .resource_id = media_entry.media_entry_id,
+         .participant_key = std::string(media_entry.participant_key.value()),
+         .participant_session_name =
+             std::string(media_entry.participant_session_name.value()),
+         .audio_csrc = media_entry.audio_csrc,
+         .video_csrcs = media_entry.video_csrcs,
+         .audio_muted = resource_media_entry.audio_muted,
+         .video_muted = resource_media_entry.video_muted});
 
     // Since these are resource "snapshots", they are intended to be complete
     // representations of the data. Therefore, existing data can be entirely
-    // replaced with the new data.
-    media_entries_by_csrc_[media_entry->audio_csrc] = media_entry.get();
-    for (uint32_t video_csrc : media_entry->video_csrcs) {
-      media_entries_by_csrc_[video_csrc] = media_entry.get();
+    // replaced with the new data, reusing the existing slot.
+    MediaEntryHandle handle;
+    auto existing_it = media_entries_by_session_name_.find(
+        media_entry.participant_session_name.value());
+    if (existing_it != media_entries_by_session_name_.end()) {
+      handle = existing_it->second;
+      MediaEntry* existing_media_entry = media_entries_.Get(handle);
+      DCHECK(existing_media_entry != nullptr);
+      // The contributing sources of the replaced media entry may have changed,
+      // so they must not resolve to the replaced entry's identifier.
+      EraseOutputFileIdentifiers(*existing_media_entry, identifiers);
+      if (existing_media_entry->media_entry_id != resource.id) {
+        media_entries_by_id_.erase(existing_media_entry->media_entry_id);
+      }
+      *existing_media_entry = std::move(media_entry);
+    } else {
+      // The key views the interned name, which the inserted entry keeps alive.
+      absl::string_view participant_session_name =
+          media_entry.participant_session_name.value();
+      handle = media_entries_.Insert(std::move(media_entry));
+      media_entries_by_session_name_[participant_session_name] = handle;
     }
-    media_entries_by_id_[resource.id] = media_entry.get();
-    media_entries_by_session_name_[media_entry->participant_session_name] =
-        std::move(media_entry);
+    SetOutputFileIdentifiers(*media_entries_.Get(handle), identifiers);
+    media_entries_by_id_[resource.id] = handle;
   }
 
   for (meet::MediaEntriesDeletedResource resource : update.deleted_resources) {
-    std::string event_log_message =
-        absl::StrFormat(kMediaEntryResourceDeleteFormat,
-                        absl::FormatTime(received_time), resource.id);
-    event_log_file_->Write(event_log_message.data(), event_log_message.size());
+    event_log_->Append({.type = ResourceEventType::kMediaEntryDeleted,
+                        .time = received_time,
+                        .resource_id = resource.id});
 
     auto node = media_entries_by_id_.extract(resource.id);
     if (node.empty()) {
@@ -210,46 +246,81 @@ void ResourceManager::OnMediaEntriesResourceUpdate(
       continue;
     }
 
-    MediaEntry* removed_media_entry = std::move(node.mapped());
+    MediaEntryHandle removed_handle = node.mapped();
+    MediaEntry* removed_media_entry = media_entries_.Get(removed_handle);
     DCHECK(removed_media_entry != nullptr);
-    media_entries_by_csrc_.erase(removed_media_entry->audio_csrc);
-    for (uint32_t video_csrc : removed_media_entry->video_csrcs) {
-      media_entries_by_csrc_.erase(video_csrc);
-    }
-    // This map holds the unique pointer to the media entry, so it must be
-    // erased after the media entry is removed from the other maps.
+    EraseOutputFileIdentifiers(*removed_media_entry, identifiers);
     media_entries_by_session_name_.erase(
-        removed_media_entry->participant_session_name);
+        removed_media_entry->participant_session_name.value());
+    media_entries_.Erase(removed_handle);
   }
+
+  PublishOutputFileIdentifiers(std::move(identifiers));
+  event_log_->Flush();
 }
 
 absl::StatusOr<std::string> ResourceManager::GetOutputFileIdentifier(
     uint32_t contributing_source) {
-  auto media_entry_it = media_entries_by_csrc_.find(contributing_source);
-  if (media_entry_it == media_entries_by_csrc_.end()) {
+  std::shared_ptr<const OutputFileIdentifiers> identifiers =
+      output_file_identifiers_.load();
+  auto identifier_it = identifiers->find(contributing_source);
+  if (identifier_it == identifiers->end()) {
     return absl::NotFoundError(
         absl::StrCat("Media entry not found for CSRC: ", contributing_source));
   }
+  if (!identifier_it->second.has_value()) {
+    return absl::NotFoundError(
+        absl::StrCat("Participant not found for CSRC: ", contributing_source));
+  }
+  return *identifier_it->second;
+}
 
+std::optional<std::string> ResourceManager::CreateOutputFileIdentifier(
+    const MediaEntry& media_entry) const {
   auto participant_it =
-      participants_by_key_.find(media_entry_it->second->participant_key);
+      participants_by_key_.find(media_entry.participant_key.value());
   if (participant_it == participants_by_key_.end()) {
-    return absl::NotFoundError(
-        absl::StrCat("Participant not found for CSRC: ", contributing_source));
+    return std::nullopt;
   }
+  const Participant* participant = participants_.Get(participant_it->second);
+  DCHECK(participant != nullptr);
+  return absl::StrFormat(kOutputFileIdentifierFormat, participant->display_name,
+                         participant->participant_key.value(),
+                         media_entry.participant_session_name.value());
+}
+
+void ResourceManager::SetOutputFileIdentifiers(
+    const MediaEntry& media_entry, OutputFileIdentifiers& identifiers) const {
+  std::optional<std::string> identifier =
+      CreateOutputFileIdentifier(media_entry);
+  identifiers[media_entry.audio_csrc] = identifier;
+  for (uint32_t video_csrc : media_entry.video_csrcs) {
+    identifiers[video_csrc] = identifier;
+  }
+}
+
+void ResourceManager::EraseOutputFileIdentifiers(
+    const MediaEntry& media_entry, OutputFileIdentifiers& identifiers) {
+  identifiers.erase(media_entry.audio_csrc);
+  for (uint32_t video_csrc : media_entry.video_csrcs) {
+    identifiers.erase(video_csrc);
+  }
+}
 
-  return absl::StrFormat(kOutputFileIdentifierFormat,
-                         participant_it->second->display_name,
-                         participant_it->second->participant_key,
-                         media_entry_it->second->participant_session_name);
+void ResourceManager::PublishOutputFileIdentifiers(
+    OutputFileIdentifiers identifiers) {
+  output_file_identifiers_.store(
+      std::make_shared<const OutputFileIdentifiers>(std::move(identifiers)));
 }
 
-absl::StatusOr<std::string> ResourceManager::ParseParticipantKey(
-    const std::optional<std::string>& participant_key) const {
+absl::StatusOr<ResourceManager::ParticipantKey>
+ResourceManager::ParseParticipantKey(
+    const std::optional<std::string>& participant_key) {
   if (!participant_key.has_value()) {
     return absl::InvalidArgumentError("Participant key is empty");
   }
-  std::vector<std::string> participant_key_split =
+  // The parts view the resource name, so only the interned key is copied.
+  std::vector<absl::string_view> participant_key_split =
       absl::StrSplit(*participant_key, '/');
   // Participant keys are expected to be in the format:
   //   participants/<participant_key>
@@ -257,15 +328,16 @@ absl::StatusOr<std::string> ResourceManager::ParseParticipantKey(
     return absl::InvalidArgumentError(absl::StrCat(
         "Participant key is not in the expected format: ", *participant_key));
   }
-  return participant_key_split[1];
+  return interned_names_.Intern(participant_key_split[1]);
 }
 
-absl::StatusOr<std::string> ResourceManager::ParseParticipantSessionName(
-    const std::optional<std::string>& participant_session_name) const {
+absl::StatusOr<ResourceManager::ParticipantSessionName>
+ResourceManager::ParseParticipantSessionName(
+    const std::optional<std::string>& participant_session_name) {
   if (!participant_session_name.has_value()) {
     return absl::InvalidArgumentError("Participant session name is empty");
   }
-  std::vector<std::string> participant_session_name_split =
+  std::vector<absl::string_view> participant_session_name_split =
       absl::StrSplit(*participant_session_name, '/');
   // Participant session names are expected to be in the format:
   //   participants/<participant_key>/mediaEntries/<media_entry_key>
@@ -274,7 +346,7 @@ absl::StatusOr<std::string> ResourceManager::ParseParticipantSessionName(
         absl::StrCat("Participant session name is not in the expected format: ",
                      *participant_session_name));
   }
-  return participant_session_name_split[3];
+  return interned_names_.Intern(participant_session_name_split[3]);
 }
 
 }  // namespace media_api_samples
@@ -17,6 +17,7 @@
 #ifndef CPP_SAMPLES_RESOURCE_MANAGER_H_
 #define CPP_SAMPLES_RESOURCE_MANAGER_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -26,25 +27,39 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "cpp/api/media_entries_resource.h"
+#include "cpp/api/participant_roster.h"
 #include "cpp/api/participants_resource.h"
+#include "cpp/samples/event_log.h"
 #include "cpp/samples/output_writer_interface.h"
 #include "cpp/samples/resource_manager_interface.h"
+#include "cpp/samples/slot_map.h"
+#include "cpp/samples/string_interner.h"
 
 namespace media_api_samples {
 
 // A participant manager that manages participant and media entry metadata.
 //
 // Additionally, this implementation outputs participant and media entry events
-// to a log file in a format that is easy to read programmatically.
+// to an event log in a format that is easy to read programmatically; see
+// `EventLogFormat`.
 //
-// This class is not thread-safe.
+// Resource updates must be applied from a single thread.
+// `GetOutputFileIdentifier` is thread-safe and may be called from any thread,
+// concurrently with resource updates.
 class ResourceManager : public ResourceManagerInterface {
  public:
+  // Writes the event log to `event_log_file` in the CSV format.
   explicit ResourceManager(
       std::unique_ptr<OutputWriterInterface> event_log_file)
-      : event_log_file_(std::move(event_log_file)) {};
+      : ResourceManager(
+            std::make_unique<CsvEventLogWriter>(std::move(event_log_file))) {}
+  explicit ResourceManager(std::unique_ptr<EventLogWriterInterface> event_log)
+      : event_log_(std::move(event_log)),
+        output_file_identifiers_(
+            std::make_shared<const OutputFileIdentifiers>()) {}
 
   void OnParticipantResourceUpdate(
       const meet::ParticipantsChannelToClient& update,
@@ -57,14 +72,18 @@ class ResourceManager : public ResourceManagerInterface {
   //
   // This implementation produces strings in the format:
   //   <display_name>_<participant_key>_<participant_session_name>
+  //
+  // Identifiers are read from an immutable snapshot, so this method does not
+  // block or contend with resource updates.
   absl::StatusOr<std::string> GetOutputFileIdentifier(
       uint32_t contributing_source) override;
 
  private:
-  // Identifier for a participant.
-  using ParticipantKey = std::string;
+  // Identifier for a participant. Keys are interned, so the participant and
+  // all of its media entries share one copy and are compared by identity.
+  using ParticipantKey = StringInterner::Handle;
   // Identifier for a media entry.
-  using ParticipantSessionName = std::string;
+  using ParticipantSessionName = StringInterner::Handle;
   // Identifier for a media stream.
   using ContributingSource = uint32_t;
 
@@ -94,45 +113,86 @@ class ResourceManager : public ResourceManagerInterface {
     std::vector<ContributingSource> video_csrcs;
   };
 
-  // Parses the participant key value from the participant resource.
+  using ParticipantHandle = SlotMap<Participant>::Handle;
+  using MediaEntryHandle = SlotMap<MediaEntry>::Handle;
+
+  // The output file identifier for a contributing source, or nullopt if the
+  // contributing source's media entry is known but its participant is not.
+  using OutputFileIdentifiers =
+      absl::flat_hash_map<ContributingSource, std::optional<std::string>>;
+
+  // Returns the output file identifier for `media_entry`, or nullopt if its
+  // participant is not known.
+  std::optional<std::string> CreateOutputFileIdentifier(
+      const MediaEntry& media_entry) const;
+  // Replaces the identifiers of all of `media_entry`'s contributing sources.
+  void SetOutputFileIdentifiers(const MediaEntry& media_entry,
+                                OutputFileIdentifiers& identifiers) const;
+  // Erases the identifiers of all of `media_entry`'s contributing sources.
+  static void EraseOutputFileIdentifiers(const MediaEntry& media_entry,
+                                         OutputFileIdentifiers& identifiers);
+  // Publishes `identifiers` as the snapshot read by `GetOutputFileIdentifier`.
+  void PublishOutputFileIdentifiers(OutputFileIdentifiers identifiers);
+
+  // Parses the participant key value from the participant resource, and
+  // interns it.
   //
   // Participant keys are expected to be in the format:
   //   participants/<participant_key>
-  absl::StatusOr<std::string> ParseParticipantKey(
-      const std::optional<std::string>& participant_key) const;
-  // Parses the participant session name value from the media entry resource.
+  absl::StatusOr<ParticipantKey> ParseParticipantKey(
+      const std::optional<std::string>& participant_key);
+  // Parses the participant session name value from the media entry resource,
+  // and interns it.
   //
   // Participant session names are expected to be in the format:
   //   participants/<participant_key>/mediaEntries/<media_entry_key>
-  absl::StatusOr<std::string> ParseParticipantSessionName(
-      const std::optional<std::string>& participant_session_name) const;
+  absl::StatusOr<ParticipantSessionName> ParseParticipantSessionName(
+      const std::optional<std::string>& participant_session_name);
+
+  // Events are appended while an update is applied, and flushed once the
+  // update is done.
+  std::unique_ptr<EventLogWriterInterface> event_log_;
+
+  // Holds the participant keys and session names referenced below. Declared
+  // before them so that it outlives their handles.
+  StringInterner interned_names_;
 
-  std::unique_ptr<OutputWriterInterface> event_log_file_;
+  // Caches the participants from resource updates, so that snapshots that do
+  // not change a participant are not processed again.
+  meet::ParticipantRoster participant_roster_;
 
-  // Participants and media entries are keyed by their unique identifiers.
+  // Participants and media entries are stored contiguously in slot maps, so
+  // join and leave churn reuses slots instead of allocating.
   //
-  // These maps are the owners of the participant and media entry objects, and
-  // the following lookup maps point to the objects in these maps.
-  absl::flat_hash_map<ParticipantKey, std::unique_ptr<Participant>>
+  // These are the owners of the participant and media entry objects, and the
+  // following lookup maps hold handles to them.
+  SlotMap<Participant> participants_;
+  SlotMap<MediaEntry> media_entries_;
+
+  // Participants and media entries are keyed by their unique identifiers. The
+  // keys view the interned identifiers held by the mapped values.
+  absl::flat_hash_map<absl::string_view, ParticipantHandle>
       participants_by_key_;
-  absl::flat_hash_map<ParticipantSessionName, std::unique_ptr<MediaEntry>>
+  absl::flat_hash_map<absl::string_view, MediaEntryHandle>
       media_entries_by_session_name_;
 
   // When receiving audio and video frames, the contributing source is the only
-  // available identifier. Therefore, a second map is used to look up the media
-  // entry associated with the contributing source.
+  // available identifier. Therefore, output file identifiers are precomputed
+  // for every known contributing source.
   //
-  // The media entry's participant key can then be used to look up the
-  // participant.
-  absl::flat_hash_map<ContributingSource, MediaEntry*> media_entries_by_csrc_;
+  // Resource updates copy the current snapshot, update the identifiers of the
+  // affected media entries, and atomically publish the result. Readers on
+  // other threads keep using the snapshot they loaded until they release it.
+  std::atomic<std::shared_ptr<const OutputFileIdentifiers>>
+      output_file_identifiers_;
 
   // Another set of lookup maps used when participant and media entry resources
   // are deleted.
   //
   // These maps will be removed in the future when deletion updates include the
   // participant and media entry keys.
-  absl::flat_hash_map<ParticipantId, Participant*> participants_by_id_;
-  absl::flat_hash_map<MediaEntryId, MediaEntry*> media_entries_by_id_;
+  absl::flat_hash_map<ParticipantId, ParticipantHandle> participants_by_id_;
+  absl::flat_hash_map<MediaEntryId, MediaEntryHandle> media_entries_by_id_;
 };
 
 }  // namespace media_api_samples
@@ -48,6 +48,9 @@ class ResourceManagerInterface {
   //
   // If sufficient information is not available to construct the identifier,
   // an error is returned.
+  //
+  // Implementations must allow this method to be called from any thread,
+  // concurrently with resource updates.
   virtual absl::StatusOr<std::string> GetOutputFileIdentifier(
       uint32_t contributing_source) = 0;
 };
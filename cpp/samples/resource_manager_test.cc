@@ -134,6 +134,41 @@ TEST(ResourceManagerTest, OnParticipantResourceUpdateLogsEvents) {
             "participant_id=345\n");
 }
 
+TEST(ResourceManagerTest, UnchangedParticipantSnapshotIsNotLoggedAgain) {
+  auto event_writer = std::make_unique<MockOutputWriter>();
+  std::vector<std::string> written_events;
+  EXPECT_CALL(*event_writer, Write(_, _))
+      .WillRepeatedly([&](const char* data, size_t size) {
+        written_events.push_back(std::string(data, size));
+      });
+  ResourceManager resource_manager(std::move(event_writer));
+  meet::ParticipantsChannelToClient update{
+      .resources = {
+          meet::ParticipantResourceSnapshot{
+              .id = 123,
+              .participant =
+                  meet::Participant{
+                      .participant_key = "participants/participant_key",
+                      .anonymous_user =
+                          meet::AnonymousUser{.display_name = "display_name"},
+                  },
+          },
+      }};
+
+  resource_manager.OnParticipantResourceUpdate(update,
+                                               absl::FromUnixSeconds(100));
+  resource_manager.OnParticipantResourceUpdate(update,
+                                               absl::FromUnixSeconds(200));
+
+  ASSERT_EQ(written_events.size(), 1);
+  EXPECT_EQ(written_events[0],
+            "time=1969-12-31T16:01:40-08:00,"
+            "event=updated participant resource,"
+            "display_name=display_name,"
+            "participant_key=participant_key,"
+            "participant_id=123\n");
+}
+
 TEST(ResourceManagerTest, OnParticipantResourceUpdateLogsDeletedEvents) {
   auto event_writer = std::make_unique<MockOutputWriter>();
   std::vector<std::string> written_events;
@@ -162,6 +197,35 @@ TEST(ResourceManagerTest, OnParticipantResourceUpdateLogsDeletedEvents) {
             "participant_id=123\n");
 }
 
+TEST(ResourceManagerTest, WritesEventsOfAnUpdateInOneWrite) {
+  auto event_writer = std::make_unique<MockOutputWriter>();
+  std::vector<std::string> written_events;
+  EXPECT_CALL(*event_writer, Write(_, _))
+      .WillRepeatedly([&](const char* data, size_t size) {
+        written_events.push_back(std::string(data, size));
+      });
+  ResourceManager resource_manager(std::move(event_writer));
+
+  resource_manager.OnParticipantResourceUpdate(
+      meet::ParticipantsChannelToClient{
+          .deleted_resources =
+              {
+                  meet::ParticipantDeletedResource{.id = 123},
+                  meet::ParticipantDeletedResource{.id = 234},
+              },
+      },
+      absl::FromUnixSeconds(100));
+
+  ASSERT_EQ(written_events.size(), 1);
+  EXPECT_EQ(written_events[0],
+            "time=1969-12-31T16:01:40-08:00,"
+            "event=deleted participant resource,"
+            "participant_id=123\n"
+            "time=1969-12-31T16:01:40-08:00,"
+            "event=deleted participant resource,"
+            "participant_id=234\n");
+}
+
 TEST(ResourceManagerTest, OnMediaEntriesResourceUpdateLogsEvents) {
   auto event_writer = std::make_unique<MockOutputWriter>();
   std::vector<std::string> written_events;
@@ -802,5 +866,125 @@ TEST(ResourceManagerTest,
                        "Participant not found for CSRC: 111"));
 }
 
+TEST(ResourceManagerTest,
+     GetOutputFileIdentifierAfterParticipantUpdateReturnsIdentifier) {
+  auto event_writer = std::make_unique<MockOutputWriter>();
+  ResourceManager resource_manager(std::move(event_writer));
+  // Media entries may be received before their participant.
+  resource_manager.OnMediaEntriesResourceUpdate(
+      meet::MediaEntriesChannelToClient{
+          .resources =
+              {
+                  meet::MediaEntriesResourceSnapshot{
+                      .id = 234,
+                      .media_entry =
+                          meet::MediaEntry{
+                              .participant_key = "participants/participant_key",
+                              .session_name =
+                                  "participants/participant_key/"
+                                  "participantSessions/session_name",
+                              .audio_csrc = 111,
+                          },
+                  },
+              },
+      },
+      absl::FromUnixSeconds(100));
+  resource_manager.OnParticipantResourceUpdate(
+      meet::ParticipantsChannelToClient{
+          .resources =
+              {
+                  meet::ParticipantResourceSnapshot{
+                      .id = 123,
+                      .participant =
+                          meet::Participant{
+                              .participant_key = "participants/participant_key",
+                              .signed_in_user =
+                                  meet::SignedInUser{
+                                      .display_name = "display_name",
+                                  },
+                          },
+                  },
+              },
+      },
+      absl::FromUnixSeconds(100));
+
+  absl::StatusOr<std::string> output_file_identifier =
+      resource_manager.GetOutputFileIdentifier(111);
+
+  ASSERT_OK(output_file_identifier);
+  EXPECT_EQ(output_file_identifier.value(),
+            "display_name_participant_key_session_name");
+}
+
+TEST(ResourceManagerTest,
+     GetOutputFileIdentifierAfterReplacingMediaEntryCsrcsReturnsError) {
+  auto event_writer = std::make_unique<MockOutputWriter>();
+  ResourceManager resource_manager(std::move(event_writer));
+  resource_manager.OnParticipantResourceUpdate(
+      meet::ParticipantsChannelToClient{
+          .resources =
+              {
+                  meet::ParticipantResourceSnapshot{
+                      .id = 123,
+                      .participant =
+                          meet::Participant{
+                              .participant_key = "participants/participant_key",
+                              .signed_in_user =
+                                  meet::SignedInUser{
+                                      .display_name = "display_name",
+                                  },
+                          },
+                  },
+              },
+      },
+      absl::FromUnixSeconds(100));
+  resource_manager.OnMediaEntriesResourceUpdate(
+      meet::MediaEntriesChannelToClient{
+          .resources =
+              {
+                  meet::MediaEntriesResourceSnapshot{
+                      .id = 234,
+                      .media_entry =
+                          meet::MediaEntry{
+                              .participant_key = "participants/participant_key",
+                              .session_name =
+                                  "participants/participant_key/"
+                                  "participantSessions/session_name",
+                              .audio_csrc = 111,
+                          },
+                  },
+              },
+      },
+      absl::FromUnixSeconds(100));
+  // Replace the media entry with a new audio CSRC.
+  resource_manager.OnMediaEntriesResourceUpdate(
+      meet::MediaEntriesChannelToClient{
+          .resources =
+              {
+                  meet::MediaEntriesResourceSnapshot{
+                      .id = 234,
+                      .media_entry =
+                          meet::MediaEntry{
+                              .participant_key = "participants/participant_key",
+                              .session_name =
+                                  "participants/participant_key/"
+                                  "participantSessions/session_name",
+                              .audio_csrc = 444,
+                          },
+                  },
+              },
+      },
+      absl::FromUnixSeconds(100));
+
+  EXPECT_THAT(resource_manager.GetOutputFileIdentifier(111),
+              StatusIs(absl::StatusCode::kNotFound,
+                       "Media entry not found for CSRC: 111"));
+  absl::StatusOr<std::string> output_file_identifier =
+      resource_manager.GetOutputFileIdentifier(444);
+  ASSERT_OK(output_file_identifier);
+  EXPECT_EQ(output_file_identifier.value(),
+            "display_name_participant_key_session_name");
+}
+
 }  // namespace
 }  // namespace media_api_samples
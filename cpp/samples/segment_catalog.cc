@@ -0,0 +1,228 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/segment_catalog.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/samples/little_endian.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+namespace {
+
+constexpr absl::string_view kMagic = "MEETSEGS";
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = kMagic.size() + sizeof(uint32_t);
+
+// kind | first frame time | last frame time | width | height | identifier size
+constexpr size_t kRecordMetadataSize =
+    sizeof(uint8_t) + 2 * sizeof(int64_t) + 2 * sizeof(int32_t) +
+    sizeof(uint16_t);
+
+absl::StatusOr<SegmentCatalogEntry> ParseRecord(absl::string_view record) {
+  uint8_t kind;
+  int64_t first_frame_time;
+  int64_t last_frame_time;
+  int32_t width;
+  int32_t height;
+  uint16_t identifier_size;
+  if (!TakeLittleEndian(record, kind) ||
+      !TakeLittleEndian(record, first_frame_time) ||
+      !TakeLittleEndian(record, last_frame_time) ||
+      !TakeLittleEndian(record, width) || !TakeLittleEndian(record, height) ||
+      !TakeLittleEndian(record, identifier_size) ||
+      kind > static_cast<uint8_t>(meet::MediaKind::kVideo) ||
+      record.size() < identifier_size) {
+    return absl::DataLossError("Malformed segment catalog record.");
+  }
+  return SegmentCatalogEntry{
+      .kind = static_cast<meet::MediaKind>(kind),
+      .file_identifier = std::string(record.substr(0, identifier_size)),
+      .file_name = std::string(record.substr(identifier_size)),
+      .first_frame_time = absl::FromUnixMicros(first_frame_time),
+      .last_frame_time = absl::FromUnixMicros(last_frame_time),
+      .width = width,
+      .height = height,
+  };
+}
+
+}  // namespace
+
+SegmentCatalogWriter::SegmentCatalogWriter(
+    std::unique_ptr<OutputWriterInterface> writer)
+    : writer_(std::move(writer)) {
+  char header[kHeaderSize];
+  kMagic.copy(header, kMagic.size());
+  PutLittleEndian(header, kMagic.size(), kVersion);
+  writer_->Write(header, sizeof(header));
+}
+
+void SegmentCatalogWriter::Append(const SegmentCatalogEntry& entry) {
+  char metadata[sizeof(uint32_t) + kRecordMetadataSize];
+  size_t offset = PutLittleEndian(
+      metadata, 0,
+      static_cast<uint32_t>(kRecordMetadataSize + entry.file_identifier.size() +
+                            entry.file_name.size()));
+  offset = PutLittleEndian(metadata, offset, static_cast<uint8_t>(entry.kind));
+  offset = PutLittleEndian(metadata, offset,
+                           absl::ToUnixMicros(entry.first_frame_time));
+  offset = PutLittleEndian(metadata, offset,
+                           absl::ToUnixMicros(entry.last_frame_time));
+  offset =
+      PutLittleEndian(metadata, offset, static_cast<int32_t>(entry.width));
+  offset =
+      PutLittleEndian(metadata, offset, static_cast<int32_t>(entry.height));
+  PutLittleEndian(metadata, offset,
+                  static_cast<uint16_t>(entry.file_identifier.size()));
+  OutputWriterInterface::Chunk chunks[] = {
+      {.content = metadata, .size = sizeof(metadata)},
+      {.content = entry.file_identifier.data(),
+       .size = static_cast<std::streamsize>(entry.file_identifier.size())},
+      {.content = entry.file_name.data(),
+       .size = static_cast<std::streamsize>(entry.file_name.size())}};
+
+  absl::MutexLock lock(&mutex_);
+  if (writer_ == nullptr) {
+    return;
+  }
+  writer_->WriteVectored(chunks);
+}
+
+void SegmentCatalogWriter::CloseAsync(
+    absl::AnyInvocable<void() &&> on_closed) {
+  std::unique_ptr<OutputWriterInterface> writer;
+  {
+    absl::MutexLock lock(&mutex_);
+    writer = std::move(writer_);
+  }
+  if (writer == nullptr) {
+    std::move(on_closed)();
+    return;
+  }
+  // The writer may be released before it has finished closing, since closing
+  // asynchronously keeps whatever state it needs alive.
+  writer->CloseAsync(std::move(on_closed));
+}
+
+absl::StatusOr<SegmentCatalog> SegmentCatalog::Parse(
+    absl::string_view contents) {
+  SegmentCatalog catalog;
+  if (!absl::StartsWith(kMagic, contents.substr(0, kMagic.size()))) {
+    return absl::InvalidArgumentError("Not a segment catalog.");
+  }
+  if (contents.size() < kHeaderSize) {
+    // The collector stopped while writing the header.
+    return catalog;
+  }
+  contents.remove_prefix(kMagic.size());
+  uint32_t version;
+  TakeLittleEndian(contents, version);
+  if (version != kVersion) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unsupported segment catalog version: ", version));
+  }
+
+  while (!contents.empty()) {
+    uint32_t size;
+    if (!TakeLittleEndian(contents, size) || contents.size() < size) {
+      // The collector stopped while appending the last record.
+      break;
+    }
+    absl::StatusOr<SegmentCatalogEntry> entry =
+        ParseRecord(contents.substr(0, size));
+    if (!entry.ok()) {
+      return entry.status();
+    }
+    contents.remove_prefix(size);
+    catalog.entries_.push_back(*std::move(entry));
+  }
+
+  for (size_t i = 0; i < catalog.entries_.size(); ++i) {
+    const SegmentCatalogEntry& entry = catalog.entries_[i];
+    ParticipantIndex& participant = catalog.index_[entry.file_identifier];
+    TimeIndex& time_index = entry.kind == meet::MediaKind::kAudio
+                                ? participant.audio
+                                : participant.video;
+    time_index.entries.push_back(i);
+  }
+  for (auto& [file_identifier, participant] : catalog.index_) {
+    for (TimeIndex* time_index : {&participant.audio, &participant.video}) {
+      // Segments are appended as they close, so a participant's segments are
+      // usually already in order.
+      std::stable_sort(time_index->entries.begin(), time_index->entries.end(),
+                       [&catalog](size_t a, size_t b) {
+                         return catalog.entries_[a].first_frame_time <
+                                catalog.entries_[b].first_frame_time;
+                       });
+      time_index->max_last_frame_times.reserve(time_index->entries.size());
+      absl::Time max_last_frame_time = absl::InfinitePast();
+      for (size_t entry : time_index->entries) {
+        max_last_frame_time = std::max(
+            max_last_frame_time, catalog.entries_[entry].last_frame_time);
+        time_index->max_last_frame_times.push_back(max_last_frame_time);
+      }
+    }
+  }
+  return catalog;
+}
+
+std::vector<const SegmentCatalogEntry*> SegmentCatalog::Find(
+    absl::string_view file_identifier, meet::MediaKind kind, absl::Time start,
+    absl::Time end) const {
+  std::vector<const SegmentCatalogEntry*> segments;
+  auto participant_it = index_.find(file_identifier);
+  if (participant_it == index_.end()) {
+    return segments;
+  }
+  const TimeIndex& time_index = kind == meet::MediaKind::kAudio
+                                    ? participant_it->second.audio
+                                    : participant_it->second.video;
+  // Segments before `first` all ended before `start`.
+  size_t first = std::partition_point(time_index.max_last_frame_times.begin(),
+                                      time_index.max_last_frame_times.end(),
+                                      [start](absl::Time max_last_frame_time) {
+                                        return max_last_frame_time < start;
+                                      }) -
+                 time_index.max_last_frame_times.begin();
+  for (size_t i = first; i < time_index.entries.size(); ++i) {
+    const SegmentCatalogEntry& entry = entries_[time_index.entries[i]];
+    if (entry.first_frame_time > end) {
+      break;
+    }
+    if (entry.last_frame_time >= start) {
+      segments.push_back(&entry);
+    }
+  }
+  return segments;
+}
+
+}  // namespace media_api_samples
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_SEGMENT_CATALOG_H_
+#define CPP_SAMPLES_SEGMENT_CATALOG_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+
+// Segment catalogs list the segments that a collector has finished writing,
+// so that downstream jobs can find a participant's segments for a time range
+// without listing the output directory and parsing file names.
+//
+// A catalog starts with a header:
+//   "MEETSEGS" | uint32 version
+// followed by an append-only sequence of records, one per segment, appended
+// as segments finish closing:
+//   uint32 size | uint8 kind | int64 first frame time | int64 last frame time |
+//   int32 width | int32 height | uint16 identifier size | identifier |
+//   file name
+// where `size` counts the bytes that follow it, times are microseconds since
+// the Unix epoch and the file name fills the rest of the record. Integers are
+// little-endian.
+struct SegmentCatalogEntry {
+  meet::MediaKind kind = meet::MediaKind::kAudio;
+  // The participant's output file identifier; see
+  // `ResourceManagerInterface::GetOutputFileIdentifier`.
+  std::string file_identifier;
+  // The finished segment's file name, including the output file prefix.
+  std::string file_name;
+  absl::Time first_frame_time;
+  absl::Time last_frame_time;
+  // The dimensions of the segment's frames. Zero for audio segments.
+  int width = 0;
+  int height = 0;
+
+  friend bool operator==(const SegmentCatalogEntry&,
+                         const SegmentCatalogEntry&) = default;
+};
+
+// Appends entries to a segment catalog.
+//
+// This class is thread-safe. Entries are written in the order in which they
+// are appended.
+class SegmentCatalogWriter {
+ public:
+  // Writes the catalog header to `writer`.
+  explicit SegmentCatalogWriter(std::unique_ptr<OutputWriterInterface> writer);
+
+  // SegmentCatalogWriter is neither copyable nor movable.
+  SegmentCatalogWriter(const SegmentCatalogWriter&) = delete;
+  SegmentCatalogWriter& operator=(const SegmentCatalogWriter&) = delete;
+
+  void Append(const SegmentCatalogEntry& entry);
+
+  // Closes the underlying writer, and invokes `on_closed` once all appended
+  // entries have been written. Entries appended after the catalog is closed
+  // are dropped.
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed);
+
+ private:
+  absl::Mutex mutex_;
+  std::unique_ptr<OutputWriterInterface> writer_ ABSL_GUARDED_BY(mutex_);
+};
+
+// The entries of a segment catalog, indexed by participant, kind and time.
+class SegmentCatalog {
+ public:
+  // Parses the catalog in `contents`. A truncated header or final record, as
+  // left by a collector that stopped while writing it, is ignored. Returns an
+  // error if the header is not a supported catalog header, or if a complete
+  // record is malformed.
+  static absl::StatusOr<SegmentCatalog> Parse(absl::string_view contents);
+
+  // Returns the entries in append order.
+  absl::Span<const SegmentCatalogEntry> entries() const { return entries_; }
+
+  // Returns the `kind` segments of `file_identifier` that overlap
+  // [`start`, `end`], ordered by first frame time.
+  std::vector<const SegmentCatalogEntry*> Find(
+      absl::string_view file_identifier, meet::MediaKind kind,
+      absl::Time start, absl::Time end) const;
+
+ private:
+  // The segments of one participant and kind.
+  struct TimeIndex {
+    // Indices into `entries_`, ordered by first frame time.
+    std::vector<size_t> entries;
+    // The latest last frame time of `entries[0..i]`, so that the first
+    // segment that may end after a given time can be binary searched even if
+    // segments overlap.
+    std::vector<absl::Time> max_last_frame_times;
+  };
+  struct ParticipantIndex {
+    TimeIndex audio;
+    TimeIndex video;
+  };
+
+  std::vector<SegmentCatalogEntry> entries_;
+  absl::flat_hash_map<std::string, ParticipantIndex> index_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_SEGMENT_CATALOG_H_
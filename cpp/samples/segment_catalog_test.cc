@@ -0,0 +1,248 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/segment_catalog.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/samples/testing/mock_output_writer.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Pointee;
+using ::testing::status::StatusIs;
+
+// Returns an output writer that appends everything written to it to
+// `catalog`.
+std::unique_ptr<MockOutputWriter> CreateCatalogOutput(std::string& catalog) {
+  auto writer = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .WillRepeatedly([&catalog](const char* content, std::streamsize size) {
+        catalog.append(content, size);
+      });
+  EXPECT_CALL(*writer, Close);
+  return writer;
+}
+
+// Returns the size of the catalog header.
+size_t HeaderSize() {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.CloseAsync([] {});
+  return contents.size();
+}
+
+SegmentCatalogEntry AudioSegment(std::string file_identifier, int start_seconds,
+                                 int end_seconds) {
+  return SegmentCatalogEntry{
+      .kind = meet::MediaKind::kAudio,
+      .file_identifier = file_identifier,
+      .file_name = absl::StrCat("audio_", file_identifier, "_", start_seconds,
+                                ".wav"),
+      .first_frame_time = absl::FromUnixSeconds(start_seconds),
+      .last_frame_time = absl::FromUnixSeconds(end_seconds),
+  };
+}
+
+TEST(SegmentCatalogTest, ParsesAppendedEntries) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  SegmentCatalogEntry audio = AudioSegment("alice", 10, 20);
+  SegmentCatalogEntry video = {
+      .kind = meet::MediaKind::kVideo,
+      .file_identifier = "bob",
+      .file_name = "video_bob_640x480.y4m",
+      .first_frame_time = absl::FromUnixMicros(1'700'000'000'123'456),
+      .last_frame_time = absl::FromUnixMicros(1'700'000'060'654'321),
+      .width = 640,
+      .height = 480,
+  };
+
+  writer.Append(audio);
+  writer.Append(video);
+  bool closed = false;
+  writer.CloseAsync([&closed] { closed = true; });
+
+  EXPECT_TRUE(closed);
+  absl::StatusOr<SegmentCatalog> catalog = SegmentCatalog::Parse(contents);
+  ASSERT_OK(catalog);
+  EXPECT_THAT(catalog->entries(), ElementsAre(audio, video));
+}
+
+TEST(SegmentCatalogTest, DropsEntriesAfterClose) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.CloseAsync([] {});
+
+  writer.Append(AudioSegment("alice", 10, 20));
+
+  EXPECT_EQ(contents.size(), HeaderSize());
+}
+
+TEST(SegmentCatalogTest, FindsOverlappingSegmentsOfParticipantAndKind) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.Append(AudioSegment("alice", 10, 20));
+  writer.Append(AudioSegment("bob", 15, 25));
+  writer.Append(AudioSegment("alice", 30, 40));
+  writer.Append(AudioSegment("alice", 50, 60));
+  // Appended out of order, as when another shard closes an earlier segment
+  // later.
+  writer.Append(AudioSegment("alice", 0, 5));
+  writer.CloseAsync([] {});
+  absl::StatusOr<SegmentCatalog> catalog = SegmentCatalog::Parse(contents);
+  ASSERT_OK(catalog);
+
+  EXPECT_THAT(
+      catalog->Find("alice", meet::MediaKind::kAudio, absl::FromUnixSeconds(4),
+                    absl::FromUnixSeconds(35)),
+      ElementsAre(Pointee(AudioSegment("alice", 0, 5)),
+                  Pointee(AudioSegment("alice", 10, 20)),
+                  Pointee(AudioSegment("alice", 30, 40))));
+  EXPECT_THAT(
+      catalog->Find("alice", meet::MediaKind::kAudio, absl::FromUnixSeconds(41),
+                    absl::FromUnixSeconds(49)),
+      ElementsAre());
+  EXPECT_THAT(
+      catalog->Find("alice", meet::MediaKind::kVideo, absl::FromUnixSeconds(0),
+                    absl::FromUnixSeconds(60)),
+      ElementsAre());
+  EXPECT_THAT(
+      catalog->Find("carol", meet::MediaKind::kAudio, absl::FromUnixSeconds(0),
+                    absl::FromUnixSeconds(60)),
+      ElementsAre());
+}
+
+TEST(SegmentCatalogTest, FindsSegmentsContainedInEarlierLongerSegment) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.Append(AudioSegment("alice", 0, 100));
+  writer.Append(AudioSegment("alice", 10, 20));
+  writer.Append(AudioSegment("alice", 30, 40));
+  writer.CloseAsync([] {});
+  absl::StatusOr<SegmentCatalog> catalog = SegmentCatalog::Parse(contents);
+  ASSERT_OK(catalog);
+
+  EXPECT_THAT(
+      catalog->Find("alice", meet::MediaKind::kAudio, absl::FromUnixSeconds(35),
+                    absl::FromUnixSeconds(50)),
+      ElementsAre(Pointee(AudioSegment("alice", 0, 100)),
+                  Pointee(AudioSegment("alice", 30, 40))));
+}
+
+TEST(SegmentCatalogTest, IgnoresTruncatedFinalRecord) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.Append(AudioSegment("alice", 10, 20));
+  writer.Append(AudioSegment("alice", 30, 40));
+  writer.CloseAsync([] {});
+  contents.resize(contents.size() - 3);
+
+  absl::StatusOr<SegmentCatalog> catalog = SegmentCatalog::Parse(contents);
+
+  ASSERT_OK(catalog);
+  EXPECT_THAT(catalog->entries(), ElementsAre(AudioSegment("alice", 10, 20)));
+}
+
+TEST(SegmentCatalogTest, ParseFailsWithMalformedRecord) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.Append(AudioSegment("alice", 10, 20));
+  writer.CloseAsync([] {});
+  // Corrupt the kind.
+  contents[HeaderSize() + sizeof(uint32_t)] = 7;
+
+  EXPECT_THAT(SegmentCatalog::Parse(contents),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(SegmentCatalogTest, WritesLittleEndianHeaderAndRecords) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.Append({.kind = meet::MediaKind::kVideo,
+                 .file_identifier = "a",
+                 .file_name = "b",
+                 .first_frame_time = absl::FromUnixMicros(0x0102),
+                 .last_frame_time = absl::FromUnixMicros(0x0304),
+                 .width = 0x0506,
+                 .height = 0x0708});
+  writer.CloseAsync([] {});
+
+  EXPECT_EQ(contents, std::string("MEETSEGS\x01\0\0\0"
+                                  "\x1d\0\0\0"
+                                  "\x01"
+                                  "\x02\x01\0\0\0\0\0\0"
+                                  "\x04\x03\0\0\0\0\0\0"
+                                  "\x06\x05\0\0"
+                                  "\x08\x07\0\0"
+                                  "\x01\0"
+                                  "ab",
+                                  HeaderSize() + 33));
+}
+
+TEST(SegmentCatalogTest, ParsesTruncatedHeaderAsEmptyCatalog) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.CloseAsync([] {});
+
+  for (size_t size = 0; size < contents.size(); ++size) {
+    absl::StatusOr<SegmentCatalog> catalog =
+        SegmentCatalog::Parse(absl::string_view(contents).substr(0, size));
+    ASSERT_OK(catalog);
+    EXPECT_THAT(catalog->entries(), ElementsAre());
+  }
+}
+
+TEST(SegmentCatalogTest, ParseFailsWithoutCatalogHeader) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.Append(AudioSegment("alice", 10, 20));
+  writer.CloseAsync([] {});
+  contents[0] = 'X';
+
+  EXPECT_THAT(SegmentCatalog::Parse(contents),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SegmentCatalogTest, ParseFailsWithUnsupportedVersion) {
+  std::string contents;
+  SegmentCatalogWriter writer(CreateCatalogOutput(contents));
+  writer.Append(AudioSegment("alice", 10, 20));
+  writer.CloseAsync([] {});
+  // Corrupt the version.
+  contents[HeaderSize() - sizeof(uint32_t)] = 2;
+
+  EXPECT_THAT(SegmentCatalog::Parse(contents),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace media_api_samples
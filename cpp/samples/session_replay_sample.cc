@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Replays a session trace recorded by multi_user_media_sample through a
+// `MultiUserMediaCollector`, so that collectors and output writers can be
+// profiled and load tested without a real conference.
+
+#include <cstdlib>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "cpp/samples/multi_user_media_collector.h"
+#include "cpp/samples/session_trace.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/rtc_base/thread.h"
+
+ABSL_FLAG(std::string, session_trace_file, "",
+          "The session trace to replay, as recorded by "
+          "multi_user_media_sample's --session_trace_file flag.");
+
+ABSL_FLAG(std::string, output_file_prefix, "/tmp/replay_output_",
+          "The prefix of the files written by the collector.");
+
+ABSL_FLAG(bool, real_time, false,
+          "Whether to replay the trace at the speed it was recorded at, "
+          "instead of as fast as possible.");
+
+ABSL_FLAG(absl::Duration, segment_gap_threshold, absl::Seconds(1),
+          "The gap between frames after which a new media segment is "
+          "started.");
+
+ABSL_FLAG(int, collector_shard_count, 0,
+          "The number of threads to write media on. If zero, media is "
+          "written on the collector thread.");
+
+int main(int argc, char** argv) {
+  absl::SetProgramUsageMessage(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  std::string trace_file_name = absl::GetFlag(FLAGS_session_trace_file);
+  if (trace_file_name.empty()) {
+    LOG(ERROR) << "Session trace file is empty";
+    return EXIT_FAILURE;
+  }
+  std::ifstream trace_file(trace_file_name, std::ios::binary);
+  if (!trace_file.is_open()) {
+    LOG(ERROR) << "Failed to open session trace file: " << trace_file_name;
+    return EXIT_FAILURE;
+  }
+  std::string trace((std::istreambuf_iterator<char>(trace_file)),
+                    std::istreambuf_iterator<char>());
+
+  std::unique_ptr<rtc::Thread> collector_thread = rtc::Thread::Create();
+  collector_thread->SetName("collector_thread", nullptr);
+  if (!collector_thread->Start()) {
+    LOG(ERROR) << "Failed to start collector thread";
+    return EXIT_FAILURE;
+  }
+  std::vector<std::unique_ptr<rtc::Thread>> shard_threads;
+  for (int i = 0; i < absl::GetFlag(FLAGS_collector_shard_count); ++i) {
+    std::unique_ptr<rtc::Thread> shard_thread = rtc::Thread::Create();
+    shard_thread->SetName(absl::StrCat("collector_shard_thread_", i), nullptr);
+    if (!shard_thread->Start()) {
+      LOG(ERROR) << "Failed to start collector shard thread";
+      return EXIT_FAILURE;
+    }
+    shard_threads.push_back(std::move(shard_thread));
+  }
+  auto media_collector =
+      webrtc::make_ref_counted<media_api_samples::MultiUserMediaCollector>(
+          absl::GetFlag(FLAGS_output_file_prefix),
+          absl::GetFlag(FLAGS_segment_gap_threshold),
+          std::move(collector_thread), std::move(shard_threads));
+
+  absl::Time replay_start = absl::Now();
+  absl::Status replay_status = media_api_samples::ReplaySessionTrace(
+      trace, *media_collector,
+      {.real_time = absl::GetFlag(FLAGS_real_time),
+       .disconnect_at_end = true});
+  if (!replay_status.ok()) {
+    LOG(ERROR) << "Failed to replay session trace: " << replay_status;
+  }
+  if (absl::Status disconnect_status =
+          media_collector->WaitForDisconnected(absl::Minutes(1));
+      !disconnect_status.ok()) {
+    LOG(ERROR) << "Failed to finish writing media: " << disconnect_status;
+    return EXIT_FAILURE;
+  }
+  LOG(INFO) << "Replayed " << trace.size() << " bytes of session trace in "
+            << absl::Now() - replay_start;
+  return replay_status.ok() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,473 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/session_trace.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/media_entries_resource_handler.h"
+#include "cpp/internal/media_stats_resource_handler.h"
+#include "cpp/internal/participants_resource_handler.h"
+#include "cpp/internal/resource_handler_interface.h"
+#include "cpp/internal/session_control_resource_handler.h"
+#include "cpp/internal/video_assignment_resource_handler.h"
+#include "cpp/samples/little_endian.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+
+namespace media_api_samples {
+namespace {
+
+constexpr absl::string_view kMagic = "MEETTRAC";
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = kMagic.size() + sizeof(uint32_t);
+constexpr size_t kRecordHeaderSize =
+    sizeof(uint8_t) + sizeof(int64_t) + sizeof(uint32_t);
+constexpr size_t kAudioFrameMetadataSize =
+    4 * sizeof(int32_t) + sizeof(uint8_t);
+constexpr size_t kVideoFrameMetadataSize = 4 * sizeof(int32_t);
+
+// Appends the rows of a plane to `chunks`, without their stride padding.
+void AppendPlaneRows(const uint8_t* data, int stride, int width, int height,
+                     std::vector<OutputWriterInterface::Chunk>& chunks) {
+  if (stride == width) {
+    chunks.push_back({.content = reinterpret_cast<const char*>(data),
+                      .size = static_cast<std::streamsize>(width) * height});
+    return;
+  }
+  for (int row = 0; row < height; ++row) {
+    chunks.push_back(
+        {.content = reinterpret_cast<const char*>(data + row * stride),
+         .size = width});
+  }
+}
+
+absl::Time ReceiveTimeOrNow(absl::Time receive_time) {
+  return receive_time == absl::InfinitePast() ? absl::Now() : receive_time;
+}
+
+using ResourceHandlers =
+    absl::flat_hash_map<std::string,
+                        std::unique_ptr<meet::ResourceHandlerInterface>>;
+
+// Returns the resource handlers keyed by the label of the data channel whose
+// messages they parse.
+ResourceHandlers CreateResourceHandlers() {
+  ResourceHandlers handlers;
+  handlers["media-entries"] =
+      std::make_unique<meet::MediaEntriesResourceHandler>();
+  handlers["media-stats"] = std::make_unique<meet::MediaStatsResourceHandler>();
+  handlers["participants"] =
+      std::make_unique<meet::ParticipantsResourceHandler>();
+  handlers["session-control"] =
+      std::make_unique<meet::SessionControlResourceHandler>();
+  handlers["video-assignment"] =
+      std::make_unique<meet::VideoAssignmentResourceHandler>();
+  return handlers;
+}
+
+absl::Status ReplayDataChannelMessage(
+    absl::string_view payload, const ResourceHandlers& handlers,
+    meet::MediaApiClientObserverInterface& observer) {
+  uint16_t label_size;
+  if (!TakeLittleEndian(payload, label_size) || payload.size() < label_size) {
+    return absl::DataLossError("Malformed data channel message record.");
+  }
+  absl::string_view label = payload.substr(0, label_size);
+  absl::string_view message = payload.substr(label_size);
+
+  auto handler_it = handlers.find(label);
+  if (handler_it == handlers.end()) {
+    LOG(WARNING) << "Skipping message from unknown data channel: " << label;
+    return absl::OkStatus();
+  }
+  absl::StatusOr<meet::ResourceUpdate> update =
+      handler_it->second->ParseUpdate(message);
+  if (!update.ok()) {
+    LOG(ERROR) << "Replayed " << label
+               << " resource update failed to parse: " << update.status();
+    return absl::OkStatus();
+  }
+  observer.OnResourceUpdate(*std::move(update));
+  return absl::OkStatus();
+}
+
+absl::Status ReplayAudioFrame(absl::string_view payload,
+                              meet::MediaApiClientObserverInterface& observer) {
+  int32_t sample_rate;
+  int32_t channel_count;
+  uint32_t contributing_source;
+  uint32_t synchronization_source;
+  uint8_t is_from_loudest_speaker;
+  if (!TakeLittleEndian(payload, sample_rate) ||
+      !TakeLittleEndian(payload, channel_count) ||
+      !TakeLittleEndian(payload, contributing_source) ||
+      !TakeLittleEndian(payload, synchronization_source) ||
+      !TakeLittleEndian(payload, is_from_loudest_speaker) ||
+      channel_count <= 0 ||
+      payload.size() % (sizeof(int16_t) * channel_count) != 0) {
+    return absl::DataLossError("Malformed audio frame record.");
+  }
+
+  // The payload is not necessarily aligned for `int16_t`, so the samples are
+  // copied out of it.
+  std::vector<int16_t> pcm16(payload.size() / sizeof(int16_t));
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(pcm16.data(), payload.data(), payload.size());
+  } else {
+    for (int16_t& sample : pcm16) {
+      TakeLittleEndian(payload, sample);
+    }
+  }
+  observer.OnAudioFrame(meet::AudioFrame{
+      .pcm16 = pcm16,
+      .bits_per_sample = 16,
+      .sample_rate = sample_rate,
+      .number_of_channels = static_cast<size_t>(channel_count),
+      .number_of_frames = pcm16.size() / channel_count,
+      .is_from_loudest_speaker = is_from_loudest_speaker != 0,
+      .contributing_source = contributing_source,
+      .synchronization_source = synchronization_source,
+      .receive_time = absl::Now()});
+  return absl::OkStatus();
+}
+
+absl::Status ReplayVideoFrame(absl::string_view payload,
+                              meet::MediaApiClientObserverInterface& observer) {
+  int32_t width;
+  int32_t height;
+  uint32_t contributing_source;
+  uint32_t synchronization_source;
+  if (!TakeLittleEndian(payload, width) || !TakeLittleEndian(payload, height) ||
+      !TakeLittleEndian(payload, contributing_source) ||
+      !TakeLittleEndian(payload, synchronization_source) || width <= 0 ||
+      height <= 0) {
+    return absl::DataLossError("Malformed video frame record.");
+  }
+  int chroma_width = (width + 1) / 2;
+  int chroma_height = (height + 1) / 2;
+  size_t luma_size = static_cast<size_t>(width) * height;
+  size_t chroma_size = static_cast<size_t>(chroma_width) * chroma_height;
+  if (payload.size() != luma_size + 2 * chroma_size) {
+    return absl::DataLossError("Malformed video frame record.");
+  }
+
+  const uint8_t* data_y = reinterpret_cast<const uint8_t*>(payload.data());
+  const uint8_t* data_u = data_y + luma_size;
+  const uint8_t* data_v = data_u + chroma_size;
+  webrtc::VideoFrame frame =
+      webrtc::VideoFrame::Builder()
+          .set_video_frame_buffer(webrtc::I420Buffer::Copy(
+              width, height, data_y, width, data_u, chroma_width, data_v,
+              chroma_width))
+          .build();
+  observer.OnVideoFrame(
+      meet::VideoFrame{.frame = frame,
+                       .contributing_source = contributing_source,
+                       .synchronization_source = synchronization_source,
+                       .receive_time = absl::Now()});
+  return absl::OkStatus();
+}
+
+absl::Status ReplayRecord(SessionTraceRecordType type,
+                          absl::string_view payload,
+                          const ResourceHandlers& handlers,
+                          meet::MediaApiClientObserverInterface& observer) {
+  switch (type) {
+    case SessionTraceRecordType::kJoined:
+      observer.OnJoined();
+      return absl::OkStatus();
+    case SessionTraceRecordType::kDisconnected: {
+      int32_t code;
+      if (!TakeLittleEndian(payload, code)) {
+        return absl::DataLossError("Malformed disconnected record.");
+      }
+      observer.OnDisconnected(
+          absl::Status(static_cast<absl::StatusCode>(code), payload));
+      return absl::OkStatus();
+    }
+    case SessionTraceRecordType::kDataChannelMessage:
+      return ReplayDataChannelMessage(payload, handlers, observer);
+    case SessionTraceRecordType::kAudioFrame:
+      return ReplayAudioFrame(payload, observer);
+    case SessionTraceRecordType::kVideoFrame:
+      return ReplayVideoFrame(payload, observer);
+  }
+  LOG(WARNING) << "Skipping session trace record of unknown type: "
+               << static_cast<int>(type);
+  return absl::OkStatus();
+}
+
+absl::Status ReplayRecords(absl::string_view trace,
+                           meet::MediaApiClientObserverInterface& observer,
+                           SessionReplayOptions options, bool& disconnected) {
+  if (!absl::StartsWith(kMagic, trace.substr(0, kMagic.size()))) {
+    return absl::InvalidArgumentError("Not a session trace.");
+  }
+  if (trace.size() < kHeaderSize) {
+    // The recording stopped while writing the header.
+    return absl::OkStatus();
+  }
+  trace.remove_prefix(kMagic.size());
+  uint32_t version;
+  TakeLittleEndian(trace, version);
+  if (version != kVersion) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unsupported session trace version: ", version));
+  }
+
+  ResourceHandlers handlers = CreateResourceHandlers();
+  absl::Time replay_start = absl::Now();
+  while (!trace.empty()) {
+    uint8_t type;
+    int64_t time_us;
+    uint32_t payload_size;
+    if (!TakeLittleEndian(trace, type) || !TakeLittleEndian(trace, time_us) ||
+        !TakeLittleEndian(trace, payload_size) || trace.size() < payload_size) {
+      return absl::DataLossError("Session trace is truncated.");
+    }
+    absl::string_view payload = trace.substr(0, payload_size);
+    trace.remove_prefix(payload_size);
+
+    if (options.real_time) {
+      absl::Duration wait =
+          replay_start + absl::Microseconds(time_us) - absl::Now();
+      if (wait > absl::ZeroDuration()) {
+        absl::SleepFor(wait);
+      }
+    }
+    auto record_type = static_cast<SessionTraceRecordType>(type);
+    if (absl::Status status =
+            ReplayRecord(record_type, payload, handlers, observer);
+        !status.ok()) {
+      return status;
+    }
+    if (record_type == SessionTraceRecordType::kDisconnected) {
+      disconnected = true;
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+SessionTraceWriter::SessionTraceWriter(
+    std::unique_ptr<OutputWriterInterface> writer, absl::Time start_time)
+    : writer_(std::move(writer)), start_time_(start_time) {
+  char header[kHeaderSize];
+  kMagic.copy(header, kMagic.size());
+  PutLittleEndian(header, kMagic.size(), kVersion);
+  writer_->Write(header, sizeof(header));
+}
+
+void SessionTraceWriter::OnDataChannelMessage(absl::string_view label,
+                                              absl::string_view message) {
+  char label_size[sizeof(uint16_t)];
+  PutLittleEndian(label_size, 0, static_cast<uint16_t>(label.size()));
+  OutputWriterInterface::Chunk payload[] = {
+      {.content = label_size, .size = sizeof(label_size)},
+      {.content = label.data(),
+       .size = static_cast<std::streamsize>(label.size())},
+      {.content = message.data(),
+       .size = static_cast<std::streamsize>(message.size())}};
+  WriteRecord(SessionTraceRecordType::kDataChannelMessage, absl::Now(),
+              payload);
+}
+
+void SessionTraceWriter::WriteJoined() {
+  WriteRecord(SessionTraceRecordType::kJoined, absl::Now(), {});
+}
+
+void SessionTraceWriter::WriteDisconnected(const absl::Status& status) {
+  char code[sizeof(int32_t)];
+  PutLittleEndian(code, 0, static_cast<int32_t>(status.code()));
+  OutputWriterInterface::Chunk payload[] = {
+      {.content = code, .size = sizeof(code)},
+      {.content = status.message().data(),
+       .size = static_cast<std::streamsize>(status.message().size())}};
+  WriteRecord(SessionTraceRecordType::kDisconnected, absl::Now(), payload);
+}
+
+void SessionTraceWriter::WriteAudioFrame(const meet::AudioFrame& frame) {
+  char metadata[kAudioFrameMetadataSize];
+  size_t offset =
+      PutLittleEndian(metadata, 0, static_cast<int32_t>(frame.sample_rate));
+  offset = PutLittleEndian(metadata, offset,
+                           static_cast<int32_t>(frame.number_of_channels));
+  offset = PutLittleEndian(metadata, offset, frame.contributing_source);
+  offset = PutLittleEndian(metadata, offset, frame.synchronization_source);
+  PutLittleEndian(metadata, offset,
+                  static_cast<uint8_t>(frame.is_from_loudest_speaker));
+  absl::Span<const int16_t> pcm16 =
+      frame.buffer != nullptr ? frame.buffer->pcm16() : frame.pcm16;
+  const char* samples = reinterpret_cast<const char*>(pcm16.data());
+  // Samples are written in place on little-endian hosts, and byte-swapped into
+  // a copy otherwise.
+  std::vector<char> swapped_samples;
+  if constexpr (std::endian::native != std::endian::little) {
+    swapped_samples.resize(pcm16.size() * sizeof(int16_t));
+    for (size_t i = 0; i < pcm16.size(); ++i) {
+      PutLittleEndian(swapped_samples.data(), i * sizeof(int16_t), pcm16[i]);
+    }
+    samples = swapped_samples.data();
+  }
+  OutputWriterInterface::Chunk payload[] = {
+      {.content = metadata, .size = sizeof(metadata)},
+      {.content = samples,
+       .size = static_cast<std::streamsize>(pcm16.size() * sizeof(int16_t))}};
+  WriteRecord(SessionTraceRecordType::kAudioFrame,
+              ReceiveTimeOrNow(frame.receive_time), payload);
+}
+
+bool SessionTraceWriter::WriteVideoFrame(const meet::VideoFrame& frame) {
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+      frame.frame.video_frame_buffer()->ToI420();
+  if (i420 == nullptr) {
+    return false;
+  }
+  char metadata[kVideoFrameMetadataSize];
+  size_t offset =
+      PutLittleEndian(metadata, 0, static_cast<int32_t>(i420->width()));
+  offset =
+      PutLittleEndian(metadata, offset, static_cast<int32_t>(i420->height()));
+  offset = PutLittleEndian(metadata, offset, frame.contributing_source);
+  PutLittleEndian(metadata, offset, frame.synchronization_source);
+
+  std::vector<OutputWriterInterface::Chunk> payload = {
+      {.content = metadata, .size = sizeof(metadata)}};
+  int chroma_width = (i420->width() + 1) / 2;
+  int chroma_height = (i420->height() + 1) / 2;
+  AppendPlaneRows(i420->DataY(), i420->StrideY(), i420->width(),
+                  i420->height(), payload);
+  AppendPlaneRows(i420->DataU(), i420->StrideU(), chroma_width, chroma_height,
+                  payload);
+  AppendPlaneRows(i420->DataV(), i420->StrideV(), chroma_width, chroma_height,
+                  payload);
+  WriteRecord(SessionTraceRecordType::kVideoFrame,
+              ReceiveTimeOrNow(frame.receive_time), payload);
+  return true;
+}
+
+void SessionTraceWriter::Close() {
+  absl::MutexLock lock(&mutex_);
+  if (writer_ == nullptr) {
+    return;
+  }
+  writer_->Close();
+  writer_ = nullptr;
+}
+
+void SessionTraceWriter::WriteRecord(
+    SessionTraceRecordType type, absl::Time time,
+    absl::Span<const OutputWriterInterface::Chunk> payload) {
+  uint32_t payload_size = 0;
+  for (const OutputWriterInterface::Chunk& chunk : payload) {
+    payload_size += static_cast<uint32_t>(chunk.size);
+  }
+  char header[kRecordHeaderSize];
+  size_t offset = PutLittleEndian(header, 0, static_cast<uint8_t>(type));
+  offset = PutLittleEndian(header, offset,
+                           absl::ToInt64Microseconds(time - start_time_));
+  PutLittleEndian(header, offset, payload_size);
+
+  std::vector<OutputWriterInterface::Chunk> chunks;
+  chunks.reserve(payload.size() + 1);
+  chunks.push_back({.content = header, .size = sizeof(header)});
+  chunks.insert(chunks.end(), payload.begin(), payload.end());
+
+  absl::MutexLock lock(&mutex_);
+  if (writer_ == nullptr) {
+    return;
+  }
+  writer_->WriteVectored(chunks);
+}
+
+void SessionRecordingObserver::OnJoined() {
+  trace_writer_->WriteJoined();
+  observer_->OnJoined();
+}
+
+void SessionRecordingObserver::OnJoined(const meet::JoinTimings& timings) {
+  trace_writer_->WriteJoined();
+  observer_->OnJoined(timings);
+}
+
+void SessionRecordingObserver::OnDisconnected(absl::Status status) {
+  trace_writer_->WriteDisconnected(status);
+  observer_->OnDisconnected(std::move(status));
+}
+
+void SessionRecordingObserver::OnResourceUpdate(meet::ResourceUpdate update) {
+  observer_->OnResourceUpdate(std::move(update));
+}
+
+void SessionRecordingObserver::OnAudioFrame(meet::AudioFrame frame) {
+  trace_writer_->WriteAudioFrame(frame);
+  observer_->OnAudioFrame(std::move(frame));
+}
+
+void SessionRecordingObserver::OnEncodedAudioFrame(
+    meet::EncodedAudioFrame frame) {
+  observer_->OnEncodedAudioFrame(std::move(frame));
+}
+
+void SessionRecordingObserver::OnVideoFrame(meet::VideoFrame frame) {
+  if (!trace_writer_->WriteVideoFrame(frame)) {
+    LOG(ERROR) << "Failed to convert video frame buffer to I420.";
+  }
+  observer_->OnVideoFrame(std::move(frame));
+}
+
+void SessionRecordingObserver::OnEncodedVideoFrame(
+    meet::EncodedVideoFrame frame) {
+  observer_->OnEncodedVideoFrame(std::move(frame));
+}
+
+absl::Status ReplaySessionTrace(absl::string_view trace,
+                                meet::MediaApiClientObserverInterface& observer,
+                                SessionReplayOptions options) {
+  bool disconnected = false;
+  absl::Status status = ReplayRecords(trace, observer, options, disconnected);
+  if (options.disconnect_at_end && !disconnected) {
+    observer.OnDisconnected(status);
+  }
+  return status;
+}
+
+}  // namespace media_api_samples
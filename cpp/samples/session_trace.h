@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_SESSION_TRACE_H_
+#define CPP_SAMPLES_SESSION_TRACE_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "webrtc/api/scoped_refptr.h"
+
+namespace media_api_samples {
+
+// Session traces capture what a Media API client received during a session,
+// so that the session can be replayed offline, e.g. to load test collectors
+// and output writers without a real conference.
+//
+// A trace starts with a header:
+//   "MEETTRAC" | uint32 version
+// followed by a sequence of records. Each record starts with a 13 byte header:
+//   uint8 type | int64 microseconds since the trace started | uint32 size
+// followed by `size` bytes of payload. Integers, including PCM16 samples, are
+// little-endian, so traces can be replayed on any host.
+//
+// Resource updates are captured as the raw data channel messages that they
+// are parsed from, so replaying a trace exercises the client's parsers too.
+// Decoded audio and video frames are captured in full, as interleaved PCM16
+// samples and tightly packed I420 planes respectively. Encoded frames are not
+// captured.
+enum class SessionTraceRecordType : uint8_t {
+  kJoined = 1,
+  // Payload: int32 status code | message.
+  kDisconnected = 2,
+  // Payload: uint16 label size | label | message.
+  kDataChannelMessage = 3,
+  // Payload: int32 sample rate | int32 channel count | uint32 CSRC |
+  //   uint32 SSRC | uint8 is from loudest speaker | PCM16 samples.
+  kAudioFrame = 4,
+  // Payload: int32 width | int32 height | uint32 CSRC | uint32 SSRC |
+  //   Y plane | U plane | V plane.
+  kVideoFrame = 5,
+};
+
+// Writes session trace records to an output writer.
+//
+// This class is thread-safe. Records are written in the order in which they
+// are submitted.
+class SessionTraceWriter : public meet::DataChannelMessageRecorderInterface {
+ public:
+  // Writes the trace header to `writer`. Record times are relative to
+  // `start_time`.
+  explicit SessionTraceWriter(std::unique_ptr<OutputWriterInterface> writer,
+                              absl::Time start_time = absl::Now());
+
+  // SessionTraceWriter is neither copyable nor movable.
+  SessionTraceWriter(const SessionTraceWriter&) = delete;
+  SessionTraceWriter& operator=(const SessionTraceWriter&) = delete;
+
+  void OnDataChannelMessage(absl::string_view label,
+                            absl::string_view message) override;
+
+  void WriteJoined();
+  void WriteDisconnected(const absl::Status& status);
+  void WriteAudioFrame(const meet::AudioFrame& frame);
+  // Returns false if the frame's buffer could not be converted to I420.
+  bool WriteVideoFrame(const meet::VideoFrame& frame);
+
+  // Closes the underlying writer. Records written after the trace is closed
+  // are dropped.
+  void Close();
+
+ private:
+  void WriteRecord(SessionTraceRecordType type, absl::Time time,
+                   absl::Span<const OutputWriterInterface::Chunk> payload);
+
+  absl::Mutex mutex_;
+  std::unique_ptr<OutputWriterInterface> writer_ ABSL_GUARDED_BY(mutex_);
+  const absl::Time start_time_;
+};
+
+// An observer that records the callbacks it receives to a session trace, and
+// then forwards them to another observer.
+//
+// Resource updates are forwarded but not recorded by this observer; they are
+// recorded as data channel messages instead, by configuring the trace writer
+// as the client's `data_channel_message_recorder`.
+class SessionRecordingObserver : public meet::MediaApiClientObserverInterface {
+ public:
+  SessionRecordingObserver(
+      std::shared_ptr<SessionTraceWriter> trace_writer,
+      rtc::scoped_refptr<meet::MediaApiClientObserverInterface> observer)
+      : trace_writer_(std::move(trace_writer)),
+        observer_(std::move(observer)) {}
+
+  void OnJoined() override;
+  void OnJoined(const meet::JoinTimings& timings) override;
+  void OnDisconnected(absl::Status status) override;
+  void OnResourceUpdate(meet::ResourceUpdate update) override;
+  void OnAudioFrame(meet::AudioFrame frame) override;
+  void OnEncodedAudioFrame(meet::EncodedAudioFrame frame) override;
+  void OnVideoFrame(meet::VideoFrame frame) override;
+  void OnEncodedVideoFrame(meet::EncodedVideoFrame frame) override;
+
+ private:
+  std::shared_ptr<SessionTraceWriter> trace_writer_;
+  rtc::scoped_refptr<meet::MediaApiClientObserverInterface> observer_;
+};
+
+struct SessionReplayOptions {
+  // If true, records are replayed with the same spacing as they were recorded
+  // with. Otherwise, they are replayed as fast as possible.
+  bool real_time = false;
+  // If true, `OnDisconnected` is invoked once the trace has been replayed if
+  // the trace did not record a disconnection, so that observers always finish
+  // the session. If the trace is malformed, the observer is disconnected with
+  // the replay error.
+  bool disconnect_at_end = false;
+};
+
+// Replays the session trace in `trace` through `observer`, on the calling
+// thread.
+//
+// Data channel messages are parsed into resource updates with the client's
+// resource handlers. Messages that fail to parse are logged and skipped, like
+// the client does. Frames are delivered with their replay time as their
+// receive time.
+//
+// Returns an error if the trace is malformed; records before the malformed
+// record have been replayed by then. Traces without a header, or with an
+// unsupported version, are rejected before anything is replayed.
+absl::Status ReplaySessionTrace(absl::string_view trace,
+                                meet::MediaApiClientObserverInterface& observer,
+                                SessionReplayOptions options = {});
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_SESSION_TRACE_H_
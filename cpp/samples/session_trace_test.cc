@@ -0,0 +1,290 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/session_trace.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/api/session_control_resource.h"
+#include "cpp/internal/testing/mock_media_api_client_observer.h"
+#include "cpp/samples/testing/mock_output_writer.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::status::StatusIs;
+
+// Returns an output writer that appends everything written to it to `trace`.
+std::unique_ptr<MockOutputWriter> CreateTraceOutput(std::string& trace) {
+  auto writer = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .WillRepeatedly([&trace](const char* content, std::streamsize size) {
+        trace.append(content, size);
+      });
+  EXPECT_CALL(*writer, Close);
+  return writer;
+}
+
+TEST(SessionTraceTest, ReplaysRecordedSession) {
+  std::string trace;
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace));
+  trace_writer.WriteJoined();
+  trace_writer.OnDataChannelMessage("session-control", R"json({
+    "resources": [
+      { "sessionStatus": { "connectionState": "STATE_JOINED" } }
+    ]
+  })json");
+  std::vector<int16_t> pcm16 = {1, -2, 3, -4};
+  trace_writer.WriteAudioFrame(
+      meet::AudioFrame{.pcm16 = pcm16,
+                       .bits_per_sample = 16,
+                       .sample_rate = 48000,
+                       .number_of_channels = 2,
+                       .number_of_frames = 2,
+                       .is_from_loudest_speaker = true,
+                       .contributing_source = 123,
+                       .synchronization_source = 456});
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(3, 3);
+  buffer->MutableDataY()[4] = 42;
+  webrtc::VideoFrame video_frame =
+      webrtc::VideoFrame::Builder().set_video_frame_buffer(buffer).build();
+  ASSERT_TRUE(trace_writer.WriteVideoFrame(
+      meet::VideoFrame{.frame = video_frame,
+                       .contributing_source = 789,
+                       .synchronization_source = 1011}));
+  trace_writer.WriteDisconnected(absl::InternalError("test error"));
+  trace_writer.Close();
+
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  ::testing::InSequence sequence;
+  EXPECT_CALL(*observer, OnJoined());
+  EXPECT_CALL(*observer, OnResourceUpdate)
+      .WillOnce([](meet::ResourceUpdate update) {
+        ASSERT_TRUE(
+            std::holds_alternative<meet::SessionControlChannelToClient>(
+                update));
+        EXPECT_EQ(std::get<meet::SessionControlChannelToClient>(update)
+                      .resources[0]
+                      .session_status.connection_state,
+                  meet::SessionStatus::ConferenceConnectionState::kJoined);
+      });
+  EXPECT_CALL(*observer, OnAudioFrame).WillOnce([](meet::AudioFrame frame) {
+    EXPECT_THAT(frame.pcm16, ElementsAre(1, -2, 3, -4));
+    EXPECT_EQ(frame.sample_rate, 48000);
+    EXPECT_EQ(frame.number_of_channels, 2);
+    EXPECT_EQ(frame.number_of_frames, 2);
+    EXPECT_TRUE(frame.is_from_loudest_speaker);
+    EXPECT_EQ(frame.contributing_source, 123);
+    EXPECT_EQ(frame.synchronization_source, 456);
+  });
+  EXPECT_CALL(*observer, OnVideoFrame).WillOnce([](meet::VideoFrame frame) {
+    rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+        frame.frame.video_frame_buffer()->ToI420();
+    EXPECT_EQ(i420->width(), 3);
+    EXPECT_EQ(i420->height(), 3);
+    EXPECT_EQ(i420->DataY()[4], 42);
+    EXPECT_EQ(frame.contributing_source, 789);
+    EXPECT_EQ(frame.synchronization_source, 1011);
+  });
+  EXPECT_CALL(*observer, OnDisconnected(StatusIs(absl::StatusCode::kInternal,
+                                                 "test error")));
+
+  EXPECT_OK(ReplaySessionTrace(trace, *observer));
+}
+
+TEST(SessionTraceTest, DropsRecordsAfterClose) {
+  std::string trace;
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace));
+  size_t header_size = trace.size();
+  trace_writer.Close();
+
+  trace_writer.WriteJoined();
+
+  EXPECT_EQ(trace.size(), header_size);
+}
+
+TEST(SessionTraceTest, WritesLittleEndianHeaderAndRecords) {
+  std::string trace;
+  absl::Time start_time = absl::Now();
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace), start_time);
+  std::vector<int16_t> pcm16 = {0x0102};
+  absl::Time receive_time = start_time + absl::Microseconds(0x090a);
+  trace_writer.WriteAudioFrame(
+      meet::AudioFrame{.pcm16 = pcm16,
+                       .bits_per_sample = 16,
+                       .sample_rate = 0x0304,
+                       .number_of_channels = 1,
+                       .number_of_frames = 1,
+                       .is_from_loudest_speaker = false,
+                       .contributing_source = 0x0506,
+                       .synchronization_source = 0x0708,
+                       .receive_time = receive_time});
+  trace_writer.Close();
+
+  EXPECT_EQ(trace, std::string("MEETTRAC\x01\0\0\0"
+                               "\x04"
+                               "\x0a\x09\0\0\0\0\0\0"
+                               "\x13\0\0\0"
+                               "\x04\x03\0\0"
+                               "\x01\0\0\0"
+                               "\x06\x05\0\0"
+                               "\x08\x07\0\0"
+                               "\0"
+                               "\x02\x01",
+                               44));
+}
+
+TEST(SessionTraceTest, ReplaysTruncatedHeaderAsEmptyTrace) {
+  std::string trace;
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace));
+  trace_writer.Close();
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+
+  for (size_t size = 0; size < trace.size(); ++size) {
+    absl::string_view header = absl::string_view(trace).substr(0, size);
+    EXPECT_OK(ReplaySessionTrace(header, *observer));
+  }
+}
+
+TEST(SessionTraceTest, ReplayFailsWithoutTraceHeader) {
+  std::string trace;
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace));
+  trace_writer.WriteJoined();
+  trace_writer.Close();
+  trace[0] = 'X';
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnJoined()).Times(0);
+
+  EXPECT_THAT(ReplaySessionTrace(trace, *observer),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SessionTraceTest, ReplayFailsWithUnsupportedVersion) {
+  std::string trace;
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace));
+  trace_writer.WriteJoined();
+  trace_writer.Close();
+  // Corrupt the version, which follows the 8 byte magic.
+  trace[8] = 2;
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnJoined()).Times(0);
+
+  EXPECT_THAT(ReplaySessionTrace(trace, *observer),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SessionTraceTest, ReplayInRealTimeKeepsRecordSpacing) {
+  std::string trace;
+  absl::Time start_time = absl::Now() - absl::Milliseconds(200);
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace), start_time);
+  trace_writer.WriteJoined();
+  trace_writer.Close();
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnJoined());
+
+  absl::Time replay_start = absl::Now();
+  EXPECT_OK(ReplaySessionTrace(trace, *observer, {.real_time = true}));
+
+  EXPECT_GE(absl::Now() - replay_start, absl::Milliseconds(200));
+}
+
+TEST(SessionTraceTest, ReplayFailsWithTruncatedTrace) {
+  std::string trace;
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace));
+  trace_writer.WriteDisconnected(absl::InternalError("test error"));
+  trace_writer.Close();
+  trace.pop_back();
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnDisconnected).Times(0);
+
+  EXPECT_THAT(ReplaySessionTrace(trace, *observer),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(SessionTraceTest, ReplayDisconnectsAtEndIfTraceDidNotDisconnect) {
+  std::string trace;
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace));
+  trace_writer.WriteJoined();
+  trace_writer.Close();
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnJoined());
+  EXPECT_CALL(*observer, OnDisconnected(absl::OkStatus()));
+
+  EXPECT_OK(ReplaySessionTrace(trace, *observer, {.disconnect_at_end = true}));
+}
+
+TEST(SessionTraceTest, ReplayDisconnectsWithErrorIfTraceIsMalformed) {
+  std::string trace;
+  SessionTraceWriter trace_writer(CreateTraceOutput(trace));
+  trace_writer.WriteJoined();
+  trace_writer.Close();
+  trace.pop_back();
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer,
+              OnDisconnected(StatusIs(absl::StatusCode::kDataLoss)));
+
+  EXPECT_THAT(
+      ReplaySessionTrace(trace, *observer, {.disconnect_at_end = true}),
+      StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(SessionTraceTest, RecordingObserverForwardsCallbacks) {
+  std::string trace;
+  auto trace_writer =
+      std::make_shared<SessionTraceWriter>(CreateTraceOutput(trace));
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnJoined());
+  EXPECT_CALL(*observer, OnResourceUpdate);
+  auto recording_observer =
+      webrtc::make_ref_counted<SessionRecordingObserver>(trace_writer,
+                                                         observer);
+
+  recording_observer->OnJoined();
+  recording_observer->OnResourceUpdate(meet::SessionControlChannelToClient());
+  trace_writer->Close();
+
+  // Only the join is recorded; resource updates are recorded as data channel
+  // messages instead.
+  auto replay_observer =
+      webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*replay_observer, OnJoined());
+  EXPECT_CALL(*replay_observer, OnResourceUpdate).Times(0);
+  EXPECT_OK(ReplaySessionTrace(trace, *replay_observer));
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -18,13 +18,17 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
-#include <vector>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/samples/media_writing.h"
 #include "webrtc/api/scoped_refptr.h"
@@ -35,70 +39,185 @@
 // to a version that supports it.
 
 namespace media_api_samples {
+namespace {
+
+// The nominal frame rate of video files. Frames are written as they are
+// received.
+constexpr int kVideoFrameRate = 30;
+
+}  // namespace
 
 void SingleUserMediaCollector::OnAudioFrame(meet::AudioFrame frame) {
-  // Copy the audio frame, since the frame is simply a view into an audio
-  // buffer.
-  std::vector<int16_t> pcm16(frame.pcm16.begin(), frame.pcm16.end());
+  if (loudest_speaker_only_ && !frame.is_from_loudest_speaker) {
+    return;
+  }
+  absl::Time received_time = frame.receive_time == absl::InfinitePast()
+                                 ? absl::Now()
+                                 : frame.receive_time;
+  // Retain the frame's buffer so the samples outlive this call. Frames without
+  // a buffer are simply a view into an audio buffer, so they must be copied.
+  rtc::scoped_refptr<meet::AudioBufferInterface> buffer =
+      frame.buffer != nullptr ? std::move(frame.buffer)
+                              : audio_buffer_pool_.Acquire(frame.pcm16);
 
   // Move audio processing to a separate thread since `OnAudioFrame`
   // implementations should move expensive work to a separate thread.
-  collector_thread_->PostTask([this, pcm16 = std::move(pcm16)] {
-    HandleAudioBuffer(std::move(pcm16));
-  });
+  audio_queue_->Enqueue(
+      frame.contributing_source,
+      [this, buffer = std::move(buffer), sample_rate = frame.sample_rate,
+       channel_count = static_cast<int>(frame.number_of_channels),
+       contributing_source = frame.contributing_source,
+       received_time]() mutable {
+        if (loudest_speaker_only_) {
+          HandleLoudestSpeaker(contributing_source, received_time);
+        }
+        HandleAudioBuffer(std::move(buffer), sample_rate, channel_count);
+      });
 }
 
 void SingleUserMediaCollector::OnVideoFrame(meet::VideoFrame frame) {
   // Move video processing to a separate thread since `OnVideoFrame`
   // implementations should move expensive work to a separate thread.
-  collector_thread_->PostTask(
-      [this, buffer = frame.frame.video_frame_buffer()] {
+  video_queue_->Enqueue(
+      frame.contributing_source,
+      [this, buffer = frame.frame.video_frame_buffer()]() mutable {
         HandleVideoBuffer(std::move(buffer));
       });
 }
 
-void SingleUserMediaCollector::HandleAudioBuffer(std::vector<int16_t> pcm16) {
+void SingleUserMediaCollector::OnEncodedVideoFrame(
+    meet::EncodedVideoFrame frame) {
+  collector_thread_->PostTask([this, frame = std::move(frame)]() mutable {
+    HandleEncodedVideoFrame(std::move(frame));
+  });
+}
+
+void SingleUserMediaCollector::FinalizeAudioFile() {
+  if (audio_writer_ == nullptr) {
+    return;
+  }
+  audio_writer_->Close();
+  audio_writer_.reset();
+  absl::Status status =
+      FinalizeWavFileHeader(absl::StrCat(output_file_prefix_, "audio.wav"));
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to finalize WAV header: " << status;
+  }
+}
+
+void SingleUserMediaCollector::HandleAudioBuffer(
+    rtc::scoped_refptr<meet::AudioBufferInterface> buffer, int sample_rate,
+    int channel_count) {
   DCHECK(collector_thread_->IsCurrent());
 
   if (audio_writer_ == nullptr) {
     std::string audio_output_file_name =
-        absl::StrCat(output_file_prefix_, "audio.pcm");
+        absl::StrCat(output_file_prefix_, "audio.wav");
 
     LOG(INFO) << "Creating audio file: " << audio_output_file_name;
     audio_writer_ = output_writer_provider_(audio_output_file_name);
+    WriteWavFileHeader(sample_rate, channel_count, *audio_writer_);
   }
 
-  WritePcm16(pcm16, *audio_writer_);
+  WritePcm16(buffer->pcm16(), *audio_writer_);
 }
 
-void SingleUserMediaCollector::HandleVideoBuffer(
-    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer) {
+void SingleUserMediaCollector::HandleLoudestSpeaker(
+    uint32_t contributing_source, absl::Time received_time) {
   DCHECK(collector_thread_->IsCurrent());
 
-  // Meet video frames are always in YUV420p format.
-  const webrtc::I420BufferInterface* i420 = buffer->GetI420();
-  if (i420 == nullptr) {
-    LOG(ERROR) << "Failed to get I420 buffer from video frame buffer.";
+  if (loudest_speaker_ == contributing_source) {
     return;
   }
+  if (speaker_timeline_writer_ == nullptr) {
+    std::string timeline_file_name =
+        absl::StrCat(output_file_prefix_, "speaker_timeline.csv");
+
+    LOG(INFO) << "Creating speaker timeline file: " << timeline_file_name;
+    speaker_timeline_writer_ = output_writer_provider_(timeline_file_name);
+    constexpr absl::string_view kHeader = "time,contributing_source\n";
+    speaker_timeline_writer_->Write(kHeader.data(), kHeader.size());
+  }
+  loudest_speaker_ = contributing_source;
+  std::string line = absl::StrCat(absl::FormatTime(received_time), ",",
+                                  contributing_source, "\n");
+  speaker_timeline_writer_->Write(line.data(), line.size());
+}
+
+void SingleUserMediaCollector::HandleVideoBuffer(
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer) {
+  DCHECK(collector_thread_->IsCurrent());
+
+  // Frame dimensions are available without converting the buffer, so the
+  // buffer is only converted (if at all) when it is written.
+  int width = buffer->width();
+  int height = buffer->height();
 
   // If the video frame size changes, or if this is the first video frame,
   // create a new video file.
-  if (video_segment_ == nullptr || video_segment_->width != i420->width() ||
-      video_segment_->height != i420->height()) {
+  if (video_segment_ == nullptr || video_segment_->width != width ||
+      video_segment_->height != height) {
     int segment_number =
         video_segment_ == nullptr ? 0 : video_segment_->segment_number + 1;
     std::string video_output_file_name =
-        absl::StrCat(output_file_prefix_, "video_", segment_number, "_",
-                     i420->width(), "x", i420->height(), ".yuv");
+        absl::StrCat(output_file_prefix_, "video_", segment_number, "_", width,
+                     "x", height, ".y4m");
 
     LOG(INFO) << "Creating video file: " << video_output_file_name;
     video_segment_ = std::make_unique<VideoSegment>(
-        segment_number, i420->width(), i420->height(),
+        segment_number, width, height,
         output_writer_provider_(video_output_file_name));
+    WriteY4mFileHeader(width, height, kVideoFrameRate,
+                       *video_segment_->writer);
+  }
+
+  if (buffer->type() != webrtc::VideoFrameBuffer::Type::kI420) {
+    buffer = i420_pool_.ToI420(*buffer);
+  }
+  if (buffer == nullptr || !WriteY4mFrame(*buffer, *video_segment_->writer)) {
+    LOG(ERROR) << "Failed to convert video frame buffer to I420.";
+  }
+}
+
+void SingleUserMediaCollector::HandleEncodedVideoFrame(
+    meet::EncodedVideoFrame frame) {
+  DCHECK(collector_thread_->IsCurrent());
+
+  std::optional<absl::string_view> fourcc =
+      IvfFourccForMimeType(frame.mime_type);
+  if (!fourcc.has_value()) {
+    LOG_EVERY_N_SEC(WARNING, 10)
+        << "Dropping encoded video with unsupported codec: " << frame.mime_type;
+    return;
+  }
+
+  // Delta frames cannot be decoded without the frames before them, so segments
+  // start at key frames. Only key frames carry reliable dimensions, so they are
+  // also the only frames that can start a new segment.
+  if (frame.is_key_frame &&
+      (video_segment_ == nullptr ||
+       video_segment_->mime_type != frame.mime_type ||
+       video_segment_->width != frame.width ||
+       video_segment_->height != frame.height)) {
+    int segment_number =
+        video_segment_ == nullptr ? 0 : video_segment_->segment_number + 1;
+    std::string video_output_file_name =
+        absl::StrCat(output_file_prefix_, "video_", segment_number, "_",
+                     frame.width, "x", frame.height, ".ivf");
+
+    LOG(INFO) << "Creating video file: " << video_output_file_name;
+    video_segment_ = std::make_unique<VideoSegment>(
+        segment_number, frame.width, frame.height,
+        output_writer_provider_(video_output_file_name), frame.mime_type);
+    WriteIvfFileHeader(*fourcc, frame.width, frame.height,
+                       *video_segment_->writer);
+  }
+  // Frames before the first key frame cannot be decoded, so they are dropped.
+  if (video_segment_ == nullptr) {
+    return;
   }
 
-  WriteYuv420(*i420, *video_segment_->writer);
+  WriteIvfFrame(frame.data, frame.rtp_timestamp, *video_segment_->writer);
 }
 
 }  // namespace media_api_samples
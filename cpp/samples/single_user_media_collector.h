@@ -21,9 +21,9 @@
 #include <fstream>
 #include <ios>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
-#include <vector>
 
 #include "absl/base/nullability.h"
 #include "absl/log/log.h"
@@ -32,6 +32,10 @@
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/audio_buffer_pool.h"
+#include "cpp/samples/buffered_output_writer.h"
+#include "cpp/samples/frame_queue.h"
+#include "cpp/samples/i420_buffer_pool.h"
 #include "cpp/samples/output_file.h"
 #include "cpp/samples/output_writer_interface.h"
 #include "webrtc/api/scoped_refptr.h"
@@ -56,6 +60,8 @@ class SingleUserMediaCollector : public meet::MediaApiClientObserverInterface {
                            std::unique_ptr<rtc::Thread> collector_thread)
       : output_file_prefix_(output_file_prefix),
         collector_thread_(std::move(collector_thread)) {
+    SetFrameQueueOptions(kDefaultAudioFrameQueueOptions,
+                         kDefaultVideoFrameQueueOptions);
     output_writer_provider_ = [](absl::string_view file_name) {
       std::ofstream file(std::string(file_name),
                          std::ios::binary | std::ios::out | std::ios::trunc);
@@ -72,8 +78,12 @@ class SingleUserMediaCollector : public meet::MediaApiClientObserverInterface {
         // data will be lost.
         LOG(ERROR) << "Failed to open file: " << file_name;
       }
-      return std::make_unique<OutputFile>(std::move(file));
+      // Media is written in many small chunks, so buffer writes to reduce the
+      // number of file writes.
+      return std::make_unique<BufferedOutputWriter>(
+          std::make_unique<OutputFile>(std::move(file)));
     };
+    finalize_audio_file_ = true;
   }
 
   // Constructor that allows injecting a custom writer provider for testing.
@@ -82,12 +92,18 @@ class SingleUserMediaCollector : public meet::MediaApiClientObserverInterface {
                            OutputWriterProvider output_writer_provider)
       : output_file_prefix_(output_file_prefix),
         output_writer_provider_(std::move(output_writer_provider)),
-        collector_thread_(std::move(collector_thread)) {}
+        collector_thread_(std::move(collector_thread)) {
+    SetFrameQueueOptions(kDefaultAudioFrameQueueOptions,
+                         kDefaultVideoFrameQueueOptions);
+  }
 
   ~SingleUserMediaCollector() override {
     // Stop the thread to ensure that enqueued tasks do not access member fields
     // after they have been destroyed.
     collector_thread_->Stop();
+    if (finalize_audio_file_) {
+      FinalizeAudioFile();
+    }
   }
 
   void OnResourceUpdate(meet::ResourceUpdate update) override {
@@ -118,8 +134,43 @@ class SingleUserMediaCollector : public meet::MediaApiClientObserverInterface {
     return absl::OkStatus();
   }
 
+  // Bounds the frames that can be waiting to be written. See
+  // `MultiUserMediaCollector::SetFrameQueueOptions`. Encoded video frames
+  // depend on the frames before them, so they are never dropped.
+  //
+  // Must be called before the collector receives any frames.
+  void SetFrameQueueOptions(FrameQueueOptions audio_options,
+                            FrameQueueOptions video_options) {
+    audio_queue_ =
+        std::make_unique<FrameQueue>(collector_thread_.get(), audio_options);
+    video_queue_ =
+        std::make_unique<FrameQueue>(collector_thread_.get(), video_options);
+  }
+
+  // Writes only the audio of the loudest speaker, as needed by e.g. meeting
+  // summaries, instead of mixing all of the conference's audio streams into
+  // the audio file. Frames from other streams are dropped as soon as they are
+  // received, before they are copied or queued.
+  //
+  // Changes of loudest speaker are also written to
+  // `<output_file_prefix>speaker_timeline.csv`, as lines of the time of the
+  // first frame from the new speaker and its contributing source.
+  //
+  // Must be called before the collector receives any frames.
+  void EnableLoudestSpeakerOnly() { loudest_speaker_only_ = true; }
+
+  FrameQueueStats GetAudioQueueStats() const {
+    return audio_queue_->GetStats();
+  }
+  FrameQueueStats GetVideoQueueStats() const {
+    return video_queue_->GetStats();
+  }
+
   void OnAudioFrame(meet::AudioFrame frame) override;
   void OnVideoFrame(meet::VideoFrame frame) override;
+  // Writes encoded video to IVF files, starting at the first key frame. Used
+  // when the client is configured for encoded video passthrough.
+  void OnEncodedVideoFrame(meet::EncodedVideoFrame frame) override;
 
  private:
   struct VideoSegment {
@@ -127,10 +178,22 @@ class SingleUserMediaCollector : public meet::MediaApiClientObserverInterface {
     int width;
     int height;
     std::unique_ptr<OutputWriterInterface> writer;
+    // The MIME type of encoded video segments, or empty for decoded video.
+    std::string mime_type;
   };
 
-  void HandleAudioBuffer(std::vector<int16_t> pcm16);
+  // Creates the audio file with a WAV header for `sample_rate` and
+  // `channel_count` if needed, then appends the samples.
+  void HandleAudioBuffer(rtc::scoped_refptr<meet::AudioBufferInterface> buffer,
+                         int sample_rate, int channel_count);
+  // Records the loudest speaker if it has changed since the previous frame.
+  void HandleLoudestSpeaker(uint32_t contributing_source,
+                            absl::Time received_time);
   void HandleVideoBuffer(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer);
+  void HandleEncodedVideoFrame(meet::EncodedVideoFrame frame);
+  // Closes the local audio file, if one was written, and sets the sizes in its
+  // header.
+  void FinalizeAudioFile();
 
   std::string output_file_prefix_;
   OutputWriterProvider output_writer_provider_;
@@ -140,12 +203,30 @@ class SingleUserMediaCollector : public meet::MediaApiClientObserverInterface {
   // format does not change, so a single writer can be used for all audio
   // frames.
   /*absl_nullable*/ std::unique_ptr<OutputWriterInterface> audio_writer_;
+  // Whether the audio file is a local file, whose header can be finalized once
+  // it is closed.
+  bool finalize_audio_file_ = false;
+  bool loudest_speaker_only_ = false;
+  // Writer for changes of loudest speaker, created with the first audio frame
+  // if only the loudest speaker is written.
+  /*absl_nullable*/ std::unique_ptr<OutputWriterInterface>
+      speaker_timeline_writer_;
+  // The contributing source of the previous audio frame, if only the loudest
+  // speaker is written.
+  std::optional<uint32_t> loudest_speaker_;
   // The current video segment, or nullptr if no video frames have been received
   // yet.
   //
   // The first video segment is created when the first video frame is received.
-  // If the video frame size changes, a new video segment is created.
+  // If the video frame size (or, for encoded video, the codec) changes, a new
+  // video segment is created.
   /*absl_nullable*/ std::unique_ptr<VideoSegment> video_segment_;
+  // Used to copy audio frames that do not own their samples. Only accessed
+  // from `OnAudioFrame`, which the client always calls from the same thread.
+  meet::AudioBufferPool audio_buffer_pool_;
+  // Recycles the buffers of converted video frames. Only accessed on
+  // `collector_thread_`.
+  I420BufferPool i420_pool_;
 
   absl::Notification join_notification_;
   absl::Notification disconnect_notification_;
@@ -153,6 +234,10 @@ class SingleUserMediaCollector : public meet::MediaApiClientObserverInterface {
   // The media collector's internal thread. Used for moving work off of the
   // MediaApiClient's threads and synchronizing access to member variables.
   std::unique_ptr<rtc::Thread> collector_thread_;
+  // Audio and video frames waiting to be handled on `collector_thread_`.
+  // Never null.
+  std::unique_ptr<FrameQueue> audio_queue_;
+  std::unique_ptr<FrameQueue> video_queue_;
 };
 
 }  // namespace media_api_samples
@@ -19,12 +19,14 @@
 #include <cstdint>
 #include <ios>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
@@ -40,6 +42,7 @@ namespace media_api_samples {
 namespace {
 
 using ::testing::_;
+using ::testing::AnyNumber;
 using ::testing::MockFunction;
 using ::testing::Return;
 
@@ -84,16 +87,22 @@ TEST(SingleUserMediaCollectorTest, ReceivesAudioFrameAndWritesToAudioFile) {
   absl::Notification write_notification;
   EXPECT_CALL(*mock_output_file, Write(_, _))
       .WillRepeatedly([&](const char* content, std::streamsize size) {
-        EXPECT_EQ(size, sizeof(int16_t));
-        written_pcm16.push_back(reinterpret_cast<const int16_t*>(content)[0]);
+        // Each frame is written in a single call.
+        EXPECT_EQ(size, pcm16.size() * sizeof(int16_t));
+        const int16_t* samples = reinterpret_cast<const int16_t*>(content);
+        written_pcm16.insert(written_pcm16.end(), samples,
+                             samples + size / sizeof(int16_t));
         if (written_pcm16.size() == pcm16.size()) {
           write_notification.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
 
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
-  EXPECT_CALL(mock_output_file_provider, Call("test_audio.pcm"))
+  EXPECT_CALL(mock_output_file_provider, Call("test_audio.wav"))
       .WillOnce(Return(std::move(mock_output_file)));
   auto thread = rtc::Thread::Create();
   thread->Start();
@@ -118,10 +127,14 @@ TEST(SingleUserMediaCollectorTest, ReceivesAudioFrameOnlyCreatesOneAudioFile) {
   EXPECT_CALL(*mock_output_file, Write(_, _))
       .WillRepeatedly([&](const char* content, std::streamsize size) {
         write_count++;
-        if (write_count == test_data1.pcm16.size() + test_data2.pcm16.size()) {
+        // Each frame is written in a single call.
+        if (write_count == 2) {
           write_notification.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   EXPECT_CALL(mock_output_file_provider, Call(_))
@@ -140,6 +153,65 @@ TEST(SingleUserMediaCollectorTest, ReceivesAudioFrameOnlyCreatesOneAudioFile) {
       write_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
 }
 
+TEST(SingleUserMediaCollectorTest,
+     LoudestSpeakerOnlyDropsOtherStreamsAndRecordsSpeakerChanges) {
+  AudioTestData first_speaker = CreateAudioTestData(/*num_samples=*/10);
+  first_speaker.frame.is_from_loudest_speaker = true;
+  first_speaker.frame.contributing_source = 1;
+  first_speaker.frame.receive_time = absl::FromUnixSeconds(1);
+  AudioTestData other_stream = CreateAudioTestData(/*num_samples=*/20);
+  other_stream.frame.is_from_loudest_speaker = false;
+  other_stream.frame.contributing_source = 2;
+  AudioTestData second_speaker = CreateAudioTestData(/*num_samples=*/10);
+  second_speaker.frame.is_from_loudest_speaker = true;
+  second_speaker.frame.contributing_source = 2;
+  second_speaker.frame.receive_time = absl::FromUnixSeconds(2);
+
+  auto mock_audio_file = std::make_unique<MockOutputWriter>();
+  int written_samples = 0;
+  absl::Notification write_notification;
+  EXPECT_CALL(*mock_audio_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written_samples += size / sizeof(int16_t);
+        if (written_samples == 20) {
+          write_notification.Notify();
+        }
+      });
+  EXPECT_CALL(*mock_audio_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
+  auto mock_timeline_file = std::make_unique<MockOutputWriter>();
+  std::string timeline;
+  EXPECT_CALL(*mock_timeline_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        timeline.append(content, size);
+      });
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  EXPECT_CALL(mock_output_file_provider, Call("test_speaker_timeline.csv"))
+      .WillOnce(Return(std::move(mock_timeline_file)));
+  EXPECT_CALL(mock_output_file_provider, Call("test_audio.wav"))
+      .WillOnce(Return(std::move(mock_audio_file)));
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<SingleUserMediaCollector>(
+      "test_", std::move(thread),
+      std::move(mock_output_file_provider).AsStdFunction());
+  collector->EnableLoudestSpeakerOnly();
+
+  collector->OnAudioFrame(std::move(first_speaker.frame));
+  collector->OnAudioFrame(std::move(other_stream.frame));
+  collector->OnAudioFrame(std::move(second_speaker.frame));
+
+  ASSERT_TRUE(
+      write_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_EQ(timeline, absl::StrCat("time,contributing_source\n",
+                                   absl::FormatTime(absl::FromUnixSeconds(1)),
+                                   ",1\n",
+                                   absl::FormatTime(absl::FromUnixSeconds(2)),
+                                   ",2\n"));
+}
+
 TEST(SingleUserMediaCollectorTest, ReceivesVideoFrameAndWritesToVideoFile) {
   VideoTestData test_data = CreateVideoTestData(/*width=*/10, /*height=*/5);
   std::vector<char> yuv_data = std::move(test_data.yuv_data);
@@ -157,9 +229,12 @@ TEST(SingleUserMediaCollectorTest, ReceivesVideoFrameAndWritesToVideoFile) {
           write_notification.Notify();
         }
       });
+  EXPECT_CALL(*mock_output_file, Write)
+      .With(IsContainerFraming())
+      .Times(AnyNumber());
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
-  EXPECT_CALL(mock_output_file_provider, Call("test_video_0_10x5.yuv"))
+  EXPECT_CALL(mock_output_file_provider, Call("test_video_0_10x5.y4m"))
       .WillOnce(Return(std::move(mock_output_file)));
   auto thread = rtc::Thread::Create();
   thread->Start();
@@ -182,7 +257,7 @@ TEST(SingleUserMediaCollectorTest,
   MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
       mock_output_file_provider;
   absl::Notification write_notification;
-  EXPECT_CALL(mock_output_file_provider, Call("test_video_0_10x5.yuv"))
+  EXPECT_CALL(mock_output_file_provider, Call("test_video_0_10x5.y4m"))
       .WillOnce([&] {
         write_notification.Notify();
         return std::make_unique<MockOutputWriter>();
@@ -211,17 +286,17 @@ TEST(SingleUserMediaCollectorTest,
   absl::Notification write_notification1;
   absl::Notification write_notification2;
   absl::Notification write_notification3;
-  EXPECT_CALL(mock_output_file_provider, Call("test_video_0_10x5.yuv"))
+  EXPECT_CALL(mock_output_file_provider, Call("test_video_0_10x5.y4m"))
       .WillOnce([&] {
         write_notification1.Notify();
         return std::make_unique<MockOutputWriter>();
       });
-  EXPECT_CALL(mock_output_file_provider, Call("test_video_1_20x5.yuv"))
+  EXPECT_CALL(mock_output_file_provider, Call("test_video_1_20x5.y4m"))
       .WillOnce([&] {
         write_notification2.Notify();
         return std::make_unique<MockOutputWriter>();
       });
-  EXPECT_CALL(mock_output_file_provider, Call("test_video_2_10x5.yuv"))
+  EXPECT_CALL(mock_output_file_provider, Call("test_video_2_10x5.y4m"))
       .WillOnce([&] {
         write_notification3.Notify();
         return std::make_unique<MockOutputWriter>();
@@ -244,5 +319,60 @@ TEST(SingleUserMediaCollectorTest,
       write_notification3.WaitForNotificationWithTimeout(absl::Seconds(1)));
 }
 
+TEST(SingleUserMediaCollectorTest,
+     WritesEncodedVideoToIvfFilesStartingAtKeyFrames) {
+  auto mock_output_file = std::make_unique<MockOutputWriter>();
+  std::streamsize written_size = 0;
+  absl::Notification write_notification;
+  EXPECT_CALL(*mock_output_file, Write(_, _))
+      .WillRepeatedly([&](const char* content, std::streamsize size) {
+        written_size += size;
+        // The 32 byte file header, then two frames with 12 byte headers.
+        if (written_size == 32 + 2 * (12 + 1)) {
+          write_notification.Notify();
+        }
+      });
+  MockFunction<std::unique_ptr<OutputWriterInterface>(absl::string_view)>
+      mock_output_file_provider;
+  absl::Notification second_file_notification;
+  EXPECT_CALL(mock_output_file_provider, Call("test_video_0_640x360.ivf"))
+      .WillOnce(Return(std::move(mock_output_file)));
+  EXPECT_CALL(mock_output_file_provider, Call("test_video_1_1280x720.ivf"))
+      .WillOnce([&] {
+        second_file_notification.Notify();
+        return std::make_unique<MockOutputWriter>();
+      });
+  auto thread = rtc::Thread::Create();
+  thread->Start();
+  auto collector = webrtc::make_ref_counted<SingleUserMediaCollector>(
+      "test_", std::move(thread),
+      std::move(mock_output_file_provider).AsStdFunction());
+
+  // Dropped, since it precedes the first key frame.
+  collector->OnEncodedVideoFrame({.data = {1},
+                                  .mime_type = "video/VP8",
+                                  .is_key_frame = false,
+                                  .width = 640,
+                                  .height = 360});
+  collector->OnEncodedVideoFrame({.data = {2},
+                                  .mime_type = "video/VP8",
+                                  .is_key_frame = true,
+                                  .width = 640,
+                                  .height = 360});
+  // Delta frames do not carry dimensions.
+  collector->OnEncodedVideoFrame(
+      {.data = {3}, .mime_type = "video/VP8", .is_key_frame = false});
+  collector->OnEncodedVideoFrame({.data = {4},
+                                  .mime_type = "video/VP8",
+                                  .is_key_frame = true,
+                                  .width = 1280,
+                                  .height = 720});
+
+  EXPECT_TRUE(
+      write_notification.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_TRUE(second_file_notification.WaitForNotificationWithTimeout(
+      absl::Seconds(1)));
+}
+
 }  // namespace
 }  // namespace media_api_samples
@@ -31,6 +31,7 @@
 #include "cpp/api/media_api_client_interface.h"
 #include "cpp/api/video_assignment_resource.h"
 #include "cpp/internal/media_api_client_factory.h"
+#include "cpp/internal/trace.h"
 #include "cpp/samples/single_user_media_collector.h"
 #include "webrtc/api/make_ref_counted.h"
 #include "webrtc/rtc_base/thread.h"
@@ -59,6 +60,19 @@ ABSL_FLAG(absl::Duration, join_timeout, absl::Minutes(2),
           "a reasonable amount of time for the participant to complete this "
           "step.");
 
+ABSL_FLAG(bool, encoded_video, false,
+          "Whether to write received video without decoding it. Encoded video "
+          "is written to IVF files instead of YUV files.");
+
+ABSL_FLAG(bool, loudest_speaker_only, false,
+          "Whether to write only the loudest speaker's audio, along with a "
+          "timeline of speaker changes, instead of all audio streams.");
+
+ABSL_FLAG(std::string, trace_categories, "",
+          "Comma-separated trace categories to log, or \"all\". Traces "
+          "include full message payloads and may be verbose. Valid categories "
+          "are data_channel, resource_update, media_stats and http.");
+
 namespace {
 
 // Request a single video stream with dimensions of 100px x 100px, and set the
@@ -90,6 +104,12 @@ meet::VideoAssignmentChannelFromClient CreateVideoAssignmentRequest() {
 int main(int argc, char** argv) {
   absl::SetProgramUsageMessage(argv[0]);
   absl::ParseCommandLine(argc, argv);
+  absl::Status trace_status =
+      meet::SetEnabledTraceCategories(absl::GetFlag(FLAGS_trace_categories));
+  if (!trace_status.ok()) {
+    LOG(ERROR) << "Invalid trace categories: " << trace_status;
+    return EXIT_FAILURE;
+  }
   std::string output_file_prefix = absl::GetFlag(FLAGS_output_directory);
   if (output_file_prefix.empty()) {
     LOG(ERROR) << "Output directory is empty";
@@ -121,11 +141,15 @@ int main(int argc, char** argv) {
   auto media_collector =
       webrtc::make_ref_counted<media_api_samples::SingleUserMediaCollector>(
           output_file_prefix, std::move(collector_thread));
+  if (absl::GetFlag(FLAGS_loudest_speaker_only)) {
+    media_collector->EnableLoudestSpeakerOnly();
+  }
   // Configure the media collector to receive a single video stream, and enable
   // audio.
   meet::MediaApiClientConfiguration config = {
       .receiving_video_stream_count = 1,
       .enable_audio_streams = true,
+      .encoded_video_passthrough = absl::GetFlag(FLAGS_encoded_video),
   };
   absl::StatusOr<std::unique_ptr<meet::MediaApiClientInterface>> client_status =
       meet::MediaApiClientFactory().CreateMediaApiClient(std::move(config),
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_SLOT_MAP_H_
+#define CPP_SAMPLES_SLOT_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace media_api_samples {
+
+// A container that stores its values in contiguous slots and hands out
+// generation-checked handles to them.
+//
+// Erased slots are reused by later insertions, so churn does not allocate once
+// the container has grown to its peak size. Reusing a slot increments its
+// generation, so handles to erased values can be detected instead of silently
+// resolving to a newer value.
+//
+// This class is not thread-safe.
+template <typename T>
+class SlotMap {
+ public:
+  struct Handle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    friend bool operator==(const Handle& lhs, const Handle& rhs) = default;
+  };
+
+  // Stores `value` in a free slot and returns its handle.
+  Handle Insert(T value) {
+    uint32_t index;
+    if (free_indices_.empty()) {
+      index = static_cast<uint32_t>(slots_.size());
+      slots_.emplace_back();
+    } else {
+      index = free_indices_.back();
+      free_indices_.pop_back();
+    }
+    Slot& slot = slots_[index];
+    slot.value.emplace(std::move(value));
+    ++size_;
+    return Handle{.index = index, .generation = slot.generation};
+  }
+
+  // Returns the value referred to by `handle`, or nullptr if the value has
+  // been erased.
+  T* Get(Handle handle) {
+    if (handle.index >= slots_.size()) {
+      return nullptr;
+    }
+    Slot& slot = slots_[handle.index];
+    if (slot.generation != handle.generation || !slot.value.has_value()) {
+      return nullptr;
+    }
+    return &*slot.value;
+  }
+  const T* Get(Handle handle) const {
+    return const_cast<SlotMap*>(this)->Get(handle);
+  }
+
+  // Erases the value referred to by `handle`. Returns false if the value has
+  // already been erased.
+  bool Erase(Handle handle) {
+    if (Get(handle) == nullptr) {
+      return false;
+    }
+    Slot& slot = slots_[handle.index];
+    slot.value.reset();
+    ++slot.generation;
+    free_indices_.push_back(handle.index);
+    --size_;
+    return true;
+  }
+
+  // Invokes `function` with every stored value, in slot order.
+  template <typename Function>
+  void ForEach(Function function) const {
+    for (const Slot& slot : slots_) {
+      if (slot.value.has_value()) {
+        function(*slot.value);
+      }
+    }
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  struct Slot {
+    std::optional<T> value;
+    uint32_t generation = 0;
+  };
+
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_indices_;
+  size_t size_ = 0;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_SLOT_MAP_H_
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/slot_map.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::IsNull;
+using ::testing::Pointee;
+using ::testing::UnorderedElementsAre;
+
+TEST(SlotMapTest, GetReturnsInsertedValue) {
+  SlotMap<std::string> slot_map;
+
+  SlotMap<std::string>::Handle handle = slot_map.Insert("value");
+
+  EXPECT_THAT(slot_map.Get(handle), Pointee(std::string("value")));
+  EXPECT_EQ(slot_map.size(), 1);
+}
+
+TEST(SlotMapTest, GetAfterEraseReturnsNull) {
+  SlotMap<std::string> slot_map;
+  SlotMap<std::string>::Handle handle = slot_map.Insert("value");
+
+  EXPECT_TRUE(slot_map.Erase(handle));
+
+  EXPECT_THAT(slot_map.Get(handle), IsNull());
+  EXPECT_TRUE(slot_map.empty());
+}
+
+TEST(SlotMapTest, EraseTwiceReturnsFalse) {
+  SlotMap<std::string> slot_map;
+  SlotMap<std::string>::Handle handle = slot_map.Insert("value");
+  ASSERT_TRUE(slot_map.Erase(handle));
+
+  EXPECT_FALSE(slot_map.Erase(handle));
+}
+
+TEST(SlotMapTest, StaleHandleDoesNotResolveToReusedSlot) {
+  SlotMap<std::string> slot_map;
+  SlotMap<std::string>::Handle stale_handle = slot_map.Insert("old");
+  ASSERT_TRUE(slot_map.Erase(stale_handle));
+
+  SlotMap<std::string>::Handle new_handle = slot_map.Insert("new");
+
+  // The erased slot is reused, but with a new generation.
+  EXPECT_EQ(new_handle.index, stale_handle.index);
+  EXPECT_NE(new_handle, stale_handle);
+  EXPECT_THAT(slot_map.Get(stale_handle), IsNull());
+  EXPECT_FALSE(slot_map.Erase(stale_handle));
+  EXPECT_THAT(slot_map.Get(new_handle), Pointee(std::string("new")));
+}
+
+TEST(SlotMapTest, ForEachVisitsStoredValues) {
+  SlotMap<std::string> slot_map;
+  slot_map.Insert("a");
+  SlotMap<std::string>::Handle erased_handle = slot_map.Insert("b");
+  slot_map.Insert("c");
+  ASSERT_TRUE(slot_map.Erase(erased_handle));
+
+  std::vector<std::string> values;
+  slot_map.ForEach([&](const std::string& value) { values.push_back(value); });
+
+  EXPECT_THAT(values, UnorderedElementsAre("a", "c"));
+}
+
+}  // namespace
+}  // namespace media_api_samples
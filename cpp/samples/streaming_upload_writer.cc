@@ -0,0 +1,520 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/streaming_upload_writer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ios>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "cpp/internal/trace_events.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+
+namespace {
+
+// Finishing an upload is retried this many times before its ID is recorded in
+// a spill file instead.
+constexpr int kMaxFinishAttempts = 3;
+
+}  // namespace
+
+class StreamingUpload : public std::enable_shared_from_this<StreamingUpload> {
+ public:
+  using SpillRenamer = StreamingSegmentUploader::SpillRenamer;
+
+  // `spill_renamer` may be null if the upload is never renamed.
+  StreamingUpload(absl::string_view object_name,
+                  ObjectUploadClientInterface& client,
+                  OutputWriterProvider spill_provider,
+                  SpillRenamer spill_renamer, StreamingUploadOptions options)
+      : object_name_(object_name),
+        client_(client),
+        spill_provider_(std::move(spill_provider)),
+        spill_renamer_(std::move(spill_renamer)),
+        options_(options),
+        final_name_(object_name) {}
+
+  // Must be called once the upload is owned by a shared pointer.
+  void Start();
+  void Write(const char* content, std::streamsize size);
+  void Close(absl::AnyInvocable<void() &&> on_closed);
+  // Sets the name recorded when the upload finishes. A spilled file is
+  // renamed to match once it has been closed. Returns whether the upload has
+  // already been finished with its previous name, so that the final name in
+  // the object's metadata must be updated.
+  bool SetFinalName(absl::string_view final_name);
+
+ private:
+  // Sends the next request of the upload, or completes closing it, if
+  // possible.
+  void Advance();
+  void OnStarted(absl::StatusOr<std::string> upload_id);
+  void OnPartUploaded(absl::Status status);
+  void OnFinished(absl::Status status);
+  // Moves every byte that has not been uploaded yet to the spill backlog,
+  // which receives all later writes. `FlushSpill` must be called once the
+  // lock is released.
+  void Spill(absl::string_view reason) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Opens the spill writer if needed, and writes the spill backlog to it.
+  // Only one thread flushes at a time, without holding the lock, so that
+  // writes and uploader callbacks are not blocked on spill I/O.
+  void FlushSpill();
+  void OnSpillClosed(absl::AnyInvocable<void() &&> on_closed);
+  std::string SpillFileName(absl::string_view name) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  const std::string object_name_;
+  ObjectUploadClientInterface& client_;
+  OutputWriterProvider spill_provider_;
+  SpillRenamer spill_renamer_;
+  const StreamingUploadOptions options_;
+
+  absl::Mutex mutex_;
+  std::string final_name_ ABSL_GUARDED_BY(mutex_);
+  std::optional<std::string> upload_id_ ABSL_GUARDED_BY(mutex_);
+  // The part being filled by writes, and complete parts waiting to be
+  // uploaded.
+  std::string current_part_ ABSL_GUARDED_BY(mutex_);
+  std::deque<std::string> pending_parts_ ABSL_GUARDED_BY(mutex_);
+  // The part being uploaded, until its request completes.
+  std::string in_flight_part_ ABSL_GUARDED_BY(mutex_);
+  bool part_in_flight_ ABSL_GUARDED_BY(mutex_) = false;
+  // Bytes written but not uploaded yet, including the in-flight part.
+  size_t pending_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t uploaded_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool finishing_ ABSL_GUARDED_BY(mutex_) = false;
+  int finish_attempts_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool finished_ ABSL_GUARDED_BY(mutex_) = false;
+  // Set if every attempt to finish the upload failed, in which case its ID is
+  // spilled so that it can be finished later.
+  bool finish_failed_ ABSL_GUARDED_BY(mutex_) = false;
+  // Set once the upload has spilled, to the offset of the first spilled byte.
+  std::optional<int64_t> spill_offset_ ABSL_GUARDED_BY(mutex_);
+  // The name that the spill writer is opened with, and then the current name
+  // of the spilled file.
+  std::string spill_file_name_ ABSL_GUARDED_BY(mutex_);
+  // Spilled data that has not been written to the spill writer yet.
+  std::deque<std::string> spill_backlog_ ABSL_GUARDED_BY(mutex_);
+  bool spill_flushing_ ABSL_GUARDED_BY(mutex_) = false;
+  bool spill_opened_ ABSL_GUARDED_BY(mutex_) = false;
+  bool spill_closed_ ABSL_GUARDED_BY(mutex_) = false;
+  // Only used by the flushing thread, and by the thread that closes it once
+  // the backlog has been flushed.
+  std::unique_ptr<OutputWriterInterface> spill_writer_;
+  bool closing_ ABSL_GUARDED_BY(mutex_) = false;
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::AnyInvocable<void() &&> on_closed_ ABSL_GUARDED_BY(mutex_);
+};
+
+void StreamingUpload::Start() {
+  client_.StartUpload(object_name_, [self = shared_from_this()](
+                                        absl::StatusOr<std::string> upload_id) {
+    self->OnStarted(std::move(upload_id));
+  });
+}
+
+void StreamingUpload::Write(const char* content, std::streamsize size) {
+  bool spilled;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (spill_offset_.has_value()) {
+      spill_backlog_.push_back(std::string(content, size));
+    } else {
+      pending_bytes_ += size;
+      while (size > 0) {
+        size_t part_size = std::min(static_cast<size_t>(size),
+                                    options_.part_size - current_part_.size());
+        current_part_.append(content, part_size);
+        content += part_size;
+        size -= part_size;
+        if (current_part_.size() == options_.part_size) {
+          pending_parts_.push_back(std::move(current_part_));
+          current_part_.clear();
+        }
+      }
+      if (pending_bytes_ > options_.max_pending_bytes) {
+        Spill(absl::StrCat("more than ", options_.max_pending_bytes,
+                           " bytes are waiting to be uploaded"));
+      }
+    }
+    spilled = spill_offset_.has_value();
+  }
+  if (spilled) {
+    FlushSpill();
+  }
+  Advance();
+}
+
+void StreamingUpload::Close(absl::AnyInvocable<void() &&> on_closed) {
+  {
+    absl::MutexLock lock(&mutex_);
+    closing_ = true;
+    on_closed_ = std::move(on_closed);
+  }
+  Advance();
+}
+
+bool StreamingUpload::SetFinalName(absl::string_view final_name) {
+  std::optional<std::pair<std::string, std::string>> spill_rename;
+  {
+    absl::MutexLock lock(&mutex_);
+    final_name_ = std::string(final_name);
+    if (!spill_offset_.has_value()) {
+      return finishing_ || finished_;
+    }
+    // Otherwise, the spilled file is renamed once it has been closed.
+    if (spill_closed_ && SpillFileName(final_name_) != spill_file_name_) {
+      spill_rename.emplace(spill_file_name_, SpillFileName(final_name_));
+      spill_file_name_ = spill_rename->second;
+    }
+  }
+  if (spill_rename.has_value() && spill_renamer_ != nullptr) {
+    spill_renamer_(spill_rename->first, spill_rename->second);
+  }
+  return false;
+}
+
+void StreamingUpload::Advance() {
+  absl::ReleasableMutexLock lock(&mutex_);
+  if (closed_) {
+    return;
+  }
+
+  if (spill_offset_.has_value()) {
+    if (!closing_ || spill_flushing_ || !spill_opened_ ||
+        !spill_backlog_.empty()) {
+      return;
+    }
+    // Requests still in flight are ignored once they complete.
+    closed_ = true;
+    absl::AnyInvocable<void() &&> on_closed = std::move(on_closed_);
+    lock.Release();
+    // The flushing thread has finished with the writer.
+    std::unique_ptr<OutputWriterInterface> spill_writer =
+        std::move(spill_writer_);
+    spill_writer->CloseAsync([self = shared_from_this(),
+                              on_closed = std::move(on_closed)]() mutable {
+      self->OnSpillClosed(std::move(on_closed));
+    });
+    return;
+  }
+
+  // Parts are uploaded one at a time, and the upload is finished after its
+  // last part.
+  if (!upload_id_.has_value() || part_in_flight_ || finishing_) {
+    return;
+  }
+  if (pending_parts_.empty() && closing_ && !current_part_.empty()) {
+    pending_parts_.push_back(std::move(current_part_));
+    current_part_.clear();
+  }
+
+  if (!pending_parts_.empty()) {
+    in_flight_part_ = std::move(pending_parts_.front());
+    pending_parts_.pop_front();
+    part_in_flight_ = true;
+    std::string upload_id = *upload_id_;
+    int64_t offset = uploaded_bytes_;
+    // The part is only modified once its request completes.
+    absl::string_view part = in_flight_part_;
+    lock.Release();
+    client_.UploadPart(upload_id, offset, part,
+                       [self = shared_from_this()](absl::Status status) {
+                         self->OnPartUploaded(std::move(status));
+                       });
+    return;
+  }
+
+  if (!closing_) {
+    return;
+  }
+  if (!finished_) {
+    finishing_ = true;
+    ++finish_attempts_;
+    std::string upload_id = *upload_id_;
+    int64_t size = uploaded_bytes_;
+    std::string final_name = final_name_;
+    lock.Release();
+    client_.FinishUpload(upload_id, size, final_name,
+                         [self = shared_from_this()](absl::Status status) {
+                           self->OnFinished(std::move(status));
+                         });
+    return;
+  }
+
+  closed_ = true;
+  absl::AnyInvocable<void() &&> on_closed = std::move(on_closed_);
+  lock.Release();
+  std::move(on_closed)();
+}
+
+void StreamingUpload::OnStarted(absl::StatusOr<std::string> upload_id) {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (spill_offset_.has_value()) {
+      return;
+    }
+    if (!upload_id.ok()) {
+      Spill(absl::StrCat("starting the upload failed: ",
+                         upload_id.status().message()));
+    } else {
+      upload_id_ = *std::move(upload_id);
+    }
+  }
+  FlushSpill();
+  Advance();
+}
+
+void StreamingUpload::OnPartUploaded(absl::Status status) {
+  {
+    absl::MutexLock lock(&mutex_);
+    part_in_flight_ = false;
+    if (!spill_offset_.has_value()) {
+      if (status.ok()) {
+        uploaded_bytes_ += in_flight_part_.size();
+        pending_bytes_ -= in_flight_part_.size();
+      } else {
+        Spill(absl::StrCat("uploading a part failed: ", status.message()));
+      }
+    }
+    in_flight_part_.clear();
+  }
+  FlushSpill();
+  Advance();
+}
+
+void StreamingUpload::OnFinished(absl::Status status) {
+  {
+    absl::MutexLock lock(&mutex_);
+    finishing_ = false;
+    if (status.ok()) {
+      finished_ = true;
+    } else if (finish_attempts_ < kMaxFinishAttempts) {
+      LOG(WARNING) << "Failed to finish upload " << *upload_id_ << " of "
+                   << final_name_ << "; retrying: " << status;
+    } else {
+      // Every byte has been uploaded, so the upload can still be finished
+      // with its ID. The spill file records it rather than any data.
+      finish_failed_ = true;
+      Spill(absl::StrCat("finishing the upload failed ", finish_attempts_,
+                         " times: ", status.message()));
+      spill_backlog_.push_back(absl::StrCat("upload_id: ", *upload_id_,
+                                            "\nsize: ", uploaded_bytes_,
+                                            "\n"));
+    }
+  }
+  FlushSpill();
+  Advance();
+}
+
+void StreamingUpload::Spill(absl::string_view reason) {
+  spill_offset_ = uploaded_bytes_;
+  spill_file_name_ = SpillFileName(final_name_);
+  LOG(WARNING) << "Spilling " << final_name_ << " to " << spill_file_name_
+               << " from byte " << *spill_offset_ << " of upload "
+               << upload_id_.value_or("(not started)") << ", since " << reason
+               << ".";
+  // The in-flight part may still be uploaded, but it cannot be relied on. Its
+  // request may still read it, so it is copied.
+  if (!in_flight_part_.empty()) {
+    spill_backlog_.push_back(in_flight_part_);
+  }
+  for (std::string& part : pending_parts_) {
+    spill_backlog_.push_back(std::move(part));
+  }
+  if (!current_part_.empty()) {
+    spill_backlog_.push_back(std::move(current_part_));
+  }
+  pending_parts_.clear();
+  current_part_.clear();
+  pending_bytes_ = 0;
+}
+
+void StreamingUpload::FlushSpill() {
+  std::string spill_file_name;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!spill_offset_.has_value() || closed_ || spill_flushing_ ||
+        (spill_opened_ && spill_backlog_.empty())) {
+      return;
+    }
+    spill_flushing_ = true;
+    spill_file_name = spill_file_name_;
+  }
+  if (spill_writer_ == nullptr) {
+    spill_writer_ = spill_provider_(spill_file_name);
+  }
+  while (true) {
+    std::deque<std::string> backlog;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (spill_backlog_.empty()) {
+        spill_flushing_ = false;
+        spill_opened_ = true;
+        break;
+      }
+      backlog.swap(spill_backlog_);
+    }
+    for (const std::string& data : backlog) {
+      spill_writer_->Write(data.data(), data.size());
+    }
+  }
+}
+
+void StreamingUpload::OnSpillClosed(absl::AnyInvocable<void() &&> on_closed) {
+  std::optional<std::pair<std::string, std::string>> spill_rename;
+  {
+    absl::MutexLock lock(&mutex_);
+    spill_closed_ = true;
+    // The segment was renamed while its spilled file was open.
+    if (SpillFileName(final_name_) != spill_file_name_) {
+      spill_rename.emplace(spill_file_name_, SpillFileName(final_name_));
+      spill_file_name_ = spill_rename->second;
+    }
+  }
+  if (spill_rename.has_value() && spill_renamer_ != nullptr) {
+    spill_renamer_(spill_rename->first, spill_rename->second);
+  }
+  std::move(on_closed)();
+}
+
+std::string StreamingUpload::SpillFileName(absl::string_view name) const {
+  if (finish_failed_) {
+    return absl::StrCat(name, ".unfinished");
+  }
+  // A file spilled from the first byte holds the whole object, so it can
+  // stand in for it.
+  if (*spill_offset_ == 0) {
+    return std::string(name);
+  }
+  return absl::StrCat(name, ".from_", *spill_offset_);
+}
+
+StreamingUploadWriter::StreamingUploadWriter(
+    absl::string_view object_name, ObjectUploadClientInterface& client,
+    OutputWriterProvider spill_provider, StreamingUploadOptions options)
+    : StreamingUploadWriter(std::make_shared<StreamingUpload>(
+          object_name, client, std::move(spill_provider),
+          /*spill_renamer=*/nullptr, options)) {}
+
+StreamingUploadWriter::StreamingUploadWriter(
+    std::shared_ptr<StreamingUpload> upload)
+    : upload_(std::move(upload)) {
+  upload_->Start();
+}
+
+StreamingUploadWriter::~StreamingUploadWriter() {
+  if (!closed_) {
+    CloseAsync([] {});
+  }
+}
+
+void StreamingUploadWriter::Write(const char* content, std::streamsize size) {
+  MEET_TRACE_EVENT("StreamingUploadWriter::Write");
+  upload_->Write(content, size);
+}
+
+void StreamingUploadWriter::Close() {
+  absl::Notification closed;
+  CloseAsync([&closed]() { closed.Notify(); });
+  closed.WaitForNotification();
+}
+
+void StreamingUploadWriter::CloseAsync(
+    absl::AnyInvocable<void() &&> on_closed) {
+  MEET_TRACE_EVENT("StreamingUploadWriter::Close");
+  closed_ = true;
+  upload_->Close(std::move(on_closed));
+}
+
+OutputWriterProvider StreamingSegmentUploader::writer_provider() {
+  return [this](absl::string_view file_name) { return OpenWriter(file_name); };
+}
+
+absl::AnyInvocable<void(absl::string_view tmp_name,
+                        absl::string_view final_name)>
+StreamingSegmentUploader::renamer() {
+  return [this](absl::string_view tmp_name, absl::string_view final_name) {
+    Rename(tmp_name, final_name);
+  };
+}
+
+std::unique_ptr<OutputWriterInterface> StreamingSegmentUploader::OpenWriter(
+    absl::string_view file_name) {
+  // The writer's constructor is private.
+  std::unique_ptr<StreamingUploadWriter> writer(
+      new StreamingUploadWriter(std::make_shared<StreamingUpload>(
+          file_name, client_,
+          [this](absl::string_view spill_file_name) {
+            absl::MutexLock lock(&spill_mutex_);
+            return spill_provider_(spill_file_name);
+          },
+          [this](absl::string_view from, absl::string_view to) {
+            absl::MutexLock lock(&spill_mutex_);
+            spill_renamer_(from, to);
+          },
+          options_)));
+  absl::MutexLock lock(&mutex_);
+  uploads_[file_name] = writer->upload_;
+  return writer;
+}
+
+void StreamingSegmentUploader::Rename(absl::string_view tmp_name,
+                                      absl::string_view final_name) {
+  std::shared_ptr<StreamingUpload> upload;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = uploads_.find(tmp_name);
+    if (it == uploads_.end()) {
+      LOG(WARNING) << "Renamed " << tmp_name
+                   << ", which is not being uploaded.";
+      return;
+    }
+    upload = std::move(it->second);
+    uploads_.erase(it);
+  }
+
+  if (upload->SetFinalName(final_name)) {
+    client_.UpdateFinalName(
+        tmp_name, final_name,
+        [tmp_name = std::string(tmp_name),
+         final_name = std::string(final_name)](absl::Status status) {
+          if (!status.ok()) {
+            LOG(ERROR) << "Failed to record final name " << final_name
+                       << " of " << tmp_name << ": " << status;
+          }
+        });
+  }
+}
+
+}  // namespace media_api_samples
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_STREAMING_UPLOAD_WRITER_H_
+#define CPP_SAMPLES_STREAMING_UPLOAD_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "cpp/samples/output_writer_interface.h"
+
+namespace media_api_samples {
+
+// Client for resumable uploads to object storage.
+//
+// Callbacks may be invoked on any thread, including the calling thread before
+// the method returns. A single client is expected to be shared by every
+// upload, e.g. by driving all of their requests over one pooled HTTP client.
+class ObjectUploadClientInterface {
+ public:
+  using StartCallback =
+      absl::AnyInvocable<void(absl::StatusOr<std::string> upload_id) &&>;
+  using UploadCallback = absl::AnyInvocable<void(absl::Status status) &&>;
+
+  virtual ~ObjectUploadClientInterface() = default;
+
+  // Starts a resumable upload of an object named `object_name`, and invokes
+  // `callback` with the ID of the upload.
+  virtual void StartUpload(absl::string_view object_name,
+                           StartCallback callback) = 0;
+  // Uploads `part`, which starts `offset` bytes into the object. An upload has
+  // at most one part in flight, and parts are uploaded in order.
+  //
+  // `part` remains valid until `callback` is invoked.
+  virtual void UploadPart(absl::string_view upload_id, int64_t offset,
+                          absl::string_view part, UploadCallback callback) = 0;
+  // Completes an upload of `size` bytes, recording `final_name` in the
+  // object's metadata.
+  virtual void FinishUpload(absl::string_view upload_id, int64_t size,
+                            absl::string_view final_name,
+                            UploadCallback callback) = 0;
+  // Replaces the final name recorded in the metadata of the finished object
+  // named `object_name`.
+  virtual void UpdateFinalName(absl::string_view object_name,
+                               absl::string_view final_name,
+                               UploadCallback callback) = 0;
+};
+
+// The state of an upload, shared with its in-flight requests.
+class StreamingUpload;
+
+struct StreamingUploadOptions {
+  // The size of every part but the last. Object stores typically require
+  // parts of at least a few MiB.
+  size_t part_size = 8 * 1024 * 1024;
+  // Once more than this many bytes are waiting to be uploaded, the writer
+  // spills to disk instead of buffering more.
+  size_t max_pending_bytes = 64 * 1024 * 1024;
+};
+
+// An output writer that streams its data to object storage as a resumable
+// upload, instead of writing it to a local file that is uploaded later.
+//
+// Written data is buffered into parts, which are uploaded one at a time. If
+// the upload fails, or falls more than `max_pending_bytes` behind, every byte
+// that has not been uploaded yet, and every later write, is spilled to a
+// writer from `spill_provider` instead. The spilled file is named after the
+// object, with a `.from_<offset>` suffix unless nothing was uploaded, so that
+// the upload can be resumed from it. Spilled data is written without holding
+// the upload's lock, so a slow spill writer does not block the upload's
+// callbacks.
+//
+// Closing the writer finishes the upload. Finishing is retried a few times; if
+// it keeps failing, a `.unfinished` spill file records the ID and size of the
+// upload, whose parts have all been uploaded, so that it can be finished
+// later. As with `AsyncOutputWriter`, the writer may be destroyed before
+// `CloseAsync` completes.
+class StreamingUploadWriter : public OutputWriterInterface {
+ public:
+  // `client` must outlive the upload, i.e. until the writer is closed.
+  StreamingUploadWriter(absl::string_view object_name,
+                        ObjectUploadClientInterface& client,
+                        OutputWriterProvider spill_provider,
+                        StreamingUploadOptions options = {});
+
+  ~StreamingUploadWriter() override;
+
+  // StreamingUploadWriter is neither copyable nor movable.
+  StreamingUploadWriter(const StreamingUploadWriter&) = delete;
+  StreamingUploadWriter& operator=(const StreamingUploadWriter&) = delete;
+
+  void Write(const char* content, std::streamsize size) override;
+  // Blocks until the upload has finished, or the spilled data has been
+  // written.
+  void Close() override;
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed) override;
+
+ private:
+  friend class StreamingSegmentUploader;
+
+  explicit StreamingUploadWriter(std::shared_ptr<StreamingUpload> upload);
+
+  std::shared_ptr<StreamingUpload> upload_;
+  bool closed_ = false;
+};
+
+// Streams media segments to object storage through `StreamingUploadWriter`s,
+// in place of the file output of `MultiUserMediaCollector`.
+//
+// `writer_provider` and `renamer` can be passed to the collector's injecting
+// constructor. Renaming a segment records its final name in the metadata of
+// its object rather than moving any data: the name is recorded when the upload
+// finishes if the segment is renamed while it is open, and updated once the
+// segment has closed otherwise, which is when the collector renames segments.
+// Spilled files are renamed instead, once they have been closed. Segments must
+// not be reopened, so the collector must not limit its open segment files, and
+// every opened segment must be renamed.
+//
+// Updates of final names complete asynchronously; failures are logged.
+class StreamingSegmentUploader {
+ public:
+  using SpillRenamer =
+      absl::AnyInvocable<void(absl::string_view from, absl::string_view to)>;
+
+  // `client` must outlive every writer and every rename. `spill_renamer`
+  // renames spilled files when their segment is renamed.
+  StreamingSegmentUploader(ObjectUploadClientInterface& client,
+                           OutputWriterProvider spill_provider,
+                           SpillRenamer spill_renamer,
+                           StreamingUploadOptions options = {})
+      : client_(client),
+        spill_provider_(std::move(spill_provider)),
+        spill_renamer_(std::move(spill_renamer)),
+        options_(options) {}
+
+  // StreamingSegmentUploader is neither copyable nor movable.
+  StreamingSegmentUploader(const StreamingSegmentUploader&) = delete;
+  StreamingSegmentUploader& operator=(const StreamingSegmentUploader&) =
+      delete;
+
+  // These are thread-safe, so they may be used by a sharded collector. The
+  // uploader must outlive them.
+  OutputWriterProvider writer_provider();
+  absl::AnyInvocable<void(absl::string_view tmp_name,
+                          absl::string_view final_name)>
+  renamer();
+
+ private:
+  std::unique_ptr<OutputWriterInterface> OpenWriter(
+      absl::string_view file_name);
+  void Rename(absl::string_view tmp_name, absl::string_view final_name);
+
+  ObjectUploadClientInterface& client_;
+  // Guards the spill callbacks separately from `mutex_`, since uploads of
+  // different segments may spill concurrently.
+  absl::Mutex spill_mutex_;
+  OutputWriterProvider spill_provider_ ABSL_GUARDED_BY(spill_mutex_);
+  SpillRenamer spill_renamer_ ABSL_GUARDED_BY(spill_mutex_);
+  const StreamingUploadOptions options_;
+  absl::Mutex mutex_;
+  // The uploads of segments that have not been renamed yet, by file name.
+  // Closed uploads are kept until they are renamed. Renamed segments are
+  // removed, so that a new segment can reuse the name.
+  absl::flat_hash_map<std::string, std::shared_ptr<StreamingUpload>> uploads_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_STREAMING_UPLOAD_WRITER_H_
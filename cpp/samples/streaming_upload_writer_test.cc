@@ -0,0 +1,376 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/streaming_upload_writer.h"
+
+#include <cstdint>
+#include <deque>
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "cpp/samples/testing/mock_output_writer.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Records requests so that tests can complete them. Requests are kept in
+// deques, since completing one may append another.
+class FakeObjectUploadClient : public ObjectUploadClientInterface {
+ public:
+  struct Part {
+    std::string upload_id;
+    int64_t offset;
+    std::string data;
+    UploadCallback callback;
+  };
+  struct Finish {
+    std::string upload_id;
+    int64_t size;
+    std::string final_name;
+    UploadCallback callback;
+  };
+  struct FinalNameUpdate {
+    std::string object_name;
+    std::string final_name;
+    UploadCallback callback;
+  };
+
+  void StartUpload(absl::string_view object_name,
+                   StartCallback callback) override {
+    started_objects.push_back(std::string(object_name));
+    start_callbacks.push_back(std::move(callback));
+  }
+  void UploadPart(absl::string_view upload_id, int64_t offset,
+                  absl::string_view part, UploadCallback callback) override {
+    parts.push_back(Part{.upload_id = std::string(upload_id),
+                         .offset = offset,
+                         .data = std::string(part),
+                         .callback = std::move(callback)});
+  }
+  void FinishUpload(absl::string_view upload_id, int64_t size,
+                    absl::string_view final_name,
+                    UploadCallback callback) override {
+    finishes.push_back(Finish{.upload_id = std::string(upload_id),
+                              .size = size,
+                              .final_name = std::string(final_name),
+                              .callback = std::move(callback)});
+  }
+  void UpdateFinalName(absl::string_view object_name,
+                       absl::string_view final_name,
+                       UploadCallback callback) override {
+    final_name_updates.push_back(
+        FinalNameUpdate{.object_name = std::string(object_name),
+                        .final_name = std::string(final_name),
+                        .callback = std::move(callback)});
+  }
+
+  std::vector<std::string> started_objects;
+  std::deque<StartCallback> start_callbacks;
+  std::deque<Part> parts;
+  std::deque<Finish> finishes;
+  std::deque<FinalNameUpdate> final_name_updates;
+};
+
+// Returns a spill writer that appends its writes to `spilled`, and records
+// the names of the spilled files in `spill_file_names`.
+OutputWriterProvider SpillProvider(std::vector<std::string>& spill_file_names,
+                                   std::string& spilled) {
+  return [&spill_file_names, &spilled](absl::string_view file_name) {
+    spill_file_names.push_back(std::string(file_name));
+    auto writer = std::make_unique<MockOutputWriter>();
+    EXPECT_CALL(*writer, Write(_, _))
+        .WillRepeatedly([&spilled](const char* content, std::streamsize size) {
+          spilled.append(content, size);
+        });
+    EXPECT_CALL(*writer, Close);
+    return writer;
+  };
+}
+
+TEST(StreamingUploadWriterTest, UploadsWritesInPartsAndFinishesOnClose) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  StreamingUploadWriter writer("segment.pcm", client,
+                               SpillProvider(spill_file_names, spilled),
+                               {.part_size = 4, .max_pending_bytes = 100});
+  bool closed = false;
+
+  writer.Write("abcdefghij", 10);
+  std::move(client.start_callbacks[0])("upload_id");
+  std::move(client.parts[0].callback)(absl::OkStatus());
+  writer.CloseAsync([&closed]() { closed = true; });
+  std::move(client.parts[1].callback)(absl::OkStatus());
+  std::move(client.parts[2].callback)(absl::OkStatus());
+  ASSERT_EQ(client.finishes.size(), 1);
+  EXPECT_FALSE(closed);
+  std::move(client.finishes[0].callback)(absl::OkStatus());
+
+  EXPECT_TRUE(closed);
+  EXPECT_THAT(client.started_objects, ElementsAre("segment.pcm"));
+  ASSERT_EQ(client.parts.size(), 3);
+  EXPECT_EQ(client.parts[0].upload_id, "upload_id");
+  EXPECT_EQ(client.parts[0].offset, 0);
+  EXPECT_EQ(client.parts[0].data, "abcd");
+  EXPECT_EQ(client.parts[1].offset, 4);
+  EXPECT_EQ(client.parts[1].data, "efgh");
+  EXPECT_EQ(client.parts[2].offset, 8);
+  EXPECT_EQ(client.parts[2].data, "ij");
+  EXPECT_EQ(client.finishes[0].size, 10);
+  EXPECT_EQ(client.finishes[0].final_name, "segment.pcm");
+  EXPECT_THAT(spill_file_names, IsEmpty());
+}
+
+TEST(StreamingUploadWriterTest, SpillsUnuploadedBytesWhenPartUploadFails) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  StreamingUploadWriter writer("segment.pcm", client,
+                               SpillProvider(spill_file_names, spilled),
+                               {.part_size = 4, .max_pending_bytes = 100});
+  bool closed = false;
+
+  writer.Write("abcdefghij", 10);
+  std::move(client.start_callbacks[0])("upload_id");
+  std::move(client.parts[0].callback)(absl::OkStatus());
+  std::move(client.parts[1].callback)(absl::UnavailableError("outage"));
+  writer.Write("kl", 2);
+  writer.CloseAsync([&closed]() { closed = true; });
+
+  EXPECT_TRUE(closed);
+  EXPECT_EQ(client.parts.size(), 2);
+  EXPECT_THAT(client.finishes, IsEmpty());
+  EXPECT_THAT(spill_file_names, ElementsAre("segment.pcm.from_4"));
+  EXPECT_EQ(spilled, "efghijkl");
+}
+
+TEST(StreamingUploadWriterTest, SpillsWholeObjectWhenStartingUploadFails) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  StreamingUploadWriter writer("segment.pcm", client,
+                               SpillProvider(spill_file_names, spilled),
+                               {.part_size = 4, .max_pending_bytes = 100});
+
+  writer.Write("abcdef", 6);
+  std::move(client.start_callbacks[0])(absl::UnavailableError("outage"));
+  writer.Close();
+
+  EXPECT_THAT(client.parts, IsEmpty());
+  EXPECT_THAT(spill_file_names, ElementsAre("segment.pcm"));
+  EXPECT_EQ(spilled, "abcdef");
+}
+
+TEST(StreamingUploadWriterTest, SpillsWhenUploadFallsBehind) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  StreamingUploadWriter writer("segment.pcm", client,
+                               SpillProvider(spill_file_names, spilled),
+                               {.part_size = 4, .max_pending_bytes = 8});
+
+  writer.Write("abcdefgh", 8);
+  EXPECT_THAT(spill_file_names, IsEmpty());
+  writer.Write("i", 1);
+  // Starting the upload completes after the writer spilled, so no part is
+  // uploaded.
+  std::move(client.start_callbacks[0])("upload_id");
+  writer.Close();
+
+  EXPECT_THAT(client.parts, IsEmpty());
+  EXPECT_THAT(spill_file_names, ElementsAre("segment.pcm"));
+  EXPECT_EQ(spilled, "abcdefghi");
+}
+
+TEST(StreamingUploadWriterTest, RetriesFinishingUpload) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  StreamingUploadWriter writer("segment.pcm", client,
+                               SpillProvider(spill_file_names, spilled),
+                               {.part_size = 4, .max_pending_bytes = 100});
+  bool closed = false;
+
+  writer.Write("ab", 2);
+  std::move(client.start_callbacks[0])("upload_id");
+  writer.CloseAsync([&closed]() { closed = true; });
+  std::move(client.parts[0].callback)(absl::OkStatus());
+  std::move(client.finishes[0].callback)(absl::UnavailableError("outage"));
+  ASSERT_EQ(client.finishes.size(), 2);
+  EXPECT_FALSE(closed);
+  std::move(client.finishes[1].callback)(absl::OkStatus());
+
+  EXPECT_TRUE(closed);
+  EXPECT_EQ(client.finishes[1].upload_id, "upload_id");
+  EXPECT_EQ(client.finishes[1].size, 2);
+  EXPECT_THAT(spill_file_names, IsEmpty());
+}
+
+TEST(StreamingUploadWriterTest, RecordsUploadIdWhenFinishingKeepsFailing) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  StreamingUploadWriter writer("segment.pcm", client,
+                               SpillProvider(spill_file_names, spilled),
+                               {.part_size = 4, .max_pending_bytes = 100});
+  bool closed = false;
+
+  writer.Write("ab", 2);
+  std::move(client.start_callbacks[0])("upload_id");
+  writer.CloseAsync([&closed]() { closed = true; });
+  std::move(client.parts[0].callback)(absl::OkStatus());
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(client.finishes.size(), i + 1);
+    std::move(client.finishes[i].callback)(absl::UnavailableError("outage"));
+  }
+
+  EXPECT_TRUE(closed);
+  EXPECT_EQ(client.finishes.size(), 3);
+  EXPECT_THAT(spill_file_names, ElementsAre("segment.pcm.unfinished"));
+  EXPECT_EQ(spilled, "upload_id: upload_id\nsize: 2\n");
+}
+
+TEST(StreamingSegmentUploaderTest, RenameRecordsFinalNameWhenFinishing) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  StreamingSegmentUploader uploader(
+      client, SpillProvider(spill_file_names, spilled),
+      [](absl::string_view, absl::string_view) {
+        ADD_FAILURE() << "Unexpected spill rename.";
+      });
+  OutputWriterProvider writer_provider = uploader.writer_provider();
+  auto renamer = uploader.renamer();
+
+  std::unique_ptr<OutputWriterInterface> writer =
+      writer_provider("segment.tmp");
+  writer->Write("ab", 2);
+  renamer("segment.tmp", "segment.pcm");
+  writer->CloseAsync([] {});
+  writer.reset();
+  std::move(client.start_callbacks[0])("upload_id");
+  std::move(client.parts[0].callback)(absl::OkStatus());
+
+  ASSERT_EQ(client.finishes.size(), 1);
+  EXPECT_EQ(client.finishes[0].size, 2);
+  EXPECT_EQ(client.finishes[0].final_name, "segment.pcm");
+  std::move(client.finishes[0].callback)(absl::OkStatus());
+  EXPECT_THAT(client.final_name_updates, IsEmpty());
+}
+
+TEST(StreamingSegmentUploaderTest, RenameAfterCloseUpdatesFinalName) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  StreamingSegmentUploader uploader(
+      client, SpillProvider(spill_file_names, spilled),
+      [](absl::string_view, absl::string_view) {
+        ADD_FAILURE() << "Unexpected spill rename.";
+      });
+  OutputWriterProvider writer_provider = uploader.writer_provider();
+  auto renamer = uploader.renamer();
+  bool closed = false;
+
+  std::unique_ptr<OutputWriterInterface> writer =
+      writer_provider("segment.tmp");
+  writer->Write("ab", 2);
+  writer->CloseAsync([&closed]() { closed = true; });
+  writer.reset();
+  std::move(client.start_callbacks[0])("upload_id");
+  std::move(client.parts[0].callback)(absl::OkStatus());
+  ASSERT_EQ(client.finishes.size(), 1);
+  std::move(client.finishes[0].callback)(absl::OkStatus());
+  ASSERT_TRUE(closed);
+  renamer("segment.tmp", "segment.pcm");
+
+  EXPECT_EQ(client.finishes[0].final_name, "segment.tmp");
+  ASSERT_EQ(client.final_name_updates.size(), 1);
+  EXPECT_EQ(client.final_name_updates[0].object_name, "segment.tmp");
+  EXPECT_EQ(client.final_name_updates[0].final_name, "segment.pcm");
+  std::move(client.final_name_updates[0].callback)(absl::OkStatus());
+}
+
+TEST(StreamingSegmentUploaderTest, RenamesSpilledFiles) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  std::vector<std::pair<std::string, std::string>> spill_renames;
+  StreamingSegmentUploader uploader(
+      client, SpillProvider(spill_file_names, spilled),
+      [&spill_renames](absl::string_view from, absl::string_view to) {
+        spill_renames.emplace_back(from, to);
+      },
+      {.part_size = 2, .max_pending_bytes = 100});
+  OutputWriterProvider writer_provider = uploader.writer_provider();
+  auto renamer = uploader.renamer();
+
+  std::unique_ptr<OutputWriterInterface> writer =
+      writer_provider("segment.tmp");
+  writer->Write("abcd", 4);
+  std::move(client.start_callbacks[0])("upload_id");
+  std::move(client.parts[0].callback)(absl::OkStatus());
+  std::move(client.parts[1].callback)(absl::UnavailableError("outage"));
+  writer->Close();
+  renamer("segment.tmp", "segment.pcm");
+
+  EXPECT_THAT(client.final_name_updates, IsEmpty());
+  EXPECT_THAT(spill_file_names, ElementsAre("segment.tmp.from_2"));
+  EXPECT_EQ(spilled, "cd");
+  EXPECT_THAT(spill_renames, ElementsAre(std::make_pair("segment.tmp.from_2",
+                                                        "segment.pcm.from_2")));
+}
+
+TEST(StreamingSegmentUploaderTest, RenamesSpilledFilesOnceClosed) {
+  FakeObjectUploadClient client;
+  std::vector<std::string> spill_file_names;
+  std::string spilled;
+  std::vector<std::pair<std::string, std::string>> spill_renames;
+  StreamingSegmentUploader uploader(
+      client, SpillProvider(spill_file_names, spilled),
+      [&spill_renames](absl::string_view from, absl::string_view to) {
+        spill_renames.emplace_back(from, to);
+      });
+  OutputWriterProvider writer_provider = uploader.writer_provider();
+  auto renamer = uploader.renamer();
+
+  std::unique_ptr<OutputWriterInterface> writer =
+      writer_provider("segment.tmp");
+  writer->Write("ab", 2);
+  std::move(client.start_callbacks[0])(absl::UnavailableError("outage"));
+  renamer("segment.tmp", "segment.pcm");
+  EXPECT_THAT(spill_renames, IsEmpty());
+  writer->Close();
+
+  EXPECT_THAT(spill_file_names, ElementsAre("segment.tmp"));
+  EXPECT_THAT(spill_renames,
+              ElementsAre(std::make_pair("segment.tmp", "segment.pcm")));
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_STRING_INTERNER_H_
+#define CPP_SAMPLES_STRING_INTERNER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace media_api_samples {
+
+// Stores a single copy of every distinct string and hands out reference
+// counted handles to it.
+//
+// Identifiers that are referenced from many places, such as a participant key
+// shared by the participant and all of its media entries, are allocated once
+// and compared by identity. A string is released when its last handle is
+// destroyed, so long sessions do not accumulate the keys of departed
+// participants.
+//
+// The interner must outlive its handles. This class is not thread-safe, and
+// neither are the handles it returns.
+class StringInterner {
+ private:
+  struct Entry {
+    std::string value;
+    int references = 0;
+  };
+
+ public:
+  // A reference to an interned string. Handles of the same interner are equal
+  // if and only if their strings are equal. Default-constructed handles refer
+  // to the empty string and are only equal to each other.
+  class Handle {
+   public:
+    Handle() = default;
+    Handle(const Handle& other)
+        : interner_(other.interner_), entry_(other.entry_) {
+      if (entry_ != nullptr) {
+        ++entry_->references;
+      }
+    }
+    Handle(Handle&& other)
+        : interner_(std::exchange(other.interner_, nullptr)),
+          entry_(std::exchange(other.entry_, nullptr)) {}
+    Handle& operator=(Handle other) {
+      std::swap(interner_, other.interner_);
+      std::swap(entry_, other.entry_);
+      return *this;
+    }
+    ~Handle() {
+      if (entry_ != nullptr && --entry_->references == 0) {
+        interner_->entries_.erase(entry_->value);
+      }
+    }
+
+    // Remains valid as long as any handle to the string exists.
+    absl::string_view value() const {
+      return entry_ != nullptr ? absl::string_view(entry_->value)
+                               : absl::string_view();
+    }
+
+    friend bool operator==(const Handle& lhs, const Handle& rhs) {
+      return lhs.entry_ == rhs.entry_;
+    }
+
+   private:
+    friend class StringInterner;
+
+    Handle(StringInterner* interner, Entry* entry)
+        : interner_(interner), entry_(entry) {
+      ++entry_->references;
+    }
+
+    StringInterner* interner_ = nullptr;
+    Entry* entry_ = nullptr;
+  };
+
+  StringInterner() = default;
+
+  // StringInterner is neither copyable nor movable, since its handles point
+  // to it.
+  StringInterner(const StringInterner&) = delete;
+  StringInterner& operator=(const StringInterner&) = delete;
+
+  // Returns a handle to the interned copy of `value`, copying it only if it is
+  // not interned already.
+  Handle Intern(absl::string_view value) {
+    auto it = entries_.find(value);
+    if (it == entries_.end()) {
+      auto entry = std::make_unique<Entry>(Entry{.value = std::string(value)});
+      absl::string_view key = entry->value;
+      it = entries_.emplace(key, std::move(entry)).first;
+    }
+    return Handle(this, it->second.get());
+  }
+
+  // The number of distinct strings with live handles.
+  size_t size() const { return entries_.size(); }
+
+ private:
+  // Keys view the values of their entries, which are heap allocated so that
+  // they do not move when the map is rehashed.
+  absl::flat_hash_map<absl::string_view, std::unique_ptr<Entry>> entries_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_STRING_INTERNER_H_
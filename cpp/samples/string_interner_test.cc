@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/string_interner.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+
+namespace media_api_samples {
+namespace {
+
+TEST(StringInternerTest, InternReturnsEqualHandlesForEqualStrings) {
+  StringInterner interner;
+
+  StringInterner::Handle first = interner.Intern(std::string("key"));
+  StringInterner::Handle second = interner.Intern(std::string("key"));
+
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(first.value().data(), second.value().data());
+  EXPECT_EQ(first.value(), "key");
+  EXPECT_EQ(interner.size(), 1);
+}
+
+TEST(StringInternerTest, InternReturnsDifferentHandlesForDifferentStrings) {
+  StringInterner interner;
+
+  StringInterner::Handle first = interner.Intern("key1");
+  StringInterner::Handle second = interner.Intern("key2");
+
+  EXPECT_FALSE(first == second);
+  EXPECT_EQ(first.value(), "key1");
+  EXPECT_EQ(second.value(), "key2");
+  EXPECT_EQ(interner.size(), 2);
+}
+
+TEST(StringInternerTest, ReleasesStringWithLastHandle) {
+  StringInterner interner;
+  StringInterner::Handle handle = interner.Intern("key");
+  StringInterner::Handle copy = handle;
+
+  handle = StringInterner::Handle();
+  EXPECT_EQ(interner.size(), 1);
+  EXPECT_EQ(copy.value(), "key");
+
+  copy = StringInterner::Handle();
+  EXPECT_EQ(interner.size(), 0);
+}
+
+TEST(StringInternerTest, MovedHandleKeepsString) {
+  StringInterner interner;
+  StringInterner::Handle handle = interner.Intern("key");
+
+  StringInterner::Handle moved = std::move(handle);
+
+  EXPECT_EQ(moved.value(), "key");
+  EXPECT_EQ(interner.size(), 1);
+}
+
+TEST(StringInternerTest, DefaultHandleIsEmpty) {
+  StringInterner interner;
+
+  StringInterner::Handle handle;
+
+  EXPECT_EQ(handle.value(), "");
+  EXPECT_FALSE(handle == interner.Intern(""));
+}
+
+TEST(StringInternerTest, ValuesRemainValidWhenTableGrows) {
+  StringInterner interner;
+  StringInterner::Handle first = interner.Intern("key");
+  absl::string_view first_value = first.value();
+
+  std::vector<StringInterner::Handle> handles;
+  for (int i = 0; i < 1000; ++i) {
+    handles.push_back(interner.Intern(std::to_string(i)));
+  }
+
+  EXPECT_EQ(first.value().data(), first_value.data());
+  EXPECT_EQ(interner.Intern("key"), first);
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -18,8 +18,11 @@
 #define CPP_SAMPLES_TESTING_MOCK_OUTPUT_FILE_H_
 
 #include <ios>
+#include <tuple>
 
 #include "gmock/gmock.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
 #include "cpp/samples/output_writer_interface.h"
 
 namespace media_api_samples {
@@ -31,6 +34,15 @@ class MockOutputWriter : public OutputWriterInterface {
   MOCK_METHOD(void, Close, (), (override));
 };
 
+// Matches the `(content, size)` arguments of writes of WAV and Y4M file headers
+// and Y4M frame markers, so that tests can expect only the media written after
+// them.
+MATCHER(IsContainerFraming, "") {
+  absl::string_view data(std::get<0>(arg), std::get<1>(arg));
+  return absl::StartsWith(data, "RIFF") ||
+         absl::StartsWith(data, "YUV4MPEG2") || data == "FRAME\n";
+}
+
 }  // namespace media_api_samples
 
 #endif  // CPP_SAMPLES_TESTING_MOCK_OUTPUT_FILE_H_
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/video_frame_batcher.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/units/time_delta.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+
+absl::StatusOr<rtc::scoped_refptr<VideoFrameBatcher>> VideoFrameBatcher::Create(
+    VideoFrameBatcherOptions options, BatchCallback batch_callback,
+    rtc::scoped_refptr<meet::MediaApiClientObserverInterface> observer) {
+  if (options.max_batch_size == 0) {
+    return absl::InvalidArgumentError(
+        "Video frame batch size must be greater than 0");
+  }
+  if (options.max_batch_delay <= absl::ZeroDuration()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Video frame batch delay must be positive; got ",
+                     absl::FormatDuration(options.max_batch_delay)));
+  }
+  if (options.width <= 0 || options.height <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Video frame batch resolution must be positive; got ",
+                     options.width, "x", options.height));
+  }
+  if (observer == nullptr) {
+    return absl::InvalidArgumentError("Observer is null");
+  }
+
+  std::unique_ptr<rtc::Thread> batch_thread = rtc::Thread::Create();
+  batch_thread->SetName("video_frame_batch_thread", nullptr);
+  if (!batch_thread->Start()) {
+    return absl::InternalError("Failed to start video frame batch thread");
+  }
+  return rtc::make_ref_counted<VideoFrameBatcher>(
+      std::move(options), std::move(batch_callback), std::move(observer),
+      std::move(batch_thread));
+}
+
+void VideoFrameBatcher::OnJoined() { observer_->OnJoined(); }
+
+void VideoFrameBatcher::OnJoined(const meet::JoinTimings& timings) {
+  observer_->OnJoined(timings);
+}
+
+void VideoFrameBatcher::OnDisconnected(absl::Status status) {
+  Flush();
+  observer_->OnDisconnected(std::move(status));
+}
+
+void VideoFrameBatcher::OnResourceUpdate(meet::ResourceUpdate update) {
+  observer_->OnResourceUpdate(std::move(update));
+}
+
+void VideoFrameBatcher::OnAudioFrame(meet::AudioFrame frame) {
+  observer_->OnAudioFrame(std::move(frame));
+}
+
+void VideoFrameBatcher::OnEncodedAudioFrame(meet::EncodedAudioFrame frame) {
+  observer_->OnEncodedAudioFrame(std::move(frame));
+}
+
+void VideoFrameBatcher::OnVideoFrame(meet::VideoFrame frame) {
+  // Frames are delivered on the decoding threads of their streams, so they are
+  // converted and scaled on the batch thread, where the pool can be used
+  // without locking.
+  frame_queue_.Enqueue(
+      frame.contributing_source,
+      [this, buffer = frame.frame.video_frame_buffer(),
+       contributing_source = frame.contributing_source,
+       synchronization_source = frame.synchronization_source,
+       receive_time = frame.receive_time]() mutable {
+        HandleVideoFrame(std::move(buffer), contributing_source,
+                         synchronization_source, receive_time);
+      });
+}
+
+void VideoFrameBatcher::OnEncodedVideoFrame(meet::EncodedVideoFrame frame) {
+  observer_->OnEncodedVideoFrame(std::move(frame));
+}
+
+void VideoFrameBatcher::Flush() {
+  absl::Notification flushed;
+  frame_queue_.PostAfterQueuedFrames([this, &flushed] {
+    if (!batch_.empty()) {
+      DeliverBatch();
+    }
+    flushed.Notify();
+  });
+  flushed.WaitForNotification();
+}
+
+void VideoFrameBatcher::HandleVideoFrame(
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    uint32_t contributing_source, uint32_t synchronization_source,
+    absl::Time receive_time) {
+  DCHECK(batch_thread_->IsCurrent());
+
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+      buffer_pool_.ToI420(*buffer);
+  if (i420 == nullptr) {
+    LOG(ERROR) << "Failed to convert video frame buffer to I420.";
+    return;
+  }
+  batch_.push_back(BatchedVideoFrame{
+      .buffer =
+          buffer_pool_.Scale(std::move(i420), options_.width, options_.height),
+      .contributing_source = contributing_source,
+      .synchronization_source = synchronization_source,
+      .receive_time = receive_time});
+
+  if (batch_.size() >= options_.max_batch_size) {
+    DeliverBatch();
+    return;
+  }
+  if (batch_.size() == 1) {
+    batch_thread_->PostDelayedTask(
+        [this, batch_id = batch_id_] {
+          if (batch_id == batch_id_ && !batch_.empty()) {
+            DeliverBatch();
+          }
+        },
+        webrtc::TimeDelta::Micros(
+            absl::ToInt64Microseconds(options_.max_batch_delay)));
+  }
+}
+
+void VideoFrameBatcher::DeliverBatch() {
+  DCHECK(batch_thread_->IsCurrent());
+
+  ++batch_id_;
+  std::vector<BatchedVideoFrame> batch = std::move(batch_);
+  batch_.clear();
+  batch_.reserve(options_.max_batch_size);
+  batch_callback_(std::move(batch));
+}
+
+}  // namespace media_api_samples
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_VIDEO_FRAME_BATCHER_H_
+#define CPP_SAMPLES_VIDEO_FRAME_BATCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/samples/frame_queue.h"
+#include "cpp/samples/i420_buffer_pool.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+
+struct VideoFrameBatcherOptions {
+  // The most frames in a batch. A batch is delivered as soon as it is full.
+  size_t max_batch_size = 8;
+  // How long the first frame of a batch waits for the batch to fill before the
+  // partial batch is delivered.
+  absl::Duration max_batch_delay = absl::Milliseconds(33);
+  // The resolution that every batched frame is scaled to. The aspect ratio of
+  // frames is not preserved.
+  int width = 640;
+  int height = 360;
+  // Bounds the frames of each contributing source that are waiting to be
+  // batched, e.g. while the batch callback is slow.
+  FrameQueueOptions frame_queue = kDefaultVideoFrameQueueOptions;
+};
+
+// A received video frame, scaled to the resolution of its batch.
+struct BatchedVideoFrame {
+  rtc::scoped_refptr<webrtc::I420BufferInterface> buffer;
+  uint32_t contributing_source = 0;
+  uint32_t synchronization_source = 0;
+  absl::Time receive_time = absl::InfinitePast();
+};
+
+// An observer that groups the decoded video frames of all of a client's
+// streams into batches of a common resolution, e.g. for running inference on
+// a GPU, and forwards every other callback to another observer.
+//
+// Frames are converted to I420 and scaled on the batcher's thread, into pooled
+// buffers, and batches are delivered to the batch callback on the same thread.
+// A batch is delivered once it holds `max_batch_size` frames or its first
+// frame has waited for `max_batch_delay`, whichever comes first, and the
+// remaining frames are delivered before `OnDisconnected` is forwarded. Frames
+// waiting for the batch thread are queued per contributing source, and by
+// default the oldest are dropped once a source falls a second behind.
+class VideoFrameBatcher : public meet::MediaApiClientObserverInterface {
+ public:
+  using BatchCallback =
+      absl::AnyInvocable<void(std::vector<BatchedVideoFrame> batch)>;
+
+  // Creates a batcher with its own batching thread.
+  static absl::StatusOr<rtc::scoped_refptr<VideoFrameBatcher>> Create(
+      VideoFrameBatcherOptions options, BatchCallback batch_callback,
+      rtc::scoped_refptr<meet::MediaApiClientObserverInterface> observer);
+
+  // Constructor that allows injecting the batching thread, useful for testing.
+  // `options` must be valid; see `Create`.
+  VideoFrameBatcher(
+      VideoFrameBatcherOptions options, BatchCallback batch_callback,
+      rtc::scoped_refptr<meet::MediaApiClientObserverInterface> observer,
+      std::unique_ptr<rtc::Thread> batch_thread)
+      : options_(std::move(options)),
+        batch_callback_(std::move(batch_callback)),
+        observer_(std::move(observer)),
+        // Delivered batches hold on to their buffers until the batch callback
+        // releases them, so allow two batches of buffers to be in use.
+        buffer_pool_(2 * options_.max_batch_size),
+        batch_thread_(std::move(batch_thread)),
+        frame_queue_(batch_thread_.get(), options_.frame_queue) {}
+
+  ~VideoFrameBatcher() override {
+    // Stop the thread to ensure that queued frames and pending batch deadlines
+    // do not access member fields after they have been destroyed.
+    batch_thread_->Stop();
+  }
+
+  // VideoFrameBatcher is neither copyable nor movable.
+  VideoFrameBatcher(const VideoFrameBatcher&) = delete;
+  VideoFrameBatcher& operator=(const VideoFrameBatcher&) = delete;
+
+  void OnJoined() override;
+  void OnJoined(const meet::JoinTimings& timings) override;
+  void OnDisconnected(absl::Status status) override;
+  void OnResourceUpdate(meet::ResourceUpdate update) override;
+  void OnAudioFrame(meet::AudioFrame frame) override;
+  void OnEncodedAudioFrame(meet::EncodedAudioFrame frame) override;
+  void OnVideoFrame(meet::VideoFrame frame) override;
+  void OnEncodedVideoFrame(meet::EncodedVideoFrame frame) override;
+
+  // Delivers the frames received so far without waiting for their batch to
+  // fill. Blocks until the batch has been delivered.
+  void Flush();
+
+  // Includes the frames dropped because their source's queue was full.
+  FrameQueueStats GetFrameQueueStats() const {
+    return frame_queue_.GetStats();
+  }
+
+ private:
+  void HandleVideoFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+                        uint32_t contributing_source,
+                        uint32_t synchronization_source,
+                        absl::Time receive_time);
+  void DeliverBatch();
+
+  const VideoFrameBatcherOptions options_;
+  BatchCallback batch_callback_;
+  rtc::scoped_refptr<meet::MediaApiClientObserverInterface> observer_;
+
+  // Only accessed on `batch_thread_`.
+  I420BufferPool buffer_pool_;
+  std::vector<BatchedVideoFrame> batch_;
+  // Identifies the current batch, so that the deadline of a batch that was
+  // already delivered because it filled up does not deliver its successor.
+  uint64_t batch_id_ = 0;
+
+  std::unique_ptr<rtc::Thread> batch_thread_;
+  FrameQueue frame_queue_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_VIDEO_FRAME_BATCHER_H_
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/video_frame_batcher.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "cpp/api/media_api_client_interface.h"
+#include "cpp/internal/testing/mock_media_api_client_observer.h"
+#include "webrtc/api/make_ref_counted.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+using ::testing::status::StatusIs;
+
+webrtc::VideoFrame CreateWebRtcFrame(int width, int height) {
+  return webrtc::VideoFrame::Builder()
+      .set_video_frame_buffer(webrtc::I420Buffer::Create(width, height))
+      .build();
+}
+
+// Returns the CSRC and resolution of every frame of `batch`.
+std::vector<std::pair<uint32_t, std::pair<int, int>>> DescribeBatch(
+    const std::vector<BatchedVideoFrame>& batch) {
+  std::vector<std::pair<uint32_t, std::pair<int, int>>> description;
+  for (const BatchedVideoFrame& frame : batch) {
+    description.emplace_back(
+        frame.contributing_source,
+        std::make_pair(frame.buffer->width(), frame.buffer->height()));
+  }
+  return description;
+}
+
+TEST(VideoFrameBatcherTest, DeliversFullBatchesScaledToCommonResolution) {
+  std::vector<std::vector<BatchedVideoFrame>> batches;
+  absl::Notification batch_delivered;
+  absl::StatusOr<rtc::scoped_refptr<VideoFrameBatcher>> batcher =
+      VideoFrameBatcher::Create(
+          {.max_batch_size = 2,
+           .max_batch_delay = absl::Hours(1),
+           .width = 64,
+           .height = 36},
+          [&](std::vector<BatchedVideoFrame> batch) {
+            batches.push_back(std::move(batch));
+            batch_delivered.Notify();
+          },
+          webrtc::make_ref_counted<meet::MockMediaApiClientObserver>());
+  ASSERT_OK(batcher);
+
+  webrtc::VideoFrame large_frame = CreateWebRtcFrame(1280, 720);
+  webrtc::VideoFrame small_frame = CreateWebRtcFrame(32, 18);
+  (*batcher)->OnVideoFrame(
+      meet::VideoFrame{.frame = large_frame, .contributing_source = 1});
+  (*batcher)->OnVideoFrame(
+      meet::VideoFrame{.frame = small_frame, .contributing_source = 2});
+
+  ASSERT_TRUE(batch_delivered.WaitForNotificationWithTimeout(absl::Seconds(5)));
+  ASSERT_EQ(batches.size(), 1);
+  EXPECT_THAT(DescribeBatch(batches[0]),
+              ElementsAre(Pair(1, Pair(64, 36)), Pair(2, Pair(64, 36))));
+}
+
+TEST(VideoFrameBatcherTest, DeliversPartialBatchAfterMaxBatchDelay) {
+  absl::Notification batch_delivered;
+  size_t batch_size = 0;
+  absl::StatusOr<rtc::scoped_refptr<VideoFrameBatcher>> batcher =
+      VideoFrameBatcher::Create(
+          {.max_batch_size = 8, .max_batch_delay = absl::Milliseconds(10)},
+          [&](std::vector<BatchedVideoFrame> batch) {
+            batch_size = batch.size();
+            batch_delivered.Notify();
+          },
+          webrtc::make_ref_counted<meet::MockMediaApiClientObserver>());
+  ASSERT_OK(batcher);
+
+  webrtc::VideoFrame frame = CreateWebRtcFrame(640, 360);
+  (*batcher)->OnVideoFrame(meet::VideoFrame{.frame = frame});
+
+  ASSERT_TRUE(batch_delivered.WaitForNotificationWithTimeout(absl::Seconds(5)));
+  EXPECT_EQ(batch_size, 1);
+}
+
+TEST(VideoFrameBatcherTest, DeliversRemainingFramesBeforeDisconnecting) {
+  std::vector<std::string> events;
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnDisconnected).WillOnce([&](absl::Status status) {
+    events.push_back("disconnected");
+  });
+  absl::StatusOr<rtc::scoped_refptr<VideoFrameBatcher>> batcher =
+      VideoFrameBatcher::Create(
+          {.max_batch_size = 8, .max_batch_delay = absl::Hours(1)},
+          [&](std::vector<BatchedVideoFrame> batch) {
+            events.push_back(absl::StrCat("batch of ", batch.size()));
+          },
+          observer);
+  ASSERT_OK(batcher);
+
+  webrtc::VideoFrame frame = CreateWebRtcFrame(640, 360);
+  (*batcher)->OnVideoFrame(meet::VideoFrame{.frame = frame});
+  (*batcher)->OnVideoFrame(meet::VideoFrame{.frame = frame});
+  (*batcher)->OnDisconnected(absl::OkStatus());
+
+  EXPECT_THAT(events, ElementsAre("batch of 2", "disconnected"));
+}
+
+TEST(VideoFrameBatcherTest, DropsOldestFramesOfSourceThatFallsBehind) {
+  std::vector<absl::Time> receive_times;
+  std::unique_ptr<rtc::Thread> batch_thread = rtc::Thread::Create();
+  ASSERT_TRUE(batch_thread->Start());
+  absl::Notification release;
+  batch_thread->PostTask([&release] { release.WaitForNotification(); });
+  auto batcher = webrtc::make_ref_counted<VideoFrameBatcher>(
+      VideoFrameBatcherOptions{
+          .max_batch_size = 8,
+          .max_batch_delay = absl::Hours(1),
+          .frame_queue = {.policy = FrameQueuePolicy::kDropOldest,
+                          .max_frames_per_source = 2}},
+      [&](std::vector<BatchedVideoFrame> batch) {
+        for (const BatchedVideoFrame& frame : batch) {
+          receive_times.push_back(frame.receive_time);
+        }
+      },
+      webrtc::make_ref_counted<meet::MockMediaApiClientObserver>(),
+      std::move(batch_thread));
+
+  webrtc::VideoFrame frame = CreateWebRtcFrame(640, 360);
+  for (int i = 0; i < 5; ++i) {
+    batcher->OnVideoFrame(
+        meet::VideoFrame{.frame = frame,
+                         .contributing_source = 1,
+                         .receive_time = absl::FromUnixSeconds(i)});
+  }
+  release.Notify();
+  batcher->Flush();
+
+  EXPECT_THAT(receive_times,
+              ElementsAre(absl::FromUnixSeconds(3), absl::FromUnixSeconds(4)));
+  EXPECT_EQ(batcher->GetFrameQueueStats().dropped_frames, 3);
+}
+
+TEST(VideoFrameBatcherTest, ForwardsOtherCallbacksToObserver) {
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+  EXPECT_CALL(*observer, OnJoined);
+  EXPECT_CALL(*observer, OnAudioFrame);
+  absl::StatusOr<rtc::scoped_refptr<VideoFrameBatcher>> batcher =
+      VideoFrameBatcher::Create(
+          {}, [](std::vector<BatchedVideoFrame> batch) {}, observer);
+  ASSERT_OK(batcher);
+
+  (*batcher)->OnJoined();
+  (*batcher)->OnAudioFrame(meet::AudioFrame{});
+}
+
+TEST(VideoFrameBatcherTest, CreateRejectsInvalidOptions) {
+  auto observer = webrtc::make_ref_counted<meet::MockMediaApiClientObserver>();
+
+  EXPECT_THAT(VideoFrameBatcher::Create(
+                  {.max_batch_size = 0},
+                  [](std::vector<BatchedVideoFrame> batch) {}, observer),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Video frame batch size must be greater than 0"));
+  EXPECT_THAT(VideoFrameBatcher::Create(
+                  {.max_batch_delay = absl::ZeroDuration()},
+                  [](std::vector<BatchedVideoFrame> batch) {}, observer),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Video frame batch delay must be positive; got 0"));
+  EXPECT_THAT(VideoFrameBatcher::Create(
+                  {.width = 0}, [](std::vector<BatchedVideoFrame> batch) {},
+                  observer),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Video frame batch resolution must be positive; got "
+                       "0x360"));
+  EXPECT_THAT(
+      VideoFrameBatcher::Create(
+          {}, [](std::vector<BatchedVideoFrame> batch) {}, nullptr),
+      StatusIs(absl::StatusCode::kInvalidArgument, "Observer is null"));
+}
+
+}  // namespace
+}  // namespace media_api_samples
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/video_segment_encoder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "cpp/samples/media_writing.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "webrtc/api/environment/environment.h"
+#include "webrtc/api/environment/environment_factory.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/encoded_image.h"
+#include "webrtc/api/video/video_bitrate_allocation.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/api/video_codecs/scalability_mode.h"
+#include "webrtc/api/video_codecs/sdp_video_format.h"
+#include "webrtc/api/video_codecs/video_codec.h"
+#include "webrtc/api/video_codecs/video_encoder.h"
+#include "webrtc/api/video_codecs/video_encoder_factory_template.h"
+#include "webrtc/api/video_codecs/video_encoder_factory_template_libaom_av1_adapter.h"
+#include "webrtc/api/video_codecs/video_encoder_factory_template_libvpx_vp8_adapter.h"
+#include "webrtc/api/video_codecs/video_encoder_factory_template_libvpx_vp9_adapter.h"
+#include "webrtc/modules/video_coding/include/video_error_codes.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+// IVF timestamps use the 90kHz RTP video clock.
+constexpr int64_t kRtpTicksPerSecond = 90000;
+constexpr int kMaxQp = 56;
+// Encoded frames are written whole, so the payload size only matters to
+// encoders that split frames into RTP packets themselves.
+constexpr size_t kMaxPayloadSize = 1200;
+
+using SoftwareVideoEncoderFactory = webrtc::VideoEncoderFactoryTemplate<
+    webrtc::LibvpxVp8EncoderTemplateAdapter,
+    webrtc::LibvpxVp9EncoderTemplateAdapter,
+    webrtc::LibaomAv1EncoderTemplateAdapter>;
+
+// Single layer, realtime settings for encoding a segment of `width`x`height`
+// frames.
+webrtc::VideoCodec CodecSettings(
+    const VideoEncodingConfiguration& configuration, int width, int height) {
+  webrtc::VideoCodec codec_settings;
+  codec_settings.codecType =
+      webrtc::PayloadStringToCodecType(configuration.codec_name);
+  codec_settings.width = width;
+  codec_settings.height = height;
+  codec_settings.startBitrate = configuration.target_bitrate_kbps;
+  codec_settings.maxBitrate = configuration.target_bitrate_kbps;
+  codec_settings.minBitrate = 0;
+  codec_settings.maxFramerate = configuration.max_frame_rate;
+  codec_settings.qpMax = kMaxQp;
+  codec_settings.numberOfSimulcastStreams = 0;
+  codec_settings.mode = webrtc::VideoCodecMode::kRealtimeVideo;
+  codec_settings.SetScalabilityMode(webrtc::ScalabilityMode::kL1T1);
+  switch (codec_settings.codecType) {
+    case webrtc::kVideoCodecVP8:
+      *codec_settings.VP8() = webrtc::VideoEncoder::GetDefaultVp8Settings();
+      break;
+    case webrtc::kVideoCodecVP9:
+      *codec_settings.VP9() = webrtc::VideoEncoder::GetDefaultVp9Settings();
+      codec_settings.VP9()->numberOfSpatialLayers = 1;
+      codec_settings.VP9()->numberOfTemporalLayers = 1;
+      break;
+    default:
+      break;
+  }
+  return codec_settings;
+}
+
+}  // namespace
+
+webrtc::EncodedImageCallback::Result
+VideoSegmentEncoder::State::OnEncodedImage(
+    const webrtc::EncodedImage& encoded_image,
+    const webrtc::CodecSpecificInfo* codec_specific_info) {
+  WriteIvfFrame(absl::MakeConstSpan(encoded_image.data(), encoded_image.size()),
+                encoded_image.RtpTimestamp(), *writer);
+  return Result(Result::OK);
+}
+
+void VideoSegmentEncoder::Encode(
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    absl::Time received_time) {
+  if (state_->queued_frames.fetch_add(1) >= state_->max_queued_frames) {
+    state_->queued_frames.fetch_sub(1);
+    LOG_EVERY_N_SEC(WARNING, 10)
+        << "Video encoder is falling behind; dropping frame.";
+    return;
+  }
+
+  if (first_frame_time_ == absl::InfinitePast()) {
+    first_frame_time_ = received_time;
+  }
+  // RTP timestamps wrap around, as players expect.
+  auto rtp_timestamp = static_cast<uint32_t>(
+      absl::ToInt64Microseconds(received_time - first_frame_time_) *
+      kRtpTicksPerSecond / absl::ToInt64Microseconds(absl::Seconds(1)));
+  thread_->PostTask([state = state_, buffer = std::move(buffer), rtp_timestamp,
+                     timestamp_us = absl::ToUnixMicros(received_time)]() {
+    if (state->encoder != nullptr) {
+      webrtc::VideoFrame frame = webrtc::VideoFrame::Builder()
+                                     .set_video_frame_buffer(buffer)
+                                     .set_rtp_timestamp(rtp_timestamp)
+                                     .set_timestamp_us(timestamp_us)
+                                     .build();
+      if (state->encoder->Encode(frame, /*frame_types=*/nullptr) !=
+          WEBRTC_VIDEO_CODEC_OK) {
+        LOG_EVERY_N_SEC(ERROR, 10) << "Failed to encode video frame.";
+      }
+    }
+    state->queued_frames.fetch_sub(1);
+  });
+}
+
+void VideoSegmentEncoder::CloseAsync(absl::AnyInvocable<void() &&> on_closed) {
+  closed_ = true;
+  thread_->PostTask([pool = pool_, state = state_,
+                     on_closed = std::move(on_closed)]() mutable {
+    if (state->encoder != nullptr) {
+      // Frames are encoded without lookahead, so every queued frame has
+      // already been written and the encoder can be reused immediately.
+      state->encoder->RegisterEncodeCompleteCallback(nullptr);
+      state->encoder->Release();
+      pool->ReleaseEncoder(std::move(state->encoder));
+    }
+    state->writer->CloseAsync(std::move(on_closed));
+  });
+}
+
+absl::StatusOr<std::unique_ptr<VideoSegmentEncoderPool>>
+VideoSegmentEncoderPool::Create(VideoEncodingConfiguration configuration) {
+  if (configuration.thread_count == 0) {
+    return absl::InvalidArgumentError(
+        "Video encoder thread count must be greater than 0");
+  }
+  if (configuration.max_queued_frames <= 0) {
+    return absl::InvalidArgumentError(
+        "Max queued video frames must be greater than 0");
+  }
+  if (configuration.target_bitrate_kbps <= 0 ||
+      configuration.max_frame_rate <= 0) {
+    return absl::InvalidArgumentError(
+        "Video encoding bitrate and frame rate must be greater than 0");
+  }
+
+  auto factory = std::make_unique<SoftwareVideoEncoderFactory>();
+  webrtc::SdpVideoFormat format(configuration.codec_name);
+  std::optional<absl::string_view> fourcc =
+      IvfFourccForMimeType(absl::StrCat("video/", configuration.codec_name));
+  if (!fourcc.has_value() ||
+      !format.IsCodecInList(factory->GetSupportedFormats())) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Unsupported video encoding codec: ", configuration.codec_name));
+  }
+
+  std::vector<std::unique_ptr<rtc::Thread>> threads;
+  threads.reserve(configuration.thread_count);
+  for (uint32_t i = 0; i < configuration.thread_count; ++i) {
+    std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+    thread->SetName(absl::StrCat("video_encoder_thread_", i), nullptr);
+    if (!thread->Start()) {
+      return absl::InternalError("Failed to start video encoder thread");
+    }
+    threads.push_back(std::move(thread));
+  }
+
+  VideoEncoderProvider encoder_provider =
+      [env = webrtc::CreateEnvironment(), factory = std::move(factory),
+       format = std::move(format)]() { return factory->Create(env, format); };
+  return std::make_unique<VideoSegmentEncoderPool>(
+      std::move(configuration), std::string(*fourcc),
+      std::move(encoder_provider), std::move(threads));
+}
+
+std::unique_ptr<VideoSegmentEncoder>
+VideoSegmentEncoderPool::CreateSegmentEncoder(
+    int width, int height, std::unique_ptr<OutputWriterInterface> writer) {
+  rtc::Thread* thread;
+  {
+    absl::MutexLock lock(&mutex_);
+    thread = threads_[next_thread_++ % threads_.size()].get();
+  }
+  auto state = std::make_shared<VideoSegmentEncoder::State>(
+      std::move(writer), configuration_.max_queued_frames);
+
+  // Initializing an encoder allocates its buffers, so it is done on the
+  // encoder thread along with everything else the encoder does.
+  thread->PostTask([this, state, encoder = AcquireEncoder(), width,
+                    height]() mutable {
+    WriteIvfFileHeader(fourcc_, width, height, *state->writer);
+    if (encoder == nullptr) {
+      LOG(ERROR) << "Failed to create " << configuration_.codec_name
+                 << " encoder; dropping video segment frames.";
+      return;
+    }
+
+    webrtc::VideoCodec codec_settings =
+        CodecSettings(configuration_, width, height);
+    if (encoder->InitEncode(
+            &codec_settings,
+            webrtc::VideoEncoder::Settings(
+                webrtc::VideoEncoder::Capabilities(/*loss_notification=*/false),
+                /*number_of_cores=*/1, kMaxPayloadSize)) !=
+        WEBRTC_VIDEO_CODEC_OK) {
+      LOG(ERROR) << "Failed to initialize " << configuration_.codec_name
+                 << " encoder for " << width << "x" << height
+                 << "; dropping video segment frames.";
+      return;
+    }
+    encoder->RegisterEncodeCompleteCallback(state.get());
+    webrtc::VideoBitrateAllocation bitrate_allocation;
+    bitrate_allocation.SetBitrate(
+        /*spatial_index=*/0, /*temporal_index=*/0,
+        static_cast<uint32_t>(configuration_.target_bitrate_kbps) * 1000);
+    encoder->SetRates(webrtc::VideoEncoder::RateControlParameters(
+        bitrate_allocation, configuration_.max_frame_rate));
+    state->encoder = std::move(encoder);
+  });
+  return absl::WrapUnique(
+      new VideoSegmentEncoder(this, thread, std::move(state)));
+}
+
+void VideoSegmentEncoderPool::Stop() {
+  for (std::unique_ptr<rtc::Thread>& thread : threads_) {
+    thread->Stop();
+  }
+}
+
+std::unique_ptr<webrtc::VideoEncoder>
+VideoSegmentEncoderPool::AcquireEncoder() {
+  absl::MutexLock lock(&mutex_);
+  if (idle_encoders_.empty()) {
+    return encoder_provider_();
+  }
+  std::unique_ptr<webrtc::VideoEncoder> encoder =
+      std::move(idle_encoders_.back());
+  idle_encoders_.pop_back();
+  return encoder;
+}
+
+void VideoSegmentEncoderPool::ReleaseEncoder(
+    std::unique_ptr<webrtc::VideoEncoder> encoder) {
+  absl::MutexLock lock(&mutex_);
+  idle_encoders_.push_back(std::move(encoder));
+}
+
+}  // namespace media_api_samples
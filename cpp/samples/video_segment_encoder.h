@@ -0,0 +1,185 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_SAMPLES_VIDEO_SEGMENT_ENCODER_H_
+#define CPP_SAMPLES_VIDEO_SEGMENT_ENCODER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "cpp/samples/output_writer_interface.h"
+#include "webrtc/api/scoped_refptr.h"
+#include "webrtc/api/video/video_frame_buffer.h"
+#include "webrtc/api/video_codecs/video_encoder.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+
+// Configures how video segments are encoded.
+struct VideoEncodingConfiguration {
+  // The codec that segments are encoded with: "VP8", "VP9" or "AV1".
+  std::string codec_name = "VP8";
+  int target_bitrate_kbps = 1000;
+  int max_frame_rate = 30;
+  // The number of threads that encoders run on.
+  uint32_t thread_count = 2;
+  // The number of frames that may wait to be encoded for a single segment.
+  // Frames received while a segment's queue is full are dropped, so that a
+  // slow encoder does not grow memory without limit.
+  int max_queued_frames = 8;
+};
+
+// Creates an encoder for the pool's codec. Returns null on failure.
+using VideoEncoderProvider =
+    absl::AnyInvocable<std::unique_ptr<webrtc::VideoEncoder>()>;
+
+class VideoSegmentEncoderPool;
+
+// Encodes the frames of a single video segment and writes them to an IVF file.
+//
+// Frames are encoded on one of the pool's threads, which also performs all
+// writes and closes the writer. The calling thread only queues frames.
+class VideoSegmentEncoder {
+ public:
+  ~VideoSegmentEncoder() {
+    if (!closed_) {
+      CloseAsync([] {});
+    }
+  }
+
+  // VideoSegmentEncoder is neither copyable nor movable.
+  VideoSegmentEncoder(const VideoSegmentEncoder&) = delete;
+  VideoSegmentEncoder& operator=(const VideoSegmentEncoder&) = delete;
+
+  // Queues `buffer` to be encoded, or drops it if `max_queued_frames` frames
+  // are already queued. `received_time` determines the frame's timestamp in
+  // the file.
+  void Encode(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+              absl::Time received_time);
+
+  // Encodes any queued frames, then returns the encoder to the pool and closes
+  // the writer. `on_closed` is invoked on the encoder thread once the writer
+  // has been closed.
+  void CloseAsync(absl::AnyInvocable<void() &&> on_closed);
+
+ private:
+  friend class VideoSegmentEncoderPool;
+
+  // Shared with queued tasks, so that the encoder and writer stay alive until
+  // every queued frame has been encoded.
+  struct State : public webrtc::EncodedImageCallback {
+    State(std::unique_ptr<OutputWriterInterface> writer, int max_queued_frames)
+        : writer(std::move(writer)), max_queued_frames(max_queued_frames) {}
+
+    webrtc::EncodedImageCallback::Result OnEncodedImage(
+        const webrtc::EncodedImage& encoded_image,
+        const webrtc::CodecSpecificInfo* codec_specific_info) override;
+
+    // Only accessed on the encoder thread. Null if the encoder could not be
+    // created or initialized, in which case frames are dropped.
+    std::unique_ptr<webrtc::VideoEncoder> encoder;
+    std::unique_ptr<OutputWriterInterface> writer;
+    const int max_queued_frames;
+    std::atomic<int> queued_frames = 0;
+  };
+
+  VideoSegmentEncoder(VideoSegmentEncoderPool* pool, rtc::Thread* thread,
+                      std::shared_ptr<State> state)
+      : pool_(pool), thread_(thread), state_(std::move(state)) {}
+
+  VideoSegmentEncoderPool* pool_;
+  rtc::Thread* thread_;
+  std::shared_ptr<State> state_;
+  // Only accessed on the calling thread.
+  absl::Time first_frame_time_ = absl::InfinitePast();
+  bool closed_ = false;
+};
+
+// A pool of threads and reusable encoders that encode video segments.
+//
+// Encoders are released back to the pool when their segment is closed and
+// reinitialized for the resolution of the next segment that uses them, so that
+// a participant starting a new segment does not pay for creating an encoder.
+class VideoSegmentEncoderPool {
+ public:
+  static absl::StatusOr<std::unique_ptr<VideoSegmentEncoderPool>> Create(
+      VideoEncodingConfiguration configuration);
+
+  // Constructor that allows injecting encoders and threads, useful for
+  // testing.
+  //
+  // `threads` must be non-empty and already started. `encoder_provider` is
+  // invoked from the calling threads of `CreateSegmentEncoder`, but never
+  // concurrently.
+  VideoSegmentEncoderPool(VideoEncodingConfiguration configuration,
+                          std::string fourcc,
+                          VideoEncoderProvider encoder_provider,
+                          std::vector<std::unique_ptr<rtc::Thread>> threads)
+      : configuration_(std::move(configuration)),
+        fourcc_(std::move(fourcc)),
+        encoder_provider_(std::move(encoder_provider)),
+        threads_(std::move(threads)) {}
+
+  ~VideoSegmentEncoderPool() { Stop(); }
+
+  // VideoSegmentEncoderPool is neither copyable nor movable.
+  VideoSegmentEncoderPool(const VideoSegmentEncoderPool&) = delete;
+  VideoSegmentEncoderPool& operator=(const VideoSegmentEncoderPool&) = delete;
+
+  // Starts encoding a segment of `width`x`height` frames to `writer`.
+  //
+  // A pooled encoder is (re)initialized for the segment's resolution on its
+  // encoder thread. Thread-safe.
+  std::unique_ptr<VideoSegmentEncoder> CreateSegmentEncoder(
+      int width, int height, std::unique_ptr<OutputWriterInterface> writer);
+
+  // Stops the encoder threads. Frames that have not been encoded are
+  // discarded, and their segments' writers are not closed.
+  void Stop();
+
+ private:
+  friend class VideoSegmentEncoder;
+
+  // Reuses an idle encoder, or creates a new one if none are idle.
+  std::unique_ptr<webrtc::VideoEncoder> AcquireEncoder();
+  void ReleaseEncoder(std::unique_ptr<webrtc::VideoEncoder> encoder);
+
+  const VideoEncodingConfiguration configuration_;
+  const std::string fourcc_;
+
+  absl::Mutex mutex_;
+  VideoEncoderProvider encoder_provider_ ABSL_GUARDED_BY(mutex_);
+  std::vector<std::unique_ptr<webrtc::VideoEncoder>> idle_encoders_
+      ABSL_GUARDED_BY(mutex_);
+  size_t next_thread_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // Declared last so that the threads are destroyed before the encoders that
+  // their tasks use.
+  std::vector<std::unique_ptr<rtc::Thread>> threads_;
+};
+
+}  // namespace media_api_samples
+
+#endif  // CPP_SAMPLES_VIDEO_SEGMENT_ENCODER_H_
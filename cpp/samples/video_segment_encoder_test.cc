@@ -0,0 +1,279 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpp/samples/video_segment_encoder.h"
+
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "cpp/samples/testing/mock_output_writer.h"
+#include "webrtc/api/video/encoded_image.h"
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/api/video_codecs/video_codec.h"
+#include "webrtc/api/video_codecs/video_encoder.h"
+#include "webrtc/modules/video_coding/include/video_error_codes.h"
+#include "webrtc/rtc_base/thread.h"
+
+namespace media_api_samples {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Pair;
+using ::testing::status::StatusIs;
+
+constexpr int kIvfFileHeaderSize = 32;
+constexpr int kIvfFrameHeaderSize = 12;
+
+// What the fake encoders of a test have been asked to do, shared since the
+// encoders are owned by the pool.
+struct EncoderLog {
+  absl::Mutex mutex;
+  std::vector<std::pair<int, int>> initialized_resolutions;
+  std::vector<uint32_t> encoded_timestamps;
+  int released_count = 0;
+  // If set, encoding blocks until it is notified.
+  absl::Notification* encoding_blocker = nullptr;
+};
+
+// Encodes each frame as its width, so that frames can be told apart.
+class FakeVideoEncoder : public webrtc::VideoEncoder {
+ public:
+  explicit FakeVideoEncoder(EncoderLog* log) : log_(log) {}
+
+  int InitEncode(const webrtc::VideoCodec* codec_settings,
+                 const Settings& settings) override {
+    absl::MutexLock lock(&log_->mutex);
+    log_->initialized_resolutions.emplace_back(codec_settings->width,
+                                               codec_settings->height);
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+  int32_t RegisterEncodeCompleteCallback(
+      webrtc::EncodedImageCallback* callback) override {
+    callback_ = callback;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+  int32_t Release() override {
+    absl::MutexLock lock(&log_->mutex);
+    ++log_->released_count;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+  int32_t Encode(
+      const webrtc::VideoFrame& frame,
+      const std::vector<webrtc::VideoFrameType>* frame_types) override {
+    if (log_->encoding_blocker != nullptr) {
+      log_->encoding_blocker->WaitForNotification();
+    }
+    {
+      absl::MutexLock lock(&log_->mutex);
+      log_->encoded_timestamps.push_back(frame.rtp_timestamp());
+    }
+    webrtc::EncodedImage encoded_image;
+    std::string data = absl::StrCat(frame.width());
+    encoded_image.d.assign(data.begin(), data.end());
+    encoded_image.SetRtpTimestamp(frame.rtp_timestamp());
+    callback_->OnEncodedImage(encoded_image, /*codec_specific_info=*/nullptr);
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+  void SetRates(const RateControlParameters& parameters) override {}
+
+ private:
+  EncoderLog* log_;
+  webrtc::EncodedImageCallback* callback_ = nullptr;
+};
+
+std::unique_ptr<VideoSegmentEncoderPool> CreatePool(
+    EncoderLog& log, int* created_encoder_count = nullptr,
+    VideoEncodingConfiguration configuration = {}) {
+  std::vector<std::unique_ptr<rtc::Thread>> threads;
+  threads.push_back(rtc::Thread::Create());
+  EXPECT_TRUE(threads.back()->Start());
+  return std::make_unique<VideoSegmentEncoderPool>(
+      std::move(configuration), "VP80",
+      [&log, created_encoder_count]() {
+        if (created_encoder_count != nullptr) {
+          ++*created_encoder_count;
+        }
+        return std::make_unique<FakeVideoEncoder>(&log);
+      },
+      std::move(threads));
+}
+
+// Returns a writer that appends everything written to `written` and notifies
+// `closed` when closed.
+std::unique_ptr<MockOutputWriter> CreateWriter(std::string& written,
+                                               absl::Notification& closed) {
+  auto writer = std::make_unique<MockOutputWriter>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .WillRepeatedly([&written](const char* content, std::streamsize size) {
+        written.append(content, size);
+      });
+  EXPECT_CALL(*writer, Close).WillOnce([&closed]() { closed.Notify(); });
+  return writer;
+}
+
+TEST(VideoSegmentEncoderTest, CreatePoolFailsForUnsupportedCodec) {
+  EXPECT_THAT(VideoSegmentEncoderPool::Create({.codec_name = "H264"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Unsupported video encoding codec: H264"));
+}
+
+TEST(VideoSegmentEncoderTest, CreatePoolFailsWithoutThreads) {
+  EXPECT_THAT(VideoSegmentEncoderPool::Create({.thread_count = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(VideoSegmentEncoderTest, CreatePoolFailsWithoutFrameQueue) {
+  EXPECT_THAT(VideoSegmentEncoderPool::Create({.max_queued_frames = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(VideoSegmentEncoderTest, WritesIvfHeaderAndEncodedFrames) {
+  EncoderLog log;
+  std::unique_ptr<VideoSegmentEncoderPool> pool = CreatePool(log);
+  std::string written;
+  absl::Notification closed;
+  std::unique_ptr<VideoSegmentEncoder> encoder =
+      pool->CreateSegmentEncoder(640, 480, CreateWriter(written, closed));
+
+  encoder->Encode(webrtc::I420Buffer::Create(640, 480), absl::UnixEpoch());
+  encoder->CloseAsync([] {});
+
+  ASSERT_TRUE(closed.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  ASSERT_EQ(written.size(), kIvfFileHeaderSize + kIvfFrameHeaderSize + 3);
+  EXPECT_EQ(written.substr(0, 4), "DKIF");
+  EXPECT_EQ(written.substr(8, 4), "VP80");
+  EXPECT_EQ(written.substr(kIvfFileHeaderSize + kIvfFrameHeaderSize), "640");
+}
+
+TEST(VideoSegmentEncoderTest, InitializesEncoderForSegmentResolution) {
+  EncoderLog log;
+  std::unique_ptr<VideoSegmentEncoderPool> pool = CreatePool(log);
+  std::string written;
+  absl::Notification closed;
+
+  pool->CreateSegmentEncoder(320, 180, CreateWriter(written, closed))
+      ->CloseAsync([] {});
+
+  ASSERT_TRUE(closed.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  absl::MutexLock lock(&log.mutex);
+  EXPECT_THAT(log.initialized_resolutions, ElementsAre(Pair(320, 180)));
+  EXPECT_EQ(log.released_count, 1);
+}
+
+TEST(VideoSegmentEncoderTest, ReusesReleasedEncoders) {
+  EncoderLog log;
+  int created_encoder_count = 0;
+  std::unique_ptr<VideoSegmentEncoderPool> pool =
+      CreatePool(log, &created_encoder_count);
+  std::string written1;
+  std::string written2;
+  absl::Notification closed1;
+  absl::Notification closed2;
+
+  pool->CreateSegmentEncoder(320, 180, CreateWriter(written1, closed1))
+      ->CloseAsync([] {});
+  ASSERT_TRUE(closed1.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  pool->CreateSegmentEncoder(640, 360, CreateWriter(written2, closed2))
+      ->CloseAsync([] {});
+  ASSERT_TRUE(closed2.WaitForNotificationWithTimeout(absl::Seconds(1)));
+
+  EXPECT_EQ(created_encoder_count, 1);
+  absl::MutexLock lock(&log.mutex);
+  EXPECT_THAT(log.initialized_resolutions,
+              ElementsAre(Pair(320, 180), Pair(640, 360)));
+}
+
+TEST(VideoSegmentEncoderTest, TimestampsFramesFromFirstFrame) {
+  EncoderLog log;
+  std::unique_ptr<VideoSegmentEncoderPool> pool = CreatePool(log);
+  std::string written;
+  absl::Notification closed;
+  std::unique_ptr<VideoSegmentEncoder> encoder =
+      pool->CreateSegmentEncoder(2, 2, CreateWriter(written, closed));
+  absl::Time start = absl::FromUnixSeconds(100);
+
+  encoder->Encode(webrtc::I420Buffer::Create(2, 2), start);
+  encoder->Encode(webrtc::I420Buffer::Create(2, 2),
+                  start + absl::Milliseconds(500));
+  encoder->CloseAsync([] {});
+
+  ASSERT_TRUE(closed.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  absl::MutexLock lock(&log.mutex);
+  EXPECT_THAT(log.encoded_timestamps, ElementsAre(0, 45000));
+}
+
+TEST(VideoSegmentEncoderTest, DropsFramesWhenQueueIsFull) {
+  EncoderLog log;
+  absl::Notification encoding_blocker;
+  log.encoding_blocker = &encoding_blocker;
+  std::unique_ptr<VideoSegmentEncoderPool> pool =
+      CreatePool(log, nullptr, {.max_queued_frames = 2});
+  std::string written;
+  absl::Notification closed;
+  std::unique_ptr<VideoSegmentEncoder> encoder =
+      pool->CreateSegmentEncoder(2, 2, CreateWriter(written, closed));
+
+  for (int i = 0; i < 5; ++i) {
+    encoder->Encode(webrtc::I420Buffer::Create(2, 2),
+                    absl::UnixEpoch() + absl::Seconds(i));
+  }
+  encoding_blocker.Notify();
+  encoder->CloseAsync([] {});
+
+  ASSERT_TRUE(closed.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  absl::MutexLock lock(&log.mutex);
+  EXPECT_THAT(log.encoded_timestamps, ElementsAre(0, 90000));
+}
+
+TEST(VideoSegmentEncoderTest, ClosesWriterIfEncoderCannotBeCreated) {
+  std::vector<std::unique_ptr<rtc::Thread>> threads;
+  threads.push_back(rtc::Thread::Create());
+  ASSERT_TRUE(threads.back()->Start());
+  VideoSegmentEncoderPool pool(
+      /*configuration=*/{}, "VP80", []() { return nullptr; },
+      std::move(threads));
+  std::string written;
+  absl::Notification closed;
+  absl::Notification on_closed;
+  std::unique_ptr<VideoSegmentEncoder> encoder =
+      pool.CreateSegmentEncoder(2, 2, CreateWriter(written, closed));
+
+  encoder->Encode(webrtc::I420Buffer::Create(2, 2), absl::UnixEpoch());
+  encoder->CloseAsync([&on_closed] { on_closed.Notify(); });
+
+  ASSERT_TRUE(on_closed.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_TRUE(closed.HasBeenNotified());
+  // Only the file header is written.
+  EXPECT_EQ(written.size(), kIvfFileHeaderSize);
+}
+
+}  // namespace
+}  // namespace media_api_samples